@@ -0,0 +1,174 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+//  This file is part of NCrystal (see https://mctools.github.io/ncrystal/)   //
+//                                                                            //
+//  Copyright 2015-2021 NCrystal developers                                   //
+//                                                                            //
+//  Licensed under the Apache License, Version 2.0 (the "License");           //
+//  you may not use this file except in compliance with the License.          //
+//  You may obtain a copy of the License at                                   //
+//                                                                            //
+//      http://www.apache.org/licenses/LICENSE-2.0                            //
+//                                                                            //
+//  Unless required by applicable law or agreed to in writing, software       //
+//  distributed under the License is distributed on an "AS IS" BASIS,         //
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  //
+//  See the License for the specific language governing permissions and       //
+//  limitations under the License.                                            //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+//Microbenchmarks measuring the time per call of the basic Scatter methods for
+//materials configured to exercise the various physics process classes, with
+//energies and directions following patterns typical of transport codes:
+//
+//  random   : independent random energies (log-uniform in 0.1meV-1eV) and
+//             isotropic random directions.
+//  sorted   : as random, but with energies in increasing order.
+//  repeated : the same energy and direction at every call (e.g. a neutron
+//             being tracked through several volumes of the same material).
+//
+//Usage: ncrystal_benchmark [filter] [mintime_seconds]
+//
+//Only cases whose name contains the filter string are run, and each
+//measurement is repeated until at least mintime seconds (default 0.2) have
+//passed. This program is not installed and is only built when BUILD_BENCHMARKS
+//is enabled.
+
+#include "NCrystal/NCrystal.hh"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <string>
+#include <vector>
+
+namespace NC = NCrystal;
+
+namespace {
+
+  struct BenchCase {
+    const char * name;
+    const char * cfg;
+  };
+
+  const BenchCase s_cases[] = {
+    { "PCBragg",           "Al_sg225.ncmat;incoh_elas=0;inelas=0" },
+    { "SCBragg",           "Ge_sg227.ncmat;mos=40arcsec;dir1=@crys_hkl:5,1,1@lab:0,0,1;"
+                           "dir2=@crys_hkl:0,-1,1@lab:0,1,0;incoh_elas=0;inelas=0" },
+    { "LCBragg(lcmode=0)", "C_sg194_pyrolytic_graphite.ncmat;mos=3deg;dir1=@crys_hkl:0,0,1@lab:0,0,1;"
+                           "dir2=@crys_hkl:1,0,0@lab:1,0,0;lcaxis=0,0,1;incoh_elas=0;inelas=0" },
+    { "LCBragg(lcmode=20)", "C_sg194_pyrolytic_graphite.ncmat;mos=3deg;dir1=@crys_hkl:0,0,1@lab:0,0,1;"
+                            "dir2=@crys_hkl:1,0,0@lab:1,0,0;lcaxis=0,0,1;lcmode=20;incoh_elas=0;inelas=0" },
+    { "LCBragg(lcmode=-20)", "C_sg194_pyrolytic_graphite.ncmat;mos=3deg;dir1=@crys_hkl:0,0,1@lab:0,0,1;"
+                             "dir2=@crys_hkl:1,0,0@lab:1,0,0;lcaxis=0,0,1;lcmode=-20;incoh_elas=0;inelas=0" },
+    { "SABScatter",        "LiquidWaterH2O_T293.6K.ncmat;elas=0" },
+    { "FreeGas",           "Al_sg225.ncmat;elas=0;inelas=freegas" },
+    { "ElIncScatter",      "V_sg229.ncmat;coh_elas=0;inelas=0" },
+    { "ProcComposition",   "Al_sg225.ncmat" },
+  };
+
+  struct Pattern {
+    std::string name;
+    std::vector<NC::NeutronEnergy> ekin;
+    std::vector<NC::NeutronDirection> dir;
+  };
+
+  std::vector<Pattern> createPatterns( std::size_t n )
+  {
+    //Use a private RNG stream so patterns do not depend on the benchmarks:
+    auto rng = NC::createBuiltinRNG( 123456789 );
+    Pattern prandom;
+    prandom.name = "random";
+    for ( std::size_t i = 0; i < n; ++i ) {
+      prandom.ekin.emplace_back( 1e-4 * std::pow( 1e4, rng->generate() ) );
+      const double uz = 2.0 * rng->generate() - 1.0;
+      const double phi = NC::k2Pi * rng->generate();
+      const double ut = std::sqrt( std::max( 0.0, 1.0 - uz * uz ) );
+      prandom.dir.push_back( NC::NeutronDirection{ ut * std::cos(phi), ut * std::sin(phi), uz } );
+    }
+    Pattern psorted = prandom;
+    psorted.name = "sorted";
+    std::sort( psorted.ekin.begin(), psorted.ekin.end() );
+    Pattern prepeated;
+    prepeated.name = "repeated";
+    prepeated.ekin.assign( n, NC::NeutronEnergy{ 0.025 } );
+    prepeated.dir.assign( n, prandom.dir.front() );
+    return { prandom, psorted, prepeated };
+  }
+
+  //Results of benchmarked calls are stored here, so they are not optimised
+  //away:
+  volatile double s_sink = 0.0;
+
+  template<class TFct>
+  double nsPerCall( const Pattern& p, double mintime, TFct fct )
+  {
+    //Warm up (e.g. lazy initialisation and caches), then cycle through the
+    //pattern in small batches until mintime has passed (checking the clock
+    //only between batches, to keep the overhead low for fast methods while
+    //not requiring full passes for slow ones):
+    double dummy = 0.0;
+    const std::size_t n = p.ekin.size();
+    for ( std::size_t i = 0; i < std::min<std::size_t>( n, 100 ); ++i )
+      dummy += fct( p.ekin[i], p.dir[i] );
+    constexpr std::size_t nbatch = 64;
+    std::size_t ncalls = 0, i = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    double elapsed = 0.0;
+    do {
+      for ( std::size_t ib = 0; ib < nbatch; ++ib ) {
+        dummy += fct( p.ekin[i], p.dir[i] );
+        if ( ++i == n )
+          i = 0;
+      }
+      ncalls += nbatch;
+      elapsed = std::chrono::duration<double>( std::chrono::steady_clock::now() - t0 ).count();
+    } while ( elapsed < mintime );
+    //Make sure the results are used:
+    s_sink = dummy;
+    return 1e9 * elapsed / ncalls;
+  }
+
+}
+
+int main( int argc, char** argv ) {
+  NC::libClashDetect();
+#ifdef NCRYSTAL_BENCHMARK_DATADIR
+  NC::DataSources::addCustomSearchDirectory( NCRYSTAL_BENCHMARK_DATADIR );
+#endif
+  const std::string filter = argc > 1 ? argv[1] : "";
+  const double mintime = argc > 2 ? std::atof( argv[2] ) : 0.2;
+
+  const auto patterns = createPatterns( 10000 );
+  std::printf( "%-22s %-24s %-9s %12s\n", "Case", "Method", "Pattern", "ns/call" );
+  for ( const auto& bc : s_cases ) {
+    if ( !filter.empty() && std::string(bc.name).find(filter) == std::string::npos )
+      continue;
+    auto sc = NC::createScatter( bc.cfg );
+    const bool oriented = sc.isOriented();
+    for ( const auto& p : patterns ) {
+      auto report = [&bc,&p]( const char * method, double ns )
+      {
+        std::printf( "%-22s %-24s %-9s %12.1f\n", bc.name, method, p.name.c_str(), ns );
+        std::fflush( stdout );
+      };
+      if ( !oriented ) {
+        report( "crossSectionIsotropic",
+                nsPerCall( p, mintime, [&sc]( NC::NeutronEnergy e, const NC::NeutronDirection& )
+                           { return sc.crossSectionIsotropic( e ).dbl(); } ) );
+        report( "sampleScatterIsotropic",
+                nsPerCall( p, mintime, [&sc]( NC::NeutronEnergy e, const NC::NeutronDirection& )
+                           { return sc.sampleScatterIsotropic( e ).mu.dbl(); } ) );
+      }
+      report( "crossSection",
+              nsPerCall( p, mintime, [&sc]( NC::NeutronEnergy e, const NC::NeutronDirection& d )
+                         { return sc.crossSection( e, d ).dbl(); } ) );
+      report( "sampleScatter",
+              nsPerCall( p, mintime, [&sc]( NC::NeutronEnergy e, const NC::NeutronDirection& d )
+                         { return sc.sampleScatter( e, d ).direction[0]; } ) );
+    }
+  }
+  return 0;
+}
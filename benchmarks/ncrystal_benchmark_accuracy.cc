@@ -0,0 +1,234 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+//  This file is part of NCrystal (see https://mctools.github.io/ncrystal/)   //
+//                                                                            //
+//  Copyright 2015-2021 NCrystal developers                                   //
+//                                                                            //
+//  Licensed under the Apache License, Version 2.0 (the "License");           //
+//  you may not use this file except in compliance with the License.          //
+//  You may obtain a copy of the License at                                   //
+//                                                                            //
+//      http://www.apache.org/licenses/LICENSE-2.0                            //
+//                                                                            //
+//  Unless required by applicable law or agreed to in writing, software       //
+//  distributed under the License is distributed on an "AS IS" BASIS,         //
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  //
+//  See the License for the specific language governing permissions and       //
+//  limitations under the License.                                            //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+//Validation of the accuracy cost of performance features, for each .ncmat
+//file in the data directory. Two Scatter objects are created for each file:
+//one with the plain file name ("exact") and one with additional cfg-string
+//parameters enabling accelerated code paths ("accel", by default
+//"xstabprec=1e-3;sabalias=1"). These are then compared as follows:
+//
+//  xs      : Cross sections are evaluated on a logarithmic grid in 1e-5-10eV,
+//            and the maximal relative deviation is reported (ignoring points
+//            where the exact cross section is below 1e-6 times its maximum),
+//            along with the speedup of the evaluations (exact time divided by
+//            accel time).
+//  sampling: At a few neutron energies nsamples scatterings are sampled from
+//            both objects, and the distributions of scattering angle cosines
+//            (mu) and final energies are compared with two-sample
+//            Kolmogorov-Smirnov tests. The largest KS distance and the
+//            smallest corresponding p-value over all energies are reported,
+//            along with the speedup of the sampling. For identical
+//            distributions, the p-values are uniformly distributed in [0,1],
+//            so only consistently tiny values indicate a problem.
+//
+//Usage: ncrystal_benchmark_accuracy [filter] [accelcfg] [nsamples]
+//
+//Only files whose name contains the filter string are considered, and nsamples
+//defaults to 20000. The accuracy cost of single precision SAB tables can be
+//assessed by including "sabfloat32=1" in accelcfg. This program is not
+//installed and is only built when BUILD_BENCHMARKS is enabled.
+
+#include "NCrystal/NCrystal.hh"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace NC = NCrystal;
+
+namespace {
+
+  class Timer {
+  public:
+    Timer() : m_t0( std::chrono::steady_clock::now() ) {}
+    double elapsed() const
+    {
+      return std::chrono::duration<double>( std::chrono::steady_clock::now() - m_t0 ).count();
+    }
+  private:
+    std::chrono::steady_clock::time_point m_t0;
+  };
+
+  struct KSResult {
+    double distance;
+    double pvalue;
+  };
+
+  //Two-sample Kolmogorov-Smirnov test (input vectors are sorted in place),
+  //with the p-value from the asymptotic distribution (cf. Numerical Recipes):
+  KSResult ksTest( std::vector<double>& a, std::vector<double>& b )
+  {
+    std::sort( a.begin(), a.end() );
+    std::sort( b.begin(), b.end() );
+    const double na = static_cast<double>( a.size() );
+    const double nb = static_cast<double>( b.size() );
+    std::size_t ia = 0, ib = 0;
+    double d = 0.0;
+    while ( ia < a.size() && ib < b.size() ) {
+      //Advance past all entries with the value, to handle ties (e.g. discrete
+      //Bragg angles or elastic scatterings) correctly:
+      const double x = std::min( a[ia], b[ib] );
+      while ( ia < a.size() && a[ia] <= x )
+        ++ia;
+      while ( ib < b.size() && b[ib] <= x )
+        ++ib;
+      d = std::max( d, std::fabs( ia / na - ib / nb ) );
+    }
+    const double en = std::sqrt( na * nb / ( na + nb ) );
+    const double lambda = ( en + 0.12 + 0.11 / en ) * d;
+    double p = 0.0;
+    if ( lambda < 0.2 ) {
+      p = 1.0;
+    } else {
+      double sign = 1.0;
+      for ( int j = 1; j <= 100; ++j ) {
+        const double term = sign * 2.0 * std::exp( -2.0 * j * j * lambda * lambda );
+        p += term;
+        if ( std::fabs( term ) < 1e-12 )
+          break;
+        sign = -sign;
+      }
+      p = std::min( 1.0, std::max( 0.0, p ) );
+    }
+    return { d, p };
+  }
+
+  struct Samples {
+    std::vector<double> mu;
+    std::vector<double> ekin;
+  };
+
+  Samples sample( NC::Scatter& sc, NC::NeutronEnergy ekin, std::size_t n )
+  {
+    const NC::NeutronDirection indir{ 0.0, 0.0, 1.0 };
+    Samples s;
+    s.mu.reserve( n );
+    s.ekin.reserve( n );
+    for ( std::size_t i = 0; i < n; ++i ) {
+      auto outcome = sc.sampleScatter( ekin, indir );
+      s.mu.push_back( outcome.direction[2] );
+      s.ekin.push_back( outcome.ekin.dbl() );
+    }
+    return s;
+  }
+
+  void validateFile( const std::string& fn, const std::string& accelcfg, std::size_t nsamples )
+  {
+    auto sc_exact = NC::createScatter( fn );
+    auto sc_accel = NC::createScatter( fn + ";" + accelcfg );
+    const NC::NeutronDirection indir{ 0.0, 0.0, 1.0 };
+
+    //Cross sections:
+    constexpr std::size_t ngrid = 5000;
+    std::vector<NC::NeutronEnergy> egrid;
+    egrid.reserve( ngrid );
+    for ( std::size_t i = 0; i < ngrid; ++i )
+      egrid.emplace_back( 1e-5 * std::pow( 1e6, i / ( ngrid - 1.0 ) ) );
+    std::vector<double> xs_exact( ngrid ), xs_accel( ngrid );
+    auto evalXS = [&egrid,&indir]( NC::Scatter& sc, std::vector<double>& out )
+    {
+      for ( std::size_t i = 0; i < egrid.size(); ++i )
+        out[i] = sc.crossSection( egrid[i], indir ).dbl();
+    };
+    //Warm up (e.g. lazily built tables), then time:
+    evalXS( sc_exact, xs_exact );
+    evalXS( sc_accel, xs_accel );
+    constexpr unsigned nrepeat = 5;
+    Timer t_exact;
+    for ( unsigned i = 0; i < nrepeat; ++i )
+      evalXS( sc_exact, xs_exact );
+    const double time_xs_exact = t_exact.elapsed();
+    Timer t_accel;
+    for ( unsigned i = 0; i < nrepeat; ++i )
+      evalXS( sc_accel, xs_accel );
+    const double time_xs_accel = t_accel.elapsed();
+
+    const double xsmax = *std::max_element( xs_exact.begin(), xs_exact.end() );
+    double maxrelerr = 0.0;
+    for ( std::size_t i = 0; i < ngrid; ++i ) {
+      if ( xs_exact[i] > 1e-6 * xsmax )
+        maxrelerr = std::max( maxrelerr, std::fabs( xs_accel[i] - xs_exact[i] ) / xs_exact[i] );
+      else if ( xs_accel[i] > 1e-6 * xsmax )
+        maxrelerr = std::max( maxrelerr, 1.0 );
+    }
+
+    //Sampling:
+    const double energies[] = { 0.001, 0.01, 0.0253, 0.1, 1.0 };
+    double maxdist = 0.0, minpval = 1.0;
+    double time_sampling_exact = 0.0, time_sampling_accel = 0.0;
+    for ( double e : energies ) {
+      const NC::NeutronEnergy ekin{ e };
+      if ( !( sc_exact.crossSection( ekin, indir ).dbl() > 0.0 ) )
+        continue;
+      Timer ts_exact;
+      auto s_exact = sample( sc_exact, ekin, nsamples );
+      time_sampling_exact += ts_exact.elapsed();
+      Timer ts_accel;
+      auto s_accel = sample( sc_accel, ekin, nsamples );
+      time_sampling_accel += ts_accel.elapsed();
+      for ( auto ks : { ksTest( s_exact.mu, s_accel.mu ), ksTest( s_exact.ekin, s_accel.ekin ) } ) {
+        maxdist = std::max( maxdist, ks.distance );
+        minpval = std::min( minpval, ks.pvalue );
+      }
+    }
+
+    auto speedup = []( double t_exact, double t_accel ) { return t_accel > 0.0 ? t_exact / t_accel : 0.0; };
+    std::printf( "%-45s %12.3g %9.2f %10.4f %10.3g %9.2f\n", fn.c_str(), maxrelerr,
+                 speedup( time_xs_exact, time_xs_accel ), maxdist, minpval,
+                 speedup( time_sampling_exact, time_sampling_accel ) );
+    std::fflush( stdout );
+  }
+
+}
+
+int main( int argc, char** argv ) {
+  NC::libClashDetect();
+#ifdef NCRYSTAL_BENCHMARK_DATADIR
+  NC::DataSources::addCustomSearchDirectory( NCRYSTAL_BENCHMARK_DATADIR );
+#endif
+  const std::string filter = argc > 1 ? argv[1] : "";
+  const std::string accelcfg = argc > 2 ? argv[2] : "xstabprec=1e-3;sabalias=1";
+  const std::size_t nsamples = static_cast<std::size_t>( std::max( 100, argc > 3 ? std::atoi( argv[3] ) : 20000 ) );
+
+  std::set<std::string> files;
+  for ( auto& e : NC::DataSources::listAvailableFiles() ) {
+    const std::string& n = e.name;
+    if ( n.size() > 6 && n.compare( n.size() - 6, 6, ".ncmat" ) == 0
+         && ( filter.empty() || n.find(filter) != std::string::npos ) )
+      files.insert( n );
+  }
+
+  std::printf( "Comparing exact and accelerated (\"%s\") results with %i samples per energy\n",
+               accelcfg.c_str(), static_cast<int>( nsamples ) );
+  std::printf( "%-45s %12s %9s %10s %10s %9s\n", "File", "XSMaxRelErr", "XSSpeedup",
+               "KSMaxDist", "KSMinPVal", "SampSpeedup" );
+  for ( auto& fn : files ) {
+    try {
+      validateFile( fn, accelcfg, nsamples );
+    } catch ( NC::Error::Exception& e ) {
+      std::printf( "%-45s ERROR: %s: %s\n", fn.c_str(), e.getTypeName(), e.what() );
+    }
+  }
+  return 0;
+}
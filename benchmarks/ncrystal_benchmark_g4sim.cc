@@ -0,0 +1,362 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+//  This file is part of NCrystal (see https://mctools.github.io/ncrystal/)   //
+//                                                                            //
+//  Copyright 2015-2021 NCrystal developers                                   //
+//                                                                            //
+//  Licensed under the Apache License, Version 2.0 (the "License");           //
+//  you may not use this file except in compliance with the License.          //
+//  You may obtain a copy of the License at                                   //
+//                                                                            //
+//      http://www.apache.org/licenses/LICENSE-2.0                            //
+//                                                                            //
+//  Unless required by applicable law or agreed to in writing, software       //
+//  distributed under the License is distributed on an "AS IS" BASIS,         //
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  //
+//  See the License for the specific language governing permissions and       //
+//  limitations under the License.                                            //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+//End-to-end throughput benchmark of the Geant4 integration, based on the setup
+//of examples/ncrystal_example_g4sim.cc: a monochromatic pencil beam of
+//neutrons hits a spherical sample surrounded by a spherical detector shell in
+//vacuum. Unlike the example, hits are only counted (not printed), the sample
+//is larger by default (so a significant fraction of neutrons scatter, often
+//several times), and the seed and number of events are fixed.
+//
+//The NCrystal scattering process installed by G4NCrystal is wrapped in a
+//process which measures the time spent in it, which is reported along with
+//the total throughput (neutrons per second) and the time spent in other code
+//(Geant4 tracking, geometry, other physics and the application itself). Note
+//that the time spent in the NCrystal process includes the overhead of the
+//clock reads (two per call) as well as calls passed through to the wrapped
+//hadronic elastic process in non-NCrystal materials (negligible here, since
+//all other volumes are vacuum). The initialisation (including creation of
+//the NCrystal material and cross section tables) is timed separately.
+//
+//Usage: ncrystal_benchmark_g4sim [nevents] [nthreads] [cfg] [radius_mm]
+//                                [wavelength_Aa]
+//
+//The defaults are 100000 events, 1 thread, "Al_sg225.ncmat", a sample radius
+//of 10mm and a wavelength of 4.0Aa. Multiple threads require a multi-threaded
+//Geant4 build. Results are only reproducible for a fixed number of threads.
+//Setting G4NCRYSTAL_XSTABPREC=0 disables the cross section tables of
+//G4NCrystal, for comparisons. This program is not installed and is only built
+//when both BUILD_BENCHMARKS and BUILD_G4HOOKS are enabled.
+
+#include "G4NCrystal/G4NCrystal.hh"
+#include "NCrystal/NCDataSources.hh"
+#include "G4RunManager.hh"
+#ifdef G4MULTITHREADED
+#  include "G4MTRunManager.hh"
+#endif
+#include "G4VUserDetectorConstruction.hh"
+#include "G4VUserPrimaryGeneratorAction.hh"
+#include "G4VUserActionInitialization.hh"
+#include "G4UserRunAction.hh"
+#include "G4UserWorkerInitialization.hh"
+#include "G4Event.hh"
+#include "G4Run.hh"
+#include "G4ParticleGun.hh"
+#include "G4ParticleTable.hh"
+#include "G4ParticleDefinition.hh"
+#include "G4PhysListFactory.hh"
+#include "G4NistManager.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4Box.hh"
+#include "G4Sphere.hh"
+#include "G4PVPlacement.hh"
+#include "G4VSensitiveDetector.hh"
+#include "G4SDManager.hh"
+#include "G4StepPoint.hh"
+#include "G4Neutron.hh"
+#include "G4ProcessManager.hh"
+#include "G4ProcessVector.hh"
+#include "G4HadronElasticProcess.hh"
+#include "G4WrapperProcess.hh"
+#include "G4Threading.hh"
+#include "G4ios.hh"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace {
+
+  struct Setup {
+    long nevents = 100000;
+    int nthreads = 1;
+    std::string cfg = "Al_sg225.ncmat";
+    double radius = 10.0*mm;
+    double wavelength = 4.0*angstrom;
+  };
+
+  //Per-thread counters, added to the global totals at the end of each run
+  //(avoiding shared writes in the event loop):
+  G4ThreadLocal double t_ncrystalTime = 0.0;//seconds
+  G4ThreadLocal long t_nhits = 0;
+  G4ThreadLocal long t_nscatteredhits = 0;
+  std::mutex s_totals_mutex;
+  double s_ncrystalTime = 0.0;
+  long s_nhits = 0;
+  long s_nscatteredhits = 0;
+
+  class TimedProcess : public G4WrapperProcess {
+    //Wraps a process and measures time spent in its post-step methods (the
+    //G4NCrystal process is a discrete process, so these are the only ones
+    //doing work).
+  public:
+    explicit TimedProcess( G4VProcess * proc )
+      : G4WrapperProcess( proc->GetProcessName(), proc->GetProcessType() )
+    {
+      RegisterProcess( proc );
+    }
+
+    G4double PostStepGetPhysicalInteractionLength( const G4Track& track, G4double prevStepSize,
+                                                   G4ForceCondition* condition ) final
+    {
+      auto t0 = std::chrono::steady_clock::now();
+      auto res = G4WrapperProcess::PostStepGetPhysicalInteractionLength( track, prevStepSize, condition );
+      t_ncrystalTime += std::chrono::duration<double>( std::chrono::steady_clock::now() - t0 ).count();
+      return res;
+    }
+
+    G4VParticleChange* PostStepDoIt( const G4Track& track, const G4Step& step ) final
+    {
+      auto t0 = std::chrono::steady_clock::now();
+      auto res = G4WrapperProcess::PostStepDoIt( track, step );
+      t_ncrystalTime += std::chrono::duration<double>( std::chrono::steady_clock::now() - t0 ).count();
+      return res;
+    }
+  };
+
+  void installTimedNCrystal()
+  {
+    //Install G4NCrystal in the current thread (process managers are per
+    //thread), and wrap the resulting process. The G4NCrystal process has the
+    //name of the (now inactive) hadronic elastic process it wraps:
+    G4NCrystal::install();
+    G4ProcessManager * pm = G4Neutron::Neutron()->GetProcessManager();
+    const G4ProcessVector * pl = pm->GetProcessList();
+    G4String elasticName;
+    for ( G4int i = 0; i < pl->size(); ++i )
+      if ( !pm->GetProcessActivation(i) && dynamic_cast<G4HadronElasticProcess*>( (*pl)[i] ) )
+        elasticName = (*pl)[i]->GetProcessName();
+    G4VProcess * ncproc = nullptr;
+    for ( G4int i = 0; i < pl->size(); ++i ) {
+      G4VProcess * p = (*pl)[i];
+      if ( pm->GetProcessActivation(i) && p->GetProcessName() == elasticName
+           && !dynamic_cast<G4HadronElasticProcess*>( p ) && !dynamic_cast<TimedProcess*>( p ) )
+        ncproc = p;
+    }
+    if ( !ncproc ) {
+      G4Exception("ncrystal_benchmark_g4sim","Error",FatalException,"Could not find G4NCrystal process");
+      return;
+    }
+    pm->RemoveProcess( ncproc );
+    pm->AddDiscreteProcess( new TimedProcess( ncproc ) );
+  }
+
+  class BenchSD : public G4VSensitiveDetector {
+    //Counts neutrons entering the detector, and how many of those scattered.
+  public:
+    BenchSD() : G4VSensitiveDetector("BenchSD") {}
+    G4bool ProcessHits( G4Step* step, G4TouchableHistory* ) final
+    {
+      if ( step->GetPreStepPoint()->GetStepStatus() != fGeomBoundary )
+        return true;//must have just entered the volume
+      if ( step->GetTrack()->GetDynamicParticle()->GetPDGcode() != 2112 )
+        return true;//must be neutron
+      ++t_nhits;
+      G4ThreeVector pos = step->GetPreStepPoint()->GetPosition();
+      if ( !( pos.z() > 0 && std::sqrt( pos.x()*pos.x() + pos.y()*pos.y() ) < 0.001*mm ) )
+        ++t_nscatteredhits;
+      step->GetTrack()->SetTrackStatus( fStopAndKill );
+      return true;
+    }
+  };
+
+  class BenchGeo : public G4VUserDetectorConstruction {
+    //Same geometry as the example, but with configurable sample material and
+    //radius. The detector kills neutrons entering it.
+  public:
+    BenchGeo( const Setup& s ) : m_setup(s) {}
+    G4VPhysicalVolume* Construct() final
+    {
+      G4Material * mat_vacuum = G4NistManager::Instance()->FindOrBuildMaterial("G4_Galactic",true);
+      G4Material * mat_sample = G4NCrystal::createMaterial( m_setup.cfg );
+
+      G4LogicalVolume * world_log = new G4LogicalVolume(new G4Box("world",110*cm,110*cm,110*cm),
+                                                        mat_vacuum,"world",0,0,0);
+      G4PVPlacement * world_phys = new G4PVPlacement(0,G4ThreeVector(),world_log,"world",0,false,0);
+      m_det_log = new G4LogicalVolume(new G4Sphere("detector",0,100.1*cm,0,CLHEP::twopi,0,CLHEP::pi),
+                                      mat_vacuum,"detector",0,0,0);
+      new G4PVPlacement(0,G4ThreeVector(),m_det_log,"detector",world_log,false,0);
+      G4LogicalVolume * vacuum_log = new G4LogicalVolume(new G4Sphere("vacuum",0,100.0*cm,0,CLHEP::twopi,0,CLHEP::pi),
+                                                         mat_vacuum,"vacuum",0,0,0);
+      new G4PVPlacement(0,G4ThreeVector(),vacuum_log,"vacuum",m_det_log,false,0);
+      G4LogicalVolume * sample_log = new G4LogicalVolume(new G4Sphere("sample",0,m_setup.radius,0,CLHEP::twopi,0,CLHEP::pi),
+                                                         mat_sample,"sample",0,0,0);
+      new G4PVPlacement(0,G4ThreeVector(),sample_log,"sample",vacuum_log,false,0);
+      return world_phys;
+    }
+    void ConstructSDandField() final
+    {
+      //Called for each thread:
+      BenchSD * sd = new BenchSD();
+      G4SDManager::GetSDMpointer()->AddNewDetector( sd );
+      SetSensitiveDetector( m_det_log, sd );
+    }
+  private:
+    Setup m_setup;
+    G4LogicalVolume * m_det_log = nullptr;
+  };
+
+  class BenchGun : public G4VUserPrimaryGeneratorAction {
+  public:
+    BenchGun( double neutron_wavelength ) : m_particleGun(new G4ParticleGun(1))
+    {
+      m_particleGun->SetParticleDefinition(G4ParticleTable::GetParticleTable()->FindParticle("neutron"));
+      m_particleGun->SetParticleEnergy( 0.5 * CLHEP::h_Planck * CLHEP::h_Planck * CLHEP::c_squared
+                                        / ( neutron_wavelength * neutron_wavelength * CLHEP::neutron_mass_c2 ) );
+      m_particleGun->SetParticlePosition(G4ThreeVector(0.0, 0.0, -100.0*cm+1.0*mm));
+      m_particleGun->SetParticleMomentumDirection(G4ThreeVector(0.0, 0.0, 1.0));
+    }
+    void GeneratePrimaries( G4Event* evt ) final
+    {
+      m_particleGun->GeneratePrimaryVertex(evt);
+    }
+  private:
+    std::unique_ptr<G4ParticleGun> m_particleGun;
+  };
+
+  class BenchRunAction : public G4UserRunAction {
+  public:
+    void EndOfRunAction( const G4Run* ) final
+    {
+      std::lock_guard<std::mutex> lock( s_totals_mutex );
+      s_ncrystalTime += t_ncrystalTime;
+      s_nhits += t_nhits;
+      s_nscatteredhits += t_nscatteredhits;
+      t_ncrystalTime = 0.0;
+      t_nhits = t_nscatteredhits = 0;
+    }
+  };
+
+  class BenchActions : public G4VUserActionInitialization {
+  public:
+    BenchActions( const Setup& s ) : m_setup(s) {}
+    void BuildForMaster() const final
+    {
+      SetUserAction( new BenchRunAction );
+    }
+    void Build() const final
+    {
+      SetUserAction( new BenchGun( m_setup.wavelength ) );
+      SetUserAction( new BenchRunAction );
+    }
+  private:
+    Setup m_setup;
+  };
+
+  class BenchWorkerInit : public G4UserWorkerInitialization {
+  public:
+    void WorkerRunStart() const final
+    {
+      //Before the first event loop of each worker (later calls do nothing):
+      static G4ThreadLocal bool done = false;
+      if ( !done ) {
+        done = true;
+        installTimedNCrystal();
+      }
+    }
+  };
+
+}
+
+int main( int argc, char** argv ) {
+
+  NCrystal::libClashDetect();//Detect broken installation
+#ifdef NCRYSTAL_BENCHMARK_DATADIR
+  NCrystal::DataSources::addCustomSearchDirectory( NCRYSTAL_BENCHMARK_DATADIR );
+#endif
+
+  Setup setup;
+  if ( argc > 1 )
+    setup.nevents = std::atol( argv[1] );
+  if ( argc > 2 )
+    setup.nthreads = std::max( 1, std::atoi( argv[2] ) );
+  if ( argc > 3 )
+    setup.cfg = argv[3];
+  if ( argc > 4 )
+    setup.radius = std::atof( argv[4] ) * mm;
+  if ( argc > 5 )
+    setup.wavelength = std::atof( argv[5] ) * angstrom;
+  if ( setup.nevents < 1 || !( setup.radius > 0.0 && setup.radius < 100.0*cm ) || !( setup.wavelength > 0.0 ) ) {
+    std::printf( "Error: invalid arguments\n" );
+    return 1;
+  }
+
+  CLHEP::HepRandom::setTheSeed(123);
+
+  auto t0 = std::chrono::steady_clock::now();
+
+  std::unique_ptr<G4RunManager> runManager;
+#ifdef G4MULTITHREADED
+  if ( setup.nthreads > 1 ) {
+    auto mtrm = new G4MTRunManager;
+    mtrm->SetNumberOfThreads( setup.nthreads );
+    runManager.reset( mtrm );
+  }
+#else
+  if ( setup.nthreads > 1 ) {
+    std::printf( "Error: multiple threads requested but Geant4 was built without multi-threading support\n" );
+    return 1;
+  }
+#endif
+  if ( !runManager )
+    runManager.reset( new G4RunManager );
+  const bool isMT = ( setup.nthreads > 1 );
+
+  runManager->SetUserInitialization( new BenchGeo( setup ) );
+  runManager->SetUserInitialization( G4PhysListFactory().GetReferencePhysList("QGSP_BIC_HP") );
+  runManager->SetUserInitialization( new BenchActions( setup ) );
+  if ( isMT )
+    runManager->SetUserInitialization( new BenchWorkerInit );
+  runManager->Initialize();
+  //The master thread also needs the process, in order to build tables:
+  installTimedNCrystal();
+
+  //Short warm-up run (also triggering initialisation of workers and physics
+  //tables), so the timed run only measures the event loop:
+  runManager->BeamOn( std::max( 1, setup.nthreads ) );
+  auto t1 = std::chrono::steady_clock::now();
+  s_ncrystalTime = 0.0;
+  s_nhits = s_nscatteredhits = 0;
+
+  runManager->BeamOn( static_cast<G4int>( setup.nevents ) );
+  auto t2 = std::chrono::steady_clock::now();
+
+  const double tinit = std::chrono::duration<double>( t1 - t0 ).count();
+  const double wall = std::chrono::duration<double>( t2 - t1 ).count();
+  const double threadtime = wall * setup.nthreads;
+  std::printf( "Material: %s (sample radius %g mm, wavelength %g Aa)\n",
+               setup.cfg.c_str(), setup.radius / mm, setup.wavelength / angstrom );
+  std::printf( "Threads: %i, events: %li, initialisation: %.3f s\n", setup.nthreads, setup.nevents, tinit );
+  std::printf( "Detected neutrons: %li (%li scattered)\n", s_nhits, s_nscatteredhits );
+  std::printf( "Event loop: %.3f s, %.4g neutrons/s\n", wall, setup.nevents / wall );
+  std::printf( "Time in NCrystal process: %.3f s (%.1f%% of thread time, %.3g us per neutron)\n",
+               s_ncrystalTime, 100.0 * s_ncrystalTime / threadtime, 1e6 * s_ncrystalTime / setup.nevents );
+  std::printf( "Time in other code: %.3f s (%.1f%% of thread time, %.3g us per neutron)\n",
+               threadtime - s_ncrystalTime, 100.0 * ( threadtime - s_ncrystalTime ) / threadtime,
+               1e6 * ( threadtime - s_ncrystalTime ) / setup.nevents );
+
+  runManager.reset();
+  G4NCrystal::Manager::cleanup();
+  return 0;
+}
@@ -0,0 +1,260 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+//  This file is part of NCrystal (see https://mctools.github.io/ncrystal/)   //
+//                                                                            //
+//  Copyright 2015-2021 NCrystal developers                                   //
+//                                                                            //
+//  Licensed under the Apache License, Version 2.0 (the "License");           //
+//  you may not use this file except in compliance with the License.          //
+//  You may obtain a copy of the License at                                   //
+//                                                                            //
+//      http://www.apache.org/licenses/LICENSE-2.0                            //
+//                                                                            //
+//  Unless required by applicable law or agreed to in writing, software       //
+//  distributed under the License is distributed on an "AS IS" BASIS,         //
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  //
+//  See the License for the specific language governing permissions and       //
+//  limitations under the License.                                            //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+//Benchmark of the time spent in the various phases of material initialisation,
+//for each .ncmat file in the data directory. The phases are timed separately
+//(with all caches cleared beforehand), in the order in which they are carried
+//out when a material is created through the factories:
+//
+//  textdata   : loading the file via the TextData factories (NCDataSources).
+//  parse      : parsing the NCMAT data (parseNCMATData).
+//  info_nohkl : parsing + loadNCMAT with dcutoff=-1 (i.e. no HKL lists).
+//  info       : parsing + loadNCMAT with default settings.
+//  fillhkl    : the difference between the two above (time spent in fillHKL).
+//
+//and for each vdoslux value, for each scattering kernel in the material:
+//
+//  kernel     : creation of the SABData (expansion via createScatteringKernel
+//               for VDOS).
+//  integrator : creation of tables for cross sections and sampling
+//               (SABIntegrator).
+//
+//as well as the creation of the full process tree via createScatter (with
+//the Info object already loaded, but with all other caches cleared). For
+//materials without scattering kernels only vdoslux=3 is used.
+//
+//Usage: ncrystal_benchmark_init [filter] [nrepeat]
+//
+//Only files whose name contains the filter string are considered, and each
+//phase is repeated nrepeat times (default 1), keeping the fastest time. Results
+//are printed to stdout as JSON (times in seconds), in order to allow tracking
+//of regressions between releases. The NCRYSTAL_SAB_CACHEDIR environment
+//variable should not be set, as the on-disk cache would bypass the kernel
+//expansion. This program is not installed and is only built when
+//BUILD_BENCHMARKS is enabled. Since it accesses internal functions, it might
+//require symbols which are not exported from NCrystal DLLs on Windows.
+
+#include "NCrystal/NCrystal.hh"
+#include "NCrystal/NCFactImpl.hh"
+#include "NCrystal/NCParseNCMAT.hh"
+#include "NCrystal/NCLoadNCMAT.hh"
+#include "NCrystal/internal/NCVDOSToScatKnl.hh"
+#include "NCrystal/internal/NCDynInfoUtils.hh"
+#include "NCrystal/internal/NCSABUtils.hh"
+#include "NCrystal/internal/NCSABIntegrator.hh"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace NC = NCrystal;
+
+namespace {
+
+  std::string jsonStr( const std::string& s )
+  {
+    std::ostringstream ss;
+    ss << '"';
+    for ( char c : s ) {
+      if ( c == '"' || c == '\\' ) {
+        ss << '\\' << c;
+      } else if ( static_cast<unsigned char>(c) < 0x20 ) {
+        char buf[8];
+        std::snprintf( buf, sizeof(buf), "\\u%04x", static_cast<unsigned>(c) );
+        ss << buf;
+      } else {
+        ss << c;
+      }
+    }
+    ss << '"';
+    return ss.str();
+  }
+
+  std::string jsonNum( double t )
+  {
+    char buf[32];
+    std::snprintf( buf, sizeof(buf), "%.6g", t );
+    return buf;
+  }
+
+  class Timer {
+  public:
+    Timer() : m_t0( std::chrono::steady_clock::now() ) {}
+    double elapsed() const
+    {
+      return std::chrono::duration<double>( std::chrono::steady_clock::now() - m_t0 ).count();
+    }
+  private:
+    std::chrono::steady_clock::time_point m_t0;
+  };
+
+  //Run fct nrepeat times, returning the fastest time. Caches are cleared
+  //before each invocation, after which setup (untimed) is invoked:
+  template<class TSetup, class TFct>
+  double timePhase( unsigned nrepeat, TSetup setup, TFct fct )
+  {
+    double best = std::numeric_limits<double>::infinity();
+    for ( unsigned i = 0; i < nrepeat; ++i ) {
+      NC::clearCaches();
+      setup();
+      Timer t;
+      fct();
+      best = std::min( best, t.elapsed() );
+    }
+    return best;
+  }
+
+  template<class TFct>
+  double timePhase( unsigned nrepeat, TFct fct )
+  {
+    return timePhase( nrepeat, [](){}, fct );
+  }
+
+  NC::Info loadInfo( const NC::TextData& td, double dcutoff )
+  {
+    NC::NCMATCfgVars cfgvars;
+    cfgvars.dcutoff = dcutoff;
+    return NC::loadNCMAT( NC::parseNCMATData( td ), std::move(cfgvars) );
+  }
+
+  //Energy up to which VDOS should be expanded, as requested by any energy grid
+  //specified in the input (cf. ncmat_doc.md):
+  double requestedEmax( const NC::DI_ScatKnl& di )
+  {
+    auto egrid = di.energyGrid();
+    if ( !egrid || egrid->empty() )
+      return 0.0;
+    return egrid->size() == 3 ? egrid->at(1) : egrid->back();
+  }
+
+  std::shared_ptr<const NC::SABData> createSABData( const NC::DI_ScatKnl& di, unsigned vdoslux )
+  {
+    auto di_vdos = dynamic_cast<const NC::DI_VDOS*>( &di );
+    if ( di_vdos ) {
+      auto knl = NC::createScatteringKernel( di_vdos->vdosData(), vdoslux, requestedEmax(di) );
+      return std::make_shared<const NC::SABData>( NC::SABUtils::transformKernelToStdFormat( std::move(knl) ) );
+    }
+    return NC::extractSABDataFromDynInfo( &di, vdoslux, false );
+  }
+
+  void benchFile( const std::string& fn, unsigned nrepeat, std::ostream& os )
+  {
+    os << "    {\n      \"file\": " << jsonStr(fn);
+    try {
+      std::shared_ptr<const NC::TextData> td;
+      const double t_textdata = timePhase( nrepeat, [&td,&fn](){ td = NC::FactImpl::createTextData( fn ).getsp(); } );
+      const double t_parse = timePhase( nrepeat, [&td](){ NC::parseNCMATData( *td ); } );
+      const double t_info_nohkl = timePhase( nrepeat, [&td](){ loadInfo( *td, -1.0 ); } );
+      unsigned nhkl = 0;
+      const double t_info = timePhase( nrepeat, [&td,&nhkl](){ nhkl = loadInfo( *td, 0.0 ).nHKL(); } );
+      os << ",\n      \"textdata\": " << jsonNum(t_textdata)
+         << ",\n      \"parse\": " << jsonNum(t_parse)
+         << ",\n      \"info_nohkl\": " << jsonNum(t_info_nohkl)
+         << ",\n      \"info\": " << jsonNum(t_info)
+         << ",\n      \"fillhkl\": " << jsonNum(std::max(0.0,t_info-t_info_nohkl))
+         << ",\n      \"nhkl\": " << nhkl;
+
+      const NC::Info info = loadInfo( *td, 0.0 );
+      std::vector<const NC::DI_ScatKnl*> knls;
+      for ( auto& di : info.getDynamicInfoList() ) {
+        auto di_sk = dynamic_cast<const NC::DI_ScatKnl*>( di.get() );
+        if ( di_sk )
+          knls.push_back( di_sk );
+      }
+      std::vector<unsigned> vdosluxvals;
+      if ( knls.empty() )
+        vdosluxvals = { 3 };
+      else
+        vdosluxvals = { 0, 1, 2, 3, 4, 5 };
+
+      os << ",\n      \"vdoslux\": [";
+      for ( auto vdoslux : vdosluxvals ) {
+        os << ( vdoslux == vdosluxvals.front() ? "\n" : ",\n" );
+        os << "        { \"vdoslux\": " << vdoslux;
+        double t_kernel = 0.0, t_integrator = 0.0;
+        for ( auto di : knls ) {
+          std::shared_ptr<const NC::SABData> sabdata;
+          t_kernel += timePhase( nrepeat, [&sabdata,di,vdoslux](){ sabdata = createSABData( *di, vdoslux ); } );
+          auto egrid = di->energyGrid();
+          t_integrator += timePhase( nrepeat, [&sabdata,&egrid]()
+                                     {
+                                       NC::SAB::SABIntegrator si( sabdata, egrid.get() );
+                                       si.createScatterHelper();
+                                     } );
+        }
+        std::ostringstream cfgstr;
+        cfgstr << fn << ";vdoslux=" << vdoslux;
+        const NC::MatCfg cfg( cfgstr.str() );
+        const double t_scatter = timePhase( nrepeat,
+                                            [&cfg](){ NC::createInfo( cfg ); },
+                                            [&cfg](){ NC::createScatter( cfg ); } );
+        os << ", \"kernel\": " << jsonNum(t_kernel)
+           << ", \"integrator\": " << jsonNum(t_integrator)
+           << ", \"scatter\": " << jsonNum(t_scatter) << " }";
+      }
+      os << "\n      ]";
+    } catch ( NC::Error::Exception& e ) {
+      os << ",\n      \"error\": " << jsonStr( std::string(e.getTypeName()) + ": " + e.what() );
+    }
+    os << "\n    }";
+  }
+
+}
+
+int main( int argc, char** argv ) {
+  NC::libClashDetect();
+#ifdef NCRYSTAL_BENCHMARK_DATADIR
+  NC::DataSources::addCustomSearchDirectory( NCRYSTAL_BENCHMARK_DATADIR );
+#endif
+  const std::string filter = argc > 1 ? argv[1] : "";
+  const unsigned nrepeat = std::max( 1, argc > 2 ? std::atoi( argv[2] ) : 1 );
+
+  std::set<std::string> files;
+  for ( auto& e : NC::DataSources::listAvailableFiles() ) {
+    const std::string& n = e.name;
+    if ( n.size() > 6 && n.compare( n.size() - 6, 6, ".ncmat" ) == 0
+         && ( filter.empty() || n.find(filter) != std::string::npos ) )
+      files.insert( n );
+  }
+
+  std::ostringstream os;
+  os << "{\n  \"ncrystal_version\": " << jsonStr( NCRYSTAL_VERSION_STR )
+     << ",\n  \"nrepeat\": " << nrepeat
+     << ",\n  \"files\": [";
+  bool first = true;
+  for ( auto& fn : files ) {
+    os << ( first ? "\n" : ",\n" );
+    first = false;
+    benchFile( fn, nrepeat, os );
+    //Flush per file, as the full run can take a while:
+    std::fputs( os.str().c_str(), stdout );
+    std::fflush( stdout );
+    os.str( "" );
+  }
+  os << "\n  ]\n}\n";
+  std::fputs( os.str().c_str(), stdout );
+  return 0;
+}
@@ -0,0 +1,256 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+//  This file is part of NCrystal (see https://mctools.github.io/ncrystal/)   //
+//                                                                            //
+//  Copyright 2015-2021 NCrystal developers                                   //
+//                                                                            //
+//  Licensed under the Apache License, Version 2.0 (the "License");           //
+//  you may not use this file except in compliance with the License.          //
+//  You may obtain a copy of the License at                                   //
+//                                                                            //
+//      http://www.apache.org/licenses/LICENSE-2.0                            //
+//                                                                            //
+//  Unless required by applicable law or agreed to in writing, software       //
+//  distributed under the License is distributed on an "AS IS" BASIS,         //
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  //
+//  See the License for the specific language governing permissions and       //
+//  limitations under the License.                                            //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+//Benchmark of the scaling of a synthetic transport loop with the number of
+//threads. Neutrons (0.0253eV) are tracked through a slab of material
+//(scattering only, with path lengths sampled from the cross sections) until
+//they leave it, on 1..N threads each working with its own clone of a single
+//Scatter object. The throughput (histories per second, summed over all
+//threads) is reported along with the scaling efficiency relative to a single
+//thread, for the following modes:
+//
+//  local    : Each thread creates its clone with cloneForCurrentThread(), so
+//             the clone (and its CachePtr contents, allocated on first usage)
+//             is allocated by the thread using it. This is the recommended
+//             usage.
+//  packed   : All clones are created in the main thread and stored next to
+//             each other in a vector, and their caches are initialised from
+//             the main thread. The clones and cache objects of different
+//             threads might then share cache lines, so an efficiency which is
+//             significantly lower than for "local" indicates false sharing.
+//  producer : No transport, each thread just calls cloneForCurrentThread() in
+//             a loop on clones sharing a single RNGProducer, in order to
+//             expose contention in the producer (throughput is in clones per
+//             second).
+//
+//Usage: ncrystal_benchmark_threads [cfg] [maxthreads] [mintime_seconds]
+//                                  [thickness_cm]
+//
+//The defaults are "Al_sg225.ncmat", the number of hardware threads, 0.5
+//seconds per measurement and a 10cm slab. Numbers of threads tested are the
+//powers of two below maxthreads and maxthreads itself. Note that results
+//naturally depend on the number of available cores and other activity on the
+//machine. This program is not installed and is only built when
+//BUILD_BENCHMARKS is enabled (and threads are supported).
+
+#include "NCrystal/NCrystal.hh"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace NC = NCrystal;
+
+namespace {
+
+  struct Setup {
+    double thickness;//cm
+    double macroXSPerBarn;//number density, so that mu[1/cm] = macroXSPerBarn * xs[barn]
+    double mintime;
+  };
+
+  //Padded to avoid false sharing between the results of different threads:
+  struct alignas(64) ThreadResult {
+    std::uint64_t ncount = 0;
+  };
+
+  //Track neutrons through the slab until told to stop, returning the number
+  //of histories completed:
+  std::uint64_t transport( NC::Scatter& sc, const Setup& setup, const std::atomic<bool>& stop )
+  {
+    auto& rng = sc.rng();
+    std::uint64_t nhist = 0;
+    constexpr unsigned nbatch = 16;
+    constexpr unsigned maxscat = 1000;
+    while ( !stop.load( std::memory_order_relaxed ) ) {
+      for ( unsigned ib = 0; ib < nbatch; ++ib, ++nhist ) {
+        NC::NeutronEnergy ekin{ 0.0253 };
+        NC::NeutronDirection dir{ 0.0, 0.0, 1.0 };
+        double z = 0.0;
+        for ( unsigned iscat = 0; iscat < maxscat; ++iscat ) {
+          const double xs = sc.crossSection( ekin, dir ).dbl();
+          if ( !( xs > 0.0 ) )
+            break;
+          z += dir[2] * ( -std::log( rng.generate() ) / ( setup.macroXSPerBarn * xs ) );
+          if ( z < 0.0 || z > setup.thickness )
+            break;
+          auto outcome = sc.sampleScatter( ekin, dir );
+          ekin = outcome.ekin;
+          dir = outcome.direction;
+        }
+      }
+    }
+    return nhist;
+  }
+
+  //Launch nthreads threads invoking fct(ithread,stopflag) which should return
+  //a count, and return the total counts per second:
+  template<class TFct>
+  double runThreads( unsigned nthreads, double mintime, TFct fct )
+  {
+    std::atomic<bool> stop( false );
+    std::atomic<unsigned> nready( 0 );
+    std::atomic<bool> go( false );
+    std::vector<ThreadResult> results( nthreads );
+    std::vector<std::thread> threads;
+    threads.reserve( nthreads );
+    for ( unsigned i = 0; i < nthreads; ++i ) {
+      threads.emplace_back( [i,&stop,&nready,&go,&results,&fct]()
+                            {
+                              ++nready;
+                              while ( !go.load() )
+                                std::this_thread::yield();
+                              results[i].ncount = fct( i, stop );
+                            } );
+    }
+    while ( nready.load() < nthreads )
+      std::this_thread::yield();
+    auto t0 = std::chrono::steady_clock::now();
+    go.store( true );
+    std::this_thread::sleep_for( std::chrono::duration<double>( mintime ) );
+    stop.store( true );
+    for ( auto& t : threads )
+      t.join();
+    const double elapsed = std::chrono::duration<double>( std::chrono::steady_clock::now() - t0 ).count();
+    std::uint64_t ntot = 0;
+    for ( auto& r : results )
+      ntot += r.ncount;
+    return ntot / elapsed;
+  }
+
+  double benchLocal( NC::Scatter& master, const Setup& setup, unsigned nthreads )
+  {
+    return runThreads( nthreads, setup.mintime,
+                       [&master,&setup]( unsigned, const std::atomic<bool>& stop )
+                       {
+                         //NB: cloning the master is MT-safe:
+                         auto sc = master.cloneForCurrentThread();
+                         return transport( sc, setup, stop );
+                       } );
+  }
+
+  double benchPacked( NC::Scatter& master, const Setup& setup, unsigned nthreads )
+  {
+    std::vector<NC::Scatter> clones;
+    clones.reserve( nthreads );
+    for ( unsigned i = 0; i < nthreads; ++i ) {
+      clones.push_back( master.clone() );
+      //Trigger allocation of cache objects from the main thread:
+      clones.back().crossSection( NC::NeutronEnergy{ 0.0253 }, NC::NeutronDirection{ 0.0, 0.0, 1.0 } );
+    }
+    return runThreads( nthreads, setup.mintime,
+                       [&clones,&setup]( unsigned i, const std::atomic<bool>& stop )
+                       {
+                         return transport( clones.at(i), setup, stop );
+                       } );
+  }
+
+  double benchProducer( NC::Scatter& master, const Setup& setup, unsigned nthreads )
+  {
+    //All clones share the RNGProducer of the master:
+    std::vector<NC::Scatter> clones;
+    clones.reserve( nthreads );
+    for ( unsigned i = 0; i < nthreads; ++i )
+      clones.push_back( master.cloneWithIdenticalRNGSettings() );
+    return runThreads( nthreads, setup.mintime,
+                       [&clones]( unsigned i, const std::atomic<bool>& stop )
+                       {
+                         auto& sc = clones.at(i);
+                         std::uint64_t n = 0;
+                         while ( !stop.load( std::memory_order_relaxed ) ) {
+                           for ( unsigned k = 0; k < 16; ++k, ++n )
+                             sc.cloneForCurrentThread();
+                         }
+                         return n;
+                       } );
+  }
+
+}
+
+int main( int argc, char** argv ) {
+  NC::libClashDetect();
+#ifdef NCRYSTAL_BENCHMARK_DATADIR
+  NC::DataSources::addCustomSearchDirectory( NCRYSTAL_BENCHMARK_DATADIR );
+#endif
+  const std::string cfg = argc > 1 ? argv[1] : "Al_sg225.ncmat";
+  unsigned maxthreads = argc > 2 ? static_cast<unsigned>( std::max( 0, std::atoi( argv[2] ) ) ) : 0;
+  if ( !maxthreads )
+    maxthreads = std::max( 1u, std::thread::hardware_concurrency() );
+  Setup setup;
+  setup.mintime = argc > 3 ? std::atof( argv[3] ) : 0.5;
+  setup.thickness = argc > 4 ? std::atof( argv[4] ) : 10.0;
+
+  auto info = NC::createInfo( cfg );
+  if ( !info->hasNumberDensity() ) {
+    std::printf( "Error: material has no number density: %s\n", cfg.c_str() );
+    return 1;
+  }
+  //Number density in atoms/Aa^3, cross sections in barn. Since 1barn=1e-24cm^2
+  //and 1Aa^-3=1e24cm^-3, the product directly gives mu in 1/cm:
+  setup.macroXSPerBarn = info->getNumberDensity().dbl();
+
+  auto master = NC::createScatter( cfg );
+
+  std::vector<unsigned> nthreadvals;
+  for ( unsigned n = 1; n < maxthreads; n *= 2 )
+    nthreadvals.push_back( n );
+  nthreadvals.push_back( maxthreads );
+
+  std::printf( "Material: %s (slab thickness %g cm, %g s per measurement)\n",
+               cfg.c_str(), setup.thickness, setup.mintime );
+  std::printf( "%-9s %8s %16s %10s %11s\n", "Mode", "Threads", "Throughput[1/s]", "Speedup", "Efficiency" );
+
+  struct Mode {
+    const char * name;
+    double (*fct)( NC::Scatter&, const Setup&, unsigned );
+    double lastEfficiency;
+  };
+  Mode modes[] = { { "local", benchLocal, 1.0 },
+                   { "packed", benchPacked, 1.0 },
+                   { "producer", benchProducer, 1.0 } };
+  for ( auto& mode : modes ) {
+    double single = 0.0;
+    for ( auto n : nthreadvals ) {
+      const double throughput = mode.fct( master, setup, n );
+      if ( n == 1 )
+        single = throughput;
+      const double speedup = single > 0.0 ? throughput / single : 0.0;
+      mode.lastEfficiency = speedup / n;
+      std::printf( "%-9s %8u %16.4g %10.2f %10.1f%%\n", mode.name, n, throughput,
+                   speedup, 100.0 * mode.lastEfficiency );
+      std::fflush( stdout );
+    }
+  }
+
+  if ( maxthreads > 1 ) {
+    const double ratio = modes[0].lastEfficiency > 0.0 ? modes[1].lastEfficiency / modes[0].lastEfficiency : 0.0;
+    std::printf( "Efficiency of packed relative to local clones at %u threads: %.2f%s\n", maxthreads, ratio,
+                 ratio < 0.9 ? " (possible false sharing)" : "" );
+    std::printf( "Efficiency of RNGProducer access at %u threads: %.1f%%%s\n", maxthreads,
+                 100.0 * modes[2].lastEfficiency,
+                 modes[2].lastEfficiency < 0.5 ? " (contention)" : "" );
+  }
+  return 0;
+}
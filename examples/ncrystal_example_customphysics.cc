@@ -61,6 +61,7 @@
 #include "NCrystal/internal/NCString.hh"
 
 #include <iostream>
+#include <algorithm>
 
 namespace NC = NCrystal;
 
@@ -88,6 +89,28 @@ public:
     return { ekin_final, mu };
   }
 
+  //Optionally, processes can also override the batched methods, which are
+  //used when many neutrons are handled at once (also when the process is
+  //combined with other processes as below). The default implementations
+  //simply call the methods above for one neutron at a time, so overriding
+  //them only makes sense when it can be done more efficiently - like here
+  //where the loops are trivial:
+
+  void evalManyXSIsotropic( NC::CachePtr&, const double*, std::size_t N,
+                            double* out_xs ) const override
+  {
+    std::fill( out_xs, out_xs + N, m_sigma.dbl() );
+  }
+
+  void sampleScatterIsotropicMany( NC::CachePtr&, NC::RNG& rng, double*,
+                                   std::size_t N, double* out_mu ) const override
+  {
+    //Elastic, so the ekin array is left unchanged. Only the scattering angles
+    //must be sampled:
+    for ( std::size_t i = 0; i < N; ++i )
+      out_mu[i] = randIsotropicScatterMu( rng ).dbl();
+  }
+
 private:
   NC::CrossSect m_sigma;
 };
@@ -231,5 +254,13 @@ int main() {
   //That should have printed out something around 100.1-100.15 barn, clearly the
   //effect of our silly 100barn model :-)
 
+  //Cross sections can also be evaluated for many neutrons at once, in which
+  //case the batched methods of the processes will be used:
+  const double ekins[3] = { NC::wl2ekin(5.0), NC::wl2ekin(1.0), NC::wl2ekin(0.5) };
+  double xs[3];
+  scatter_custom_Al.evalManyXSIsotropic( ekins, 3, xs );
+  std::cout<<"Cross sections at 5.0Aa, 1.0Aa and 0.5Aa: "
+           <<xs[0]<<" barn, "<<xs[1]<<" barn, "<<xs[2]<<" barn"<<std::endl;
+
   return 0;
 }
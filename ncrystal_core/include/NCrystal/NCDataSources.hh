@@ -140,6 +140,18 @@ namespace NCrystal {
     //the compile time definition of the same name (in that order):
     NCRYSTAL_API void enableStandardSearchPath(bool = true);
 
+    ////////////////////////////////////////////////////////////////////////////
+    // The content of on-disk search directories (those of the "stdlib",
+    // "stdpath" and "customdirs" factories) is by default read just once and
+    // kept in an in-memory index, so file lookups and browsing do not need to
+    // access the file system repeatedly (which can be slow on network file
+    // systems). Files added to such directories after they were first indexed
+    // are thus only found after a call to refreshDirectoryIndex. Indexing can
+    // be disabled entirely, either here or by setting the environment variable
+    // NCRYSTAL_NO_DIRINDEX=1.
+    NCRYSTAL_API void refreshDirectoryIndex();
+    NCRYSTAL_API void enableDirectoryIndex( bool = true );
+
     // Disable all standard data sources, remove all TextData factories as well,
     // clear all registered virtual files and custom search directories. Finish
     // by calling global clearCaches function ("Ripley: I say we take off and
@@ -146,6 +146,11 @@ namespace NCrystal {
     double operator()();
     double generate();
 
+    //Fill array with n such numbers (the same numbers, in the same order, as
+    //n calls to generate() would have resulted in, but implementations can
+    //provide a more efficient bulk method):
+    void generateMany( std::size_t n, double* tgt );
+
     //Generate integer uniformly in { 0, 1, ..., N-1 }:
     uint32_t generateInt( uint32_t N );
     uint64_t generateInt64( uint64_t N );
@@ -157,6 +162,7 @@ namespace NCrystal {
 
   protected:
     virtual double actualGenerate() = 0;//uniformly in (0,1]
+    virtual void actualGenerateMany( std::size_t n, double* tgt );//default calls actualGenerate() n times
   };
 
   struct NCRYSTAL_API UniqueIDValue {
@@ -1027,6 +1033,15 @@ namespace NCrystal {
     return r;
   }
 
+  inline void RNG::generateMany( std::size_t n, double* tgt ) {
+    actualGenerateMany( n, tgt );
+#ifndef NDEBUG
+    for ( std::size_t i = 0; i < n; ++i )
+      if ( ! ( tgt[i] > 0.0 && tgt[i] <= 1.0 ) )
+        NCRYSTAL_THROW2(CalcError,"Random number stream generated number "<<tgt[i]<<" which is outside (0.0,1.0]");
+#endif
+  }
+
   inline uint32_t RNG::generateInt( uint32_t N )
   {
     constexpr uint32_t nmax = std::numeric_limits<uint32_t>::max();
@@ -26,9 +26,16 @@
 namespace NCrystal {
 
   class Info;
+  namespace ProcImpl { class Process; }
 
   //Dumps info to stdout:
   NCRYSTAL_API void dump(const Info&);
+
+  //Dumps approximate memory footprint to stdout, separating exclusively owned
+  //memory from memory in objects shared with others (like factory caches). For
+  //processes, a breakdown of the full tree of components is shown:
+  NCRYSTAL_API void dumpMemoryFootprint(const Info&);
+  NCRYSTAL_API void dumpMemoryFootprint(const ProcImpl::Process&);
 }
 
 #endif
@@ -43,6 +43,7 @@ namespace NCrystal {
   NCRYSTAL_API shared_obj<const Info> createInfo( const MatCfg& cfg );
   NCRYSTAL_API Scatter createScatter( const MatCfg& cfg );
   NCRYSTAL_API Absorption createAbsorption( const MatCfg& cfg );
+  NCRYSTAL_API TotalXS createTotalXS( const MatCfg& cfg );//scatter+absorption
 
   //////////////////////////////////////////////////////////////////////////
   // For the case of Scatter instance, they can also by created with more //
@@ -26,6 +26,7 @@
 #include "NCrystal/NCProcImpl.hh"
 #include "NCrystal/NCInfo.hh"
 #include "NCrystal/NCTextData.hh"
+#include <future>
 
 /////////////////////////////////////////////////////////////////////////////////
 //                                                                             //
@@ -58,12 +59,103 @@ namespace NCrystal {
     NCRYSTAL_API shared_obj<const ProcImpl::Process> createScatter( const MatCfg& cfg );
     NCRYSTAL_API shared_obj<const ProcImpl::Process> createAbsorption( const MatCfg& cfg );
 
+    //Create several of the above objects for the same cfg in a single pass, for
+    //instance for one-off cfg objects from MatCfg::createFromRawData. The Info
+    //object is created first and then reused whenever the Scatter and
+    //Absorption factories request it, so the input data is only parsed once
+    //even when caching is disabled. Objects not requested are left empty:
+    struct MultiCreated {
+      optional_shared_obj<const Info> info;
+      optional_shared_obj<const ProcImpl::Process> scatter;
+      optional_shared_obj<const ProcImpl::Process> absorption;
+    };
+    NCRYSTAL_API MultiCreated createMulti( const MatCfg& cfg,
+                                           bool wantInfo = true,
+                                           bool wantScatter = true,
+                                           bool wantAbsorption = true );
+
+    //Asynchronous versions of the above, which start the creation on a pool of
+    //background threads and immediately return a future for the result (any
+    //exceptions are likewise propagated through the futures). Concurrent
+    //requests for the same configuration share a single creation job, and
+    //results are cached exactly as for the synchronous versions. The pool size
+    //is given by the NCRYSTAL_NTHREADS environment variable if set, and
+    //otherwise by the number of available hardware threads:
+    NCRYSTAL_API std::shared_future<shared_obj<const Info>> createInfoAsync( const MatCfg& cfg );
+    NCRYSTAL_API std::shared_future<shared_obj<const ProcImpl::Process>> createScatterAsync( const MatCfg& cfg );
+    NCRYSTAL_API std::shared_future<shared_obj<const ProcImpl::Process>> createAbsorptionAsync( const MatCfg& cfg );
+
+    //Snapshots of derived data. Saving a snapshot creates Info, Scatter and
+    //Absorption objects for the given cfg-strings, and writes all the
+    //expensive derived tables (expanded VDOS kernels, cross section tables and
+    //samplers for S(alpha,beta) scattering, HKL lists, ...) which were needed in the
+    //process into a single binary file. For this to be complete, all caches
+    //are cleared first. Loading a snapshot in a later process (with the same
+    //NCrystal version and architecture) makes these tables available without
+    //recomputation, for any configuration needing them. Input files are still
+    //read and parsed as usual, which is typically cheap in comparison:
+    NCRYSTAL_API void saveSnapshot( const std::string& path, const VectS& cfgstrs );
+    //Same, but creating objects for different cfg-strings in parallel using
+    //nthreads threads (0 means all available hardware threads), which is
+    //useful when preparing kernels for many materials or temperatures at
+    //once. The version above uses NCRYSTAL_NTHREADS (see NCThreadUtils.hh):
+    NCRYSTAL_API void saveSnapshot( const std::string& path, const VectS& cfgstrs, unsigned nthreads );
+    NCRYSTAL_API void loadSnapshot( const std::string& path );
+
+    //Same as saveSnapshot, but returning the content of the snapshot file
+    //rather than writing it (e.g. for distribution to other processes, which
+    //can then use loadSnapshotFromMemory):
+    NCRYSTAL_API std::string saveSnapshotToMemory( const VectS& cfgstrs, unsigned nthreads );
+
+    //Load snapshot from memory instead (data must be aligned to 64 bytes and
+    //remain valid for the rest of the process lifetime, as for static data
+    //embedded with ncrystal_ncmat2cpp --precompile):
+    NCRYSTAL_API void loadSnapshotFromMemory( const unsigned char * data, std::size_t size );
+
     //Disable and enable caching in these factories (default state upon startup
     //is for caching to be enabled, unless the environment variable
     //NCRYSTAL_NOCACHE is set):
     NCRYSTAL_API void setCachingEnabled(bool);
     NCRYSTAL_API bool getCachingEnabled();
 
+    //Targeted alternative to clearCaches() (from NCMem.hh), which only drops
+    //the cached Info, Scatter and Absorption objects created from TextData
+    //with the given UID, as well as any such TextData objects kept for reuse
+    //(see setTextDataRevalidationInterval). Lower-level caches of heavy data
+    //like scattering kernels are not keyed on the input data, and are
+    //therefore not affected:
+    NCRYSTAL_API void clearCachesFor( TextDataUID );
+
+    //Enable content-based deduplication of TextData objects (default state
+    //upon startup is for it to be disabled, unless the environment variable
+    //NCRYSTAL_TEXTDATA_DEDUP is set). When enabled, a newly loaded TextData
+    //object with the same data type and byte-wise identical content as a
+    //recently loaded (and still cached) one, will share its dataUID(), even if
+    //it comes from a different source (e.g. in-memory files registered under
+    //different names). Since downstream caches of Info, Scatter and Absorption
+    //objects are keyed on this UID, work can then be reused across such
+    //duplicates. The price is that reused objects might refer to the name of
+    //the first source in their descriptions and error messages:
+    NCRYSTAL_API void setTextDataDeduplicationEnabled(bool);
+    NCRYSTAL_API bool getTextDataDeduplicationEnabled();
+
+    //Revalidation policy for TextData objects. By default (negative interval),
+    //every createTextData call searches the data sources again and re-reads
+    //on-disk files, so any changes are picked up immediately. With a
+    //non-negative interval, the result for a given TextDataPath is instead
+    //reused for up to that many seconds, after which on-disk files are only
+    //checked for changes via their inode, modification time and size (and
+    //only reloaded if changed). An infinite interval ("immutable data" mode)
+    //means that the file system is never consulted again for previously loaded
+    //data. Reused results are dropped upon clearCaches() or when TextData
+    //factories are modified (as happens for most changes to the data sources
+    //in NCDataSources.hh), but note that changes of the current working
+    //directory are not detected. The default value can be set with the
+    //environment variable NCRYSTAL_TEXTDATA_REVALIDATE (a number of seconds,
+    //or "immutable"):
+    NCRYSTAL_API void setTextDataRevalidationInterval( double seconds );
+    NCRYSTAL_API double getTextDataRevalidationInterval();
+
     ////////////////////////////////////////////////////////////////////////////
     ////////////////////////////////////////////////////////////////////////////
     ////////////////////////////////////////////////////////////////////////////
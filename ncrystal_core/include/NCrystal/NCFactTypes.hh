@@ -114,6 +114,11 @@ namespace NCrystal {
     //looking at the actual data (which always works for NCMAT data), or the
     //file-name extension (e.g. a file named Foo.bar is assumed to have data
     //type "bar").
+    //
+    //On-disk files are by default read into memory. If the environment variable
+    //NCRYSTAL_MMAP_TEXTDATA=1 is set, they are instead memory mapped (where
+    //supported), such that lines are iterated directly over the mapping. Note
+    //that on-disk files must then not be modified while in use.
     static TextDataSource createFromOnDiskPath( std::string, std::string dataType = {} );
     static TextDataSource createFromInMemData( RawStrData, std::string dataType = {} );
     const Variant<std::string,RawStrData>&& data() &&;
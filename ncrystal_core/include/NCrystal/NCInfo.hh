@@ -230,6 +230,9 @@ namespace NCrystal {
     //check if SAB is already built:
     bool hasBuiltSAB() const;
 
+    //Account memory of the SABData object (if already built):
+    void accountMemory( MemoryFootprint& ) const;
+
   protected:
     //Implement in derived classes to build the completed SABData object (will
     //only be called once and in an MT-safe context, protected by per-object
@@ -457,6 +460,13 @@ namespace NCrystal {
     const CustomSectionData& getCustomSection( const CustomSectionName& name,
                                                unsigned index=0 ) const;
 
+    //////////////////////////////////////////////////////////////////
+    // Approximate memory usage (see MemoryFootprint in NCMem.hh).  //
+    // Only potentially large containers are counted in detail.     //
+    //////////////////////////////////////////////////////////////////
+
+    void accountMemory( MemoryFootprint& ) const;
+
     //////////////////////////////
     // Internals follow here... //
     //////////////////////////////
@@ -33,11 +33,16 @@ namespace NCrystal {
   // (it will have a reference count of 0 when returned).
   //
   // Parameters must be set via a NCMATCfgVars struct.  Parameters "temp",
-  // "dcutoff", "dcutoffup", and "atomdb" have the same meaning as the
-  // corresponding parameters described in NCMatCfg.hh (although atomdb must
-  // here be already be split into "lines" and "words"). The "expandhkl"
-  // parameter can be used to request that lists of equivalent HKL planes be
-  // created.
+  // "dcutoff", "dcutoffup", "emax", "propsonly" and "atomdb" have the same
+  // meaning as the corresponding parameters described in NCMatCfg.hh
+  // (although atomdb must here be already be split into "lines" and
+  // "words"). The "expandhkl" parameter can be used to request that lists of
+  // equivalent HKL planes be created. Conversely, the "compacthkl" parameter
+  // can be used to request HKL lists without any normals, in order to save
+  // memory when only powder (i.e. PCBragg) modelling is needed. For crystals
+  // with a space group, single-crystal and layered-crystal modelling remains
+  // possible, since normals are then reconstructed on demand (see
+  // FillHKLCfg::compact in internal/NCFillHKL.hh).
   //
   // Setting "temp" to -1.0 will result in a temperature of 293.15K unless
   // something in the input indicates another value (i.e. if a scatterkernel is
@@ -48,7 +53,10 @@ namespace NCrystal {
     Temperature temp = Temperature{-1.0};//kelvin
     double dcutoff = 0.0;//angstrom
     double dcutoffup = kInfinity;//angstrom
+    double emax = 0.0;//eV (0 means no restriction)
+    bool propsonly = false;
     bool expandhkl = false;
+    bool compacthkl = false;
     std::vector<VectS> atomdb;
   };
 
@@ -110,9 +110,10 @@ namespace NCrystal {
     // preference, this will be done by looking at #1 the explicit dataType
     // string provided as a parameter to the constructor (if non-empty), #2 the
     // dataType from the TextData object, #3 if the TextData content starts with
-    // the 5 characters "NCMAT", the type will be inferred to be "ncmat", and
-    // finally as a last resort, #4 the file extension of the filename provided,
-    // if any. If all these options fail to determine the data format, a
+    // the 5 characters "NCMAT", the type will be inferred to be "ncmat" (and
+    // likewise "ncmatbin" for data in the binary NCMAT format), and finally
+    // as a last resort, #4 the file extension of the filename provided, if
+    // any. If all these options fail to determine the data format, a
     // BadInput exception will be thrown.
     //
     // Note that providing data manually as a string will result in a new
@@ -188,7 +189,9 @@ namespace NCrystal {
     //               Packing factor which can be less than 1.0 for powders,
     //               which can thus be modelled as polycrystals with reduced
     //               density (not to be confused with the *atomic* packing
-    //               factor).
+    //               factor). As it does not affect per-atom cross sections,
+    //               the same scatter and absorption processes are used for
+    //               cfgs which differ only in packfact.
     //
     // mos.........: [ double, no fallback value ]
     //               Mosaic FWHM spread in mosaic single crystals, in radians.
@@ -263,6 +266,19 @@ namespace NCrystal {
     //               and truncation range of Gaussian. Values must be in the
     //               range [1e-7,1e-1].
     //
+    // mostab......: [ bool, fallback value is false ]
+    //               Whether circle integrals of the mosaicity distribution in
+    //               single crystals (including layered crystals) which can not
+    //               be handled by approximation formulas, should be looked up
+    //               in a precomputed table rather than being integrated
+    //               numerically. This is mostly of interest for low-mosaicity
+    //               crystals used in backscattering geometries. The tables have
+    //               errors below mosprec/2 and are shared between all crystals
+    //               with the same mosaicity and mosprec, but they might take
+    //               a few seconds to initialise. No table is used if this is
+    //               not possible with less than 2M table entries (typically
+    //               when mosprec<1e-4).
+    //
     // lcmode......: [ int, fallback value is 0 ]
     //               Choose which modelling is used for layered crystals (has no
     //               effect unless lcaxis is also set). The default value
@@ -275,6 +291,30 @@ namespace NCrystal {
     //               triggers a new selection of n=-lcmode randomly oriented
     //               crystallites.
     //
+    // lcfixedrot..: [ bool, fallback value is false ]
+    //               Only has an effect when lcmode is negative. If enabled, the
+    //               n=-lcmode crystallite orientations are no longer selected
+    //               randomly for each crossSection call, but are instead fixed
+    //               and equidistantly spaced (n is rounded up to a prime). This
+    //               gives smooth, deterministic and MT-safe cross sections, and
+    //               requires far fewer orientations for a given accuracy.
+    //
+    // lctabprec...: [ double, fallback value is 0 ]
+    //               When non-zero (and lcmode=0), cross sections in layered
+    //               crystals are evaluated with the help of a table in
+    //               (wavelength,angle to lcaxis), which is refined until
+    //               interpolated values reproduce the exact cross sections to
+    //               the approximate relative precision given by this parameter.
+    //               Contributions from planes whose normals are parallel to the
+    //               lcaxis are always evaluated exactly. The table is built upon
+    //               the first cross section evaluation, which might take from a
+    //               few seconds to several minutes (depending on mosaicity and
+    //               lctabprec), after which cross section evaluations are much
+    //               faster. A warning is emitted if the precision could not be
+    //               reached with 4M table entries (typically only for low
+    //               mosaicities). Scatterings are unaffected. Values must be 0
+    //               (disabled) or in the range [1e-5,1e-1].
+    //
     // sccutoff....: [ double, fallback value is 0.4Aa ]
     //               Single-crystal d-spacing cutoff in Angstrom. When creating
     //               single-crystal scatterers, crystal planes with spacing
@@ -318,6 +358,134 @@ namespace NCrystal {
     //               vdoslux level actually used will be 3 less than the one
     //               specified in this variable (but at least 0).
     //
+    // vdosthintol.: [ double, fallback value is 0 ]
+    //               When non-zero, the alpha and beta grids of scattering
+    //               kernels expanded from a VDOS (including idealised Debye
+    //               model VDOS's) are thinned, removing grid points wherever
+    //               the S(alpha,beta) values there are reproduced to within
+    //               this relative tolerance by interpolation between the
+    //               remaining neighbouring points. The resulting smaller
+    //               kernels need less memory and initialisation time for
+    //               essentially unchanged accuracy. Values must be 0
+    //               (disabled) or in the range [1e-9,1e-1].
+    //
+    // sabalias....: [ bool, fallback value is false ]
+    //               Whether to sample scatterings on S(alpha,beta) scattering
+    //               kernels (including those expanded from a VDOS) with an
+    //               alternative algorithm, which selects the beta bin in
+    //               constant time with a precomputed alias table and needs no
+    //               internal rejection loop. Rather than interpolating alpha
+    //               between neighbouring beta grid points, it maps alpha from
+    //               the nearby grid point onto the kinematically allowed range,
+    //               so the sampled distributions differ slightly (within the
+    //               precision of the kernel grid) from those of the default
+    //               algorithm. Cross sections are unaffected.
+    //
+    // sabfloat32..: [ bool, fallback value is false ]
+    //               Whether to keep the large derived tables (log(S) values
+    //               and cumulative alpha integrals) of S(alpha,beta)
+    //               scattering kernels (including those expanded from a VDOS)
+    //               in single rather than double precision, halving their
+    //               memory usage. Values are widened to double precision as
+    //               they are used, so cross sections and sampled
+    //               distributions are only affected at the level of the
+    //               rounding of the tabulated values.
+    //
+    // fgtab.......: [ bool, fallback value is false ]
+    //               Whether to sample energy transfers of free-gas scattering
+    //               models from precomputed tables (shared between all
+    //               materials with the same target masses), rather than with
+    //               the exact rejection sampling algorithm. This is
+    //               significantly faster for heavier gases, at the cost of
+    //               small interpolation errors in the sampled distributions.
+    //               Cross sections are unaffected.
+    //
+    // sabtinterp..: [ double, fallback value is 0 ]
+    //               When non-zero, scattering kernels expanded from a VDOS
+    //               (including idealised Debye model VDOS's) are only built at
+    //               temperatures on a coarse grid with this spacing (in
+    //               kelvin). Materials at temperatures between two grid points
+    //               will then linearly interpolate the cross sections of the
+    //               two neighbouring kernels, and sample scatterings from one
+    //               or the other in proportion to their contributions to the
+    //               interpolated cross section. This allows many materials at
+    //               slightly different temperatures (e.g. cells of a reactor
+    //               model with a temperature profile) to share a few kernels,
+    //               at the cost of an approximation whose precision depends on
+    //               the grid spacing. Values must be 0 (disabled) or in the
+    //               range [1e-3,1e3].
+    //
+    // xstabprec...: [ double, fallback value is 0 ]
+    //               When non-zero, scattering cross sections in isotropic
+    //               materials are evaluated (for neutron energies between
+    //               1e-5eV and 10eV) via a precomputed table on a union energy
+    //               grid of all scattering components, which is refined until
+    //               linear interpolation reproduces the exact cross sections to
+    //               the approximate relative precision given by this
+    //               parameter. Bragg edges are always treated exactly. This
+    //               can speed up cross section evaluations in materials with
+    //               many or expensive scattering components, at the cost of
+    //               additional initialisation time and memory. Values must be
+    //               0 (disabled) or in the range [1e-9,1e-1].
+    //
+    // xsquant.....: [ double, fallback value is 0 ]
+    //               When non-zero, scattering cross sections in anisotropic
+    //               materials (e.g. single crystals) are evaluated for
+    //               quantised neutron energies and directions, using this
+    //               parameter as the relative bin width in energy and as the
+    //               bin width of each direction component. Cross sections are
+    //               evaluated at the bin centres, and kept in a cache shared by
+    //               all threads (and all materials configured with this
+    //               parameter), so neutrons in the same bin do not require new
+    //               evaluations. This is an approximation, which can greatly
+    //               speed up simulations of well collimated monochromatic beams,
+    //               where many neutrons are effectively identical. The
+    //               tolerance should be well below the beam divergence and the
+    //               mosaicity. It is ignored for isotropic materials. Values
+    //               must be 0 (disabled) or in the range [1e-9,1e-1].
+    //
+    // dbintol.....: [ double, fallback value is 0 ]
+    //               When non-zero, Bragg diffraction in powders is modelled
+    //               with planes grouped into bins of d-spacings, each bin
+    //               spanning at most this relative tolerance below the largest
+    //               d-spacing in it. The summed contributions of the planes in
+    //               a bin are assigned to the largest d-spacing, so the Bragg
+    //               edge at which a bin starts to contribute is unchanged, as
+    //               are cross sections above the last edge of a bin, while
+    //               scattering angles are shifted by (roughly) no more than
+    //               the tolerance. Planes well separated from others are not
+    //               affected. This can greatly reduce the number of edges in
+    //               large low-symmetry unit cells, speeding up cross section
+    //               evaluations and scatterings. Values must be 0 (disabled)
+    //               or in the range [1e-9,1e-1].
+    //
+    // emax........: [ double, fallback value is 0 ]
+    //               When non-zero, the material is only intended for use with
+    //               neutron energies (in eV) up to this value, which allows
+    //               material setup to skip work which is only needed at higher
+    //               energies. Currently this means that crystal planes with
+    //               d-spacings too small to ever satisfy the Bragg condition at
+    //               these energies are not generated (effectively raising
+    //               dcutoff), which can greatly reduce initialisation time and
+    //               memory usage for complex crystals. Results at energies up
+    //               to this value are unaffected, while Bragg diffraction will
+    //               be missing at higher energies. Values must be 0 (disabled)
+    //               or in the range [1e-5,1e3].
+    //
+    // propsonly...: [ bool, fallback value is false ]
+    //               Request Info objects which only provide basic material
+    //               properties such as density, composition, temperature,
+    //               cross sections, dynamic information and (where available)
+    //               unit cell and atomic positions. Crystal planes are not
+    //               generated (as with dcutoff=-1), which is usually by far the
+    //               most expensive part of creating Info objects for
+    //               crystalline materials, in both time and memory. This is
+    //               intended for code which only needs material properties
+    //               (e.g. when building geometries), and it is an error to use
+    //               it when creating scatter physics. Info objects with and
+    //               without propsonly are cached separately. Currently only
+    //               NCMAT data supports this (other info factories ignore it).
+    //
     // atomdb......: [ string, fallback value is "" ]
     //               Modify atomic definitions if supported by the info factory
     //               (in practice this is unlikely to be supported by anything
@@ -369,6 +537,7 @@ namespace NCrystal {
     void set_packfact( double );
     void set_mos( MosaicityFWHM );
     void set_mosprec( double );
+    void set_mostab( bool );
     void set_sccutoff( double );
     void set_dirtol( double );
     void set_coh_elas( bool );
@@ -378,7 +547,19 @@ namespace NCrystal {
     void set_scatfactory( const std::string& );
     void set_absnfactory( const std::string& );
     void set_lcmode( int );
+    void set_lcfixedrot( bool );
+    void set_lctabprec( double );
     void set_vdoslux( int );
+    void set_vdosthintol( double );
+    void set_sabalias( bool );
+    void set_sabfloat32( bool );
+    void set_fgtab( bool );
+    void set_sabtinterp( double );
+    void set_xstabprec( double );
+    void set_xsquant( double );
+    void set_emax( double );
+    void set_propsonly( bool );
+    void set_dbintol( double );
     void set_atomdb( const std::string& );
     void set_lcaxis( const LCAxis& );
     //
@@ -407,13 +588,26 @@ namespace NCrystal {
     double get_packfact() const;
     MosaicityFWHM get_mos() const;
     double get_mosprec() const;
+    bool get_mostab() const;
     double get_sccutoff() const;
     double get_dirtol() const;
     LCAxis get_lcaxis() const;
     const std::string& get_scatfactory() const;
     const std::string& get_absnfactory() const;
     int  get_lcmode() const;
+    bool get_lcfixedrot() const;
+    double get_lctabprec() const;
     int  get_vdoslux() const;
+    double get_vdosthintol() const;
+    bool get_sabalias() const;
+    bool get_sabfloat32() const;
+    bool get_fgtab() const;
+    double get_sabtinterp() const;
+    double get_xstabprec() const;
+    double get_xsquant() const;
+    double get_emax() const;
+    bool get_propsonly() const;
+    double get_dbintol() const;
     const std::string& get_atomdb() const;
     const std::vector<VectS>& get_atomdb_parsed() const;
 
@@ -511,6 +705,10 @@ namespace NCrystal {
     //be invoked by the factory infrastructure:
     void checkConsistency() const;
 
+    //Copy with the packfact parameter removed (i.e. unset, rather than set to
+    //1.0), for use as key when creating processes which do not depend on it:
+    MatCfg cloneWithoutPackfact() const;
+
     //Convenience interface for setting/decoding scatfactory+absnfactory parameters:
     struct FactRequested {
       std::string specific;
@@ -524,6 +722,20 @@ namespace NCrystal {
     //Unspecified ordering (for usage as map keys):
     bool operator<(const MatCfg&) const;
 
+    //Canonical compact key, holding everything relevant for the ordering
+    //above, along with a precomputed 64bit hash of it (for usage in hash
+    //maps). Two objects have equal keys exactly when neither is ordered before
+    //the other. The key is computed on first request, and shared by copies
+    //until they are modified:
+    struct CacheKey {
+      uint64_t hash;
+      std::string str;
+      bool operator==(const CacheKey& o) const { return hash == o.hash && str == o.str; }
+      bool operator!=(const CacheKey& o) const { return !(*this==o); }
+    };
+    using CacheKeySP = std::shared_ptr<const CacheKey>;
+    CacheKeySP cacheKey() const;
+
   private:
     struct constructor_args : private MoveOnly {
       OptionalTextDataSP td; std::string pars, origfn;
@@ -550,6 +762,8 @@ namespace NCrystal {
     Temperature get_temp() const;
     double get_dcutoff() const;
     double get_dcutoffup() const;
+    double get_emax() const;
+    bool get_propsonly() const;
     const std::string& get_atomdb() const;
     const std::vector<VectS>& get_atomdb_parsed() const;
     std::string get_infofact_name() const;
@@ -570,6 +784,7 @@ namespace NCrystal {
     MatInfoCfg( MatInfoCfg&& ) = default;
     MatInfoCfg& operator=(MatInfoCfg&&) = default;
     bool operator<(const MatInfoCfg&) const;
+    MatCfg::CacheKeySP cacheKey() const;//like MatCfg::cacheKey, but only with parameters above
   private:
     MatCfg m_cfg;
   };
@@ -596,6 +811,8 @@ namespace NCrystal {
   inline Temperature MatInfoCfg::get_temp() const { return m_cfg.get_temp(); }
   inline double MatInfoCfg::get_dcutoff() const { return m_cfg.get_dcutoff(); }
   inline double MatInfoCfg::get_dcutoffup() const { return m_cfg.get_dcutoffup(); }
+  inline double MatInfoCfg::get_emax() const { return m_cfg.get_emax(); }
+  inline bool MatInfoCfg::get_propsonly() const { return m_cfg.get_propsonly(); }
   inline const std::string& MatInfoCfg::get_atomdb() const { return m_cfg.get_atomdb(); }
   inline const std::vector<VectS>& MatInfoCfg::get_atomdb_parsed() const { return m_cfg.get_atomdb_parsed(); }
   inline std::string MatInfoCfg::get_infofact_name() const { return m_cfg.get_infofact_name(); }
@@ -30,6 +30,9 @@
 #include <atomic>
 #include <cstddef>
 #include <new>
+#include <set>
+#include <vector>
+#include <iterator>
 
 namespace NCrystal {
 
@@ -37,10 +40,22 @@ namespace NCrystal {
   //clear data associated to active object for which client code has ownership):
   NCRYSTAL_API void clearCaches();
 
+  //Same as clearCaches(), except that the objects released from the caches
+  //are destructed in a background thread, so the caller is not stalled while
+  //large cached data structures are deallocated:
+  NCRYSTAL_API void clearCachesAsync();
+
   //For internal NCrystal usage, registered functions will be invoked whenever
   //clearCaches() is called:
   NCRYSTAL_API void registerCacheCleanupFunction(std::function<void()>);
 
+  //For internal NCrystal usage, cache cleanup code should hand objects it
+  //releases to this function rather than letting them go out of scope (and
+  //must not hold any locks while doing so). They are then either destructed
+  //immediately, or in a background thread when invoked during
+  //clearCachesAsync():
+  NCRYSTAL_API void disposeReleasedCacheObjects( std::vector<std::shared_ptr<const void>>&& );
+
   //Type alias for std::shared_ptr which makes it clear when to use shared_obj
   //and when to use the nullable alternative:
   template <class T>
@@ -260,6 +275,51 @@ namespace NCrystal {
 
   };
 
+  //Accounting of the (approximate) memory footprint of a tree of objects, like
+  //an Info object or a process and its components. Memory which is owned
+  //exclusively by the tree is kept separate from memory held by sub-objects
+  //which are also referenced from elsewhere (e.g. by factory caches or other
+  //process trees), since only the former would be released if the tree was
+  //deleted. Shared sub-objects reached more than once are only counted once.
+  class MemoryFootprint {
+  public:
+    //Add bytes directly owned by the object currently being accounted:
+    void add( std::size_t nbytes ) noexcept;
+
+    //Visit sub-objects held via shared pointers. These are counted as shared
+    //if the pointer has other owners (hence the actual owning pointer must be
+    //passed, not a temporary copy). By default obj->accountMemory(*this) is
+    //invoked, but a custom function taking the object can be provided:
+    template<class T>
+    void addSharedObject( const std::shared_ptr<T>& obj );
+    template<class T, class TFct>
+    void addSharedObject( const std::shared_ptr<T>& obj, TFct&& fct );
+    template<class T>
+    void addSharedObject( const shared_obj<T>& obj ) { addSharedObject( obj.getsp() ); }
+    template<class T, class TFct>
+    void addSharedObject( const shared_obj<T>& obj, TFct&& fct ) { addSharedObject( obj.getsp(), std::forward<TFct>(fct) ); }
+
+    std::size_t exclusiveBytes() const noexcept { return m_exclusive; }
+    std::size_t sharedBytes() const noexcept { return m_shared; }
+    std::size_t totalBytes() const noexcept { return m_exclusive + m_shared; }
+
+  private:
+    std::set<const void*> m_seen;
+    std::size_t m_exclusive = 0;
+    std::size_t m_shared = 0;
+    unsigned m_shareddepth = 0;
+  };
+
+  //Convenience function for objects with an accountMemory(MemoryFootprint&)
+  //method:
+  template<class T>
+  inline MemoryFootprint memoryFootprint( const T& t )
+  {
+    MemoryFootprint mf;
+    t.accountMemory( mf );
+    return mf;
+  }
+
   //Aligned allocation suitable for any alignment size. Returned memory must be
   //eventually released by call to std::free. Throws std::bad_alloc in case the
   //allocation fails.
@@ -270,6 +330,53 @@ namespace NCrystal {
   template<class TValue>
   inline TValue* alignedAlloc( std::size_t number_of_objects );
 
+  //Simple expanding-only memory pool (arena), for the many short-lived
+  //allocations made by temporary containers while building up a material
+  //(e.g. node-based maps and lists). Memory is handed out from large chunks,
+  //individual deallocations are ignored, and everything is released at once
+  //when the pool is released or destructed. This gives better cache locality,
+  //reduces memory fragmentation, and avoids contention in the global allocator
+  //when many threads build materials concurrently. A pool must not be used
+  //concurrently from several threads. Requests larger than the chunk size get
+  //a dedicated chunk. Alignments beyond alignof(std::max_align_t) are not
+  //supported:
+  class MemPool {
+  public:
+    explicit MemPool( std::size_t chunksize = 65536 ) : m_size(chunksize) { nc_assert_always(chunksize>0); }
+    MemPool( const MemPool& ) = delete;
+    MemPool& operator=( const MemPool& ) = delete;
+    ~MemPool() { release(); }
+    void * allocate( std::size_t n, std::size_t alignment );
+    void deallocate( void *, std::size_t ) {}//ignore
+    void release();//free all chunks at once (invalidates all allocated memory)
+  private:
+    unsigned char * m_data = nullptr;
+    std::size_t const m_size;
+    std::size_t m_offset = 0;
+    std::vector<unsigned char*> m_chunks;
+    void * allocateDedicatedChunk( std::size_t n );
+  };
+
+  //Standard allocator for using a MemPool in STL containers. Note that
+  //containers using it must not outlive the pool:
+  template <typename T>
+  struct MemPoolAllocator {
+    template <typename U> friend struct MemPoolAllocator;
+    using value_type = T;
+    using pointer = T *;
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+    explicit MemPoolAllocator( MemPool * a ) : m_pool(a) { nc_assert(a); }
+    template <typename U> MemPoolAllocator( MemPoolAllocator<U> const & rhs ) : m_pool(rhs.m_pool) {}
+    pointer allocate( std::size_t n ) { return static_cast<pointer>(m_pool->allocate(n * sizeof(T), alignof(T))); }
+    void deallocate( pointer p, std::size_t n ) { m_pool->deallocate(p, n * sizeof(T)); }
+    template <typename U> bool operator==( MemPoolAllocator<U> const & rhs ) const { return m_pool == rhs.m_pool; }
+    template <typename U> bool operator!=( MemPoolAllocator<U> const & rhs ) const { return m_pool != rhs.m_pool; }
+  private:
+    MemPool * m_pool;
+  };
+
 }
 
 #if __cplusplus < 201402L
@@ -325,6 +432,70 @@ namespace NCrystal {
     return static_cast<TValue*>(alignedAlloc( alignof(TValue), number_of_objects * sizeof(TValue) ));
   }
 
+  inline void * MemPool::allocate( std::size_t n, std::size_t alignment )
+  {
+    nc_assert( n > 0 );
+    nc_assert( alignment > 0 && (alignment & (alignment - 1)) == 0 );
+    nc_assert( alignment <= alignof(std::max_align_t) );
+    if ( n > m_size / 4 )
+      return allocateDedicatedChunk( n );
+    m_offset = ( ( m_offset + alignment - 1 ) / alignment ) * alignment;//move up to alignment
+    if ( !m_data || m_offset + n > m_size ) {//must grow
+      m_chunks.push_back( m_data = static_cast<unsigned char *>(::operator new(m_size)) );
+      m_offset = 0;
+    }
+    void * result = m_data + m_offset;
+    m_offset += n;
+    return result;
+  }
+
+  inline void * MemPool::allocateDedicatedChunk( std::size_t n )
+  {
+    //Keep the current chunk at the back, so allocations continue from it:
+    auto chunk = static_cast<unsigned char *>(::operator new(n));
+    m_chunks.insert( m_chunks.empty() ? m_chunks.end() : std::prev(m_chunks.end()), chunk );
+    return chunk;
+  }
+
+  inline void MemPool::release()
+  {
+    for ( auto& e : m_chunks )
+      ::operator delete(e);
+    m_chunks.clear();
+    m_data = nullptr;
+    m_offset = 0;
+  }
+
+  inline void MemoryFootprint::add( std::size_t nbytes ) noexcept
+  {
+    ( m_shareddepth ? m_shared : m_exclusive ) += nbytes;
+  }
+
+  template<class T>
+  inline void MemoryFootprint::addSharedObject( const std::shared_ptr<T>& obj )
+  {
+    addSharedObject( obj, [this]( const T& t ) { t.accountMemory( *this ); } );
+  }
+
+  template<class T, class TFct>
+  inline void MemoryFootprint::addSharedObject( const std::shared_ptr<T>& obj, TFct&& fct )
+  {
+    if ( !obj || !m_seen.insert( static_cast<const void*>( obj.get() ) ).second )
+      return;
+    const bool isShared = obj.use_count() > 1;
+    if ( isShared )
+      ++m_shareddepth;
+    try {
+      fct( static_cast<const T&>( *obj ) );
+    } catch (...) {
+      if ( isShared )
+        --m_shareddepth;
+      throw;
+    }
+    if ( isShared )
+      --m_shareddepth;
+  }
+
 }
 
 #endif
@@ -95,6 +95,23 @@ namespace NCrystal {
       //kept synchronised with the NCMAT loader code.
       typedef std::map<std::string,VectD > FieldMapT;
       FieldMapT fields;//Stuff like "temperature", "alphagrid", "betagrid", ...
+      //If requested at parse time, large kernel tables ("sab" and
+      //"sab_scaled") are not decoded up front, but are instead represented by
+      //a function which will decode and return the values when invoked. Such
+      //deferred fields are never also present in the fields map, and the
+      //validate() method only checks their presence (the values must be
+      //validated by the code requesting them):
+      typedef std::function<VectD()> DeferredFieldDecoder;
+      typedef std::map<std::string,DeferredFieldDecoder> DeferredFieldMapT;
+      DeferredFieldMapT deferredFields;
+      //The raw text of each deferred field (the lines of the field, starting
+      //with the keyword), which remains valid as long as the corresponding
+      //decoder exists. This allows content based caching of data derived from
+      //the tables without decoding them first:
+      typedef std::map<std::string,std::pair<const char*,const char*>> DeferredFieldTextMapT;
+      DeferredFieldTextMapT deferredFieldTexts;
+      bool hasField( const std::string& name ) const { return fields.count(name) || deferredFields.count(name); }
+      void decodeDeferredFields();//move all deferred fields into the fields map (throws BadInput in case of problems)
       void validate() const;//throws BadInput in case of problems specific to this DynInfo object (missing/wrong fields, etc.)
     };
     std::vector<DynInfo> dyninfos;
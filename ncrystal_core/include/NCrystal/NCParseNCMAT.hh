@@ -33,13 +33,24 @@ namespace NCrystal {
   //of data (a more complete validation is typically carried out afterwards by
   //the NCMAT Loader code).
   //
+  //Data in the binary NCMAT format (data type "ncmatbin", see
+  //internal/NCNCMATBinary.hh) is also accepted, and will simply be decoded.
+  //
   //If doFinalValidation is false, the parser won't call NCMatData::validate()
   //before returning (although some other validations will still take place
   //during parsing). Calls with doFinalValidation=false should only happen if
   //the calling code intends to call NCMatData::validate() on the returned data.
+  //
+  //If deferLargeFields is true, large scattering kernel tables ("sab" and
+  //"sab_scaled" fields in @DYNINFO sections) are not decoded, but are instead
+  //made available in DynInfo::deferredFields, as functions which will decode
+  //the tables on demand (see NCNCMATData.hh). The data in the TextData object
+  //is kept alive by these functions, but any syntax errors in the tables will
+  //only be reported when the tables are decoded.
 
   NCRYSTAL_API NCMATData parseNCMATData( const TextData&,
-                                         bool doFinalValidation = true );
+                                         bool doFinalValidation = true,
+                                         bool deferLargeFields = false );
 
 }
 
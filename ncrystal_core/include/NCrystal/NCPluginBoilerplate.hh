@@ -89,6 +89,10 @@ extern "C" {
   {
     return NCPLUGIN_NAME_CSTR;
   }
+  ncpluginhh_export unsigned ncplugin_getprocinterfaceversion()
+  {
+    return NC::ProcImpl::processInterfaceVersion;
+  }
 }
 #endif
 
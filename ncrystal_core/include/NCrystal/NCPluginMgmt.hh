@@ -47,6 +47,25 @@ namespace NCrystal {
     // are enabled by adding them to the NCRYSTAL_PLUGIN_LIST environment
     // variable, while the loading of builtin plugins is handled by NCrystal's
     // cmake configuration.
+    //
+    // Loading of a plugin from NCRYSTAL_PLUGIN_LIST can be deferred until it
+    // is actually needed, by placing a manifest file next to the shared
+    // library, with ".ncplugin" appended to the library file name:
+    //
+    //   NCPluginManifest v1
+    //   name MyPlugin
+    //   factory scatter MyPluginScatFact     # textdata, info, scatter or absorption
+    //   datatypes myext                      # optional
+    //   customsections MYPLUGIN              # optional
+    //
+    // All factories registered by the plugin must be declared. Until the plugin
+    // is loaded, stand-in factories with the declared names are registered in
+    // their place. The library is loaded when one of those is explicitly
+    // requested, when data with one of the listed data types (or file
+    // extensions) is requested, or (for scatter and absorption factories) when
+    // the material has one of the listed @CUSTOM_ sections. Set
+    // NCRYSTAL_PLUGIN_NODEFER=1 to always load immediately. Deferred plugins
+    // will only appear in the loadedPlugins() list once actually loaded.
 
     //
     enum class PluginType { Dynamic, Builtin, Undefined };
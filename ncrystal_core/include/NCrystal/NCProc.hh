@@ -53,6 +53,34 @@ namespace NCrystal {
   class Scatter;
   class Absorption;
 
+  //Pool of cache objects which can be reused by Scatter and Absorption clones,
+  //avoiding heap allocations in workloads which create and discard many clones
+  //(e.g. one per secondary neutron). Caches released into the pool are
+  //invalidated in-place rather than deallocated, and are only handed out again
+  //for the same underlying process. A CachePool is not MT-safe, so
+  //multi-threaded applications should use one pool per thread.
+  class NCRYSTAL_API CachePool : private MoveOnly {
+  public:
+    CachePool() = default;
+
+    //Get a previously released cache for the process (returns nullptr if none
+    //is available, in which case a new cache is allocated on first usage):
+    CachePtr acquire( const ProcImpl::Process& );
+
+    //Invalidate cache and keep it for later reuse (nullptr is ignored):
+    void release( const ProcImpl::Process&, CachePtr&& );
+
+    std::size_t size() const noexcept { return m_entries.size(); }
+    void clear() { m_entries.clear(); }
+
+    //Allow move-semantics:
+    CachePool( CachePool&& ) = default;
+    CachePool& operator=( CachePool&& ) = default;
+  private:
+    struct Entry { UniqueIDValue procid; CachePtr cache; };
+    std::vector<Entry> m_entries;
+  };
+
   class NCRYSTAL_API Process : private MoveOnly {
   public:
 
@@ -66,7 +94,14 @@ namespace NCrystal {
     CrossSect crossSection( NeutronEnergy, const NeutronDirection& );
     CrossSect crossSectionIsotropic( NeutronEnergy );
 
+    //Vectorised cross sections (see ProcImpl::Process::evalManyXS):
+    void evalManyXS( const double* ekin, const double* ux, const double* uy, const double* uz,
+                     std::size_t N, double* out_xs );
+    void evalManyXSIsotropic( const double* ekin, std::size_t N, double* out_xs );
+
     void clearCache();
+    //Move the cache into the pool, for reuse by later clones:
+    void releaseCache( CachePool& );
     ProcImpl::ProcPtr underlyingPtr() const;
     const ProcImpl::Process& underlying() const;
 
@@ -93,6 +128,8 @@ namespace NCrystal {
     //Multi-threaded applications should clone the object and work
     //with one cloned object per thread:
     Absorption clone() const;
+    //Clone which borrows a cache from the pool if available:
+    Absorption clone( CachePool& ) const;
 
     //Allow move-semantics:
     Absorption( Absorption&& ) = default;
@@ -113,6 +150,16 @@ namespace NCrystal {
     ScatterOutcome sampleScatter( NeutronEnergy, const NeutronDirection& );
     ScatterOutcomeIsotropic sampleScatterIsotropic( NeutronEnergy );
 
+    //Sample scatterings of many neutrons at once, updating the provided arrays
+    //of neutron states in-place:
+    void sampleScatterMany( double* ekin, double* ux, double* uy, double* uz, std::size_t N );
+    void sampleScatterIsotropicMany( double* ekin, std::size_t N, double* out_mu );
+
+    //Biased sampling, conditioned on outcomes being inside the window and
+    //returning statistical weights (see ProcImpl::Process::sampleScatterBiased):
+    BiasedScatterOutcome sampleScatterBiased( NeutronEnergy, const NeutronDirection&, const ScatterWindow& );
+    BiasedScatterOutcomeIsotropic sampleScatterIsotropicBiased( NeutronEnergy, const ScatterWindow& );
+
     //Multi-threaded applications should clone the object and work
     //with one cloned object per thread (will use equivalently named
     //RNGProducer::produceXXX methods to produce new RNG stream for
@@ -120,6 +167,9 @@ namespace NCrystal {
     Scatter clone();
     Scatter cloneByIdx( RNGStreamIndex rngstreamid );
     Scatter cloneForCurrentThread();
+    //Same as clone(), but borrows a cache from the pool if available (return
+    //it with releaseCache when the clone is no longer needed):
+    Scatter clone( CachePool& );
     //Other esoteric cloning methods:
     Scatter cloneWithIdenticalRNGSettings();
     Scatter clone( shared_obj<RNGProducer>, shared_obj<RNG> );
@@ -132,6 +182,12 @@ namespace NCrystal {
     void replaceRNG( shared_obj<RNG>, shared_obj<RNGProducer> );
     void replaceRNGAndUpdateProducer( shared_obj<RNGStream> );//will reinit current producer (potentially affecting other objects!)
 
+    //Use the substream of base for the given (e.g. event) number. Calling
+    //this at the start of each event gives results which do not depend on the
+    //order in which events are processed. Caches and the producer are kept
+    //(base must be substream capable):
+    void replaceRNGWithSubstream( const RNGStream& base, uint64_t number );
+
     //Allow move-semantics:
     Scatter( Scatter&& ) = default;
     Scatter &operator=(Scatter &&) = default;
@@ -144,6 +200,95 @@ namespace NCrystal {
     shared_obj<RNGProducer> m_rngproducer;
   };
 
+
+  /////////////////////////////////////////////////////////////////////////////////
+  class NCRYSTAL_API MultiMaterialScatter final : private MoveOnly {
+  public:
+
+    //Batch processing of neutrons in several materials, for instance in
+    //voxelised geometries where a bank of neutrons is spread over many
+    //materials. Each neutron is given along with the index of its material
+    //(in the list passed to the constructor), and the neutrons are grouped by
+    //material internally, so the vectorised methods of each material can be
+    //used. Results are returned in the original order. As for Scatter
+    //objects, multi-threaded applications should use one instance per thread
+    //(e.g. created from Scatter clones).
+
+    MultiMaterialScatter( std::vector<Scatter> materials );
+
+    std::size_t nMaterials() const noexcept { return m_materials.size(); }
+    Scatter& material( std::size_t i ) { return m_materials.at(i); }
+
+    void evalManyXS( const unsigned* imat, const double* ekin,
+                     const double* ux, const double* uy, const double* uz,
+                     std::size_t N, double* out_xs );
+    void sampleScatterMany( const unsigned* imat, double* ekin,
+                            double* ux, double* uy, double* uz, std::size_t N );
+
+    //Allow move-semantics:
+    MultiMaterialScatter( MultiMaterialScatter&& ) = default;
+    MultiMaterialScatter& operator=( MultiMaterialScatter&& ) = default;
+
+  private:
+    std::vector<Scatter> m_materials;
+    //Workspace (reused between calls):
+    std::vector<std::size_t> m_offsets;
+    std::vector<std::size_t> m_order;
+    std::vector<std::size_t> m_pos;
+    std::vector<double> m_buf;
+    void groupByMaterial( const unsigned* imat, std::size_t N );
+  };
+
+  /////////////////////////////////////////////////////////////////////////////////
+  class NCRYSTAL_API TotalXS final : private MoveOnly {
+  public:
+
+    //Combined evaluation of the scattering and absorption cross sections of a
+    //material, for transport codes which need both at every step. Absorption
+    //processes which are simple 1/velocity laws (the standard AbsOOV model) or
+    //null are evaluated inline, without virtual dispatch or cache lookups. As
+    //for Scatter objects, multi-threaded applications should use one instance
+    //per thread (NB: Most users will create it via the createTotalXS function
+    //from NCFact.hh).
+
+    TotalXS( Scatter, Absorption );
+
+    struct Values {
+      CrossSect scatter;
+      CrossSect absorption;
+      CrossSect total;
+    };
+
+    Values crossSection( NeutronEnergy, const NeutronDirection& );
+    Values crossSectionIsotropic( NeutronEnergy );
+
+    //Vectorised version, providing scattering and absorption cross sections
+    //in separate arrays (the total is their sum):
+    void evalManyXSIsotropic( const double* ekin, std::size_t N,
+                              double* out_scatter, double* out_absorption );
+
+    Scatter& scatter() noexcept { return m_scat; }
+    Absorption& absorption() noexcept { return m_abs; }
+
+    //Allow move-semantics:
+    TotalXS( TotalXS&& ) = default;
+    TotalXS& operator=( TotalXS&& ) = default;
+
+  private:
+    Scatter m_scat;
+    Absorption m_abs;
+    double m_oovConst = 0.0;
+    bool m_absInline = false;
+    CrossSect absorptionXS( NeutronEnergy ekin )
+    {
+      if ( !m_absInline )
+        return m_abs.crossSectionIsotropic( ekin );
+      if ( m_oovConst == 0.0 )
+        return CrossSect{ 0.0 };
+      return CrossSect{ ekin.dbl() ? m_oovConst / std::sqrt( ekin.dbl() ) : kInfinity };
+    }
+  };
+
 }
 
 
@@ -164,10 +309,32 @@ inline bool NCrystal::Process::isOriented() const noexcept { return m_proc->isOr
 inline NCrystal::EnergyDomain NCrystal::Process::domain() const noexcept { return m_proc->domain(); }
 inline bool NCrystal::Process::isNull() const noexcept { return m_proc->isNull(); }
 inline void NCrystal::Process::clearCache() { m_cachePtr.reset(); }
+inline void NCrystal::Process::releaseCache( CachePool& pool ) { pool.release( *m_proc, std::move(m_cachePtr) ); m_cachePtr = nullptr; }
 inline NCrystal::CrossSect NCrystal::Process::crossSection( NeutronEnergy ekin, const NeutronDirection& dir )
 { return m_proc->crossSection(m_cachePtr,ekin,dir); }
 inline NCrystal::CrossSect NCrystal::Process::crossSectionIsotropic( NeutronEnergy ekin )
 { return m_proc->crossSectionIsotropic(m_cachePtr,ekin); }
+inline void NCrystal::Process::evalManyXS( const double* ekin, const double* ux, const double* uy, const double* uz,
+                                           std::size_t N, double* out_xs )
+{ m_proc->evalManyXS(m_cachePtr,ekin,ux,uy,uz,N,out_xs); }
+inline NCrystal::TotalXS::Values NCrystal::TotalXS::crossSection( NeutronEnergy ekin, const NeutronDirection& dir )
+{
+  Values v;
+  v.scatter = m_scat.crossSection( ekin, dir );
+  v.absorption = absorptionXS( ekin );
+  v.total = CrossSect{ v.scatter.dbl() + v.absorption.dbl() };
+  return v;
+}
+inline NCrystal::TotalXS::Values NCrystal::TotalXS::crossSectionIsotropic( NeutronEnergy ekin )
+{
+  Values v;
+  v.scatter = m_scat.crossSectionIsotropic( ekin );
+  v.absorption = absorptionXS( ekin );
+  v.total = CrossSect{ v.scatter.dbl() + v.absorption.dbl() };
+  return v;
+}
+inline void NCrystal::Process::evalManyXSIsotropic( const double* ekin, std::size_t N, double* out_xs )
+{ m_proc->evalManyXSIsotropic(m_cachePtr,ekin,N,out_xs); }
 inline NCrystal::shared_obj<NCrystal::RNG> NCrystal::Scatter::rngSO() { return m_rng; }
 inline NCrystal::RNG& NCrystal::Scatter::rng() { return m_rng; }
 inline NCrystal::shared_obj<NCrystal::RNGProducer> NCrystal::Scatter::rngproducerSO() { return m_rngproducer; }
@@ -176,5 +343,13 @@ inline NCrystal::ScatterOutcome NCrystal::Scatter::sampleScatter( NeutronEnergy
 { return m_proc->sampleScatter(m_cachePtr,m_rng,ekin,dir); }
 inline NCrystal::ScatterOutcomeIsotropic NCrystal::Scatter::sampleScatterIsotropic( NeutronEnergy ekin )
 { return m_proc->sampleScatterIsotropic(m_cachePtr,m_rng,ekin); }
+inline void NCrystal::Scatter::sampleScatterMany( double* ekin, double* ux, double* uy, double* uz, std::size_t N )
+{ m_proc->sampleScatterMany(m_cachePtr,m_rng,ekin,ux,uy,uz,N); }
+inline void NCrystal::Scatter::sampleScatterIsotropicMany( double* ekin, std::size_t N, double* out_mu )
+{ m_proc->sampleScatterIsotropicMany(m_cachePtr,m_rng,ekin,N,out_mu); }
+inline NCrystal::BiasedScatterOutcome NCrystal::Scatter::sampleScatterBiased( NeutronEnergy ekin, const NeutronDirection& dir, const ScatterWindow& window )
+{ return m_proc->sampleScatterBiased(m_cachePtr,m_rng,ekin,dir,window); }
+inline NCrystal::BiasedScatterOutcomeIsotropic NCrystal::Scatter::sampleScatterIsotropicBiased( NeutronEnergy ekin, const ScatterWindow& window )
+{ return m_proc->sampleScatterIsotropicBiased(m_cachePtr,m_rng,ekin,window); }
 
 #endif
@@ -24,6 +24,7 @@
 #include "NCrystal/NCTypes.hh"
 #include "NCrystal/NCRNG.hh"
 #include "NCrystal/NCSmallVector.hh"
+#include <functional>
 
 ///////////////////////////////////////////////////////////////////////////////////
 //                                                                               //
@@ -63,6 +64,10 @@
 //    The reason for doing this is that calling code will take care of managing  //
 //    issues such as cache lifetimes and having different caches in each thread  //
 //    of a multi-threaded programme.                                             //
+// 5) Processes used in bulk should consider overriding the batched methods      //
+//    (evalManyXS, sampleScatterIsotropicMany, etc.). Compositions of processes  //
+//    forward chunks of neutrons to them, so custom physics from plugins is not  //
+//    limited to the slower one-neutron-at-a-time default implementations.       //
 //                                                                               //
 ///////////////////////////////////////////////////////////////////////////////////
 
@@ -70,6 +75,13 @@ namespace NCrystal {
 
   namespace ProcImpl {
 
+    //Version of the virtual interface of the classes below, increased whenever
+    //virtual methods are added or changed. Dynamic plugins record the version
+    //they were compiled against (cf. NCPluginBoilerplate.hh), and are refused
+    //at load time in case of a mismatch, rather than crashing due to
+    //incompatible vtables (version 2 added the batched methods):
+    constexpr unsigned processInterfaceVersion = 2;
+
     ///////////////////////////////////////////////////////////////////////////////
     //
     // Common base class of all processes.
@@ -108,6 +120,14 @@ namespace NCrystal {
       //return std::shared_ptr and not shared_obj):
       virtual std::shared_ptr<Process> createMerged( const Process& ) const;
 
+      //Same as createMerged, but for processes which appear with different
+      //scales (e.g. fractions) in a composition. The returned process must
+      //represent scale_this*(*this)+scale_other*other in its entirety, and is
+      //used with a scale of 1.0:
+      virtual std::shared_ptr<Process> createMergedScaled( const Process&,
+                                                           double scale_this,
+                                                           double scale_other ) const;
+
       //The next four functions implement cross section calculations and
       //scattering samplings. Depending on material and process type, some of
       //them might be unavailable and will throw an exception if called:
@@ -124,6 +144,63 @@ namespace NCrystal {
       //This can be called only when processType is Scatter and materialType is Isotropic:
       virtual ScatterOutcomeIsotropic sampleScatterIsotropic(CachePtr&, RNG&, NeutronEnergy ) const = 0;
 
+      //Vectorised versions of crossSection and crossSectionIsotropic, which
+      //evaluates the cross sections of N neutrons with a single call (the
+      //output array must have room for N values). Directions are provided as
+      //separate arrays of x, y and z components. The default implementations
+      //simply invoke the single-neutron methods in a loop, but processes can
+      //override them with more efficient implementations. The same
+      //restrictions as for the single-neutron methods apply concerning when
+      //the isotropic version can be used. Implementations are free to exploit
+      //energies sorted in ascending or descending order (as is the case when
+      //evaluating a spectrum on a grid), as done by the Bragg diffraction
+      //model which then steps through the Bragg edges in a single pass:
+      virtual void evalManyXS( CachePtr&, const double* ekin,
+                               const double* ux, const double* uy, const double* uz,
+                               std::size_t N, double* out_xs ) const;
+      virtual void evalManyXSIsotropic( CachePtr&, const double* ekin, std::size_t N,
+                                        double* out_xs ) const;
+
+      //Vectorised versions of sampleScatter and sampleScatterIsotropic. The
+      //neutron states are provided as a structure-of-arrays (separate arrays
+      //of ekin and direction components) of length N, and are updated in place
+      //with the outcomes of the scatterings. The isotropic version writes the
+      //cosines of the scattering angles to the out_mu array. Default
+      //implementations simply invoke the single-neutron methods in a loop:
+      virtual void sampleScatterMany( CachePtr&, RNG&, double* ekin,
+                                      double* ux, double* uy, double* uz,
+                                      std::size_t N ) const;
+      virtual void sampleScatterIsotropicMany( CachePtr&, RNG&, double* ekin, std::size_t N,
+                                               double* out_mu ) const;
+
+      //Biased (forced) sampling of scatterings, conditioned on the outcome
+      //being inside the given window. The returned weight is the probability
+      //that an unbiased scattering ends up inside the window (or an unbiased
+      //estimate of it), so weighted results reproduce those of unbiased
+      //sampling restricted to the window. If no outcomes inside the window are
+      //possible, the weight is 0 and the neutron is returned unscattered. The
+      //default implementations sample window.ntrials unbiased scatterings and
+      //return one of those inside the window, picked at random, using the
+      //fraction of scatterings inside the window as weight:
+      virtual BiasedScatterOutcome sampleScatterBiased( CachePtr&, RNG&, NeutronEnergy,
+                                                        const NeutronDirection&,
+                                                        const ScatterWindow& ) const;
+      virtual BiasedScatterOutcomeIsotropic sampleScatterIsotropicBiased( CachePtr&, RNG&, NeutronEnergy,
+                                                                          const ScatterWindow& ) const;
+
+      //Upper bound (majorant) of the cross section for any neutron energy in the
+      //given domain and (for anisotropic materials) any neutron direction,
+      //intended for usage in e.g. Woodcock (delta) tracking. Bounds are
+      //conservative, but implementations should try to keep them reasonably
+      //tight. The default implementation returns infinity (i.e. no useful
+      //bound is available):
+      virtual CrossSect majorantCrossSection( EnergyDomain ) const;
+
+      //Account approximate memory usage (see MemoryFootprint in NCMem.hh).
+      //Implementations holding significant amounts of data should override
+      //this, since the default implementation only adds a nominal object size:
+      virtual void accountMemory( MemoryFootprint& ) const;
+
       //Callers who would like to reduce allocations during their event loops,
       //can call the following function which is likely (but not 100%
       //guaranteed) to allocate an object in the provided CachePtr (if needed):
@@ -146,6 +223,8 @@ namespace NCrystal {
       friend class AbsorptionIsotropicMat;
       //Infrastructure classes (final):
       friend class ProcComposition;
+      friend class ProfiledProcess;
+      friend class LazyProcess;
       friend class NullProcess;
     };
 
@@ -165,12 +244,25 @@ namespace NCrystal {
       //Isotropic material, anisotropic methods are implemented in terms of the isotropic ones:
       CrossSect crossSection(CachePtr& cp, NeutronEnergy ekin, const NeutronDirection& ) const final;
       ScatterOutcome sampleScatter(CachePtr& cp, RNG& rng, NeutronEnergy ekin, const NeutronDirection& ) const override;
+      void evalManyXS( CachePtr&, const double* ekin,
+                       const double* ux, const double* uy, const double* uz,
+                       std::size_t N, double* out_xs ) const final;
+      void sampleScatterMany( CachePtr&, RNG&, double* ekin,
+                              double* ux, double* uy, double* uz,
+                              std::size_t N ) const override;
+      BiasedScatterOutcome sampleScatterBiased( CachePtr&, RNG&, NeutronEnergy,
+                                                const NeutronDirection&,
+                                                const ScatterWindow& ) const override;
 
       //NB: We have marked the sampleScatter as "override" here instead of
       //"final", since some models might be able to do something more efficient
       //than the sampleScatter method implemented here (which calls
       //sampleScatterIsotropic followed by a call to
-      //the randNeutronDirectionGivenScatterMu utility function).
+      //the randNeutronDirectionGivenScatterMu utility function). Models
+      //reimplementing sampleScatter should also reimplement sampleScatterMany,
+      //since the version here is implemented via sampleScatterIsotropicMany
+      //followed by a call to the randNeutronDirectionsGivenScatterMu utility
+      //function.
 
     };
 
@@ -188,6 +280,12 @@ namespace NCrystal {
       //throw LogicError if attempted):
       CrossSect crossSectionIsotropic(CachePtr&, NeutronEnergy ) const final;
       ScatterOutcomeIsotropic sampleScatterIsotropic(CachePtr&, RNG&, NeutronEnergy ) const final;
+      void evalManyXSIsotropic( CachePtr&, const double* ekin, std::size_t N,
+                                double* out_xs ) const final;
+      void sampleScatterIsotropicMany( CachePtr&, RNG&, double* ekin, std::size_t N,
+                                       double* out_mu ) const final;
+      BiasedScatterOutcomeIsotropic sampleScatterIsotropicBiased( CachePtr&, RNG&, NeutronEnergy,
+                                                                  const ScatterWindow& ) const final;
     };
 
     ///////////////////////////////////////////////////////////////////////////////
@@ -201,13 +299,30 @@ namespace NCrystal {
 
       //Isotropic material, anisotropic xsect is implemented in terms of the isotropic one:
       CrossSect crossSection(CachePtr& cp, NeutronEnergy ekin, const NeutronDirection& ) const final;
+      void evalManyXS( CachePtr&, const double* ekin,
+                       const double* ux, const double* uy, const double* uz,
+                       std::size_t N, double* out_xs ) const final;
 
       //Absorption process, it is not allowed to call scattering methods (will
       //throw LogicError if attempted):
       ScatterOutcome sampleScatter(CachePtr&, RNG&, NeutronEnergy, const NeutronDirection& ) const final;
       ScatterOutcomeIsotropic sampleScatterIsotropic(CachePtr&, RNG&, NeutronEnergy ) const final;
+      void sampleScatterMany( CachePtr&, RNG&, double* ekin,
+                              double* ux, double* uy, double* uz,
+                              std::size_t N ) const final;
+      void sampleScatterIsotropicMany( CachePtr&, RNG&, double* ekin, std::size_t N,
+                                       double* out_mu ) const final;
+      BiasedScatterOutcome sampleScatterBiased( CachePtr&, RNG&, NeutronEnergy,
+                                                const NeutronDirection&,
+                                                const ScatterWindow& ) const final;
+      BiasedScatterOutcomeIsotropic sampleScatterIsotropicBiased( CachePtr&, RNG&, NeutronEnergy,
+                                                                  const ScatterWindow& ) const final;
     };
 
+    //Internal class holding tables of cross sections (see
+    //ProcComposition::enableXSTable and TabulatedXS below):
+    class XSTable;
+
     ///////////////////////////////////////////////////////////////////////////////
     //
     // Composition class. This is a technical class which can be used to
@@ -246,6 +361,67 @@ namespace NCrystal {
       CrossSect crossSectionIsotropic(CachePtr& cacheptr, NeutronEnergy ekin ) const final;
       ScatterOutcome sampleScatter(CachePtr& cacheptr, RNG& rng, NeutronEnergy ekin, const NeutronDirection& dir ) const final;
       ScatterOutcomeIsotropic sampleScatterIsotropic(CachePtr& cacheptr, RNG& rng, NeutronEnergy ekin ) const final;
+      void evalManyXS( CachePtr&, const double* ekin,
+                       const double* ux, const double* uy, const double* uz,
+                       std::size_t N, double* out_xs ) const final;
+      void evalManyXSIsotropic( CachePtr&, const double* ekin, std::size_t N,
+                                double* out_xs ) const final;
+      void sampleScatterMany( CachePtr&, RNG&, double* ekin,
+                              double* ux, double* uy, double* uz,
+                              std::size_t N ) const final;
+      void sampleScatterIsotropicMany( CachePtr&, RNG&, double* ekin, std::size_t N,
+                                       double* out_mu ) const final;
+      //Biased sampling first selects a component by cross section (as for
+      //unbiased sampling), and then uses its biased sampling methods:
+      BiasedScatterOutcome sampleScatterBiased( CachePtr&, RNG&, NeutronEnergy,
+                                                const NeutronDirection&,
+                                                const ScatterWindow& ) const final;
+      BiasedScatterOutcomeIsotropic sampleScatterIsotropicBiased( CachePtr&, RNG&, NeutronEnergy,
+                                                                  const ScatterWindow& ) const final;
+      CrossSect majorantCrossSection( EnergyDomain ) const final;
+      void accountMemory( MemoryFootprint& ) const final;
+
+      //Component-resolved access, for e.g. variance reduction schemes with
+      //separate weighting of components. The cumulative (scaled) component
+      //cross sections, which are used internally for selecting components when
+      //sampling, are written to out_commul (which must have room for
+      //components().size() values) and the total cross section is
+      //returned. Scatterings on a specific component can then be sampled with
+      //the same cache, without any further cross section evaluations:
+      CrossSect componentCrossSections( CachePtr&, NeutronEnergy, const NeutronDirection&,
+                                        double* out_commul ) const;
+      CrossSect componentCrossSectionsIsotropic( CachePtr&, NeutronEnergy, double* out_commul ) const;
+      ScatterOutcome sampleScatterComponent( CachePtr&, RNG&, unsigned icomponent,
+                                             NeutronEnergy, const NeutronDirection& ) const;
+      ScatterOutcomeIsotropic sampleScatterIsotropicComponent( CachePtr&, RNG&, unsigned icomponent,
+                                                               NeutronEnergy ) const;
+
+      //Optionally precompute a table of total and (cumulative) per-component
+      //cross sections on a union energy grid, so that cross section
+      //evaluations (and the selection of components when sampling) in
+      //isotropic materials requires just a binary search and a linear
+      //interpolation. The grid is refined until interpolated values agree with
+      //exact evaluations to within the requested relative precision. Energies
+      //where cross sections are known to be discontinuous (Bragg edges of
+      //PCBragg components and domain edges of all components) are placed at
+      //grid points, with values on both sides of them evaluated exactly, and
+      //energies outside the table range are always evaluated exactly. The
+      //table is shared by all users of the object, but is discarded if
+      //components are subsequently modified. Only allowed for isotropic
+      //materials:
+      void enableXSTable( double precision );
+      bool hasXSTable() const noexcept { return m_xstable != nullptr; }
+
+      //Optionally quantise neutron energies and directions when evaluating
+      //cross sections in anisotropic materials, using the given tolerance as
+      //the relative bin width in energy and as the bin width of direction
+      //components. Cross sections are then evaluated at the bin centres, and
+      //shared (via a global LRU cache) by all neutrons in the same bin and in
+      //all threads. This is an approximation, intended for e.g. collimated
+      //monochromatic beams where many neutrons are effectively
+      //identical. Only allowed for anisotropic materials:
+      void enableXSQuantisation( double tolerance );
+      double xsQuantisation() const noexcept { return m_xsquant; }
 
       //Combine components efficiently. Often this result in their placement in
       //a ProcComposition object, but in case of no null-processes in the list a
@@ -264,8 +440,377 @@ namespace NCrystal {
       ProcessType m_processType;
       MaterialType m_materialType;
       EnergyDomain m_domain = { NeutronEnergy{0.0}, NeutronEnergy{0.0} };
+      std::shared_ptr<const XSTable> m_xstable;
+      double m_xsquant = 0.0;//0 means no quantisation
+      class EvalPlan;
+      std::shared_ptr<const EvalPlan> m_plan;//rebuilt whenever m_components change.
+      void addComponentImpl( ProcPtr, double );
       class Impl;
       friend class Impl;
+      friend class ProfiledProcess;
+      friend class XSTable;
+    };
+
+    ///////////////////////////////////////////////////////////////////////////////
+    //
+    // Profiling wrapper, intended for continuous monitoring of the time spent
+    // in NCrystal in production. Use ProfiledProcess::wrap to get a process
+    // which gives identical results as the wrapped one, but in which a small
+    // fraction of the calls to each process in the tree (the process itself
+    // and, if it is a ProcComposition, each of its components) are timed. For
+    // every reportInterval calls to the top-level process, the callback is
+    // then invoked with a summary of (cumulative) call counts and estimated
+    // times of all processes in the tree. Calls to the vectorised methods count
+    // as one call per neutron. The callback is invoked from the thread making
+    // the call (never concurrently from several threads) and may throw
+    // exceptions, which propagate to the caller. It must not itself use the
+    // profiled process.
+    //
+    // Timed calls are selected deterministically (every 1/sampleFraction'th
+    // call), so results and RNG streams are completely unaffected, and the
+    // overhead of untimed calls is merely that of an atomic counter increment.
+    //
+
+    class NCRYSTAL_API ProfiledProcess final : public Process {
+    public:
+
+      struct NCRYSTAL_API Entry {
+        const char * name;//name() of the process
+        unsigned depth;//0 for the top-level process, 1 for its components
+        uint64_t nCallsXS;//number of cross section evaluations
+        uint64_t nCallsSampling;//number of sampled scatterings
+        double timeXS;//estimated total time in cross section evaluations [s]
+        double timeSampling;//estimated total time in sampling [s]
+      };
+      using Callback = std::function<void(const std::vector<Entry>&)>;
+
+      static ProcPtr wrap( ProcPtr, Callback,
+                           uint64_t reportInterval = 1000000,
+                           double sampleFraction = 0.01 );
+
+      //Current summary (also available outside the callback):
+      std::vector<Entry> summary() const;
+
+      const char * name() const noexcept final { return "ProfiledProcess"; }
+      const Process& wrapped() const noexcept { return *m_proc; }
+      MaterialType materialType() const noexcept final { return m_proc->materialType(); }
+      ProcessType processType() const noexcept final { return m_proc->processType(); }
+      EnergyDomain domain() const noexcept final { return m_proc->domain(); }
+      CrossSect crossSection(CachePtr&, NeutronEnergy, const NeutronDirection& ) const final;
+      CrossSect crossSectionIsotropic(CachePtr&, NeutronEnergy ) const final;
+      ScatterOutcome sampleScatter(CachePtr&, RNG&, NeutronEnergy, const NeutronDirection& ) const final;
+      ScatterOutcomeIsotropic sampleScatterIsotropic(CachePtr&, RNG&, NeutronEnergy ) const final;
+      void evalManyXS( CachePtr&, const double* ekin,
+                       const double* ux, const double* uy, const double* uz,
+                       std::size_t N, double* out_xs ) const final;
+      void evalManyXSIsotropic( CachePtr&, const double* ekin, std::size_t N,
+                                double* out_xs ) const final;
+      void sampleScatterMany( CachePtr&, RNG&, double* ekin,
+                              double* ux, double* uy, double* uz,
+                              std::size_t N ) const final;
+      void sampleScatterIsotropicMany( CachePtr&, RNG&, double* ekin, std::size_t N,
+                                       double* out_mu ) const final;
+      BiasedScatterOutcome sampleScatterBiased( CachePtr&, RNG&, NeutronEnergy,
+                                                const NeutronDirection&,
+                                                const ScatterWindow& ) const final;
+      BiasedScatterOutcomeIsotropic sampleScatterIsotropicBiased( CachePtr&, RNG&, NeutronEnergy,
+                                                                  const ScatterWindow& ) const final;
+      CrossSect majorantCrossSection( EnergyDomain d ) const final { return m_proc->majorantCrossSection(d); }
+      void accountMemory( MemoryFootprint& ) const final;
+
+      struct Shared;
+      ProfiledProcess( ProcPtr, std::shared_ptr<Shared>, unsigned depth );
+      ~ProfiledProcess();
+    private:
+      struct Stats {
+        std::atomic<uint64_t> ncalls{0};
+        std::atomic<uint64_t> nsampled{0};
+        std::atomic<uint64_t> sampledTime{0};//nanoseconds
+      };
+      ProcPtr m_proc;
+      std::shared_ptr<Shared> m_shared;
+      unsigned m_depth;
+      //NB: These mutable counters only record statistics, and never affect
+      //results (they are not "hidden-state"):
+      mutable Stats m_statsXS;
+      mutable Stats m_statsSampling;
+      template<class TFct>
+      void profile( Stats&, std::size_t n, TFct&& ) const;
+    };
+
+    ///////////////////////////////////////////////////////////////////////////////
+    //
+    // Wrapper for isotropic scattering processes with expensive cross section
+    // evaluations (e.g. custom physics provided by plugins). The cross section
+    // of the wrapped process is tabulated upon construction, and cross section
+    // evaluations afterwards require just a binary search and a linear
+    // interpolation. The table is built like the ones of
+    // ProcComposition::enableXSTable: starting from a logarithmic grid, it is
+    // refined until interpolated values agree with exact evaluations to within
+    // the requested relative precision. Domain edges of the wrapped process,
+    // Bragg edges of PCBragg instances (the wrapped process itself or its
+    // components in case of a ProcComposition) and any knownEdges supplied in
+    // the parameters are placed at grid points, so discontinuities at these
+    // energies are represented exactly. Energies outside [emin,emax] are
+    // always evaluated exactly, and scatterings are always sampled by the
+    // wrapped process.
+    //
+    // The expensive tabulation can be carried out with multiple threads (0
+    // means the number given by the NCRYSTAL_NTHREADS environment variable),
+    // in which case the wrapped process must of course support concurrent
+    // calls with separate CachePtr objects (as all processes should). The
+    // resulting table does not depend on the number of threads used.
+    //
+
+    class NCRYSTAL_API TabulatedXS final : public ScatterIsotropicMat {
+    public:
+
+      struct NCRYSTAL_API Params {
+        double precision = 1e-3;
+        double emin = 1e-5;//eV
+        double emax = 10.0;//eV
+        VectD knownEdges;
+        unsigned nthreads = 1;
+      };
+
+      TabulatedXS( ProcPtr );
+      TabulatedXS( ProcPtr, const Params& );
+      ~TabulatedXS();
+
+      const char * name() const noexcept final { return "TabulatedXS"; }
+      const Process& wrapped() const noexcept { return *m_proc; }
+      EnergyDomain domain() const noexcept final { return m_proc->domain(); }
+      CrossSect crossSectionIsotropic(CachePtr&, NeutronEnergy ) const final;
+      void evalManyXSIsotropic( CachePtr&, const double* ekin, std::size_t N,
+                                double* out_xs ) const final;
+      ScatterOutcome sampleScatter(CachePtr&, RNG&, NeutronEnergy, const NeutronDirection& ) const final;
+      ScatterOutcomeIsotropic sampleScatterIsotropic(CachePtr&, RNG&, NeutronEnergy ) const final;
+      void sampleScatterMany( CachePtr&, RNG&, double* ekin,
+                              double* ux, double* uy, double* uz,
+                              std::size_t N ) const final;
+      void sampleScatterIsotropicMany( CachePtr&, RNG&, double* ekin, std::size_t N,
+                                       double* out_mu ) const final;
+      BiasedScatterOutcome sampleScatterBiased( CachePtr&, RNG&, NeutronEnergy,
+                                                const NeutronDirection&,
+                                                const ScatterWindow& ) const final;
+      BiasedScatterOutcomeIsotropic sampleScatterIsotropicBiased( CachePtr&, RNG&, NeutronEnergy,
+                                                                  const ScatterWindow& ) const final;
+      //Interpolated values never exceed the tabulated ones, which are exact:
+      CrossSect majorantCrossSection( EnergyDomain ) const final;
+      void accountMemory( MemoryFootprint& ) const final;
+
+    private:
+      ProcPtr m_proc;
+      std::shared_ptr<const XSTable> m_table;
+    };
+
+    ///////////////////////////////////////////////////////////////////////////////
+    //
+    // Wrapper for isotropic elastic scattering processes with expensive
+    // sampling code (e.g. custom SANS-like physics provided by plugins). Upon
+    // construction, nsamples scatterings are sampled with the wrapped process
+    // at each point of a logarithmic energy grid (with nptsPerDecade points per
+    // decade), and the resulting distributions of mu=cos(scattering angle) are
+    // stored as tables of nquantiles+1 equidistant quantiles. Sampling then
+    // requires just a single random number: the quantile function is
+    // evaluated by linear interpolation in the tables at the two grid points
+    // adjacent to the neutron energy, and the results are interpolated
+    // linearly in log(ekin). The tables are thus approximations, with a
+    // precision controlled by the parameters, and they are only appropriate
+    // for mu distributions varying smoothly with energy.
+    //
+    // Outside [emin,emax], and between grid points where the wrapped process
+    // has a vanishing cross section, sampling is carried out by the wrapped
+    // process, which also provides all cross sections. An exception is thrown
+    // if the wrapped process is found to not be elastic.
+    //
+    // The tables are sampled using independent counter-based RNG streams for
+    // each grid point (see createCounterBasedRNG), so they are reproducible
+    // given the seed, and do not depend on the number of threads used (0 means
+    // the number given by the NCRYSTAL_NTHREADS environment variable).
+    //
+
+    class NCRYSTAL_API TabulatedMuSampling final : public ScatterIsotropicMat {
+    public:
+
+      struct NCRYSTAL_API Params {
+        double emin = 1e-5;//eV
+        double emax = 10.0;//eV
+        unsigned nptsPerDecade = 20;
+        unsigned nsamples = 20000;
+        unsigned nquantiles = 256;
+        uint64_t seed = 0;
+        unsigned nthreads = 1;
+      };
+
+      TabulatedMuSampling( ProcPtr );
+      TabulatedMuSampling( ProcPtr, const Params& );
+      ~TabulatedMuSampling();
+
+      const char * name() const noexcept final { return "TabulatedMuSampling"; }
+      const Process& wrapped() const noexcept { return *m_proc; }
+      EnergyDomain domain() const noexcept final { return m_proc->domain(); }
+      CrossSect crossSectionIsotropic(CachePtr& cp, NeutronEnergy ekin ) const final
+      {
+        return m_proc->crossSectionIsotropic( cp, ekin );
+      }
+      void evalManyXSIsotropic( CachePtr& cp, const double* ekin, std::size_t N,
+                                double* out_xs ) const final
+      {
+        m_proc->evalManyXSIsotropic( cp, ekin, N, out_xs );
+      }
+      ScatterOutcomeIsotropic sampleScatterIsotropic(CachePtr&, RNG&, NeutronEnergy ) const final;
+      CrossSect majorantCrossSection( EnergyDomain d ) const final { return m_proc->majorantCrossSection(d); }
+      void accountMemory( MemoryFootprint& ) const final;
+
+    private:
+      ProcPtr m_proc;
+      double m_logemin = 0.0;
+      double m_invdlog = 0.0;
+      std::size_t m_ngrid = 0;
+      unsigned m_nquantiles = 0;
+      VectD m_quantiles;//m_nquantiles+1 values per grid point
+      std::vector<char> m_valid;//whether table is available at grid point
+    };
+
+    ///////////////////////////////////////////////////////////////////////////////
+    //
+    // Placeholder for a process whose construction is deferred until it is
+    // actually needed, i.e. until the first call to any of the cross section,
+    // sampling or majorant methods (since ProcComposition only invokes
+    // components with a domain containing the neutron energy, a suitable
+    // domain can postpone this further). The material type, process type and
+    // domain must be known up front, and the created process must be
+    // consistent with them (its domain must be contained in the declared
+    // one). Creation is thread-safe and happens at most once (if the creator
+    // throws an exception, it propagates to the caller, and creation is
+    // attempted again upon the next call).
+    //
+
+    class NCRYSTAL_API LazyProcess final : public Process {
+    public:
+      using Creator = std::function<ProcPtr()>;
+      LazyProcess( MaterialType, ProcessType, EnergyDomain, Creator );
+      ~LazyProcess();
+
+      const char * name() const noexcept final { return "LazyProcess"; }
+      MaterialType materialType() const noexcept final { return m_materialType; }
+      ProcessType processType() const noexcept final { return m_processType; }
+      EnergyDomain domain() const noexcept final { return m_domain; }
+
+      //Access underlying process (creating it if needed):
+      const Process& process() const;
+      bool isCreated() const noexcept { return m_created.load( std::memory_order_acquire ) != nullptr; }
+
+      CrossSect crossSection(CachePtr&, NeutronEnergy, const NeutronDirection& ) const final;
+      CrossSect crossSectionIsotropic(CachePtr&, NeutronEnergy ) const final;
+      ScatterOutcome sampleScatter(CachePtr&, RNG&, NeutronEnergy, const NeutronDirection& ) const final;
+      ScatterOutcomeIsotropic sampleScatterIsotropic(CachePtr&, RNG&, NeutronEnergy ) const final;
+      void evalManyXS( CachePtr&, const double* ekin,
+                       const double* ux, const double* uy, const double* uz,
+                       std::size_t N, double* out_xs ) const final;
+      void evalManyXSIsotropic( CachePtr&, const double* ekin, std::size_t N,
+                                double* out_xs ) const final;
+      void sampleScatterMany( CachePtr&, RNG&, double* ekin,
+                              double* ux, double* uy, double* uz,
+                              std::size_t N ) const final;
+      void sampleScatterIsotropicMany( CachePtr&, RNG&, double* ekin, std::size_t N,
+                                       double* out_mu ) const final;
+      BiasedScatterOutcome sampleScatterBiased( CachePtr&, RNG&, NeutronEnergy,
+                                                const NeutronDirection&,
+                                                const ScatterWindow& ) const final;
+      BiasedScatterOutcomeIsotropic sampleScatterIsotropicBiased( CachePtr&, RNG&, NeutronEnergy,
+                                                                  const ScatterWindow& ) const final;
+      CrossSect majorantCrossSection( EnergyDomain ) const final;
+      void accountMemory( MemoryFootprint& ) const final;
+
+    private:
+      MaterialType m_materialType;
+      ProcessType m_processType;
+      EnergyDomain m_domain;
+      Creator m_creator;
+      //NB: Mutable, but merely implementing the deferred construction (not
+      //"hidden-state"):
+      mutable std::mutex m_mutex;
+      mutable OptionalProcPtr m_proc;
+      mutable std::atomic<const Process*> m_created{nullptr};
+      const Process& createProcess() const;
+    };
+
+    ///////////////////////////////////////////////////////////////////////////////
+    //
+    // Workload-adaptive version of TabulatedXS. Rather than tabulating a fixed
+    // energy range up front, the first nlearn cross section evaluations are
+    // carried out exactly while a coarse histogram (binsPerDecade bins per
+    // decade of energy) of the energies is recorded. A TabulatedXS is then
+    // built over the range of the non-empty bins (widened by one bin on each
+    // side), and used for all subsequent cross section evaluations. Ranges
+    // never queried are thus never tabulated, which allows a smaller table or
+    // a finer precision for the same cost. Energies outside the tabulated
+    // range continue to be evaluated exactly, and scatterings are always
+    // sampled by the wrapped process.
+    //
+    // Note that which calls are served by the table depends on the order of
+    // calls (and in multi-threaded programmes, on their timing), so results
+    // are only reproducible to within the requested precision. Only isotropic
+    // scattering processes are supported (tables of cross sections of
+    // oriented crystals as functions of both energy and direction would be
+    // prohibitively large).
+    //
+
+    class NCRYSTAL_API AdaptiveTabulatedXS final : public ScatterIsotropicMat {
+    public:
+
+      struct NCRYSTAL_API Params {
+        uint64_t nlearn = 100000;//number of cross section evaluations observed
+        unsigned binsPerDecade = 10;
+        double precision = 1e-4;
+        VectD knownEdges;
+        unsigned nthreads = 1;//for building the table (0 means NCRYSTAL_NTHREADS)
+      };
+
+      AdaptiveTabulatedXS( ProcPtr );
+      AdaptiveTabulatedXS( ProcPtr, const Params& );
+      ~AdaptiveTabulatedXS();
+
+      const char * name() const noexcept final { return "AdaptiveTabulatedXS"; }
+      const Process& wrapped() const noexcept { return *m_proc; }
+
+      //The table, once built (nullptr while still learning):
+      const TabulatedXS* tabulated() const noexcept { return m_tab.load( std::memory_order_acquire ); }
+
+      EnergyDomain domain() const noexcept final { return m_proc->domain(); }
+      CrossSect crossSectionIsotropic(CachePtr&, NeutronEnergy ) const final;
+      void evalManyXSIsotropic( CachePtr&, const double* ekin, std::size_t N,
+                                double* out_xs ) const final;
+      ScatterOutcome sampleScatter(CachePtr&, RNG&, NeutronEnergy, const NeutronDirection& ) const final;
+      ScatterOutcomeIsotropic sampleScatterIsotropic(CachePtr&, RNG&, NeutronEnergy ) const final;
+      void sampleScatterMany( CachePtr&, RNG&, double* ekin,
+                              double* ux, double* uy, double* uz,
+                              std::size_t N ) const final;
+      void sampleScatterIsotropicMany( CachePtr&, RNG&, double* ekin, std::size_t N,
+                                       double* out_mu ) const final;
+      BiasedScatterOutcome sampleScatterBiased( CachePtr&, RNG&, NeutronEnergy,
+                                                const NeutronDirection&,
+                                                const ScatterWindow& ) const final;
+      BiasedScatterOutcomeIsotropic sampleScatterIsotropicBiased( CachePtr&, RNG&, NeutronEnergy,
+                                                                  const ScatterWindow& ) const final;
+      //Interpolated values never exceed the exact ones at the grid points, so
+      //the majorant of the wrapped process is valid before and after the switch:
+      CrossSect majorantCrossSection( EnergyDomain d ) const final { return m_proc->majorantCrossSection(d); }
+      void accountMemory( MemoryFootprint& ) const final;
+
+    private:
+      ProcPtr m_proc;
+      Params m_pars;
+      std::size_t m_nbins;
+      //NB: Mutable, but merely implementing the switch to the table:
+      std::unique_ptr<std::atomic<uint64_t>[]> m_hist;
+      mutable std::atomic<uint64_t> m_ncalls{0};
+      mutable std::shared_ptr<const TabulatedXS> m_tabOwner;//set once before m_tab
+      mutable std::atomic<const TabulatedXS*> m_tab{nullptr};
+      void record( const double* ekin, std::size_t N ) const;
+      void buildTable() const;
     };
 
     ///////////////////////////////////////////////////////////////////////////////
@@ -281,6 +826,12 @@ namespace NCrystal {
       CrossSect crossSection(CachePtr&, NeutronEnergy, const NeutronDirection& ) const final { return CrossSect{0.0}; }
       ScatterOutcomeIsotropic sampleScatterIsotropic(CachePtr&, RNG&, NeutronEnergy ) const final;
       ScatterOutcome sampleScatter(CachePtr&, RNG&, NeutronEnergy, const NeutronDirection& ) const final;
+      void evalManyXS( CachePtr&, const double*, const double*, const double*, const double*,
+                       std::size_t N, double* out_xs ) const final { std::fill( out_xs, out_xs + N, 0.0 ); }
+      void evalManyXSIsotropic( CachePtr&, const double*, std::size_t N, double* out_xs ) const final { std::fill( out_xs, out_xs + N, 0.0 ); }
+      void sampleScatterMany( CachePtr&, RNG&, double*, double*, double*, double*, std::size_t ) const final {}
+      void sampleScatterIsotropicMany( CachePtr&, RNG&, double*, std::size_t N, double* out_mu ) const final { std::fill( out_mu, out_mu + N, 1.0 ); }
+      CrossSect majorantCrossSection( EnergyDomain ) const final { return CrossSect{0.0}; }
     private:
       UniqueID m_uniqueID;
       //Only NullScatter/NullAbsorption can inherit from this class:
@@ -317,6 +868,10 @@ namespace NCrystal {
     inline bool Process::isNull() const noexcept { auto d = domain(); return std::isinf(d.elow.get()) || d.elow>=d.ehigh; }
 
     inline std::shared_ptr<Process> Process::createMerged( const Process& ) const { return nullptr; }
+    inline std::shared_ptr<Process> Process::createMergedScaled( const Process&, double, double ) const { return nullptr; }
+
+    inline CrossSect Process::majorantCrossSection( EnergyDomain ) const { return CrossSect{kInfinity}; }
+    inline void Process::accountMemory( MemoryFootprint& mf ) const { mf.add( sizeof(Process) ); }
 
     template<class CacheClass>
     inline CacheClass& Process::accessCache(CachePtr& cpbase) const {
@@ -341,6 +896,20 @@ namespace NCrystal {
       return crossSectionIsotropic(cp,ekin);
     }
 
+    inline void ScatterIsotropicMat::evalManyXS( CachePtr& cp, const double* ekin,
+                                                 const double*, const double*, const double*,
+                                                 std::size_t N, double* out_xs ) const
+    {
+      evalManyXSIsotropic(cp,ekin,N,out_xs);
+    }
+
+    inline void AbsorptionIsotropicMat::evalManyXS( CachePtr& cp, const double* ekin,
+                                                    const double*, const double*, const double*,
+                                                    std::size_t N, double* out_xs ) const
+    {
+      evalManyXSIsotropic(cp,ekin,N,out_xs);
+    }
+
     inline const ProcComposition::ComponentList& ProcComposition::components() const noexcept
     {
       return m_components;
@@ -32,6 +32,12 @@ namespace NCrystal {
   //Modify the RNG default streams used by NCrystal:
   NCRYSTAL_API void setDefaultRNG( shared_obj<RNGStream> );
   NCRYSTAL_API void setDefaultRNGFctForAllThreads( std::function<double()> );
+  //Same, but with a function filling an array with the requested number of
+  //random numbers at a time. Numbers are requested in batches of bufsize and
+  //served from a per-thread buffer (so fct must still be thread safe), which
+  //greatly reduces overhead if fct is expensive to call (e.g. in Python):
+  NCRYSTAL_API void setDefaultRNGBulkFctForAllThreads( std::function<void(double*,unsigned)> fct,
+                                                      unsigned bufsize = 1024 );
   NCRYSTAL_API void clearDefaultRNG();
 
   //For some applications it might be desirable to access the RNG streams
@@ -46,6 +52,25 @@ namespace NCrystal {
   NCRYSTAL_API shared_obj<RNGStream> createBuiltinRNG( uint64_t seed = 0 );
   NCRYSTAL_API shared_obj<RNGStream> createBuiltinRNG( const RNGStreamState& state );
 
+  //Alternative builtin RNG, running nlanes (4 or 8) interleaved copies of the
+  //builtin generator (each lane a jump ahead of the previous one) and
+  //generating numbers a block at a time in a form suitable for
+  //vectorisation. Results are reproducible given the seed, but differ from
+  //those of createBuiltinRNG. Streams are jump capable, and can therefore be
+  //used with RNGProducer:
+  NCRYSTAL_API shared_obj<RNGStream> createBuiltinMultiLaneRNG( unsigned nlanes, uint64_t seed = 0 );
+  NCRYSTAL_API shared_obj<RNGStream> createBuiltinMultiLaneRNG( const RNGStreamState& state );
+
+  //Counter-based RNG (Philox4x32-10), in which the numbers are fully
+  //determined by the seed, the stream index, and the position in the
+  //stream. Independent streams for different indices (which must have the
+  //highest bit clear) can thus be created directly by anyone in constant time
+  //and without any shared state. Jumping increments the stream index, and an
+  //RNGProducer based on such a stream creates the streams for produceByIdx
+  //directly in a separate index range (i.e. independently of the order of
+  //calls and of any other streams handed out):
+  NCRYSTAL_API shared_obj<RNGStream> createCounterBasedRNG( uint64_t seed = 0, RNGStreamIndex = RNGStreamIndex{0} );
+
   //Check whether a given RNG state is from the builtin RNG:
   NCRYSTAL_API bool stateIsFromBuiltinRNG(const RNGStreamState&);
 
@@ -80,6 +105,21 @@ namespace NCrystal {
     virtual bool isJumpCapable() const { return false; }
     virtual shared_obj<RNGStream> createJumped() const;
 
+    //Some RNG's (e.g. counter-based ones) can instead directly create the
+    //independent stream for a given index in constant time. If so, the
+    //RNGProducer::produceByIdx method will use this rather than jumping:
+    virtual bool isIndexCapable() const { return false; }
+    virtual shared_obj<RNGStream> createForIndex( RNGStreamIndex ) const;
+
+    //Some RNG's can cheaply derive a substream from the current state and a
+    //number (e.g. an event number), which can be used to get results which
+    //are reproducible regardless of the order in which events are processed
+    //(and of the number of threads or nodes involved). The substreams for
+    //different numbers are independent, and only depend on the state of the
+    //base stream (which is not modified):
+    virtual bool isSubstreamCapable() const { return false; }
+    virtual shared_obj<RNGStream> createSubstream( uint64_t ) const;
+
     //Override and return true if the same RNG stream should be used even if
     //objects are cloned for different threads (this supports wrapping of
     //global RNG sources which already takes care of concurrency by other
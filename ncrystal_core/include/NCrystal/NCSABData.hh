@@ -39,6 +39,9 @@ namespace NCrystal {
     AtomMass elementMassAMU() const { return m_m; }
     double suggestedEmax() const { return m_sem; }
 
+    //Memory usage (see MemoryFootprint in NCMem.hh):
+    void accountMemory( MemoryFootprint& ) const;
+
     //Constructors etc. (all expensive operations forbidden):
     SABData( VectD&& alphaGrid, VectD&& betaGrid, VectD&& sab,
              Temperature temperature, SigmaBound boundXS, AtomMass elementMassAMU,
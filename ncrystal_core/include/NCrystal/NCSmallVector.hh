@@ -24,6 +24,7 @@
 #include "NCrystal/NCDefs.hh"
 #include <initializer_list>
 #include <type_traits>
+#include <cstring>
 
 namespace NCrystal {
 
@@ -163,6 +164,10 @@ namespace NCrystal {
     TValue& emplace_back( Args&& ... );
     void resize( size_type );//requires TValue to have noexcept default constructor
     void resize( size_type, const TValue& value );//requires TValue to be noexcept copy constructible
+    //Like resize(n), but leaves any added elements uninitialised. Only
+    //available for trivial types, and intended for numerical buffers which
+    //will anyway be completely overwritten before being read:
+    void resize_uninitialized( size_type );
     void pop_back() noexcept;
     void clear() noexcept;
 
@@ -274,6 +279,24 @@ namespace NCrystal {
     static_assert(std::is_nothrow_move_constructible<TValue>::value,
                   "SmallVector can only keep objects with noexcept move-constructors.");
 
+    //Trivially copyable objects can be relocated to new storage with a plain
+    //memcpy (and need no destructor calls afterwards):
+    static constexpr bool trivial_relocate = std::is_trivially_copyable<TValue>::value;
+
+    static void relocate( TValue * src_begin, TValue * src_end, TValue * dest ) noexcept
+    {
+      //Move-construct [src_begin,src_end) into uninitialised memory at dest
+      //(the source objects must still be destructed by the caller):
+      if ( trivial_relocate ) {
+        if ( src_begin != src_end )
+          std::memcpy( (void*)dest, (const void*)src_begin,
+                       sizeof(TValue) * std::distance( src_begin, src_end ) );
+      } else {
+        for ( ; src_begin != src_end; ++src_begin )
+          new( (void*)(dest++) ) TValue( std::move( *src_begin ) );
+      }
+    }
+
     static constexpr bool large(const SmallVector* THIS) noexcept { return THIS->m_count > NSMALL; }
     static constexpr bool small(const SmallVector* THIS) noexcept { return THIS->m_count <= NSMALL; }
 
@@ -295,6 +318,19 @@ namespace NCrystal {
         ++m_end;//on line after TValue constructor (in case it throws)
         assert( m_end <= m_begin + m_capacity );
       }
+      void relocate_back( TValue * src_begin, TValue * src_end ) noexcept
+      {
+        //NB: calling code is responsible for ensuring adequate capacity.
+        Impl::relocate( src_begin, src_end, m_end );
+        m_end += std::distance( src_begin, src_end );
+        assert( m_end <= m_begin + m_capacity );
+      }
+      void grow_end( size_type n ) noexcept
+      {
+        //Adopt n objects already constructed at m_end.
+        m_end += n;
+        assert( m_end <= m_begin + m_capacity );
+      }
 
       ~DetachedHeap()
       {
@@ -342,8 +378,7 @@ namespace NCrystal {
       assert( large(THIS) );
       assert( n >= THIS->m_count );
       auto heap = createNewDetachedHeap(n);
-      for ( auto&& e : *THIS )
-        heap.emplace_back(std::move(e));
+      heap.relocate_back( THIS->begin(), THIS->end() );
       adoptHeap(THIS,heap);
     }
 
@@ -363,7 +398,7 @@ namespace NCrystal {
     {
       //Call destructors, release heap alloction (if any) and set count to
       //0. It is noexcept since destructors should not throw.
-      if ( THIS->m_count > 0 ) {
+      if ( !std::is_trivially_destructible<TValue>::value && THIS->m_count > 0 ) {
         auto it = THIS->begin();
         auto itE = THIS->end();
         for (;it!=itE;++it)
@@ -402,26 +437,21 @@ namespace NCrystal {
     static TValue& grow_and_emplace_back( SmallVector * THIS, Args&& ...args )
     {
       assert( THIS->m_count == THIS->capacity() );
-      //In this edge-case we actually construct the object here on the stack
-      //first, and then afterwards increase capacity and move it over. This is
-      //to make sure the SmallVector state is unchanged in case the constructor
-      //throws:
-      TValue newvalue(std::forward<Args>(args)...);
-      if ( THIS->m_count == NSMALL ) {
-        //Special case, moving from small to large buffer!
-        auto heap = createNewDetachedHeap( NSMALL*2 );//might throw bad_alloc
-        //Ok, done with everything that might throw, it is now safe to start
-        //modifying our state:
-        for ( auto&& e : *THIS )
-          heap.emplace_back(std::move(e));//noexcept move constructor
-        heap.emplace_back(std::move(newvalue));
-        TValue * last = std::prev(heap.end());
-        adoptHeap( THIS, heap );
-        return *last;
-      } else {
-        resizeLargeCapacity( THIS, THIS->m_count*2 );
-        return THIS->emplace_back(std::move(newvalue));
-      }
+      //The new object is constructed directly at its final place in the new
+      //heap storage, before the existing objects are relocated next to
+      //it. This makes sure the SmallVector state is unchanged in case the
+      //allocation or the constructor throws, and that args can safely refer
+      //to existing elements:
+      const size_type n = THIS->m_count;
+      auto heap = createNewDetachedHeap( n*2 );//might throw bad_alloc
+      TValue * newobjaddr = heap.begin() + n;
+      new( (void*)(newobjaddr) ) TValue(std::forward<Args>(args)...);//might throw
+      //Ok, done with everything that might throw, it is now safe to start
+      //modifying our state:
+      heap.relocate_back( THIS->begin(), THIS->end() );
+      heap.grow_end(1);
+      adoptHeap( THIS, heap );
+      return *newobjaddr;
     }
 
     template<typename ...Args>
@@ -458,9 +488,7 @@ namespace NCrystal {
       clear();
     if ( Impl::small(&o) ) {
       //Move values:
-      auto it = begin();
-      for ( auto&& e : o )
-        new(it++) TValue(std::move(e));
+      Impl::relocate( o.begin(), o.end(), begin() );
       m_count = o.m_count;
       o.clear();
       Impl::setBeginPtrSmallData(this);
@@ -756,8 +784,7 @@ namespace NCrystal {
     //relying on TValue to be is_nothrow_default_constructible):
     assert( n > NSMALL );
     auto heap = Impl::createNewDetachedHeap( n );
-    for ( auto&&e : *this )
-      heap.emplace_back(std::move(e));
+    heap.relocate_back( begin(), end() );
     for ( size_type i = m_count; i < n; ++i )
       heap.emplace_back();//TValue() is noexcept
     assert( (size_type)std::distance(heap.begin(),heap.end()) == n );
@@ -791,14 +818,34 @@ namespace NCrystal {
     //relying on TValue to be is_nothrow_copy_constructible):
     assert( n > NSMALL );
     auto heap = Impl::createNewDetachedHeap( n );
-    for ( auto&&e : *this )
-      heap.emplace_back(std::move(e));
+    heap.relocate_back( begin(), end() );
     for ( size_type i = m_count; i < n; ++i )
       heap.emplace_back(val_to_copy);//TValue(val_to_copy) is noexcept
     assert( (size_type)std::distance(heap.begin(),heap.end()) == n );
     Impl::adoptHeap(this,heap);
   }
 
+  template<class TValue, std::size_t NSMALL, SVMode MODE>
+  inline void SmallVector<TValue,NSMALL,MODE>::resize_uninitialized( size_type n )
+  {
+    static_assert(std::is_trivially_default_constructible<TValue>::value
+                  && std::is_trivially_copyable<TValue>::value,
+                  "Usage of SmallVector::resize_uninitialized requires objects to be trivial.");
+    if ( m_count >= n ) {
+      Impl::resizeDown( this, n );
+      return;
+    }
+    if ( n <= capacity() ) {
+      m_count = n;
+      return;
+    }
+    assert( n > NSMALL );
+    auto heap = Impl::createNewDetachedHeap( n );
+    heap.relocate_back( begin(), end() );
+    heap.grow_end( n - m_count );
+    Impl::adoptHeap(this,heap);
+  }
+
   template<class TValue, std::size_t NSMALL, SVMode MODE>
   inline void SmallVector<TValue,NSMALL,MODE>::pop_back() noexcept
   {
@@ -54,16 +54,24 @@ namespace NCrystal {
   public:
     //Low-level string data object which does not have any sort of meta-data. Is
     //cheap to copy around and should not have any life-time issues, since it
-    //internally wraps either a long-lived const char pointer or a
-    //shared_obj<std::string> object. The data is always contiguous and
+    //internally wraps either a long-lived const char pointer, a
+    //shared_obj<std::string> object, or data in some other storage kept alive
+    //by a shared pointer (e.g. a memory mapped file, allowing data to be used
+    //without copying it to the heap). The data is always contiguous and
     //null-terminated (thus can only store data with null-free encodings like
-    //ASCII or UTF-8). Constructors taking std::string also optionally takes a
+    //ASCII or UTF-8 - the only exception being data in the binary NCMAT format
+    //which is recognised by its magic bytes). Constructors taking std::string also optionally takes a
     //srcdescr parameter which is used for more meaningful error messages in
     //case of unsupported encodings.
     struct static_data_ptr_t {};
     RawStrData( static_data_ptr_t, const char * ) noexcept;
     RawStrData( std::string&&, const char * srcdescr = nullptr );
     RawStrData( shared_obj<std::string>, const char * srcdescr = nullptr );
+    //External storage (*dataEnd must be a null char which is also kept alive):
+    struct external_storage_t {};
+    RawStrData( external_storage_t, std::shared_ptr<const void> storage,
+                const char * dataBegin, const char * dataEnd,
+                const char * srcdescr = nullptr );
 
     RawStrData( const RawStrData& ) = default;
     RawStrData( RawStrData&& ) = default;
@@ -86,7 +94,8 @@ namespace NCrystal {
 
   private:
     const char *m_b, *m_e;
-    optional_shared_obj<std::string> m_s;
+    std::shared_ptr<const void> m_storage;
+    void validateNoNullChars( const char * srcdescr ) const;
   };
 
   class NCRYSTAL_API TextData : private MoveOnly {
@@ -122,6 +131,13 @@ namespace NCrystal {
     Iterator cbegin() const { return begin(); }
     Iterator cend() const { return end(); }
 
+    //Optional index of line offsets, providing random access to lines (for
+    //instance to let parsers split the data into chunks which can be
+    //processed independently). Construct it when needed with
+    //TextData::LineIndex(textdata). Building it requires a single
+    //memchr-based pass over the data:
+    class LineIndex;
+
     //Raw access to underlying data:
     const RawStrData& rawData() const noexcept;
 
@@ -166,6 +182,13 @@ namespace NCrystal {
     //identical:
     bool hasIdenticalMetaData( const TextData& ) const noexcept;
 
+    //Let this object share the UID of another object, which must have the
+    //same data type and byte-wise identical raw data (throws BadInput if
+    //not). This is intended for content-based deduplication in the factories
+    //(see FactImpl::setTextDataDeduplicationEnabled), and should only be done
+    //before the object is made available to any other code:
+    void adoptDataUID( const TextData& );
+
     //Full iterator declaration and internals:
     class Iterator {
     public:
@@ -179,12 +202,16 @@ namespace NCrystal {
       ncconstexpr17 bool operator==(const Iterator&) const noexcept;
       ncconstexpr17 bool operator!=(const Iterator&) const noexcept;
       ncconstexpr17 bool operator<(const Iterator&) const noexcept;
+      //Position of the current line in the raw data (for advanced usage, like
+      //parsers wishing to revisit a range of lines later):
+      ncconstexpr17 const char * rawLineBegin() const noexcept;
       Iterator( const Iterator& );
       Iterator& operator=( const Iterator& );
       Iterator( Iterator&& );
       Iterator& operator=( Iterator&& );
     private:
       friend class TextData;
+      friend class LineIndex;
       Iterator(const char *);
       struct is_end_t{};
       Iterator(const char *, is_end_t );
@@ -201,6 +228,41 @@ namespace NCrystal {
     TextDataUID m_uid;
   };
 
+  class NCRYSTAL_API TextData::LineIndex {
+  public:
+    //Lines are defined exactly as when iterating over the TextData object,
+    //and the same errors are produced for unsupported line endings. For
+    //binary NCMAT data, only the lines of the text preamble are indexed. The
+    //LineIndex keeps the underlying raw data alive:
+    LineIndex( const TextData& );
+
+    //Number of lines:
+    std::size_t size() const noexcept { return m_starts.size() - 1; }
+    bool empty() const noexcept { return size() == 0; }
+
+    //Raw character range of line i (without newline characters):
+    const char * lineBegin( std::size_t i ) const noexcept;
+    const char * lineEnd( std::size_t i ) const noexcept;
+    std::string line( std::size_t i ) const;
+
+    //Iterator positioned at line i (i==size() gives an end iterator). The
+    //lines [i,j) can then be visited as "for (auto it = idx.iteratorAt(i),
+    //itE = idx.iteratorAt(j); it != itE; ++it)":
+    Iterator iteratorAt( std::size_t i ) const;
+
+    //Split the lines into (at most) nchunks contiguous ranges with roughly
+    //equal amounts of raw data. Returns the line index boundaries, which
+    //always start with 0 and end with size():
+    std::vector<std::size_t> chunkBoundaries( std::size_t nchunks ) const;
+
+  private:
+    RawStrData m_data;
+    //Offsets of the line starts, followed by a sentinel value which is the
+    //offset where a following line would have started:
+    std::vector<std::size_t> m_starts;
+    std::size_t m_nchars = 0;//offset of the null char ending the indexed data
+  };
+
   std::ostream& operator<< ( std::ostream& , const TextData& );
 }
 
@@ -280,9 +342,13 @@ namespace NCrystal {
 
   inline ncconstexpr17 const TextData::Iterator::value_type* TextData::Iterator::operator->() const noexcept { return &m_buf; }
   inline ncconstexpr17 const TextData::Iterator::value_type& TextData::Iterator::operator*() const noexcept { return m_buf; }
-  inline ncconstexpr17 bool TextData::Iterator::operator==(const Iterator& o) const noexcept { return m_data == o.m_data; }
-  inline ncconstexpr17 bool TextData::Iterator::operator!=(const Iterator& o) const noexcept { return m_data != o.m_data; }
+  //Any iterator positioned at a null char is an end iterator (normally there is
+  //only one, at the end of the data, but binary NCMAT data has one directly
+  //after its text preamble):
+  inline ncconstexpr17 bool TextData::Iterator::operator==(const Iterator& o) const noexcept { return m_data == o.m_data || ( *m_data == '\0' && *o.m_data == '\0' ); }
+  inline ncconstexpr17 bool TextData::Iterator::operator!=(const Iterator& o) const noexcept { return !( *this == o ); }
   inline ncconstexpr17 bool TextData::Iterator::operator<(const Iterator& o) const noexcept { return m_data < o.m_data; }
+  inline ncconstexpr17 const char * TextData::Iterator::rawLineBegin() const noexcept { return m_data; }
 
   inline TextData::Iterator::Iterator( const Iterator& o )
   {
@@ -305,6 +305,35 @@ namespace NCrystal {
     CosineScatAngle mu;
   };
 
+  //Window of accepted outcomes for biased scattering sampling (see
+  //ProcImpl::Process::sampleScatterBiased). Outcomes are inside the window if
+  //the cosine of the scattering angle is in [mu_min,mu_max] and the final
+  //neutron energy is in [ekin_min,ekin_max]. Generic implementations estimate
+  //weights from ntrials unbiased scatterings:
+  struct NCRYSTAL_API ScatterWindow {
+    double mu_min = -1.0;
+    double mu_max = 1.0;
+    NeutronEnergy ekin_min = NeutronEnergy{ 0.0 };
+    NeutronEnergy ekin_max = NeutronEnergy{ kInfinity };
+    unsigned ntrials = 100;
+    bool contains( NeutronEnergy ekin, double mu ) const noexcept
+    {
+      return mu >= mu_min && mu <= mu_max
+        && ekin.dbl() >= ekin_min.dbl() && ekin.dbl() <= ekin_max.dbl();
+    }
+  };
+
+  //Outcomes of biased scattering sampling, with statistical weights:
+  struct NCRYSTAL_API BiasedScatterOutcome {
+    ScatterOutcome outcome;
+    double weight;
+  };
+
+  struct NCRYSTAL_API BiasedScatterOutcomeIsotropic {
+    ScatterOutcomeIsotropic outcome;
+    double weight;
+  };
+
   //Index identifying RNG streams:
   class NCRYSTAL_API RNGStreamIndex final : public EncapsulatedValue<RNGStreamIndex,uint64_t> {
   public:
@@ -41,6 +41,9 @@ namespace NCrystal {
 
     std::shared_ptr<Process> createMerged( const Process& ) const override;
 
+    //Constant c in xs=c/sqrt(ekin), allowing client code to inline the model:
+    double oovConstant() const noexcept { return m_c; }
+
   private:
     double m_c;
   };
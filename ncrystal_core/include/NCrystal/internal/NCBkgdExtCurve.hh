@@ -33,18 +33,61 @@ namespace NCrystal {
     //external functions for calculating cross-sections, using the XSectProvider
     //section in the passed Info object. Scatterings will be elastic and
     //isotropic.
+    //
+    //As the external functions can be expensive, the cross section curve is
+    //tabulated at construction time on a uniform grid in log(energy) covering
+    //1e-5eV to 10eV, with linear interpolation between grid points. The grid
+    //density is doubled until interpolated values at all interval midpoints
+    //agree with exact evaluations within the relative precision tableprec
+    //(using at most 4096 points per decade). Any intervals still failing
+    //that check (e.g. due to discontinuities), as well as energies outside the
+    //table, are handled by exact evaluations. A tableprec value of 0 disables
+    //the tabulation entirely.
 
     const char * name() const noexcept final { return "BkgdExtCurve"; }
 
-    BkgdExtCurve( shared_obj<const Info> );
+    BkgdExtCurve( shared_obj<const Info>, double tableprec = 1e-6 );
     virtual ~BkgdExtCurve();
 
-    CrossSect crossSectionIsotropic(CachePtr&, NeutronEnergy ) const final;
+    CrossSect crossSectionIsotropic(CachePtr&, NeutronEnergy ekin ) const final
+    {
+      return ( m_table.covers( ekin.dbl() )
+               ? CrossSect{ m_table.lookup( ekin.dbl(), *m_ci ) }
+               : m_ci->xsectScatNonBragg(ekin) );
+    }
+    void evalManyXSIsotropic( CachePtr&, const double* ekin, std::size_t N,
+                              double* out_xs ) const final;
     ScatterOutcomeIsotropic sampleScatterIsotropic(CachePtr&, RNG&, NeutronEnergy ) const final;
     ScatterOutcome sampleScatter(CachePtr&, RNG&, NeutronEnergy, const NeutronDirection& ) const final;
+    void sampleScatterMany( CachePtr&, RNG&, double* ekin,
+                            double* ux, double* uy, double* uz,
+                            std::size_t N ) const final;
 
   protected:
     shared_obj<const Info> m_ci;
+
+  private:
+    class Table {
+    public:
+      void init( const Info&, double precision );
+      bool covers( double ekin ) const noexcept { return ekin >= m_emin && ekin <= m_emax; }
+      double lookup( double ekin, const Info& info ) const
+      {
+        const double x = ( std::log( ekin ) - m_logemin ) * m_invdloge;
+        const std::size_t i = std::min<std::size_t>( static_cast<std::size_t>( x > 0.0 ? x : 0.0 ),
+                                                     m_xs.size() - 2 );
+        if ( !m_exact.empty() && m_exact[i] )
+          return info.xsectScatNonBragg( NeutronEnergy{ ekin } ).dbl();
+        const double t = x - i;
+        return m_xs[i] + t * ( m_xs[i+1] - m_xs[i] );
+      }
+    private:
+      //Default values ensure that covers(..) is always false when disabled:
+      double m_emin = 1.0, m_emax = 0.0, m_logemin = 0.0, m_invdloge = 0.0;
+      VectD m_xs;
+      std::vector<char> m_exact;//empty or flags for intervals needing exact evaluation
+    };
+    Table m_table;
   };
 }
 
@@ -0,0 +1,146 @@
+#ifndef NCrystal_CPUDispatch_hh
+#define NCrystal_CPUDispatch_hh
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+//  This file is part of NCrystal (see https://mctools.github.io/ncrystal/)   //
+//                                                                            //
+//  Copyright 2015-2021 NCrystal developers                                   //
+//                                                                            //
+//  Licensed under the Apache License, Version 2.0 (the "License");           //
+//  you may not use this file except in compliance with the License.          //
+//  You may obtain a copy of the License at                                   //
+//                                                                            //
+//      http://www.apache.org/licenses/LICENSE-2.0                            //
+//                                                                            //
+//  Unless required by applicable law or agreed to in writing, software       //
+//  distributed under the License is distributed on an "AS IS" BASIS,         //
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  //
+//  See the License for the specific language governing permissions and       //
+//  limitations under the License.                                            //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include "NCrystal/NCDefs.hh"
+
+//Runtime selection of vector kernels. The same binary can run on machines
+//with different instruction sets, so rather than relying on -march flags at
+//build time, elementwise kernels are compiled several times (with the
+//compiler's target attribute) and the best version supported by the CPU is
+//picked on first use. Kernels are plain loops written to be vectorised by the
+//compiler, and the versions only differ in the instructions available to
+//it. Floating point contraction (FMA) must be disabled in translation units
+//defining such kernels, so all versions give identical results.
+//
+//The environment variable NCRYSTAL_SIMD can be set to "scalar", "baseline",
+//"avx2" or "avx512" to cap the level used (levels not supported by the CPU
+//are never used). The "scalar" level evaluates the kernels one element at a
+//time with no vectorisation, and is intended as a reference for validation.
+
+#if ( defined(__GNUC__) || defined(__clang__) ) && ( defined(__x86_64__) || defined(__i386__) ) && !defined(NCRYSTAL_DISABLE_CPUDISPATCH)
+#  define NCRYSTAL_HAS_CPUDISPATCH
+#  define NCRYSTAL_TARGET_AVX2 __attribute__((target("avx2")))
+#  define NCRYSTAL_TARGET_AVX512 __attribute__((target("avx2,avx512f,avx512dq")))
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#  define NCRYSTAL_KERNEL_INLINE inline __attribute__((always_inline))
+#  define NCRYSTAL_KERNEL_NOINLINE __attribute__((noinline))
+#else
+#  define NCRYSTAL_KERNEL_INLINE inline
+#  define NCRYSTAL_KERNEL_NOINLINE
+#endif
+
+namespace NCrystal {
+
+  namespace CPUDispatch {
+
+    enum class ISA { Scalar, Baseline, AVX2, AVX512 };
+
+    //Level in use (highest supported by CPU and build, capped by NCRYSTAL_SIMD):
+    ISA activeISA();
+
+    //Highest level supported by CPU and build (ignoring NCRYSTAL_SIMD):
+    ISA detectedISA();
+
+    const char * isaName( ISA );
+
+    //Elementwise kernels map an input array to one or two output arrays. A
+    //kernel is a class with a static function:
+    //
+    //  NCRYSTAL_KERNEL_INLINE static void eval( const double* x, double* out_a,
+    //                                           double* out_b, std::size_t i );
+    //
+    //evaluating entry i (out_b is nullptr for kernels with a single output).
+    //The function returned by selectKernel<TKernel>() evaluates it for
+    //entries [0,n) using the version for activeISA(). It should be stored in
+    //a static variable by the caller, so the selection happens only once:
+    using KernelFct = void(*)( const double* x, double* out_a, double* out_b, std::size_t n );
+    template<class TKernel>
+    KernelFct selectKernel();
+
+  }
+
+}
+
+////////////////////////////
+// Inline implementations //
+////////////////////////////
+
+namespace NCrystal {
+  namespace CPUDispatch {
+    namespace detail {
+      template<class TKernel>
+      NCRYSTAL_KERNEL_NOINLINE void evalOne( const double* x, double* a, double* b, std::size_t i )
+      {
+        TKernel::eval( x, a, b, i );
+      }
+      template<class TKernel>
+      void runScalar( const double* x, double* a, double* b, std::size_t n )
+      {
+        //Out-of-line call per entry prevents the compiler from vectorising:
+        for ( std::size_t i = 0; i < n; ++i )
+          evalOne<TKernel>( x, a, b, i );
+      }
+      template<class TKernel>
+      void runBaseline( const double* x, double* a, double* b, std::size_t n )
+      {
+        for ( std::size_t i = 0; i < n; ++i )
+          TKernel::eval( x, a, b, i );
+      }
+#ifdef NCRYSTAL_HAS_CPUDISPATCH
+      template<class TKernel>
+      NCRYSTAL_TARGET_AVX2 void runAVX2( const double* x, double* a, double* b, std::size_t n )
+      {
+        for ( std::size_t i = 0; i < n; ++i )
+          TKernel::eval( x, a, b, i );
+      }
+      template<class TKernel>
+      NCRYSTAL_TARGET_AVX512 void runAVX512( const double* x, double* a, double* b, std::size_t n )
+      {
+        for ( std::size_t i = 0; i < n; ++i )
+          TKernel::eval( x, a, b, i );
+      }
+#endif
+    }
+  }
+}
+
+template<class TKernel>
+inline NCrystal::CPUDispatch::KernelFct NCrystal::CPUDispatch::selectKernel()
+{
+  switch ( activeISA() ) {
+  case ISA::Scalar:
+    return &detail::runScalar<TKernel>;
+#ifdef NCRYSTAL_HAS_CPUDISPATCH
+  case ISA::AVX2:
+    return &detail::runAVX2<TKernel>;
+  case ISA::AVX512:
+    return &detail::runAVX512<TKernel>;
+#endif
+  default:
+    return &detail::runBaseline<TKernel>;
+  }
+}
+
+#endif
@@ -0,0 +1,97 @@
+#ifndef NCrystal_Counters_hh
+#define NCrystal_Counters_hh
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+//  This file is part of NCrystal (see https://mctools.github.io/ncrystal/)   //
+//                                                                            //
+//  Copyright 2015-2021 NCrystal developers                                   //
+//                                                                            //
+//  Licensed under the Apache License, Version 2.0 (the "License");           //
+//  you may not use this file except in compliance with the License.          //
+//  You may obtain a copy of the License at                                   //
+//                                                                            //
+//      http://www.apache.org/licenses/LICENSE-2.0                            //
+//                                                                            //
+//  Unless required by applicable law or agreed to in writing, software       //
+//  distributed under the License is distributed on an "AS IS" BASIS,         //
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  //
+//  See the License for the specific language governing permissions and       //
+//  limitations under the License.                                            //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include "NCrystal/NCDefs.hh"
+#ifdef NCRYSTAL_ENABLE_COUNTERS
+#  include <atomic>
+#endif
+
+namespace NCrystal {
+
+  //Optional instrumentation of the hot paths of the physics models. When
+  //NCrystal is built with NCRYSTAL_ENABLE_COUNTERS defined (ENABLE_COUNTERS=ON
+  //in CMake), a global (process-wide, shared between all threads) counter is
+  //incremented at each of the points listed below. Otherwise the NCRYSTAL_COUNT
+  //macros expand to nothing and the counters always read as zero. The counters
+  //help selecting which configuration parameters to tune for speed:
+  //
+  //  proccomp_cache_hit/miss : ProcComposition cross section cache (e.g. many
+  //                            misses for repeated calls indicates that
+  //                            neutron states are not reused).
+  //  scbragg_cache_hit/miss  : SCBragg per-state cache (cf. dirtol).
+  //  lcbragg_cache_hit/miss  : LCHelper per-state cache (cf. lcmode).
+  //  gos_circleint_slow      : GaussOnSphere circle integrals not given by the
+  //                            closed-form approximation, and the number of
+  //  gos_circleint_numint      those not found in the tables either, which
+  //                            needed full numerical integration (cf. mosprec).
+  //  sab_alg1_samples        : (alpha,beta) sampling with SABSamplerAtE_Alg1,
+  //  sab_alg1_iterations       and the number of rejection loop iterations
+  //                            needed (cf. vdoslux).
+  //  rng_draws               : Values drawn from builtin RNG streams (divide by
+  //                            the number of sampling calls made for the number
+  //                            of draws per event).
+  //  adaptxs_learn           : Cross section evaluations observed by
+  //  adaptxs_table             AdaptiveTabulatedXS while learning, and those
+  //                            served by its table afterwards (cf. nlearn).
+
+  namespace Counters {
+
+    enum class Id : unsigned {
+      ProcCompCacheHit, ProcCompCacheMiss,
+      SCBraggCacheHit, SCBraggCacheMiss,
+      LCBraggCacheHit, LCBraggCacheMiss,
+      GOSCircleIntSlow, GOSCircleIntNumInt,
+      SABAlg1Samples, SABAlg1Iterations,
+      RNGDraws,
+      AdaptXSLearn, AdaptXSTable,
+      N //number of counters, must be last
+    };
+
+    //Whether NCrystal was built with NCRYSTAL_ENABLE_COUNTERS:
+    bool enabled() noexcept;
+    const char * name( Id );
+
+    //Access all counters (as name,value pairs), or reset them to zero:
+    std::vector<std::pair<std::string,uint64_t>> getAll();
+    void resetAll();
+
+#ifdef NCRYSTAL_ENABLE_COUNTERS
+    namespace detail {
+      extern std::atomic<uint64_t> s_counters[static_cast<unsigned>(Id::N)];
+    }
+    inline void add( Id id, uint64_t n )
+    {
+      detail::s_counters[static_cast<unsigned>(id)].fetch_add( n, std::memory_order_relaxed );
+    }
+#endif
+  }
+}
+
+#ifdef NCRYSTAL_ENABLE_COUNTERS
+#  define NCRYSTAL_COUNT_N(id,n) ::NCrystal::Counters::add( ::NCrystal::Counters::Id::id, (n) )
+#else
+#  define NCRYSTAL_COUNT_N(id,n) do {} while(0)
+#endif
+#define NCRYSTAL_COUNT(id) NCRYSTAL_COUNT_N(id,1)
+
+#endif
@@ -33,18 +33,50 @@ namespace NCrystal {
   //NCMatCfg.hh, and only affects VDOS-based scattering kernels. For the special
   //case of VDOSDebye based kernels, the vdoslux parameter will be reduced by 3
   //(but not less than 0), to prevent wasting resources on what is anyway rather
-  //crude input.
+  //crude input. Likewise, the vdosthintol parameter (also described in
+  //NCMatCfg.hh) only affects kernels expanded from a VDOS.
   //
   //Unless useCache=false is set, a MT-safe caching mechanism will be employed
   //behind the scene in order to prevent duplication of work in case of repeated
   //calls. The cache can obviously be cleared with the
   //clearSABDataFromDynInfoCaches function (automatically invoked by the global
   //clearCaches function):
-  std::shared_ptr<const SABData> extractSABDataFromDynInfo( const DI_ScatKnl*, unsigned vdoslux = 3, bool useCache = true );
+  std::shared_ptr<const SABData> extractSABDataFromDynInfo( const DI_ScatKnl*, unsigned vdoslux = 3, bool useCache = true,
+                                                            double vdosthintol = 0.0 );
   std::shared_ptr<const SABData> extractSABDataFromVDOSDebyeModel( DebyeTemperature, Temperature, SigmaBound, AtomMass,
-                                                                   unsigned vdoslux = 3, bool useCache = true );
+                                                                   unsigned vdoslux = 3, bool useCache = true,
+                                                                   double vdosthintol = 0.0 );
   void clearSABDataFromDynInfoCaches();
 
+  //Access SABData from a DynInfo object, but for a different temperature than
+  //the one of the DynInfo object (only VDOS and VDOSDebye based kernels can be
+  //evaluated at other temperatures, directly specified kernels results in a
+  //BadInput exception). With useCache=true, the cache used for VDOS based
+  //kernels is keyed on the actual content of the VDOS rather than on the
+  //DynInfo object, so the resulting SABData objects can be shared between all
+  //Info objects with identical VDOS data:
+  std::shared_ptr<const SABData> extractSABDataFromDynInfoAtTemperature( const DI_ScatKnl*, Temperature,
+                                                                         unsigned vdoslux = 3,
+                                                                         bool useCache = true,
+                                                                         double vdosthintol = 0.0 );
+
+  //Multi-temperature version of extractSABDataFromDynInfo, intended for
+  //temperature scans. Rather than loading the material at each temperature,
+  //the regularised VDOS (and any requested energy range) of the provided
+  //DI_VDOS object is reused for all temperatures, and the per-temperature
+  //expansions are carried out in parallel (using NCRYSTAL_NTHREADS
+  //threads). Results are returned in the order of the temperatures, and are
+  //identical to those obtained from extractSABDataFromDynInfo with DI_VDOS
+  //objects loaded at each temperature. DI_VDOSDebye objects are likewise
+  //supported, while directly specified kernels (which are fixed at a single
+  //temperature) results in a BadInput exception. Caching (if enabled) is
+  //carried out as in extractSABDataFromDynInfoAtTemperature:
+  std::vector<std::shared_ptr<const SABData>> extractSABDataFromDynInfoAtTemperatures( const DI_ScatKnl*,
+                                                                                      const std::vector<Temperature>&,
+                                                                                      unsigned vdoslux = 3,
+                                                                                      bool useCache = true,
+                                                                                      double vdosthintol = 0.0 );
+
   //Idealised VDOS based only on Debye temperature:
   VDOSData createVDOSDebye( DebyeTemperature, Temperature, SigmaBound, AtomMass);
 }
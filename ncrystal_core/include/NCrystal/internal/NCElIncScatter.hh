@@ -61,6 +61,11 @@ namespace NCrystal {
 
     CrossSect crossSectionIsotropic(CachePtr&, NeutronEnergy ) const final;
     ScatterOutcomeIsotropic sampleScatterIsotropic(CachePtr&, RNG&, NeutronEnergy ) const final;
+    CrossSect majorantCrossSection( EnergyDomain ) const final;
+    void evalManyXSIsotropic( CachePtr&, const double* ekin, std::size_t N,
+                              double* out_xs ) const final;
+    void sampleScatterIsotropicMany( CachePtr&, RNG&, double* ekin, std::size_t N,
+                                     double* out_mu ) const final;
 
     //Simple additive merge:
     std::shared_ptr<Process> createMerged( const Process& ) const override;
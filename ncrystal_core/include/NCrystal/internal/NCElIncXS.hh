@@ -23,6 +23,7 @@
 
 #include "NCrystal/NCTypes.hh"
 #include "NCrystal/NCSmallVector.hh"
+#include "NCrystal/internal/NCSpline.hh"
 
 namespace NCrystal {
 
@@ -41,6 +42,11 @@ namespace NCrystal {
     //typically 1.0 in mono-atomic systems and otherwise represents the fraction
     //of elements (by count). E.g. for sapphire (Al2O3), Al should be added with
     //a scale of 0.4 and O with a fraction of 0.6.
+    //
+    //For polyatomic systems with several elements, a table of the total cross
+    //section versus log(energy) is precomputed (see below), so evaluate(..)
+    //does not need to loop over all elements, and sampleMu(..) can select the
+    //element without evaluating the contributions of all of them.
 
     ElIncXS( const VectD& elements_meanSqDisp,
              const VectD& elements_boundincohxs,
@@ -66,6 +72,9 @@ namespace NCrystal {
     static double evaluateMonoAtomic( NeutronEnergy, double meanSqDisp, SigmaBound bound_incoh_xs);
     double evaluate(NeutronEnergy ekin) const;
 
+    //Evaluate for N energies at once:
+    void evaluateMany( const double* ekin, std::size_t N, double* out_xs ) const;
+
     //Sample cosine of scatter angle:
     static double sampleMuMonoAtomic( RNG&, NeutronEnergy, double meanSqDisp );
     double sampleMu( RNG&, NeutronEnergy );
@@ -110,10 +119,44 @@ namespace NCrystal {
     //
     ////////////////////////////////////////////////////////////////////////////////////
 
+    ////////////////////////////////////////////////////////////////////////////////////
+    //
+    // Tabulation for polyatomic systems:
+    //
+    // Using units where t_i = msd_i * e for element i, the total cross section
+    // is XStot(e) = sum_i c_i * (1-exp(-t_i))/t_i, with c_i=sigma_inc_i*scale_i.
+    // Below e_low = 0.01/max(msd_i), all t_i are small and XStot is simply a
+    // third order polynomial in e, with coefficients given by the moments
+    // sum_i c_i msd_i^k. Above e_high = 24/min(msd_i), all terms are c_i/t_i
+    // and XStot = (sum_i c_i/msd_i)/e.  In between, XStot is tabulated on a
+    // uniform grid in log(e) and interpolated with a cubic spline (relative
+    // precision better than 1e-8).
+    //
+    // For sampling, the per-element contributions are tabulated at the grid
+    // points as well. Since each of them decreases with e, the values at the
+    // grid point just below e can be used as majorants: An element is selected
+    // according to those, and accepted with the probability given by the ratio
+    // of its actual contribution at e to the tabulated one (typically >98%).
+    // The resulting element selection is thus exact.
+    //
+    ////////////////////////////////////////////////////////////////////////////////////
+
   private:
     SmallVector<PairDD,16> m_elm_data;//for exact eval, (msd,boundincohxs*scale)
     static double eval_1mexpmtdivt(double t);//safe/fast eval of (1-exp(-t))/t for t>=0.0 with >10 sign. digits
 
+    struct Table {
+      double elow = 0.0, ehigh = 0.0, logelow = 0.0, invdloge = 0.0;
+      double lowcoeffs[4] = {0.0,0.0,0.0,0.0};//polynomial coefficients for e<elow
+      double highcoeff = 0.0;//XStot = highcoeff / e for e>ehigh
+      unsigned npts = 0;
+      SplinedLookupTable xs;//XStot as a function of log(e), for e in [elow,ehigh]
+      VectD selweights;//(npts+2)*nelem commulative weights, see initTable()
+    };
+    std::shared_ptr<const Table> m_table;//only for polyatomic systems
+    void initTable();
+    double sampleElementMSD( RNG&, double e ) const;
+
   };
 }
 
@@ -56,34 +56,21 @@ namespace NCrystal {
       bool operator<(const HKL&o) const {
         return ( h!=o.h ? h<o.h : ( k!=o.k ? k<o.k : l<o.l ) );
       }
+      bool operator==(const HKL&o) const { return h==o.h && k==o.k && l==o.l; }
     };
 
-    const std::set<HKL>& getEquivalentReflections(int h, int k, int l);
+    //Returns one (h,k,l) index for each pair of equivalent demi-normals (of
+    //(h,k,l) and (-h,-k,-l), the one comparing larger is used), sorted
+    //according to HKL::operator<. The returned reference is only valid until
+    //the next call:
+    const std::vector<HKL>& getEquivalentReflections(int h, int k, int l);
 
   private:
-    void calc_Triclinic_1_2(int,int,int);
-    void calc_Monoclinic_3_15(int,int,int);
-    void calc_Orthorhombic_16_74(int,int,int);
-    void calc_Tetragonal_75_88(int,int,int);
-    void calc_Tetragonal_89_142(int,int,int);
-    void calc_Trigonal_143_148(int,int,int);
-    void calc_Trigonal_149_167(int,int,int);
-    void calc_Hexagonal_168_176(int,int,int);
-    void calc_Hexagonal_177_194(int,int,int);
-    void calc_Cubic_195_206(int,int,int);
-    void calc_Cubic_207_230(int,int,int);
-
-    void add(int h,int k,int l) {
-      HKL a(h,k,l);
-      HKL am(-h,-k,-l);
-      //only insert one deminormal, not both am and a:
-      if (!m_planes.count(a)&&!m_planes.count(am))
-        m_planes.insert(am<a?a:am);
-    }
-
-    std::set<HKL> m_planes;
-    void (EqRefl::*m_calc) (int,int,int);
-
+    //Table-driven: Symmetry operations of the Laue class of the space group,
+    //as integer matrices acting on (h,k,l) (see NCEqRefl.cc):
+    const int (*m_ops)[3][3];
+    std::size_t m_nops;
+    std::vector<HKL> m_planes;
   };
 
 
@@ -22,8 +22,10 @@
 ////////////////////////////////////////////////////////////////////////////////
 
 #include "NCrystal/NCDefs.hh"
+#include "NCrystal/internal/NCTrace.hh"
 #include <chrono>
 #include <iostream>
+#include <condition_variable>
 #ifndef NCRYSTAL_DISABLE_THREADS
 #  include <thread>
 #endif
@@ -32,6 +34,18 @@ namespace NCrystal {
 
   constexpr unsigned CachedFactory_KeepAllStrongRefs = std::numeric_limits<unsigned>::max();
 
+  struct FactoryCacheStats {
+    //Instrumentation of a given cache (see getAllFactoryCacheStats below):
+    std::string name;
+    std::size_t nstrongrefs = 0;//objects kept alive by the cache (incl. under memory budget)
+    std::size_t nentries = 0;//cache entries (objects which might still be alive)
+    std::size_t nbytes = 0;//approximate size of objects still alive (0 if unknown)
+    std::size_t ninflight = 0;//objects currently under construction
+    uint64_t nhits = 0;//requests served by an existing (or concurrently built) object
+    uint64_t nmisses = 0;//requests resulting in construction of a new object
+    double constructionTime = 0.0;//total wall time in seconds spent constructing
+  };
+
   template<class TKey>
   struct CFB_Unthinned_t {
     //Default key thinning strategy is to not actually do any thinning. If
@@ -40,6 +54,10 @@ namespace NCrystal {
     //thinning again and again).
     using key_type = TKey;
     using thinned_key_type = TKey;
+    //Type of map used for the cache (key strategies can select e.g. a hash map
+    //instead):
+    template <class TMapped>
+    using map_type = std::map<thinned_key_type,TMapped>;
     template <class TMap>
     static typename TMap::mapped_type& cacheMapLookup( TMap& map, const key_type& key, Optional<thinned_key_type>& )
     {
@@ -66,6 +84,12 @@ namespace NCrystal {
     // kept alive and won't have to be recreated later). Strong refs are kept to
     // the last NStrongRefsKept objects accessed.
     //
+    // Alternatively, if a global memory budget is configured (see
+    // setFactoryCacheMemoryBudget below), strong refs to objects for which the
+    // factory implements approxMemoryUsage are instead kept in a global LRU
+    // list shared by all factories, and the least recently accessed objects are
+    // released whenever their combined size exceeds the budget.
+    //
     // The strong refs and any dangling weak refs can be cleaned up by an explicit
     // call to the cleanup function of a particular factory, or simply by calling the
     // global clearCaches function which will in turn call the cleanup function of
@@ -89,24 +113,48 @@ namespace NCrystal {
     //automatically registered with and invoked by global clearCaches function):
     void cleanup();
 
-    struct Stats { std::size_t nstrongrefs, nweakrefs; };
+    //Targeted cleanup, only releasing entries for which pred(thinned_key)
+    //returns true:
+    template<class TPred>
+    void cleanupIf( TPred pred );
+
+    //Number of strong and weak refs currently kept. Strong refs kept under the
+    //global memory budget are counted separately, along with their approximate
+    //size in bytes:
+    struct Stats { std::size_t nstrongrefs, nweakrefs, nbudgetedrefs, nbudgetedbytes; };
     Stats currentStats();
 
+    //Full instrumentation (this is what getAllFactoryCacheStats reports):
+    FactoryCacheStats fullStats();
+
   protected:
     virtual ShPtr actualCreate(const key_type&) const = 0;
+
+    //Approximate memory footprint of created objects in bytes. Return 0 (the
+    //default) if unknown, in which case the object will never be accounted
+    //against the global memory budget:
+    virtual std::size_t approxMemoryUsage(const value_type&) const { return 0; }
   private:
     struct CacheEntry {
       bool underConstruction = false;
       bool wasInvalidatedDuringConstruction = false;
       WeakPtr weakPtr;
-      void clear() { underConstruction = wasInvalidatedDuringConstruction = false; weakPtr.reset(); }
+      std::size_t approxBytes = 0;
+      void clear() { underConstruction = wasInvalidatedDuringConstruction = false; weakPtr.reset(); approxBytes = 0; }
     };
-    using CacheMap = std::map<thinned_key_type,CacheEntry>;
+    void recordAccess( const ShPtr&, std::size_t approxBytes, bool isNew );//must hold lock
+    using CacheMap = typename TKeyThinner::template map_type<CacheEntry>;
     CacheMap m_cache;
     std::mutex m_mutex;
+    //Threads waiting for another thread to finish constructing an object are
+    //woken up via this whenever a construction finishes (or fails):
+    std::condition_variable_any m_constructionFinished;
     class StrongRefKeeper;
     StrongRefKeeper m_strongRefs;
     bool m_cleanupNeedsRegistry = true;
+    uint64_t m_nhits = 0;
+    uint64_t m_nmisses = 0;
+    double m_constructionTime = 0.0;
 
   };
 
@@ -118,6 +166,36 @@ namespace NCrystal {
   void enableFactoryVerbosity( bool status = true );
   bool getFactoryVerbosity();
 
+  //Memory budget in bytes for objects kept alive by factory caches (0 means no
+  //budget, in which case each factory just keeps its NStrongRefsKept last
+  //accessed objects alive). The default value can be set in megabytes with the
+  //NCRYSTAL_FACTORY_CACHE_MB environment variable. Lowering the budget
+  //immediately releases objects as needed:
+  void setFactoryCacheMemoryBudget( std::size_t nbytes );
+  std::size_t getFactoryCacheMemoryBudget();
+
+  struct FactoryCacheMemoryStats { std::size_t budget, nobjects, nbytes; };
+  FactoryCacheMemoryStats getFactoryCacheMemoryStats();
+
+  //Statistics for all caches which have been used so far. Caches which are not
+  //instances of CachedFactoryBase can participate by registering a function
+  //providing their statistics (CachedFactoryBase instances register themselves
+  //upon first usage):
+  std::vector<FactoryCacheStats> getAllFactoryCacheStats();
+  void registerFactoryCacheStatsFunction( std::function<FactoryCacheStats()> );
+
+  namespace detail {
+    //Global LRU list of strong refs kept under the memory budget, with
+    //entries tagged by the owning factory. It never calls back into any
+    //factory, and released objects are destructed after its internal lock is
+    //released (or, for the release functions, handed to the caller):
+    void memBudgetTouch( const void* owner, std::shared_ptr<const void> obj, std::size_t nbytes );
+    void memBudgetReleaseAll( const void* owner, std::vector<std::shared_ptr<const void>>& released );
+    void memBudgetRelease( const std::set<const void*>& objs, std::vector<std::shared_ptr<const void>>& released );
+    struct MemBudgetOwnerStats { std::size_t nobjects, nbytes; };
+    MemBudgetOwnerStats memBudgetOwnerStats( const void* owner );
+  }
+
 }
 
 
@@ -148,6 +226,12 @@ namespace NCrystal {
   public:
     StrongRefKeeper()  { reserveCapacity(m_v); }
     void clear() { m_v.clear(); }
+    void moveAllTo( std::vector<std::shared_ptr<const void>>& out )
+    {
+      for ( auto& sp : m_v )
+        out.push_back( std::move(sp) );
+      m_v.clear();
+    }
     bool empty() const { return m_v.empty(); }
     std::size_t size() const { return static_cast<std::size_t>(m_v.size()); }
     void wasAccessedAndIsNotInList( const ShPtr& sp ) {
@@ -221,22 +305,81 @@ namespace NCrystal {
     }
   };
 
+  template<class TKey,class TValue,unsigned N,class TKT>
+  inline void CachedFactoryBase<TKey,TValue,N,TKT>::recordAccess( const ShPtr& sp, std::size_t approxBytes, bool isNew )
+  {
+    if ( approxBytes > 0 && getFactoryCacheMemoryBudget() > 0 ) {
+      //Kept alive under the global budget rather than by m_strongRefs:
+      if (!isNew)
+        m_strongRefs.releaseOne( sp );
+      detail::memBudgetTouch( this, sp, approxBytes );
+      return;
+    }
+    if ( isNew )
+      m_strongRefs.wasAccessedAndIsNotInList( sp );
+    else
+      m_strongRefs.wasAccessed( sp );
+  }
+
   template<class TKey,class TValue,unsigned N,class TKT>
   inline void CachedFactoryBase<TKey,TValue,N,TKT>::cleanup()
   {
-    NCRYSTAL_LOCK_GUARD(m_mutex);
-    m_strongRefs.clear();
-    auto it = m_cache.begin();
-    auto itE = m_cache.end();
-    while (it!=itE) {
-      auto itNext = std::next(it);
-      if ( it->second.underConstruction ) {
-        it->second.wasInvalidatedDuringConstruction = true;
-      } else {
-        m_cache.erase(it);
+    //Released objects are disposed of after the lock is released:
+    std::vector<std::shared_ptr<const void>> released;
+    {
+      NCRYSTAL_LOCK_GUARD(m_mutex);
+      m_strongRefs.moveAllTo( released );
+      detail::memBudgetReleaseAll( this, released );
+      auto it = m_cache.begin();
+      auto itE = m_cache.end();
+      while (it!=itE) {
+        auto itNext = std::next(it);
+        if ( it->second.underConstruction ) {
+          it->second.wasInvalidatedDuringConstruction = true;
+        } else {
+          m_cache.erase(it);
+        }
+        it = itNext;
+      }
+    }
+    disposeReleasedCacheObjects( std::move(released) );
+  }
+
+  template<class TKey,class TValue,unsigned N,class TKT>
+  template<class TPred>
+  inline void CachedFactoryBase<TKey,TValue,N,TKT>::cleanupIf( TPred pred )
+  {
+    std::vector<std::shared_ptr<const void>> released;
+    {
+      NCRYSTAL_LOCK_GUARD(m_mutex);
+      std::set<ShPtr> to_release;
+      auto it = m_cache.begin();
+      auto itE = m_cache.end();
+      while (it!=itE) {
+        auto itNext = std::next(it);
+        if ( pred( it->first ) ) {
+          if ( it->second.underConstruction ) {
+            it->second.wasInvalidatedDuringConstruction = true;
+          } else {
+            ShPtr sp = it->second.weakPtr.lock();
+            if ( sp != nullptr )
+              to_release.insert( std::move(sp) );
+            m_cache.erase(it);
+          }
+        }
+        it = itNext;
+      }
+      if ( !to_release.empty() ) {
+        m_strongRefs.releaseMany( to_release );
+        std::set<const void*> objs;
+        for ( auto& sp : to_release )
+          objs.insert( sp.get() );
+        detail::memBudgetRelease( objs, released );
+        for ( auto& sp : to_release )
+          released.push_back( sp );
       }
-      it = itNext;
     }
+    disposeReleasedCacheObjects( std::move(released) );
   }
 
   template<class TKey,class TValue,unsigned N,class TKT>
@@ -246,6 +389,30 @@ namespace NCrystal {
     Stats s;
     s.nstrongrefs = m_strongRefs.size();
     s.nweakrefs = static_cast<std::size_t>(m_cache.size());
+    auto bs = detail::memBudgetOwnerStats( this );
+    s.nbudgetedrefs = bs.nobjects;
+    s.nbudgetedbytes = bs.nbytes;
+    return s;
+  }
+
+  template<class TKey,class TValue,unsigned N,class TKT>
+  inline FactoryCacheStats CachedFactoryBase<TKey,TValue,N,TKT>::fullStats()
+  {
+    FactoryCacheStats s;
+    s.name = factoryName();
+    auto bs = detail::memBudgetOwnerStats( this );
+    NCRYSTAL_LOCK_GUARD(m_mutex);
+    s.nstrongrefs = m_strongRefs.size() + bs.nobjects;
+    s.nentries = static_cast<std::size_t>(m_cache.size());
+    for ( auto& e : m_cache ) {
+      if ( e.second.underConstruction )
+        ++s.ninflight;
+      if ( !e.second.weakPtr.expired() )
+        s.nbytes += e.second.approxBytes;
+    }
+    s.nhits = m_nhits;
+    s.nmisses = m_nmisses;
+    s.constructionTime = m_constructionTime;
     return s;
   }
 
@@ -269,6 +436,7 @@ namespace NCrystal {
       //Local guard class. Kind of like std::lock_guard, but can remove set
       //underConstruction flag as well.
       std::mutex& m_mutex;
+      std::condition_variable_any& m_constructionFinished;
       bool* m_constructFlag = nullptr;
       bool m_isLocked = false;
     public:
@@ -280,15 +448,18 @@ namespace NCrystal {
       constexpr bool isLocked() const noexcept { return m_isLocked; }
 
       bool weHoldConstructFlag() const { return m_constructFlag != nullptr; }
-      Guard( std::mutex& mutex ) : m_mutex(mutex) {}
+      Guard( std::mutex& mutex, std::condition_variable_any& cv )
+        : m_mutex(mutex), m_constructionFinished(cv) {}
       void releaseConstructFlagWithoutSetting() {
         m_constructFlag = nullptr;
+        m_constructionFinished.notify_all();
       }
       void setConstructFlagFalseAndRelease() {
         if ( m_constructFlag != nullptr ) {
           ensureLock(NCRYSTAL_DEBUG_LOCKS_ARGS);
           *m_constructFlag = false;
           m_constructFlag = nullptr;
+          m_constructionFinished.notify_all();
         }
       }
       void setConstructFlagWithGuard( bool* constructFlag ) {
@@ -335,12 +506,13 @@ namespace NCrystal {
     const bool verbose = getFactoryVerbosity();
     const std::string keystr = ( verbose ? keyToString(key) : std::string() );
 
-    Guard guard(m_mutex);
+    Guard guard(m_mutex,m_constructionFinished);
     guard.ensureLock(NCRYSTAL_DEBUG_LOCKS_ARGS);
     if ( m_cleanupNeedsRegistry ) {
       m_cleanupNeedsRegistry = false;
       std::function<void()> fct_cleanup = [this](){ this->cleanup(); };
       registerCacheCleanupFunction(fct_cleanup);
+      registerFactoryCacheStatsFunction( [this](){ return this->fullStats(); } );
     }
 
     if ( verbose )
@@ -351,24 +523,28 @@ namespace NCrystal {
 
     Optional<thinned_key_type> thinned_key;
 
-    auto& cache_entry = TKT::cacheMapLookup( m_cache, key, thinned_key );
-    ShPtr res = cache_entry.weakPtr.lock();
+    //NB: Map entries might be erased by cleanup() whenever we do not hold the
+    //lock (unless they are under construction), so the entry must be looked
+    //up again after reacquiring the lock:
+    CacheEntry* cache_entry = &TKT::cacheMapLookup( m_cache, key, thinned_key );
+    ShPtr res = cache_entry->weakPtr.lock();
     if (!!res) {
       if ( verbose )
         std::cout<< this->factoryName()
                  <<" (thread_"<<thread_details::currentThreadIDForPrint()<<")"
                  <<" : Return pre-existing cached object for key "<<keystr<<std::endl;
-      nc_assert_always(!cache_entry.underConstruction);
+      nc_assert_always(!cache_entry->underConstruction);
 
       //Record access:
       nc_assert(guard.isLocked());
-      m_strongRefs.wasAccessed( res );
+      ++m_nhits;
+      recordAccess( res, cache_entry->approxBytes, false );
       return res;//easy: already there
     }
     //Not there: check if already under construction or if we should construct:
 
-    if (!cache_entry.underConstruction) {
-      guard.setConstructFlagWithGuard(&cache_entry.underConstruction);
+    if (!cache_entry->underConstruction) {
+      guard.setConstructFlagWithGuard(&cache_entry->underConstruction);
       nc_assert(guard.weHoldConstructFlag());
     }
 
@@ -383,22 +559,33 @@ namespace NCrystal {
                   <<" (thread_"<<thread_details::currentThreadIDForPrint()<<")"
                   << " : Creating (from scratch) object for key " << keystr << std::endl;
       //Invoke actual creation function without holding the mutex lock.
-      res = actualCreate(key);
+      auto t0 = std::chrono::steady_clock::now();
+      std::size_t approxBytes;
+      {
+        Trace::Span span( this->factoryName() );
+        if ( span.active() )
+          span.setDetail( keyToString(key) );
+        res = actualCreate(key);
+        approxBytes = ( res ? approxMemoryUsage(*res) : 0 );
+      }
+      const double tconstruct = std::chrono::duration<double>(std::chrono::steady_clock::now()-t0).count();
       //Populate result while holding mutex lock:
       guard.ensureLock(NCRYSTAL_DEBUG_LOCKS_ARGS);
-      cache_entry = TKT::cacheMapLookup( m_cache, key, thinned_key );//reacquire after getting lock back
+      ++m_nmisses;
+      m_constructionTime += tconstruct;
+      cache_entry = &TKT::cacheMapLookup( m_cache, key, thinned_key );//reacquire after getting lock back
       //no one else should have tried to create this:
-      nc_assert_always(cache_entry.underConstruction);
-      nc_assert_always(!cache_entry.weakPtr.lock());
+      nc_assert_always(cache_entry->underConstruction);
+      nc_assert_always(!cache_entry->weakPtr.lock());
       //Check if was invalidated while constructing:
-      if ( cache_entry.wasInvalidatedDuringConstruction ) {
+      if ( cache_entry->wasInvalidatedDuringConstruction ) {
         //oups, we were invalidated. Throw away result and restart:
         if ( verbose )
           std::cout<< this->factoryName()
                    <<" (thread_"<<thread_details::currentThreadIDForPrint()<<")"
                    <<" : Throwing away constructed result due to invalidation from another thread"<<std::endl;
+        cache_entry->clear();
         guard.releaseConstructFlagWithoutSetting();
-        cache_entry.clear();
         guard.ensureUnlock(NCRYSTAL_DEBUG_LOCKS_ARGS);
         return this->create(key);
       } else {
@@ -407,32 +594,35 @@ namespace NCrystal {
           std::cout<< this->factoryName()
                    <<" (thread_"<<thread_details::currentThreadIDForPrint()<<")"
                    <<" : Finished construction"<<std::endl;
-        cache_entry.weakPtr = res;
-        m_strongRefs.wasAccessedAndIsNotInList( res );
+        cache_entry->weakPtr = res;
+        cache_entry->approxBytes = approxBytes;
+        recordAccess( res, approxBytes, true );
         guard.setConstructFlagFalseAndRelease();
         guard.ensureUnlock(NCRYSTAL_DEBUG_LOCKS_ARGS);
         return res;
       }
     } else {
-      //Wait for other thread to populate cache. Sleep and recheck periodically.
-      while (true) {
-#ifndef NCRYSTAL_DISABLE_THREADS
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
-#else
-        NCRYSTAL_THROW(LogicError,"Other thread seems to be doing work - but NCrystal was built with NCRYSTAL_DISABLE_THREADS and can not support this.");
+      //Wait for other thread to populate cache. We are woken up whenever a
+      //construction finishes (the timeout is merely a safeguard), and then
+      //recheck. All threads requesting the same key thus wait for a single
+      //construction, and resume as soon as it is done.
+#ifdef NCRYSTAL_DISABLE_THREADS
+      NCRYSTAL_THROW(LogicError,"Other thread seems to be doing work - but NCrystal was built with NCRYSTAL_DISABLE_THREADS and can not support this.");
 #endif
-        guard.ensureLock(NCRYSTAL_DEBUG_LOCKS_ARGS);
-        cache_entry = TKT::cacheMapLookup( m_cache, key, thinned_key );//reacquire after getting lock back
-        if ( verbose )
-          std::cout<< this->factoryName()
-                   <<" (thread_"<<thread_details::currentThreadIDForPrint()<<")"
-                   <<" : Waiting for other thread to create (from scratch) object for key "<<keystr<<std::endl;
-        res = cache_entry.weakPtr.lock();
-        if (!!res)
+      Trace::Span span( std::string(this->factoryName()) + " (wait)" );
+      if ( span.active() )
+        span.setDetail( keyToString(key) );
+      guard.ensureLock(NCRYSTAL_DEBUG_LOCKS_ARGS);
+      while (true) {
+        cache_entry = &TKT::cacheMapLookup( m_cache, key, thinned_key );//reacquire after getting lock back
+        res = cache_entry->weakPtr.lock();
+        if (!!res) {
+          ++m_nhits;
           return res;//success! [other thread just created it and put it in m_strongRefs, probably wasteful to do it again]
+        }
 
         //Not yet. Double-check other thread is still trying:
-        if (!cache_entry.underConstruction) {
+        if (!cache_entry->underConstruction) {
           //Not there and no other thread is currently trying to construct
           //it. Technically we can't know if this situation happened because the
           //other thread ended prematurely (e.g. exception thrown), or because
@@ -454,7 +644,12 @@ namespace NCrystal {
           guard.ensureUnlock(NCRYSTAL_DEBUG_LOCKS_ARGS);
           return this->create(key);
         }
-        guard.ensureUnlock(NCRYSTAL_DEBUG_LOCKS_ARGS);
+        if ( verbose )
+          std::cout<< this->factoryName()
+                   <<" (thread_"<<thread_details::currentThreadIDForPrint()<<")"
+                   <<" : Waiting for other thread to create (from scratch) object for key "<<keystr<<std::endl;
+        nc_assert(guard.isLocked());
+        m_constructionFinished.wait_for( m_mutex, std::chrono::milliseconds(100) );
       }
     }
   }
@@ -54,9 +54,20 @@ namespace NCrystal {
     enum caltype {FT_forward,FT_inverse};
     std::vector< std::complex<double> > m_w;
 
-    //The actual fast-fourier transform algorithm:
-    void fftd( std::vector<std::complex<double> > &inout, caltype ct,
-               unsigned minimum_output_size );
+    //Transform "plans" are cached per transform size (which is a power of 2),
+    //since the same sizes are typically used repeatedly. The twiddle table
+    //above and the work buffer below are shared between all sizes:
+    struct Plan {
+      unsigned size = 0, log_size = 0;
+      std::vector<std::pair<unsigned,unsigned>> bitrev_swaps;
+    };
+    std::vector<Plan> m_plans;//indexed by log_size
+    std::vector< std::complex<double> > m_work;
+    const Plan& getPlan( unsigned minimum_output_size );
+
+    //The actual fast-fourier transform algorithm (in-place, data.size() must
+    //match the plan):
+    void fftd( std::vector<std::complex<double> > &data, const Plan&, caltype ct );
     void initWTable( unsigned );
   };
 }
@@ -26,6 +26,7 @@
 // ubiquitous, but until then...
 
 #include "NCrystal/NCDefs.hh"
+#include "NCrystal/internal/NCSpan.hh"
 
 namespace NCrystal {
 
@@ -54,6 +55,20 @@ namespace NCrystal {
   // linux/osx/bsd, and fail gracefully in the rest.
   std::string tryRealPath( const std::string& path );
 
+  //Identity of a file (inode, modification time and size), which can be used
+  //to cheaply detect on-disk changes without reading the file. Returns NullOpt
+  //if the file does not exist or on platforms without stat support:
+  struct FileStamp {
+    uint64_t inode = 0;
+    int64_t mtime_ns = 0;
+    uint64_t size = 0;
+    bool operator==( const FileStamp& o ) const
+    {
+      return inode == o.inode && mtime_ns == o.mtime_ns && size == o.size;
+    }
+  };
+  Optional<FileStamp> tryGetFileStamp( const std::string& path );
+
   //Read entire file into a string while protecting against someone mistakenly
   //trying to open a multi-gigabyte file and bringing their machine to a slow
   //halt. Will return NullOpt in case the file does not exists or is
@@ -61,6 +76,26 @@ namespace NCrystal {
   //DataLoadError.
   Optional<std::string> readEntireFileToString( const std::string& path );
 
+  //Read-only memory map of an entire file. Pages are shared with any other
+  //process mapping the same file, so the data is only present once in physical
+  //memory on a given machine. The mapFile function returns nullptr if the file
+  //can not be mapped (including on platforms without mmap support):
+  class MappedFile : private NoCopyMove {
+  public:
+    static std::shared_ptr<const MappedFile> mapFile( const std::string& path );
+    //Version for text files, which additionally guarantees that the mapped
+    //data is followed by a null character (as required by RawStrData). This
+    //comes for free from the zero-filled remainder of the last page, so
+    //nullptr is also returned for files whose size is a multiple of the page
+    //size:
+    static std::shared_ptr<const MappedFile> mapTextFile( const std::string& path );
+    ~MappedFile();
+    Span<const char> data() const { return m_data; }
+  private:
+    MappedFile( const char * data, std::size_t size ) : m_data( data, data + size ) {}
+    Span<const char> m_data;
+  };
+
 }
 
 #endif
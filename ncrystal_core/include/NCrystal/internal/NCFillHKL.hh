@@ -32,6 +32,15 @@ namespace NCrystal {
   //will then calculate and add the HKL info, so HKL must not yet have been
   //enabled on the passed Info object.
   //
+  //If the NCRYSTAL_FILLHKL_CACHE environment variable is set to 1, the
+  //temperature independent partial structure factors of each atom species are
+  //cached for all planes. Later invocations for the same crystal which only
+  //differ in dcutoff or in the mean-squared-displacements of the atoms (e.g.
+  //parameter sweeps or temperature scans) then only need to calculate the
+  //additional planes when dcutoff is lowered, and to recombine the partial
+  //structure factors with new Debye-Waller factors. Results are the same as
+  //without the cache.
+  //
   //Several parameters can be used to fine-tune the behaviour:
 
   struct FillHKLCfg {
@@ -45,6 +54,15 @@ namespace NCrystal {
     bool expandhkl = false;// Request that lists of equivalent HKL planes be
                            // created in Info objects.
 
+    bool compact = false;// Store only a representative (h,k,l), dspacing,
+                         // fsquared and multiplicity for each family, with no
+                         // demi-normals (saving a lot of memory for powder-only
+                         // usage). Families are split into groups of
+                         // symmetry-equivalent reflections, allowing consumers
+                         // to reconstruct normals on demand from the space
+                         // group. Ignored if there is no space group, and can
+                         // not be combined with expandhkl.
+
     double fsquarecut = 1e-5;// Barn. A cutoff value in barn. HKL reflections
                              // with contribution below this will be skipped
                              // (used to skip weak and impossible
@@ -0,0 +1,49 @@
+#ifndef NCrystal_FlatBlob_hh
+#define NCrystal_FlatBlob_hh
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+//  This file is part of NCrystal (see https://mctools.github.io/ncrystal/)   //
+//                                                                            //
+//  Copyright 2015-2021 NCrystal developers                                   //
+//                                                                            //
+//  Licensed under the Apache License, Version 2.0 (the "License");           //
+//  you may not use this file except in compliance with the License.          //
+//  You may obtain a copy of the License at                                   //
+//                                                                            //
+//      http://www.apache.org/licenses/LICENSE-2.0                            //
+//                                                                            //
+//  Unless required by applicable law or agreed to in writing, software       //
+//  distributed under the License is distributed on an "AS IS" BASIS,         //
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  //
+//  See the License for the specific language governing permissions and       //
+//  limitations under the License.                                            //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include "NCrystal/NCProcImpl.hh"
+
+namespace NCrystal {
+
+  //Export an isotropic scatter process to a flat pointer-free memory blob, in
+  //the layout described (and evaluated) by the C header ncflatblob.h. The
+  //process is decomposed into its ProcComposition components (recursively),
+  //with PCBragg components stored exactly, and all other components tabulated
+  //on a union energy grid of nekin logarithmically spaced points in
+  //[ekin_min,ekin_max] (with domain edges of the components inserted), along
+  //with nsamples sampled outcomes for each grid point. Throws BadInput for
+  //oriented processes or invalid parameters. The returned blob is stored in
+  //uint64 words to guarantee alignment, its size in bytes is a multiple of 8.
+
+  struct FlatBlobCfg {
+    double ekin_min = 1e-5;
+    double ekin_max = 10.0;
+    unsigned nekin = 1000;
+    unsigned nsamples = 128;
+  };
+
+  std::vector<std::uint64_t> exportFlatBlob( const ProcImpl::Process&, RNG&, const FlatBlobCfg& = {} );
+
+}
+
+#endif
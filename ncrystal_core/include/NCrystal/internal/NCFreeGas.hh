@@ -42,13 +42,22 @@ namespace NCrystal {
 
     const char * name() const noexcept final { return "FreeGas"; }
 
-    //Explicitly provide target parameters or take parameters from AtomData object:
-    FreeGas( Temperature, AtomMass, SigmaFree );
-    FreeGas( Temperature, AtomMass, SigmaBound );
-    FreeGas( Temperature, const AtomData& );
+    //Explicitly provide target parameters or take parameters from AtomData
+    //object. If tabulatedBeta is true, energy transfers will be sampled from a
+    //shared precomputed table (see FreeGasBetaTable in NCFreeGasUtils.hh),
+    //which is faster but only approximate:
+    FreeGas( Temperature, AtomMass, SigmaFree, bool tabulatedBeta = false );
+    FreeGas( Temperature, AtomMass, SigmaBound, bool tabulatedBeta = false );
+    FreeGas( Temperature, const AtomData&, bool tabulatedBeta = false );
 
     CrossSect crossSectionIsotropic(CachePtr&, NeutronEnergy ) const override;
     ScatterOutcomeIsotropic sampleScatterIsotropic(CachePtr&, RNG&, NeutronEnergy ) const override;
+    CrossSect majorantCrossSection( EnergyDomain ) const override;
+    void evalManyXSIsotropic( CachePtr&, const double* ekin, std::size_t N,
+                              double* out_xs ) const override;
+    void sampleScatterIsotropicMany( CachePtr&, RNG&, double* ekin, std::size_t N,
+                                     double* out_mu ) const override;
+    void accountMemory( MemoryFootprint& ) const override;
 
     virtual ~FreeGas();
 
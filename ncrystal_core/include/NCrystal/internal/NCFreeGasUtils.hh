@@ -73,6 +73,9 @@ namespace NCrystal {
     //Get the cross-section:
     CrossSect crossSection( NeutronEnergy ekin ) const;
 
+    //Get the cross-section for N energies at once:
+    void evalManyXS( const double* ekin, std::size_t N, double* out_xs ) const;
+
     //Evaluate (1+1/(2a^2))*erf(a)+exp(-a^2)/(sqrt(pi)*a) (used internally, but
     //exposed here for testing):
     static double evalXSShapeASq(double a_squared);
@@ -81,12 +84,16 @@ namespace NCrystal {
     double m_sigmaFree, m_ca;
   };
 
+  class FreeGasBetaTable;
+
   class FreeGasSampler final {
   public:
 
     //Evaluate quantum mechanical Free Gas model.
 
-    FreeGasSampler(NeutronEnergy, Temperature, AtomMass );
+    //If a FreeGasBetaTable (for the same target mass) is provided, it will be
+    //used to sample beta values whenever it covers the neutron energy:
+    FreeGasSampler(NeutronEnergy, Temperature, AtomMass, const FreeGasBetaTable* = nullptr );
     ~FreeGasSampler();
 
     //Beta/energy-transfer sampling:
@@ -105,6 +112,54 @@ namespace NCrystal {
 
   private:
     double m_c, m_kT, m_sqrtAc, m_invA, m_Adiv4, m_normfact, m_c_real;
+    const FreeGasBetaTable* m_betatable;
+    double sampleBetaExact(RNG&) const;
+  };
+
+  class FreeGasBetaTable final : private MoveOnly {
+  public:
+
+    //Precomputed inverse cumulative distribution functions of beta, for a
+    //given target mass and values of c=E/kT on a logarithmic grid in
+    //[cmin,cmax]. As the distributions only depend on c and the mass, a table
+    //can be used at any temperature. Tables are built by numerical
+    //integration of the exact distributions of beta, and beta values are then
+    //sampled with a single random number by interpolating the quantiles (in
+    //both c and the random number) of the neighbouring grid points. The
+    //results are thus approximate, with the largest relative deviations in the
+    //far tails of the distributions. Callers must fall back to exact sampling
+    //outside [cmin,cmax].
+    //
+    //Tables are expensive to create, so the shared instances for a given
+    //target mass provided by getShared() should normally be used.
+    //
+    //High-energy tables (getSharedHighE()) instead cover c in
+    //[cmax,highECMax(mass)], above which the exact sampling uses the simple
+    //limit of a uniformly distributed energy loss anyway. As the width of the
+    //distributions grows proportionally to c, these tables hold quantiles of
+    //the reduced variable beta/c, and sampled values are scaled back with c.
+
+    static constexpr double cmin = 1e-3;
+    static constexpr double cmax = 1e3;
+    static double highECMax( AtomMass );
+    bool covers( double c ) const noexcept { return c >= m_cmin && c <= m_cmax; }
+
+    double sampleBeta( double c, RNG& ) const;
+
+    FreeGasBetaTable( AtomMass, bool highE = false );
+    static shared_obj<const FreeGasBetaTable> getShared( AtomMass );
+    static shared_obj<const FreeGasBetaTable> getSharedHighE( AtomMass );
+
+    AtomMass targetMass() const noexcept { return m_mass; }
+    bool isHighE() const noexcept { return m_highE; }
+    std::size_t approxMemoryUsage() const noexcept;
+
+  private:
+    AtomMass m_mass;
+    VectD m_quantiles;//m_nu quantiles for each grid point in c
+    double m_cmin, m_cmax, m_dlogc_inv;
+    unsigned m_nc;
+    bool m_highE;
   };
 
 }
@@ -122,6 +177,19 @@ namespace NCrystal {
     return CrossSect{ m_sigmaFree * evalXSShapeASq( m_ca * ekin.dbl() ) };
   }
 
+  inline void FreeGasXSProvider::evalManyXS( const double* ekin, std::size_t N, double* out_xs ) const
+  {
+    for ( std::size_t i = 0; i < N; ++i )
+      out_xs[i] = m_sigmaFree * evalXSShapeASq( m_ca * ekin[i] );
+  }
+
+  inline double FreeGasSampler::sampleBeta( RNG& rng ) const
+  {
+    if ( m_betatable && m_betatable->covers( m_c_real ) )
+      return m_betatable->sampleBeta( m_c_real, rng );
+    return sampleBetaExact( rng );
+  }
+
   inline double FreeGasSampler::sampleDeltaE( RNG& rng ) const
   {
     return sampleBeta(rng)*m_kT;
@@ -24,9 +24,12 @@
 #include "NCrystal/NCTypes.hh"
 #include "NCrystal/internal/NCGaussOnSphere.hh"
 #include "NCrystal/internal/NCVector.hh"
+#include <cstdlib>
 
 namespace NCrystal {
 
+  class GaussMos_CandidateBatch;
+
   class GaussMos {
   public:
 
@@ -52,6 +55,10 @@ namespace NCrystal {
     void setTruncationN(double);
     void setPrecision(double);
 
+    //Use precomputed tables for circle integrals where approximation formulas
+    //are not valid (see GaussOnSphere::enableCircleIntegralTable):
+    void enableCircleIntegralTable();
+
     void setDSpacingSpread(double);//Enable dspacing deviation in non-ideal crystal [default value of 0.0 means no deviation]
 
     //Access parameters of Gaussian mosaicity distribution:
@@ -83,6 +90,19 @@ namespace NCrystal {
     double calcRawCrossSectionValue( InteractionPars& ip,
                                      double cos_angle_indir_normal ) const;
 
+    //Batch version of calcRawCrossSectionValue, with identical results. The
+    //spans must have the same size, and may refer to the same memory:
+    void calcRawCrossSectionValues( InteractionPars& ip,
+                                    Span<const double> cos_angles_indir_normal,
+                                    Span<double> out ) const;
+
+    //Conservative upper bound of calcRawCrossSectionValue for a given plane,
+    //valid for any neutron direction and any neutron wavelength up to wl_max
+    //(the bound increases with wavelength, until wl_max reaches 2*dspacing). The
+    //xsfact parameter has the same meaning as for InteractionPars. This is
+    //intended for quick estimation of majorant cross sections:
+    double calcMaxCrossSectionValue( double wl_max, double inv2dsp, double xsfact ) const;
+
     //Cross-sections for a large number of demi-normals can be found in one go
     //(if they otherwise share parameters like d-spacing & fsquared, which must
     //have been first set with a call to setInteractionParameters). This method
@@ -103,6 +123,38 @@ namespace NCrystal {
                               std::vector<ScatCache>& cache,
                               VectD& xs_commul ) const;
 
+    //Alternatively, the deminormals can be provided in a structure-of-arrays
+    //layout, which allows the compiler to vectorise the initial truncation
+    //checks. Results (including the order of entries appended to cache and
+    //xs_commul) are identical to those of the method above:
+    class NormalsSoA;
+    double calcCrossSections( InteractionPars& ip,
+                              const Vector& neutron_indir,
+                              const NormalsSoA& deminormals,
+                              std::vector<ScatCache>& cache,
+                              VectD& xs_commul ) const;
+
+    //Same, but only considering the normals with indices in [ibegin,iend)
+    //(allowing normals of many families to share a single NormalsSoA object):
+    double calcCrossSections( InteractionPars& ip,
+                              const Vector& neutron_indir,
+                              const NormalsSoA& deminormals,
+                              std::size_t ibegin, std::size_t iend,
+                              std::vector<ScatCache>& cache,
+                              VectD& xs_commul ) const;
+
+    //Same as the calcCrossSections methods above, but only returning the total
+    //cross-section, without recording the intermediate results for individual
+    //deminormals (for when these are not needed, or will only be needed for a
+    //few groups of deminormals, which can then be recalculated):
+    double calcTotalCrossSection( InteractionPars& ip,
+                                  const Vector& neutron_indir,
+                                  const std::vector<Vector>& deminormals ) const;
+    double calcTotalCrossSection( InteractionPars& ip,
+                                  const Vector& neutron_indir,
+                                  const NormalsSoA& deminormals,
+                                  std::size_t ibegin, std::size_t iend ) const;
+
     //Scatterings can only be generated once appropriate info has been found via
     //previous calls to cross-section methods, and with relevant info embedded
     //into ScatCache objects (of course, they will only be relevant for the
@@ -138,6 +190,50 @@ namespace NCrystal {
     double m_delta_d = 0.0;
     void updateDerivedValues();
     double calcRawCrossSectionValueInit( InteractionPars&, double ) const;
+    //Implementation of calcCrossSections/calcTotalCrossSection (intermediate
+    //results are only recorded if cache and xs_commul are not null):
+    double calcCrossSectionsImpl( InteractionPars&, const Vector&,
+                                  const std::vector<Vector>&,
+                                  std::vector<ScatCache>*, VectD* ) const;
+    double calcCrossSectionsImpl( InteractionPars&, const Vector&,
+                                  const NormalsSoA&, std::size_t, std::size_t,
+                                  std::vector<ScatCache>*, VectD* ) const;
+  };
+
+  class GaussMos::NormalsSoA : private MoveOnly {
+  public:
+    //Copy of normals, stored in separate arrays of x, y and z coordinates, each
+    //aligned to GaussMos::NormalsSoA::alignment bytes:
+    static constexpr std::size_t alignment = 32;
+    NormalsSoA() = default;
+    explicit NormalsSoA( const std::vector<Vector>& );
+    explicit NormalsSoA( std::size_t n );//n null vectors, to be filled with set(..)
+    NormalsSoA( NormalsSoA&& ) = default;
+    NormalsSoA& operator=( NormalsSoA&& ) = default;
+
+    std::size_t size() const noexcept { return m_size; }
+    bool empty() const noexcept { return m_size == 0; }
+    const double * x() const noexcept { return m_data.get(); }
+    const double * y() const noexcept { return m_data.get() + m_stride; }
+    const double * z() const noexcept { return m_data.get() + 2 * m_stride; }
+    Vector at( std::size_t i ) const ncnoexceptndebug
+    {
+      nc_assert( i < m_size );
+      return { x()[i], y()[i], z()[i] };
+    }
+    void set( std::size_t i, const Vector& v ) ncnoexceptndebug
+    {
+      nc_assert( i < m_size );
+      double * xx = m_data.get();
+      xx[i] = v.x();
+      xx[i+m_stride] = v.y();
+      xx[i+2*m_stride] = v.z();
+    }
+  private:
+    struct Free { void operator()( double* p ) const noexcept { std::free(p); } };
+    std::unique_ptr<double[],Free> m_data;
+    std::size_t m_size = 0;
+    std::size_t m_stride = 0;
   };
 
   class GaussMos::InteractionPars {
@@ -148,6 +244,7 @@ namespace NCrystal {
     void set(double neutron_wavelength, double inv2dsp, double xsfact);
   private:
     friend class GaussMos;
+    friend class GaussMos_CandidateBatch;
     //Frequently accessed members first:
     double m_Q = 0.0;//Once initialised, m_Q = m_Qprime * m_xsfact
     double m_sin_perfect_theta = 0.0;
@@ -23,6 +23,7 @@
 
 #include "NCrystal/internal/NCMath.hh"
 #include "NCrystal/internal/NCSpline.hh"
+#include "NCrystal/internal/NCCounters.hh"
 #include <cstring>
 
 namespace NCrystal {
@@ -97,12 +98,20 @@ namespace NCrystal {
     double evalCosX(double cosx) const;//safe for any cosine value,  might be slow.
     double evalCosXInRange(double cosx) const;//like evalXCosX but slightly faster since it assumes cosx>=cos(truncangle) (within
                                               //numerical precision) or something bad will happen (an assert or a bad memory access).
+    void evalCosXInRangeMany( Span<const double> cosx, Span<double> out ) const;//batch version (in-place allowed)
 
     //Integrated density along a circle which is the result of intersecting the
     //sphere with a cone located an angle of gamma away from the Gaussian center
     //and with an opening angle of alpha.
     double circleIntegral( double cosgamma, double singamma, double cosalpha, double sinalpha ) const;
 
+    //Evaluate circleIntegral(..) for several values of cosgamma at once (with
+    //singamma=sqrt(1-cosgamma^2), i.e. gamma in [0,pi]). Circles for which the
+    //approximation formula is valid are evaluated with batched lookups, and
+    //results are identical to those of individual circleIntegral calls:
+    void circleIntegralMany( Span<const double> cosgamma, double cosalpha, double sinalpha,
+                             Span<double> out ) const;
+
     //Generate random point on circle, according to the density there. Returns
     //false in case of vanishing density everywhere on circle. The ct=cos(t) and
     //st=sin(t) values can be used to construct the coordinate of the chosen
@@ -112,6 +121,19 @@ namespace NCrystal {
     bool genPointOnCircle( RNG&, double cosgamma, double singamma, double cosalpha, double sinalpha,
                            double& cost, double& sint ) const;
 
+    //Optionally, the circle integrals for which the approximation formula is
+    //not valid (which otherwise require a full numerical integration) can be
+    //looked up in a precomputed 2D table. The table is shared between all
+    //GaussOnSphere instances with identical parameters, and it is refined
+    //until the interpolation errors are below half the precision
+    //parameter. If this is not possible within a reasonable table size (2M
+    //entries, usually only a problem for prec<1e-4), or if the precision
+    //parameter is >=1 (in which case numerical integration is never done), no
+    //table will be used. The setting is retained if the parameters are
+    //subsequently modified with a call to set(..):
+    void enableCircleIntegralTable();
+    bool hasCircleIntegralTable() const { return m_citable != nullptr; }
+
     static double calcNormFactor( double sigma, double trunc_angle );
 
     //Estimate ntrunc by finding the N at which a 2D *planar* Gaussian would
@@ -125,6 +147,10 @@ namespace NCrystal {
 
   private:
     double circleIntegralSlow( double cacg, double sasg, double ca, double sa ) const;
+    class CircleIntegralTable;
+    std::shared_ptr<const CircleIntegralTable> m_citable;
+    bool m_citable_enabled = false;
+    void updateCircleIntegralTable();
     double m_cta;
     double m_circleint_k1;
     double m_circleint_k2;
@@ -192,6 +218,14 @@ inline double NCrystal::GaussOnSphere::evalCosXInRange(double cosx) const {
   return res;
 }
 
+inline void NCrystal::GaussOnSphere::evalCosXInRangeMany( Span<const double> cosx, Span<double> out ) const {
+  nc_assert(isValid());
+  nc_assert(cosx.size()==out.size());
+  m_lt_evalcosx.evalMany( cosx, out );
+  for ( auto& e : out )
+    e = ncmax(0.0,e);
+}
+
 inline double NCrystal::GaussOnSphere::circleIntegral( double cg, double sg, double ca, double sa ) const
 {
   nc_assert(isValid());
@@ -207,6 +241,7 @@ inline double NCrystal::GaussOnSphere::circleIntegral( double cg, double sg, dou
   }
 
   //special case, needs more careful treatment:
+  NCRYSTAL_COUNT(GOSCircleIntSlow);
   return circleIntegralSlow( cg,sg,ca,sa );
   //NB: Passing in sasc and cacg to circleIntegralSlow seems like it might save
   //a few multiplications, but it actually slows down in certain benchmarks
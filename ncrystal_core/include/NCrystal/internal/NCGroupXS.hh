@@ -0,0 +1,63 @@
+#ifndef NCrystal_GroupXS_hh
+#define NCrystal_GroupXS_hh
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+//  This file is part of NCrystal (see https://mctools.github.io/ncrystal/)   //
+//                                                                            //
+//  Copyright 2015-2021 NCrystal developers                                   //
+//                                                                            //
+//  Licensed under the Apache License, Version 2.0 (the "License");           //
+//  you may not use this file except in compliance with the License.          //
+//  You may obtain a copy of the License at                                   //
+//                                                                            //
+//      http://www.apache.org/licenses/LICENSE-2.0                            //
+//                                                                            //
+//  Unless required by applicable law or agreed to in writing, software       //
+//  distributed under the License is distributed on an "AS IS" BASIS,         //
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  //
+//  See the License for the specific language governing permissions and       //
+//  limitations under the License.                                            //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include "NCrystal/NCProcImpl.hh"
+
+namespace NCrystal {
+
+  //Flux-weighted averages of the cross section of an isotropic process over
+  //energy groups, as needed for instance to provide multi-group cross
+  //sections for deterministic reactor physics codes. The G groups are given
+  //by G+1 increasing energies, groupBounds, and the result for group g is:
+  //
+  //  int_{E_g}^{E_{g+1}} xs(E)*flux(E) dE / int_{E_g}^{E_{g+1}} flux(E) dE
+  //
+  //The flux is given as a table of (energy,value) points, linearly
+  //interpolated in between, which must cover all groups. If no table is
+  //given, a 1/E (slowing down) spectrum is assumed. Groups with no flux get a
+  //value of 0.
+  //
+  //Integrals are carried out in ln(E), with Romberg integration on segments
+  //between all energies at which the integrand is known to have kinks or
+  //discontinuities: group bounds, flux table points, domain edges, Bragg
+  //edges of PCBragg instances and grid points of cross section tables of
+  //SABScatter instances (including components of compositions). Segments
+  //which do not converge quickly are bisected. Cross sections are evaluated
+  //with evalManyXSIsotropic for all points of a refinement level at once,
+  //and the segments are distributed over nthreads threads (0 means all
+  //available hardware threads). Results do not depend on nthreads.
+
+  struct GroupXSParams {
+    double precision = 1e-6;//relative precision targeted for each segment
+    unsigned nthreads = 1;
+  };
+
+  VectD groupAveragedXS( const ProcImpl::Process&,
+                         const VectD& groupBounds,
+                         const VectD& fluxEnergies,
+                         const VectD& fluxValues,
+                         const GroupXSParams& = GroupXSParams() );
+
+}
+
+#endif
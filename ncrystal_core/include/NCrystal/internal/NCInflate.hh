@@ -0,0 +1,44 @@
+#ifndef NCrystal_Inflate_hh
+#define NCrystal_Inflate_hh
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+//  This file is part of NCrystal (see https://mctools.github.io/ncrystal/)   //
+//                                                                            //
+//  Copyright 2015-2021 NCrystal developers                                   //
+//                                                                            //
+//  Licensed under the Apache License, Version 2.0 (the "License");           //
+//  you may not use this file except in compliance with the License.          //
+//  You may obtain a copy of the License at                                   //
+//                                                                            //
+//      http://www.apache.org/licenses/LICENSE-2.0                            //
+//                                                                            //
+//  Unless required by applicable law or agreed to in writing, software       //
+//  distributed under the License is distributed on an "AS IS" BASIS,         //
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  //
+//  See the License for the specific language governing permissions and       //
+//  limitations under the License.                                            //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include "NCrystal/internal/NCDebyeMSD.hh"
+#include "NCrystal/internal/NCMath.hh"
+
+#include "NCrystal/NCDefs.hh"
+
+namespace NCrystal {
+
+  //Minimal decoder for raw DEFLATE streams (RFC 1951, i.e. without zlib or
+  //gzip headers), as produced by e.g. Python's zlib.compressobj(wbits=-15).
+  //Used to unpack embedded data without depending on external libraries, so
+  //it favours simplicity over speed. The size of the decompressed data must be
+  //known in advance, and a BadInput exception is thrown if the stream is
+  //corrupt or does not inflate to exactly that number of bytes.
+
+  std::string inflateRawDeflate( const unsigned char* data,
+                                 std::size_t nbytes,
+                                 std::size_t expected_size );
+
+}
+
+#endif
@@ -24,6 +24,7 @@
 #include "NCrystal/NCProcImpl.hh"
 #include "NCrystal/NCSCOrientation.hh"
 #include "NCrystal/internal/NCVector.hh"
+#include "NCrystal/internal/NCSCBragg.hh"
 
 namespace NCrystal {
 
@@ -41,9 +42,18 @@ namespace NCrystal {
     //
     //     mode=0: LCHelper
     //     mode>0: LCBraggRef(nsample=mode)
-    //     mode<0: LCBraggRndmRef(nsample=-mode)
+    //     mode<0: LCBraggRndmRot(nsample=-mode)
     //
-    //For a description of the prec and ntrunc parameters, see NCGaussMos.hh.
+    //For a description of the prec and ntrunc parameters, see NCGaussMos.hh,
+    //and see GaussOnSphere::enableCircleIntegralTable for circint_table. A
+    //non-zero xstable_prec enables LCHelper::enableCrossSectionTable with that
+    //precision (only supported for mode=0), and fixed_rotations is passed on
+    //to LCBraggRndmRot (only supported for mode<0).
+    //
+    //For mode!=0, the orientation independent geometry of the underlying
+    //SCBragg model can be supplied in scgeometry (cf. SCBragg::createGeometry),
+    //so instances for different layer axes or orientations of the same
+    //crystal can share it. The plane_provider is then not used.
     LCBragg( const Info&,
              const SCOrientation&,
              MosaicityFWHM,
@@ -52,7 +62,11 @@ namespace NCrystal {
              double delta_d = 0,
              PlaneProvider * plane_provider = 0,
              double prec=1e-3,
-             double ntrunc=0.0 );
+             double ntrunc=0.0,
+             bool circint_table = false,
+             double xstable_prec = 0.0,
+             bool fixed_rotations = false,
+             optional_shared_obj<const SCBragg::Geometry> scgeometry = nullptr );
 
     const char * name() const noexcept final { return "LCBragg"; }
 
@@ -64,6 +78,16 @@ namespace NCrystal {
 
     CrossSect crossSection(CachePtr&, NeutronEnergy, const NeutronDirection& ) const final;
     ScatterOutcome sampleScatter(CachePtr&, RNG&, NeutronEnergy, const NeutronDirection& ) const final;
+    //Batched versions (passed on in one go to the underlying SCBragg model, if
+    //any):
+    void evalManyXS( CachePtr&, const double* ekin,
+                     const double* ux, const double* uy, const double* uz,
+                     std::size_t N, double* out_xs ) const final;
+    void sampleScatterMany( CachePtr&, RNG&, double* ekin,
+                            double* ux, double* uy, double* uz,
+                            std::size_t N ) const final;
+    CrossSect majorantCrossSection( EnergyDomain ) const final;
+    void accountMemory( MemoryFootprint& ) const final;
 
   private:
     struct pimpl;
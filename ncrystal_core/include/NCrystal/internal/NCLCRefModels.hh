@@ -37,6 +37,7 @@ namespace NCrystal {
     const char * name() const noexcept override { return "LCBraggRef"; }
     CrossSect crossSection(CachePtr&, NeutronEnergy, const NeutronDirection& ) const override;
     EnergyDomain domain() const noexcept override;
+    CrossSect majorantCrossSection( EnergyDomain ) const override;
     ScatterOutcome sampleScatter(CachePtr&, RNG&, NeutronEnergy, const NeutronDirection& ) const override;
   private:
     ProcImpl::ProcPtr m_sc;
@@ -54,19 +55,31 @@ namespace NCrystal {
     //
     //WARNING: The crossSection function of this class use the global default
     //RNG stream, and is therefore NOT MT-safe.
-    LCBraggRndmRot(ProcImpl::ProcPtr scbragg, LCAxis lcaxis_lab, unsigned nsample = 1);
+    //
+    //If fixed_rotations is set, the random rotations are instead replaced by a
+    //fixed set of equidistant rotations (nsample rounded up to a prime, like in
+    //LCBraggRef), precomputed once in the constructor. Cross-sections are then
+    //deterministic (and MT-safe), only recalculated when the neutron state
+    //changes, and the single crystal model is evaluated for all rotations in a
+    //single call to evalManyXS. Unlike LCBraggRef, the same rotations are used
+    //for sampling scatterings, consistently with the cross-sections.
+    LCBraggRndmRot(ProcImpl::ProcPtr scbragg, LCAxis lcaxis_lab, unsigned nsample = 1,
+                   bool fixed_rotations = false );
     const char * name() const noexcept override { return "LCBraggRndmRot"; }
     CrossSect crossSection(CachePtr&, NeutronEnergy, const NeutronDirection& ) const override;
     EnergyDomain domain() const noexcept override;
+    CrossSect majorantCrossSection( EnergyDomain ) const override;
     ScatterOutcome sampleScatter(CachePtr&, RNG&, NeutronEnergy, const NeutronDirection& ) const override;
   private:
     ProcImpl::ProcPtr m_sc;
     Vector m_lcaxislab;
     unsigned m_nsample;
+    std::vector<PhiRot> m_fixedrot;//only used with fixed_rotations
     class Cache : public CacheBase {
     public:
-      std::vector<PhiRot> rotations;//rotations sampled
+      std::vector<PhiRot> rotations;//rotations sampled (unused with fixed_rotations)
       VectD xscommul;//cross-sections at the sampled rotations.
+      VectD ekin, ux, uy, uz, xs;//buffers for evalManyXS with fixed_rotations
       CachePtr sc_cacheptr;//for passing to m_sc
       std::pair<NeutronEnergy,Vector> neutron_state = {NeutronEnergy{-1.0},Vector{0,0,0}};
       void invalidateCache() override { neutron_state = {NeutronEnergy{-1.0},Vector{0,0,0}}; }
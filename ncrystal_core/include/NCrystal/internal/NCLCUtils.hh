@@ -25,7 +25,6 @@
 #include "NCrystal/internal/NCGaussMos.hh"
 #include "NCrystal/internal/NCVector.hh"
 #include "NCrystal/NCTypes.hh"
-#include <cstring>
 
 namespace NCrystal {
 
@@ -109,8 +108,9 @@ namespace NCrystal {
     //wrapped appropriately. Note that this class does NOT apply any truncation
     //cut, which is assumed to take place in the calling code.
   public:
-    //Constructor takes same parameters as GaussMos.
-    LCStdFrame(MosaicityFWHM, double prec = 1e-3, double ntrunc = 0.0 );
+    //Constructor takes same parameters as GaussMos (and optionally enables
+    //GaussMos::enableCircleIntegralTable).
+    LCStdFrame(MosaicityFWHM, double prec = 1e-3, double ntrunc = 0.0, bool circint_table = false );
 
     //For reference, we provide const access to underlying GaussMos object
     const GaussMos& gaussMos() const { return m_gm; }
@@ -152,13 +152,13 @@ namespace NCrystal {
                   double cosphi, double sinphi, Vector& outdir ) const;
 
   private:
-    const GaussMos m_gm;
+    GaussMos m_gm;
   };
 
   class LCHelper : private MoveOnly {
     //Class which can provide cross-sections and scatterings for planes with
-    //normals not parallel to the lcaxis. Prec and ntrunc parameters will be
-    //passed on directly to the internal GaussMos object.
+    //normals not parallel to the lcaxis. Prec, ntrunc and circint_table
+    //parameters will be passed on directly to the internal LCStdFrame object.
   public:
     LCHelper( LCAxis lcaxis_crystalframe,
               LCAxis lcaxis_labframe,
@@ -166,7 +166,25 @@ namespace NCrystal {
               double unitcell_volume_times_natoms,
               PlaneProvider * pp,
               double prec = 1e-3,
-              double ntrunc = 0.0 );
+              double ntrunc = 0.0,
+              bool circint_table = false );
+    ~LCHelper();
+
+    //Optionally, cross-sections can be evaluated with the help of a table of
+    //the contributions from off-axis normals, precomputed on a grid in
+    //(wavelength,|cos(angle between neutron and lcaxis)|). The grid is refined
+    //until bilinear interpolation reproduces exact evaluations to the
+    //requested relative precision (or until the intervals become very
+    //small). Contributions from on-axis normals are sharply peaked but cheap,
+    //and are always evaluated exactly. The table is built (thread-safely) upon
+    //the first cross-section evaluation and is shared by all users of the
+    //LCHelper object. Scatterings are unaffected and still use the exact
+    //cross-sections of each ROI when selecting a plane to scatter on:
+    void enableCrossSectionTable( double precision );
+    bool hasCrossSectionTable() const { return m_xstable != nullptr; }
+
+    //Approximate memory footprint in bytes:
+    std::size_t approxMemoryUsage() const;
 
     //Usage happens via Cache objects (allowing users of the class to decide
     //upon caching strategies themselves). One should not share Cache objects
@@ -187,6 +205,10 @@ namespace NCrystal {
 
     double braggThreshold() const;//max wavelength, beyond which all cross-sections will be 0.
 
+    //Conservative upper bound on cross-sections for any wavelength in
+    //[wl_min,wl_max] and any direction:
+    double majorantCrossSection( double wl_min, double wl_max ) const;
+
     const GaussMos& gaussMos() { return m_lcstdframe.gaussMos(); }
 
   private:
@@ -195,18 +217,16 @@ namespace NCrystal {
     LCStdFrame m_lcstdframe;
     double m_xsfact;
     void forceUpdateCache( Cache&, uint64_t discr_wl, uint64_t discr_c3 ) const;
-    struct Overlay : private MoveOnly {
-      static const unsigned ndata = 8;
-      Overlay();
-      ~Overlay();
-      void clear();
-      void prepareNullArray();
-      float * data;
-      double nonCommulVal(unsigned i) const;
-      Overlay(Overlay&& o);
-      Overlay& operator=(Overlay&& o);
-    };
-  static void genPhiVal(RNG& rand, const LCROI& roi, const Overlay& overlay, double& phi, double& overlay_at_phi);
+    class XSTable;
+    std::unique_ptr<XSTable> m_xstable;
+    double crossSectionOffAxisNoTable( Cache&, double wavelength, double c3 ) const;
+    double crossSectionOnAxis( Cache&, double wavelength, double c3 ) const;
+    //Overlays for sampling phi in off-axis ROIs are commulative histograms
+    //with overlay_ndata bins across [rotmin,rotmax]. They are kept
+    //back-to-back in a single buffer in the Cache (all zeroes until prepared):
+    static constexpr unsigned overlay_ndata = 8;
+    static double overlayNonCommulVal(const float* overlay, unsigned i);
+  static void genPhiVal(RNG& rand, const LCROI& roi, const float* overlay, double& phi, double& overlay_at_phi);
 
   public:
     class Cache : public CacheBase {
@@ -222,7 +242,8 @@ namespace NCrystal {
       double m_s3;//sqrt(1-m_c3*m_c3)
       std::vector<LCROI> m_roilist;
       VectD m_roixs_commul;//for selecting
-      std::vector<Overlay> m_roi_overlays;//for selecting
+      std::vector<float> m_roi_overlays;//for selecting (overlay_ndata entries per ROI)
+      std::vector<LCROI> m_onaxis_roilist;//on-axis ROIs when using XSTable
     };
   };
 }
@@ -271,13 +292,7 @@ namespace NCrystal {
   {
     //Starts in same state as after calling Cache::reset()
   }
-  inline LCHelper::Overlay::Overlay() : data(0) {}
-  inline LCHelper::Overlay::~Overlay() { delete[] data; }
-  inline void LCHelper::Overlay::clear() { delete[] data; data = 0; }
-  inline void LCHelper::Overlay::prepareNullArray() { if (!data) { data = new float[ndata]; } std::memset(data,0,sizeof(float)*ndata); }
-  inline double LCHelper::Overlay::nonCommulVal(unsigned i) const { nc_assert(i<ndata); return i ? data[i]-(double)data[i-1] : (double)data[i]; }
-  inline LCHelper::Overlay::Overlay(LCHelper::Overlay&& o) { std::swap(data,o.data); }
-  inline LCHelper::Overlay& LCHelper::Overlay::operator=(LCHelper::Overlay&& o) { std::swap(data,o.data); return *this; }
+  inline double LCHelper::overlayNonCommulVal(const float* overlay, unsigned i) { nc_assert(i<overlay_ndata); return i ? overlay[i]-(double)overlay[i-1] : (double)overlay[i]; }
 
 }
 
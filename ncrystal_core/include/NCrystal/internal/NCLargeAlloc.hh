@@ -0,0 +1,46 @@
+#ifndef NCrystal_LargeAlloc_hh
+#define NCrystal_LargeAlloc_hh
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+//  This file is part of NCrystal (see https://mctools.github.io/ncrystal/)   //
+//                                                                            //
+//  Copyright 2015-2021 NCrystal developers                                   //
+//                                                                            //
+//  Licensed under the Apache License, Version 2.0 (the "License");           //
+//  you may not use this file except in compliance with the License.          //
+//  You may obtain a copy of the License at                                   //
+//                                                                            //
+//      http://www.apache.org/licenses/LICENSE-2.0                            //
+//                                                                            //
+//  Unless required by applicable law or agreed to in writing, software       //
+//  distributed under the License is distributed on an "AS IS" BASIS,         //
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  //
+//  See the License for the specific language governing permissions and       //
+//  limitations under the License.                                            //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include "NCrystal/NCDefs.hh"
+
+namespace NCrystal {
+
+  //Memory for large immutable tables which are accessed randomly (e.g. by
+  //sampling algorithms). If enabled by setting the NCRYSTAL_HUGEPAGES
+  //environment variable (and running on Linux), allocations of at least one
+  //huge page (2MiB) are made directly with mmap, aligned to 2MiB and advised
+  //to be backed by transparent huge pages (madvise(MADV_HUGEPAGE)), which
+  //reduces TLB misses. Whether the kernel actually provides huge pages depends
+  //on the system configuration (cf. /sys/kernel/mm/transparent_hugepage/). In
+  //all other cases, ordinary heap memory is used.
+  //
+  //The returned memory is uninitialised, suitably aligned for any fundamental
+  //type, and released when the last copy of the returned pointer goes away:
+
+  bool hugePagesEnabled();
+  std::shared_ptr<void> allocateLargeTable( std::size_t nbytes );
+
+}
+
+
+#endif
@@ -63,6 +63,11 @@ namespace NCrystal {
   double ncmin(double, double, double, double);
   double ncmax(double, double, double, double);
 
+  //Hint to the CPU that the memory at the given address will soon be read
+  //(no-op on compilers without support). Used to overlap memory accesses of
+  //independent lookups in batched code paths:
+  void ncprefetch(const void*);
+
   //Check that span contains values that could be a grid. I.e. is non-empty,
   //sorted, no duplicated values, no NaN/inf's.
   bool nc_is_grid(Span<const double>);
@@ -93,6 +98,18 @@ namespace NCrystal {
   double atan_approx(double x);//calling atan_smallarg_approx when |x|<0.442 and falling back to std::atan and exact results otherwise.
   double expm1_smallarg_approx(double x);//7th order Taylor expansion
 
+  //Evaluate std::exp, std::log or std::cos+std::sin for many values at once,
+  //in branch-free loops which the compiler can vectorise. Results agree with
+  //the std:: functions to within ~1e-15 (relative for exp/log, absolute for
+  //sincos), and input values outside the ranges covered by the kernels
+  //(e.g. exp(x) for |x|>708, log(x) for non-positive, subnormal or infinite x,
+  //sincos(x) for |x|>1e5, or NaN) are evaluated with the std:: functions.
+  //Output arrays must have the same size as the input, and may coincide with
+  //it (but not partially overlap):
+  void exp_many( Span<const double> x, double* out );
+  void log_many( Span<const double> x, double* out );
+  void sincos_many( Span<const double> x, double* out_cos, double* out_sin );
+
   //Evaluate erfc(a)-erfc(b) in a relatively numerically safe
   //manner and with as few actual calls to std::erfc as possible:
   double erfcdiff(double a, double b);
@@ -273,6 +290,15 @@ inline double NCrystal::ncabs(double a) { return std::abs(a); }
 inline bool NCrystal::ncisnan(double a) { return std::isnan(a); }
 inline bool NCrystal::ncisinf(double a) { return std::isinf(a); }
 
+inline void NCrystal::ncprefetch(const void* p)
+{
+#if defined(__GNUC__) || defined(__clang__)
+  __builtin_prefetch(p);
+#else
+  (void)p;
+#endif
+}
+
 inline double NCrystal::ncclamp(double val, double low, double up)
 {
   nc_assert(up>=low);
@@ -0,0 +1,69 @@
+#ifndef NCrystal_NCMATBinary_hh
+#define NCrystal_NCMATBinary_hh
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+//  This file is part of NCrystal (see https://mctools.github.io/ncrystal/)   //
+//                                                                            //
+//  Copyright 2015-2021 NCrystal developers                                   //
+//                                                                            //
+//  Licensed under the Apache License, Version 2.0 (the "License");           //
+//  you may not use this file except in compliance with the License.          //
+//  You may obtain a copy of the License at                                   //
+//                                                                            //
+//      http://www.apache.org/licenses/LICENSE-2.0                            //
+//                                                                            //
+//  Unless required by applicable law or agreed to in writing, software       //
+//  distributed under the License is distributed on an "AS IS" BASIS,         //
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  //
+//  See the License for the specific language governing permissions and       //
+//  limitations under the License.                                            //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include "NCrystal/NCNCMATData.hh"
+#include "NCrystal/NCTextData.hh"
+
+namespace NCrystal {
+
+  //Binary companion format of the NCMAT format (data type "ncmatbin",
+  //conventional file extension ".ncmatbin"), which can be loaded much faster
+  //than the .ncmat text format, since no string-to-double conversions are
+  //needed (this in particular matters for large @DYNINFO sections). Binary
+  //files are produced from NCMATData objects (normally parsed from .ncmat
+  //files, e.g. with the ncrystal_ncmat2bin command), and parseNCMATData will
+  //transparently decode such data, so it can be used anywhere .ncmat data is
+  //accepted.
+  //
+  //The data starts with an ASCII preamble, consisting of the magic string
+  //"\x89NCMATBIN" on the first line, followed by any lines from the original
+  //file containing NCRYSTALMATCFG (so embedded configuration is preserved),
+  //and a terminating null character. Thus, TextData iterators will only ever
+  //see the preamble. The binary payload follows after zero-padding to an
+  //8-byte boundary, and begins with a 32-bit endianness tag and a format
+  //version. Data produced on platforms of the opposite endianness is
+  //byte-swapped when read, while data with a different format version is
+  //rejected (and must be regenerated from the original .ncmat file).
+
+  constexpr unsigned ncmatBinaryFormatVersion = 1;
+
+  //Check if data starts with the magic bytes of the binary format:
+  bool isNCMATBinaryData( const char * dataBegin, const char * dataEnd ) noexcept;
+
+  //Encode NCMATData (remembering any extra preamble lines):
+  std::string encodeNCMATBinary( const NCMATData&, const VectS& preambleLines = {} );
+
+  //Convenience function for parsing NCMAT data and converting the result to
+  //the binary format, preserving any NCRYSTALMATCFG lines:
+  std::string convertToNCMATBinary( const TextData& );
+
+  //Same, but writing the result to a file (throws DataLoadError on failure):
+  void writeNCMATBinaryFile( const TextData&, const std::string& path );
+
+  //Decode binary data (usually invoked via parseNCMATData). Throws BadInput in
+  //case of invalid or unsupported data:
+  NCMATData decodeNCMATBinary( const TextData&, bool doFinalValidation = true );
+
+}
+
+#endif
@@ -37,16 +37,19 @@ namespace NCrystal {
 
     const char * name() const noexcept final { return "PCBragg"; }
 
-    //Constructor:
-    PCBragg( const Info& );
+    //Constructor. If dbintol>0, planes are grouped into bins of d-spacings,
+    //each bin spanning at most the relative tolerance dbintol below its largest
+    //d-spacing, at which all contributions of the bin are placed (see the
+    //dbintol parameter in NCMatCfg.hh):
+    PCBragg( const Info&, double dbintol = 0.0 );
 
     //Specialised constructors taking (dspacing,fsquared*multiplicity) pairs.
     //Either needs structure info, or just v0*n_atoms, unit cell volume in Aa^3
     //and number atoms per unit cell:
 
     using VectDFM = std::vector<PairDD>;
-    PCBragg( const StructureInfo&, VectDFM&& );
-    PCBragg( double v0_times_natoms, VectDFM&& );
+    PCBragg( const StructureInfo&, VectDFM&&, double dbintol = 0.0 );
+    PCBragg( double v0_times_natoms, VectDFM&&, double dbintol = 0.0 );
 
     //There is a maximum wavelength at which Bragg diffraction is possible, so
     //lower energy bound will reflect this (upper bound is infinity):
@@ -54,6 +57,24 @@ namespace NCrystal {
 
     CrossSect crossSectionIsotropic(CachePtr&, NeutronEnergy ) const final;
     ScatterOutcomeIsotropic sampleScatterIsotropic(CachePtr&, RNG&, NeutronEnergy ) const final;
+    void evalManyXSIsotropic( CachePtr&, const double* ekin, std::size_t N,
+                              double* out_xs ) const final;
+    void sampleScatterIsotropicMany( CachePtr&, RNG&, double* ekin, std::size_t N,
+                                     double* out_mu ) const final;
+    //Native biased sampling, restricted to planes scattering into the window:
+    BiasedScatterOutcomeIsotropic sampleScatterIsotropicBiased( CachePtr&, RNG&, NeutronEnergy,
+                                                                const ScatterWindow& ) const final;
+    CrossSect majorantCrossSection( EnergyDomain ) const final;
+    void accountMemory( MemoryFootprint& ) const final;
+
+    //Energies of the Bragg edges (in increasing order), at which the cross
+    //section is discontinuous:
+    const VectD& braggEdgeEnergies() const noexcept { return m_2dE; }
+
+    //Cumulative contributions of the planes (ordered as the Bragg edges), such
+    //that the cross section for energies just above the i'th edge is
+    //braggEdgeCommulXS()[i]/ekin:
+    const VectD& braggEdgeCommulXS() const noexcept { return m_fdm_commul; }
 
     //Two PCBragg instances can be merged by merging the plane lists:
     std::shared_ptr<Process> createMerged( const Process& ) const override;
@@ -62,13 +83,35 @@ namespace NCrystal {
     PCBragg( no_init_t ) {}
 
   protected:
-    CosineScatAngle genScatterMu(RNG&, NeutronEnergy ekin) const;
+    CosineScatAngle genScatterMu(RNG&, NeutronEnergy ekin, std::size_t idx) const;
     std::size_t findLastValidPlaneIdx( NeutronEnergy ekin) const;
+    std::size_t findLastValidPlaneIdx( std::size_t& lastidx, double ekin ) const;
+    //Batched version for N<=64 energies, with the searches interleaved. Only
+    //entries with ekin[i]>=m_threshold are filled into out_idx:
+    void findLastValidPlaneIdxMany( std::size_t& lastidx, const double* ekin,
+                                    std::size_t N, std::size_t* out_idx ) const;
+    //Single merge pass over energies sorted in ascending or descending order
+    //(e.g. a wavelength or TOF grid), walking the Bragg edges along with the
+    //energies rather than searching for each of them. Returns false (without
+    //touching out_xs) if the energies are not monotonic:
+    bool evalManyXSSorted( std::size_t& lastidx, const double* ekin, std::size_t N,
+                           double* out_xs ) const;
     NeutronEnergy m_threshold = NeutronEnergy{kInfinity};
     VectD m_2dE;
     VectD m_fdm_commul;
-    void init( const StructureInfo&, VectDFM&& );
-    void init( double v0_times_natoms, VectDFM&& );
+    void init( const StructureInfo&, VectDFM&&, double dbintol );
+    void init( double v0_times_natoms, VectDFM&&, double dbintol );
+
+    //Copies of m_2dE and m_fdm_commul in Eytzinger (breadth-first, 1-based)
+    //layout, which makes the searches cache-friendly and branch-free even for
+    //long plane lists. The permutation vector maps positions back to indices
+    //in the sorted vectors (with entry 0 holding the "not found" value
+    //m_2dE.size()). Must be rebuilt with initSearchIndex() whenever m_2dE or
+    //m_fdm_commul changes:
+    VectD m_eytz_2dE;
+    VectD m_eytz_fdm;
+    std::vector<std::uint32_t> m_eytz_perm;
+    void initSearchIndex();
   };
 
 }
@@ -48,6 +48,28 @@ namespace NCrystal {
     //return value here usually indicates incomplete information for normals to
     //be provided:
     virtual bool canProvide() const = 0;
+
+    //Bulk alternative to looping with getNextPlane, providing all planes of a
+    //complete loop at once in contiguous arrays (entry i of each array refers
+    //to the same plane). The default implementation simply calls prepareLoop
+    //and loops with getNextPlane, but implementations can provide faster
+    //versions. The list is cleared before it is filled:
+    struct PlaneList {
+      VectD dspacings;
+      VectD fsquareds;
+      std::vector<Vector> demi_normals;
+      std::size_t size() const noexcept { return dspacings.size(); }
+      bool empty() const noexcept { return dspacings.empty(); }
+      void clear() noexcept { dspacings.clear(); fsquareds.clear(); demi_normals.clear(); }
+      void reserve( std::size_t n ) { dspacings.reserve(n); fsquareds.reserve(n); demi_normals.reserve(n); }
+      void add( double dsp, double fsq, const Vector& dn )
+      {
+        dspacings.push_back(dsp);
+        fsquareds.push_back(fsq);
+        demi_normals.push_back(dn);
+      }
+    };
+    virtual void getAllPlanes( PlaneList& );
   };
 
   //Creates standard plane provider from Info object, which will attempt various
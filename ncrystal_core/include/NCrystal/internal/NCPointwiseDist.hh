@@ -22,6 +22,7 @@
 ////////////////////////////////////////////////////////////////////////////////
 
 #include "NCrystal/NCDefs.hh"
+#include "NCrystal/internal/NCSpan.hh"
 
 namespace NCrystal {
   //Class which provides random sampling of a 1D piece-wise linear
@@ -29,6 +30,13 @@ namespace NCrystal {
   //values on a given set of points, which must be specified in
   //ascending order. The integral_weight parameter is only used when
   //merging two distributions.
+  //
+  //For distributions with more than a few points, a guide table (the indexed
+  //search of Chen and Asau) is built alongside the CDF, which for each of N
+  //equal-probability intervals holds the first CDF bin which might contain
+  //percentiles in that interval. This narrows the binary search for a given
+  //percentile value down to (typically) one or two bins, while still giving
+  //results identical to a search over the full CDF.
   class PointwiseDist {
   public:
     PointwiseDist(const VectD &x, const VectD &y, double integral_weight=1.0 );
@@ -39,6 +47,10 @@ namespace NCrystal {
     //Sample:
     double sample(RNG& rng) const { return percentileWithIndex(rng()).first; }
 
+    //Sample out.size() values in one go (consuming random numbers in the same
+    //way as repeated calls to sample(..)):
+    void sampleMany( RNG& rng, Span<double> out ) const;
+
     PointwiseDist& operator+=(const PointwiseDist&);
     PointwiseDist& operator*=(double frac);
     void setIntegralWeight(double);
@@ -47,6 +59,14 @@ namespace NCrystal {
     const VectD& getXVals() const { return m_x; }
     const VectD& getYVals() const { return m_y; }
 
+    //Access to remaining internal state, and reconstruction of an identical
+    //instance from it (for persistency, minimal validation only):
+    const VectD& getCDFVals() const { return m_cdf; }
+    double getIntegralWeight() const { return m_iweight; }
+    std::size_t approxMemoryUsage() const;
+    static PointwiseDist createFromInternalData( VectD&& x, VectD&& y, VectD&& cdf,
+                                                 double integral_weight );
+
     //Convenience constructor (would not be needed if we had C++17's std::make_from_tuple):
     PointwiseDist(const std::pair<VectD,VectD>& xy, double integral_weight=1.0 )
       : PointwiseDist(xy.first,xy.second,integral_weight) {}
@@ -58,6 +78,8 @@ namespace NCrystal {
     std::pair<double,unsigned> sampleWithIndex( RNG& rng ) const { return percentileWithIndex(rng()); }
 
   private:
+    struct internal_data_t {};
+    PointwiseDist( internal_data_t, VectD&& x, VectD&& y, VectD&& cdf, double iw );
     //todo: We have both m_cdf and m_y, although they essentially contain the
     //same info. Could we implement more light-weight version? Could we
     //implement as a non-owning view, i.e. which keeps m_x in span (but likely
@@ -66,6 +88,9 @@ namespace NCrystal {
     VectD m_x;
     VectD m_y;
     double m_iweight;
+    std::vector<uint32_t> m_guide;//empty if not used
+    void initGuide();
+    std::size_t findBin( double p ) const;
   };
 }
 
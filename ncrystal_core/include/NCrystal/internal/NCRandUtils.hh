@@ -37,9 +37,31 @@ namespace NCrystal {
   NeutronDirection randIsotropicNeutronDirection( RNG& );
   NeutronDirection randNeutronDirectionGivenScatterMu( RNG&, double mu, const Vector& in );
 
+  //Whether the environment variable NCRYSTAL_LEGACY_RNG_SAMPLING=1 is set, in
+  //which case batched sampling methods must consume random numbers exactly as
+  //repeated calls to their scalar counterparts would (e.g. for regression
+  //tests against earlier NCrystal releases):
+  bool useLegacyRandSampling();
+
+  //Batched version of randNeutronDirectionGivenScatterMu, rotating N directions
+  //(given as separate arrays of x, y and z components) in place. Azimuthal
+  //angles are sampled directly rather than with rejection loops, so results
+  //(and consumption of random numbers) differ from those of the scalar
+  //version (unless useLegacyRandSampling() is true, in which case the scalar
+  //version is used for each direction):
+  void randNeutronDirectionsGivenScatterMu( RNG&, const double* mu,
+                                            double* ux, double* uy, double* uz,
+                                            std::size_t N );
+
   //Sample a random point on the unit circle:
   PairDD randPointOnUnitCircle( RNG& );
 
+  //Batched version, sampling N points (cosphi,sinphi) on the unit circle
+  //without rejection loops (i.e. consuming exactly N random numbers), unless
+  //useLegacyRandSampling() is true (in which case randPointOnUnitCircle is used
+  //for each point):
+  void randPointsOnUnitCircle( RNG&, std::size_t N, double* cosphi, double* sinphi );
+
   //Sample one or two independent values from a unit Gaussian:
   double randNorm( RNG& );
   void randNorm( RNG&, double&g1, double&g2);
@@ -69,6 +91,44 @@ namespace NCrystal {
     double m_a, m_c1, m_c2;
   };
 
+  class RandAliasSampler {
+  public:
+    //Pick index according to (non-negative, non-commulative) weights in O(1)
+    //time, using the alias method of Walker (with the construction algorithm
+    //of Vose). Entries with vanishing weights are never picked. Only a single
+    //random number is consumed per call.
+    RandAliasSampler() = default;//invalid instance (size()=0)
+    RandAliasSampler( Span<const double> weights );
+    std::size_t sample(RNG&rng) const;
+    std::size_t size() const { return m_prob.size(); }
+
+    //Access internal tables, and reconstruct from them (for persistency):
+    const VectD& internalProbs() const { return m_prob; }
+    const std::vector<uint32_t>& internalAliases() const { return m_alias; }
+    static RandAliasSampler createFromInternalData( VectD&& probs, std::vector<uint32_t>&& aliases );
+  private:
+    VectD m_prob;
+    std::vector<uint32_t> m_alias;
+  };
+
+  class CachedRandIdxPicker {
+  public:
+    //For picking indices repeatedly according to the same commulative weights
+    //(e.g. kept in a cache object). Initially picks are done with
+    //pickRandIdxByWeight, but if the weights are reused sufficiently many
+    //times, an alias table (see RandAliasSampler) is built and used for
+    //subsequent O(1) picks. The invalidate() method MUST be called whenever
+    //the weights change. Alias tables are not used when
+    //useLegacyRandSampling() is true.
+    void invalidate() noexcept { m_npicks = 0; }
+    std::size_t pick( RNG&, Span<const double> commulvals );
+  private:
+    static constexpr unsigned s_npicks_before_build = 8;
+    unsigned m_npicks = 0;
+    RandAliasSampler m_sampler;
+    std::size_t buildAndPick( RNG&, Span<const double> commulvals );
+  };
+
   //Sample f(x) = exp(-c*x)/sqrt(x) on [a,b], a>=0 b>a, c>0:
   double randExpDivSqrt( RNG&, double c, double a, double b );
 
@@ -91,6 +151,7 @@ namespace NCrystal {
 #endif
 
     double generate();// uniformly in ]0,1]
+    void generateMany( std::size_t n, double* tgt );//n calls to generate()
     uint64_t genUInt64();//uniformly over 0..uint64max-1 (i.e. all bits randomised)
     uint32_t genUInt32();//uniformly over 0..uint32max-1 (i.e. all bits randomised)
     bool coinflip();
@@ -99,6 +160,8 @@ namespace NCrystal {
     const state_t& state() const noexcept  { return m_s; }
     state_t& state() noexcept { return m_s; }
     void jump();
+    void jump( uint64_t n );//same as n calls to jump(), but in O(log(n)) time
+    void longJump();//same as 2^32 calls to jump()
 
     //Internal functions, exposed solely for the purpose of unit tests:
     static uint64_t splitmix64(uint64_t& state);
@@ -175,6 +238,28 @@ inline double NCrystal::RandExpIntervalSampler::sample(RNG&rng) const
   return m_a + m_c1 * std::log( 1.0 + rng.generate() * m_c2 );
 }
 
+inline std::size_t NCrystal::RandAliasSampler::sample(RNG&rng) const
+{
+  nc_assert(!m_prob.empty());
+  const std::size_t n = m_prob.size();
+  const double u = rng.generate() * n;
+  std::size_t i = std::min<std::size_t>( static_cast<std::size_t>(u), n-1 );
+  return ( u - i ) < m_prob[i] ? i : m_alias[i];
+}
+
+inline std::size_t NCrystal::CachedRandIdxPicker::pick( RNG& rng, Span<const double> commulvals )
+{
+  if ( m_npicks > s_npicks_before_build ) {
+    nc_assert( m_sampler.size() == static_cast<std::size_t>(commulvals.size()) );
+    return m_sampler.sample(rng);
+  }
+  if ( m_npicks < s_npicks_before_build ) {
+    ++m_npicks;
+    return pickRandIdxByWeight( rng, commulvals );
+  }
+  return buildAndPick( rng, commulvals );
+}
+
 inline double NCrystal::randExpInterval( RNG& rng, double a, double b, double c )
 {
   return RandExpIntervalSampler(a,b,c).sample(rng);
@@ -196,6 +281,23 @@ inline double NCrystal::RandXRSRImpl::generate()
   return randUInt64ToFP01( genUInt64WithBadLowerBits() );
 }
 
+inline void NCrystal::RandXRSRImpl::generateMany( std::size_t n, double* tgt )
+{
+  //Same as genUInt64WithBadLowerBits, but keeping the state in local
+  //variables to avoid store/reload in every iteration:
+  uint64_t s0 = m_s[0];
+  uint64_t s1 = m_s[1];
+  for ( std::size_t i = 0; i < n; ++i ) {
+    const uint64_t result = s0 + s1;
+    s1 ^= s0;
+    s0 = ((s0 << 55) | (s0 >> 9)) ^ s1 ^ (s1 << 14);
+    s1 = (s1 << 36) | (s1 >> 28);
+    tgt[i] = randUInt64ToFP01( result );
+  }
+  m_s[0] = s0;
+  m_s[1] = s1;
+}
+
 inline uint64_t NCrystal::RandXRSRImpl::genUInt64()
 {
   //Since lower 3 bits in generator output have unwanted correlations, we simply
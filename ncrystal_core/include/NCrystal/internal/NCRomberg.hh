@@ -39,14 +39,21 @@ namespace NCrystal {
     virtual double evalFunc(double) const = 0;
 
     //However, as integration will internally always evaluate the function at 16
-    //or more equally spaced points at once, it might occasionally be more
-    //efficient to evaluate the function at all of these points in a coherent
-    //manner. In case this is desired, the user must override evalFuncMany and
-    //evalFuncSum instead (due to the nature of C++, evalFunc will still have to
-    //be implemented - however this can be a dummy implementation throwing an
-    //exception in case of anyone calling it accidentally):
+    //or more equally spaced points at once, it is often more efficient to
+    //evaluate the function at all of these points in a coherent (and
+    //vectorisable) manner. In case this is desired, the user should override
+    //evalFuncMany, which will then be used for all function evaluations: The
+    //new points of each refinement level are passed in a single call (levels
+    //with more than maxBatchSize new points are split into consecutive calls
+    //of that size). Due to the nature of C++, evalFunc will still have to be
+    //implemented - however this can be a dummy implementation throwing an
+    //exception in case of anyone calling it accidentally:
 
     virtual void evalFuncMany(double* fvals, unsigned n, double offset, double delta) const;
+    static constexpr unsigned maxBatchSize = 256;
+
+    //Sum of the function at n equally spaced points. The default implementation
+    //uses evalFuncMany, so there is usually no need to override it:
     virtual double evalFuncManySum(unsigned n, double offset, double delta) const;
 
     //Users should override this in order to change heuristics of when to stop
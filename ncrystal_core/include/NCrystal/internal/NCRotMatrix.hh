@@ -55,6 +55,15 @@ namespace NCrystal {
     RotMatrix& operator=(Matrix&& o);
 
     Vector operator*(const Vector&) const;
+
+    //Multiply N vectors provided as separate arrays of x, y and z coordinates
+    //(structure-of-arrays), with results identical to those of operator*. The
+    //output arrays may be identical to the input arrays (in-place operation),
+    //but must otherwise not overlap with them:
+    void rotateMany( const double* x, const double* y, const double* z,
+                     double* out_x, double* out_y, double* out_z,
+                     std::size_t N ) const;
+
     const Vector& colX() const;
     const Vector& colY() const;
     const Vector& colZ() const;
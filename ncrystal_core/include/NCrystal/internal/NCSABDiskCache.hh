@@ -0,0 +1,119 @@
+#ifndef NCrystal_SABDiskCache_hh
+#define NCrystal_SABDiskCache_hh
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+//  This file is part of NCrystal (see https://mctools.github.io/ncrystal/)   //
+//                                                                            //
+//  Copyright 2015-2021 NCrystal developers                                   //
+//                                                                            //
+//  Licensed under the Apache License, Version 2.0 (the "License");           //
+//  you may not use this file except in compliance with the License.          //
+//  You may obtain a copy of the License at                                   //
+//                                                                            //
+//      http://www.apache.org/licenses/LICENSE-2.0                            //
+//                                                                            //
+//  Unless required by applicable law or agreed to in writing, software       //
+//  distributed under the License is distributed on an "AS IS" BASIS,         //
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  //
+//  See the License for the specific language governing permissions and       //
+//  limitations under the License.                                            //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include "NCrystal/internal/NCSABSamplerModels.hh"
+#include "NCrystal/internal/NCScatKnlData.hh"
+
+namespace NCrystal {
+
+  namespace SAB {
+
+    //Opt-in persistent on-disk cache for the tables built by SABIntegrator,
+    //intended for jobs where many processes would otherwise rebuild the same
+    //tables. It is enabled by setting the NCRYSTAL_SAB_CACHEDIR environment
+    //variable to the path of an existing directory. Files are keyed by a
+    //content hash of the SABData, the requested energy grid, the sampler type
+    //and the NCrystal version, and contain the energy grid, cross sections
+    //and SABSamplerAtE instances in a compact native binary format (so cache
+    //directories should not be shared between machines with different
+    //architectures). Files are written atomically (via renaming of a
+    //temporary file), so concurrent jobs can safely share a directory.
+    //
+    //The same entries can also be bundled into a single snapshot file (see
+    //below), and entries from loaded snapshots are used in preference to
+    //those in the cache directory (a cache directory is not required for
+    //this).
+    //
+    //Returns key of the cache entry (i.e. the file name inside the cache
+    //directory), or an empty string if neither the cache directory nor
+    //snapshots are in use (the last parameter must be
+    //CommonCache::isSinglePrecision()):
+    std::string diskCacheKey( const SABData&, const VectD& egrid_input, SamplerAtEType,
+                              bool singlePrecisionTables );
+
+    //Attempt to load entry (returns false if the entry is absent or
+    //unusable). The CommonCache must be the one derived from the same SABData:
+    bool loadFromDiskCache( const std::string& key,
+                            std::shared_ptr<const SABSamplerAtE_Alg1::CommonCache>,
+                            VectD& out_egrid,
+                            VectD& out_xsvals,
+                            std::vector<std::unique_ptr<SABSamplerAtE>>& out_samplers );
+
+    //Store entry (failures only trigger a warning):
+    void saveToDiskCache( const std::string& key,
+                          const VectD& egrid,
+                          const VectD& xsvals,
+                          const std::vector<std::unique_ptr<SABSamplerAtE>>& samplers );
+
+    //Move the large logsab and alphaintegrals_cumul tables of the CommonCache
+    //into a read-only memory mapped file in the same directory (written first
+    //if needed), so that all processes on a machine share a single physical
+    //copy. Returns a new CommonCache referring to the mapped memory, or simply
+    //returns the input CommonCache if the cache is not enabled or the mapping
+    //failed:
+    std::shared_ptr<const SABSamplerAtE_Alg1::CommonCache>
+    mapSharedCommonCache( std::shared_ptr<const SABSamplerAtE_Alg1::CommonCache> );
+
+    //Similarly for the S(alpha,beta) tables resulting from expansion of a VDOS
+    //(empty key if caching is not in use, nullptr if entry is not available):
+    std::string expandedVDOSCacheKey( const VDOSData&, unsigned vdoslux, double requestedEmax,
+                                      double vdosthintol );
+    std::shared_ptr<const SABData> loadExpandedVDOSFromDiskCache( const std::string& key );
+    void saveExpandedVDOSToDiskCache( const std::string& key, const SABData& );
+
+    //And for the S(alpha,beta) tables resulting from validation and conversion
+    //of kernels provided directly in NCMAT files (e.g. "sab_scaled"). Most of
+    //the time for these is spent decoding the kernel table from text, so the
+    //key is based on the raw text [tableBegin,tableEnd) of the table rather
+    //than on its decoded values (the sab field of the ScatKnlData is ignored):
+    std::string convertedKernelCacheKey( const ScatKnlData&, const char * tableBegin, const char * tableEnd );
+    std::shared_ptr<const SABData> loadConvertedKernelFromDiskCache( const std::string& key );
+    void saveConvertedKernelToDiskCache( const std::string& key, const SABData& );
+
+    //Snapshots. While recording, all entries loaded or stored by the functions
+    //above are collected, and endSnapshotRecording then writes them into a
+    //single file (or simply discards them if the path is empty). Loading a
+    //snapshot file (memory mapped when possible) makes its entries available
+    //for the rest of the process lifetime. Errors result in exceptions:
+    void beginSnapshotRecording();
+    void endSnapshotRecording( const std::string& path );
+    std::string endSnapshotRecordingToMemory();//returns content instead
+    void loadSnapshot( const std::string& path );
+
+    //Load snapshot from data in memory, which must remain valid for the rest
+    //of the process lifetime (e.g. static data embedded in a library):
+    void loadSnapshotFromMemory( const char * data, std::size_t size );
+
+    //Other kinds of derived data can also be included in snapshots (but not in
+    //the cache directory), using keys which do not clash with those above. Keys
+    //must consist of a prefix ending in an underscore followed by a unique
+    //part, and snapshotsMightUse(prefix) returns false when there is no need
+    //to calculate (the unique part of) the key at all:
+    bool snapshotsMightUse( const char * keyprefix );//see below
+    Optional<std::string> findSnapshotEntry( const std::string& key );
+    void recordSnapshotEntry( const std::string& key, const std::string& data );
+  }
+
+}
+
+#endif
@@ -0,0 +1,100 @@
+#ifndef NCrystal_SABEGridIndex_hh
+#define NCrystal_SABEGridIndex_hh
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+//  This file is part of NCrystal (see https://mctools.github.io/ncrystal/)   //
+//                                                                            //
+//  Copyright 2015-2021 NCrystal developers                                   //
+//                                                                            //
+//  Licensed under the Apache License, Version 2.0 (the "License");           //
+//  you may not use this file except in compliance with the License.          //
+//  You may obtain a copy of the License at                                   //
+//                                                                            //
+//      http://www.apache.org/licenses/LICENSE-2.0                            //
+//                                                                            //
+//  Unless required by applicable law or agreed to in writing, software       //
+//  distributed under the License is distributed on an "AS IS" BASIS,         //
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  //
+//  See the License for the specific language governing permissions and       //
+//  limitations under the License.                                            //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include "NCrystal/internal/NCMath.hh"
+
+namespace NCrystal {
+
+  namespace SAB {
+
+    //Energy grid of an SABXSProvider/SABSampler pair, along with a precomputed
+    //index for fast bin lookup. The index divides [egrid.front(),egrid.back()]
+    //into buckets of equal width in log(E), each remembering the range of grid
+    //points it might contain, so a lookup is a logarithm followed by a search
+    //over a handful of points. The same instance is normally shared between
+    //the xsprovider and sampler of a kernel, so the bin found for a given
+    //energy can be reused by both.
+
+    class EGridIndex final : private NoCopyMove {
+    public:
+      EGridIndex( VectD&& egrid );//must be positive, sorted and non-empty
+      ~EGridIndex();
+
+      const VectD& grid() const { return m_egrid; }
+
+      //Index of first grid point above ekin (i.e. same as std::upper_bound):
+      std::size_t bin( double ekin ) const;
+
+      //Same as bin(..) for N energies at once. The lookups are carried out in
+      //small groups, with the memory accesses of each group interleaved (and
+      //prefetched) to hide their latency:
+      void binMany( const double* ekin, std::size_t N, std::size_t* out_bins ) const;
+
+      //Same as binMany(..), but for non-decreasing energies (e.g. when
+      //tabulating cross sections on an energy grid). Rather than performing an
+      //independent lookup for each energy, the grid is traversed from the bin
+      //of the previous energy:
+      void binManySorted( const double* ekin, std::size_t N, std::size_t* out_bins ) const;
+
+      //Approximate memory footprint in bytes:
+      std::size_t approxMemoryUsage() const;
+
+    private:
+      VectD m_egrid;
+      std::vector<std::pair<uint32_t,uint32_t>> m_buckets;//range of grid indices
+      double m_logEmin = 0.0;
+      double m_invLogBucketWidth = 0.0;
+      std::size_t binSlow( double ekin ) const
+      {
+        return std::upper_bound( m_egrid.begin(), m_egrid.end(), ekin ) - m_egrid.begin();
+      }
+    };
+
+  }
+
+}
+
+////////////////////////////
+// Inline implementations //
+////////////////////////////
+
+inline std::size_t NCrystal::SAB::EGridIndex::bin( double ekin ) const
+{
+  const std::size_t n = m_egrid.size();
+  if ( !( ekin >= m_egrid.front() ) )
+    return 0;//also handles NaN
+  if ( ekin >= m_egrid.back() )
+    return n;
+  const double x = ( std::log( ekin ) - m_logEmin ) * m_invLogBucketWidth;
+  const std::size_t ib = ncmin( static_cast<std::size_t>( ncmax( 0.0, x ) ), m_buckets.size() - 1 );
+  //Bucket edges were widened slightly during construction, so rounding errors
+  //in the log above can never push the answer outside the range:
+  const auto& b = m_buckets[ib];
+  auto itB = m_egrid.begin() + b.first;
+  auto itE = m_egrid.begin() + b.second;
+  const std::size_t res = std::upper_bound( itB, itE, ekin ) - m_egrid.begin();
+  nc_assert( res == binSlow( ekin ) );
+  return res;
+}
+
+#endif
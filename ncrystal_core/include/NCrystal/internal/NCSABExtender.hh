@@ -51,6 +51,14 @@ namespace NCrystal {
     class SABFGExtender : public SABExtender {
     public:
       //Extend with single target type FreeGas model.
+      //
+      //As sampling of the free gas beta distribution is expensive, and since
+      //the extender is typically used for all scatterings above the energy
+      //range of the tabulated kernel (e.g. during slowing down of fast
+      //neutrons), beta values are sampled from the shared precomputed tables
+      //of FreeGasBetaTable (for both the standard and the high-energy range of
+      //c=E/kT). The tables only depend on the target mass, and are created
+      //upon first usage.
       SABFGExtender( Temperature, AtomMass, SigmaBound );
       SABFGExtender( Temperature, AtomMass, SigmaFree );
       virtual ~SABFGExtender();
@@ -60,6 +68,9 @@ namespace NCrystal {
       FreeGasXSProvider m_xsprovider;
       Temperature m_t;
       AtomMass m_m;
+      struct BetaTables;
+      std::unique_ptr<BetaTables> m_betaTables;
+      const FreeGasBetaTable* betaTable( double c ) const;
     };
 
   }
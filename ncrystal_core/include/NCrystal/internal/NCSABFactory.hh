@@ -28,14 +28,19 @@ namespace NCrystal {
 
   namespace SAB {
 
-    //Direct factory function with no caching:
+    //Direct factory function with no caching (see NCSABIntegrator.hh for the
+    //meaning of the sampler type and single precision flag):
     std::unique_ptr<const SABScatterHelper> createScatterHelper( shared_obj<const SABData>,
-                                                                 std::shared_ptr<const VectD> energyGrid = nullptr );
+                                                                 std::shared_ptr<const VectD> energyGrid = nullptr,
+                                                                 SamplerAtEType = SamplerAtEType::Alg1,
+                                                                 bool singlePrecisionTables = false );
 
     //Same with caching:
     void clearScatterHelperCache();
     shared_obj<const SABScatterHelper> createScatterHelperWithCache( shared_obj<const SABData>,
-                                                                     std::shared_ptr<const VectD> energyGrid = nullptr );
+                                                                     std::shared_ptr<const VectD> energyGrid = nullptr,
+                                                                     SamplerAtEType = SamplerAtEType::Alg1,
+                                                                 bool singlePrecisionTables = false );
 
     //For caching reasons, we keep a database of energy grid's and an associated
     //unique id. Note that it is expected that most energy grids specified will
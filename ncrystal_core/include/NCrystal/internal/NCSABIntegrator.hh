@@ -41,18 +41,29 @@ namespace NCrystal {
       //
       //If a SABExtender is not provided, a default single-target free gas
       //extender will be used.
+      //
+      //The samplerType parameter selects the algorithm used for sampling
+      //(alpha,beta) at each energy grid point (see NCSABSamplerModels.hh), and
+      //singlePrecisionTables whether the large derived tables are kept in
+      //single precision (see SABSamplerAtE_Alg1::CommonCache).
 
       //Both constructors and destructors of the SABIntegrator are light-weight,
       //and it is safe and recommended to end the life of SABIntegrator after
       //the desired createXXX method has been called. SABIntegrators are not
       //MT-safe, so should not be shared between threads.
       //
+      //The analysis of the individual energy grid points is internally shared
+      //between the number of threads given by getNThreadsFromEnv() (see
+      //NCThreadUtils.hh). This does not affect the results.
+      //
 
     public:
       ~SABIntegrator();
       SABIntegrator( shared_obj<const SABData>,
                      const VectD* egrid = nullptr,
-                     std::shared_ptr<const SABExtender> sabextender = nullptr );
+                     std::shared_ptr<const SABExtender> sabextender = nullptr,
+                     SamplerAtEType samplerType = SamplerAtEType::Alg1,
+                     bool singlePrecisionTables = false );
 
       SABXSProvider createXSProvider() { SABXSProvider o; doit(&o,nullptr); return o; }
       SABSampler createSampler() { SABSampler o; doit(nullptr,&o); return o; }
@@ -23,9 +23,16 @@
 
 #include "NCrystal/NCSABData.hh"
 #include "NCrystal/internal/NCSABExtender.hh"
+#include "NCrystal/internal/NCSABEGridIndex.hh"
 
 namespace NCrystal {
 
+  namespace SAB {
+    //Choice of SABSamplerAtE implementation used at each energy grid point
+    //(see NCSABSamplerModels.hh):
+    enum class SamplerAtEType { Alg1, AliasTable };
+  }
+
   class SABSamplerAtE : private NoCopyMove {
     //For sampling (alpha,beta) values at a given energy, Ei, or lower. This
     //is intended to be implemented with the rejection method, taking
@@ -38,6 +45,10 @@ namespace NCrystal {
   public:
     virtual PairDD sampleAlphaBeta(double ekin_div_kT, RNG&) const = 0;
     virtual ~SABSamplerAtE() = default;
+    //Approximate memory footprint in bytes (excluding shared data):
+    virtual std::size_t approxMemoryUsage() const { return sizeof(SABSamplerAtE); }
+    //Account any shared data (not included in approxMemoryUsage()):
+    virtual void accountSharedMemory( MemoryFootprint& ) const {}
   };
 
   class SABSampler final : private MoveOnly {
@@ -49,6 +60,13 @@ namespace NCrystal {
                   std::shared_ptr<const SAB::SABExtender>,
                   double xsAtEmax );
 
+    //Version which shares the energy grid (and its index) with an xsprovider:
+    void setData( Temperature temperature,
+                  std::shared_ptr<const SAB::EGridIndex>,
+                  std::vector<std::unique_ptr<SABSamplerAtE>>&&,
+                  std::shared_ptr<const SAB::SABExtender>,
+                  double xsAtEmax );
+
     SABSampler( Temperature temperature,
                 VectD&& egrid,
                 std::vector<std::unique_ptr<SABSamplerAtE>>&&,
@@ -64,17 +82,44 @@ namespace NCrystal {
     //Convenience (calls sampleAlphaBeta, then converts):
     PairDD sampleDeltaEMu( NeutronEnergy, RNG& rng) const;
 
+    //Index of first grid point above ekin (i.e. std::upper_bound), and
+    //sampling when that is already known (e.g. from a shared EGridIndex):
+    std::size_t gridBin( double ekin ) const { return m_egridIndex->bin( ekin ); }
+    PairDD sampleDeltaEMuInBin( NeutronEnergy, std::size_t ibin, RNG& rng) const;
+    const SAB::EGridIndex& egridIndex() const { return *m_egridIndex; }
+
+    //Sample (deltaE,mu) for N neutron energies at once. Performance benefits
+    //from processing neutrons in the same energy grid bin together (keeping
+    //the corresponding SABSamplerAtE data hot in the cache). If the energies
+    //are already sorted in ascending order, BatchOrder::Sorted can be used to
+    //walk the energy grid linearly rather than searching it for each
+    //neutron. With BatchOrder::SortInternally, the neutrons are instead
+    //grouped by energy grid bin via a counting sort before sampling (the
+    //output is still in the order of the input):
+    enum class BatchOrder { Unsorted, Sorted, SortInternally };
+    void sampleDeltaEMuMany( RNG&, const double* ekin, std::size_t N,
+                             double* out_deltaE, double* out_mu,
+                             BatchOrder = BatchOrder::SortInternally ) const;
+
+    //Approximate memory footprint in bytes (excluding shared data), and full
+    //accounting (see MemoryFootprint in NCMem.hh):
+    std::size_t approxMemoryUsage() const;
+    void accountMemory( MemoryFootprint& ) const;
+
     //Move ok:
     SABSampler( SABSampler&& ) = default;
     SABSampler& operator=( SABSampler&& ) = default;
 
   private:
-    VectD m_egrid;
+    std::shared_ptr<const SAB::EGridIndex> m_egridIndex;
     std::vector<std::unique_ptr<SABSamplerAtE>> m_samplers;
     double m_kT = 0.0;
     std::shared_ptr<const SAB::SABExtender> m_extender;
     double m_xsAtEmax = 0.0, m_k1 = 0.0, m_k2 = 0.0;
     PairDD sampleHighE(NeutronEnergy, RNG&) const;
+    const VectD& egrid() const { return m_egridIndex->grid(); }
+    PairDD sampleAlphaBetaInBin( NeutronEnergy, std::size_t ibin, RNG& ) const;
+    PairDD alphaBetaToDeltaEMu( const PairDD& alphabeta, NeutronEnergy, RNG& ) const;
   };
 }
 
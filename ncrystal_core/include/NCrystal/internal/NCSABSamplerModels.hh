@@ -24,6 +24,7 @@
 #include "NCrystal/internal/NCSABSampler.hh"
 #include "NCrystal/internal/NCPointwiseDist.hh"
 #include "NCrystal/internal/NCMath.hh"
+#include "NCrystal/internal/NCRandUtils.hh"
 
 namespace NCrystal {
   namespace SAB {
@@ -33,11 +34,33 @@ namespace NCrystal {
       //sampling paper (https://doi.org/10.1016/j.jcp.2018.11.043).
     public:
       PairDD sampleAlphaBeta(double ekin_div_kT, RNG&) const final;
+      std::size_t approxMemoryUsage() const final;
+      void accountSharedMemory( MemoryFootprint& mf ) const final { mf.addSharedObject( m_common ); }
 
       struct CommonCache {
+        //The logsab and alphaintegrals_cumul tables (same layout as
+        //data->sab()) live in memory kept alive by the storage object, which
+        //might be a memory mapped file shared between processes (see
+        //NCSABDiskCache.hh). To save memory, the tables can optionally be kept
+        //in single precision (cf. the sabfloat32 cfg parameter), in which case
+        //only the _f32 spans are non-empty:
         const std::shared_ptr<const SABData> data;
-        const VectD logsab, alphaintegrals_cumul;
+        const Span<const double> logsab, alphaintegrals_cumul;
+        const Span<const float> logsab_f32, alphaintegrals_cumul_f32;
+        const std::shared_ptr<const void> storage;
+        bool isSinglePrecision() const { return !logsab_f32.empty(); }
+        std::size_t approxMemoryUsage() const
+        {
+          return sizeof(CommonCache) + ( logsab.size() + alphaintegrals_cumul.size() ) * sizeof(double)
+            + ( logsab_f32.size() + alphaintegrals_cumul_f32.size() ) * sizeof(float);
+        }
+        void accountMemory( MemoryFootprint& mf ) const
+        {
+          mf.add( approxMemoryUsage() );
+          mf.addSharedObject( data );
+        }
       };
+
       class AlphaSampleInfo  {
         //Class able to sample alpha for a given energy and beta-value.
       public:
@@ -56,6 +79,21 @@ namespace NCrystal {
                           std::vector<AlphaSampleInfo>&&,
                           std::size_t ibetaOffset );
 
+      //Access internal state and reconstruct from it (for persistency):
+      SABSamplerAtE_Alg1( std::shared_ptr<const CommonCache>,
+                          PointwiseDist&& betaSampler,
+                          std::vector<AlphaSampleInfo>&&,
+                          std::size_t ibetaOffset );
+      const PointwiseDist& betaSampler() const { return m_betaSampler; }
+      const std::vector<AlphaSampleInfo>& alphaSampleInfos() const { return m_alphaSamplerInfos; }
+      std::size_t ibetaOffset() const { return m_ibetaOffset; }
+
+      //Sample alpha at the beta grid point with index ibeta, for the
+      //kinematically accessible alpha range at Ei described by the info
+      //object (also used by SABSamplerAtE_Alias):
+      static double sampleAlphaAtRow( const CommonCache&, const AlphaSampleInfo&,
+                                      std::size_t ibeta, double rand_percentile );
+
     private:
       //Sample beta from P(beta|Ei) (line 4 of Alg. 1 in the sampling paper):
       double sampleBeta(RNG&) const;
@@ -71,6 +109,56 @@ namespace NCrystal {
       std::size_t m_ibetaOffset;
     };
 
+    class SABSamplerAtE_Alias : public SABSamplerAtE {
+      //Alternative to SABSamplerAtE_Alg1 which needs neither a binary search
+      //to select the beta bin, nor a rejection loop. The piecewise linear
+      //P(beta|Ei) is decomposed into two linear ("triangular") components per
+      //beta bin, one for each bin edge, and a component is picked in O(1) time
+      //with an alias table. Alpha is then sampled from the grid row at that
+      //bin edge (exactly as in SABSamplerAtE_Alg1), and mapped linearly onto
+      //the kinematically allowed alpha range at the sampled beta value. Thus
+      //the sampled points are always kinematically valid at Ei, but not
+      //necessarily at lower ekin values (SABSampler::sampleAlphaBeta takes care
+      //of rejecting those).
+    public:
+      PairDD sampleAlphaBeta(double ekin_div_kT, RNG&) const final;
+      std::size_t approxMemoryUsage() const final;
+      void accountSharedMemory( MemoryFootprint& mf ) const final { mf.addSharedObject( m_common ); }
+
+      using CommonCache = SABSamplerAtE_Alg1::CommonCache;
+      using AlphaSampleInfo = SABSamplerAtE_Alg1::AlphaSampleInfo;
+
+      //Same arguments as for SABSamplerAtE_Alg1, but also needs Ei/kT:
+      SABSamplerAtE_Alias( std::shared_ptr<const CommonCache>,
+                           double ei_div_kT,
+                           VectD&& betaVals,
+                           const VectD& betaWeights,
+                           std::vector<AlphaSampleInfo>&&,
+                           std::size_t ibetaOffset );
+
+      //Access internal state and reconstruct from it (for persistency):
+      SABSamplerAtE_Alias( std::shared_ptr<const CommonCache>,
+                           double ei_div_kT,
+                           VectD&& betaVals,
+                           RandAliasSampler&& componentSampler,
+                           std::vector<AlphaSampleInfo>&&,
+                           std::size_t ibetaOffset );
+      double eiDivKT() const { return m_eiDivKT; }
+      const VectD& betaVals() const { return m_betaVals; }
+      const RandAliasSampler& componentSampler() const { return m_componentSampler; }
+      const std::vector<AlphaSampleInfo>& alphaSampleInfos() const { return m_alphaSamplerInfos; }
+      std::size_t ibetaOffset() const { return m_ibetaOffset; }
+
+    private:
+      PairDD alphaRangeAtEi( double beta ) const;
+      std::shared_ptr<const CommonCache> m_common;
+      double m_eiDivKT;
+      VectD m_betaVals;
+      RandAliasSampler m_componentSampler;
+      std::vector<AlphaSampleInfo> m_alphaSamplerInfos;
+      std::size_t m_ibetaOffset;
+    };
+
     class SABSamplerAtE_NoScatter : public SABSamplerAtE {
       //Special technical sampler which doesn't actually scatter (i.e. returns
       //alpha=beta=0). For usage of edge-cases with vanishing cross-section.
@@ -47,8 +47,13 @@ namespace NCrystal {
     //multiple SABScatter instances based on the same input object will avoid
     //duplicated resource consumption.
     //
-    //The vdoslux parameter has no effect if input is not a VDOS.
-    SABScatter( const DI_ScatKnl&, unsigned vdoslux = 3, bool useCache = true );
+    //The vdoslux and vdosthintol parameters have no effect if input is not a
+    //VDOS. Setting useAliasSampler selects the SABSamplerAtE_Alias sampling
+    //algorithm instead of the default SABSamplerAtE_Alg1, and setting
+    //singlePrecisionTables keeps the large derived tables in single precision.
+    SABScatter( const DI_ScatKnl&, unsigned vdoslux = 3, bool useCache = true,
+                bool useAliasSampler = false, double vdosthintol = 0.0,
+                bool singlePrecisionTables = false );
     SABScatter( SABData &&,
                 const VectD& energyGrid = VectD() );
     SABScatter( shared_obj<const SABData>,
@@ -61,11 +66,97 @@ namespace NCrystal {
 
     CrossSect crossSectionIsotropic(CachePtr&, NeutronEnergy ) const final;
     ScatterOutcomeIsotropic sampleScatterIsotropic(CachePtr&, RNG&, NeutronEnergy ) const final;
+    void evalManyXSIsotropic( CachePtr&, const double* ekin, std::size_t N,
+                              double* out_xs ) const final;
+    void sampleScatterIsotropicMany( CachePtr&, RNG&, double* ekin, std::size_t N,
+                                     double* out_mu ) const final;
+    CrossSect majorantCrossSection( EnergyDomain ) const final;
+    void accountMemory( MemoryFootprint& ) const final;
+
+    //Append energies of the grid points of the cross section tables (between
+    //which cross sections are linearly interpolated) to the vector. For
+    //merged instances, these are the grid points of all kernels:
+    void addXSGridEnergies( VectD& ) const;
+
+    //SABScatter instances can be merged, in which case the resulting instance
+    //represents the weighted sum of the constituent kernels. Cross sections
+    //are then tabulated on the union of the energy grids of the kernels
+    //(giving exactly the same results as the separate instances), and each
+    //scattering is sampled from one of the kernels, chosen in proportion to
+    //its contribution to the cross section at the given neutron energy. For
+    //materials with several elements with S(alpha,beta) kernels, this avoids a
+    //separate component (and cross section evaluation) for each of them:
+    std::shared_ptr<Process> createMerged( const Process& ) const override;
+    std::shared_ptr<Process> createMergedScaled( const Process&,
+                                                 double scale_this,
+                                                 double scale_other ) const override;
 
   protected:
     struct Impl;
     Pimpl<Impl> m_impl;
-    const SAB::SABScatterHelper * m_sh;
+    const SAB::SABScatterHelper * m_sh;//nullptr for merged instances
+
+  private:
+    class MergedKernels;
+    struct merged_t {};
+    SABScatter( merged_t, shared_obj<const MergedKernels> );
+    double mergedCrossSection( NeutronEnergy ) const;
+  };
+
+  class SABTInterpScatter final : public ProcImpl::ScatterIsotropicMat {
+  public:
+
+    //Provides cross-sections and samplings at a temperature, T, in between two
+    //temperatures, T_lo and T_hi, for which S(alpha,beta) scattering kernels
+    //are available. Cross sections are linearly interpolated in temperature,
+    //and each scattering is sampled from one of the two kernels, chosen in
+    //proportion to its contribution to the interpolated cross section at the
+    //given neutron energy. The weight of the kernel at T_hi is
+    //(T-T_lo)/(T_hi-T_lo) and must be in the range (0,1).
+
+    const char * name() const noexcept final { return "SABTInterpScatter"; }
+
+    SABTInterpScatter( shared_obj<const SAB::SABScatterHelper> sh_lo,
+                       shared_obj<const SAB::SABScatterHelper> sh_hi,
+                       double weight_hi );
+
+    //Create scatter process at the given temperature, based on kernels at
+    //temperatures on a grid with the indicated spacing (in kelvin). The
+    //kernels are provided by the helperAtTemperature function, which should
+    //normally employ caching so kernels at the grid temperatures can be shared
+    //between many processes. The returned process will be a simple SABScatter
+    //instance if the temperature is (very close to) a grid point or below the
+    //first non-zero grid point:
+    using HelperAtTemperatureFct = std::function<shared_obj<const SAB::SABScatterHelper>(Temperature)>;
+    static ProcImpl::ProcPtr createOnTemperatureGrid( Temperature, double gridSpacing,
+                                                      const HelperAtTemperatureFct& helperAtTemperature );
+
+    //Convenience version for DI_ScatKnl objects of type DI_VDOS or
+    //DI_VDOSDebye (parameters as for the corresponding SABScatter
+    //constructor, kernels are always cached):
+    static ProcImpl::ProcPtr createOnTemperatureGrid( const DI_ScatKnl&, double gridSpacing,
+                                                      unsigned vdoslux = 3, bool useAliasSampler = false,
+                                                      double vdosthintol = 0.0,
+                                                      bool singlePrecisionTables = false );
+
+    virtual ~SABTInterpScatter();
+
+    CrossSect crossSectionIsotropic(CachePtr&, NeutronEnergy ) const final;
+    ScatterOutcomeIsotropic sampleScatterIsotropic(CachePtr&, RNG&, NeutronEnergy ) const final;
+    void evalManyXSIsotropic( CachePtr&, const double* ekin, std::size_t N,
+                              double* out_xs ) const final;
+    void sampleScatterIsotropicMany( CachePtr&, RNG&, double* ekin, std::size_t N,
+                                     double* out_mu ) const final;
+    CrossSect majorantCrossSection( EnergyDomain ) const final;
+    void accountMemory( MemoryFootprint& ) const final;
+
+    //Grid points of the cross section tables of both kernels (cf. SABScatter):
+    void addXSGridEnergies( VectD& ) const;
+
+  private:
+    shared_obj<const SAB::SABScatterHelper> m_sh_lo, m_sh_hi;
+    double m_wlo, m_whi;
+    PairDD sampleDeltaEMu( RNG&, NeutronEnergy ) const;
   };
 
 }
@@ -40,6 +40,12 @@ namespace NCrystal {
       SABScatterHelper& operator=( SABScatterHelper&& ) = default;
       SABXSProvider xsprovider;
       SABSampler sampler;
+      std::size_t approxMemoryUsage() const { return xsprovider.approxMemoryUsage() + sampler.approxMemoryUsage(); }
+      void accountMemory( MemoryFootprint& mf ) const
+      {
+        mf.add( xsprovider.approxMemoryUsage() );
+        sampler.accountMemory( mf );
+      }
     };
 
   }
@@ -71,6 +71,18 @@ namespace NCrystal {
     //Faster version with pre-calculated logs. Returns slightly reduced (better than 1e-14) precision results.
     double integrateAlphaInterval_fast(double a1,double s1, double a2 , double s2 , double logs1, double logs2);
 
+    //Span-based versions intended for processing entire tables or alpha rows,
+    //S(alpha|beta_i), as returned by sliceSABAtBetaIdx_const. calcLogSAB sets
+    //out_logsab[i]=log(sab[i]) (-inf when sab[i]=0), via a branch-free
+    //polynomial log implementation which compilers can vectorise, and which
+    //agrees with std::log to within a few ulp. integrateAlphaRow_fast sets
+    //out_cumul[0]=0 and out_cumul[i]=out_cumul[i-1]+integrateAlphaInterval_fast(
+    //alpha[i-1],sab[i-1],alpha[i],sab[i],logsab[i-1],logsab[i]) for i>0. All
+    //spans must have identical sizes:
+    void calcLogSAB( Span<const double> sab, Span<double> out_logsab );
+    void integrateAlphaRow_fast( Span<const double> alpha, Span<const double> sab,
+                                 Span<const double> logsab, Span<double> out_cumul );
+
     //Find the grid cells touched by the kinematically accessible region for
     //ekin_div_kt = ekin/kT. The ibeta_low index will indicate the lowest
     //beta-bin, which will span [ibeta_low,ibeta_low+1], and the alpha-values
@@ -23,6 +23,7 @@
 
 #include "NCrystal/NCDefs.hh"
 #include "NCrystal/internal/NCSABExtender.hh"
+#include "NCrystal/internal/NCSABEGridIndex.hh"
 
 namespace NCrystal {
 
@@ -32,19 +33,41 @@ namespace NCrystal {
                    std::shared_ptr<const SAB::SABExtender> );
     void setData( VectD&& egrid, VectD&& xsvals,
                   std::shared_ptr<const SAB::SABExtender> );
+    //Version which shares the energy grid (and its index) with a sampler:
+    void setData( std::shared_ptr<const SAB::EGridIndex>, VectD&& xsvals,
+                  std::shared_ptr<const SAB::SABExtender> );
     SABXSProvider() = default;//default constructs invalid instance
     ~SABXSProvider();
     CrossSect crossSection(NeutronEnergy) const;
 
+    //Index of first grid point above ekin, and cross section evaluation when
+    //that is already known (e.g. because it was already looked up in a shared
+    //EGridIndex for the sampler):
+    std::size_t gridBin( NeutronEnergy ekin ) const { return m_egridIndex->bin( ekin.dbl() ); }
+    CrossSect crossSectionInBin( NeutronEnergy, std::size_t ibin ) const;
+
+    //Evaluate cross sections for N energies at once:
+    void evalManyXS( const double* ekin, std::size_t N, double* out_xs ) const;
+
+    //Upper bound on cross sections in energy domain (assumes that cross
+    //sections of the extender are decreasing functions of energy, which is
+    //for instance true for free gas models):
+    CrossSect majorantCrossSection( EnergyDomain ) const;
+
     //Move ok:
     SABXSProvider( SABXSProvider&& ) = default;
     SABXSProvider& operator=( SABXSProvider&& ) = default;
 
     //For reference:
-    const VectD & internalEGrid() const { return m_egrid; }
+    const VectD & internalEGrid() const { return m_egridIndex->grid(); }
+    const SAB::EGridIndex& egridIndex() const { return *m_egridIndex; }
     const VectD & internalXSGrid() const { return m_xs; }
+
+    //Approximate memory footprint in bytes:
+    std::size_t approxMemoryUsage() const;
   private:
-    VectD m_egrid, m_xs;
+    std::shared_ptr<const SAB::EGridIndex> m_egridIndex;
+    VectD m_xs;
     std::shared_ptr<const SAB::SABExtender> m_extender;
     double m_kExtension;
   };
@@ -43,13 +43,34 @@ namespace NCrystal {
     //initialisation in the constructor, and the SCBragg instance will *not*
     //assume ownership of it.
     //
-    //For a description of the prec and ntrunc parameters, see NCGaussMos.hh.
+    //For a description of the prec and ntrunc parameters, see NCGaussMos.hh,
+    //and see GaussOnSphere::enableCircleIntegralTable for circint_table.
     SCBragg( const Info&,
              const SCOrientation&,
              MosaicityFWHM,
              double delta_d = 0,
              PlaneProvider * plane_provider = nullptr,
-             double prec = 1e-3, double ntrunc = 0.0 );
+             double prec = 1e-3, double ntrunc = 0.0,
+             bool circint_table = false );
+
+    //The reflection families and their deminormals in the crystal frame do not
+    //depend on the crystal orientation or mosaicity, and can be created once
+    //with createGeometry and then shared between any number of SCBragg
+    //instances (e.g. for many orientations of the same crystal), making the
+    //construction of each of those cheap. Geometries created without a
+    //plane_provider are in addition shared automatically between calls for the
+    //same Info object:
+    class Geometry;
+    using GeometryPtr = shared_obj<const Geometry>;
+    static GeometryPtr createGeometry( const Info&,
+                                       PlaneProvider * plane_provider = nullptr );
+    SCBragg( const Info&,
+             const SCOrientation&,
+             MosaicityFWHM,
+             GeometryPtr,
+             double delta_d = 0,
+             double prec = 1e-3, double ntrunc = 0.0,
+             bool circint_table = false );
 
     const char * name() const noexcept final { return "SCBragg"; }
 
@@ -62,6 +83,20 @@ namespace NCrystal {
     CrossSect crossSection(CachePtr&, NeutronEnergy, const NeutronDirection& ) const final;
     ScatterOutcome sampleScatter(CachePtr&, RNG&, NeutronEnergy, const NeutronDirection& ) const final;
 
+    //Batched versions, rotating the neutron directions into (and out of) the
+    //crystal frame for many neutrons at once:
+    void evalManyXS( CachePtr&, const double* ekin,
+                     const double* ux, const double* uy, const double* uz,
+                     std::size_t N, double* out_xs ) const final;
+    void sampleScatterMany( CachePtr&, RNG&, double* ekin,
+                            double* ux, double* uy, double* uz,
+                            std::size_t N ) const final;
+
+    //Upper bound on cross sections (for any direction), obtained by adding up
+    //upper bounds for all normals which might contribute:
+    CrossSect majorantCrossSection( EnergyDomain ) const final;
+    void accountMemory( MemoryFootprint& ) const final;
+
   private:
     struct pimpl;
     std::unique_ptr<pimpl> m_pimpl;
@@ -38,11 +38,17 @@ namespace NCrystal {
               double derivative_y_right = 0.0 );
     double evalWithAssert(double x) const;
     double evalUnbounded(double x) const;
+    //Batch version of evalUnbounded (it is allowed for x and out to be the
+    //same span, in which case the results are evaluated in place):
+    void evalManyUnbounded( Span<const double> x, Span<double> out ) const;
     void swap(CubicSpline&o);
   private:
     friend class SplinedLookupTable;
     std::size_t m_nm2;
-    std::vector<PairDD > m_data;
+    //Function values and second derivatives are kept in separate arrays,
+    //which makes batch evaluations easier to vectorise:
+    VectD m_y;
+    VectD m_y2;
   };
 
   class SplinedLookupTable {
@@ -65,6 +71,10 @@ namespace NCrystal {
     void set( const Fct1D* thefct,double a,double b,double fprime_a, double fprime_b,unsigned npts = 1000,
               const std::string& name="", const std::string& description="" );
     double eval(double x) const;//<-- query the resulting lookup table
+    //Evaluate several points in one go, with results identical to those of
+    //eval(..). The input and output spans must have the same size, and may
+    //refer to the same memory:
+    void evalMany( Span<const double> x, Span<double> out ) const;
     void swap(SplinedLookupTable&o);
     double getLower() const { return m_a; }
     double getUpper() const { return m_b; }
@@ -99,16 +109,41 @@ inline double NCrystal::CubicSpline::evalUnbounded(double x) const {
   std::size_t idx = ncmin(static_cast<std::size_t>(x),m_nm2);
   double b = x-idx;//fraction inside bin
   double a = 1.0-b;
-  nc_assert(idx+1<m_data.size());
-  std::vector<PairDD >::const_iterator it = m_data.begin()+idx;
-  double tmp = a * (it->first);
-  double tmp2 = (a*a*a-a) * (it->second);
-  ++it;
-  tmp += b*(it->first);
-  tmp2 += (b*b*b-b) * (it->second);
+  nc_assert(idx+1<m_y.size());
+  const double * y = m_y.data() + idx;
+  const double * y2 = m_y2.data() + idx;
+  double tmp = a * y[0];
+  double tmp2 = (a*a*a-a) * y2[0];
+  tmp += b*y[1];
+  tmp2 += (b*b*b-b) * y2[1];
   return tmp + 0.166666666666666666666666666666666666666666666666666667 * tmp2;
 }
 
+inline void NCrystal::CubicSpline::evalManyUnbounded( Span<const double> xvals, Span<double> out ) const {
+  nc_assert(m_nm2>0);
+  nc_assert(xvals.size()==out.size());
+  const std::size_t n = out.size();
+  const double * x = xvals.data();
+  double * res = out.data();
+  const double * y = m_y.data();
+  const double * y2 = m_y2.data();
+  const std::size_t nm2 = m_nm2;
+  //Same operations as in evalUnbounded, in a loop without branches or
+  //function calls:
+  for ( std::size_t i = 0; i < n; ++i ) {
+    const double xi = x[i];
+    const std::size_t idxraw = static_cast<std::size_t>(xi);
+    const std::size_t idx = ( idxraw < nm2 ? idxraw : nm2 );
+    const double b = xi-idx;
+    const double a = 1.0-b;
+    double tmp = a * y[idx];
+    double tmp2 = (a*a*a-a) * y2[idx];
+    tmp += b*y[idx+1];
+    tmp2 += (b*b*b-b) * y2[idx+1];
+    res[i] = tmp + 0.166666666666666666666666666666666666666666666666666667 * tmp2;
+  }
+}
+
 
 inline NCrystal::SplinedLookupTable::SplinedLookupTable() : m_a(0), m_invdelta(0), m_b(0) {}
 inline NCrystal::SplinedLookupTable::SplinedLookupTable( const VectD& fvals,
@@ -134,6 +169,18 @@ inline double NCrystal::SplinedLookupTable::eval(double x) const {
   return m_spline.evalUnbounded((x-m_a)*m_invdelta);
 }
 
+inline void NCrystal::SplinedLookupTable::evalMany( Span<const double> x, Span<double> out ) const {
+  nc_assert(x.size()==out.size());
+  const std::size_t n = out.size();
+  const double * xx = x.data();
+  double * res = out.data();
+  const double a = m_a;
+  const double invdelta = m_invdelta;
+  for ( std::size_t i = 0; i < n; ++i )
+    res[i] = (xx[i]-a)*invdelta;
+  m_spline.evalManyUnbounded( out, out );
+}
+
 inline void NCrystal::SplinedLookupTable::swap(NCrystal::SplinedLookupTable&o) {
   std::swap(m_a,o.m_a);
   std::swap(m_b,o.m_b);
@@ -143,7 +190,8 @@ inline void NCrystal::SplinedLookupTable::swap(NCrystal::SplinedLookupTable&o) {
 
 inline void NCrystal::CubicSpline::swap(NCrystal::CubicSpline&o) {
   std::swap(m_nm2,o.m_nm2);
-  std::swap(m_data,o.m_data);
+  std::swap(m_y,o.m_y);
+  std::swap(m_y2,o.m_y2);
 }
 
 #endif
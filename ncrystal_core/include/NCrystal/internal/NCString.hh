@@ -25,6 +25,7 @@
 
 #include "NCrystal/NCDefs.hh"
 #include <ostream>
+#include <cstring>
 
 namespace NCrystal {
 
@@ -50,6 +51,41 @@ namespace NCrystal {
              std::size_t maxsplit = 0,
              char sep = 0 );
 
+  //Light-weight non-owning view of a range of characters (like
+  //std::string_view, which is not available in C++11). The viewed data must
+  //outlive the view:
+  class StrView {
+  public:
+    static constexpr std::size_t npos = std::size_t(-1);
+    constexpr StrView() noexcept : m_b(nullptr), m_n(0) {}
+    constexpr StrView( const char * b, std::size_t n ) noexcept : m_b(b), m_n(n) {}
+    StrView( const char * b, const char * e ) noexcept : m_b(b), m_n(static_cast<std::size_t>(e-b)) {}
+    StrView( const std::string& s ) noexcept : m_b(s.data()), m_n(s.size()) {}
+    constexpr const char * data() const noexcept { return m_b; }
+    constexpr std::size_t size() const noexcept { return m_n; }
+    constexpr bool empty() const noexcept { return m_n == 0; }
+    constexpr const char * begin() const noexcept { return m_b; }
+    constexpr const char * end() const noexcept { return m_b + m_n; }
+    constexpr char operator[]( std::size_t i ) const noexcept { return m_b[i]; }
+    constexpr char front() const noexcept { return *m_b; }
+    std::string to_string() const { return std::string( m_b, m_n ); }
+    std::size_t find( char c ) const noexcept;
+    StrView substr( std::size_t pos, std::size_t n = npos ) const ncnoexceptndebug;
+    bool operator==( const StrView& o ) const noexcept;
+    bool operator!=( const StrView& o ) const noexcept { return !(*this==o); }
+  private:
+    const char * m_b;
+    std::size_t m_n;
+  };
+  std::ostream& operator<<( std::ostream&, const StrView& );
+
+  //Like split(..), but placing views into the input in the output vector,
+  //thus avoiding any string allocations (when the output vector is reused):
+  void splitViews( std::vector<StrView>& output,
+                   StrView input,
+                   std::size_t maxsplit = 0,
+                   char sep = 0 );
+
 
   //Substrings at edges:
   bool startswith(const std::string& str, const std::string& substr);
@@ -80,6 +116,12 @@ namespace NCrystal {
   bool safe_str2dbl(const std::string&, double& result );
   bool safe_str2int(const std::string&, int& result );
 
+  //Versions taking views (plain numbers are converted without any copying):
+  double str2dbl(StrView, const char * errmsg = 0);
+  int str2int(StrView, const char * errmsg = 0);
+  bool safe_str2dbl(StrView, double& result );
+  bool safe_str2int(StrView, int& result );
+
   //Convenience:
   inline bool isDouble( const std::string& ss ) { double dummy; return safe_str2dbl(ss,dummy); }
   inline bool isInt( const std::string& ss ) { int dummy; return safe_str2int(ss,dummy); }
@@ -145,6 +187,28 @@ namespace NCrystal {
     return s;
   }
 
+  inline std::size_t StrView::find( char c ) const noexcept
+  {
+    auto it = std::find( begin(), end(), c );
+    return it == end() ? npos : static_cast<std::size_t>( it - m_b );
+  }
+
+  inline StrView StrView::substr( std::size_t pos, std::size_t n ) const ncnoexceptndebug
+  {
+    nc_assert( pos <= m_n );
+    return StrView( m_b + pos, std::min( n, m_n - pos ) );
+  }
+
+  inline bool StrView::operator==( const StrView& o ) const noexcept
+  {
+    return m_n == o.m_n && ( m_n == 0 || std::memcmp( m_b, o.m_b, m_n ) == 0 );
+  }
+
+  inline std::ostream& operator<<( std::ostream& os, const StrView& sv )
+  {
+    return os.write( sv.data(), static_cast<std::streamsize>( sv.size() ) );
+  }
+
   inline bool isAlphaNumeric( const char c )
   {
     return ( c>='a' && c<='z' ) || ( c>='A' && c<='Z' ) || ( c>='0' && c<='9' );
@@ -0,0 +1,196 @@
+#ifndef NCrystal_ThreadUtils_hh
+#define NCrystal_ThreadUtils_hh
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+//  This file is part of NCrystal (see https://mctools.github.io/ncrystal/)   //
+//                                                                            //
+//  Copyright 2015-2021 NCrystal developers                                   //
+//                                                                            //
+//  Licensed under the Apache License, Version 2.0 (the "License");           //
+//  you may not use this file except in compliance with the License.          //
+//  You may obtain a copy of the License at                                   //
+//                                                                            //
+//      http://www.apache.org/licenses/LICENSE-2.0                            //
+//                                                                            //
+//  Unless required by applicable law or agreed to in writing, software       //
+//  distributed under the License is distributed on an "AS IS" BASIS,         //
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  //
+//  See the License for the specific language governing permissions and       //
+//  limitations under the License.                                            //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include "NCrystal/NCDefs.hh"
+#include <functional>
+
+//Utilities for parallelising expensive initialisation work. Results must
+//not depend on the number of threads used, so the work should be split into
+//independent tasks writing to separate pre-allocated output slots.
+//
+//All work is carried out by a single global task pool, whose threads are
+//started upon first usage and kept alive until the process ends. Idle pool
+//threads pick up (steal) tasks from any parallelFor call in progress,
+//including calls nested inside tasks of other parallelFor calls or
+//background tasks. Such nested calls therefore compose: the total number of
+//threads busy with NCrystal work never exceeds the pool size (plus the
+//threads of the application calling into NCrystal), and threads which would
+//otherwise idle while waiting for slow tasks of one call can help with
+//another.
+
+namespace NCrystal {
+
+  //Number of threads to use for parallel initialisation work, as set with
+  //setNThreads or requested by the NCRYSTAL_NTHREADS environment variable. If
+  //neither is used, the value is 1 (no parallelisation), a value of 0 (or
+  //"auto") means to use all available hardware threads. Always returns 1 if
+  //NCrystal was built with NCRYSTAL_DISABLE_THREADS:
+  unsigned getNThreadsFromEnv();
+
+  //Override the value of NCRYSTAL_NTHREADS (0 means all available hardware
+  //threads). This affects subsequent calls to getNThreadsFromEnv(), and
+  //should be called before starting any NCrystal work in other threads:
+  void setNThreads( unsigned );
+
+  //Call fct(i) for all i in [0,n), using up to nthreads threads (the calling
+  //thread included). Tasks are handed out in increasing order of i. If any
+  //call throws an exception, remaining tasks are skipped and the first
+  //exception is rethrown in the calling thread once all threads have
+  //finished. Nested calls (i.e. from within fct) also use the pool, but with
+  //no more threads than are idle at the time:
+  void parallelFor( std::size_t n, unsigned nthreads,
+                    const std::function<void(std::size_t)>& fct );
+
+  //Parallel reduction with results independent of the number of threads:
+  //evaluates map(i) for all i in [0,n) like parallelFor, and then combines
+  //the results in order of increasing i in the calling thread, i.e. returns
+  //reduce(...reduce(reduce(init,map(0)),map(1))...,map(n-1)). Intended for
+  //expensive map calls (results are kept until the end, and T must be
+  //default constructible):
+  template<class T, class TMap, class TReduce>
+  T parallelReduce( std::size_t n, unsigned nthreads, T init,
+                    const TMap& map, const TReduce& reduce );
+
+  //Invoke fct asynchronously on the pool. For this purpose the pool has at
+  //least as many threads as given by NCRYSTAL_NTHREADS if set, and otherwise
+  //by the number of available hardware threads. Exceptions must be handled
+  //within fct (any escaping exceptions are silently discarded). If NCrystal
+  //was built with NCRYSTAL_DISABLE_THREADS, fct is simply invoked immediately
+  //in the calling thread:
+  void runInBackground( std::function<void()> fct );
+
+  //Applications with their own thread pool (TBB, OpenMP, ...) can let
+  //NCrystal use that instead of starting threads of its own. Any function
+  //which is set is used in place of the internal pool: parallelFor(n,
+  //nthreads,fct) must call fct(i) exactly once for each i in [0,n) before
+  //returning, using up to nthreads threads (fct never throws). For instance,
+  //with TBB it could call tbb::parallel_for(std::size_t(0),n,fct). The
+  //runInBackground(fct) function must arrange for fct() to be invoked
+  //asynchronously (e.g. with tbb::task_arena::enqueue). Must be called before
+  //starting any NCrystal work in other threads:
+  struct ExternalTaskPool {
+    std::function<void(std::size_t, unsigned, const std::function<void(std::size_t)>&)> parallelFor;
+    std::function<void(std::function<void()>)> runInBackground;
+  };
+  void setExternalTaskPool( ExternalTaskPool );
+
+  //Optional NUMA awareness: If the NCRYSTAL_NUMA_REPLICATE environment
+  //variable is set (and NCrystal is running on Linux), numaReplicationEnabled()
+  //returns true, and currentNUMANode() returns the NUMA node of the CPU on
+  //which the calling thread is running (otherwise it always returns 0). The
+  //node is only rechecked periodically, so the result might briefly be stale
+  //after a thread migrated to another node:
+  bool numaReplicationEnabled();
+  unsigned currentNUMANode();
+
+  //Holder of a large immutable object, which (if NUMA replication is enabled)
+  //is lazily copied for each NUMA node upon the first access from a thread
+  //running on that node. Since the copy is made by the accessing thread, the
+  //usual "first-touch" policy of the OS places its memory on the local node,
+  //so threads on all nodes read from local memory. The object is otherwise
+  //simply shared. Nodes with ids beyond the first 16 simply use the original:
+  template<class T>
+  class NUMAReplicated : private NoCopyMove {
+  public:
+    explicit NUMAReplicated( std::shared_ptr<const T> );
+    const T& get() const;
+    const T& original() const noexcept { return *m_orig; }
+    std::size_t nReplicas() const;
+  private:
+    static constexpr unsigned nmaxnodes = 16;
+    std::shared_ptr<const T> m_orig;
+    unsigned m_orignode = 0;
+    bool m_enabled;
+    mutable std::atomic<const T*> m_replicas[nmaxnodes];
+    mutable std::mutex m_mutex;
+    mutable std::vector<std::unique_ptr<const T>> m_owned;
+    const T& createReplica( unsigned node ) const;
+  };
+
+}
+
+
+////////////////////////////
+// Inline implementations //
+////////////////////////////
+
+namespace NCrystal {
+
+  template<class T, class TMap, class TReduce>
+  inline T parallelReduce( std::size_t n, unsigned nthreads, T init,
+                           const TMap& map, const TReduce& reduce )
+  {
+    std::vector<T> vals( n );
+    parallelFor( n, nthreads, [&vals,&map]( std::size_t i ) { vals[i] = map( i ); } );
+    for ( auto& v : vals )
+      init = reduce( std::move(init), std::move(v) );
+    return init;
+  }
+
+  template<class T>
+  inline NUMAReplicated<T>::NUMAReplicated( std::shared_ptr<const T> orig )
+    : m_orig( std::move(orig) ),
+      m_enabled( numaReplicationEnabled() )
+  {
+    nc_assert_always( m_orig != nullptr );
+    for ( auto& r : m_replicas )
+      r.store( nullptr, std::memory_order_relaxed );
+    if ( m_enabled )
+      m_orignode = currentNUMANode();//where the original was most likely created
+  }
+
+  template<class T>
+  inline const T& NUMAReplicated<T>::get() const
+  {
+    if ( !m_enabled )
+      return *m_orig;
+    const unsigned node = currentNUMANode();
+    if ( node == m_orignode || node >= nmaxnodes )
+      return *m_orig;
+    const T* r = m_replicas[node].load( std::memory_order_acquire );
+    return r ? *r : createReplica( node );
+  }
+
+  template<class T>
+  inline const T& NUMAReplicated<T>::createReplica( unsigned node ) const
+  {
+    NCRYSTAL_LOCK_GUARD(m_mutex);
+    const T* r = m_replicas[node].load( std::memory_order_acquire );
+    if ( r )
+      return *r;
+    m_owned.push_back( std::make_unique<const T>( *m_orig ) );
+    r = m_owned.back().get();
+    m_replicas[node].store( r, std::memory_order_release );
+    return *r;
+  }
+
+  template<class T>
+  inline std::size_t NUMAReplicated<T>::nReplicas() const
+  {
+    NCRYSTAL_LOCK_GUARD(m_mutex);
+    return m_owned.size();
+  }
+
+}
+
+#endif
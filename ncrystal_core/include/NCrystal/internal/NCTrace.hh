@@ -0,0 +1,70 @@
+#ifndef NCrystal_Trace_hh
+#define NCrystal_Trace_hh
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+//  This file is part of NCrystal (see https://mctools.github.io/ncrystal/)   //
+//                                                                            //
+//  Copyright 2015-2021 NCrystal developers                                   //
+//                                                                            //
+//  Licensed under the Apache License, Version 2.0 (the "License");           //
+//  you may not use this file except in compliance with the License.          //
+//  You may obtain a copy of the License at                                   //
+//                                                                            //
+//      http://www.apache.org/licenses/LICENSE-2.0                            //
+//                                                                            //
+//  Unless required by applicable law or agreed to in writing, software       //
+//  distributed under the License is distributed on an "AS IS" BASIS,         //
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  //
+//  See the License for the specific language governing permissions and       //
+//  limitations under the License.                                            //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include "NCrystal/NCDefs.hh"
+
+namespace NCrystal {
+
+  namespace Trace {
+
+    //Lightweight tracing of expensive initialisation steps (factory creations,
+    //waits for objects under construction in other threads, HKL list
+    //creation, VDOS expansion, SAB table creation, ...), intended for
+    //diagnosing slow startups in multi-threaded applications.
+    //
+    //Tracing is enabled by setting the NCRYSTAL_TRACE environment variable to
+    //the name of an output file. At process exit all recorded spans are then
+    //written to that file in the Chrome trace event format (JSON), which can
+    //be inspected with tools like https://ui.perfetto.dev or
+    //chrome://tracing. Each thread gets its own track, so waits for other
+    //threads appear alongside the computations they are waiting for.
+    //
+    //When tracing is disabled, a Span costs a single check of a cached flag.
+
+    bool enabled();
+
+    class Span : private NoCopyMove {
+    public:
+      //Record time spent from construction to destruction of the Span under
+      //the given name (only if tracing is enabled):
+      Span( const char * name );
+      Span( const std::string& name );
+      ~Span();
+
+      //Whether the span is actually recorded, and additional information (like
+      //a cfg-string) to attach to the span. Since creating it might be costly,
+      //it is recommended to check active() before calling setDetail:
+      bool active() const noexcept { return m_active; }
+      void setDetail( std::string );
+
+    private:
+      bool m_active;
+      std::uint64_t m_tstart = 0;
+      std::string m_name;
+      std::string m_detail;
+    };
+
+  }
+}
+
+#endif
@@ -42,6 +42,13 @@ namespace NCrystal {
     // The VDOSEval constructor assumes (and will error if not) that the
     // provided VDOS parameterisation has already been regularised (e.g. by the
     // regulariseVDOSGrid function further down).
+    //
+    // The same VDOS is typically evaluated by several VDOSEval instances (for
+    // Info preparation, the incoherent elastic model and the scattering
+    // kernel), so results of the integrations in the constructor,
+    // calcEffectiveTemperature() and calcGamma0() are memoised per VDOS and
+    // temperature. Cached values are only used for identical input, so
+    // results are unaffected.
 
     VDOSEval( const VDOSData& );
     ~VDOSEval();
@@ -94,6 +101,10 @@ namespace NCrystal {
     Temperature m_temperature;
     double m_elementMassAMU, m_originalIntegral;
     unsigned m_nptsExtended;
+    struct Memo;
+    std::shared_ptr<Memo> m_memo;
+    double calcGamma0Impl() const;
+    double calcEffectiveTemperatureImpl() const;
     template <class Fct, class FctEsqTaylor>
     double integrateWithFunction(Fct,FctEsqTaylor) const;
   };
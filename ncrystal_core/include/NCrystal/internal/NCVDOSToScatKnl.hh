@@ -34,7 +34,21 @@ namespace NCrystal {
   ScatKnlData createScatteringKernel( const VDOSData&,
                                       unsigned vdosluxlvl = 3,//0 to 5, affects binning, Emax, etc.
                                       double targetEmax = 0.0,//if 0, will depend on luxlvl. Error if set to unachievable value.
-                                      const VDOSGn::TruncAndThinningParams ttpars = VDOSGn::TruncAndThinningChoices::Default );
+                                      const VDOSGn::TruncAndThinningParams ttpars = VDOSGn::TruncAndThinningChoices::Default,
+                                      double thinningTolerance = 0.0 );//if >0, thin result with thinScatteringKernel
+
+  //Optionally thin the alpha and beta grids of kernels created from VDOS
+  //spectra, removing grid points wherever the S(alpha,beta) values there are
+  //reproduced to within the given relative tolerance by (log-linear)
+  //interpolation between the remaining neighbouring points. This results in
+  //smaller kernels with cross sections and sampling distributions of
+  //essentially unchanged accuracy. To avoid the large gaps which can cause
+  //artefacts in integration and sampling algorithms, at most maxskip
+  //consecutive points are removed, and beta points with |beta| below
+  //protectBeta (the dense points near beta=0) are always kept. Returns number
+  //of points removed:
+  std::size_t thinScatteringKernel( ScatKnlData&, double tolerance,
+                                    double protectBeta, unsigned maxskip = 3 );
 
   //Internal functions, exposed here for testing:
   VectD setupAlphaGrid( double kT, double msd, double alphaMax, unsigned npts );
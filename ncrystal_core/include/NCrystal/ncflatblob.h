@@ -0,0 +1,245 @@
+#ifndef ncrystal_flatblob_h
+#define ncrystal_flatblob_h
+
+/******************************************************************************/
+/*                                                                            */
+/*  This file is part of NCrystal (see https://mctools.github.io/ncrystal/)   */
+/*                                                                            */
+/*  Copyright 2015-2021 NCrystal developers                                   */
+/*                                                                            */
+/*  Licensed under the Apache License, Version 2.0 (the "License");           */
+/*  you may not use this file except in compliance with the License.          */
+/*  You may obtain a copy of the License at                                   */
+/*                                                                            */
+/*      http://www.apache.org/licenses/LICENSE-2.0                            */
+/*                                                                            */
+/*  Unless required by applicable law or agreed to in writing, software       */
+/*  distributed under the License is distributed on an "AS IS" BASIS,         */
+/*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  */
+/*  See the License for the specific language governing permissions and       */
+/*  limitations under the License.                                            */
+/*                                                                            */
+/******************************************************************************/
+
+/********************************************************************************/
+/* Layout of, and header-only evaluator for, the flat memory blobs produced by  */
+/* ncrystal_export_flatblob (see ncrystal.h). A blob is a single contiguous     */
+/* pointer-free chunk of memory (all positions are byte offsets from the start  */
+/* of the blob), which can be copied verbatim to devices like GPUs. This file   */
+/* does not depend on the NCrystal library and contains only plain C code, so   */
+/* it can be included in device code. When compiled with CUDA or HIP all the    */
+/* functions are marked __host__ __device__. Random numbers must be provided by */
+/* the caller, as uniformly distributed values in [0,1).                        */
+/*                                                                              */
+/* Each component of the exported isotropic scatter process is stored either    */
+/* exactly (powder Bragg diffraction, as lists of Bragg edge thresholds and     */
+/* cumulative contributions), or as cross sections on the union energy grid     */
+/* along with a fixed number of sampled scattering outcomes at each grid point  */
+/* (all other components, e.g. those based on scattering kernels). Cross        */
+/* sections of tabulated components are interpolated linearly, and outcomes     */
+/* are sampled from a neighbouring grid point picked with probabilities given   */
+/* by the interpolation weights. Outside the grid range the values at the       */
+/* nearest grid end are used.                                                   */
+/********************************************************************************/
+
+#include <stdint.h>
+#include <math.h>
+
+#ifndef NCFLATBLOB_FCT
+#  if defined(__CUDACC__) || defined(__HIPCC__)
+#    define NCFLATBLOB_FCT static inline __host__ __device__
+#  else
+#    define NCFLATBLOB_FCT static inline
+#  endif
+#endif
+
+#define NCFLATBLOB_MAGIC 0x4e43464c41544231ull /* "NCFLATB1" */
+#define NCFLATBLOB_VERSION 1
+#define NCFLATBLOB_NRANDOM 3 /* random numbers needed per sampling */
+#define NCFLATBLOB_COMP_TABULATED 0
+#define NCFLATBLOB_COMP_BRAGG 1
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+  typedef struct {
+    uint64_t magic;      /* NCFLATBLOB_MAGIC                                    */
+    uint64_t version;    /* NCFLATBLOB_VERSION                                  */
+    uint64_t nbytes;     /* total size of blob                                  */
+    uint64_t n_egrid;    /* number of points in union energy grid               */
+    uint64_t n_samples;  /* sampled outcomes per grid point (tabulated comps)   */
+    uint64_t n_comp;     /* number of components                                */
+    uint64_t off_egrid;  /* n_egrid energies [eV] (increasing)                  */
+    uint64_t off_xstot;  /* n_egrid total cross sections [barn] (reference only) */
+    uint64_t off_comps;  /* n_comp ncflatblob_comp_t entries                    */
+  } ncflatblob_header_t;
+
+  typedef struct {
+    uint64_t type;  /* NCFLATBLOB_COMP_TABULATED or NCFLATBLOB_COMP_BRAGG       */
+    uint64_t n;     /* Bragg: number of edges. Tabulated: n_egrid               */
+    uint64_t off_a; /* Bragg: edge energies. Tabulated: xs at grid points       */
+    uint64_t off_b; /* Bragg: cumulative xs*ekin. Tabulated: n_egrid*n_samples  */
+                    /*        ratios ekin_final/ekin                            */
+    uint64_t off_c; /* Bragg: unused. Tabulated: n_egrid*n_samples mu values    */
+  } ncflatblob_comp_t;
+
+  /* Access header and check that the blob seems valid (returns 0 if not):     */
+  NCFLATBLOB_FCT const ncflatblob_header_t* ncflatblob_header( const void* blob )
+  {
+    return (const ncflatblob_header_t*)blob;
+  }
+  NCFLATBLOB_FCT int ncflatblob_valid( const void* blob )
+  {
+    const ncflatblob_header_t* h = ncflatblob_header(blob);
+    return blob && h->magic == NCFLATBLOB_MAGIC && h->version == NCFLATBLOB_VERSION && h->n_egrid >= 2;
+  }
+
+  /* Total cross section [barn] at ekin [eV]:                                  */
+  NCFLATBLOB_FCT double ncflatblob_crosssection( const void* blob, double ekin );
+
+  /* Sample scattering at ekin [eV], using NCFLATBLOB_NRANDOM random numbers   */
+  /* from rnd. Results are final energy [eV] and cosine of scattering angle:   */
+  NCFLATBLOB_FCT void ncflatblob_samplescatter( const void* blob, double ekin, const double* rnd,
+                                                double* ekin_final, double* mu );
+
+  /*=============================================================================*/
+  /*== Implementation                                                        ==*/
+  /*=============================================================================*/
+
+  NCFLATBLOB_FCT const double* ncflatblob_darr( const void* blob, uint64_t off )
+  {
+    return (const double*)( (const char*)blob + off );
+  }
+
+  NCFLATBLOB_FCT const ncflatblob_comp_t* ncflatblob_comp( const void* blob, uint64_t i )
+  {
+    return (const ncflatblob_comp_t*)( (const char*)blob + ncflatblob_header(blob)->off_comps ) + i;
+  }
+
+  /* Number of entries in the increasing array arr which are <= x:             */
+  NCFLATBLOB_FCT uint64_t ncflatblob_countle( const double* arr, uint64_t n, double x )
+  {
+    uint64_t lo = 0;
+    while ( n > 0 ) {
+      uint64_t half = n / 2;
+      if ( arr[lo+half] <= x ) {
+        lo += half + 1;
+        n -= half + 1;
+      } else {
+        n = half;
+      }
+    }
+    return lo;
+  }
+
+  /* Grid position: index i and interpolation fraction f in [0,1] such that    */
+  /* ekin corresponds to egrid[i]+f*(egrid[i+1]-egrid[i]) (clamped to range):  */
+  NCFLATBLOB_FCT void ncflatblob_gridpos( const void* blob, double ekin, uint64_t* i, double* f )
+  {
+    const ncflatblob_header_t* h = ncflatblob_header(blob);
+    const double* egrid = ncflatblob_darr(blob,h->off_egrid);
+    const uint64_t n = h->n_egrid;
+    if ( !( ekin > egrid[0] ) ) {
+      *i = 0;
+      *f = 0.0;
+      return;
+    }
+    if ( !( ekin < egrid[n-1] ) ) {
+      *i = n - 2;
+      *f = 1.0;
+      return;
+    }
+    uint64_t k = ncflatblob_countle(egrid,n,ekin) - 1;
+    *i = k;
+    *f = ( ekin - egrid[k] ) / ( egrid[k+1] - egrid[k] );
+  }
+
+  NCFLATBLOB_FCT double ncflatblob_compxs( const void* blob, const ncflatblob_comp_t* c,
+                                           double ekin, uint64_t i, double f )
+  {
+    if ( c->type == NCFLATBLOB_COMP_BRAGG ) {
+      const uint64_t k = ncflatblob_countle( ncflatblob_darr(blob,c->off_a), c->n, ekin );
+      return k ? ncflatblob_darr(blob,c->off_b)[k-1] / ekin : 0.0;
+    }
+    const double* xs = ncflatblob_darr(blob,c->off_a);
+    return xs[i] + f * ( xs[i+1] - xs[i] );
+  }
+
+  NCFLATBLOB_FCT double ncflatblob_crosssection( const void* blob, double ekin )
+  {
+    const ncflatblob_header_t* h = ncflatblob_header(blob);
+    uint64_t i;
+    double f;
+    ncflatblob_gridpos(blob,ekin,&i,&f);
+    double xs = 0.0;
+    for ( uint64_t ic = 0; ic < h->n_comp; ++ic )
+      xs += ncflatblob_compxs(blob,ncflatblob_comp(blob,ic),ekin,i,f);
+    return xs;
+  }
+
+  NCFLATBLOB_FCT void ncflatblob_samplescatter( const void* blob, double ekin, const double* rnd,
+                                                double* ekin_final, double* mu )
+  {
+    const ncflatblob_header_t* h = ncflatblob_header(blob);
+    uint64_t i;
+    double f;
+    ncflatblob_gridpos(blob,ekin,&i,&f);
+    *ekin_final = ekin;
+    *mu = 1.0;
+
+    /* Select component by contribution to cross section: */
+    const double xstot = ncflatblob_crosssection(blob,ekin);
+    if ( !( xstot > 0.0 ) )
+      return;
+    const double target = rnd[0] * xstot;
+    double xssum = 0.0;
+    uint64_t ic = 0;
+    for ( ; ic + 1 < h->n_comp; ++ic ) {
+      xssum += ncflatblob_compxs(blob,ncflatblob_comp(blob,ic),ekin,i,f);
+      if ( target < xssum )
+        break;
+    }
+    const ncflatblob_comp_t* c = ncflatblob_comp(blob,ic);
+
+    if ( c->type == NCFLATBLOB_COMP_BRAGG ) {
+      /* Elastic, select plane by contribution among the available ones: */
+      const double* e_edges = ncflatblob_darr(blob,c->off_a);
+      const double* commul = ncflatblob_darr(blob,c->off_b);
+      const uint64_t k = ncflatblob_countle( e_edges, c->n, ekin );
+      if ( !k )
+        return;
+      const double t = rnd[1] * commul[k-1];
+      uint64_t j = 0, n = k;
+      while ( n > 0 ) {
+        /* lower bound search for t in commul[0..k) */
+        uint64_t half = n / 2;
+        if ( commul[j+half] < t ) {
+          j += half + 1;
+          n -= half + 1;
+        } else {
+          n = half;
+        }
+      }
+      if ( j >= k )
+        j = k - 1;
+      const double m = 1.0 - 2.0 * e_edges[j] / ekin;
+      *mu = m < -1.0 ? -1.0 : ( m > 1.0 ? 1.0 : m );
+      return;
+    }
+
+    /* Tabulated outcome from neighbouring grid point: */
+    uint64_t ig = ( rnd[1] < f ? i + 1 : i );
+    uint64_t js = (uint64_t)( rnd[2] * h->n_samples );
+    if ( js >= h->n_samples )
+      js = h->n_samples - 1;
+    const uint64_t idx = ig * h->n_samples + js;
+    *ekin_final = ekin * ncflatblob_darr(blob,c->off_b)[idx];
+    *mu = ncflatblob_darr(blob,c->off_c)[idx];
+  }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
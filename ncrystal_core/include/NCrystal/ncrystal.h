@@ -49,6 +49,8 @@ extern "C" {
   typedef struct { void * internal; } ncrystal_scatter_t;
   typedef struct { void * internal; } ncrystal_absorption_t;
   typedef struct { void * internal; } ncrystal_atomdata_t;
+  typedef struct { void * internal; } ncrystal_batchctx_t;
+  typedef struct { void * internal; } ncrystal_pending_t;
 
   NCRYSTAL_API int  ncrystal_refcount( void* object );
   NCRYSTAL_API void ncrystal_ref( void* object );
@@ -80,6 +82,21 @@ extern "C" {
   NCRYSTAL_API ncrystal_scatter_t ncrystal_create_scatter( const char * cfgstr );
   NCRYSTAL_API ncrystal_absorption_t ncrystal_create_absorption( const char * cfgstr );
 
+  /* Asynchronous creation: Start creating the object on a pool of background    */
+  /* threads and return immediately with a handle to the pending result. The     */
+  /* corresponding ncrystal_wait_xxx function will then wait for the object to   */
+  /* be ready and return it (it can be called more than once, each time          */
+  /* returning a new handle to the same object). Errors in cfgstr itself are     */
+  /* reported immediately, while any errors during creation are reported by the  */
+  /* ncrystal_wait_xxx call. Pending handles must be cleaned up by calling       */
+  /* ncrystal_unref.                                                             */
+  NCRYSTAL_API ncrystal_pending_t ncrystal_create_info_async( const char * cfgstr );
+  NCRYSTAL_API ncrystal_pending_t ncrystal_create_scatter_async( const char * cfgstr );
+  NCRYSTAL_API ncrystal_pending_t ncrystal_create_absorption_async( const char * cfgstr );
+  NCRYSTAL_API ncrystal_info_t ncrystal_wait_info( ncrystal_pending_t );
+  NCRYSTAL_API ncrystal_scatter_t ncrystal_wait_scatter( ncrystal_pending_t );
+  NCRYSTAL_API ncrystal_absorption_t ncrystal_wait_absorption( ncrystal_pending_t );
+
   /* Notice: ncrystal_scatter_t objects contain RNG streams, which a lot of other  */
   /* functions in this file are dedicated to handling.                             */
 
@@ -126,6 +143,8 @@ extern "C" {
   /* Fine tuning factory availability and caching                                  */
   NCRYSTAL_API void ncrystal_disable_caching(); /*NB: this concerns Info object caching only! */
   NCRYSTAL_API void ncrystal_enable_caching();  /*NB: this concerns Info object caching only! */
+  /* Let input data with identical content share cached objects (0 to disable):   */
+  NCRYSTAL_API void ncrystal_enable_textdata_dedup( int );
   NCRYSTAL_API int ncrystal_has_factory( const char * name );
 
   /*============================================================================== */
@@ -198,6 +217,15 @@ extern "C" {
   NCRYSTAL_API void ncrystal_info_gethkl( ncrystal_info_t, int idx,
                                           int* h, int* k, int* l, int* multiplicity,
                                           double * dspacing, double* fsquared );
+  /*Bulk version of ncrystal_info_gethkl, filling arrays of length nhkl:          */
+  NCRYSTAL_API void ncrystal_info_gethkl_all( ncrystal_info_t,
+                                              int* h, int* k, int* l, int* multiplicity,
+                                              double * dspacing, double* fsquared );
+  /*Demi-normals of all HKL families (multiplicity/2 normals per family, in the   */
+  /*order of the families). Number is 0 when unavailable, and the array passed to */
+  /*ncrystal_info_getdeminormals_all must have room for 3 doubles per normal:     */
+  NCRYSTAL_API unsigned ncrystal_info_ndeminormals( ncrystal_info_t );
+  NCRYSTAL_API void ncrystal_info_getdeminormals_all( ncrystal_info_t, double* normals );
 
   /*Access AtomInfo:                                                               */
   NCRYSTAL_API unsigned ncrystal_info_natominfo( ncrystal_info_t );/* 0=unavail    */
@@ -211,6 +239,14 @@ extern "C" {
   NCRYSTAL_API void ncrystal_info_getatompos( ncrystal_info_t,
                                               unsigned iatom, unsigned ipos,
                                               double* x, double* y, double* z );
+  /*Bulk versions of the two above, filling arrays of length natominfo and (for   */
+  /*positions) 3 doubles for each of the number_per_unit_cell positions of each   */
+  /*atom, with atoms in the usual order:                                          */
+  NCRYSTAL_API void ncrystal_info_getatominfo_all( ncrystal_info_t,
+                                                   unsigned* atomdataindex,
+                                                   unsigned* number_per_unit_cell,
+                                                   double* debye_temp, double* msd );
+  NCRYSTAL_API void ncrystal_info_getatompos_all( ncrystal_info_t, double* xyz );
 
   /*Access dynamic info:                                                           */
   /*ditypeid: 0->nonscat, 1:freegas, 2:scatknl 3:vdos, 4:vdosdebye, 99:unknown     */
@@ -299,6 +335,11 @@ extern "C" {
   NCRYSTAL_API unsigned ncrystal_info_customsec_nlines( ncrystal_info_t, unsigned isection );
   NCRYSTAL_API unsigned ncrystal_info_customline_nparts( ncrystal_info_t, unsigned isection, unsigned iline );
   NCRYSTAL_API const char* ncrystal_info_customline_getpart( ncrystal_info_t, unsigned isection, unsigned iline, unsigned ipart );
+  /* Bulk access to all custom sections. Resulting string list must be deallocated */
+  /* by a call to ncrystal_dealloc_stringlist, and contains entries in the format  */
+  /* name0,content0,name1,content1,.., where the content has one line per line of  */
+  /* the section, with the parts of each line separated by single spaces:          */
+  NCRYSTAL_API void ncrystal_info_getcustomsections_all( ncrystal_info_t, unsigned* nstrs, char*** strs );
 
   /*============================================================================== */
   /*============================================================================== */
@@ -327,6 +368,12 @@ extern "C" {
   /*each error:                                                                    */
   NCRYSTAL_API void ncrystal_seterrhandler(void (*handler)(char*,char*));
 
+  /*The error status (as returned by the functions above) is kept separately for   */
+  /*each thread, so it is only affected by calls made in the current thread. The   */
+  /*legacy behaviour of a single process-wide status can be enabled by calling     */
+  /*ncrystal_setthreadlocalerrors(0):                                              */
+  NCRYSTAL_API int ncrystal_setthreadlocalerrors(int);/* returns old value */
+
   /*============================================================================== */
   /*============================================================================== */
   /*==                                                                          == */
@@ -343,6 +390,12 @@ extern "C" {
   /* of thread_local objects perhaps).                                             */
   NCRYSTAL_API void ncrystal_setrandgen( double (*rg)() );
 
+  /* Same, but with a callback which must fill the provided array with the       */
+  /* requested number of random numbers. NCrystal will request numbers in large  */
+  /* batches and keep them in a per-thread buffer, which is much more efficient  */
+  /* when the callback is expensive to invoke (e.g. from Python).                */
+  NCRYSTAL_API void ncrystal_setrandgen_bulk( void (*rg)(double*,unsigned) );
+
   /* It is also possible to (re) set the RNG to the builtin generator (optionally  */
   /* by state or integer seed) */
   NCRYSTAL_API void ncrystal_setbuiltinrandgen();
@@ -416,6 +469,48 @@ extern "C" {
   /* Dump info to stdout:                                                          */
   NCRYSTAL_API void ncrystal_dump(ncrystal_info_t);
 
+  /* Approximate memory footprint in bytes, separating memory owned exclusively    */
+  /* by the object (and its components) from memory of sub-objects also shared     */
+  /* with others, e.g. factory caches (see MemoryFootprint in NCMem.hh). The dump  */
+  /* functions print the same to stdout, with a per-component breakdown for        */
+  /* processes:                                                                    */
+  NCRYSTAL_API void ncrystal_info_memory_footprint( ncrystal_info_t,
+                                                    double* exclusive_bytes,
+                                                    double* shared_bytes );
+  NCRYSTAL_API void ncrystal_process_memory_footprint( ncrystal_process_t,
+                                                       double* exclusive_bytes,
+                                                       double* shared_bytes );
+  NCRYSTAL_API void ncrystal_dump_info_memory_footprint( ncrystal_info_t );
+  NCRYSTAL_API void ncrystal_dump_process_memory_footprint( ncrystal_process_t );
+
+  /* Create profiled clones of scatter or absorption objects, which give identical */
+  /* results but in which a fraction (sample_fraction, e.g. 0.01) of the calls to  */
+  /* the process and each of its components are timed (see ProfiledProcess in      */
+  /* NCProcImpl.hh). For every report_interval calls, the callback is invoked with */
+  /* the userdata pointer and a summary of the n processes in the tree (the first  */
+  /* entry is the top-level process, with depth 0, and its components have depth   */
+  /* 1): numbers of cross section evaluations and sampled scatterings, and the     */
+  /* estimated total times spent in them [s]. Statistics are cumulative and shared */
+  /* by all clones of the returned object. The callback must not use the object.   */
+  /* Returned objects must be cleaned up with ncrystal_unref.                      */
+  typedef void (*ncrystal_profile_callback_t)( void* userdata, unsigned n,
+                                               const char** names,
+                                               const unsigned* depths,
+                                               const double* ncalls_xs,
+                                               const double* time_xs,
+                                               const double* ncalls_sampling,
+                                               const double* time_sampling );
+  NCRYSTAL_API ncrystal_scatter_t ncrystal_create_profiled_scatter( ncrystal_scatter_t,
+                                                                    ncrystal_profile_callback_t,
+                                                                    void* userdata,
+                                                                    unsigned long report_interval,
+                                                                    double sample_fraction );
+  NCRYSTAL_API ncrystal_absorption_t ncrystal_create_profiled_absorption( ncrystal_absorption_t,
+                                                                          ncrystal_profile_callback_t,
+                                                                          void* userdata,
+                                                                          unsigned long report_interval,
+                                                                          double sample_fraction );
+
   /* Utility converting between neutron wavelength [Aa] to kinetic energy [eV]:    */
   NCRYSTAL_API double ncrystal_wl2ekin( double wl );
   NCRYSTAL_API double ncrystal_ekin2wl( double ekin );
@@ -447,11 +542,53 @@ extern "C" {
   /* Clear various caches employed inside NCrystal:                                */
   NCRYSTAL_API void ncrystal_clear_caches();
 
+  /* Set number of threads used for expensive initialisation work, overriding  */
+  /* the NCRYSTAL_NTHREADS environment variable (0 means all available hardware */
+  /* threads). Should be called before creating any objects:                     */
+  NCRYSTAL_API void ncrystal_setnthreads( unsigned );
+
+  /* Save snapshot of derived data needed by a list of cfg-strings into a single  */
+  /* binary file, or load such a snapshot so that the data will not have to be     */
+  /* recomputed (see NCFactImpl.hh for details). Saving clears all caches:        */
+  NCRYSTAL_API void ncrystal_save_snapshot( const char * path, unsigned ncfgstrs,
+                                            const char ** cfgstrs );
+  /* Same, but creating the objects for different cfg-strings in parallel using */
+  /* nthreads threads (0 means all available hardware threads):                 */
+  NCRYSTAL_API void ncrystal_save_snapshot_mt( const char * path, unsigned ncfgstrs,
+                                               const char ** cfgstrs, unsigned nthreads );
+  NCRYSTAL_API void ncrystal_load_snapshot( const char * path );
+  /* Same, but returning the snapshot data in a newly allocated buffer of *size   */
+  /* bytes (to be deallocated with ncrystal_dealloc_string), and loading it from  */
+  /* such a buffer (the data is copied, so the buffer can be deallocated after): */
+  NCRYSTAL_API char* ncrystal_save_snapshot_to_memory( unsigned ncfgstrs, const char ** cfgstrs,
+                                                       unsigned nthreads, unsigned long* size );
+  NCRYSTAL_API void ncrystal_load_snapshot_from_memory( const char * data, unsigned long size );
+
+  /* Convert NCMAT data into the binary NCMAT format (see NCNCMATBinary.hh), and */
+  /* write the result to the indicated output file:                              */
+  NCRYSTAL_API void ncrystal_ncmat2binary( const char * datasrc, const char * outpath );
+
   /* Get list of plugins. Resulting string list must be deallocated by a call to   */
   /* ncrystal_dealloc_stringlist by, and contains entries in the format            */
   /* pluginname0,filename0,plugintype0,pluginname1,filename1,plugintype1,...:      */
   NCRYSTAL_API void ncrystal_get_plugin_list( unsigned* nstrs, char*** strs );
 
+  /* Get statistics for all caches used so far. Resulting string list must be     */
+  /* deallocated by a call to ncrystal_dealloc_stringlist, and contains entries    */
+  /* in the format name0,nstrongrefs0,nentries0,nbytes0,ninflight0,nhits0,         */
+  /* nmisses0,constructiontime0,name1,... (construction times in seconds):         */
+  NCRYSTAL_API void ncrystal_get_cache_stats( unsigned* nstrs, char*** strs );
+
+  /* Get values of the hot-path instrumentation counters (see NCCounters.hh).      */
+  /* These are only incremented if NCrystal was built with ENABLE_COUNTERS=ON, as  */
+  /* indicated by ncrystal_counters_enabled (otherwise all values are zero).       */
+  /* Resulting string list must be deallocated by a call to                        */
+  /* ncrystal_dealloc_stringlist, and contains entries in the format               */
+  /* name0,value0,name1,value1,...:                                                */
+  NCRYSTAL_API int ncrystal_counters_enabled();
+  NCRYSTAL_API void ncrystal_get_counters( unsigned* nstrs, char*** strs );
+  NCRYSTAL_API void ncrystal_reset_counters();
+
   /* Deallocate strings:                                                           */
   NCRYSTAL_API void ncrystal_dealloc_stringlist( unsigned len, char** );
   NCRYSTAL_API void ncrystal_dealloc_string( char* );
@@ -488,6 +625,9 @@ extern "C" {
   /*============================================================================== */
   /*============================================================================== */
 
+  /* The sampling functions below give results identical to those of repeated   */
+  /* calls to ncrystal_samplescatterisotropic/ncrystal_samplescatter. See the    */
+  /* batch (_soa) interfaces further below for faster vectorised alternatives.  */
   NCRYSTAL_API void ncrystal_samplescatterisotropic_many( ncrystal_scatter_t,
                                                           const double * ekin,
                                                           unsigned long n_ekin,
@@ -504,12 +644,227 @@ extern "C" {
                                                  double * results_diry,
                                                  double * results_dirz );
 
+  /* Sample n_samples isotropic scatterings at ekin and fill their distribution  */
+  /* into a histogram, so that only bin contents must be transferred. The        */
+  /* histogram is 1D if yvar is 0 and 2D otherwise, with the variable codes:     */
+  /*   1: energy transfer ekin_final-ekin [eV]   2: mu=cos(scattering angle)     */
+  /*   3: momentum transfer Q [1/Aa]             4: alpha   5: beta              */
+  /* The dimensionless alpha and beta values are defined as in the S(alpha,beta) */
+  /* formalism at the indicated temperature [K] (which is ignored otherwise).    */
+  /* Results are written into results[ix*nbinsy+iy] (with nbinsy=1 for 1D        */
+  /* histograms), and sampled values outside the histogram ranges are simply     */
+  /* not counted. Samplings are done in fixed-size chunks, distributed over      */
+  /* nthreads threads (0 means all available hardware threads), using            */
+  /* independent RNG streams produced from the RNG producer of the scatter       */
+  /* handle. Since streams are assigned to chunks rather than threads, results   */
+  /* do not depend on nthreads:                                                  */
+  NCRYSTAL_API void ncrystal_samplescatterisotropic_hist( ncrystal_scatter_t,
+                                                          double ekin,
+                                                          unsigned long n_samples,
+                                                          int xvar, unsigned nbinsx,
+                                                          double xmin, double xmax,
+                                                          int yvar, unsigned nbinsy,
+                                                          double ymin, double ymax,
+                                                          double temperature,
+                                                          unsigned nthreads,
+                                                          double * results );
+
   NCRYSTAL_API void ncrystal_crosssection_nonoriented_many( ncrystal_process_t,
                                                             const double * ekin,
                                                             unsigned long n_ekin,
                                                             unsigned long repeat,
                                                             double* results );
 
+  /* Evaluate cross sections for all combinations of n_ekin energies and n_dir   */
+  /* directions, writing the cross section for ekin[i] and direction[j] into     */
+  /* results[i*n_dir+j] (so n_ekin*n_dir values in total). The energies are      */
+  /* split over nthreads threads (0 means all available hardware threads), each  */
+  /* with its own copy of any caches:                                            */
+  NCRYSTAL_API void ncrystal_crosssection_grid( ncrystal_process_t,
+                                                const double * ekin,
+                                                unsigned long n_ekin,
+                                                const double (*direction)[3],
+                                                unsigned long n_dir,
+                                                unsigned nthreads,
+                                                double* results );
+
+  /* Flux-weighted averages of the cross section of an isotropic process over   */
+  /* n_bounds-1 energy groups with the given n_bounds increasing group bounds   */
+  /* [eV], written into results. The flux is given by a table of n_flux points  */
+  /* (flux_ekin,flux_values) which is linearly interpolated and must cover all  */
+  /* groups, or a 1/E spectrum is assumed if n_flux is 0. Integrals are carried */
+  /* out natively, with adaptive integration between known discontinuities and */
+  /* kinks of the cross section (e.g. Bragg edges and S(alpha,beta) grid        */
+  /* points) to the requested relative precision, and with the work split over */
+  /* nthreads threads (0 means all available hardware threads). Results do not  */
+  /* depend on nthreads:                                                        */
+  NCRYSTAL_API void ncrystal_groupaveraged_xs( ncrystal_process_t,
+                                               const double * group_bounds,
+                                               unsigned long n_bounds,
+                                               const double * flux_ekin,
+                                               const double * flux_values,
+                                               unsigned long n_flux,
+                                               double precision,
+                                               unsigned nthreads,
+                                               double* results );
+
+  /* Batch (structure-of-arrays) interfaces. These operate on n neutrons at a    */
+  /* time, with each state component in a separate array, and are forwarded     */
+  /* directly to the vectorised implementations of the physics models. All      */
+  /* modifiable state (caches and RNG stream) is kept in an explicit batch       */
+  /* context object, and the process handles passed to these functions are only */
+  /* read. Thus, different threads can use the same scatter or absorption       */
+  /* handle concurrently without cloning, as long as each thread uses its own   */
+  /* batch context.                                                             */
+  /*                                                                            */
+  /* A context is tied to the physics of the process it was created from, but   */
+  /* can also be used with clones of that process. For scatter handles, the     */
+  /* context gets its own RNG stream (by index, or for the current thread, see  */
+  /* also ncrystal_clone_scatter_rngbyidx). Contexts for absorption handles     */
+  /* have no RNG stream (the rngstreamidx argument is ignored). Contexts must be */
+  /* cleaned up with ncrystal_unref.                                            */
+  NCRYSTAL_API ncrystal_batchctx_t ncrystal_create_batchctx( ncrystal_process_t,
+                                                             unsigned long rngstreamidx );
+  NCRYSTAL_API ncrystal_batchctx_t ncrystal_create_batchctx_forcurrentthread( ncrystal_process_t );
+
+  /* Context which instead of an NCrystal RNG stream uses a caller-provided     */
+  /* callback, which must fill the array tgt with n random numbers uniformly in */
+  /* (0,1]. The userdata pointer is passed along unchanged, and can for instance */
+  /* point to the state of a generator owned by the caller (one per context).   */
+  /* Using such contexts, neither process handles nor the global RNG set with   */
+  /* ncrystal_setrandgen are involved in any mutable state:                     */
+  NCRYSTAL_API ncrystal_batchctx_t ncrystal_create_batchctx_customrng( ncrystal_process_t,
+                                                                      void (*rg)(void* userdata,
+                                                                                 double* tgt,
+                                                                                 unsigned n),
+                                                                      void* userdata );
+
+  /* Single-neutron versions of the functions below, for transport codes which  */
+  /* track neutrons one at a time (e.g. with a dynamic thread pool) and want to */
+  /* share one process handle between all threads without cloning it. Each     */
+  /* thread (or task) should simply use its own context:                        */
+  NCRYSTAL_API void ncrystal_crosssection_nonoriented_ctx( ncrystal_process_t,
+                                                           ncrystal_batchctx_t,
+                                                           double ekin,
+                                                           double* result );
+  NCRYSTAL_API void ncrystal_crosssection_ctx( ncrystal_process_t,
+                                               ncrystal_batchctx_t,
+                                               double ekin,
+                                               const double (*direction)[3],
+                                               double* result );
+  NCRYSTAL_API void ncrystal_samplescatterisotropic_ctx( ncrystal_scatter_t,
+                                                         ncrystal_batchctx_t,
+                                                         double ekin,
+                                                         double* ekin_final,
+                                                         double* cos_scat_angle );
+  NCRYSTAL_API void ncrystal_samplescatter_ctx( ncrystal_scatter_t,
+                                                ncrystal_batchctx_t,
+                                                double ekin,
+                                                const double (*direction)[3],
+                                                double* ekin_final,
+                                                double (*direction_final)[3] );
+
+  /* Even faster versions of the single-neutron functions above, for the       */
+  /* innermost loops of transport codes. A context is resolved (and validated  */
+  /* against the process) once, and the resulting ncrystal_fastctx_t simply    */
+  /* points directly to the physics model, cache and RNG stream of the context. */
+  /* The "unchecked" functions then skip all handle validation, and forward     */
+  /* directly to the physics model. A fast context does not hold a reference,  */
+  /* so must only be used while the batch context is alive. Passing invalid or */
+  /* wrong handles (including fast contexts of absorption processes to the     */
+  /* sampling functions) results in undefined behaviour. Errors raised by the  */
+  /* physics models are still handled as usual:                                */
+  typedef struct { void * internal; } ncrystal_fastctx_t;
+  NCRYSTAL_API ncrystal_fastctx_t ncrystal_resolve_batchctx( ncrystal_process_t,
+                                                             ncrystal_batchctx_t );
+  NCRYSTAL_API double ncrystal_crosssection_nonoriented_unchecked( ncrystal_fastctx_t,
+                                                                   double ekin );
+  NCRYSTAL_API double ncrystal_crosssection_unchecked( ncrystal_fastctx_t,
+                                                       double ekin,
+                                                       const double (*direction)[3] );
+  NCRYSTAL_API void ncrystal_samplescatterisotropic_unchecked( ncrystal_fastctx_t,
+                                                               double ekin,
+                                                               double* ekin_final,
+                                                               double* cos_scat_angle );
+  NCRYSTAL_API void ncrystal_samplescatter_unchecked( ncrystal_fastctx_t,
+                                                      double ekin,
+                                                      const double (*direction)[3],
+                                                      double* ekin_final,
+                                                      double (*direction_final)[3] );
+
+  /* Sample scatterings, updating the neutron states (ekin and direction       */
+  /* arrays) in place. The isotropic version writes the cosines of scattering  */
+  /* angles to the results_cos_scat_angle array. NB: Random numbers are        */
+  /* consumed differently than in the single-neutron functions, so results for */
+  /* a given RNG seed differ from those of repeated single-neutron calls:      */
+  NCRYSTAL_API void ncrystal_samplescatter_soa( ncrystal_scatter_t,
+                                                ncrystal_batchctx_t,
+                                                unsigned long n,
+                                                double * ekin,
+                                                double * dirx,
+                                                double * diry,
+                                                double * dirz );
+  NCRYSTAL_API void ncrystal_samplescatterisotropic_soa( ncrystal_scatter_t,
+                                                         ncrystal_batchctx_t,
+                                                         unsigned long n,
+                                                         double * ekin,
+                                                         double * results_cos_scat_angle );
+
+  /* Evaluate cross sections (works for both scatter and absorption handles):  */
+  NCRYSTAL_API void ncrystal_crosssection_soa( ncrystal_process_t,
+                                               ncrystal_batchctx_t,
+                                               unsigned long n,
+                                               const double * ekin,
+                                               const double * dirx,
+                                               const double * diry,
+                                               const double * dirz,
+                                               double * results );
+  NCRYSTAL_API void ncrystal_crosssection_nonoriented_soa( ncrystal_process_t,
+                                                           ncrystal_batchctx_t,
+                                                           unsigned long n,
+                                                           const double * ekin,
+                                                           double * results );
+
+  /* Export flat tables describing a non-oriented scatter process, for usage in  */
+  /* code which can not call NCrystal during tracking (e.g. on GPUs). The        */
+  /* tables are defined on a grid of n_ekin energies, logarithmically spaced     */
+  /* from ekin_min to ekin_max (both in eV), which is written to results_ekin.   */
+  /* For each grid point, the cross section is written into results_xs, and      */
+  /* n_samples scatterings are sampled using the RNG stream of the scatter       */
+  /* handle, writing the energy transfers (ekin_final-ekin) and cosines of       */
+  /* scattering angles into results_sampled_dekin and results_sampled_mu         */
+  /* (n_ekin*n_samples values each, with the samples for the i'th grid point at  */
+  /* indices i*n_samples..(i+1)*n_samples-1). Note that such tables are          */
+  /* approximations, which can for instance not resolve the sharp features of    */
+  /* Bragg edges between grid points:                                            */
+  NCRYSTAL_API void ncrystal_export_flattables( ncrystal_scatter_t,
+                                                double ekin_min,
+                                                double ekin_max,
+                                                unsigned n_ekin,
+                                                unsigned n_samples,
+                                                double * results_ekin,
+                                                double * results_xs,
+                                                double * results_sampled_dekin,
+                                                double * results_sampled_mu );
+
+  /* Export a non-oriented scatter process to a single flat and pointer-free     */
+  /* memory blob which can be copied verbatim to GPUs and evaluated there with   */
+  /* the header-only (and NCrystal-independent) functions in ncflatblob.h, where */
+  /* the layout is also described. Powder Bragg diffraction components are       */
+  /* stored exactly, while other components are tabulated on a union grid based  */
+  /* on n_ekin logarithmically spaced energies from ekin_min to ekin_max (in eV) */
+  /* with n_samples outcomes sampled (with the RNG stream of the scatter handle) */
+  /* at each grid point. The size of the returned blob (in bytes) is written to  */
+  /* result_nbytes. The blob must be deallocated with ncrystal_dealloc_flatblob, */
+  /* and NULL is returned in case of errors:                                     */
+  NCRYSTAL_API void * ncrystal_export_flatblob( ncrystal_scatter_t,
+                                                double ekin_min,
+                                                double ekin_max,
+                                                unsigned n_ekin,
+                                                unsigned n_samples,
+                                                unsigned long * result_nbytes );
+  NCRYSTAL_API void ncrystal_dealloc_flatblob( void * );
+
   /*============================================================================== */
   /*============================================================================== */
   /*==                                                                          == */
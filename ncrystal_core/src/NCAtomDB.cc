@@ -103,13 +103,46 @@ namespace NCrystal {
         return s_db;
       }
 
+      //Index into the (sorted) internal DB, giving for each Z the range of
+      //entries with that Z (the natural element, if present, is first):
+      struct ZIndex {
+        static constexpr unsigned nz = 150;
+        std::array<uint32_t,nz+1> zbegin;
+        ZIndex( const std::vector<Entry>& db )
+        {
+          std::size_t i = 0;
+          for ( unsigned z = 0; z <= nz; ++z ) {
+            while ( i < db.size() && db[i].Z() < z )
+              ++i;
+            zbegin[z] = static_cast<uint32_t>(i);
+          }
+          nc_assert_always( zbegin[nz] == db.size() );
+        }
+      };
+      const ZIndex& internalDBZIndex() {
+        static ZIndex s_idx( internalDB() );
+        return s_idx;
+      }
+
+      std::size_t lookupEntryIdx( AtomDBKey key )
+      {
+        //Returns db.size() if not found. Each Z has at most a few dozen
+        //isotopes, so a linear scan within the Z range is fast.
+        const auto& db = internalDB();
+        const auto& zidx = internalDBZIndex();
+        const unsigned Z = key.Z();
+        nc_assert( Z < ZIndex::nz );
+        for ( std::size_t i = zidx.zbegin[Z]; i < zidx.zbegin[Z+1]; ++i )
+          if ( db[i].key() == key )
+            return i;
+        return db.size();
+      }
+
       const Entry* lookupEntry( AtomDBKey key )
       {
         const auto& db = internalDB();
-        auto it = std::lower_bound(db.begin(),db.end(),key);
-        if ( it == db.end() || it->key() != key )
-          return nullptr;
-        return &(*it);
+        auto i = lookupEntryIdx( key );
+        return i < db.size() ? &db[i] : nullptr;
       }
 
     //This template argument of base class is true, i.e. factory keeps strong
@@ -144,6 +177,47 @@ namespace NCrystal {
 
       static StdAtomDataFactory s_stdAtomDBFact;
 
+      //Since the factory anyway keeps all objects alive, the resulting
+      //AtomDataSP objects are also kept in a small table indexed like the
+      //internal DB, which avoids the (relatively expensive) general factory
+      //machinery on repeated lookups. It is cleared along with other caches.
+      class FastAtomDataCache {
+      public:
+        OptionalAtomDataSP get( AtomDBKey key )
+        {
+          const auto& db = internalDB();
+          const std::size_t i = lookupEntryIdx( key );
+          if ( i == db.size() )
+            return nullptr;
+          //Register outside our own lock, to preserve lock ordering w.r.t. the
+          //global cache cleanup:
+          static bool s_registered = [this](){ registerCacheCleanupFunction( [this](){ this->clear(); } ); return true; }();
+          (void)s_registered;
+          {
+            NCRYSTAL_LOCK_GUARD(m_mutex);
+            if ( m_sps.empty() )
+              m_sps.resize( db.size() );
+            if ( m_sps[i] != nullptr )
+              return m_sps[i];
+          }
+          //Create outside the lock (the factory does its own locking):
+          OptionalAtomDataSP res = s_stdAtomDBFact.create( key );
+          NCRYSTAL_LOCK_GUARD(m_mutex);
+          if ( i < m_sps.size() )
+            m_sps[i] = res;
+          return res;
+        }
+        void clear()
+        {
+          NCRYSTAL_LOCK_GUARD(m_mutex);
+          m_sps.clear();
+        }
+      private:
+        std::mutex m_mutex;
+        std::vector<OptionalAtomDataSP> m_sps;
+      };
+      static FastAtomDataCache s_fastAtomDataCache;
+
     }
   }
 }
@@ -152,7 +226,7 @@ NC::OptionalAtomDataSP NC::AtomDB::getNaturalElement( unsigned Z )
 {
   if (!internal::AtomDBKey::isZAValid(Z,0))
     return nullptr;
-  return internal::s_stdAtomDBFact.create(internal::AtomDBKey(Z,0));
+  return internal::s_fastAtomDataCache.get(internal::AtomDBKey(Z,0));
 }
 
 NC::OptionalAtomDataSP NC::AtomDB::getNaturalElement( const std::string& name )
@@ -161,14 +235,14 @@ NC::OptionalAtomDataSP NC::AtomDB::getNaturalElement( const std::string& name )
   unsigned Z = elementNameToZ(name);
   if (Z==0)
     return nullptr;
-  return internal::s_stdAtomDBFact.create(internal::AtomDBKey(Z,0));
+  return internal::s_fastAtomDataCache.get(internal::AtomDBKey(Z,0));
 }
 
 NC::OptionalAtomDataSP NC::AtomDB::getIsotope( unsigned Z, unsigned A )
 {
   if (!internal::AtomDBKey::isZAValid(Z,A))
     return nullptr;
-  return A>=Z ? internal::s_stdAtomDBFact.create(internal::AtomDBKey(Z,A)) : nullptr;
+  return A>=Z ? internal::s_fastAtomDataCache.get(internal::AtomDBKey(Z,A)) : nullptr;
 }
 
 NC::OptionalAtomDataSP NC::AtomDB::getIsotope( const std::string& name )
@@ -183,7 +257,7 @@ NC::OptionalAtomDataSP NC::AtomDB::getIsotopeOrNatElem( unsigned Z, unsigned A )
 {
   if (!internal::AtomDBKey::isZAValid(Z,A))
     return nullptr;
-  return internal::s_stdAtomDBFact.create(internal::AtomDBKey(Z,A));
+  return internal::s_fastAtomDataCache.get(internal::AtomDBKey(Z,A));
 }
 
 NC::OptionalAtomDataSP NC::AtomDB::getIsotopeOrNatElem( const std::string& name )
@@ -196,7 +270,7 @@ NC::OptionalAtomDataSP NC::AtomDB::getIsotopeOrNatElem( const std::string& name
   if (!internal::AtomDBKey::isZAValid(Z,A))
     return nullptr;
 
-  return internal::s_stdAtomDBFact.create(internal::AtomDBKey(Z,A));
+  return internal::s_fastAtomDataCache.get(internal::AtomDBKey(Z,A));
 }
 
 unsigned NC::AtomDB::getAllEntriesCount()
@@ -38,14 +38,42 @@ namespace NCrystal {
       "Cf"_s, "Es"_s, "Fm"_s, "Md"_s, "No"_s, "Lr"_s, "Rf"_s, "Db"_s, "Sg"_s, "Bh"_s,
       "Hs"_s, "Mt"_s, "Ds"_s, "Rg"_s, "Cn"_s, "Nh"_s, "Fl"_s, "Mc"_s, "Lv"_s, "Ts"_s,
       "Og"_s };
-    static const std::map<std::string,unsigned> s_natelem_name2z_map = []()
+    //Element symbols are one uppercase letter optionally followed by one
+    //lowercase letter, so a direct-indexed table over those two characters
+    //serves as a (collision free) perfect hash of the list above:
+    constexpr unsigned s_name2z_ncol = 27;
+    constexpr unsigned s_name2z_invalid = 26*s_name2z_ncol;
+    inline unsigned natElemTableIdx( const std::string& name )
     {
-      std::map<std::string,unsigned> mm;
-      constexpr unsigned zmax = (sizeof(s_natelemlist)/sizeof(s_natelemlist[0]));
-      for (unsigned zm1 = 0; zm1<zmax; ++zm1)
-        mm[s_natelemlist[zm1]] = zm1+1;
-      return mm;
-    }();
+      //Returns s_name2z_invalid for anything which can not be an element symbol:
+      const std::size_t n = name.size();
+      if ( n < 1 || n > 2 )
+        return s_name2z_invalid;
+      const char c0 = name[0];
+      if ( c0 < 'A' || c0 > 'Z' )
+        return s_name2z_invalid;
+      if ( n == 1 )
+        return unsigned(c0-'A')*s_name2z_ncol;
+      const char c1 = name[1];
+      if ( c1 < 'a' || c1 > 'z' )
+        return s_name2z_invalid;
+      return unsigned(c0-'A')*s_name2z_ncol + unsigned(c1-'a') + 1;
+    }
+    struct NatElemName2ZTable {
+      std::array<uint8_t,s_name2z_invalid+1> z;//last entry is always 0
+      NatElemName2ZTable()
+      {
+        z.fill(0);
+        constexpr unsigned zmax = (sizeof(s_natelemlist)/sizeof(s_natelemlist[0]));
+        static_assert(zmax<256,"");
+        for (unsigned zm1 = 0; zm1<zmax; ++zm1) {
+          unsigned idx = natElemTableIdx( s_natelemlist[zm1] );
+          nc_assert_always( idx < s_name2z_invalid && z[idx] == 0 );
+          z[idx] = static_cast<uint8_t>(zm1+1);
+        }
+      }
+    };
+    static const NatElemName2ZTable s_natelem_name2z_table;
 
   }
 }
@@ -61,8 +89,7 @@ const std::string& NC::elementZToName(unsigned z)
 }
 
 unsigned NC::elementNameToZ(const std::string& name) {
-  auto it = s_natelem_name2z_map.find(name);
-  return ( it == s_natelem_name2z_map.end() ? 0 : it->second );
+  return s_natelem_name2z_table.z[natElemTableIdx( name )];
 }
 
 void NC::AtomSymbol::longInit(const std::string& symbol)
@@ -23,18 +23,89 @@
 
 namespace NC = NCrystal;
 
-NC::BkgdExtCurve::BkgdExtCurve( shared_obj<const Info> ci )
+NC::BkgdExtCurve::BkgdExtCurve( shared_obj<const Info> ci, double tableprec )
   : m_ci(std::move(ci))
 {
   if (!m_ci->providesNonBraggXSects())
     NCRYSTAL_THROW(MissingInfo,"BkgdExtCurve: Passed Info object lacks NonBraggXSects needed for cross sections.");
+  if ( !( tableprec >= 0.0 && tableprec < 1.0 ) )
+    NCRYSTAL_THROW2(BadInput,"BkgdExtCurve: invalid table precision: "<<tableprec);
+  if ( tableprec > 0.0 )
+    m_table.init( *m_ci, tableprec );
 }
 
 NC::BkgdExtCurve::~BkgdExtCurve() = default;
 
-NC::CrossSect NC::BkgdExtCurve::crossSectionIsotropic(NC::CachePtr&, NC::NeutronEnergy ekin ) const
+void NC::BkgdExtCurve::Table::init( const Info& info, double precision )
 {
-  return m_ci->xsectScatNonBragg(ekin);
+  constexpr double table_emin = 1e-5;//eV
+  constexpr double table_emax = 10.0;//eV
+  constexpr unsigned npts_per_decade_init = 16;
+  constexpr unsigned npts_per_decade_max = 4096;
+  const double ndecades = std::log10( table_emax / table_emin );
+  const double logemin = std::log( table_emin );
+  const double logemax = std::log( table_emax );
+  auto evalExact = [&info]( double loge ) { return info.xsectScatNonBragg( NeutronEnergy{ std::exp( loge ) } ).dbl(); };
+
+  //Start with a coarse grid and keep doubling the density. The midpoints
+  //evaluated in the check at one level are reused as grid points at the next:
+  std::size_t nintervals = static_cast<std::size_t>( npts_per_decade_init * ndecades + 0.5 );
+  const std::size_t nintervals_max = static_cast<std::size_t>( npts_per_decade_max * ndecades + 0.5 );
+  VectD xs, xsmid;
+  xs.reserve( nintervals + 1 );
+  for ( std::size_t i = 0; i <= nintervals; ++i )
+    xs.push_back( evalExact( logemin + ( logemax - logemin ) * double(i) / nintervals ) );
+
+  //Errors elsewhere in the intervals might slightly exceed the ones at the
+  //midpoints, so aim a bit lower than requested:
+  const double tolfact = 0.5 * precision;
+  auto midpointOK = [tolfact]( double a, double b, double exact_mid )
+  {
+    return ncabs( 0.5 * ( a + b ) - exact_mid ) <= tolfact * ncabs( exact_mid ) + 1e-12;
+  };
+
+  while ( true ) {
+    const double dloge = ( logemax - logemin ) / nintervals;
+    xsmid.clear();
+    xsmid.reserve( nintervals );
+    bool allok = true;
+    for ( std::size_t i = 0; i < nintervals; ++i ) {
+      xsmid.push_back( evalExact( logemin + ( i + 0.5 ) * dloge ) );
+      if ( allok && !midpointOK( xs[i], xs[i+1], xsmid.back() ) )
+        allok = false;
+    }
+    if ( allok || 2 * nintervals > nintervals_max ) {
+      if ( !allok ) {
+        m_exact.resize( nintervals, 0 );
+        for ( std::size_t i = 0; i < nintervals; ++i )
+          m_exact[i] = midpointOK( xs[i], xs[i+1], xsmid[i] ) ? 0 : 1;
+      }
+      break;
+    }
+    VectD xsnew;
+    xsnew.reserve( 2 * nintervals + 1 );
+    for ( std::size_t i = 0; i < nintervals; ++i ) {
+      xsnew.push_back( xs[i] );
+      xsnew.push_back( xsmid[i] );
+    }
+    xsnew.push_back( xs.back() );
+    xs.swap( xsnew );
+    nintervals *= 2;
+  }
+
+  xs.shrink_to_fit();
+  m_xs = std::move( xs );
+  m_emin = table_emin;
+  m_emax = table_emax;
+  m_logemin = logemin;
+  m_invdloge = nintervals / ( logemax - logemin );
+}
+
+void NC::BkgdExtCurve::evalManyXSIsotropic( CachePtr& cp, const double* ekin, std::size_t N,
+                                            double* out_xs ) const
+{
+  for ( std::size_t i = 0; i < N; ++i )
+    out_xs[i] = crossSectionIsotropic( cp, NeutronEnergy{ ekin[i] } ).dbl();
 }
 
 NC::ScatterOutcomeIsotropic NC::BkgdExtCurve::sampleScatterIsotropic( CachePtr&,
@@ -50,3 +121,16 @@ NC::ScatterOutcome NC::BkgdExtCurve::sampleScatter( CachePtr&, RNG& rng, Neutron
   //Elastic, isotropic.
   return { ekin, randIsotropicNeutronDirection(rng) };
 }
+
+void NC::BkgdExtCurve::sampleScatterMany( CachePtr&, RNG& rng, double*,
+                                          double* ux, double* uy, double* uz,
+                                          std::size_t N ) const
+{
+  //Elastic, isotropic.
+  for ( std::size_t i = 0; i < N; ++i ) {
+    auto dir = randIsotropicDirection(rng);
+    ux[i] = dir.x();
+    uy[i] = dir.y();
+    uz[i] = dir.z();
+  }
+}
@@ -0,0 +1,78 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+//  This file is part of NCrystal (see https://mctools.github.io/ncrystal/)   //
+//                                                                            //
+//  Copyright 2015-2021 NCrystal developers                                   //
+//                                                                            //
+//  Licensed under the Apache License, Version 2.0 (the "License");           //
+//  you may not use this file except in compliance with the License.          //
+//  You may obtain a copy of the License at                                   //
+//                                                                            //
+//      http://www.apache.org/licenses/LICENSE-2.0                            //
+//                                                                            //
+//  Unless required by applicable law or agreed to in writing, software       //
+//  distributed under the License is distributed on an "AS IS" BASIS,         //
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  //
+//  See the License for the specific language governing permissions and       //
+//  limitations under the License.                                            //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include "NCrystal/internal/NCCPUDispatch.hh"
+#include "NCrystal/internal/NCString.hh"
+
+namespace NC = NCrystal;
+
+NC::CPUDispatch::ISA NC::CPUDispatch::detectedISA()
+{
+  static const ISA s_isa = []()
+  {
+#ifdef NCRYSTAL_HAS_CPUDISPATCH
+    //NB: __builtin_cpu_supports also verifies that the OS saves the extended
+    //register state:
+    __builtin_cpu_init();
+    if ( __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq") )
+      return ISA::AVX512;
+    if ( __builtin_cpu_supports("avx2") )
+      return ISA::AVX2;
+#endif
+    return ISA::Baseline;
+  }();
+  return s_isa;
+}
+
+NC::CPUDispatch::ISA NC::CPUDispatch::activeISA()
+{
+  static const ISA s_isa = []()
+  {
+    const ISA detected = detectedISA();
+    const std::string ev = ncgetenv("SIMD");
+    if ( ev.empty() )
+      return detected;
+    ISA requested;
+    if ( ev == "scalar" )
+      requested = ISA::Scalar;
+    else if ( ev == "baseline" )
+      requested = ISA::Baseline;
+    else if ( ev == "avx2" )
+      requested = ISA::AVX2;
+    else if ( ev == "avx512" )
+      requested = ISA::AVX512;
+    else
+      NCRYSTAL_THROW2(BadInput,"Invalid value of NCRYSTAL_SIMD environment variable: \""<<ev
+                      <<"\" (valid values are scalar, baseline, avx2 and avx512)");
+    return ( static_cast<int>( requested ) < static_cast<int>( detected ) ? requested : detected );
+  }();
+  return s_isa;
+}
+
+const char * NC::CPUDispatch::isaName( ISA isa )
+{
+  switch ( isa ) {
+  case ISA::Scalar: return "scalar";
+  case ISA::Baseline: return "baseline";
+  case ISA::AVX2: return "avx2";
+  case ISA::AVX512: return "avx512";
+  }
+  return "unknown";
+}
@@ -22,6 +22,7 @@
 #include "NCrystal/internal/NCAtomUtils.hh"
 #include "NCrystal/internal/NCMath.hh"
 #include "NCrystal/internal/NCIter.hh"
+#include "NCrystal/internal/NCFactoryUtils.hh"
 #include <iomanip>
 #include <sstream>
 
@@ -34,6 +35,88 @@ namespace NCrystal {
   namespace {
     typedef std::vector< std::tuple<unsigned,unsigned,double> > Flat_ZAfrac;
 
+    void flatten_ZAfrac( Flat_ZAfrac& out, const AtomData& data, double weight )
+    {
+      //Flatten into (Z,A,fraction) entries, keeping natural elements as A=0:
+      if ( data.isComposite() ) {
+        unsigned nc = data.nComponents();
+        for ( unsigned i = 0; i < nc; ++i ) {
+          const auto& comp = data.getComponent(i);
+          flatten_ZAfrac(out,*comp.data,weight*comp.fraction);
+        }
+      } else {
+        nc_assert(data.Z()!=0);
+        out.emplace_back(data.Z(),data.isNaturalElement() ? 0 : data.A(),weight);
+      }
+    }
+
+    class CompositeBreakdownCache {
+    public:
+      //Flattened breakdowns of composite AtomData objects, keyed on their
+      //UID. Walking the component trees is thus only needed once per atom,
+      //even when it appears in many materials:
+      static constexpr std::size_t nmax_entries = 256;
+      using Value = std::shared_ptr<const Flat_ZAfrac>;
+
+      Value get( const AtomData& data )
+      {
+        nc_assert( data.isComposite() );
+        const auto key = data.getUniqueID();
+        {
+          NCRYSTAL_LOCK_GUARD(m_mtx);
+          auto it = m_entries.find(key);
+          if ( it != m_entries.end() ) {
+            ++m_nhits;
+            return it->second;
+          }
+          ++m_nmisses;
+        }
+        auto flat = std::make_shared<Flat_ZAfrac>();
+        flatten_ZAfrac( *flat, data, 1.0 );
+        NCRYSTAL_LOCK_GUARD(m_mtx);
+        if ( m_entries.size() >= nmax_entries )
+          m_entries.clear();//UIDs are never reused, so simply start over
+        return m_entries.emplace( key, std::move(flat) ).first->second;
+      }
+
+      void clear()
+      {
+        NCRYSTAL_LOCK_GUARD(m_mtx);
+        m_entries.clear();
+      }
+
+      FactoryCacheStats stats()
+      {
+        NCRYSTAL_LOCK_GUARD(m_mtx);
+        FactoryCacheStats s;
+        s.name = "CompositeBreakdownCache";
+        s.nstrongrefs = s.nentries = m_entries.size();
+        for ( const auto& e : m_entries )
+          s.nbytes += e.second->capacity() * sizeof(Flat_ZAfrac::value_type);
+        s.nhits = m_nhits;
+        s.nmisses = m_nmisses;
+        return s;
+      }
+
+    private:
+      std::mutex m_mtx;
+      std::map<UniqueIDValue,Value> m_entries;
+      uint64_t m_nhits = 0, m_nmisses = 0;
+    };
+
+    CompositeBreakdownCache& compositeBreakdownCache()
+    {
+      static CompositeBreakdownCache cache;
+      static bool registered = []()
+      {
+        registerCacheCleanupFunction( [](){ cache.clear(); } );
+        registerFactoryCacheStatsFunction( [](){ return cache.stats(); } );
+        return true;
+      }();
+      (void)registered;
+      return cache;
+    }
+
     template<class T>
     void collect_ZAfrac( Flat_ZAfrac& out,
                          const AtomData& data,
@@ -41,24 +124,22 @@ namespace NCrystal {
                          const T& natabprov,
                          CU::ForceIsotopesChoice forceiso )
     {
-      if (data.isNaturalElement()) {
-        nc_assert(data.Z()!=0);
-        if (forceiso==CU::ForceIsotopes) {
-          for (auto& Afrac : natabprov(data.Z()))
-            out.emplace_back(data.Z(),Afrac.first,Afrac.second*weight);
+      auto addEntry = [&out,&natabprov,forceiso]( unsigned Z, unsigned A, double w )
+      {
+        if ( A == 0 && forceiso == CU::ForceIsotopes ) {
+          for (auto& Afrac : natabprov(Z))
+            out.emplace_back(Z,Afrac.first,Afrac.second*w);
         } else {
-          out.emplace_back(data.Z(),0,weight);
+          out.emplace_back(Z,A,w);
         }
-      } else if (data.isSingleIsotope()) {
-        nc_assert(data.Z()!=0);
-        out.emplace_back(data.Z(),data.A(),weight);
+      };
+      if ( data.isComposite() ) {
+        auto flat = compositeBreakdownCache().get(data);
+        for ( const auto& e : *flat )
+          addEntry( std::get<0>(e), std::get<1>(e), std::get<2>(e) * weight );
       } else {
-        nc_assert(data.isComposite());
-        unsigned nc = data.nComponents();
-        for ( unsigned i = 0; i < nc; ++i ) {
-          const auto& comp = data.getComponent(i);
-          collect_ZAfrac(out,*comp.data,weight*comp.fraction,natabprov,forceiso);
-        }
+        nc_assert(data.Z()!=0);
+        addEntry( data.Z(), data.isNaturalElement() ? 0 : data.A(), weight );
       }
     }
   }
@@ -150,9 +231,10 @@ NC::CU::FullBreakdown NC::CU::createFullBreakdown( const Info::Composition& comp
   nc_assert_always(  (uint64_t)zafrac.size() < (uint64_t)(std::numeric_limits<unsigned>::max()) );
   const unsigned nzafrac = zafrac.size();
 
+  std::vector<std::pair<unsigned,StableSum>> current;
   for (unsigned i = 0; i < nzafrac; ) {
     unsigned zval = getZ(i);
-    std::vector<std::pair<unsigned,StableSum>> current;
+    current.clear();
     unsigned inext = i;
     for ( ; (inext < nzafrac && getZ(inext) == zval ); ++inext ) {
       if ( getFrac(inext) == 0.0 )
@@ -0,0 +1,81 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+//  This file is part of NCrystal (see https://mctools.github.io/ncrystal/)   //
+//                                                                            //
+//  Copyright 2015-2021 NCrystal developers                                   //
+//                                                                            //
+//  Licensed under the Apache License, Version 2.0 (the "License");           //
+//  you may not use this file except in compliance with the License.          //
+//  You may obtain a copy of the License at                                   //
+//                                                                            //
+//      http://www.apache.org/licenses/LICENSE-2.0                            //
+//                                                                            //
+//  Unless required by applicable law or agreed to in writing, software       //
+//  distributed under the License is distributed on an "AS IS" BASIS,         //
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  //
+//  See the License for the specific language governing permissions and       //
+//  limitations under the License.                                            //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include "NCrystal/internal/NCCounters.hh"
+
+namespace NC = NCrystal;
+
+#ifdef NCRYSTAL_ENABLE_COUNTERS
+std::atomic<uint64_t> NC::Counters::detail::s_counters[static_cast<unsigned>(NC::Counters::Id::N)] = {};
+#endif
+
+bool NC::Counters::enabled() noexcept
+{
+#ifdef NCRYSTAL_ENABLE_COUNTERS
+  return true;
+#else
+  return false;
+#endif
+}
+
+const char * NC::Counters::name( Id id )
+{
+  switch ( id ) {
+  case Id::ProcCompCacheHit: return "proccomp_cache_hit";
+  case Id::ProcCompCacheMiss: return "proccomp_cache_miss";
+  case Id::SCBraggCacheHit: return "scbragg_cache_hit";
+  case Id::SCBraggCacheMiss: return "scbragg_cache_miss";
+  case Id::LCBraggCacheHit: return "lcbragg_cache_hit";
+  case Id::LCBraggCacheMiss: return "lcbragg_cache_miss";
+  case Id::GOSCircleIntSlow: return "gos_circleint_slow";
+  case Id::GOSCircleIntNumInt: return "gos_circleint_numint";
+  case Id::SABAlg1Samples: return "sab_alg1_samples";
+  case Id::SABAlg1Iterations: return "sab_alg1_iterations";
+  case Id::RNGDraws: return "rng_draws";
+  case Id::AdaptXSLearn: return "adaptxs_learn";
+  case Id::AdaptXSTable: return "adaptxs_table";
+  case Id::N: break;
+  };
+  NCRYSTAL_THROW(BadInput,"Invalid counter id");
+}
+
+std::vector<std::pair<std::string,uint64_t>> NC::Counters::getAll()
+{
+  std::vector<std::pair<std::string,uint64_t>> res;
+  constexpr unsigned n = static_cast<unsigned>(Id::N);
+  res.reserve( n );
+  for ( unsigned i = 0; i < n; ++i ) {
+#ifdef NCRYSTAL_ENABLE_COUNTERS
+    const uint64_t value = detail::s_counters[i].load( std::memory_order_relaxed );
+#else
+    const uint64_t value = 0;
+#endif
+    res.emplace_back( name( static_cast<Id>(i) ), value );
+  }
+  return res;
+}
+
+void NC::Counters::resetAll()
+{
+#ifdef NCRYSTAL_ENABLE_COUNTERS
+  for ( auto& c : detail::s_counters )
+    c.store( 0, std::memory_order_relaxed );
+#endif
+}
@@ -22,7 +22,9 @@
 #include "NCrystal/NCFactImpl.hh"
 #include "NCrystal/internal/NCString.hh"
 #include "NCrystal/internal/NCFileUtils.hh"
+#include "NCrystal/internal/NCInflate.hh"
 #include "NCrystal/NCPluginMgmt.hh"
+#include <unordered_map>
 
 namespace NC = NCrystal;
 namespace NCD = NCrystal::DataSources;
@@ -86,7 +88,99 @@ void NCD::enableAbsolutePaths( bool doEnable )
 
 namespace NCrystal {
   namespace DataSources {
-    std::vector<BrowseEntry> browseDir( const std::string& dirname, Priority priority ) {
+
+    class DirIndex : private NoCopyMove {
+      //Names of all entries in a directory, read once upon construction. Whether
+      //or not an entry is a file is only checked when first needed.
+    public:
+      DirIndex( const std::string& dirname )
+        : m_dirname(dirname)
+      {
+        for ( const auto& pattern : { "/*", "/.*" } ) {
+          for ( const auto& f : ncglob(dirname+pattern) ) {
+            auto bn = basename(f);
+            if ( bn != "." && bn != ".." )
+              m_entries.emplace( std::move(bn), EntryType::Unknown );
+          }
+        }
+        m_names.reserve( m_entries.size() );
+        for ( const auto& e : m_entries )
+          m_names.push_back( e.first );
+        std::sort( m_names.begin(), m_names.end() );
+      }
+
+      bool hasFile( const std::string& name )
+      {
+        auto it = m_entries.find( name );
+        if ( it == m_entries.end() )
+          return false;
+        NCRYSTAL_LOCK_GUARD(m_mtx);
+        if ( it->second == EntryType::Unknown )
+          it->second = ( file_exists( path_join( m_dirname, name ) ) ? EntryType::File : EntryType::Other );
+        return it->second == EntryType::File;
+      }
+
+      //Sorted list of entries (i.e. with the same order as ncglob):
+      const VectS& names() const { return m_names; }
+
+    private:
+      enum class EntryType { Unknown, File, Other };
+      std::string m_dirname;
+      std::unordered_map<std::string,EntryType> m_entries;
+      VectS m_names;
+      std::mutex m_mtx;
+    };
+
+    struct DirIndexDB {
+      std::mutex mtx;
+      std::map<std::string,shared_obj<DirIndex>> indices;
+      std::atomic<bool> enabled{ !ncgetenv_bool("NO_DIRINDEX") };
+    };
+    DirIndexDB& getDirIndexDB() { static DirIndexDB db; return db; }
+
+    shared_obj<DirIndex> getDirIndex( const std::string& dirname )
+    {
+      auto& db = getDirIndexDB();
+      NCRYSTAL_LOCK_GUARD(db.mtx);
+      auto it = db.indices.find( dirname );
+      if ( it != db.indices.end() )
+        return it->second;
+      auto idx = makeSO<DirIndex>( dirname );
+      db.indices.emplace( dirname, idx );
+      return idx;
+    }
+
+    bool fileExistsInDir( const std::string& dirname, const std::string& relpath )
+    {
+      //Use index when enabled. Relative paths with subdirectories are looked up
+      //in the index of the subdirectory:
+      if ( !getDirIndexDB().enabled.load() )
+        return file_exists( path_join( dirname, relpath ) );
+      auto i = relpath.rfind('/');
+      if ( i == std::string::npos )
+        return getDirIndex( dirname )->hasFile( relpath );
+      return getDirIndex( path_join( dirname, relpath.substr( 0, i ) ) )->hasFile( relpath.substr( i + 1 ) );
+    }
+
+    VectS listDir( const std::string& dirname, bool requireDot = false )
+    {
+      //List full paths of entries like ncglob(dirname+"/*") (or "/*.*" if
+      //requireDot is set):
+      if ( !getDirIndexDB().enabled.load() )
+        return ncglob( dirname + ( requireDot ? "/*.*" : "/*" ) );
+      VectS res;
+      for ( const auto& n : getDirIndex( dirname )->names() ) {
+        if ( n.empty() || n[0] == '.' )
+          continue;//as with glob
+        if ( requireDot && !contains(n,'.') )
+          continue;
+        res.push_back( path_join( dirname, n ) );
+      }
+      return res;
+    }
+
+    std::vector<BrowseEntry> browseDir( const std::string& dirname, Priority priority,
+                                        bool useIndex = true ) {
       //Browse for known extensions in directory and any direct sub-dirs without
       //"." in the name.
       std::vector<BrowseEntry> out;
@@ -94,7 +188,7 @@ namespace NCrystal {
       VectS subdirs;
       VectS extensionsV = recognisedFileExtensions();
       const std::set<std::string> extensions(extensionsV.begin(),extensionsV.end());
-      for ( const auto& f : ncglob(dirname+"/*") ) {
+      for ( const auto& f : ( useIndex ? listDir(dirname) : ncglob(dirname+"/*") ) ) {
         auto bn = basename(f);
         if ( !contains(bn,'.') ) {
           //might be subdir (or file without '.' in the name, but the glob below
@@ -107,7 +201,7 @@ namespace NCrystal {
       //Deal with subdirs:
       for ( const auto& subdir : subdirs ) {
         auto subdir_fullpath = path_join( dirname, subdir );
-        for ( const auto& f : ncglob(subdir_fullpath+"/*.*") ) {
+        for ( const auto& f : ( useIndex ? listDir(subdir_fullpath,true) : ncglob(subdir_fullpath+"/*.*") ) ) {
           if ( extensions.count(getfileext(f))!=0 )
             out.push_back( { path_join(subdir,basename(f)), dirname, priority } );
         }
@@ -142,7 +236,8 @@ namespace NCrystal {
       }
       std::vector<BrowseEntry> browse() const override
       {
-        return browseDir( ncgetcwd(), Priority{default_priority_relpath} );
+        //No index, since the current working directory is often modified:
+        return browseDir( ncgetcwd(), Priority{default_priority_relpath}, false );
       }
     };
 
@@ -160,9 +255,8 @@ namespace NCrystal {
         if ( contains( p.path(), ".." ) )
           return {};
         for ( auto& dir : m_dirList ) {
-          std::string s = path_join( dir, p.path() );
-          if ( file_exists(s) )
-            return s;
+          if ( fileExistsInDir( dir, p.path() ) )
+            return path_join( dir, p.path() );
         }
         return {};
       }
@@ -215,9 +309,8 @@ namespace NCrystal {
         auto & cdl = getCustomDirList();
         NCRYSTAL_LOCK_GUARD(cdl.mtx);
         for ( auto& e : cdl.dirList ) {
-          std::string s = path_join( e.second, p.path() );
-          if ( file_exists(s) )
-            return {e.first,s};
+          if ( fileExistsInDir( e.second, p.path() ) )
+            return { e.first, path_join( e.second, p.path() ) };
         }
         return { Priority::Unable, {} };
       }
@@ -249,6 +342,21 @@ namespace NCrystal {
   }
 }
 
+void NCD::refreshDirectoryIndex()
+{
+  auto& db = getDirIndexDB();
+  NCRYSTAL_LOCK_GUARD(db.mtx);
+  db.indices.clear();
+}
+
+void NCD::enableDirectoryIndex( bool doEnable )
+{
+  auto& db = getDirIndexDB();
+  NCRYSTAL_LOCK_GUARD(db.mtx);
+  db.enabled = doEnable;
+  db.indices.clear();
+}
+
 void NCD::enableRelativePaths( bool doEnable )
 {
   Plugins::ensurePluginsLoaded();
@@ -272,8 +380,61 @@ namespace NCrystal {
   namespace AutoGenNCMAT { void registerStdNCMAT(); }//fwd declared - linked in elsewhere
 
   namespace DataSources {
+    //Entry in an embedded compressed archive. It is only inflated on first
+    //request, after which the result is kept for the lifetime of the process:
+    class CompressedEmbeddedFile : private NoCopyMove {
+    public:
+      CompressedEmbeddedFile( const unsigned char* data, std::size_t nbytes, std::size_t uncompressed_size )
+        : m_data(data), m_nbytes(nbytes), m_size(uncompressed_size) {}
+      RawStrData getData() const
+      {
+        NCRYSTAL_LOCK_GUARD(m_mtx);
+        if ( !m_cache )
+          m_cache = std::make_shared<std::string>( inflateRawDeflate( m_data, m_nbytes, m_size ) );
+        return RawStrData( shared_obj<std::string>( m_cache ) );
+      }
+    private:
+      const unsigned char* m_data;
+      std::size_t m_nbytes;
+      std::size_t m_size;
+      mutable std::mutex m_mtx;
+      mutable std::shared_ptr<std::string> m_cache;
+    };
+    using CompressedFileMap = std::map<std::string,shared_obj<CompressedEmbeddedFile>>;
+
+    class TDFact_CompressedEmbedded final : public FactImpl::TextDataFactory {
+    public:
+      TDFact_CompressedEmbedded( std::string name, CompressedFileMap files, Priority priority )
+        : m_files(std::move(files)), m_name(std::move(name)), m_priority(priority)
+      {
+      }
+      const char * name() const noexcept override { return m_name.c_str(); }
+      Priority query( const TextDataPath& p ) const override
+      {
+        return m_files.count(p.path()) ? m_priority : Priority::Unable;
+      }
+      TextDataSource produce( const TextDataPath& p ) const override
+      {
+        auto it = m_files.find(p.path());
+        nc_assert_always( it != m_files.end() );
+        return TextDataSource::createFromInMemData( it->second->getData() );
+      }
+      std::vector<BrowseEntry> browse() const override {
+        std::vector<BrowseEntry> v;
+        v.reserve( m_files.size() );
+        for ( const auto& e : m_files )
+          v.push_back( { e.first, m_name, m_priority } );
+        return v;
+      }
+    private:
+      CompressedFileMap m_files;
+      std::string m_name;
+      Priority m_priority;
+    };
+
     struct StdDataLibInMemDB {
       std::map<std::string,TextDataSource> virtFileMap;
+      CompressedFileMap compressedFileMap;
       std::mutex mtx;
     };
     StdDataLibInMemDB& getStdDataLibInMemDB()
@@ -293,6 +454,17 @@ namespace NCrystal {
       nc_map_force_emplace( db.virtFileMap, name,
                             TextDataSource::createFromInMemData( RawStrData( RawStrData::static_data_ptr_t(), static_data) ) );
     }
+    void registerEmbeddedCompressedNCMAT( const char* name, const unsigned char* archive,
+                                          std::size_t offset, std::size_t nbytes,
+                                          std::size_t uncompressed_size )
+    {
+      //Like registerEmbeddedNCMAT, but for files stored as raw DEFLATE streams
+      //in a single archive. Only the index entry is recorded here:
+      auto& db = NCD::getStdDataLibInMemDB();
+      NCRYSTAL_LOCK_GUARD(db.mtx);
+      nc_map_force_emplace( db.compressedFileMap, name,
+                            makeSO<NCD::CompressedEmbeddedFile>( archive + offset, nbytes, uncompressed_size ) );
+    }
   }
 #else
   //On-disk standard data library:
@@ -362,6 +534,13 @@ void NCD::enableStandardDataLibrary( bool doEnable, Optional<std::string> reques
       }
     }
     NCRYSTAL_LOCK_GUARD(db.mtx);
+    if ( !db.compressedFileMap.empty() ) {
+      //Entries share their decompression caches with the DB:
+      FactImpl::registerFactory( std::make_unique<TDFact_CompressedEmbedded>( factNameStdLib,
+                                                                              db.compressedFileMap,
+                                                                              thePriority ) );
+      return;
+    }
     //Copy entries map:
     decltype(db.virtFileMap) virtFileMapCopy;
     for ( const auto& e :  db.virtFileMap )
@@ -538,10 +717,9 @@ namespace NCrystal {
       validateVirtFilename(virtualFilename);
       auto& vfs = virtualFilesSharedData();
       NCRYSTAL_LOCK_GUARD(vfs.mtx);
-      const bool was_empty = vfs.virtualFiles.empty();
       nc_map_force_emplace( vfs.virtualFiles, virtualFilename, std::move(tsd), priority );
-      if ( was_empty )
-        FactImpl::registerFactory(std::make_unique<TDFact_VirtualFiles>());
+      //(Re)register factory, also invalidating any cached lookups:
+      FactImpl::registerFactory(std::make_unique<TDFact_VirtualFiles>());
     }
   }
 
@@ -718,6 +896,7 @@ void NCD::removeAllDataSources()
   enableStandardDataLibrary(false);
   enableStandardSearchPath(false);
   removeCustomSearchDirectories();
+  refreshDirectoryIndex();
   {
     auto& vfs = virtualFilesSharedData();
     NCRYSTAL_LOCK_GUARD(vfs.mtx);
@@ -20,7 +20,6 @@
 
 #include "NCrystal/internal/NCDebyeMSD.hh"
 #include "NCrystal/internal/NCMath.hh"
-#include "NCrystal/internal/NCRomberg.hh"
 
 namespace NC = NCrystal;
 
@@ -46,24 +45,48 @@ double NC::calcDebyeMSDScale( DebyeTemperature dt, AtomMass am )
 }
 
 namespace NCrystal {
-  class DebyeMSDShapeIntegral : public Romberg {
-  public:
-    //Integrate function f(x)=x/(exp(x)-1)
-    DebyeMSDShapeIntegral() {}
-    virtual ~DebyeMSDShapeIntegral() {}
-    virtual double evalFunc(double x) const {
-      if (ncabs(x)<1e-4) {
-        //evaluate via Taylor expansion for numerical stability
-        double x2=x*x;
-        return 1-x*0.5+x2*0.08333333333333333333333333333333-x2*x2*0.00138888888888888888888888888888888889;
-      }
-      return x / std::expm1(x);
-    }
-    virtual bool accept(unsigned lvl, double prev_estimate, double estimate,double,double) const
+  namespace {
+    //Evaluates integral_{0}^{y}[t/(exp(t)-1)]dt, to (close to) full double
+    //precision. For small y, the Taylor expansion of the integrand in terms of
+    //Bernoulli numbers, t/(exp(t)-1)=sum_n B_n t^n/n!, is integrated term by
+    //term (converges for y<2pi). For larger y, the integral is instead
+    //evaluated as pi^2/6 minus the integral from y to infinity, which is
+    //sum_{k>=1} exp(-k*y)*(y/k+1/k^2).
+    double integralXDivExpm1( double y )
     {
-      return lvl>11 || (lvl > 7 && ncabs(estimate-prev_estimate)<1e-10);
+      nc_assert( y >= 0.0 );
+      if ( y <= 2.0 ) {
+        //Coefficients B_n/((n+1)*n!) for n=2,4,...,30:
+        static constexpr double coeffs[] = { 2.7777777777777776e-02, -2.7777777777777778e-04,
+                                             4.7241118669690098e-06, -9.1857730746619641e-08,
+                                             1.8978869988971001e-09, -4.0647616451442256e-11,
+                                             8.9216910204564523e-13, -1.9939295860721074e-14,
+                                             4.5189800296199183e-16, -1.0356517612181247e-17,
+                                             2.395218621026187e-19, -5.581785874325009e-21,
+                                             1.3091507554183213e-22, -3.0874198024267403e-24,
+                                             7.3159756527022029e-26 };
+        constexpr std::size_t ncoeffs = sizeof(coeffs)/sizeof(coeffs[0]);
+        const double y2 = y*y;
+        double poly = 0.0;
+        for ( std::size_t i = ncoeffs; i > 0; --i )
+          poly = coeffs[i-1] + y2 * poly;
+        return y * ( 1.0 - 0.25 * y + y2 * poly );
+      }
+      constexpr double pisq_div_6 = kPiSq / 6.0;
+      const double q = std::exp( -y );
+      double tail = 0.0;
+      double qk = 1.0;
+      for ( unsigned k = 1; k < 100; ++k ) {
+        qk *= q;
+        const double invk = 1.0 / k;
+        const double term = qk * invk * ( y + invk );
+        tail += term;
+        if ( term < 1e-17 * pisq_div_6 )
+          break;
+      }
+      return pisq_div_6 - tail;
     }
-  };
+  }
 }
 
 double NC::calcDebyeMSDShape( double x )
@@ -71,8 +94,7 @@ double NC::calcDebyeMSDShape( double x )
   nc_assert_always(x>=0.0);
   if (x<1e-50)
     return 0.25;
-  DebyeMSDShapeIntegral integral;
-  return 0.25 + x * x * integral.integrate( 0.0, 1.0 / x );
+  return 0.25 + x * x * integralXDivExpm1( 1.0 / x );
 }
 
 NC::DebyeTemperature NC::debyeTempFromIsotropicMSD( double msd, Temperature t, AtomMass am )
@@ -33,3 +33,9 @@ NCrystal::UniqueID::UniqueID()
 
 NCrystal::RNG::~RNG() = default;
 
+void NCrystal::RNG::actualGenerateMany( std::size_t n, double* tgt )
+{
+  for ( std::size_t i = 0; i < n; ++i )
+    tgt[i] = actualGenerate();
+}
+
@@ -20,6 +20,7 @@
 
 #include "NCrystal/NCDump.hh"
 #include "NCrystal/NCInfo.hh"
+#include "NCrystal/NCProcImpl.hh"
 #include "NCrystal/internal/NCMath.hh"
 #include "NCrystal/internal/NCString.hh"
 #include <cstdio>
@@ -229,3 +230,52 @@ void NCrystal::dump(const Info&c)
   }
   printf("%s", hr);
 }
+
+namespace NCrystal {
+  namespace {
+    std::string fmtBytes( std::size_t n )
+    {
+      char buf[64];
+      if ( n < 1024 )
+        snprintf(buf,sizeof(buf),"%i B",static_cast<int>(n));
+      else if ( n < 1024*1024 )
+        snprintf(buf,sizeof(buf),"%.1f kB",n/1024.0);
+      else
+        snprintf(buf,sizeof(buf),"%.1f MB",n/(1024.0*1024.0));
+      return buf;
+    }
+
+    void dumpFootprintLine( const std::string& label, const MemoryFootprint& mf )
+    {
+      printf("%-40s exclusive: %10s   shared: %10s\n",label.c_str(),
+             fmtBytes(mf.exclusiveBytes()).c_str(),fmtBytes(mf.sharedBytes()).c_str());
+    }
+
+    void dumpProcFootprint( const ProcImpl::Process& p, unsigned level, bool isShared, double scale )
+    {
+      std::ostringstream label;
+      label << std::string(2*level,' ') << p.name();
+      if ( scale != 1.0 )
+        label << " (x" << scale << ")";
+      if ( isShared )
+        label << " [shared]";
+      dumpFootprintLine( label.str(), memoryFootprint(p) );
+      auto pc = dynamic_cast<const ProcImpl::ProcComposition*>(&p);
+      if ( pc ) {
+        for ( auto& comp : pc->components() )
+          dumpProcFootprint( *comp.process, level + 1,
+                             comp.process.getsp().use_count() > 1, comp.scale );
+      }
+    }
+  }
+}
+
+void NCrystal::dumpMemoryFootprint(const Info& info)
+{
+  dumpFootprintLine( "Info", memoryFootprint(info) );
+}
+
+void NCrystal::dumpMemoryFootprint(const ProcImpl::Process& p)
+{
+  dumpProcFootprint( p, 0, false, 1.0 );
+}
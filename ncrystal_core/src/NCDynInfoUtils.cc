@@ -23,13 +23,15 @@
 #include "NCrystal/internal/NCMath.hh"
 #include "NCrystal/internal/NCVDOSToScatKnl.hh"
 #include "NCrystal/internal/NCSABUtils.hh"
+#include "NCrystal/internal/NCThreadUtils.hh"
+#include "NCrystal/internal/NCSABDiskCache.hh"
 namespace NC = NCrystal;
 
 namespace NCrystal {
   namespace DICache {
     //Cache keys:
-    using VDOSKey = std::tuple<uint64_t,unsigned,const DI_VDOS*>;//(DI unique id, vdoslux 0..5, DI object)
-    using VDOSDebyeKey = std::tuple<unsigned,uint64_t,uint64_t,uint64_t,uint64_t>;//(reduced vdoslux 0..2 + rounded: elementMass, boundXS, T, TDebye)
+    using VDOSKey = std::tuple<uint64_t,unsigned,const DI_VDOS*,double>;//(DI unique id, vdoslux 0..5, DI object, vdosthintol)
+    using VDOSDebyeKey = std::tuple<unsigned,uint64_t,uint64_t,uint64_t,uint64_t,double>;//(reduced vdoslux 0..2 + rounded: elementMass, boundXS, T, TDebye + vdosthintol)
 
     //For VDOS Debye we can potentially share work between different Info
     //objects, since the number of dependent parameters is very low. Thus, we
@@ -37,13 +39,14 @@ namespace NCrystal {
     //only base calculations on values derived from those rounded values:
     struct VDOSDebyePars {
       unsigned reduced_vdoslux;
+      double vdosthintol;
       AtomMass elementMass;
       Temperature temperature;
       DebyeTemperature debyeTemperature;
       SigmaBound boundXS;
     };
 
-    VDOSDebyeKey getKey(unsigned reduced_vdoslux, Temperature t, DebyeTemperature dt, SigmaBound sb, AtomMass mass ) {
+    VDOSDebyeKey getKey(unsigned reduced_vdoslux, double vdosthintol, Temperature t, DebyeTemperature dt, SigmaBound sb, AtomMass mass ) {
       dt.validate();
       t.validate();
       sb.validate();
@@ -54,10 +57,12 @@ namespace NCrystal {
                            roundFct(mass.get()),
                            roundFct(sb.get()),
                            roundFct(t.get()),
-                           roundFct(dt.get()) );
+                           roundFct(dt.get()),
+                           vdosthintol );
     }
-    VDOSDebyeKey getKey(unsigned reduced_vdoslux, const DI_VDOSDebye& di) {
+    VDOSDebyeKey getKey(unsigned reduced_vdoslux, double vdosthintol, const DI_VDOSDebye& di) {
       return getKey(reduced_vdoslux,
+                    vdosthintol,
                     di.temperature(),
                     di.debyeTemperature(),
                     di.atomData().scatteringXS(),
@@ -68,24 +73,139 @@ namespace NCrystal {
       //always base calculations only on what can be extracted using the key
       //(this is important due to rounding):
       return { std::get<0>(key),
+               std::get<5>(key),
                AtomMass{std::get<1>(key)*0.001},
                Temperature{std::get<3>(key)*0.001},
                DebyeTemperature{std::get<4>(key)*0.001},
                SigmaBound{std::get<2>(key)*0.001} };
     }
 
+    //The Debye model kernels are in addition shared between different
+    //elements: expressed in x=alpha*kT*msd*2m_n/hbar^2 rather than alpha,
+    //S(x,beta) depends only on T/TDebye, and since msd is inversely
+    //proportional to the element mass, the kernel for mass M follows from the
+    //one at a reference mass Mref by scaling the alpha grid with M/Mref. To
+    //make sure the derived kernels still cover the kinematic region (which
+    //does not depend on M), the reference masses are placed on a log-grid
+    //with 4 points per octave and the one just below M is used:
+    using DebyeRefKey = std::tuple<unsigned,uint64_t,uint64_t,int,double>;//(reduced vdoslux 0..2 + rounded: T, TDebye + mass bucket + vdosthintol)
+    constexpr double debyeMassBucketsPerOctave = 4.0;
+
+    double debyeRefMass( int massBucket )
+    {
+      return std::exp2( massBucket / debyeMassBucketsPerOctave );
+    }
+
+    DebyeRefKey getDebyeRefKey( const VDOSDebyeKey& key )
+    {
+      const double mass = std::get<1>(key)*0.001;
+      int bucket = static_cast<int>( std::floor( std::log2( mass ) * debyeMassBucketsPerOctave ) );
+      if ( debyeRefMass( bucket ) > mass )
+        --bucket;//guard against rounding
+      nc_assert( debyeRefMass( bucket ) <= mass );
+      return DebyeRefKey( std::get<0>(key), std::get<3>(key), std::get<4>(key), bucket, std::get<5>(key) );
+    }
+
+    //For VDOS based kernels at other temperatures than that of the DI_VDOS
+    //object, we base the key on the actual VDOS content (including the new
+    //temperature), so that work can be shared between different Info objects
+    //(e.g. the same material loaded at many slightly different
+    //temperatures). The hash is only used to speed up comparisons, equal keys
+    //always have identical content:
+    double requestedEmax( const DI_VDOS& );
+    struct VDOSContentKey {
+      HashValue hash;
+      unsigned vdoslux;
+      double vdosthintol;
+      double requestedEmax;
+      std::shared_ptr<const VDOSData> vdos;
+      bool operator<( const VDOSContentKey& o ) const
+      {
+        if ( hash != o.hash )
+          return hash < o.hash;
+        if ( vdoslux != o.vdoslux )
+          return vdoslux < o.vdoslux;
+        if ( vdosthintol != o.vdosthintol )
+          return vdosthintol < o.vdosthintol;
+        if ( requestedEmax != o.requestedEmax )
+          return requestedEmax < o.requestedEmax;
+        const VDOSData& a = *vdos;
+        const VDOSData& b = *o.vdos;
+        auto ta = std::make_tuple( a.temperature().get(), a.boundXS().get(), a.elementMassAMU().get(), a.vdos_egrid() );
+        auto tb = std::make_tuple( b.temperature().get(), b.boundXS().get(), b.elementMassAMU().get(), b.vdos_egrid() );
+        if ( ta != tb )
+          return ta < tb;
+        return a.vdos_density() < b.vdos_density();
+      }
+    };
+
+    VDOSContentKey getKey( unsigned vdoslux, double vdosthintol, std::shared_ptr<const VDOSData> vd, double emax )
+    {
+      nc_assert(vdoslux<=5);
+      HashValue hash = hashContainer(vd->vdos_density());
+      hash_combine(hash,vd->vdos_egrid().first);
+      hash_combine(hash,vd->vdos_egrid().second);
+      hash_combine(hash,vd->temperature().get());
+      hash_combine(hash,vd->boundXS().get());
+      hash_combine(hash,vd->elementMassAMU().get());
+      return VDOSContentKey{ hash, vdoslux, vdosthintol, emax, std::move(vd) };
+    }
+
+    VDOSContentKey getKey( unsigned vdoslux, double vdosthintol, const DI_VDOS& di, Temperature t )
+    {
+      t.validate();
+      const auto& vd_orig = di.vdosData();
+      return getKey( vdoslux,
+                     vdosthintol,
+                     std::make_shared<const VDOSData>( vd_orig.vdos_egrid(), VectD(vd_orig.vdos_density()),
+                                                       t, vd_orig.boundXS(), vd_orig.elementMassAMU() ),
+                     requestedEmax(di) );
+    }
+
+    //The expanded S(alpha,beta) does not depend on the bound scattering cross
+    //section, which is merely carried along in the SABData. Expansions are
+    //therefore shared via a cache of kernels with unit cross section (keyed on
+    //VDOS content), so different Info objects with the same VDOS but different
+    //cross sections (e.g. from atomdb overrides) only need one expansion. The
+    //element mass on the other hand affects S itself, and is part of the key:
+    VDOSContentKey getUnitXSKey( unsigned vdoslux, double vdosthintol, const VDOSData& vd, double emax )
+    {
+      return getKey( vdoslux,
+                     vdosthintol,
+                     std::make_shared<const VDOSData>( vd.vdos_egrid(), VectD(vd.vdos_density()),
+                                                       vd.temperature(), SigmaBound{1.0},
+                                                       vd.elementMassAMU() ),
+                     emax );
+    }
+
+    //Expand VDOS, sharing work via the unit cross section cache above if
+    //useCache is set (nb: disk caches are consulted in any case):
+    std::shared_ptr<const SABData> expandVDOS( const VDOSData&, unsigned vdoslux, double vdosthintol,
+                                               double emax, bool useCache );
+
     //Actual worker functions producing results:
-    std::shared_ptr<const SABData> extractFromDIVDOSNoCache( unsigned vdoslux, const DI_VDOS& );
-    std::shared_ptr<const SABData> extractFromDIVDOSDebyeNoCache( const VDOSDebyeKey& );
+    std::shared_ptr<const SABData> extractFromDIVDOSNoCache( unsigned vdoslux, double vdosthintol,
+                                                             const DI_VDOS&, bool useCache = false );
+    std::shared_ptr<const SABData> extractFromDIVDOSNoCache( const VDOSContentKey&, bool useCache = false );
+    std::shared_ptr<const SABData> extractFromDIVDOSDebyeNoCache( const VDOSDebyeKey&, bool useCache = false );
+    std::shared_ptr<const SABData> expandDebyeRefNoCache( const DebyeRefKey& );
 
     //Factories:
+    std::size_t approxSABDataMemoryUsage( const SABData& d )
+    {
+      return sizeof(SABData) + ( d.alphaGrid().size() + d.betaGrid().size() + d.sab().size() ) * sizeof(double);
+    }
+
     class VDOS2SABFactory : public NC::CachedFactoryBase<VDOSKey,SABData,10> {
     public:
       const char* factoryName() const final { return "VDOS2SABFactory"; }
       std::string keyToString( const VDOSKey& key ) const final
       {
         std::ostringstream ss;
-        ss<<"(DI_VDOS id="<<std::get<0>(key)<<";vdoslux="<<std::get<1>(key)<<")";
+        ss<<"(DI_VDOS id="<<std::get<0>(key)<<";vdoslux="<<std::get<1>(key);
+        if ( std::get<3>(key) > 0.0 )
+          ss<<";vdosthintol="<<std::get<3>(key);
+        ss<<")";
         return ss.str();
       }
     protected:
@@ -94,7 +214,11 @@ namespace NCrystal {
         unsigned vdoslux = std::get<1>(key);
         const DI_VDOS* di_vdos = std::get<2>(key);
         nc_assert_always( di_vdos && di_vdos->getUniqueID().value == std::get<0>(key) );
-        return extractFromDIVDOSNoCache( vdoslux, *di_vdos );
+        return extractFromDIVDOSNoCache( vdoslux, std::get<3>(key), *di_vdos, true );
+      }
+      std::size_t approxMemoryUsage( const SABData& d ) const final
+      {
+        return approxSABDataMemoryUsage(d);
       }
     };
 
@@ -109,22 +233,89 @@ namespace NCrystal {
           <<";M="<<p.elementMass
           <<";T="<<p.temperature
           <<";TDebye="<<p.debyeTemperature
-          <<";boundXS="<<p.boundXS<<")";
+          <<";boundXS="<<p.boundXS;
+        if ( p.vdosthintol > 0.0 )
+          ss<<";vdosthintol="<<p.vdosthintol;
+        ss<<")";
         return ss.str();
       }
     protected:
       virtual ShPtr actualCreate( const VDOSDebyeKey& key ) const final
       {
-        return extractFromDIVDOSDebyeNoCache(key);
+        return extractFromDIVDOSDebyeNoCache( key, true );
+      }
+      std::size_t approxMemoryUsage( const SABData& d ) const final
+      {
+        return approxSABDataMemoryUsage(d);
+      }
+    };
+
+    class DebyeRef2SABFactory : public NC::CachedFactoryBase<DebyeRefKey,SABData,10> {
+    public:
+      const char* factoryName() const final { return "DebyeRef2SABFactory"; }
+      std::string keyToString( const DebyeRefKey& key ) const final
+      {
+        std::ostringstream ss;
+        ss<<"(reduced_vdoslux="<<std::get<0>(key)
+          <<";Mref="<<debyeRefMass(std::get<3>(key))
+          <<";T="<<Temperature{std::get<1>(key)*0.001}
+          <<";TDebye="<<DebyeTemperature{std::get<2>(key)*0.001};
+        if ( std::get<4>(key) > 0.0 )
+          ss<<";vdosthintol="<<std::get<4>(key);
+        ss<<")";
+        return ss.str();
+      }
+    protected:
+      virtual ShPtr actualCreate( const DebyeRefKey& key ) const final
+      {
+        return expandDebyeRefNoCache( key );
+      }
+      std::size_t approxMemoryUsage( const SABData& d ) const final
+      {
+        return approxSABDataMemoryUsage(d);
       }
     };
 
+    class VDOSContent2SABFactory : public NC::CachedFactoryBase<VDOSContentKey,SABData,10> {
+    public:
+      VDOSContent2SABFactory( const char * name, bool useUnitXSCache )
+        : m_name(name), m_useUnitXSCache(useUnitXSCache) {}
+      const char* factoryName() const final { return m_name; }
+      std::string keyToString( const VDOSContentKey& key ) const final
+      {
+        std::ostringstream ss;
+        ss<<"(VDOS hash="<<key.hash
+          <<";vdoslux="<<key.vdoslux
+          <<";T="<<key.vdos->temperature()
+          <<";Emax="<<key.requestedEmax;
+        if ( key.vdosthintol > 0.0 )
+          ss<<";vdosthintol="<<key.vdosthintol;
+        ss<<")";
+        return ss.str();
+      }
+    protected:
+      virtual ShPtr actualCreate( const VDOSContentKey& key ) const final
+      {
+        return extractFromDIVDOSNoCache( key, m_useUnitXSCache );
+      }
+      std::size_t approxMemoryUsage( const SABData& d ) const final
+      {
+        return approxSABDataMemoryUsage(d);
+      }
+    private:
+      const char * m_name;
+      bool m_useUnitXSCache;
+    };
+
     static VDOS2SABFactory s_vdos2sabfactory;
+    static VDOSContent2SABFactory s_vdoscontent2sabfactory( "VDOSContent2SABFactory", true );
+    static VDOSContent2SABFactory s_unitxsvdos2sabfactory( "UnitXSVDOS2SABFactory", false );
     static VDOSDebye2SABFactory s_vdosdebye2sabfactory;
+    static DebyeRef2SABFactory s_debyeref2sabfactory;
 
-    std::shared_ptr<const SABData> extractFromDIVDOS( unsigned vdoslux, const DI_VDOS& di )
+    std::shared_ptr<const SABData> extractFromDIVDOS( unsigned vdoslux, double vdosthintol, const DI_VDOS& di )
     {
-      VDOSKey key( di.getUniqueID().value, vdoslux, &di );
+      VDOSKey key( di.getUniqueID().value, vdoslux, &di, vdosthintol );
       return s_vdos2sabfactory.create(key);
     }
 
@@ -140,7 +331,8 @@ std::shared_ptr<const NC::SABData> NC::extractSABDataFromVDOSDebyeModel( DebyeTe
                                                                          Temperature temperature,
                                                                          SigmaBound boundXS,
                                                                          AtomMass elementMassAMU,
-                                                                         unsigned vdoslux, bool useCache )
+                                                                         unsigned vdoslux, bool useCache,
+                                                                         double vdosthintol )
 {
   nc_assert( vdoslux <= 5 );
   nc_assert( temperature.get() > 0.0 && temperature.get() < 1.0e5 );
@@ -148,13 +340,14 @@ std::shared_ptr<const NC::SABData> NC::extractSABDataFromVDOSDebyeModel( DebyeTe
   nc_assert( debyeTemperature.get() > 0.0 && debyeTemperature.get() < 1.0e5 );
   nc_assert( elementMassAMU.get() > 0.0 && elementMassAMU.get() < 1.0e5 );
   unsigned reduced_vdoslux = static_cast<unsigned>(std::max<int>(0,static_cast<int>(vdoslux)-3));//nb: replicated below
-  auto key = DICache::getKey(reduced_vdoslux,temperature,debyeTemperature,boundXS,elementMassAMU);
+  auto key = DICache::getKey(reduced_vdoslux,vdosthintol,temperature,debyeTemperature,boundXS,elementMassAMU);
   if (!useCache)
     return DICache::extractFromDIVDOSDebyeNoCache(key);
   return DICache::extractFromDIVDOSDebye(key);
 }
 
-std::shared_ptr<const NC::SABData> NC::extractSABDataFromDynInfo( const NC::DI_ScatKnl* di, unsigned vdoslux, bool useCache )
+std::shared_ptr<const NC::SABData> NC::extractSABDataFromDynInfo( const NC::DI_ScatKnl* di, unsigned vdoslux, bool useCache,
+                                                                  double vdosthintol )
 {
   nc_assert( di );
   nc_assert( vdoslux <= 5 );
@@ -163,7 +356,7 @@ std::shared_ptr<const NC::SABData> NC::extractSABDataFromDynInfo( const NC::DI_S
   auto di_vdosdebye = dynamic_cast<const DI_VDOSDebye*>(di);
   if (di_vdosdebye) {
     unsigned reduced_vdoslux = static_cast<unsigned>(std::max<int>(0,static_cast<int>(vdoslux)-3));//nb: replicated above
-    auto key = DICache::getKey(reduced_vdoslux,*di_vdosdebye);
+    auto key = DICache::getKey(reduced_vdoslux,vdosthintol,*di_vdosdebye);
     if (!useCache)
       return DICache::extractFromDIVDOSDebyeNoCache(key);
     return DICache::extractFromDIVDOSDebye(key);
@@ -179,8 +372,8 @@ std::shared_ptr<const NC::SABData> NC::extractSABDataFromDynInfo( const NC::DI_S
   auto di_vdos = dynamic_cast<const DI_VDOS*>(di);
   if (di_vdos) {
     if (!useCache)
-      return DICache::extractFromDIVDOSNoCache(vdoslux,*di_vdos);
-    return DICache::extractFromDIVDOS(vdoslux,*di_vdos);
+      return DICache::extractFromDIVDOSNoCache(vdoslux,vdosthintol,*di_vdos);
+    return DICache::extractFromDIVDOS(vdoslux,vdosthintol,*di_vdos);
   }
 
   //==> Unknown:
@@ -191,38 +384,171 @@ std::shared_ptr<const NC::SABData> NC::extractSABDataFromDynInfo( const NC::DI_S
 void NC::clearSABDataFromDynInfoCaches()
 {
   DICache::s_vdos2sabfactory.cleanup();
+  DICache::s_vdoscontent2sabfactory.cleanup();
+  DICache::s_unitxsvdos2sabfactory.cleanup();
   DICache::s_vdosdebye2sabfactory.cleanup();
+  DICache::s_debyeref2sabfactory.cleanup();
+}
+
+namespace NCrystal {
+  namespace DICache {
+    double requestedEmax( const DI_VDOS& di )
+    {
+      //If user specified an energy-grid with a specific upper energy, Emax,
+      //this is essentially a request to expand the vdos out to that energy:
+      double requested_Emax = 0.0;
+      auto egrid = di.energyGrid();
+      if ( !!egrid && ! egrid->empty() ) {
+        //egrid is either the grid pts directly (when size>3), of the form
+        //[emin, emax, npts], where 0 entries indicates no value.
+        nc_assert_always(egrid->size()>=3);
+        requested_Emax = egrid->size()==3 ? egrid->at(1) : egrid->back();
+      }
+      return requested_Emax;
+    }
+  }
+}
+
+namespace NCrystal {
+  namespace DICache {
+    std::shared_ptr<const SABData> expandVDOSNoCache( const VDOSData& vd, unsigned vdoslux, double vdosthintol, double emax )
+    {
+      //Expansion is costly, so the results are also shared via the SAB disk
+      //cache and snapshots when these are in use:
+      const std::string key = SAB::expandedVDOSCacheKey( vd, vdoslux, emax, vdosthintol );
+      if ( !key.empty() ) {
+        auto cached = SAB::loadExpandedVDOSFromDiskCache( key );
+        if ( cached )
+          return cached;
+      }
+      SABData sabdata = SABUtils::transformKernelToStdFormat( createScatteringKernel( vd, vdoslux, emax,
+                                                                                             VDOSGn::TruncAndThinningChoices::Default,
+                                                                                             vdosthintol ) );
+      auto res = std::make_shared<const SABData>(std::move(sabdata));
+      if ( !key.empty() )
+        SAB::saveExpandedVDOSToDiskCache( key, *res );
+      return res;
+    }
+
+    std::shared_ptr<const SABData> expandVDOS( const VDOSData& vd, unsigned vdoslux, double vdosthintol,
+                                               double emax, bool useCache )
+    {
+      if ( !useCache )
+        return expandVDOSNoCache( vd, vdoslux, vdosthintol, emax );
+      auto unitxs = s_unitxsvdos2sabfactory.create( getUnitXSKey( vdoslux, vdosthintol, vd, emax ) );
+      if ( vd.boundXS().dbl() == 1.0 )
+        return unitxs;
+      return std::make_shared<const SABData>( VectD( unitxs->alphaGrid() ),
+                                              VectD( unitxs->betaGrid() ),
+                                              VectD( unitxs->sab() ),
+                                              unitxs->temperature(),
+                                              vd.boundXS(),
+                                              unitxs->elementMassAMU(),
+                                              unitxs->suggestedEmax() );
+    }
+  }
+}
+
+std::shared_ptr<const NC::SABData> NC::DICache::extractFromDIVDOSNoCache( unsigned vdoslux, double vdosthintol,
+                                                                         const DI_VDOS& di, bool useCache )
+{
+  return expandVDOS( di.vdosData(), vdoslux, vdosthintol, requestedEmax(di), useCache );
+}
+
+std::shared_ptr<const NC::SABData> NC::DICache::extractFromDIVDOSNoCache( const VDOSContentKey& key, bool useCache )
+{
+  return expandVDOS( *key.vdos, key.vdoslux, key.vdosthintol, key.requestedEmax, useCache );
 }
 
-std::shared_ptr<const NC::SABData> NC::DICache::extractFromDIVDOSNoCache( unsigned vdoslux, const DI_VDOS& di )
+std::shared_ptr<const NC::SABData> NC::extractSABDataFromDynInfoAtTemperature( const NC::DI_ScatKnl* di,
+                                                                              Temperature temperature,
+                                                                              unsigned vdoslux, bool useCache,
+                                                                              double vdosthintol )
 {
-  //If user specified an energy-grid with a specific upper energy, Emax,
-  //this is essentially a request to expand the vdos out to that energy:
-  double requested_Emax = 0.0;
-  auto egrid = di.energyGrid();
-  if ( !!egrid && ! egrid->empty() ) {
-    //egrid is either the grid pts directly (when size>3), of the form
-    //[emin, emax, npts], where 0 entries indicates no value.
-    nc_assert_always(egrid->size()>=3);
-    requested_Emax = egrid->size()==3 ? egrid->at(1) : egrid->back();
+  nc_assert_always( di );
+  nc_assert_always( vdoslux <= 5 );
+  temperature.validate();
+
+  //==> VDOSDebye (already keyed on parameter values rather than DI object):
+  auto di_vdosdebye = dynamic_cast<const DI_VDOSDebye*>(di);
+  if ( di_vdosdebye )
+    return extractSABDataFromVDOSDebyeModel( di_vdosdebye->debyeTemperature(), temperature,
+                                             di_vdosdebye->atomData().scatteringXS(),
+                                             di_vdosdebye->atomData().averageMassAMU(),
+                                             vdoslux, useCache, vdosthintol );
+
+  //==> VDOS:
+  auto di_vdos = dynamic_cast<const DI_VDOS*>(di);
+  if ( di_vdos ) {
+    auto key = DICache::getKey( vdoslux, vdosthintol, *di_vdos, temperature );
+    if (!useCache)
+      return DICache::extractFromDIVDOSNoCache(key);
+    return DICache::s_vdoscontent2sabfactory.create(key);
   }
-  const auto& vd = di.vdosData();
-  SABData sabdata = SABUtils::transformKernelToStdFormat( createScatteringKernel( vd, vdoslux,requested_Emax ) );
-  return std::make_shared<const SABData>(std::move(sabdata));
 
+  //==> Directly specified kernels:
+  if ( dynamic_cast<const DI_ScatKnlDirect*>(di) )
+    NCRYSTAL_THROW(BadInput,"Directly specified scattering kernels can not be evaluated at other temperatures.");
+
+  //==> Unknown:
+  NCRYSTAL_THROW(LogicError,"Unknown DI_ScatKnl sub class");
+  return nullptr;
+}
+
+std::vector<std::shared_ptr<const NC::SABData>>
+NC::extractSABDataFromDynInfoAtTemperatures( const NC::DI_ScatKnl* di,
+                                             const std::vector<Temperature>& temperatures,
+                                             unsigned vdoslux, bool useCache,
+                                             double vdosthintol )
+{
+  nc_assert_always( di );
+  nc_assert_always( vdoslux <= 5 );
+  for ( auto& t : temperatures )
+    t.validate();
+
+  if ( dynamic_cast<const DI_ScatKnlDirect*>(di) )
+    NCRYSTAL_THROW(BadInput,"extractSABDataFromDynInfoAtTemperatures: Directly specified scattering"
+                   " kernels can not be evaluated at other temperatures.");
+
+  std::vector<std::shared_ptr<const SABData>> result( temperatures.size() );
+  parallelFor( temperatures.size(), getNThreadsFromEnv(),
+               [&result,&temperatures,di,vdoslux,useCache,vdosthintol](std::size_t i)
+               {
+                 result[i] = extractSABDataFromDynInfoAtTemperature( di, temperatures[i], vdoslux,
+                                                                     useCache, vdosthintol );
+               } );
+  return result;
 }
 
-std::shared_ptr<const NC::SABData> NC::DICache::extractFromDIVDOSDebyeNoCache( const VDOSDebyeKey& key )
+std::shared_ptr<const NC::SABData> NC::DICache::extractFromDIVDOSDebyeNoCache( const VDOSDebyeKey& key, bool useCache )
 {
   auto param = debyekey2params( key );
+  auto refkey = getDebyeRefKey( key );
+  auto ref = useCache ? s_debyeref2sabfactory.create( refkey ) : expandDebyeRefNoCache( refkey );
 
+  //Derive kernel for the actual element from the reference kernel (see
+  //comments near DebyeRefKey):
+  const double alphaScale = param.elementMass.dbl() / debyeRefMass( std::get<3>(refkey) );
+  return std::make_shared<const SABData>( vectorTrf( ref->alphaGrid(), [alphaScale](double a){ return a*alphaScale; } ),
+                                          VectD( ref->betaGrid() ),
+                                          VectD( ref->sab() ),
+                                          ref->temperature(),
+                                          param.boundXS,
+                                          param.elementMass,
+                                          ref->suggestedEmax() );
+}
+
+std::shared_ptr<const NC::SABData> NC::DICache::expandDebyeRefNoCache( const DebyeRefKey& key )
+{
   //Setup VDOS data from Debye Model. We only specify points in the upper 50% of
   //[0,debye_energy], to benefit from the quadratic scaling below the first grid
   //point implemented in VDOSEval (i.e. we get a more precise G1 function
   //constructed):
-  auto vdosdata = createVDOSDebye( param.debyeTemperature, param.temperature, param.boundXS, param.elementMass );
-  SABData sabdata = SABUtils::transformKernelToStdFormat( createScatteringKernel( vdosdata, param.reduced_vdoslux ) );
-  return std::make_shared<const SABData>(std::move(sabdata));
+  auto vdosdata = createVDOSDebye( DebyeTemperature{std::get<2>(key)*0.001},
+                                   Temperature{std::get<1>(key)*0.001},
+                                   SigmaBound{1.0},
+                                   AtomMass{debyeRefMass(std::get<3>(key))} );
+  return expandVDOSNoCache( vdosdata, std::get<0>(key), std::get<4>(key), 0.0 );
 }
 
 
@@ -138,6 +138,18 @@ NC::CrossSect NC::ElIncScatter::crossSectionIsotropic( CachePtr&, NeutronEnergy
   return CrossSect{ m_elincxs->evaluate( ekin ) };
 }
 
+NC::CrossSect NC::ElIncScatter::majorantCrossSection( EnergyDomain d ) const
+{
+  //Cross sections decrease with energy:
+  return CrossSect{ m_elincxs->evaluate( d.elow ) };
+}
+
+void NC::ElIncScatter::evalManyXSIsotropic( CachePtr&, const double* ekin, std::size_t N,
+                                           double* out_xs ) const
+{
+  m_elincxs->evaluateMany( ekin, N, out_xs );
+}
+
 NC::ScatterOutcomeIsotropic NC::ElIncScatter::sampleScatterIsotropic( CachePtr&, RNG& rng, NeutronEnergy ekin ) const
 {
   double mu = m_elincxs->sampleMu( rng, ekin );
@@ -145,6 +157,16 @@ NC::ScatterOutcomeIsotropic NC::ElIncScatter::sampleScatterIsotropic( CachePtr&,
   return { ekin, CosineScatAngle{mu} };
 }
 
+void NC::ElIncScatter::sampleScatterIsotropicMany( CachePtr&, RNG& rng, double* ekin, std::size_t N,
+                                                   double* out_mu ) const
+{
+  //elastic: ekin unchanged
+  for ( std::size_t i = 0; i < N; ++i ) {
+    out_mu[i] = m_elincxs->sampleMu( rng, NeutronEnergy{ekin[i]} );
+    nc_assert( out_mu[i] >= -1.0 && out_mu[i] <= 1.0 );
+  }
+}
+
 NC::ElIncScatter::ElIncScatter( std::unique_ptr<ElIncXS> p )
   : m_elincxs(std::move(p))
 {
@@ -37,12 +37,38 @@ double NC::ElIncXS::evaluate(NeutronEnergy ekin) const
   //evaluateMonoAtomic() and sampleMu(..)
   constexpr double kkk = 16.0 * kPiSq * ekin2wlsqinv(1.0);
   double e = kkk*ekin.dbl();
+  if ( m_table ) {
+    const Table& t = *m_table;
+    if ( e <= t.elow )
+      return t.lowcoeffs[0] + e * ( t.lowcoeffs[1] + e * ( t.lowcoeffs[2] + e * t.lowcoeffs[3] ) );
+    if ( e >= t.ehigh )
+      return t.highcoeff / e;
+    return t.xs.eval( std::log( e ) );
+  }
   double xs = 0.0;
   for ( auto& elmdata : m_elm_data )
     xs += elmdata.second * eval_1mexpmtdivt( elmdata.first * e );
   return xs;
 }
 
+void NC::ElIncXS::evaluateMany( const double* ekin, std::size_t N, double* out_xs ) const
+{
+  if ( m_table ) {
+    for ( std::size_t i = 0; i < N; ++i )
+      out_xs[i] = evaluate( NeutronEnergy{ ekin[i] } );
+    return;
+  }
+  //Same as evaluate(..), but with the loop over elements as the outer loop:
+  constexpr double kkk = 16.0 * kPiSq * ekin2wlsqinv(1.0);
+  std::fill( out_xs, out_xs + N, 0.0 );
+  for ( auto& elmdata : m_elm_data ) {
+    const double k = elmdata.first * kkk;
+    const double c = elmdata.second;
+    for ( std::size_t i = 0; i < N; ++i )
+      out_xs[i] += c * eval_1mexpmtdivt( k * ekin[i] );
+  }
+}
+
 double NC::ElIncXS::eval_1mexpmtdivt(double t)
 {
   //safe eval of (1-exp(-t))/t for t>=0.0
@@ -88,6 +114,122 @@ void NC::ElIncXS::set( const VectD& elm_msd,
   m_elm_data.reserve_hint(elm_bixs.size());
   for ( auto i : ncrange( elm_msd.size() ) )
     m_elm_data.emplace_back( elm_msd[i], elm_bixs[i]*elm_scale[i] );
+  initTable();
+}
+
+void NC::ElIncXS::initTable()
+{
+  m_table.reset();
+  const std::size_t nelem = m_elm_data.size();
+  if ( nelem < 2 )
+    return;
+  double msdmin(kInfinity), msdmax(0.0);
+  for ( auto& elmdata : m_elm_data ) {
+    msdmin = ncmin( msdmin, elmdata.first );
+    msdmax = ncmax( msdmax, elmdata.first );
+  }
+  if ( !(msdmin>0.0) )
+    return;//keep it simple, elements without displacements are unphysical anyway
+
+  //See the description of the tabulation in the header file. Using 64 points
+  //per decade gives a relative precision of the splined cross sections better
+  //than 1e-8:
+  constexpr double pts_per_decade = 64.0;
+  constexpr unsigned npts_max = 2000;
+  auto t = std::make_unique<Table>();
+  t->elow = 0.01 / msdmax;
+  t->ehigh = 24.0 / msdmin;
+  t->logelow = std::log( t->elow );
+  const double logehigh = std::log( t->ehigh );
+  const double nptsd = std::ceil( ( logehigh - t->logelow ) * ( pts_per_decade / std::log(10.0) ) ) + 1.0;
+  if ( nptsd > npts_max )
+    return;//extreme range of displacements, stick with exact calculations
+  t->npts = ncmax( 8u, static_cast<unsigned>( nptsd ) );
+  const double dloge = ( logehigh - t->logelow ) / ( t->npts - 1 );
+  t->invdloge = 1.0 / dloge;
+
+  //Derivative of (1-exp(-t))/t:
+  auto deriv_1mexpmtdivt = []( double tt )
+  {
+    if ( tt < 0.01 )
+      return -0.5 + tt * ( 1.0/3.0 - tt * 0.125 );
+    return ( std::exp(-tt) * ( 1.0 + tt ) - 1.0 ) / ( tt * tt );
+  };
+  //Derivative of XStot with respect to log(e):
+  auto evalDerivLogE = [this,&deriv_1mexpmtdivt]( double e )
+  {
+    double res = 0.0;
+    for ( auto& elmdata : m_elm_data ) {
+      const double tt = elmdata.first * e;
+      res += elmdata.second * tt * deriv_1mexpmtdivt( tt );
+    }
+    return res;
+  };
+
+  //Commulative weights for element selection, with rows for e<elow (the
+  //e->0 limits, c_i), each grid point, and e>ehigh (c_i/msd_i, exact):
+  t->selweights.reserve( ( t->npts + 2 ) * nelem );
+  auto addRow = [&t,this]( double e, bool ehigh_limit )
+  {
+    double sum = 0.0;
+    for ( auto& ed : m_elm_data )
+      t->selweights.push_back( sum += ( ehigh_limit
+                                        ? ed.second / ed.first
+                                        : ed.second * eval_1mexpmtdivt( ed.first * e ) ) );
+  };
+  addRow( 0.0, false );
+  VectD fvals;
+  fvals.reserve( t->npts );
+  for ( unsigned j = 0; j < t->npts; ++j ) {
+    addRow( j + 1 == t->npts ? t->ehigh : std::exp( t->logelow + j * dloge ), false );
+    fvals.push_back( t->selweights.back() );
+  }
+  addRow( 0.0, true );
+  nc_assert_always( t->selweights.size() == ( t->npts + 2 ) * nelem );
+
+  t->xs.set( fvals, t->logelow, logehigh, evalDerivLogE( t->elow ), evalDerivLogE( t->ehigh ) );
+
+  //Polynomial coefficients for e<elow, consistent with the Taylor expansion
+  //in eval_1mexpmtdivt, and the coefficient for e>ehigh:
+  for ( auto& elmdata : m_elm_data ) {
+    const double c = elmdata.second;
+    const double m = elmdata.first;
+    t->lowcoeffs[0] += c;
+    t->lowcoeffs[1] += -0.5 * c * m;
+    t->lowcoeffs[2] += c * m * m * ( 1.0 / 6.0 );
+    t->lowcoeffs[3] += -c * m * m * m * ( 1.0 / 24.0 );
+    t->highcoeff += c / m;
+  }
+  m_table = std::move( t );
+}
+
+double NC::ElIncXS::sampleElementMSD( RNG& rng, double e ) const
+{
+  nc_assert( m_table );
+  const Table& t = *m_table;
+  const std::size_t nelem = m_elm_data.size();
+  std::size_t irow;
+  if ( e <= t.elow ) {
+    irow = 0;
+  } else if ( e >= t.ehigh ) {
+    irow = t.npts + 1;
+  } else {
+    const double x = ( std::log( e ) - t.logelow ) * t.invdloge;
+    irow = 1 + ncmin( static_cast<std::size_t>( ncmax( 0.0, x ) ), static_cast<std::size_t>( t.npts - 2 ) );
+  }
+  const double * row = &t.selweights[ irow * nelem ];
+  Span<const double> weights( row, row + nelem );
+  while ( true ) {
+    auto idx = pickRandIdxByWeight( rng, weights );
+    nc_assert( idx < nelem );
+    const auto& elmdata = m_elm_data[idx];
+    if ( irow == t.npts + 1 )
+      return elmdata.first;//weights are exact
+    //Accept according to ratio of actual contribution and majorant:
+    const double majorant = row[idx] - ( idx ? row[idx-1] : 0.0 );
+    if ( rng.generate() * majorant <= elmdata.second * eval_1mexpmtdivt( elmdata.first * e ) )
+      return elmdata.first;
+  }
 }
 
 double NC::ElIncXS::sampleMuMonoAtomic( RNG& rng, NeutronEnergy ekin, double meanSqDisp )
@@ -133,6 +275,11 @@ double NC::ElIncXS::sampleMu( RNG& rng, NeutronEnergy ekin )
   if ( nelem == 1 )
     return sampleMuMonoAtomic( rng, ekin, m_elm_data.front().first );
 
+  if ( m_table ) {
+    constexpr double kkk = 16.0 * kPiSq * ekin2wlsqinv(1.0);
+    return sampleMuMonoAtomic( rng, ekin, sampleElementMSD( rng, kkk * ekin.dbl() ) );
+  }
+
   //Calculate per-element contribution and select accordingly.
 
   //First a little trick to provide us with an array for caching element-wise
@@ -194,4 +341,5 @@ NC::ElIncXS::ElIncXS( const ElIncXS& a, double scale_a, const ElIncXS& b, double
   }
   result.shrink_to_fit();
   std::swap(m_elm_data,result);
+  initTable();
 }
@@ -21,117 +21,178 @@
 #include "NCrystal/internal/NCEqRefl.hh"
 #include "NCrystal/NCDefs.hh"
 
-NCrystal::EqRefl::EqRefl(int sg)
-{
-  if (sg<1||sg>230)
-    NCRYSTAL_THROW(BadInput,"Space group number is not in the range 1 to 230");
-
-  if (sg<149) {
-    if (sg<75) {
-      if (sg<3)
-        m_calc = &EqRefl::calc_Triclinic_1_2;
-      else if (sg<16)
-        m_calc = &EqRefl::calc_Monoclinic_3_15;
-      else
-        m_calc = &EqRefl::calc_Orthorhombic_16_74;
-    } else {
-      if (sg<89)
-        m_calc = &EqRefl::calc_Tetragonal_75_88;
-      else if (sg<143)
-        m_calc = &EqRefl::calc_Tetragonal_89_142;
-      else
-        m_calc = &EqRefl::calc_Trigonal_143_148;
+namespace NCrystal {
+  namespace {
+
+    //Symmetry operations of each Laue class, as integer matrices acting on
+    //(h,k,l). Only the operations giving distinct demi-normals are listed
+    //(i.e. one of each pair related by (h,k,l)->(-h,-k,-l)), with the identity
+    //always first:
+
+    constexpr int ops_Triclinic_1_2[][3][3] = {
+      { { 1, 0, 0}, { 0, 1, 0}, { 0, 0, 1} },//(h,k,l)
+    };
+    constexpr int ops_Monoclinic_3_15[][3][3] = {
+      { { 1, 0, 0}, { 0, 1, 0}, { 0, 0, 1} },//(h,k,l)
+      { { 1, 0, 0}, { 0,-1, 0}, { 0, 0, 1} },//(h,-k,l)
+    };
+    constexpr int ops_Orthorhombic_16_74[][3][3] = {
+      { { 1, 0, 0}, { 0, 1, 0}, { 0, 0, 1} },//(h,k,l)
+      { { 1, 0, 0}, { 0,-1, 0}, { 0, 0,-1} },//(h,-k,-l)
+      { { 1, 0, 0}, { 0,-1, 0}, { 0, 0, 1} },//(h,-k,l)
+      { { 1, 0, 0}, { 0, 1, 0}, { 0, 0,-1} },//(h,k,-l)
+    };
+    constexpr int ops_Tetragonal_75_88[][3][3] = {
+      { { 1, 0, 0}, { 0, 1, 0}, { 0, 0, 1} },//(h,k,l)
+      { { 0, 1, 0}, {-1, 0, 0}, { 0, 0,-1} },//(k,-h,-l)
+      { { 1, 0, 0}, { 0, 1, 0}, { 0, 0,-1} },//(h,k,-l)
+      { { 0, 1, 0}, {-1, 0, 0}, { 0, 0, 1} },//(k,-h,l)
+    };
+    constexpr int ops_Tetragonal_89_142[][3][3] = {
+      { { 1, 0, 0}, { 0, 1, 0}, { 0, 0, 1} },//(h,k,l)
+      { { 0, 1, 0}, { 1, 0, 0}, { 0, 0, 1} },//(k,h,l)
+      { { 0, 1, 0}, {-1, 0, 0}, { 0, 0,-1} },//(k,-h,-l)
+      { { 1, 0, 0}, { 0, 1, 0}, { 0, 0,-1} },//(h,k,-l)
+      { { 0, 1, 0}, {-1, 0, 0}, { 0, 0, 1} },//(k,-h,l)
+      { { 1, 0, 0}, { 0,-1, 0}, { 0, 0,-1} },//(h,-k,-l)
+      { { 0, 1, 0}, { 1, 0, 0}, { 0, 0,-1} },//(k,h,-l)
+      { { 1, 0, 0}, { 0,-1, 0}, { 0, 0, 1} },//(h,-k,l)
+    };
+    constexpr int ops_Trigonal_143_148[][3][3] = {
+      { { 1, 0, 0}, { 0, 1, 0}, { 0, 0, 1} },//(h,k,l)
+      { { 1, 1, 0}, {-1, 0, 0}, { 0, 0,-1} },//(h+k,-h,-l)
+      { { 0, 1, 0}, {-1,-1, 0}, { 0, 0, 1} },//(k,-h-k,l)
+    };
+    constexpr int ops_Trigonal_149_167[][3][3] = {
+      { { 1, 0, 0}, { 0, 1, 0}, { 0, 0, 1} },//(h,k,l)
+      { { 1, 1, 0}, {-1, 0, 0}, { 0, 0,-1} },//(h+k,-h,-l)
+      { { 0, 1, 0}, {-1,-1, 0}, { 0, 0, 1} },//(k,-h-k,l)
+      { { 0, 1, 0}, { 1, 0, 0}, { 0, 0,-1} },//(k,h,-l)
+      { { 1, 1, 0}, { 0,-1, 0}, { 0, 0, 1} },//(h+k,-k,l)
+      { { 1, 0, 0}, {-1,-1, 0}, { 0, 0,-1} },//(h,-h-k,-l)
+    };
+    constexpr int ops_Hexagonal_168_176[][3][3] = {
+      { { 1, 0, 0}, { 0, 1, 0}, { 0, 0, 1} },//(h,k,l)
+      { { 1, 0, 0}, { 0, 1, 0}, { 0, 0,-1} },//(h,k,-l)
+      { { 0, 1, 0}, {-1,-1, 0}, { 0, 0,-1} },//(k,-h-k,-l)
+      { { 0, 1, 0}, {-1,-1, 0}, { 0, 0, 1} },//(k,-h-k,l)
+      { { 1, 1, 0}, {-1, 0, 0}, { 0, 0, 1} },//(h+k,-h,l)
+      { { 1, 1, 0}, {-1, 0, 0}, { 0, 0,-1} },//(h+k,-h,-l)
+    };
+    constexpr int ops_Hexagonal_177_194[][3][3] = {
+      { { 1, 0, 0}, { 0, 1, 0}, { 0, 0, 1} },//(h,k,l)
+      { { 0, 1, 0}, {-1,-1, 0}, { 0, 0,-1} },//(k,-h-k,-l)
+      { { 1, 1, 0}, {-1, 0, 0}, { 0, 0,-1} },//(h+k,-h,-l)
+      { { 1, 0, 0}, { 0, 1, 0}, { 0, 0,-1} },//(h,k,-l)
+      { { 0, 1, 0}, {-1,-1, 0}, { 0, 0, 1} },//(k,-h-k,l)
+      { { 1, 1, 0}, {-1, 0, 0}, { 0, 0, 1} },//(h+k,-h,l)
+      { { 0, 1, 0}, { 1, 0, 0}, { 0, 0, 1} },//(k,h,l)
+      { { 1, 1, 0}, { 0,-1, 0}, { 0, 0, 1} },//(h+k,-k,l)
+      { { 1, 0, 0}, {-1,-1, 0}, { 0, 0, 1} },//(h,-h-k,l)
+      { { 0, 1, 0}, { 1, 0, 0}, { 0, 0,-1} },//(k,h,-l)
+      { { 1, 1, 0}, { 0,-1, 0}, { 0, 0,-1} },//(h+k,-k,-l)
+      { { 1, 0, 0}, {-1,-1, 0}, { 0, 0,-1} },//(h,-h-k,-l)
+    };
+    constexpr int ops_Cubic_195_206[][3][3] = {
+      { { 1, 0, 0}, { 0, 1, 0}, { 0, 0, 1} },//(h,k,l)
+      { { 1, 0, 0}, { 0,-1, 0}, { 0, 0,-1} },//(h,-k,-l)
+      { { 1, 0, 0}, { 0,-1, 0}, { 0, 0, 1} },//(h,-k,l)
+      { { 1, 0, 0}, { 0, 1, 0}, { 0, 0,-1} },//(h,k,-l)
+      { { 0, 1, 0}, { 0, 0, 1}, { 1, 0, 0} },//(k,l,h)
+      { { 0, 1, 0}, { 0, 0,-1}, {-1, 0, 0} },//(k,-l,-h)
+      { { 0, 1, 0}, { 0, 0,-1}, { 1, 0, 0} },//(k,-l,h)
+      { { 0, 1, 0}, { 0, 0, 1}, {-1, 0, 0} },//(k,l,-h)
+      { { 0, 0, 1}, { 1, 0, 0}, { 0, 1, 0} },//(l,h,k)
+      { { 0, 0, 1}, {-1, 0, 0}, { 0,-1, 0} },//(l,-h,-k)
+      { { 0, 0, 1}, {-1, 0, 0}, { 0, 1, 0} },//(l,-h,k)
+      { { 0, 0, 1}, { 1, 0, 0}, { 0,-1, 0} },//(l,h,-k)
+    };
+    constexpr int ops_Cubic_207_230[][3][3] = {
+      { { 1, 0, 0}, { 0, 1, 0}, { 0, 0, 1} },//(h,k,l)
+      { { 1, 0, 0}, { 0,-1, 0}, { 0, 0,-1} },//(h,-k,-l)
+      { { 1, 0, 0}, { 0,-1, 0}, { 0, 0, 1} },//(h,-k,l)
+      { { 1, 0, 0}, { 0, 1, 0}, { 0, 0,-1} },//(h,k,-l)
+      { { 0, 1, 0}, { 0, 0, 1}, { 1, 0, 0} },//(k,l,h)
+      { { 0, 1, 0}, { 0, 0,-1}, {-1, 0, 0} },//(k,-l,-h)
+      { { 0, 1, 0}, { 0, 0,-1}, { 1, 0, 0} },//(k,-l,h)
+      { { 0, 1, 0}, { 0, 0, 1}, {-1, 0, 0} },//(k,l,-h)
+      { { 0, 0, 1}, { 1, 0, 0}, { 0, 1, 0} },//(l,h,k)
+      { { 0, 0, 1}, {-1, 0, 0}, { 0,-1, 0} },//(l,-h,-k)
+      { { 0, 0, 1}, {-1, 0, 0}, { 0, 1, 0} },//(l,-h,k)
+      { { 0, 0, 1}, { 1, 0, 0}, { 0,-1, 0} },//(l,h,-k)
+      { { 0, 1, 0}, { 1, 0, 0}, { 0, 0, 1} },//(k,h,l)
+      { { 0, 1, 0}, {-1, 0, 0}, { 0, 0,-1} },//(k,-h,-l)
+      { { 0, 1, 0}, {-1, 0, 0}, { 0, 0, 1} },//(k,-h,l)
+      { { 0, 1, 0}, { 1, 0, 0}, { 0, 0,-1} },//(k,h,-l)
+      { { 0, 0, 1}, { 0, 1, 0}, { 1, 0, 0} },//(l,k,h)
+      { { 0, 0, 1}, { 0,-1, 0}, {-1, 0, 0} },//(l,-k,-h)
+      { { 0, 0, 1}, { 0,-1, 0}, { 1, 0, 0} },//(l,-k,h)
+      { { 0, 0, 1}, { 0, 1, 0}, {-1, 0, 0} },//(l,k,-h)
+      { { 1, 0, 0}, { 0, 0, 1}, { 0, 1, 0} },//(h,l,k)
+      { { 1, 0, 0}, { 0, 0,-1}, { 0,-1, 0} },//(h,-l,-k)
+      { { 1, 0, 0}, { 0, 0,-1}, { 0, 1, 0} },//(h,-l,k)
+      { { 1, 0, 0}, { 0, 0, 1}, { 0,-1, 0} },//(h,l,-k)
+    };
+
+    struct EqReflOpTable {
+      const int (*ops)[3][3];
+      std::size_t nops;
+    };
+
+    template<std::size_t N>
+    constexpr EqReflOpTable mkTable( const int (&ops)[N][3][3] )
+    {
+      return EqReflOpTable{ ops, N };
     }
-  } else {
-    if (sg<195) {
-      if (sg<168)
-        m_calc = &EqRefl::calc_Trigonal_149_167;
-      else if (sg<177)
-        m_calc = &EqRefl::calc_Hexagonal_168_176;
-      else
-        m_calc = &EqRefl::calc_Hexagonal_177_194;
-    } else {
-      if (sg<207)
-        m_calc = &EqRefl::calc_Cubic_195_206;
-      else
-        m_calc = &EqRefl::calc_Cubic_207_230;
+
+    EqReflOpTable eqReflOpsForSpaceGroup( int sg )
+    {
+      nc_assert( sg>=1 && sg<=230 );
+      if (sg<3)   return mkTable( ops_Triclinic_1_2 );
+      if (sg<16)  return mkTable( ops_Monoclinic_3_15 );
+      if (sg<75)  return mkTable( ops_Orthorhombic_16_74 );
+      if (sg<89)  return mkTable( ops_Tetragonal_75_88 );
+      if (sg<143) return mkTable( ops_Tetragonal_89_142 );
+      if (sg<149) return mkTable( ops_Trigonal_143_148 );
+      if (sg<168) return mkTable( ops_Trigonal_149_167 );
+      if (sg<177) return mkTable( ops_Hexagonal_168_176 );
+      if (sg<195) return mkTable( ops_Hexagonal_177_194 );
+      if (sg<207) return mkTable( ops_Cubic_195_206 );
+      return mkTable( ops_Cubic_207_230 );
     }
   }
+}
 
+NCrystal::EqRefl::EqRefl(int sg)
+{
+  if (sg<1||sg>230)
+    NCRYSTAL_THROW(BadInput,"Space group number is not in the range 1 to 230");
+  const auto table = eqReflOpsForSpaceGroup(sg);
+  m_ops = table.ops;
+  m_nops = table.nops;
+  m_planes.reserve(m_nops);
 }
 
 NCrystal::EqRefl::~EqRefl()
 {
 }
 
-const std::set<NCrystal::EqRefl::HKL>& NCrystal::EqRefl::getEquivalentReflections(int h, int k, int l)
+const std::vector<NCrystal::EqRefl::HKL>& NCrystal::EqRefl::getEquivalentReflections(int h, int k, int l)
 {
   m_planes.clear();
-  add(h,k,l);//this one is common for all spacegroups
-  (this->*m_calc)(h,k,l);
+  for ( std::size_t i = 0; i < m_nops; ++i ) {
+    const auto& m = m_ops[i];
+    HKL a( m[0][0]*h + m[0][1]*k + m[0][2]*l,
+           m[1][0]*h + m[1][1]*k + m[1][2]*l,
+           m[2][0]*h + m[2][1]*k + m[2][2]*l );
+    HKL am(-a.h,-a.k,-a.l);
+    //only keep one deminormal, not both am and a:
+    if ( a < am )
+      a = am;
+    if ( std::find( m_planes.begin(), m_planes.end(), a ) == m_planes.end() )
+      m_planes.push_back(a);
+  }
+  //Sorted for reproducibility:
+  std::sort( m_planes.begin(), m_planes.end() );
   return m_planes;
 }
-
-void NCrystal::EqRefl::calc_Triclinic_1_2(int, int, int)
-{
-}
-
-void NCrystal::EqRefl::calc_Monoclinic_3_15(int h, int k, int l)
-{
-  add(h,-k,l);
-}
-
-void NCrystal::EqRefl::calc_Orthorhombic_16_74(int h, int k, int l)
-{
-  add(h,-k,-l); add(h,-k,l); add(h,k,-l);
-}
-
-void NCrystal::EqRefl::calc_Tetragonal_75_88(int h, int k, int l)
-{
-  add(k,-h,-l); add(h,k,-l); add(k,-h,l);
-}
-
-void NCrystal::EqRefl::calc_Tetragonal_89_142(int h, int k, int l)
-{
-  add(k,h,l); add(k,-h,-l); add(h,k,-l);
-  add(k,-h,l); add(h,-k,-l); add(k,h,-l); add(h,-k,l);
-}
-
-void NCrystal::EqRefl::calc_Trigonal_143_148(int h, int k, int l)
-{
-  add(h+k,-h,-l); add(k,-h-k,l);
-}
-
-void NCrystal::EqRefl::calc_Trigonal_149_167(int h, int k, int l)
-{
-  add(h+k,-h,-l); add(k,-h-k,l); add(k,h,-l); add(h+k,-k,l); add(h,-h-k,-l);
-}
-
-void NCrystal::EqRefl::calc_Hexagonal_168_176(int h, int k, int l)
-{
-  add(h,k,-l); add(k,-h-k,-l); add(k,-h-k,l); add(h+k,-h,l); add(h+k,-h,-l);
-}
-
-void NCrystal::EqRefl::calc_Hexagonal_177_194(int h, int k, int l)
-{
-  add(k,-h-k,-l); add(h+k,-h,-l); add(h,k,-l); add(k,-h-k,l);
-  add(h+k,-h,l); add(k,h,l); add(h+k,-k,l); add(h,-h-k,l);
-  add(k,h,-l); add(h+k,-k,-l); add(h,-h-k,-l);
-}
-
-void NCrystal::EqRefl::calc_Cubic_195_206(int h, int k, int l)
-{
-  add(h,-k,-l); add(h,-k,l); add(h,k,-l);
-  add(k,l,h); add(k,-l,-h); add(k,-l,h); add(k,l,-h);
-  add(l,h,k); add(l,-h,-k); add(l,-h,k); add(l,h,-k);
-}
-
-void NCrystal::EqRefl::calc_Cubic_207_230(int h, int k, int l)
-{
-  add(h,-k,-l); add(h,-k,l); add(h,k,-l);
-  add(k,l,h); add(k,-l,-h); add(k,-l,h); add(k,l,-h);
-  add(l,h,k); add(l,-h,-k); add(l,-h,k); add(l,h,-k);
-  add(k,h,l); add(k,-h,-l); add(k,-h,l); add(k,h,-l);
-  add(l,k,h); add(l,-k,-h); add(l,-k,h); add(l,k,-h);
-  add(h,l,k); add(h,-l,-k); add(h,-l,k); add(h,l,-k);
-}
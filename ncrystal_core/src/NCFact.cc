@@ -57,6 +57,11 @@ NC::Absorption NC::createAbsorption( const MatCfg& cfg )
   return Absorption( FactImpl::createAbsorption( cfg ) );
 }
 
+NC::TotalXS NC::createTotalXS( const MatCfg& cfg )
+{
+  return TotalXS( createScatter( cfg ), createAbsorption( cfg ) );
+}
+
 NC::shared_obj<const NC::Info> NC::createInfo( const MatCfg& cfg )
 {
   return FactImpl::createInfo(cfg);
@@ -23,6 +23,12 @@
 #include "NCrystal/internal/NCFactoryUtils.hh"
 #include "NCrystal/internal/NCString.hh"
 #include "NCrystal/internal/NCFileUtils.hh"
+#include "NCrystal/internal/NCThreadUtils.hh"
+#include "NCrystal/internal/NCSABDiskCache.hh"
+#include "NCrystal/internal/NCNCMATBinary.hh"
+#include "NCrystal/internal/NCTrace.hh"
+#include <unordered_map>
+#include <thread>
 
 namespace NC = NCrystal;
 namespace NCF = NCrystal::FactImpl;
@@ -69,6 +75,10 @@ namespace NCrystal {
         {
           return key.toString();
         };
+        std::size_t approxMemoryUsage( const value_type& v ) const final
+        {
+          return FactDef::approxMemoryUsage(v);
+        }
         const char* factoryName() const final
         {
           static std::string name = std::string(FactDef::name())+"FactoryDB";
@@ -275,35 +285,38 @@ namespace NCrystal {
         bool operator<(const DBKey_TextDataPath&o) const { return m_path < o.m_path; }
       };
 
-      class DBKey_MatCfg {
-        MatCfg m_cfg;
+      //The MatCfg based keys carry the canonical compact cache key of the
+      //configuration, so the caches can use hash maps, and so the key is only
+      //computed once per configuration object (rather than field by field
+      //string comparisons in every map lookup):
+      template<class TCfg>
+      class DBKey_MatCfgBase {
+        TCfg m_cfg;
+        MatCfg::CacheKeySP m_key;
+        DBKey_MatCfgBase( const TCfg& cfg, MatCfg::CacheKeySP key ) : m_cfg(cfg), m_key(std::move(key)) {}
       public:
-        using userfact_keytype = MatCfg;
-        DBKey_MatCfg( const MatCfg& cfg ) : m_cfg(cfg) {}
-        const MatCfg& getUserFactoryKey() const { return m_cfg; }
+        using userfact_keytype = TCfg;
+        DBKey_MatCfgBase( const TCfg& cfg ) : m_cfg(cfg), m_key(cfg.cacheKey()) {}
+        const TCfg& getUserFactoryKey() const { return m_cfg; }
         void validate() const { m_cfg.checkConsistency(); }
         std::string toString() const { return m_cfg.toStrCfg(); }
-        bool operator<(const DBKey_MatCfg&o) const { return m_cfg < o.m_cfg; }
-        DBKey_MatCfg cloneThinned() const { return m_cfg.cloneThinned(); }
-      };
-
-      class DBKey_MatInfoCfg {
-        MatInfoCfg m_cfg;
-      public:
-        using userfact_keytype = MatInfoCfg;
-        DBKey_MatInfoCfg( const MatInfoCfg& cfg ) : m_cfg(cfg) {}
-        const MatInfoCfg& getUserFactoryKey() const { return m_cfg; }
-        void validate() const { m_cfg.checkConsistency(); }
-        std::string toString() const { return m_cfg.toStrCfg(); }
-        bool operator<(const DBKey_MatInfoCfg&o) const { return m_cfg < o.m_cfg; }
-        DBKey_MatInfoCfg cloneThinned() const { return m_cfg.cloneThinned(); }
+        bool operator<(const DBKey_MatCfgBase&o) const { return m_cfg < o.m_cfg; }
+        bool operator==(const DBKey_MatCfgBase&o) const { return m_key == o.m_key || *m_key == *o.m_key; }
+        DBKey_MatCfgBase cloneThinned() const { return DBKey_MatCfgBase( m_cfg.cloneThinned(), m_key ); }
+        struct Hasher {
+          std::size_t operator()( const DBKey_MatCfgBase& k ) const { return static_cast<std::size_t>(k.m_key->hash); }
+        };
       };
+      using DBKey_MatCfg = DBKey_MatCfgBase<MatCfg>;
+      using DBKey_MatInfoCfg = DBKey_MatCfgBase<MatInfoCfg>;
 
       template<class TKey = DBKey_MatCfg>
       struct DBKeyThinner {
         //Thinning (DBKey_)MatCfg objects so we don't have strong TextData refs in the cache map keys.
         using key_type = TKey;
         using thinned_key_type = TKey;
+        template <class TMapped>
+        using map_type = std::unordered_map<thinned_key_type,TMapped,typename TKey::Hasher>;
         template <class TMap>
         static typename TMap::mapped_type& cacheMapLookup( TMap& map, const key_type& key, Optional<thinned_key_type>& tkey )
         {
@@ -363,6 +376,7 @@ namespace NCrystal {
         using TProdRV = produced_type;
         //Not used, just needs to be here:
         static shared_obj<const TProdRV> transformTProdRVToShPtr( TProdRV ) { return optional_shared_obj<const TProdRV>{nullptr}; }
+        static std::size_t approxMemoryUsage( const produced_type& ) { return 0; }
         using TKeyThinner = CFB_Unthinned_t<key_type>;
       };
 
@@ -385,6 +399,7 @@ namespace NCrystal {
         //produces shared objects directly:
         using TProdRV = shared_obj<const produced_type>;
         static TProdRV transformTProdRVToShPtr( TProdRV o ) { return o; }
+        static std::size_t approxMemoryUsage( const produced_type& info ) { return memoryFootprint(info).totalBytes(); }
       };
 
       struct FactDefScatter {
@@ -403,6 +418,8 @@ namespace NCrystal {
         //produces shared objects directly:
         using TProdRV = shared_obj<const produced_type>;
         static TProdRV transformTProdRVToShPtr( TProdRV o ) { return o; }
+        //Unknown, since heavy data is usually shared via other caches:
+        static std::size_t approxMemoryUsage( const produced_type& ) { return 0; }
       };
 
       struct FactDefAbsorption {
@@ -421,6 +438,8 @@ namespace NCrystal {
         //produces shared objects directly:
         using TProdRV = shared_obj<const produced_type>;
         static TProdRV transformTProdRVToShPtr( TProdRV o ) { return o; }
+        //Unknown, since heavy data is usually shared via other caches:
+        static std::size_t approxMemoryUsage( const produced_type& ) { return 0; }
       };
 
       //The actual global DB instances (avoid global statics and encapsulate in
@@ -449,12 +468,126 @@ namespace NCrystal {
   }
 }
 
+namespace NCrystal {
+  namespace FactImpl {
+    namespace {
+      double initialTextDataRevalidationInterval()
+      {
+        std::string s = ncgetenv("TEXTDATA_REVALIDATE");
+        if ( s.empty() )
+          return -1.0;
+        if ( s == "immutable" )
+          return kInfinity;
+        return str2dbl( s, "Invalid value of NCRYSTAL_TEXTDATA_REVALIDATE"
+                        " (must be a number of seconds or \"immutable\")" );
+      }
+
+      struct TDRevalidationDB {
+        struct Entry {
+          TextDataSP td;
+          Optional<FileStamp> stamp;//only for on-disk data
+          std::chrono::steady_clock::time_point lastCheck;
+        };
+        std::mutex mtx;
+        std::atomic<double> interval{ initialTextDataRevalidationInterval() };
+        std::unordered_map<std::string,Entry> entries;
+        bool cleanupRegistered = false;
+      };
+
+      TDRevalidationDB& tdRevalidationDB() { static TDRevalidationDB db; return db; }
+
+      template<class TPred>
+      void clearTDRevalidationDBIf( TPred pred )
+      {
+        auto& db = tdRevalidationDB();
+        std::vector<std::shared_ptr<const void>> released;
+        {
+          NCRYSTAL_LOCK_GUARD(db.mtx);
+          for ( auto it = db.entries.begin(); it != db.entries.end(); ) {
+            if ( pred( *it->second.td ) ) {
+              released.push_back( std::move(it->second.td) );
+              it = db.entries.erase( it );
+            } else {
+              ++it;
+            }
+          }
+        }
+        disposeReleasedCacheObjects( std::move(released) );
+      }
+
+      void clearTDRevalidationDB()
+      {
+        clearTDRevalidationDBIf( []( const TextData& ) { return true; } );
+      }
+
+      Optional<TextDataSP> lookupTDRevalidationDB( const std::string& key, double interval )
+      {
+        auto& db = tdRevalidationDB();
+        Optional<std::string> onDiskPath;
+        Optional<FileStamp> stamp;
+        {
+          NCRYSTAL_LOCK_GUARD(db.mtx);
+          auto it = db.entries.find( key );
+          if ( it == db.entries.end() )
+            return NullOpt;
+          auto now = std::chrono::steady_clock::now();
+          if ( std::chrono::duration<double>( now - it->second.lastCheck ).count() <= interval )
+            return it->second.td;
+          if ( !it->second.stamp.has_value() ) {
+            //In-memory data: do full search again.
+            db.entries.erase( it );
+            return NullOpt;
+          }
+          onDiskPath = it->second.td->getLastKnownOnDiskLocation();
+          stamp = it->second.stamp.value();
+        }
+        //Stat file outside lock:
+        nc_assert( onDiskPath.has_value() );
+        auto newstamp = tryGetFileStamp( onDiskPath.value() );
+        NCRYSTAL_LOCK_GUARD(db.mtx);
+        auto it = db.entries.find( key );
+        if ( it == db.entries.end() )
+          return NullOpt;
+        if ( !newstamp.has_value() || !( newstamp.value() == stamp.value() ) ) {
+          db.entries.erase( it );
+          return NullOpt;
+        }
+        it->second.lastCheck = std::chrono::steady_clock::now();
+        return it->second.td;
+      }
+
+      void addToTDRevalidationDB( const std::string& key, const TextDataSP& td )
+      {
+        auto& db = tdRevalidationDB();
+        TDRevalidationDB::Entry entry{ td, NullOpt, std::chrono::steady_clock::now() };
+        const auto& onDiskPath = td->getLastKnownOnDiskLocation();
+        if ( onDiskPath.has_value() ) {
+          entry.stamp = tryGetFileStamp( onDiskPath.value() );
+          if ( !entry.stamp.has_value() )
+            return;//can not validate later
+        }
+        NCRYSTAL_LOCK_GUARD(db.mtx);
+        if ( !db.cleanupRegistered ) {
+          db.cleanupRegistered = true;
+          registerCacheCleanupFunction(clearTDRevalidationDB);
+        }
+        nc_map_force_emplace( db.entries, key, std::move(entry) );
+      }
+    }
+  }
+}
+
 void NCF::removeTextDataFactoryIfExists( const std::string& name )
 {
-  return textDataDB().removeFactoryIfExists( name );
+  textDataDB().removeFactoryIfExists( name );
+  clearTDRevalidationDB();
 }
 
-void NCF::registerFactory( std::unique_ptr<const TextDataFactory> f, RegPolicy rp ) { textDataDB().addFactory(std::move(f),rp); }
+void NCF::registerFactory( std::unique_ptr<const TextDataFactory> f, RegPolicy rp )
+{
+  textDataDB().addFactory(std::move(f),rp);
+  clearTDRevalidationDB();
+}
 void NCF::registerFactory( std::unique_ptr<const NCF::InfoFactory> f, NCF::RegPolicy rp ) { infoDB().addFactory(std::move(f),rp); }
 void NCF::registerFactory( std::unique_ptr<const NCF::ScatterFactory> f, NCF::RegPolicy rp ) { scatterDB().addFactory(std::move(f),rp); }
 void NCF::registerFactory( std::unique_ptr<const NCF::AbsorptionFactory> f, NCF::RegPolicy rp ) { absorptionDB().addFactory(std::move(f),rp); }
@@ -484,28 +617,140 @@ namespace NCrystal {
   namespace FactImpl {
     //Fwd declare fct implemented in NCTDProd.cc:
    TextDataSP produceTextDataSP_PreferPreviousObject( const TextDataPath&, TextDataSource&& );
+    namespace {
+      //Selects cache entries of both MatCfg and MatInfoCfg based DBs:
+      struct KeyHasTextDataUID {
+        TextDataUID uid;
+        template<class TCfg>
+        bool operator()( const DBKey_MatCfgBase<TCfg>& key ) const
+        {
+          return key.getUserFactoryKey().textDataUID() == uid;
+        }
+      };
+    }
   }
 }
 
+void NCF::clearCachesFor( TextDataUID uid )
+{
+  if (getFactoryVerbosity())
+    std::cout<<"NCrystal::Factory - called clearCachesFor(TextDataUID="<<uid.value()<<")."<<std::endl;
+  const KeyHasTextDataUID pred{ uid };
+  scatterDB().cleanupIf( pred );
+  absorptionDB().cleanupIf( pred );
+  infoDB().cleanupIf( pred );
+  clearTDRevalidationDBIf( [uid]( const TextData& td ) { return td.dataUID() == uid; } );
+}
+
+void NCF::setTextDataRevalidationInterval( double seconds )
+{
+  if ( std::isnan( seconds ) )
+    NCRYSTAL_THROW(BadInput,"Invalid TextData revalidation interval");
+  tdRevalidationDB().interval = seconds;
+  clearTDRevalidationDB();
+}
+
+double NCF::getTextDataRevalidationInterval()
+{
+  return tdRevalidationDB().interval;
+}
+
 NC::shared_obj<const NC::TextData> NCF::createTextData( const TextDataPath& path )
 {
-  //Always recheck the source without cache (file might have changed on-disk,
+  Trace::Span span("FactImpl::createTextData");
+  if ( span.active() )
+    span.setDetail( path.toString() );
+
+  //Possibly reuse previous result without (full) recheck, if allowed by the
+  //revalidation policy:
+  const double interval = tdRevalidationDB().interval;
+  std::string key;
+  if ( interval >= 0.0 ) {
+    key = path.toString();
+    auto td = lookupTDRevalidationDB( key, interval );
+    if ( td.has_value() )
+      return std::move( td.value() );
+  }
+
+  //Otherwise recheck the source without cache (file might have changed on-disk,
   //process might have changed working directory, ...):
   auto textDataSource = textDataDB().searchAndCreateTProdRV( path );
 
   //But whenever identical (and possible given memory constraints of caching),
   //the object is the same as the one returned on previous calls:
-  return produceTextDataSP_PreferPreviousObject( path, std::move(textDataSource) );
+  auto td = produceTextDataSP_PreferPreviousObject( path, std::move(textDataSource) );
+  if ( interval >= 0.0 )
+    addToTDRevalidationDB( key, td );
+  return td;
+}
+
+namespace NCrystal {
+  namespace FactImpl {
+    namespace {
+      //Info object made available to createInfo calls on the current thread
+      //while createMulti is producing Scatter and Absorption objects:
+      struct PinnedInfo {
+        const MatInfoCfg* infocfg = nullptr;
+        const shared_obj<const Info>* info = nullptr;
+      };
+      PinnedInfo& pinnedInfo()
+      {
+        static thread_local PinnedInfo pi;
+        return pi;
+      }
+      class PinnedInfoGuard : private NoCopyMove {
+        PinnedInfo m_prev;
+      public:
+        PinnedInfoGuard( const MatInfoCfg& infocfg, const shared_obj<const Info>& info )
+          : m_prev( pinnedInfo() )
+        {
+          pinnedInfo().infocfg = &infocfg;
+          pinnedInfo().info = &info;
+        }
+        ~PinnedInfoGuard() { pinnedInfo() = m_prev; }
+      };
+    }
+  }
 }
 
 NC::shared_obj<const NC::Info> NCF::createInfo( const MatCfg& cfg )
 {
-  return infoDB().createWithOrWithoutCache( { cfg.createInfoCfg() } );
+  Trace::Span span("FactImpl::createInfo");
+  if ( span.active() )
+    span.setDetail( cfg.toStrCfg() );
+  auto infocfg = cfg.createInfoCfg();
+  const auto& pi = pinnedInfo();
+  if ( pi.infocfg && !( infocfg < *pi.infocfg ) && !( *pi.infocfg < infocfg ) )
+    return *pi.info;
+  return infoDB().createWithOrWithoutCache( { std::move(infocfg) } );
+}
+
+namespace NCrystal {
+  namespace FactImpl {
+    namespace {
+      //The packing factor only scales macroscopic quantities (i.e. number
+      //densities of atoms), never the per-atom cross sections of processes. So
+      //processes are created (and cached) from a reduced cfg without packfact,
+      //making cfgs which differ only in packfact share the same process tree
+      //(Info objects are already shared, since MatInfoCfg ignores packfact):
+      MatCfg reducedProcessCfg( const MatCfg& cfg )
+      {
+        if ( cfg.get_packfact() != 1.0 )
+          cfg.checkConsistency();//validate original before discarding packfact
+        return cfg.cloneWithoutPackfact();
+      }
+    }
+  }
 }
 
 NC::shared_obj<const NC::ProcImpl::Process> NCF::createScatter( const MatCfg& cfg )
 {
-  auto p = scatterDB().createWithOrWithoutCache( { cfg } );
+  Trace::Span span("FactImpl::createScatter");
+  if ( span.active() )
+    span.setDetail( cfg.toStrCfg() );
+  if ( cfg.get_propsonly() )
+    NCRYSTAL_THROW(BadInput,"The propsonly parameter can only be used when creating Info objects");
+  auto p = scatterDB().createWithOrWithoutCache( { reducedProcessCfg( cfg ) } );
   auto pt = p->processType();
   if ( pt != ProcessType::Scatter )
     NCRYSTAL_THROW2(CalcError,"Scatter factory created "<<pt<<" process!");
@@ -514,13 +759,197 @@ NC::shared_obj<const NC::ProcImpl::Process> NCF::createScatter( const MatCfg& cf
 
 NC::shared_obj<const NC::ProcImpl::Process> NCF::createAbsorption( const MatCfg& cfg )
 {
-  auto p = absorptionDB().createWithOrWithoutCache( { cfg } );
+  Trace::Span span("FactImpl::createAbsorption");
+  if ( span.active() )
+    span.setDetail( cfg.toStrCfg() );
+  auto p = absorptionDB().createWithOrWithoutCache( { reducedProcessCfg( cfg ) } );
   auto pt = p->processType();
   if ( pt != ProcessType::Absorption )
     NCRYSTAL_THROW2(CalcError,"Absorption factory created "<<pt<<" process!");
   return p;
 }
 
+NCF::MultiCreated NCF::createMulti( const MatCfg& cfg,
+                                    bool wantInfo,
+                                    bool wantScatter,
+                                    bool wantAbsorption )
+{
+  MultiCreated res;
+  if ( !wantScatter && !wantAbsorption ) {
+    if ( wantInfo )
+      res.info = createInfo( cfg );
+    return res;
+  }
+  const auto infocfg = cfg.createInfoCfg();
+  const auto info = createInfo( cfg );
+  PinnedInfoGuard guard( infocfg, info );
+  if ( wantInfo )
+    res.info = info;
+  if ( wantScatter )
+    res.scatter = createScatter( cfg );
+  if ( wantAbsorption )
+    res.absorption = createAbsorption( cfg );
+  return res;
+}
+
+void NCF::saveSnapshot( const std::string& path, const VectS& cfgstrs )
+{
+  saveSnapshot( path, cfgstrs, getNThreadsFromEnv() );
+}
+
+namespace NCrystal {
+  namespace FactImpl {
+    namespace {
+      template<class TFinish>
+      auto recordSnapshot( const VectS& cfgstrs, unsigned nthreads, TFinish finish ) -> decltype(finish())
+      {
+        if ( nthreads == 0 )
+          nthreads = ncmax( 1u, std::thread::hardware_concurrency() );
+        //Clear caches, so all derived data is produced (or loaded) again and
+        //therefore recorded. The MatCfg objects are only created afterwards,
+        //so they refer to the same TextData objects as those subsequently
+        //created by client code. Recording is MT-safe, and the resulting
+        //snapshot does not depend on the order in which objects are created:
+        clearCaches();
+        SAB::beginSnapshotRecording();
+        try {
+          parallelFor( cfgstrs.size(), nthreads, [&cfgstrs]( std::size_t i )
+          {
+            MatCfg cfg( cfgstrs.at(i) );
+            createInfo( cfg );
+            createScatter( cfg );
+            createAbsorption( cfg );
+          } );
+        } catch (...) {
+          SAB::endSnapshotRecording( std::string() );//discard
+          throw;
+        }
+        return finish();
+      }
+    }
+  }
+}
+
+void NCF::saveSnapshot( const std::string& path, const VectS& cfgstrs, unsigned nthreads )
+{
+  nc_assert_always(!path.empty());
+  recordSnapshot( cfgstrs, nthreads, [&path]() { SAB::endSnapshotRecording( path ); } );
+}
+
+std::string NCF::saveSnapshotToMemory( const VectS& cfgstrs, unsigned nthreads )
+{
+  return recordSnapshot( cfgstrs, nthreads, []() { return SAB::endSnapshotRecordingToMemory(); } );
+}
+
+void NCF::loadSnapshot( const std::string& path )
+{
+  SAB::loadSnapshot( path );
+}
+
+void NCF::loadSnapshotFromMemory( const unsigned char * data, std::size_t size )
+{
+  SAB::loadSnapshotFromMemory( reinterpret_cast<const char*>(data), size );
+}
+
+namespace NCrystal {
+  namespace FactImpl {
+    namespace {
+      //Keeps track of in-flight asynchronous creation jobs, so concurrent
+      //requests for the same key can share a single job. Entries are removed
+      //when the jobs finish (from then on, requests are serviced by the normal
+      //factory caches):
+      template<class TKey, class TResult>
+      class AsyncJobs {
+      public:
+        using future_type = std::shared_future<TResult>;
+        future_type launch( const TKey& key, std::function<TResult()> fct )
+        {
+          auto promise = std::make_shared<std::promise<TResult>>();
+          future_type fut;
+          {
+            NCRYSTAL_LOCK_GUARD(m_mutex);
+            auto it = m_inflight.find(key);
+            if ( it != m_inflight.end() )
+              return it->second;
+            fut = promise->get_future().share();
+            m_inflight.emplace( key, fut );
+          }
+          runInBackground( [this,key,promise,fct]()
+          {
+            try {
+              auto res = fct();
+              this->jobFinished(key);
+              promise->set_value( std::move(res) );
+            } catch (...) {
+              this->jobFinished(key);
+              promise->set_exception( std::current_exception() );
+            }
+          } );
+          return fut;
+        }
+      private:
+        std::mutex m_mutex;
+        std::map<TKey,future_type> m_inflight;
+        void jobFinished( const TKey& key )
+        {
+          NCRYSTAL_LOCK_GUARD(m_mutex);
+          m_inflight.erase(key);
+        }
+      };
+
+      template<class TKey, class TResult>
+      std::shared_future<TResult> launchAsync( AsyncJobs<TKey,TResult>& jobs, const TKey& key,
+                                               std::function<TResult()> fct )
+      {
+        if ( getCachingEnabled() )
+          return jobs.launch( key, std::move(fct) );
+        //Without caching, requests are never shared:
+        auto promise = std::make_shared<std::promise<TResult>>();
+        auto fut = promise->get_future().share();
+        runInBackground( [promise,fct]()
+        {
+          try {
+            promise->set_value( fct() );
+          } catch (...) {
+            promise->set_exception( std::current_exception() );
+          }
+        } );
+        return fut;
+      }
+
+      using InfoAsyncJobs = AsyncJobs<MatInfoCfg,shared_obj<const Info>>;
+      using ProcAsyncJobs = AsyncJobs<MatCfg,shared_obj<const ProcImpl::Process>>;
+      InfoAsyncJobs& infoAsyncJobs() { static InfoAsyncJobs jobs; return jobs; }
+      ProcAsyncJobs& scatterAsyncJobs() { static ProcAsyncJobs jobs; return jobs; }
+      ProcAsyncJobs& absorptionAsyncJobs() { static ProcAsyncJobs jobs; return jobs; }
+    }
+  }
+}
+
+std::shared_future<NC::shared_obj<const NC::Info>> NCF::createInfoAsync( const MatCfg& cfg )
+{
+  auto infocfg = cfg.createInfoCfg();
+  std::function<shared_obj<const Info>()> fct = [infocfg]()
+  {
+    return infoDB().createWithOrWithoutCache( { infocfg } );
+  };
+  return launchAsync( infoAsyncJobs(), infocfg, std::move(fct) );
+}
+
+std::shared_future<NC::shared_obj<const NC::ProcImpl::Process>> NCF::createScatterAsync( const MatCfg& cfg )
+{
+  auto cfg2 = reducedProcessCfg( cfg ).clone();
+  std::function<shared_obj<const ProcImpl::Process>()> fct = [cfg2]() { return createScatter( cfg2 ); };
+  return launchAsync( scatterAsyncJobs(), cfg2, std::move(fct) );
+}
+
+std::shared_future<NC::shared_obj<const NC::ProcImpl::Process>> NCF::createAbsorptionAsync( const MatCfg& cfg )
+{
+  auto cfg2 = reducedProcessCfg( cfg ).clone();
+  std::function<shared_obj<const ProcImpl::Process>()> fct = [cfg2]() { return createAbsorption( cfg2 ); };
+  return launchAsync( absorptionAsyncJobs(), cfg2, std::move(fct) );
+}
+
 NC::ProcImpl::ProcPtr NCF::ScatterFactory::globalCreateScatter( const MatCfg& cfg, bool allowself ) const
 {
   auto cfg2 = cfg.clone();
@@ -550,6 +979,8 @@ std::string NCF::guessDataType( const RawStrData& data,
 {
   //Figure out data type. We are able to recognise NCMAT content from the
   //data itself, and otherwise we look at the file extension.
+  if ( isNCMATBinaryData( data.begin(), data.end() ) )
+    return "ncmatbin"_s;
   if ( 0 == std::strncmp( data.begin(), "NCMAT", 5 ) )
     return "ncmat"_s;
   auto ext = getfileext(filename);
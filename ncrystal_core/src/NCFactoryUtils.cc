@@ -20,6 +20,8 @@
 
 #include "NCrystal/internal/NCFactoryUtils.hh"
 #include "NCrystal/internal/NCString.hh"
+#include <list>
+#include <unordered_map>
 namespace NC = NCrystal;
 
 namespace NCrystal {
@@ -27,6 +29,138 @@ namespace NCrystal {
     static std::atomic<bool> s_factoryVerbosity( ncgetenv_bool("DEBUG_FACTORY")
                                                  || ncgetenv_bool("DEBUGFACTORY")
                                                  || ncgetenv_bool("DEBUG_FACT") );
+
+    std::size_t budgetFromEnv()
+    {
+      double mb = ncgetenv_dbl("FACTORY_CACHE_MB",0.0);
+      if ( !(mb>=0.0) || mb > 1e9 )
+        NCRYSTAL_THROW2(BadInput,"Invalid value of environment variable NCRYSTAL_FACTORY_CACHE_MB"
+                        " (must be a non-negative number of megabytes): "<<mb);
+      return static_cast<std::size_t>( mb * 1048576.0 );
+    }
+
+    class MemBudgetLRU {
+    public:
+      struct Entry {
+        const void* owner;
+        std::shared_ptr<const void> obj;
+        std::size_t nbytes;
+      };
+    private:
+      using List = std::list<Entry>;
+      std::mutex m_mutex;
+      std::atomic<std::size_t> m_budget{ budgetFromEnv() };//written only while holding m_mutex
+      std::size_t m_nbytes = 0;
+      List m_lru;//least recently accessed first
+      std::unordered_map<const void*,List::iterator> m_index;
+
+      //Must hold lock. Moves evicted entries to the output list, so they can
+      //be destructed after releasing the lock:
+      void evictExcess( List& evicted )
+      {
+        while ( m_nbytes > m_budget && !m_lru.empty() ) {
+          auto it = m_lru.begin();
+          m_nbytes -= it->nbytes;
+          m_index.erase( it->obj.get() );
+          evicted.splice( evicted.end(), m_lru, it );
+        }
+      }
+      template<class TPred>
+      void releaseIf( List& released, TPred pred )
+      {
+        auto it = m_lru.begin();
+        while ( it != m_lru.end() ) {
+          auto itNext = std::next(it);
+          if ( pred(*it) ) {
+            m_nbytes -= it->nbytes;
+            m_index.erase( it->obj.get() );
+            released.splice( released.end(), m_lru, it );
+          }
+          it = itNext;
+        }
+      }
+    public:
+      std::size_t budget() const { return m_budget; }
+
+      void setBudget( std::size_t b )
+      {
+        List evicted;
+        NCRYSTAL_LOCK_GUARD(m_mutex);
+        m_budget = b;
+        if ( b == 0 )
+          releaseIf( evicted, [](const Entry&){ return true; } );
+        else
+          evictExcess( evicted );
+      }
+
+      void touch( const void* owner, std::shared_ptr<const void> obj, std::size_t nbytes )
+      {
+        nc_assert( obj != nullptr && nbytes > 0 );
+        List evicted;
+        NCRYSTAL_LOCK_GUARD(m_mutex);
+        if ( m_budget == 0 )
+          return;//budget was disabled concurrently
+        auto itIdx = m_index.find( obj.get() );
+        if ( itIdx != m_index.end() ) {
+          //Already there, move to back:
+          m_lru.splice( m_lru.end(), m_lru, itIdx->second );
+          return;
+        }
+        m_lru.push_back( Entry{ owner, std::move(obj), nbytes } );
+        m_index[m_lru.back().obj.get()] = std::prev(m_lru.end());
+        m_nbytes += nbytes;
+        evictExcess( evicted );
+      }
+
+      template<class TPred>
+      void releaseIfToVector( std::vector<std::shared_ptr<const void>>& out, TPred pred )
+      {
+        List released;
+        {
+          NCRYSTAL_LOCK_GUARD(m_mutex);
+          releaseIf( released, pred );
+        }
+        for ( auto& e : released )
+          out.push_back( std::move(e.obj) );
+      }
+
+      detail::MemBudgetOwnerStats ownerStats( const void* owner )
+      {
+        NCRYSTAL_LOCK_GUARD(m_mutex);
+        detail::MemBudgetOwnerStats res{0,0};
+        for ( auto& e : m_lru ) {
+          if ( e.owner == owner ) {
+            ++res.nobjects;
+            res.nbytes += e.nbytes;
+          }
+        }
+        return res;
+      }
+
+      FactoryCacheMemoryStats stats()
+      {
+        NCRYSTAL_LOCK_GUARD(m_mutex);
+        return FactoryCacheMemoryStats{ m_budget.load(), static_cast<std::size_t>(m_lru.size()), m_nbytes };
+      }
+    };
+
+    struct StatsFctRegistry {
+      std::mutex mtx;
+      std::vector<std::function<FactoryCacheStats()>> fcts;
+    };
+    StatsFctRegistry& statsFctRegistry()
+    {
+      //Never deleted (like memBudgetLRU below):
+      static StatsFctRegistry * s_reg = new StatsFctRegistry;
+      return *s_reg;
+    }
+
+    MemBudgetLRU& memBudgetLRU()
+    {
+      //Never deleted, since factories might access it during static destruction:
+      static MemBudgetLRU * s_lru = new MemBudgetLRU;
+      return *s_lru;
+    }
   }
 }
 
@@ -39,3 +173,63 @@ bool NC::getFactoryVerbosity()
 {
   return s_factoryVerbosity;
 }
+
+void NC::setFactoryCacheMemoryBudget( std::size_t nbytes )
+{
+  memBudgetLRU().setBudget( nbytes );
+}
+
+std::size_t NC::getFactoryCacheMemoryBudget()
+{
+  return memBudgetLRU().budget();
+}
+
+NC::FactoryCacheMemoryStats NC::getFactoryCacheMemoryStats()
+{
+  return memBudgetLRU().stats();
+}
+
+void NC::detail::memBudgetTouch( const void* owner, std::shared_ptr<const void> obj, std::size_t nbytes )
+{
+  memBudgetLRU().touch( owner, std::move(obj), nbytes );
+}
+
+void NC::detail::memBudgetReleaseAll( const void* owner, std::vector<std::shared_ptr<const void>>& released )
+{
+  memBudgetLRU().releaseIfToVector( released, [owner](const MemBudgetLRU::Entry& e){ return e.owner == owner; } );
+}
+
+void NC::detail::memBudgetRelease( const std::set<const void*>& objs, std::vector<std::shared_ptr<const void>>& released )
+{
+  memBudgetLRU().releaseIfToVector( released, [&objs](const MemBudgetLRU::Entry& e){ return objs.count( e.obj.get() ) > 0; } );
+}
+
+NC::detail::MemBudgetOwnerStats NC::detail::memBudgetOwnerStats( const void* owner )
+{
+  return memBudgetLRU().ownerStats( owner );
+}
+
+void NC::registerFactoryCacheStatsFunction( std::function<FactoryCacheStats()> f )
+{
+  nc_assert_always(!!f);
+  auto& reg = statsFctRegistry();
+  NCRYSTAL_LOCK_GUARD(reg.mtx);
+  reg.fcts.push_back( std::move(f) );
+}
+
+std::vector<NC::FactoryCacheStats> NC::getAllFactoryCacheStats()
+{
+  //Invoke functions without holding the registry lock (they will lock the
+  //individual caches):
+  decltype(StatsFctRegistry::fcts) fcts;
+  {
+    auto& reg = statsFctRegistry();
+    NCRYSTAL_LOCK_GUARD(reg.mtx);
+    fcts = reg.fcts;
+  }
+  std::vector<FactoryCacheStats> res;
+  res.reserve( fcts.size() );
+  for ( auto& f : fcts )
+    res.push_back( f() );
+  return res;
+}
@@ -41,6 +41,22 @@ namespace NCrystal {
     }
   };
 
+  class NCMATBinaryFactory final : public FactImpl::InfoFactory {
+  public:
+    //Binary NCMAT data, decoded transparently by the NCMAT loader:
+    const char * name() const noexcept final { return "stdncmatbin"; }
+
+    Priority query( const MatInfoCfg& cfg ) const final
+    {
+      return cfg.getDataType()=="ncmatbin" ? Priority{100} : Priority{Priority::Unable};
+    }
+
+    shared_obj<const Info> produce( const MatInfoCfg& cfg ) const final
+    {
+      return NC::makeSO<const Info>( loadNCMAT(cfg) );
+    }
+  };
+
 }
 
 //Finally, a function which can be used to enable the above factory. Note that
@@ -51,5 +67,8 @@ extern "C" void ncrystal_register_ncmat_factory()
 {
   NC::FactImpl::registerFactory( std::make_unique<NC::NCMATFactory>(),
                                  NC::FactImpl::RegPolicy::IGNORE_IF_EXISTS );
+  NC::FactImpl::registerFactory( std::make_unique<NC::NCMATBinaryFactory>(),
+                                 NC::FactImpl::RegPolicy::IGNORE_IF_EXISTS );
   NC::DataSources::addRecognisedFileExtensions("ncmat");
+  NC::DataSources::addRecognisedFileExtensions("ncmatbin");
 }
@@ -53,85 +53,136 @@ void NC::FastConvolve::initWTable( unsigned n_size )
   }
 }
 
-void NC::FastConvolve::fftconv( const NC::VectD& a1, const NC::VectD& a2, NC::VectD& y, double dt )
+const NC::FastConvolve::Plan& NC::FastConvolve::getPlan( unsigned minimum_output_size )
 {
-  const int minimum_out_size = a1.size() + a2.size() - 1;
+  double output_log_size_fp = std::ceil(std::log2(minimum_output_size));
+  nc_assert_always(output_log_size_fp<32);
+  const unsigned output_log_size = static_cast<unsigned>(output_log_size_fp);
+  if ( m_plans.size() <= output_log_size )
+    m_plans.resize( output_log_size + 1 );
+  Plan& plan = m_plans[output_log_size];
+  if ( plan.size )
+    return plan;//already prepared
 
-  std::vector<std::complex<double> > b1(a1.begin(),a1.end());
-  fftd(b1,FT_forward,minimum_out_size);
-  std::vector<std::complex<double> > b2(a2.begin(),a2.end());
-  fftd(b2,FT_forward,minimum_out_size);
+  const unsigned output_size = ( 1u << output_log_size );//this is now minimum_output_size rounded up to next power of 2
+  plan.size = output_size;
+  plan.log_size = output_log_size;
 
+  //Precompute the swaps needed for the bit-reversal permutation:
+  for ( unsigned j = 1; j + 1 < output_size; ++j ) {
+    unsigned i = 0;
+    for ( unsigned k = 1, tmp = j; k < output_size; i = (i<<1)|(tmp&1), k <<= 1, tmp >>= 1 )
+      {
+      }
+    if ( j < i )
+      plan.bitrev_swaps.emplace_back( j, i );
+  }
 
-  nc_assert(b1.size()==b2.size());
-  std::vector<std::complex<double> >::iterator itb1(b1.begin()), itb1E(b1.end()), itb2(b2.begin());
-  while (itb1!=itb1E)
-    *itb1++ *= *itb2++;
+  //The twiddle table is shared by all plans (smaller transforms simply use a
+  //stride). Since calcPhase reduces k/2^n fractions before evaluation, the
+  //values do not depend on the table size:
+  if ( m_w.size() < output_size )
+    initWTable( output_size );
+  return plan;
+}
 
-  fftd(b1,FT_inverse,minimum_out_size);
+void NC::FastConvolve::fftconv( const NC::VectD& a1, const NC::VectD& a2, NC::VectD& y, double dt )
+{
+  nc_assert_always( !a1.empty() && !a2.empty() );
+  const unsigned minimum_out_size = a1.size() + a2.size() - 1;
+  const Plan& plan = getPlan( minimum_out_size );
+  const std::size_t n = plan.size;
+
+  //Both inputs are real, so instead of transforming each (and wasting half of
+  //the work on zero imaginary parts), we transform z = a1 + i*a2 with a
+  //single complex FFT. The transforms of a1 and a2 are then given by
+  //A1[k]=(Z[k]+conj(Z[n-k]))/2 and A2[k]=(Z[k]-conj(Z[n-k]))/(2i), so their
+  //product is (Z[k]^2-conj(Z[n-k])^2)/(4i). Self-convolutions (which happen
+  //for all even phonon orders) need just the transform of a1, squared:
+  auto& b = m_work;
+  b.assign( n, std::complex<double>() );
+  const bool selfConvolution = ( &a1 == &a2 || a1 == a2 );
+  if ( selfConvolution ) {
+    for ( std::size_t i = 0; i < a1.size(); ++i )
+      b[i].real( a1[i] );
+    fftd( b, plan, FT_forward );
+    for ( auto& e : b )
+      e *= e;
+  } else {
+    for ( std::size_t i = 0; i < a1.size(); ++i )
+      b[i].real( a1[i] );
+    for ( std::size_t i = 0; i < a2.size(); ++i )
+      b[i].imag( a2[i] );
+    fftd( b, plan, FT_forward );
+    auto prodAt = []( const std::complex<double>& zk, const std::complex<double>& zmk )
+    {
+      //(zk^2-conj(zmk)^2)/(4i):
+      const double re = ( zk.real()*zk.real() - zk.imag()*zk.imag() )
+        - ( zmk.real()*zmk.real() - zmk.imag()*zmk.imag() );
+      const double im = 2.0 * ( zk.real()*zk.imag() + zmk.real()*zmk.imag() );
+      return std::complex<double>( 0.25 * im, -0.25 * re );
+    };
+    //Process k and n-k together, so the update can be done in-place:
+    b[0] = prodAt( b[0], b[0] );
+    if ( n > 1 )
+      b[n/2] = prodAt( b[n/2], b[n/2] );
+    for ( std::size_t k = 1; k < n/2; ++k ) {
+      const std::complex<double> zk = b[k];
+      const std::complex<double> zmk = b[n-k];
+      b[k] = prodAt( zk, zmk );
+      b[n-k] = prodAt( zmk, zk );
+    }
+  }
+
+  fftd( b, plan, FT_inverse );
 
   y.resize(minimum_out_size);
-  const double k = dt/b1.size();
-  nc_assert(b1.size()==b2.size());
-  nc_assert(y.size()<=b1.size());
+  const double k = dt/b.size();
+  nc_assert(y.size()<=b.size());
   VectD::iterator ity(y.begin()), ityE(y.end());
-  itb1 = b1.begin();
-  for(;ity!=ityE;++ity,++itb1) {
+  auto itb = b.begin();
+  for(;ity!=ityE;++ity,++itb) {
 #ifdef NCRYSTAL_FASTCONVOLVE_EXTRASAFEMATH
     //use std::abs which calls std::hypot behind the scenes (expensive but can avoid overflows)
-    *ity = k * std::abs(*itb1);
+    *ity = k * std::abs(*itb);
 #else
     //naive and simple, avoids std::hypot
-    double a(itb1->real());
-    double b(itb1->imag());
-    *ity = std::sqrt(a*a+b*b)*k;
+    double a(itb->real());
+    double bb(itb->imag());
+    *ity = std::sqrt(a*a+bb*bb)*k;
 #endif
   }
 }
 
-void NC::FastConvolve::fftd( std::vector<std::complex< double> > &data, FastConvolve::caltype ct,
-                             unsigned minimum_output_size )
+void NC::FastConvolve::fftd( std::vector<std::complex< double> > &data, const Plan& plan,
+                             FastConvolve::caltype ct )
 {
-  double output_log_size_fp = std::ceil(std::log2(minimum_output_size));
-  nc_assert_always(output_log_size_fp<32);
-  const int output_log_size = output_log_size_fp;
-  const int output_size = ( 1 << output_log_size );//this is now minimum_output_size rounded up to next power of 2
+  const unsigned output_size = plan.size;
+  const unsigned output_log_size = plan.log_size;
+  nc_assert_always( data.size() == (std::size_t)output_size );
+  nc_assert_always( m_w.size() >= (std::size_t)output_size );
 
-  const unsigned wTableSizeNeeded = std::max<unsigned>(output_size,data.size());
-  if ( m_w.size() < wTableSizeNeeded )
-    initWTable( wTableSizeNeeded );
-
-  nc_assert_always( data.size() <= (std::size_t)output_size );
-  if( data.size() != (size_t)output_size )
-    data.resize(output_size,std::complex<double>());
-
-  for(int j=1;j<output_size-1;++j)
-    {
-      int i=0;
-      for(int k=1,tmp=j; k<output_size; i=(i<<1)|(tmp&1),k<<=1,tmp>>=1)
-        {
-        }
-      if(j<i)
-        swap(data[i],data[j]);
-    }
+  for ( const auto& sw : plan.bitrev_swaps )
+    std::swap( data[sw.first], data[sw.second] );
 
-  const int jump = m_w.size()/output_size;
+  const unsigned jump = m_w.size()/output_size;
 #ifndef NCRYSTAL_FASTCONVOLVE_EXTRASAFEMATH
   const double convfact = (ct==FT_inverse?-1.0:1.0);
 #endif
 
-  for(int i=0;i<output_log_size;++i){
-    int z=0;
-    const int i1 = (1<<i);
-    const int i1m1 = i1-1;
-    const int i2 = 1<<(output_log_size-i-1);
-    for(int j=0;j<output_size;++j){
-      if((j/i1)%2){
-        std::complex<double>& data_j = data[j];
-        std::complex<double>& data_sympos = data[j-i1];
+  for ( unsigned i = 0; i < output_log_size; ++i ) {
+    const unsigned i1 = (1u<<i);
+    const unsigned wstep = ( 1u<<(output_log_size-i-1) ) * jump;
+    for ( unsigned blockstart = 0; blockstart < output_size; blockstart += 2*i1 ) {
+      std::complex<double> * data_sympos_ptr = &data[blockstart];
+      std::complex<double> * data_j_ptr = data_sympos_ptr + i1;
+      for ( unsigned m = 0; m < i1; ++m ) {
+        std::complex<double>& data_j = data_j_ptr[m];
+        std::complex<double>& data_sympos = data_sympos_ptr[m];
+        const std::complex<double>& w_zjump = m_w[m*wstep];
 #ifdef NCRYSTAL_FASTCONVOLVE_EXTRASAFEMATH
         //std::complex<> multiplication is slow since it takes care of proper inf/nan/overflow
-        data_j *= (ct==inverse?std::conj(m_w[z*jump]):m_w[z*jump]);
+        data_j *= (ct==FT_inverse?std::conj(w_zjump):w_zjump);
         //and the -=,+= operators seems to carry significant overhead for some reason:
         std::complex<double> temp = data_sympos;
         data_sympos += data_j;
@@ -139,7 +190,6 @@ void NC::FastConvolve::fftd( std::vector<std::complex< double> > &data, FastConv
         data_j = temp;
 #else
         //naive and simple is faster:
-        const std::complex<double>& w_zjump = m_w[z*jump];
         const double a(data_j.real()), b(data_j.imag()), c(w_zjump.real()), d(convfact * w_zjump.imag());
         const double jr(a*c-b*d);
         const double ji(a*d+b*c);
@@ -150,11 +200,6 @@ void NC::FastConvolve::fftd( std::vector<std::complex< double> > &data, FastConv
         data_sympos.real( sr + jr );
         data_sympos.imag( si + ji );
 #endif
-        z += i2;
-      } else {
-        z = 0;
-        //will be the same result for the next i1-1 loops, so skip ahead:
-        j += i1m1;
       }
     }
   }
@@ -148,6 +148,20 @@ std::string NC::ncgetcwd() {
     string::size_type position = string( buff ).find_last_of( "\\/" );
     return string( buff ).substr( 0, position);
 }
+//No memory mapping support on windows (for now):
+std::shared_ptr<const NC::MappedFile> NC::MappedFile::mapFile( const std::string& )
+{
+  return nullptr;
+}
+std::shared_ptr<const NC::MappedFile> NC::MappedFile::mapTextFile( const std::string& )
+{
+  return nullptr;
+}
+NC::MappedFile::~MappedFile() = default;
+NC::Optional<NC::FileStamp> NC::tryGetFileStamp( const std::string& )
+{
+  return NullOpt;
+}
 #else
 //POSIX globbing:
 #include <glob.h>
@@ -194,4 +208,52 @@ std::string NC::ncgetcwd() {
   }
   NCRYSTAL_THROW(CalcError,"Could not determine current working directory");
 }
+//POSIX memory mapping:
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+std::shared_ptr<const NC::MappedFile> NC::MappedFile::mapFile( const std::string& path )
+{
+  int fd = ::open( path.c_str(), O_RDONLY );
+  if ( fd < 0 )
+    return nullptr;
+  struct stat st;
+  void * addr = MAP_FAILED;
+  if ( ::fstat( fd, &st ) == 0 && st.st_size > 0 )
+    addr = ::mmap( nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0 );
+  ::close( fd );//mapping stays valid after closing the descriptor
+  if ( addr == MAP_FAILED )
+    return nullptr;
+  return std::shared_ptr<const MappedFile>( new MappedFile( static_cast<const char*>(addr),
+                                                          static_cast<std::size_t>(st.st_size) ) );
+}
+std::shared_ptr<const NC::MappedFile> NC::MappedFile::mapTextFile( const std::string& path )
+{
+  static const long pagesize = ::sysconf( _SC_PAGESIZE );
+  auto mf = mapFile( path );
+  if ( !mf || pagesize <= 0 || ( mf->data().size() % pagesize ) == 0 )
+    return nullptr;
+  nc_assert( *mf->data().end() == '\0' );
+  return mf;
+}
+NC::MappedFile::~MappedFile()
+{
+  if ( !m_data.empty() )
+    ::munmap( const_cast<char*>(m_data.data()), static_cast<std::size_t>(m_data.size()) );
+}
+NC::Optional<NC::FileStamp> NC::tryGetFileStamp( const std::string& path )
+{
+  struct stat st;
+  if ( ::stat( path.c_str(), &st ) != 0 )
+    return NullOpt;
+  FileStamp fs;
+  fs.inode = static_cast<uint64_t>( st.st_ino );
+#if defined(__APPLE__)
+  fs.mtime_ns = static_cast<int64_t>( st.st_mtimespec.tv_sec ) * 1000000000 + st.st_mtimespec.tv_nsec;
+#else
+  fs.mtime_ns = static_cast<int64_t>( st.st_mtim.tv_sec ) * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+  fs.size = static_cast<uint64_t>( st.st_size );
+  return fs;
+}
 #endif
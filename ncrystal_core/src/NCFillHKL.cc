@@ -23,8 +23,18 @@
 #include "NCrystal/internal/NCRotMatrix.hh"
 #include "NCrystal/internal/NCLatticeUtils.hh"
 #include "NCrystal/internal/NCString.hh"
+#include "NCrystal/internal/NCThreadUtils.hh"
+#include "NCrystal/internal/NCEqRefl.hh"
+#include "NCrystal/internal/NCFactoryUtils.hh"
+#include "NCrystal/internal/NCTrace.hh"
+#include "NCrystal/internal/NCSABDiskCache.hh"
+#include "NCrystal/NCVersion.hh"
 #include "NCrystal/NCDefs.hh"
 #include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <cstring>
 
 namespace NC = NCrystal;
 
@@ -55,64 +65,10 @@ namespace NCrystal {
 #endif
 
 #ifdef NCRYSTAL_NCMAT_USE_MEMPOOL
-#include <stdexcept>
-#include <type_traits>
 #include <scoped_allocator>
 namespace NCrystal {
-  //We use a simple expanding-only memory pool for the temporary multimap used
-  //to detect hkl families. This results in better cache locality and should
-  //hopefully reduce memory fragmentation. TODO: Consider moving this pool
-  //infrastructure to common utilities.
-  class MemPool {
-  public:
-    explicit MemPool(std::size_t s) : m_size(s), m_offset(s+1) { m_chunks.reserve(64); }
-    MemPool(MemPool const &) = delete;
-    MemPool & operator=(MemPool const &) = delete;
-    ~MemPool() { for (auto& e: m_chunks) ::operator delete(e); }
-    void deallocate(void *, std::size_t) {}//ignore
-    void * allocate(std::size_t n, std::size_t alignment)
-    {
-      nc_assert(n&&n<m_size);
-      m_offset = ((m_offset + alignment - 1) / alignment ) * alignment;//move up to alignment
-      if (m_offset + n > m_size) {//must grow
-        m_chunks.push_back(m_data = static_cast<unsigned char *>(::operator new(m_size)));
-        m_offset = 0;
-      }
-      void * result = m_data + m_offset;
-      m_offset += n;
-      return result;
-    }
-  private:
-    unsigned char * m_data;
-    std::size_t const m_size;
-    std::size_t m_offset;
-    std::vector<unsigned char*> m_chunks;
-  };
-
-  template <typename T>
-  struct MemPoolAllocator {
-    //Boiler-plate needed to make stl container use our MemPool:
-    template <typename U> friend struct MemPoolAllocator;
-    using value_type = T;
-    using pointer = T *;
-    using propagate_on_container_copy_assignment = std::true_type;
-    using propagate_on_container_move_assignment = std::true_type;
-    using propagate_on_container_swap = std::true_type;
-    explicit MemPoolAllocator(MemPool * a) : m_pool(a) {}
-    template <typename U> MemPoolAllocator(MemPoolAllocator<U> const & rhs) : m_pool(rhs.m_pool) {}
-    pointer allocate(std::size_t n)
-    {
-      return static_cast<pointer>(m_pool->allocate(n * sizeof(T), alignof(T)));
-    }
-    void deallocate(pointer /*p*/, std::size_t /*n*/)
-    {
-      //if MemPool deallocate was not no-op, we should call it here: m_pool->deallocate(p, n * sizeof(T));
-    }
-    template <typename U> bool operator==(MemPoolAllocator<U> const & rhs) const { return m_pool == rhs.m_pool; }
-    template <typename U> bool operator!=(MemPoolAllocator<U> const & rhs) const { return m_pool != rhs.m_pool; }
-  private:
-    MemPool * m_pool;
-  };
+  //We use a MemPool (see NCMem.hh) for the temporary multimap used to detect
+  //hkl families:
   typedef std::multimap<FamKeyType, size_t, std::less<const FamKeyType>,
                         std::scoped_allocator_adaptor<MemPoolAllocator<std::pair<const FamKeyType, size_t>>>> FamMap;
 }
@@ -142,11 +98,307 @@ namespace NCrystal {
       for( ; it!=itE; ++it )
         *itOut++ = kk2*(*it);
     }
+
+    bool compactifyHKLList( const HKLList& hkllist,
+                            const std::vector<std::vector<short>>& eqv_hkl_short,
+                            int spacegroup, HKLList& out )
+    {
+      //Produce HKL list with just a representative (h,k,l) point, fsquared,
+      //dspacing and multiplicity for each family. Families which do not consist
+      //of exactly one group of symmetry-equivalent reflections (due to
+      //accidental (d,F^2) degeneracies) are split, so that normals can later
+      //be reconstructed from the space group (see NCPlaneProvider.cc). Returns
+      //false if the families in the input are not consistent with the space
+      //group.
+      nc_assert_always( hkllist.size() == eqv_hkl_short.size() );
+      EqRefl eqrefl( spacegroup );
+      auto canonical = []( int h, int k, int l )
+      {
+        //Sign convention is irrelevant for demi-normals:
+        EqRefl::HKL a(h,k,l), am(-h,-k,-l);
+        return a < am ? am : a;
+      };
+      out.clear();
+      out.reserve( hkllist.size() );
+      std::map<EqRefl::HKL,std::size_t> member2idx;
+      std::vector<bool> done;
+      for ( std::size_t ifam = 0; ifam < hkllist.size(); ++ifam ) {
+        const HKLInfo& fam = hkllist[ifam];
+        const std::vector<short>& eh = eqv_hkl_short[ifam];
+        const std::size_t n = eh.size() / 3;
+        nc_assert_always( n*3 == eh.size() && n == fam.demi_normals.size() );
+        member2idx.clear();
+        for ( std::size_t j = 0; j < n; ++j )
+          member2idx[canonical(eh[3*j],eh[3*j+1],eh[3*j+2])] = j;
+        done.assign( n, false );
+        for ( std::size_t j = 0; j < n; ++j ) {
+          if ( done[j] )
+            continue;
+          const int h(eh[3*j]), k(eh[3*j+1]), l(eh[3*j+2]);
+          std::size_t norbit = 0;
+          for ( const auto& e : eqrefl.getEquivalentReflections(h,k,l) ) {
+            auto itM = member2idx.find( canonical(e.h,e.k,e.l) );
+            if ( itM == member2idx.end() || done[itM->second] )
+              return false;
+            done[itM->second] = true;
+            ++norbit;
+          }
+          HKLInfo hi;
+          hi.h = h;
+          hi.k = k;
+          hi.l = l;
+          hi.fsquared = fam.fsquared;
+          hi.dspacing = fam.dspacing;
+          hi.multiplicity = static_cast<unsigned>( norbit * 2 );
+          out.emplace_back(std::move(hi));
+        }
+      }
+      return true;
+    }
+
+    //Cache of temperature independent partial structure factors, allowing
+    //invocations which only differ in dcutoff (e.g. in parameter sweeps) or in
+    //the mean-squared-displacements (e.g. the same crystal at different
+    //temperatures) to skip most or all of the expensive phase calculations.
+    //For each plane inside the searched (h,k,l) range with d-spacing in
+    //[dcutoff,dcutoffup], in the order of the serial loop over h,k,l, an entry
+    //holds the sums of cos(2pi*hkl.r) and sin(2pi*hkl.r) over the positions r
+    //of each atom species, from which F^2 can be calculated for any set of
+    //Debye-Waller factors. Planes for which F^2 would be below fsquarecut even
+    //with unit Debye-Waller factors are left out. Since the searched range only
+    //grows when dcutoff is lowered, an entry contains all planes needed for
+    //any higher dcutoff (in the same order as the serial loop would visit
+    //them), and can be extended with the planes needed for a lower dcutoff.
+    struct PlanePartials {
+      double dcutoff = kInfinity;
+      int max_h = -1, max_k = -1, max_l = -1;//searched (h,k,l) range
+      std::size_t nspecies = 0;
+      std::vector<int> hkl;//3 entries per plane
+      VectD ksq;//squared length of wave vector
+      std::vector<Vector> demi_normals;
+      VectD partials;//2*nspecies entries per plane (cos and sin sums)
+      std::size_t size() const { return ksq.size(); }
+      std::size_t nbytes() const
+      {
+        return hkl.size()*sizeof(int) + ksq.size()*sizeof(double)
+          + demi_normals.size()*sizeof(Vector) + partials.size()*sizeof(double);
+      }
+      bool contains( int h, int k, int l, double dspacingsq ) const
+      {
+        return ( h <= max_h && std::abs(k) <= max_k && std::abs(l) <= max_l
+                 && dspacingsq >= dcutoff * dcutoff );
+      }
+      void append( const PlanePartials& o, std::size_t i )
+      {
+        auto itp = std::next( o.partials.begin(), 2*nspecies*i );
+        hkl.insert( hkl.end(), std::next( o.hkl.begin(), 3*i ), std::next( o.hkl.begin(), 3*(i+1) ) );
+        ksq.push_back( o.ksq[i] );
+        demi_normals.push_back( o.demi_normals[i] );
+        partials.insert( partials.end(), itp, std::next( itp, 2*nspecies ) );
+      }
+      void append( const PlanePartials& o )
+      {
+        hkl.insert( hkl.end(), o.hkl.begin(), o.hkl.end() );
+        ksq.insert( ksq.end(), o.ksq.begin(), o.ksq.end() );
+        demi_normals.insert( demi_normals.end(), o.demi_normals.begin(), o.demi_normals.end() );
+        partials.insert( partials.end(), o.partials.begin(), o.partials.end() );
+      }
+      void clear()
+      {
+        hkl.clear();
+        ksq.clear();
+        demi_normals.clear();
+        partials.clear();
+      }
+    };
+
+    class PlanePartialsCache {
+    public:
+      static constexpr std::size_t nmax_entries = 4;
+      using Entry = std::pair<VectD,std::shared_ptr<const PlanePartials>>;
+
+      //Find entry (with any dcutoff):
+      std::shared_ptr<const PlanePartials> lookup( const VectD& key )
+      {
+        NCRYSTAL_LOCK_GUARD(m_mtx);
+        auto it = std::find_if( m_entries.begin(), m_entries.end(),
+                                [&key](const Entry& e) { return e.first == key; } );
+        if ( it == m_entries.end() ) {
+          ++m_nmisses;
+          return nullptr;
+        }
+        ++m_nhits;
+        auto res = it->second;
+        std::rotate( it, std::next(it), m_entries.end() );
+        return res;
+      }
+
+      void store( VectD&& key, std::shared_ptr<const PlanePartials> pp )
+      {
+        NCRYSTAL_LOCK_GUARD(m_mtx);
+        auto it = std::find_if( m_entries.begin(), m_entries.end(),
+                                [&key](const Entry& e) { return e.first == key; } );
+        if ( it != m_entries.end() ) {
+          if ( it->second->dcutoff <= pp->dcutoff )
+            return;//existing entry is at least as useful
+          m_entries.erase(it);
+        }
+        if ( m_entries.size() == nmax_entries )
+          m_entries.erase( m_entries.begin() );
+        m_entries.emplace_back( std::move(key), std::move(pp) );
+      }
+
+      void clear()
+      {
+        NCRYSTAL_LOCK_GUARD(m_mtx);
+        m_entries.clear();
+      }
+
+      FactoryCacheStats stats()
+      {
+        NCRYSTAL_LOCK_GUARD(m_mtx);
+        FactoryCacheStats s;
+        s.name = "FillHKLPlaneCache";
+        s.nstrongrefs = s.nentries = m_entries.size();
+        for ( const auto& e : m_entries )
+          s.nbytes += e.second->nbytes();
+        s.nhits = m_nhits;
+        s.nmisses = m_nmisses;
+        return s;
+      }
+
+    private:
+      std::mutex m_mtx;
+      std::vector<Entry> m_entries;
+      uint64_t m_nhits = 0, m_nmisses = 0;
+    };
+
+    PlanePartialsCache& planePartialsCache()
+    {
+      static PlanePartialsCache cache;
+      static bool registered = []()
+      {
+        registerCacheCleanupFunction( [](){ cache.clear(); } );
+        registerFactoryCacheStatsFunction( [](){ return cache.stats(); } );
+        return true;
+      }();
+      (void)registered;
+      return cache;
+    }
+
+    //Encoding of complete HKL lists for inclusion in snapshots (native binary
+    //layout, as for other snapshot entries):
+    constexpr const char * hkl_snapshot_prefix = "ncrystal_hkl_";
+
+    std::string hklSnapshotKey( const VectD& inputs )
+    {
+      uint64_t h = 14695981039346656037ull;//FNV-1a
+      for ( auto e : inputs ) {
+        uint64_t w;
+        std::memcpy( &w, &e, sizeof(w) );
+        for ( unsigned i = 0; i < 8; ++i ) {
+          h ^= ( w >> (8*i) ) & 0xff;
+          h *= 1099511628211ull;
+        }
+      }
+      std::ostringstream ss;
+      ss << hkl_snapshot_prefix << std::hex << std::setw(16) << std::setfill('0') << h;
+      return ss.str();
+    }
+
+    template<class T>
+    void hklSnapshotPut( std::string& buf, const T& t )
+    {
+      buf.append( reinterpret_cast<const char*>(&t), sizeof(T) );
+    }
+
+    std::string encodeHKLSnapshotEntry( const VectD& inputs, const HKLList& hkllist )
+    {
+      std::string buf;
+      hklSnapshotPut( buf, static_cast<uint64_t>(inputs.size()) );
+      for ( auto e : inputs )
+        hklSnapshotPut( buf, e );
+      hklSnapshotPut( buf, static_cast<uint64_t>(hkllist.size()) );
+      for ( const auto& e : hkllist ) {
+        hklSnapshotPut( buf, e.dspacing );
+        hklSnapshotPut( buf, e.fsquared );
+        hklSnapshotPut( buf, static_cast<int32_t>(e.h) );
+        hklSnapshotPut( buf, static_cast<int32_t>(e.k) );
+        hklSnapshotPut( buf, static_cast<int32_t>(e.l) );
+        hklSnapshotPut( buf, static_cast<uint32_t>(e.multiplicity) );
+        hklSnapshotPut( buf, static_cast<uint64_t>(e.demi_normals.size()) );
+        hklSnapshotPut( buf, static_cast<uint32_t>( e.eqv_hkl ? 1 : 0 ) );
+        for ( const auto& n : e.demi_normals )
+          for ( unsigned i = 0; i < 3; ++i )
+            hklSnapshotPut( buf, n[i] );
+        if ( e.eqv_hkl )
+          for ( std::size_t i = 0; i < 3*e.demi_normals.size(); ++i )
+            hklSnapshotPut( buf, e.eqv_hkl[i] );
+      }
+      return buf;
+    }
+
+    bool decodeHKLSnapshotEntry( const std::string& buf, const VectD& inputs, HKLList& out )
+    {
+      std::size_t pos = 0;
+      auto get = [&buf,&pos]( void * dest, std::size_t n )
+      {
+        if ( n > buf.size() - pos )
+          return false;
+        std::memcpy( dest, buf.data() + pos, n );
+        pos += n;
+        return true;
+      };
+      uint64_t n;
+      if ( !get( &n, sizeof(n) ) || n != inputs.size() )
+        return false;
+      for ( auto e : inputs ) {
+        double v;
+        if ( !get( &v, sizeof(v) ) || std::memcmp( &v, &e, sizeof(v) ) != 0 )
+          return false;
+      }
+      if ( !get( &n, sizeof(n) ) || n > buf.size() )
+        return false;
+      HKLList res;
+      res.reserve( static_cast<std::size_t>(n) );
+      for ( uint64_t i = 0; i < n; ++i ) {
+        HKLInfo hi;
+        int32_t h, k, l;
+        uint32_t mult, has_eqv;
+        uint64_t nnormals;
+        if ( !get( &hi.dspacing, sizeof(double) ) || !get( &hi.fsquared, sizeof(double) )
+             || !get( &h, sizeof(h) ) || !get( &k, sizeof(k) ) || !get( &l, sizeof(l) )
+             || !get( &mult, sizeof(mult) ) || !get( &nnormals, sizeof(nnormals) )
+             || !get( &has_eqv, sizeof(has_eqv) ) || nnormals > buf.size() )
+          return false;
+        hi.h = h;
+        hi.k = k;
+        hi.l = l;
+        hi.multiplicity = mult;
+        hi.demi_normals.resize( static_cast<std::size_t>(nnormals) );
+        for ( auto& nv : hi.demi_normals )
+          for ( unsigned j = 0; j < 3; ++j )
+            if ( !get( &nv[j], sizeof(double) ) )
+              return false;
+        if ( has_eqv ) {
+          hi.eqv_hkl = decltype(hi.eqv_hkl)( new short[ 3*hi.demi_normals.size() ]() );
+          if ( !get( &hi.eqv_hkl[0], 3*hi.demi_normals.size()*sizeof(short) ) )
+            return false;
+        }
+        res.emplace_back( std::move(hi) );
+      }
+      if ( pos != buf.size() )
+        return false;
+      out = std::move(res);
+      return true;
+    }
+
   }
 }
 
 void NC::fillHKL( NC::Info& info, FillHKLCfg cfg )
 {
+  Trace::Span span("fillHKL");
   const bool env_ignorefsqcut = std::getenv("NCRYSTAL_FILLHKL_IGNOREFSQCUT");
   if (env_ignorefsqcut)
     cfg.fsquarecut = 0.0;
@@ -187,36 +439,102 @@ void NC::fillHKL( NC::Info& info, FillHKLCfg cfg )
   nc_assert_always(info.hasStructureInfo());
   nc_assert_always(!info.hasHKLInfo());
   nc_assert_always(cfg.dcutoff>0.0&&cfg.dcutoff<cfg.dcutoffup);
+  if ( cfg.compact && cfg.expandhkl )
+    NCRYSTAL_THROW(BadInput,"Compact HKL lists can not be combined with expanded HKL info");
 
   const RotMatrix rec_lat = getReciprocalLatticeRot( info );
 
   const double min_ds_sq(cfg.dcutoff*cfg.dcutoff);
   const double max_ds_sq(cfg.dcutoffup*cfg.dcutoffup);
 
-  //Collect info for each atom in suitable format for use for calculations below:
-  SmallVector<SmallVector<Vector,16>,4> atomic_pos;//atomic coordinates
+  //Collect info for each atom in suitable format for use for calculations
+  //below. The atomic coordinates of all atoms are kept in flat arrays (species
+  //i occupying indices [atom_begin[i],atom_begin[i+1])), together with the
+  //phase factors exp(i*2pi*z) needed to step along the l-direction:
   SmallVectD csl;//coherent scattering length
   SmallVectD msd;//mean squared displacement
-  SmallVectD cache_factors;
+  std::vector<std::size_t> atom_begin;
+  VectD pos_x, pos_y, pos_z, step_c, step_s;
 
   AtomList::const_iterator it (info.atomInfoBegin()), itE(info.atomInfoEnd());
   for (;it!=itE;++it) {
     nc_assert( it->msd().has_value() );
     msd.push_back( it->msd().value() );
     csl.push_back( it->atomData().coherentScatLen() );
-    SmallVector<Vector,16> pos;
-    pos.reserve_hint( it->unitCellPositions().size() );
-    for ( const auto& p : it->unitCellPositions() )
-      pos.push_back( p.as<Vector>() );
-    atomic_pos.push_back( std::move(pos) );
+    atom_begin.push_back( pos_x.size() );
+    for ( const auto& p : it->unitCellPositions() ) {
+      const Vector v = p.as<Vector>();
+      pos_x.push_back( v.x() );
+      pos_y.push_back( v.y() );
+      pos_z.push_back( v.z() );
+      double cz, sz;
+      sincos( v.z() * k2Pi, cz, sz );
+      step_c.push_back( cz );
+      step_s.push_back( sz );
+    }
   }
+  atom_begin.push_back( pos_x.size() );
+  const std::size_t natoms = pos_x.size();
 
   int max_h, max_k, max_l;
   estimateHKLRange(cfg.dcutoff,rec_lat,max_h, max_k, max_l);
 
-  nc_assert_always(msd.size()==atomic_pos.size());
+  const StructureInfo& structinfo = info.getStructureInfo();
+  const int spacegroup = structinfo.spacegroup;
+  const bool compact = cfg.compact && spacegroup > 0;
+
+  //Complete results can be included in snapshots (see NCFactImpl.hh), keyed
+  //by all inputs (which are also stored in the entry to guard against hash
+  //collisions):
+  std::string snapshotkey;
+  VectD snapshotinputs;
+  if ( !do_select && SAB::snapshotsMightUse( hkl_snapshot_prefix ) ) {
+    snapshotinputs = { double(NCRYSTAL_VERSION), cfg.dcutoff, cfg.dcutoffup, cfg.fsquarecut,
+                       cfg.merge_tolerance, double(cfg.expandhkl), double(compact),
+                       double(no_forceunitdebyewallerfactor), structinfo.lattice_a,
+                       structinfo.lattice_b, structinfo.lattice_c, structinfo.alpha,
+                       structinfo.beta, structinfo.gamma, double(spacegroup) };
+    for ( std::size_t i = 0; i < csl.size(); ++i ) {
+      snapshotinputs.push_back( csl[i] );
+      snapshotinputs.push_back( msd[i] );
+      snapshotinputs.push_back( double( atom_begin[i+1] - atom_begin[i] ) );
+      for ( std::size_t j = atom_begin[i]; j < atom_begin[i+1]; ++j ) {
+        snapshotinputs.push_back( pos_x[j] );
+        snapshotinputs.push_back( pos_y[j] );
+        snapshotinputs.push_back( pos_z[j] );
+      }
+    }
+    snapshotkey = hklSnapshotKey( snapshotinputs );
+    auto entry = SAB::findSnapshotEntry( snapshotkey );
+    HKLList decoded;
+    if ( entry.has_value() && decodeHKLSnapshotEntry( entry.value(), snapshotinputs, decoded ) ) {
+      info.enableHKLInfo(cfg.dcutoff,cfg.dcutoffup);
+      info.setHKLList(std::move(decoded));
+      return;
+    }
+  }
+  auto setResult = [&info,&snapshotkey,&snapshotinputs]( HKLList&& result )
+  {
+    if ( !snapshotkey.empty() )
+      SAB::recordSnapshotEntry( snapshotkey, encodeHKLSnapshotEntry( snapshotinputs, result ) );
+    info.setHKLList(std::move(result));
+  };
+
+  //Partial structure factors can optionally be cached for reuse by later
+  //invocations (see PlanePartialsCache above):
+  const bool use_cache = !do_select && ncgetenv_bool("FILLHKL_CACHE");
+
+  if ( compact ) {
+    //Compact mode needs complete groups of symmetry-equivalent reflections,
+    //which the estimate above does not always provide for non-orthogonal
+    //cells. So use the (larger) exact bounds, |h|<=a/dcutoff etc.:
+    max_h = std::max<int>( max_h, static_cast<int>( std::ceil( structinfo.lattice_a / cfg.dcutoff ) ) );
+    max_k = std::max<int>( max_k, static_cast<int>( std::ceil( structinfo.lattice_b / cfg.dcutoff ) ) );
+    max_l = std::max<int>( max_l, static_cast<int>( std::ceil( structinfo.lattice_c / cfg.dcutoff ) ) );
+  }
+
+  nc_assert_always(msd.size()+1==atom_begin.size());
   nc_assert_always(msd.size()==csl.size());
-  cache_factors.resize(csl.size(),0.0);
 
   //cache some thresholds for efficiency (see below where it is used for more
   //comments):
@@ -229,6 +547,10 @@ void NC::fillHKL( NC::Info& info, FillHKLCfg cfg )
       whkl_thresholds.push_back(kInfinity);//use inf when not true that fsqcut^2 << fsq
   }
 
+  //Compact mode needs the (h,k,l) indices of all family members, just like
+  //expandhkl mode:
+  const bool track_hkl = cfg.expandhkl || compact;
+
   //We now conduct a brute-force loop over h,k,l indices, adding calculated info
   //in the following containers along the way:
   HKLList hkllist;
@@ -246,16 +568,107 @@ void NC::fillHKL( NC::Info& info, FillHKLCfg cfg )
   FamMap fsq2hklidx;
 #endif
 
-  SmallVectD whkl;//outside loop for reusage
-  while ( whkl.size() < msd.size() )
-    whkl.push_back(1.0);//init with unit factors in case of forceunitdebyewallerfactor
-
   //NB, for reasons of symmetry we ignore half of the hkl vectors (ignoring
   //h,k,l->-h,-k,-l and 000). This means, half a space, and half a plane and
-  //half an axis,  hence the loop limits:
+  //half an axis, hence the loop limits.
+  //
+  //The expensive part, calculating structure factors, is done independently
+  //for each "slab" of hkl points with the same value of h. Slabs are processed
+  //in batches, potentially in parallel (see NCThreadUtils.hh), after which the
+  //resulting reflections of each batch are merged into families in the same
+  //order as in a simple serial loop over h,k,l. Results thus do not depend on
+  //the number of threads used.
+
+  struct Reflection {
+    int h, k, l;
+    double fsquared, dspacing;
+    Vector demi_normal;
+  };
+
+  //Phase factors exp(i*2pi*(h*x+k*y+l*z)) of all atoms in an (h,k) row, valid
+  //for l=phasor_l[i] for atoms of species i. Rather than calling sincos for
+  //each atom and plane, these are advanced along the l-direction by
+  //multiplication with exp(i*2pi*z). They are only calculated directly at
+  //values of l which are multiples of phasor_max_steps, and stepped from
+  //there. This bounds the accumulation of numerical errors, and makes the
+  //results for a given plane independent of which other planes were visited
+  //(and thus of dcutoff, and of whether the plane cache below is used):
+  constexpr int phasor_max_steps = 16;
+  auto updatePhases = [&]( VectD& ph_c, VectD& ph_s, std::vector<int>& phasor_l,
+                           std::size_t i, int loop_h, int loop_k, int loop_l )
+  {
+    const std::size_t jB = atom_begin[i];
+    const std::size_t jE = atom_begin[i+1];
+    const int l_anchor = loop_l - ( ( loop_l % phasor_max_steps ) + phasor_max_steps ) % phasor_max_steps;
+    nc_assert( loop_l >= phasor_l[i] );
+    if ( phasor_l[i] < l_anchor ) {
+      for ( std::size_t j = jB; j < jE; ++j ) {
+        double phase = ( loop_h * pos_x[j] + loop_k * pos_y[j] + l_anchor * pos_z[j] ) * k2Pi;
+        sincos( phase, ph_c[j], ph_s[j] );
+      }
+      phasor_l[i] = l_anchor;
+    }
+    int nsteps = loop_l - phasor_l[i];
+    phasor_l[i] = loop_l;
+    while ( nsteps-- ) {
+      for ( std::size_t j = jB; j < jE; ++j ) {
+        const double c = ph_c[j];
+        const double s = ph_s[j];
+        ph_c[j] = c * step_c[j] - s * step_s[j];
+        ph_s[j] = s * step_c[j] + c * step_s[j];
+      }
+    }
+  };
+
+  //Debye-Waller weighted coherent scattering lengths of each species for a
+  //plane with squared wave vector length ksq (whkl must be initialised with
+  //unit factors). Returns false if the resulting F^2 is certainly below
+  //fsquarecut:
+  auto calcFactors = [&]( double ksq, SmallVectD& whkl, SmallVectD& cache_factors )
+  {
+    if (no_forceunitdebyewallerfactor) {
+      nclikely fillHKL_getWhkl(whkl, ksq, msd);
+    }
+
+    double real_or_imag_upper_limit(0.0);
+    for( unsigned i=0; i < whkl.size(); ++i ) {
+      if ( whkl[i] > whkl_thresholds[i]) {
+        cache_factors[i] = 0.0;
+        continue;//Abort early to save exp/cos/sin calls. Note that
+                 //O(fsquarecut) here corresponds to O(fsquarecut^2)
+                 //contributions to final FSquared - for which we demand
+                 //>fsquarecut below. We only do this when fsquarecut<1e-2
+                 //(see calculations for whkl_thresholds above).
+      } else {
+        double factor = csl[i]*std::exp(-whkl[i]);
+        cache_factors[i] = factor;
+        //Assuming cos(phase)=sin(phase)=1 gives us a cheap upper limit on
+        //fsquared:
+        real_or_imag_upper_limit += ( atom_begin[i+1] - atom_begin[i] )*factor;
+      }
+    }
+
+    //If the upper limit on fsq is below fsquarecut, we can skip already and
+    //avoid needless calculations further down:
+    return !(real_or_imag_upper_limit*real_or_imag_upper_limit*2.0<cfg.fsquarecut);
+  };
+
+  auto calcSlab = [&]( int loop_h, std::vector<Reflection>& out )
+  {
+    out.clear();
+    SmallVectD whkl;
+    while ( whkl.size() < msd.size() )
+      whkl.push_back(1.0);//init with unit factors in case of forceunitdebyewallerfactor
+    SmallVectD cache_factors;
+    cache_factors.resize(csl.size(),0.0);
+
+    VectD ph_c(natoms), ph_s(natoms);
+    std::vector<int> phasor_l(csl.size());
 
-  for( int loop_h=0;loop_h<=max_h;++loop_h ) {
     for( int loop_k=(loop_h?-max_k:0);loop_k<=max_k;++loop_k ) {
+      //Invalidate phase factors at start of each row:
+      for ( auto& e : phasor_l )
+        e = -max_l - phasor_max_steps - 1;
       for( int loop_l=-max_l;loop_l<=max_l;++loop_l ) {
         if(loop_h==0 && loop_k==0 && loop_l<=0)
           continue;
@@ -270,32 +683,8 @@ void NC::fillHKL( NC::Info& info, FillHKLCfg cfg )
         if( dspacingsq < min_ds_sq || dspacingsq > max_ds_sq )
           continue;
 
-        if (no_forceunitdebyewallerfactor) {
-          nclikely fillHKL_getWhkl(whkl, ksq, msd);
-        }
-
         //calculate |F|^2
-        double real_or_imag_upper_limit(0.0);
-        for( unsigned i=0; i < whkl.size(); ++i ) {
-          if ( whkl[i] > whkl_thresholds[i]) {
-            cache_factors[i] = 0.0;
-            continue;//Abort early to save exp/cos/sin calls. Note that
-                     //O(fsquarecut) here corresponds to O(fsquarecut^2)
-                     //contributions to final FSquared - for which we demand
-                     //>fsquarecut below. We only do this when fsquarecut<1e-2
-                     //(see calculations for whkl_thresholds above).
-          } else {
-            double factor = csl[i]*std::exp(-whkl[i]);
-            cache_factors[i] = factor;
-            //Assuming cos(phase)=sin(phase)=1 gives us a cheap upper limit on
-            //fsquared:
-            real_or_imag_upper_limit += atomic_pos[i].size()*factor;
-          }
-        }
-
-        //If the upper limit on fsq is below fsquarecut, we can skip already and
-        //avoid needless calculations further down:
-        if(real_or_imag_upper_limit*real_or_imag_upper_limit*2.0<cfg.fsquarecut)
+        if ( !calcFactors( ksq, whkl, cache_factors ) )
           continue;
 
         //Time to calculate phases and sum up contributions. Use numerically
@@ -306,15 +695,11 @@ void NC::fillHKL( NC::Info& info, FillHKLCfg cfg )
           double factor = cache_factors[i];
           if (!factor)
             continue;
-          auto itAtomPos = atomic_pos[i].begin();
-          auto itAtomPosEnd = atomic_pos[i].end();
+          updatePhases( ph_c, ph_s, phasor_l, i, loop_h, loop_k, loop_l );
           StableSum cpsum, spsum;
-          for(;itAtomPos!=itAtomPosEnd;++itAtomPos) {
-            double phase = hkl.dot(*itAtomPos) * k2Pi;
-            double cp,sp;
-            sincos(phase,cp,sp);
-            cpsum.add(cp);
-            spsum.add(sp);
+          for ( std::size_t j = atom_begin[i]; j < atom_begin[i+1]; ++j ) {
+            cpsum.add(ph_c[j]);
+            spsum.add(ph_s[j]);
           }
           real.add(cpsum.sum() * factor);
           imag.add(spsum.sum() * factor);
@@ -331,59 +716,267 @@ void NC::fillHKL( NC::Info& info, FillHKLCfg cfg )
         waveVector *= 1.0 / std::sqrt(ksq);
 
         const double dspacing = std::sqrt(dspacingsq);//TODO: store dspacingsquared in multimap and avoid some sqrt calls.
-        FamKeyType searchkey(keygen(FSquared,dspacing));//key for our fsq2hklidx multimap
-
-        FamMap::iterator itSearchLB = fsq2hklidx.lower_bound(searchkey);
-        FamMap::iterator itSearch(itSearchLB), itSearchE(fsq2hklidx.end());
-        bool isnewfamily = true;
-        for ( ; itSearch!=itSearchE && itSearch->first == searchkey; ++itSearch ) {
-          nc_assert(itSearch->second<hkllist.size());
-          HKLInfo * hklinfo = &hkllist[itSearch->second];
-          if ( ncabs(FSquared-hklinfo->fsquared) < cfg.merge_tolerance*(FSquared+hklinfo->fsquared )
-              && ncabs(dspacing-hklinfo->dspacing) < cfg.merge_tolerance*(dspacing+hklinfo->dspacing ) )
-            {
-              //Compatible with existing family, simply add normals to it.
-              hklinfo->demi_normals.push_back(waveVector.as<HKLInfo::Normal>());
-              if (cfg.expandhkl) {
-                nc_assert(itSearch->second<eqv_hkl_short.size());
-                eqv_hkl_short[itSearch->second].push_back(loop_h);
-                eqv_hkl_short[itSearch->second].push_back(loop_k);
-                eqv_hkl_short[itSearch->second].push_back(loop_l);
-              }
-              isnewfamily = false;
-              break;
-            }
+        out.push_back( Reflection{ loop_h, loop_k, loop_l, FSquared, dspacing, waveVector } );
+      }//loop_l
+    }//loop_k
+  };
+
+  auto mergeReflection = [&]( const Reflection& r )
+  {
+    FamKeyType searchkey(keygen(r.fsquared,r.dspacing));//key for our fsq2hklidx multimap
+
+    FamMap::iterator itSearchLB = fsq2hklidx.lower_bound(searchkey);
+    FamMap::iterator itSearch(itSearchLB), itSearchE(fsq2hklidx.end());
+    for ( ; itSearch!=itSearchE && itSearch->first == searchkey; ++itSearch ) {
+      nc_assert(itSearch->second<hkllist.size());
+      HKLInfo * hklinfo = &hkllist[itSearch->second];
+      if ( ncabs(r.fsquared-hklinfo->fsquared) < cfg.merge_tolerance*(r.fsquared+hklinfo->fsquared )
+           && ncabs(r.dspacing-hklinfo->dspacing) < cfg.merge_tolerance*(r.dspacing+hklinfo->dspacing ) )
+        {
+          //Compatible with existing family, simply add normals to it.
+          hklinfo->demi_normals.push_back(r.demi_normal.as<HKLInfo::Normal>());
+          if (track_hkl) {
+            nc_assert(itSearch->second<eqv_hkl_short.size());
+            eqv_hkl_short[itSearch->second].push_back(r.h);
+            eqv_hkl_short[itSearch->second].push_back(r.k);
+            eqv_hkl_short[itSearch->second].push_back(r.l);
+          }
+          return;
         }
-        if (isnewfamily) {
+    }
 
-          if ( hkllist.size()>1000000 && !env_ignorefsqcut )//guard against crazy setups
-            NCRYSTAL_THROW2(CalcError,"Combinatorics too great to reach requested dcutoff = "<<cfg.dcutoff<<" Aa");
+    //New family:
+    if ( hkllist.size()>1000000 && !env_ignorefsqcut )//guard against crazy setups
+      NCRYSTAL_THROW2(CalcError,"Combinatorics too great to reach requested dcutoff = "<<cfg.dcutoff<<" Aa");
+
+    HKLInfo hi;
+    hi.h=r.h;
+    hi.k=r.k;
+    hi.l=r.l;
+    hi.fsquared = r.fsquared;
+    hi.dspacing = r.dspacing;
+    hi.demi_normals.push_back(r.demi_normal.as<HKLInfo::Normal>());
+    fsq2hklidx.insert(itSearchLB,FamMap::value_type(searchkey,hkllist.size()));
+    hkllist.emplace_back(std::move(hi));
+    if (track_hkl) {
+      eqv_hkl_short.push_back(std::vector<short>());
+      std::vector<short>& last = eqv_hkl_short.back();
+      last.reserve(3);
+      last.push_back(r.h);
+      last.push_back(r.k);
+      last.push_back(r.l);
+    }
+  };
 
-          HKLInfo hi;
-          hi.h=loop_h;
-          hi.k=loop_k;
-          hi.l=loop_l;
-          hi.fsquared = FSquared;
-          hi.dspacing = dspacing;
-          hi.demi_normals.push_back(waveVector.as<HKLInfo::Normal>());
-          fsq2hklidx.insert(itSearchLB,FamMap::value_type(searchkey,hkllist.size()));
-          hkllist.emplace_back(std::move(hi));
-          if (cfg.expandhkl) {
-            eqv_hkl_short.push_back(std::vector<short>());
-            std::vector<short>& last = eqv_hkl_short.back();
-            last.reserve(3);
-            last.push_back(loop_h);
-            last.push_back(loop_k);
-            last.push_back(loop_l);
+  //When caching, the temperature independent partial structure factors of all
+  //planes are kept (see PlanePartialsCache above), and reflections are
+  //calculated from those. They are calculated like in calcSlab, except that
+  //the phases of all species are needed for all planes. Planes already
+  //present in the entry "known" (if any) are skipped:
+  auto calcSlabPartials = [&]( int loop_h, const PlanePartials* known, PlanePartials& out )
+  {
+    out.clear();
+    const std::size_t nspecies = csl.size();
+    VectD ph_c(natoms), ph_s(natoms);
+    std::vector<int> phasor_l(nspecies);
+    for( int loop_k=(loop_h?-max_k:0);loop_k<=max_k;++loop_k ) {
+      for ( auto& e : phasor_l )
+        e = -max_l - phasor_max_steps - 1;
+      for( int loop_l=-max_l;loop_l<=max_l;++loop_l ) {
+        if(loop_h==0 && loop_k==0 && loop_l<=0)
+          continue;
+        Vector waveVector = rec_lat*Vector(loop_h,loop_k,loop_l);
+        const double ksq = waveVector.mag2();
+        const double dspacingsq = (k2Pi*k2Pi)/ksq;
+        if( dspacingsq < min_ds_sq || dspacingsq > max_ds_sq )
+          continue;
+        if ( known && known->contains( loop_h, loop_k, loop_l, dspacingsq ) )
+          continue;
+        const std::size_t ipartials = out.partials.size();
+        double fabs_upper_limit = 0.0;
+        for ( std::size_t i = 0; i < nspecies; ++i ) {
+          updatePhases( ph_c, ph_s, phasor_l, i, loop_h, loop_k, loop_l );
+          StableSum cpsum, spsum;
+          for ( std::size_t j = atom_begin[i]; j < atom_begin[i+1]; ++j ) {
+            cpsum.add(ph_c[j]);
+            spsum.add(ph_s[j]);
           }
+          const double cp = cpsum.sum();
+          const double sp = spsum.sum();
+          out.partials.push_back( cp );
+          out.partials.push_back( sp );
+          fabs_upper_limit += ncabs(csl[i]) * std::sqrt( cp*cp + sp*sp );
         }
-      }//loop_l
-    }//loop_k
-  }//loop_h
+        //Skip planes which can never pass the fsquarecut (with a small safety
+        //margin for rounding errors):
+        if ( fabs_upper_limit*fabs_upper_limit*(1.0+1e-9) < cfg.fsquarecut ) {
+          out.partials.resize( ipartials );
+          continue;
+        }
+        out.hkl.push_back( loop_h );
+        out.hkl.push_back( loop_k );
+        out.hkl.push_back( loop_l );
+        out.ksq.push_back( ksq );
+        out.demi_normals.push_back( waveVector * ( 1.0 / std::sqrt(ksq) ) );
+      }
+    }
+  };
 
+  auto reflectionsFromPartials = [&]( const PlanePartials& pp, std::size_t ibegin,
+                                      std::size_t iend, std::vector<Reflection>& out )
+  {
+    out.clear();
+    SmallVectD whkl;
+    while ( whkl.size() < msd.size() )
+      whkl.push_back(1.0);
+    SmallVectD cache_factors;
+    cache_factors.resize(csl.size(),0.0);
+    for ( std::size_t ip = ibegin; ip < iend; ++ip ) {
+      const int * hkl = &pp.hkl[3*ip];
+      const double ksq = pp.ksq[ip];
+      const double dspacingsq = (k2Pi*k2Pi)/ksq;
+      //Only use planes which the serial loop over h,k,l would visit:
+      if( dspacingsq < min_ds_sq || dspacingsq > max_ds_sq
+          || hkl[0] > max_h || std::abs(hkl[1]) > max_k || std::abs(hkl[2]) > max_l )
+        continue;
+      if ( !calcFactors( ksq, whkl, cache_factors ) )
+        continue;
+      const double * partials = &pp.partials[ 2 * pp.nspecies * ip ];
+      StableSum real, imag;
+      for( unsigned i=0 ; i < whkl.size(); ++i ) {
+        double factor = cache_factors[i];
+        if (!factor)
+          continue;
+        real.add(partials[2*i] * factor);
+        imag.add(partials[2*i+1] * factor);
+      }
+      double realsum = real.sum();
+      double imagsum = imag.sum();
+      double FSquared = (realsum*realsum+imagsum*imagsum);
+      if(FSquared<cfg.fsquarecut)
+        continue;
+      out.push_back( Reflection{ hkl[0], hkl[1], hkl[2], FSquared,
+                                 std::sqrt(dspacingsq), pp.demi_normals[ip] } );
+    }
+  };
+
+  //Limited batch size keeps memory usage down and allows the guard against
+  //crazy setups in mergeReflection to trigger early:
+  const unsigned nthreads = getNThreadsFromEnv();
+  const int nbatch = ( nthreads > 1 ? static_cast<int>( 4 * nthreads ) : 1 );
+  if ( use_cache ) {
+    //Key encodes all inputs except dcutoff and mean-squared-displacements
+    //(including the compact flag, which affects how the searched (h,k,l)
+    //range depends on dcutoff):
+    VectD ppkey = { structinfo.lattice_a, structinfo.lattice_b, structinfo.lattice_c,
+                    structinfo.alpha, structinfo.beta, structinfo.gamma,
+                    cfg.dcutoffup, cfg.fsquarecut, double(compact) };
+    for ( std::size_t i = 0; i < csl.size(); ++i ) {
+      ppkey.push_back( csl[i] );
+      ppkey.push_back( double( atom_begin[i+1] - atom_begin[i] ) );
+      for ( std::size_t j = atom_begin[i]; j < atom_begin[i+1]; ++j ) {
+        ppkey.push_back( pos_x[j] );
+        ppkey.push_back( pos_y[j] );
+        ppkey.push_back( pos_z[j] );
+      }
+    }
+    std::shared_ptr<const PlanePartials> planes = planePartialsCache().lookup( ppkey );
+    if ( !planes || planes->dcutoff > cfg.dcutoff ) {
+      //Calculate the planes not already known, and merge them with the known
+      //ones (if any) in the order of the serial loop over h,k,l:
+      const std::shared_ptr<const PlanePartials> known = std::move(planes);
+      const std::size_t nknown = ( known ? known->size() : 0 );
+      std::size_t iknown = 0;
+      auto pp = std::make_shared<PlanePartials>();
+      pp->dcutoff = cfg.dcutoff;
+      pp->max_h = max_h;
+      pp->max_k = max_k;
+      pp->max_l = max_l;
+      pp->nspecies = csl.size();
+      auto appendKnownBefore = [&known,&pp,&iknown,nknown]( const int * hkl )
+      {
+        for ( ; iknown < nknown; ++iknown ) {
+          const int * hkl_known = &known->hkl[3*iknown];
+          if ( hkl && !std::lexicographical_compare( hkl_known, hkl_known + 3, hkl, hkl + 3 ) )
+            return;
+          pp->append( *known, iknown );
+        }
+      };
+      std::vector<PlanePartials> slabpartials;
+      for ( int batch_h = 0; batch_h <= max_h; batch_h += nbatch ) {
+        const int n = std::min<int>( nbatch, max_h + 1 - batch_h );
+        slabpartials.resize(n);
+        parallelFor( n, nthreads,
+                     [&slabpartials,&calcSlabPartials,&known,batch_h]( std::size_t i )
+                     {
+                       calcSlabPartials( batch_h + static_cast<int>(i), known.get(), slabpartials[i] );
+                     } );
+        for ( int i = 0; i < n; ++i ) {
+          const PlanePartials& slab = slabpartials[i];
+          for ( std::size_t j = 0; j < slab.size(); ++j ) {
+            appendKnownBefore( &slab.hkl[3*j] );
+            pp->append( slab, j );
+          }
+        }
+      }
+      appendKnownBefore( nullptr );
+      planePartialsCache().store( std::move(ppkey), pp );
+      planes = std::move(pp);
+    }
+    //Reflections are produced in fixed size chunks of planes, merged in order:
+    constexpr std::size_t chunksize = 8192;
+    const std::size_t nplanes = planes->size();
+    const std::size_t nchunks = ( nplanes + chunksize - 1 ) / chunksize;
+    std::vector<std::vector<Reflection>> chunks;
+    for ( std::size_t batch = 0; batch < nchunks; batch += nbatch ) {
+      const std::size_t n = std::min<std::size_t>( nbatch, nchunks - batch );
+      chunks.resize(n);
+      parallelFor( n, nthreads,
+                   [&chunks,&reflectionsFromPartials,&planes,batch,nplanes]( std::size_t i )
+                   {
+                     const std::size_t ibegin = ( batch + i ) * chunksize;
+                     reflectionsFromPartials( *planes, ibegin,
+                                              std::min<std::size_t>( ibegin + chunksize, nplanes ),
+                                              chunks[i] );
+                   } );
+      for ( std::size_t i = 0; i < n; ++i )
+        for ( const auto& r : chunks[i] )
+          mergeReflection( r );
+    }
+  } else {
+    std::vector<std::vector<Reflection>> slabs;
+    for ( int batch_h = 0; batch_h <= max_h; batch_h += nbatch ) {
+      const int n = std::min<int>( nbatch, max_h + 1 - batch_h );
+      slabs.resize(n);
+      parallelFor( n, nthreads,
+                   [&slabs,&calcSlab,batch_h]( std::size_t i )
+                   {
+                     calcSlab( batch_h + static_cast<int>(i), slabs[i] );
+                   } );
+      for ( int i = 0; i < n; ++i )
+        for ( const auto& r : slabs[i] )
+          mergeReflection( r );
+    }
+  }
   //update HKLlist and copy to info
   info.enableHKLInfo(cfg.dcutoff,cfg.dcutoffup);
 
+  if ( compact ) {
+    HKLList compactlist;
+    if ( compactifyHKLList( hkllist, eqv_hkl_short, spacegroup, compactlist ) ) {
+      setResult(std::move(compactlist));
+      return;
+    }
+    //Fall back to normal HKL list (should not happen for valid input):
+    static bool s_first = true;
+    if ( s_first ) {
+      s_first = false;
+      std::cout<<"NCrystal WARNING: Could not produce compact HKL list since the hkl"
+        " families are not consistent with the space group (will provide normal"
+        " HKL list instead)."<<std::endl;
+    }
+  }
+
   HKLList::iterator itHKL, itHKLB(hkllist.begin()), itHKLE(hkllist.end());
   for(itHKL=itHKLB;itHKL!=itHKLE;++itHKL) {
     unsigned deminorm_size = itHKL->demi_normals.size();
@@ -399,6 +992,6 @@ void NC::fillHKL( NC::Info& info, FillHKLCfg cfg )
       std::copy(eh.begin(), eh.end(), &itHKL->eqv_hkl[0]);
     }
   }
-  info.setHKLList(std::move(hkllist));;
+  setResult(std::move(hkllist));
 
 }
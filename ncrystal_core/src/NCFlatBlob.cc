@@ -0,0 +1,174 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+//  This file is part of NCrystal (see https://mctools.github.io/ncrystal/)   //
+//                                                                            //
+//  Copyright 2015-2021 NCrystal developers                                   //
+//                                                                            //
+//  Licensed under the Apache License, Version 2.0 (the "License");           //
+//  you may not use this file except in compliance with the License.          //
+//  You may obtain a copy of the License at                                   //
+//                                                                            //
+//      http://www.apache.org/licenses/LICENSE-2.0                            //
+//                                                                            //
+//  Unless required by applicable law or agreed to in writing, software       //
+//  distributed under the License is distributed on an "AS IS" BASIS,         //
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  //
+//  See the License for the specific language governing permissions and       //
+//  limitations under the License.                                            //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include "NCrystal/internal/NCFlatBlob.hh"
+#include "NCrystal/internal/NCPCBragg.hh"
+#include "NCrystal/internal/NCMath.hh"
+#include "NCrystal/ncflatblob.h"
+#include <cstring>
+
+namespace NC = NCrystal;
+
+namespace NCrystal {
+  namespace {
+
+    struct FlatComponent {
+      double scale;
+      const ProcImpl::Process* process;
+    };
+
+    void collectComponents( const ProcImpl::Process& p, double scale, std::vector<FlatComponent>& out )
+    {
+      if ( p.isNull() || !(scale>0.0) )
+        return;
+      auto pc = dynamic_cast<const ProcImpl::ProcComposition*>(&p);
+      if ( !pc ) {
+        out.push_back( { scale, &p } );
+        return;
+      }
+      for ( auto& c : pc->components() )
+        collectComponents( *c.process, scale * c.scale, out );
+    }
+
+    class BlobWriter {
+    public:
+      //Reserve space for n doubles (or other 8-byte entries), returning byte offset:
+      std::uint64_t reserve( std::size_t n )
+      {
+        std::uint64_t off = m_data.size() * sizeof(std::uint64_t);
+        m_data.resize( m_data.size() + n, 0 );
+        return off;
+      }
+      double * darr( std::uint64_t off )
+      {
+        return reinterpret_cast<double*>( reinterpret_cast<char*>( m_data.data() ) + off );
+      }
+      template<class T>
+      void write( std::uint64_t off, const T& t )
+      {
+        static_assert( sizeof(T) % sizeof(std::uint64_t) == 0, "" );
+        std::memcpy( reinterpret_cast<char*>( m_data.data() ) + off, &t, sizeof(T) );
+      }
+      std::vector<std::uint64_t>& data() { return m_data; }
+    private:
+      std::vector<std::uint64_t> m_data;
+    };
+
+  }
+}
+
+std::vector<std::uint64_t> NC::exportFlatBlob( const ProcImpl::Process& proc, RNG& rng, const FlatBlobCfg& cfg )
+{
+  if ( proc.isOriented() )
+    NCRYSTAL_THROW(BadInput,"exportFlatBlob: only supported for non-oriented processes.");
+  if ( !( cfg.ekin_min > 0.0 && cfg.ekin_min < cfg.ekin_max && std::isfinite(cfg.ekin_max) )
+       || cfg.nekin < 2 || cfg.nsamples < 1 )
+    NCRYSTAL_THROW(BadInput,"exportFlatBlob: invalid parameters.");
+
+  std::vector<FlatComponent> comps;
+  collectComponents( proc, 1.0, comps );
+
+  //Union energy grid:
+  VectD egrid = logspace( std::log10(cfg.ekin_min), std::log10(cfg.ekin_max), cfg.nekin );
+  egrid.front() = cfg.ekin_min;
+  egrid.back() = cfg.ekin_max;
+  for ( auto& c : comps ) {
+    auto d = c.process->domain();
+    for ( double e : { d.elow.dbl(), d.ehigh.dbl() } )
+      if ( e > cfg.ekin_min && e < cfg.ekin_max )
+        egrid.push_back( e );
+  }
+  std::sort( egrid.begin(), egrid.end() );
+  egrid.erase( std::unique( egrid.begin(), egrid.end() ), egrid.end() );
+  const std::size_t ne = egrid.size();
+  const std::size_t ns = cfg.nsamples;
+
+  BlobWriter w;
+  ncflatblob_header_t hdr;
+  std::memset( &hdr, 0, sizeof(hdr) );
+  const std::uint64_t off_hdr = w.reserve( sizeof(hdr) / sizeof(std::uint64_t) );
+  nc_assert_always( off_hdr == 0 );
+  hdr.magic = NCFLATBLOB_MAGIC;
+  hdr.version = NCFLATBLOB_VERSION;
+  hdr.n_egrid = ne;
+  hdr.n_samples = ns;
+  hdr.n_comp = comps.size();
+  hdr.off_egrid = w.reserve( ne );
+  std::copy( egrid.begin(), egrid.end(), w.darr( hdr.off_egrid ) );
+  hdr.off_xstot = w.reserve( ne );
+  hdr.off_comps = w.reserve( comps.size() * sizeof(ncflatblob_comp_t) / sizeof(std::uint64_t) );
+
+  VectD xstot( ne, 0.0 );
+  VectD sampled_ekin( ns ), sampled_mu( ns );
+  for ( std::size_t ic = 0; ic < comps.size(); ++ic ) {
+    const auto& c = comps.at(ic);
+    ncflatblob_comp_t fc;
+    std::memset( &fc, 0, sizeof(fc) );
+    CachePtr cache;
+    auto pcbragg = dynamic_cast<const PCBragg*>( c.process );
+    if ( pcbragg ) {
+      const auto& edges = pcbragg->braggEdgeEnergies();
+      const auto& commul = pcbragg->braggEdgeCommulXS();
+      nc_assert_always( edges.size() == commul.size() );
+      fc.type = NCFLATBLOB_COMP_BRAGG;
+      fc.n = edges.size();
+      fc.off_a = w.reserve( edges.size() );
+      std::copy( edges.begin(), edges.end(), w.darr( fc.off_a ) );
+      fc.off_b = w.reserve( commul.size() );
+      double * out_commul = w.darr( fc.off_b );
+      for ( std::size_t i = 0; i < commul.size(); ++i )
+        out_commul[i] = c.scale * commul[i];
+      for ( std::size_t i = 0; i < ne; ++i )
+        xstot[i] += c.scale * c.process->crossSectionIsotropic( cache, NeutronEnergy{egrid[i]} ).dbl();
+    } else {
+      fc.type = NCFLATBLOB_COMP_TABULATED;
+      fc.n = ne;
+      fc.off_a = w.reserve( ne );
+      fc.off_b = w.reserve( ne * ns );
+      fc.off_c = w.reserve( ne * ns );
+      const auto domain = c.process->domain();
+      for ( std::size_t i = 0; i < ne; ++i ) {
+        const NeutronEnergy ekin{egrid[i]};
+        const double xs = ( domain.contains(ekin)
+                            ? c.scale * c.process->crossSectionIsotropic( cache, ekin ).dbl()
+                            : 0.0 );
+        w.darr( fc.off_a )[i] = xs;
+        xstot[i] += xs;
+        double * out_ratio = w.darr( fc.off_b ) + i * ns;
+        double * out_mu = w.darr( fc.off_c ) + i * ns;
+        if ( !(xs>0.0) ) {
+          std::fill( out_ratio, out_ratio + ns, 1.0 );
+          std::fill( out_mu, out_mu + ns, 1.0 );
+          continue;
+        }
+        std::fill( sampled_ekin.begin(), sampled_ekin.end(), egrid[i] );
+        c.process->sampleScatterIsotropicMany( cache, rng, sampled_ekin.data(), ns, sampled_mu.data() );
+        for ( std::size_t j = 0; j < ns; ++j )
+          out_ratio[j] = sampled_ekin[j] / egrid[i];
+        std::copy( sampled_mu.begin(), sampled_mu.end(), out_mu );
+      }
+    }
+    w.write( hdr.off_comps + ic * sizeof(ncflatblob_comp_t), fc );
+  }
+  std::copy( xstot.begin(), xstot.end(), w.darr( hdr.off_xstot ) );
+  hdr.nbytes = w.data().size() * sizeof(std::uint64_t);
+  w.write( off_hdr, hdr );
+  return std::move( w.data() );
+}
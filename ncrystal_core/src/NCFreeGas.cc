@@ -28,35 +28,46 @@ struct NC::FreeGas::Impl {
 
   Impl( Temperature t,
         AtomMass target_mass_amu,
-        SigmaFree sigma )
+        SigmaFree sigma,
+        bool tabulatedBeta )
     : m_xsprovider(t, target_mass_amu, sigma),
       m_temperature(DoValidate,t),
       m_target_mass_amu(DoValidate,target_mass_amu)
   {
+    if ( tabulatedBeta )
+      m_betatable = FreeGasBetaTable::getShared( target_mass_amu ).getsp();
   }
 
   FreeGasXSProvider m_xsprovider;
   Temperature m_temperature;
   AtomMass m_target_mass_amu;
+  std::shared_ptr<const FreeGasBetaTable> m_betatable;
+
+  FreeGasSampler sampler( NeutronEnergy ekin ) const
+  {
+    return FreeGasSampler( ekin, m_temperature, m_target_mass_amu, m_betatable.get() );
+  }
 
 };
 
 NC::FreeGas::FreeGas( Temperature t,
                       AtomMass target_mass_amu,
-                      SigmaFree sigma )
-  : m_impl(t,target_mass_amu,sigma)
+                      SigmaFree sigma,
+                      bool tabulatedBeta )
+  : m_impl(t,target_mass_amu,sigma,tabulatedBeta)
 {
 }
 
 NC::FreeGas::FreeGas( Temperature t,
                       AtomMass target_mass_amu,
-                      SigmaBound sb )
-  : FreeGas( t, target_mass_amu, sb.free(target_mass_amu) )
+                      SigmaBound sb,
+                      bool tabulatedBeta )
+  : FreeGas( t, target_mass_amu, sb.free(target_mass_amu), tabulatedBeta )
 {
 }
 
-NC::FreeGas::FreeGas( Temperature t, const AtomData& ad )
-  : FreeGas( t, ad.averageMassAMU(), ad.freeScatteringXS() )
+NC::FreeGas::FreeGas( Temperature t, const AtomData& ad, bool tabulatedBeta )
+  : FreeGas( t, ad.averageMassAMU(), ad.freeScatteringXS(), tabulatedBeta )
 {
 }
 
@@ -67,9 +78,41 @@ NC::CrossSect NC::FreeGas::crossSectionIsotropic(CachePtr&, NeutronEnergy ekin )
   return CrossSect{ m_impl->m_xsprovider.crossSection(ekin) };
 }
 
+NC::CrossSect NC::FreeGas::majorantCrossSection( EnergyDomain d ) const
+{
+  //Cross sections decrease with energy (from infinity at ekin=0 towards the
+  //free cross section at high energies):
+  return m_impl->m_xsprovider.crossSection( d.elow );
+}
+
+void NC::FreeGas::evalManyXSIsotropic( CachePtr&, const double* ekin, std::size_t N,
+                                      double* out_xs ) const
+{
+  m_impl->m_xsprovider.evalManyXS( ekin, N, out_xs );
+}
+
 NC::ScatterOutcomeIsotropic NC::FreeGas::sampleScatterIsotropic(CachePtr&, RNG& rng, NeutronEnergy ekin ) const
 {
   double delta_ekin, mu;
-  std::tie(delta_ekin,mu) = FreeGasSampler(ekin,m_impl->m_temperature,m_impl->m_target_mass_amu).sampleDeltaEMu(rng);
+  std::tie(delta_ekin,mu) = m_impl->sampler(ekin).sampleDeltaEMu(rng);
   return { NeutronEnergy{ncmax(0.0,ekin.get()+delta_ekin)}, CosineScatAngle{mu} };
 }
+
+void NC::FreeGas::sampleScatterIsotropicMany( CachePtr&, RNG& rng, double* ekin, std::size_t N,
+                                              double* out_mu ) const
+{
+  double delta_ekin, mu;
+  for ( std::size_t i = 0; i < N; ++i ) {
+    NeutronEnergy e{ekin[i]};
+    std::tie(delta_ekin,mu) = m_impl->sampler(e).sampleDeltaEMu(rng);
+    ekin[i] = ncmax( 0.0, e.get() + delta_ekin );
+    out_mu[i] = mu;
+  }
+}
+
+void NC::FreeGas::accountMemory( MemoryFootprint& mf ) const
+{
+  mf.add( sizeof(FreeGas) + sizeof(Impl) );
+  mf.addSharedObject( m_impl->m_betatable,
+                      [&mf]( const FreeGasBetaTable& t ) { mf.add( t.approxMemoryUsage() ); } );
+}
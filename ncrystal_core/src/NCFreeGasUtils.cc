@@ -21,6 +21,7 @@
 #include "NCrystal/internal/NCFreeGasUtils.hh"
 #include "NCrystal/internal/NCMath.hh"
 #include "NCrystal/internal/NCRandUtils.hh"
+#include "NCrystal/internal/NCFactoryUtils.hh"
 namespace NC=NCrystal;
 
 #define NCRYSTAL_FREEGASUTILS_ENABLEEXTRADEBUGGING 0
@@ -489,7 +490,8 @@ namespace NCrystal {
 
 }
 
-NC::FreeGasSampler::FreeGasSampler(NeutronEnergy ekin, Temperature temp_kelvin, AtomMass target_mass_amu)
+NC::FreeGasSampler::FreeGasSampler(NeutronEnergy ekin, Temperature temp_kelvin, AtomMass target_mass_amu,
+                                   const FreeGasBetaTable* betatable )
   : m_c(ncmin(1e14,ncmax(1e-10,ekin.get()/(temp_kelvin.kT())))),
     //nb: we constrain m_c for numerical safety (1.16e13 is 1GeV neutron on 1Kelvin material)
     m_kT(temp_kelvin.kT()),
@@ -497,7 +499,8 @@ NC::FreeGasSampler::FreeGasSampler(NeutronEnergy ekin, Temperature temp_kelvin,
     m_invA(1.0/target_mass_amu.relativeToNeutronMass()),
     m_Adiv4(0.25*target_mass_amu.relativeToNeutronMass()),
     m_normfact(0.5/std::erf(std::sqrt(m_c*m_invA))),
-    m_c_real(ekin.get()/(temp_kelvin.kT()))//unconstrainted version of m_c
+    m_c_real(ekin.get()/(temp_kelvin.kT())),//unconstrainted version of m_c
+    m_betatable(betatable)
 {
 #ifndef NDEBUG
   nc_assert(m_c>0);
@@ -511,6 +514,7 @@ NC::FreeGasSampler::FreeGasSampler(NeutronEnergy ekin, Temperature temp_kelvin,
   ekin.validate();
   temp_kelvin.validate();
   target_mass_amu.validate();
+  nc_assert( !betatable || betatable->targetMass() == target_mass_amu );
 #endif
 }
 
@@ -527,7 +531,19 @@ void NC::FreeGasSampler::testBetaDistEval (double beta, double & f_exact, double
   f_exact = eval_helper.evalExact();
 }
 
-double NC::FreeGasSampler::sampleBeta( RNG& rng ) const
+namespace NCrystal {
+  namespace {
+    //Threshold in c=E/kT above which beta is sampled from a uniform energy
+    //loss distribution (A is the target mass relative to the neutron mass):
+    double freeGasHighECThreshold( double A )
+    {
+      const double A2 = A*A;
+      return 1e4*ncmin(1000.0*A,A2*A2*A2);
+    }
+  }
+}
+
+double NC::FreeGasSampler::sampleBetaExact( RNG& rng ) const
 {
   if (m_c_real>1e4) {
     //At extremely high energy the neutron will to a very good approximation
@@ -536,9 +552,7 @@ double NC::FreeGasSampler::sampleBeta( RNG& rng ) const
     //exact threshold of what constitutes "very high' energy depends on the
     //value of A. We use an ad-hoc determination of the threshold, found from
     //inspection of beta-distributions:
-    const double A = 1.0 / m_invA;
-    const double A2 = A*A;
-    const double c_highe_threshold = 1e4*ncmin(1000.0*A,A2*A2*A2);
+    const double c_highe_threshold = freeGasHighECThreshold( 1.0 / m_invA );
     if ( m_c_real > c_highe_threshold ) {
       double am1_div_ap1 = (1.0-m_invA)/(1.0+m_invA);// (A-1)/(A+1);
       double elossmax = m_c_real * (1.0-am1_div_ap1*am1_div_ap1);
@@ -929,3 +943,156 @@ double NC::FreeGasSampler::sampleAlpha( double beta, RNG& rng ) const
     return ncclamp(x*t,am,ap);
   }
 }
+
+namespace NCrystal {
+  namespace {
+    //Grid parameters of FreeGasBetaTable:
+    constexpr unsigned fgbt_nc_per_decade = 24;
+    constexpr unsigned fgbt_nu = 513;//quantiles per grid point
+    constexpr unsigned fgbt_nscan = 500;//coarse points per side when narrowing ranges
+    constexpr unsigned fgbt_nfine = 2000;//fine integration points per side
+
+    class FreeGasBetaTableFactory : public CachedFactoryBase<double,FreeGasBetaTable> {
+    public:
+      FreeGasBetaTableFactory( bool highE ) : m_highE(highE) {}
+      const char* factoryName() const final { return m_highE ? "FreeGasBetaTableFactory(highE)" : "FreeGasBetaTableFactory"; }
+      std::string keyToString( const double& key ) const final
+      {
+        std::ostringstream ss;
+        ss<<"(mass="<<key<<"u)";
+        return ss.str();
+      }
+    protected:
+      ShPtr actualCreate( const double& key ) const final
+      {
+        return std::make_shared<const FreeGasBetaTable>( AtomMass{key}, m_highE );
+      }
+      std::size_t approxMemoryUsage( const FreeGasBetaTable& t ) const final
+      {
+        return t.approxMemoryUsage();
+      }
+    private:
+      bool m_highE;
+    };
+  }
+}
+
+constexpr double NC::FreeGasBetaTable::cmin;
+constexpr double NC::FreeGasBetaTable::cmax;
+
+double NC::FreeGasBetaTable::highECMax( AtomMass m )
+{
+  return ncmax( cmax, freeGasHighECThreshold( m.relativeToNeutronMass() ) );
+}
+
+NC::FreeGasBetaTable::FreeGasBetaTable( AtomMass target_mass_amu, bool highE )
+  : m_mass(target_mass_amu),
+    m_cmin( highE ? cmax : cmin ),
+    m_cmax( highE ? highECMax( target_mass_amu ) : cmax ),
+    m_highE( highE )
+{
+  target_mass_amu.validate();
+  const double invA = 1.0/target_mass_amu.relativeToNeutronMass();
+  const double ndecades = std::log10( m_cmax / m_cmin );
+  m_nc = ncmax( 2u, static_cast<unsigned>( std::ceil( ndecades * fgbt_nc_per_decade - 1e-9 ) ) + 1 );
+  m_dlogc_inv = ( m_cmax > m_cmin ? ( m_nc - 1 ) / std::log( m_cmax / m_cmin ) : 0.0 );
+  m_quantiles.reserve( m_nc * fgbt_nu );
+  const double fcut = 1e-10;//relative to f(beta=0)=1, negligible contributions
+  const double bmax = 13.815510557964274;//same upper limit as in sampleBetaExact
+  VectD grid, cdf;
+  grid.reserve( 2*fgbt_nfine );
+  cdf.reserve( 2*fgbt_nfine );
+  for ( unsigned ic = 0; ic < m_nc; ++ic ) {
+    const double c = ( ic == 0 ? m_cmin : ( ic + 1 == m_nc ? m_cmax : m_cmin * std::exp( ic / m_dlogc_inv ) ) );
+    const double sqrtAc = std::sqrt( target_mass_amu.dbl()*c/const_neutron_atomic_mass );
+    const double normfact = 0.5/std::erf(std::sqrt(c*invA));
+    auto f = [c,invA,sqrtAc,normfact]( double beta )
+    {
+      return ( beta <= -c ? 0.0 : FGEvalBetaDistHelper( c, invA, sqrtAc, beta, normfact ).evalExact() );
+    };
+    //Narrow the ranges on each side of beta=0 (f decreases monotonically away
+    //from beta=0) to where f is non-negligible:
+    double blow = -c;
+    for ( unsigned i = 1; i < fgbt_nscan; ++i ) {
+      const double b = -c * ( 1.0 - double(i) / fgbt_nscan );
+      if ( f( b ) > fcut )
+        break;
+      blow = b;
+    }
+    double bhigh = bmax;
+    for ( unsigned i = 1; i < fgbt_nscan; ++i ) {
+      const double b = bmax * ( 1.0 - double(i) / fgbt_nscan );
+      if ( f( b ) > fcut )
+        break;
+      bhigh = b;
+    }
+    //Integrate with the trapezoidal rule on fine grids on each side:
+    grid.clear();
+    cdf.clear();
+    for ( auto b : linspace( blow, 0.0, fgbt_nfine ) )
+      grid.push_back( b );
+    for ( auto b : linspace( 0.0, bhigh, fgbt_nfine ) )
+      if ( b > 0.0 )
+        grid.push_back( b );
+    double fprev = f( grid.front() );
+    cdf.push_back( 0.0 );
+    for ( std::size_t i = 1; i < grid.size(); ++i ) {
+      const double fval = f( grid[i] );
+      cdf.push_back( cdf.back() + 0.5 * ( fval + fprev ) * ( grid[i] - grid[i-1] ) );
+      fprev = fval;
+    }
+    nc_assert_always( cdf.back() > 0.0 );
+    //Invert at equidistant points in [0,1] (storing beta/c for high-E tables):
+    const double norm = cdf.back();
+    const double qscale = m_highE ? 1.0 / c : 1.0;
+    std::size_t j = 0;
+    for ( unsigned iu = 0; iu < fgbt_nu; ++iu ) {
+      const double target = norm * double(iu) / ( fgbt_nu - 1 );
+      while ( j + 2 < cdf.size() && cdf[j+1] < target )
+        ++j;
+      const double dc = cdf[j+1] - cdf[j];
+      const double t = dc > 0.0 ? ncclamp( ( target - cdf[j] ) / dc, 0.0, 1.0 ) : 0.0;
+      m_quantiles.push_back( ( grid[j] + t * ( grid[j+1] - grid[j] ) ) * qscale );
+    }
+  }
+  nc_assert_always( m_quantiles.size() == m_nc * fgbt_nu );
+}
+
+double NC::FreeGasBetaTable::sampleBeta( double c, RNG& rng ) const
+{
+  nc_assert( covers(c) );
+  const double pos = std::log( c / m_cmin ) * m_dlogc_inv;
+  const unsigned ic = std::min<unsigned>( static_cast<unsigned>( ncmax( 0.0, pos ) ), m_nc - 2 );
+  const double w = ncclamp( pos - ic, 0.0, 1.0 );
+  const double * q0 = &m_quantiles[ ic * fgbt_nu ];
+  const double * q1 = q0 + fgbt_nu;
+  while ( true ) {
+    const double u = rng.generate() * ( fgbt_nu - 1 );
+    const unsigned iu = std::min<unsigned>( static_cast<unsigned>( u ), fgbt_nu - 2 );
+    const double t = u - iu;
+    const double b0 = q0[iu] + t * ( q0[iu+1] - q0[iu] );
+    const double b1 = q1[iu] + t * ( q1[iu+1] - q1[iu] );
+    const double beta = ( b0 + w * ( b1 - b0 ) ) * ( m_highE ? c : 1.0 );
+    //The interpolated lower endpoint might be slightly below the kinematic
+    //limit of -c, in which case we simply try again:
+    if ( beta > -c )
+      return beta;
+  }
+}
+
+std::size_t NC::FreeGasBetaTable::approxMemoryUsage() const noexcept
+{
+  return sizeof(FreeGasBetaTable) + m_quantiles.size() * sizeof(double);
+}
+
+NC::shared_obj<const NC::FreeGasBetaTable> NC::FreeGasBetaTable::getShared( AtomMass m )
+{
+  static FreeGasBetaTableFactory s_factory( false );
+  return s_factory.create( m.dbl() );
+}
+
+NC::shared_obj<const NC::FreeGasBetaTable> NC::FreeGasBetaTable::getSharedHighE( AtomMass m )
+{
+  static FreeGasBetaTableFactory s_factory( true );
+  return s_factory.create( m.dbl() );
+}
@@ -106,6 +106,11 @@ void NC::GaussMos::setPrecision(double p)
   }
 }
 
+void NC::GaussMos::enableCircleIntegralTable()
+{
+  m_gos.enableCircleIntegralTable();
+}
+
 void NC::GaussMos::setDSpacingSpread(double dd)
 {
   if (dd==m_delta_d)
@@ -146,19 +151,178 @@ double NC::GaussMos::calcRawCrossSectionValueInit(InteractionPars& ip, double co
   }
 }
 
+void NC::GaussMos::calcRawCrossSectionValues( InteractionPars& ip,
+                                              Span<const double> cosangles,
+                                              Span<double> out ) const
+{
+  nc_assert(ip.isValid());
+  nc_assert(cosangles.size()==out.size());
+  const std::size_t n = out.size();
+  if (!n)
+    return;
+  std::size_t ibegin = 0;
+  if (!(ip.m_Q>0.)) {
+    //Let the first evaluation initialise Q:
+    out[0] = calcRawCrossSectionValue(ip,cosangles[0]);
+    ibegin = 1;
+  }
+  if (ip.m_Q>0.) {
+    //Usual case:
+    Span<double> outrest = out.subspan(ibegin);
+    m_gos.circleIntegralMany( cosangles.subspan(ibegin), ip.m_sin_perfect_theta, ip.m_cos_perfect_theta, outrest );
+    for ( auto& e : outrest )
+      e *= ip.m_Q;
+  } else {
+    //Q is zero or infinite:
+    for ( std::size_t i = ibegin; i < n; ++i )
+      out[i] = calcRawCrossSectionValue(ip,cosangles[i]);
+  }
+}
+
+double NC::GaussMos::calcMaxCrossSectionValue( double wl_max, double inv2dsp, double xsfact ) const
+{
+  nc_assert(wl_max>=0&&inv2dsp>0&&xsfact>=0);
+  const double sin_perfect_theta = ncmin( 1.0, wl_max * inv2dsp );
+  if ( !(sin_perfect_theta>0.0) )
+    return 0.0;
+  const double cos_perfect_theta = std::sqrt( ncmax( 0.0, 1.0 - sin_perfect_theta*sin_perfect_theta ) );
+  //Cross sections are Q*circleIntegral with Q=wl^3*xsfact/(2*sintheta*costheta),
+  //where the circle has circumference 2pi*costheta and the density (which is
+  //at most the normalisation factor) is non-vanishing only within the
+  //truncation angle. The circle integral can thus be no larger than
+  //2pi*normfact*min(costheta,truncangle). Additionally, the integral along a
+  //curve through the center of the Gaussian is about sqrt(2pi)*sigma*normfact,
+  //so we can (conservatively) also limit the effective length of the circle
+  //to 2pi*sigma:
+  const double s = ncmin( m_gos.getTruncangle(), m_gos.getSigma() );
+  const double wl = sin_perfect_theta / inv2dsp;
+  const double fact = ( cos_perfect_theta > s ? s / cos_perfect_theta : 1.0 );
+  return kPi * m_gos.getNormFactor() * xsfact * wl * wl * fact / inv2dsp;
+}
+
+namespace NCrystal {
+  //Normals and anti-normals which passed the truncation checks are collected
+  //in batches, allowing the circle integrals of their contributions to be
+  //evaluated together with GaussOnSphere::circleIntegralMany. Shared by both
+  //calcCrossSections methods to guarantee identical results. Contributions are
+  //appended in the order in which they were added, just like if they had been
+  //evaluated one at a time:
+  class GaussMos_CandidateBatch : private NoCopyMove {
+  public:
+    GaussMos_CandidateBatch( const GaussMos& gm, GaussMos::InteractionPars& ip,
+                             std::vector<GaussMos::ScatCache>* cache,
+                             VectD* xs_commul, double xsoffset )
+      : m_gm(gm), m_ip(ip), m_cache(cache), m_xs_commul(xs_commul), m_xsoffset(xsoffset)
+    {
+    }
+
+    //Normals are identified by their index (only looked up for contributing
+    //entries when flushing):
+    template<class TGetNormal>
+    void addContribs( const TGetNormal& getNormal, std::size_t inormal,
+                      double dot, double sdotcptsq, double ds, double cta )
+    {
+      double Am = ncmax( 0.0, cta - ds );
+      if ( sdotcptsq > Am*Am ) {
+        //anti-normal is within truncated Gauss
+        add( getNormal, dot, 2*inormal+1 );
+      }
+      double Ap = ncmax( 0.0, cta + ds );
+      if ( sdotcptsq > Ap*Ap ) {
+        //normal is within truncated Gauss
+        add( getNormal, -dot, 2*inormal );
+      }
+    }
+
+    //Process remaining entries and return the summed cross section:
+    template<class TGetNormal>
+    double finish( const TGetNormal& getNormal )
+    {
+      flush( getNormal );
+      return m_xssum;
+    }
+
+  private:
+    static constexpr std::size_t nmax = 32;
+    const GaussMos& m_gm;
+    GaussMos::InteractionPars& m_ip;
+    std::vector<GaussMos::ScatCache>* m_cache;//null if not recording
+    VectD* m_xs_commul;//null if not recording
+    const double m_xsoffset;
+    double m_xssum = 0.0;
+    std::size_t m_n = 0;
+    double m_cosangles[nmax];
+    double m_xs[nmax];
+    std::size_t m_keys[nmax];//2*normal_index+(1 for anti-normal)
+
+    template<class TGetNormal>
+    void add( const TGetNormal& getNormal, double cos_angle_indir_normal, std::size_t key )
+    {
+      m_cosangles[m_n] = cos_angle_indir_normal;
+      m_keys[m_n] = key;
+      if ( ++m_n == nmax )
+        flush( getNormal );
+    }
+
+    template<class TGetNormal>
+    void flush( const TGetNormal& getNormal )
+    {
+      if ( !m_n )
+        return;
+      m_gm.calcRawCrossSectionValues( m_ip, Span<const double>( &m_cosangles[0], &m_cosangles[0] + m_n ),
+                                      Span<double>( &m_xs[0], &m_xs[0] + m_n ) );
+      if ( !m_cache ) {
+        for ( std::size_t i = 0; i < m_n; ++i )
+          m_xssum += m_xs[i];
+        m_n = 0;
+        return;
+      }
+      for ( std::size_t i = 0; i < m_n; ++i ) {
+        const double xs = m_xs[i];
+        if (xs) {
+          m_xs_commul->push_back(m_xsoffset + (m_xssum += xs));
+          const std::size_t key = m_keys[i];
+          if ( key & 1 )
+            m_cache->emplace_back( -getNormal( key >> 1 ), m_ip.m_inv2dsp );
+          else
+            m_cache->emplace_back( getNormal( key >> 1 ), m_ip.m_inv2dsp );
+        }
+      }
+      m_n = 0;
+    }
+  };
+}
+
 double NC::GaussMos::calcCrossSections( InteractionPars& ip,
                                         const NC::Vector& indir,
                                         const std::vector<NC::Vector>& deminormals,
                                         std::vector<NC::GaussMos::ScatCache>& cache,
                                         VectD& xs_commul ) const
+{
+  return calcCrossSectionsImpl( ip, indir, deminormals, &cache, &xs_commul );
+}
+
+double NC::GaussMos::calcTotalCrossSection( InteractionPars& ip,
+                                            const NC::Vector& indir,
+                                            const std::vector<NC::Vector>& deminormals ) const
+{
+  return calcCrossSectionsImpl( ip, indir, deminormals, nullptr, nullptr );
+}
+
+double NC::GaussMos::calcCrossSectionsImpl( InteractionPars& ip,
+                                            const NC::Vector& indir,
+                                            const std::vector<NC::Vector>& deminormals,
+                                            std::vector<NC::GaussMos::ScatCache>* cache,
+                                            VectD* xs_commul ) const
 {
   nc_assert(ip.isValid()&&ip.m_wl>0);
   nc_assert(indir.isUnitVector());
+  nc_assert( ( cache == nullptr ) == ( xs_commul == nullptr ) );
   std::vector<Vector>::const_iterator it(deminormals.begin()), itE(deminormals.end());
-  double xsoffset = xs_commul.empty() ? 0.0 : xs_commul.back();
-  double xssum(0.0);
+  GaussMos_CandidateBatch batch( *this, ip, cache, xs_commul, ( !xs_commul || xs_commul->empty() ) ? 0.0 : xs_commul->back() );
   const double cptsq = ip.m_cos_perfect_theta_sq;
   const double cta = m_gos.getCosTruncangle();
+  auto getNormal = [&deminormals]( std::size_t i ) -> const Vector& { return deminormals[i]; };
   for(;it!=itE;++it) {
     const Vector& normal = *it;
     const double dot = normal.dot(indir);
@@ -172,27 +336,127 @@ double NC::GaussMos::calcCrossSections( InteractionPars& ip,
       continue;
 
     //At least one of the two normals should contribute, so deal with them:
-    double Am = ncmax( 0.0, cta - ds );
-    if ( sdotcptsq > Am*Am ) {
-      //anti-normal is within truncated Gauss
-      double xs = calcRawCrossSectionValue(ip, dot );
-      if (xs) {
-        xs_commul.push_back(xsoffset + (xssum += xs));
-        cache.emplace_back(-normal, ip.m_inv2dsp);
-      }
+    batch.addContribs( getNormal, static_cast<std::size_t>( it - deminormals.begin() ),
+                       dot, sdotcptsq, ds, cta );
+  }
+  return batch.finish( getNormal );
+}
+
+NC::GaussMos::NormalsSoA::NormalsSoA( std::size_t n )
+  : m_size( n )
+{
+  if ( !n )
+    return;
+  //Pad each array, so they all start at aligned addresses:
+  constexpr std::size_t nalign = alignment / sizeof(double);
+  static_assert( nalign * sizeof(double) == alignment, "" );
+  m_stride = ( ( m_size + nalign - 1 ) / nalign ) * nalign;
+  m_data.reset( static_cast<double*>( alignedAlloc( alignment, 3 * m_stride * sizeof(double) ) ) );
+  std::fill( m_data.get(), m_data.get() + 3 * m_stride, 0.0 );
+}
+
+NC::GaussMos::NormalsSoA::NormalsSoA( const std::vector<Vector>& normals )
+  : NormalsSoA( normals.size() )
+{
+  for ( std::size_t i = 0; i < m_size; ++i )
+    set( i, normals[i] );
+}
+
+double NC::GaussMos::calcCrossSections( InteractionPars& ip,
+                                        const NC::Vector& indir,
+                                        const NormalsSoA& deminormals,
+                                        std::vector<NC::GaussMos::ScatCache>& cache,
+                                        VectD& xs_commul ) const
+{
+  return calcCrossSections( ip, indir, deminormals, 0, deminormals.size(), cache, xs_commul );
+}
+
+double NC::GaussMos::calcCrossSections( InteractionPars& ip,
+                                        const NC::Vector& indir,
+                                        const NormalsSoA& deminormals,
+                                        std::size_t ibegin, std::size_t iend,
+                                        std::vector<NC::GaussMos::ScatCache>& cache,
+                                        VectD& xs_commul ) const
+{
+  return calcCrossSectionsImpl( ip, indir, deminormals, ibegin, iend, &cache, &xs_commul );
+}
+
+double NC::GaussMos::calcTotalCrossSection( InteractionPars& ip,
+                                            const NC::Vector& indir,
+                                            const NormalsSoA& deminormals,
+                                            std::size_t ibegin, std::size_t iend ) const
+{
+  return calcCrossSectionsImpl( ip, indir, deminormals, ibegin, iend, nullptr, nullptr );
+}
+
+double NC::GaussMos::calcCrossSectionsImpl( InteractionPars& ip,
+                                            const NC::Vector& indir,
+                                            const NormalsSoA& deminormals,
+                                            std::size_t ibegin, std::size_t iend,
+                                            std::vector<NC::GaussMos::ScatCache>* cache,
+                                            VectD* xs_commul ) const
+{
+  nc_assert(ip.isValid()&&ip.m_wl>0);
+  nc_assert(indir.isUnitVector());
+  nc_assert( ( cache == nullptr ) == ( xs_commul == nullptr ) );
+  GaussMos_CandidateBatch batch( *this, ip, cache, xs_commul, ( !xs_commul || xs_commul->empty() ) ? 0.0 : xs_commul->back() );
+  const double cptsq = ip.m_cos_perfect_theta_sq;
+  const double spt = ip.m_sin_perfect_theta;
+  const double cta = m_gos.getCosTruncangle();
+  const double ux = indir.x(), uy = indir.y(), uz = indir.z();
+  auto getNormal = [&deminormals]( std::size_t i ) { return deminormals.at(i); };
+
+  nc_assert( ibegin <= iend && iend <= deminormals.size() );
+  const std::size_t n = iend;
+  const double * xx = deminormals.x();
+  const double * yy = deminormals.y();
+  const double * zz = deminormals.z();
+  std::size_t i = ibegin;
+#if defined(__AVX2__) || defined(__AVX512F__)
+  //With wide vector registers available, normals are processed in blocks,
+  //with the combined truncation check performed for all normals in the block
+  //in a branch-free loop suitable for auto-vectorisation. Only the (usually
+  //few) normals passing the check are subsequently handled one at a
+  //time. With only SSE2 this was found to be slower than the simple loop
+  //below, so the block loop is only used for builds with AVX2 or AVX-512
+  //enabled (e.g. via -march=native). The arithmetic is the same in both
+  //cases, and each lane is computed independently, so results are
+  //bit-for-bit identical (as long as the compiler does not contract
+  //operations into FMA instructions, cf. the STRICT_FP CMake option):
+  constexpr std::size_t nblock = NormalsSoA::alignment / sizeof(double);
+  double dots[nblock];
+  double sdotcptsqs[nblock];
+  double excess[nblock];
+  for ( ; i + nblock <= n; i += nblock ) {
+    //For finite values, a>b is equivalent to a-b>0, so the combined check is
+    //unchanged:
+    for ( std::size_t k = 0; k < nblock; ++k ) {
+      const double dot = xx[i+k]*ux + yy[i+k]*uy + zz[i+k]*uz;
+      const double sdotcptsq = (1.0 - dot * dot)*cptsq;
+      const double A0raw = cta - std::fabs(dot * spt);
+      const double A0 = 0.5 * ( A0raw + std::fabs(A0raw) );//branch-free ncmax(0.0,A0raw)
+      dots[k] = dot;
+      sdotcptsqs[k] = sdotcptsq;
+      excess[k] = sdotcptsq - A0*A0;
     }
-    double Ap = ncmax( 0.0, cta + ds );
-    if ( sdotcptsq > Ap*Ap ) {
-      //normal is within truncated Gauss
-      double xs = calcRawCrossSectionValue(ip, -dot );
-      if (xs) {
-        xs_commul.push_back(xsoffset + (xssum += xs));
-        cache.emplace_back(normal, ip.m_inv2dsp);
-      }
+    for ( std::size_t k = 0; k < nblock; ++k ) {
+      if ( !( excess[k] > 0.0 ) )
+        continue;
+      batch.addContribs( getNormal, i+k, dots[k], sdotcptsqs[k], dots[k] * spt, cta );
     }
-
   }
-  return xssum;
+#endif
+  //Remaining normals (all of them, without AVX):
+  for ( ; i < n; ++i ) {
+    const double dot = xx[i]*ux + yy[i]*uy + zz[i]*uz;
+    double sdotcptsq = (1.0 - dot * dot)*cptsq;
+    double ds = dot * spt;
+    double A0 = ncmax( 0.0, cta - ncabs(ds) );
+    if ( sdotcptsq <= A0*A0 )
+      continue;
+    batch.addContribs( getNormal, i, dot, sdotcptsq, ds, cta );
+  }
+  return batch.finish( getNormal );
 }
 
 void NC::GaussMos::genScat( RNG& rng, const ScatCache& cache, double wl_raw, const NC::Vector& indir, NC::Vector& outdir) const
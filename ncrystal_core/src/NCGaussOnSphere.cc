@@ -21,7 +21,9 @@
 #include "NCrystal/internal/NCGaussOnSphere.hh"
 #include "NCrystal/internal/NCRomberg.hh"
 #include "NCrystal/internal/NCRandUtils.hh"
+#include "NCrystal/internal/NCFactoryUtils.hh"
 #include <iostream>
+#include <sstream>
 #include <cstdlib>
 namespace NC = NCrystal;
 
@@ -75,7 +77,7 @@ namespace NCrystal {
 
     virtual double evalFunc(double) const {
       //Must be implemented, but should never be called since we provide
-      //evalFuncMany+evalFuncManySum.
+      //evalFuncMany.
       nc_assert_always(false);
     }
 
@@ -90,24 +92,10 @@ namespace NCrystal {
       do {
         double cb = m_sasg * grid.current_cosval() + m_cacg;
         nc_assert(NC::ncabs(cb)<1.000000001);
-        fvals[i++] = m_gos->evalCosXInRange(cb);
+        fvals[i++] = cb;
       } while (grid.step());
-    }
-
-    virtual double evalFuncManySum(unsigned n, double offset, double delta) const
-    {
-      if (m_nevals)
-        m_nevals += n;
-      nc_assert(offset>=0&&offset<kPi*1.00001);
-      nc_assert(delta>0&&delta*n<=kPi*1.00001);
-      CosSinGridGen grid(n,offset,delta);
-      double sum(0.);
-      do {
-        double cb = m_sasg * grid.current_cosval() + m_cacg;
-        nc_assert(NC::ncabs(cb)<1.000000001);
-        sum += m_gos->evalCosXInRange(cb);
-      } while (grid.step());
-      return sum;
+      Span<double> fv( fvals, fvals + n );
+      m_gos->evalCosXInRangeMany( fv, fv );
     }
 
     virtual bool accept(unsigned level, double prev_estimate, double estimate, double a, double b) const
@@ -371,6 +359,234 @@ void NC::GaussOnSphere::set(double sigma, double trunc_angle, double prec ) {
 
   m_lt_sofcosd.swap(lt_sofcosd);
   m_lt_evalcosx.swap(lt_evalcosx);
+  updateCircleIntegralTable();
+}
+
+class NC::GaussOnSphere::CircleIntegralTable : private MoveOnly {
+public:
+  //Table of circleIntegral(..)/sin(alpha) in the region where the
+  //approximation formula can not be used, as a function of alpha and
+  //gamma. Using delta=gamma-alpha, all non-vanishing values are found for
+  //|delta|<truncangle, and the approximation formula is valid whenever both
+  //alpha and gamma are larger than a certain angle s0 (see below). The table
+  //thus covers alpha in [0,s0+truncangle] and delta in
+  //[-truncangle,truncangle]. To better capture the structure of the
+  //function, the grid is uniform in sqrt(alpha) and in phi=acos(-delta/truncangle),
+  //and values are bilinearly interpolated. The grid is refined until
+  //interpolation errors at all cell edge midpoints are below 0.5*prec
+  //relative to the maximal value in the table (or twice the accuracy of the
+  //numerical integration, if that is larger).
+  explicit CircleIntegralTable( const GaussOnSphere& );
+  bool isValid() const { return !m_vals.empty(); }
+  double lookup( double alpha, double gamma ) const
+  {
+    //Returns -1.0 if outside table:
+    nc_assert(isValid());
+    const double fa = std::sqrt( alpha * m_inv_alphamax ) * m_na_m1;
+    const double cosphi = ( alpha - gamma ) * m_inv_truncangle;
+    if ( !( fa < m_na_m1 ) || !( ncabs(cosphi) <= 1.0 ) )
+      return -1.0;
+    const double fp = std::acos( cosphi ) * m_np_m1_over_pi;
+    const std::size_t ia = static_cast<std::size_t>(fa);
+    const std::size_t ip = std::min<std::size_t>( m_np - 2, static_cast<std::size_t>(fp) );
+    const double ta = fa - ia;
+    const double tp = fp - ip;
+    const double * v = &m_vals[ ia * m_np + ip ];
+    return ( 1.0 - ta ) * ( ( 1.0 - tp ) * v[0] + tp * v[1] )
+      + ta * ( ( 1.0 - tp ) * v[m_np] + tp * v[m_np+1] );
+  }
+private:
+  VectD m_vals;
+  std::size_t m_np = 0;
+  double m_na_m1 = 0.0;
+  double m_np_m1_over_pi = 0.0;
+  double m_inv_alphamax = 0.0;
+  double m_inv_truncangle = 0.0;
+};
+
+NC::GaussOnSphere::CircleIntegralTable::CircleIntegralTable( const GaussOnSphere& gos )
+{
+  nc_assert_always( !gos.m_citable );
+  nc_assert_always( gos.m_prec < 1.0 );
+  nc_assert_always( gos.m_circleint_k1 < 1.0 );
+  const double truncangle = gos.m_truncangle;
+  //The approximation formula is used when
+  //k1*sin(alpha)*sin(gamma)+cos(alpha)*cos(gamma)<k2 where k2=cos(truncangle)-1e-5,
+  //or equivalently (with delta=gamma-alpha):
+  //(1-k1)*sin(alpha)*sin(gamma) > cos(delta)-k2. Since cos(delta)<=1, it is
+  //sufficient that sin(alpha)*sin(gamma)>(1-k2)/(1-k1), which is certainly
+  //the case if both angles are above s0:
+  const double s0 = std::asin( ncmin( 1.0, std::sqrt( ( 1.0 - gos.m_circleint_k2 ) / ( 1.0 - gos.m_circleint_k1 ) ) ) );
+  const double alphamax = ncmin( kPiHalf, s0 + truncangle );
+
+  auto evalPt = [&gos,truncangle,alphamax]( double fa, double fp )
+  {
+    //fa and fp are fractional positions in [0,1]:
+    const double alpha = alphamax * fa * fa;
+    //NB: The integral is symmetric in gamma, so use |gamma| at the edge of the
+    //table where gamma<0:
+    const double gamma = ncabs( alpha - truncangle * std::cos( kPi * fp ) );
+    double ca, sa, cg, sg;
+    sincos( alpha, ca, sa );
+    sincos( gamma, cg, sg );
+    if ( !( sa > 0.0 ) )
+      return k2Pi * gos.evalCosX( cg );//limit of circleIntegral/sin(alpha) for alpha->0
+    return gos.circleIntegralSlow( cg, sg, ca, sa ) / sa;
+  };
+
+  constexpr std::size_t nmax = 2097152;//2M entries (16MB)
+  std::size_t na = 17;
+  std::size_t np = 17;
+  VectD vals;
+  vals.reserve( na * np );
+  for ( std::size_t i = 0; i < na; ++i )
+    for ( std::size_t j = 0; j < np; ++j )
+      vals.push_back( evalPt( double(i) / ( na - 1 ), double(j) / ( np - 1 ) ) );
+
+  //Tolerance (no need to go much below the accuracy of the numerical
+  //integrations themselves):
+  const double tol = ncmax( 0.5 * gos.m_prec, 2.0 * gos.m_numint_accuracy );
+  VectD mida, midp;
+  while ( true ) {
+    const double vmax = *std::max_element( vals.begin(), vals.end() );
+    if ( !( vmax > 0.0 ) )
+      return;//should not happen
+    //Check interpolation errors at midpoints along each direction. The
+    //midpoint values are kept, since they become nodes in case of
+    //refinement:
+    mida.clear();
+    midp.clear();
+    double erra(0.0), errp(0.0);
+    for ( std::size_t i = 0; i + 1 < na; ++i ) {
+      for ( std::size_t j = 0; j < np; ++j ) {
+        mida.push_back( evalPt( ( i + 0.5 ) / ( na - 1 ), double(j) / ( np - 1 ) ) );
+        erra = ncmax( erra, ncabs( mida.back() - 0.5 * ( vals[i*np+j] + vals[(i+1)*np+j] ) ) );
+      }
+    }
+    for ( std::size_t i = 0; i < na; ++i ) {
+      for ( std::size_t j = 0; j + 1 < np; ++j ) {
+        midp.push_back( evalPt( double(i) / ( na - 1 ), ( j + 0.5 ) / ( np - 1 ) ) );
+        errp = ncmax( errp, ncabs( midp.back() - 0.5 * ( vals[i*np+j] + vals[i*np+j+1] ) ) );
+      }
+    }
+    const bool refine_a = erra > tol * vmax;
+    const bool refine_p = errp > tol * vmax;
+    if ( !refine_a && !refine_p )
+      break;
+    const std::size_t na2 = ( refine_a ? 2 * na - 1 : na );
+    const std::size_t np2 = ( refine_p ? 2 * np - 1 : np );
+    if ( na2 * np2 > nmax )
+      return;//give up, leaving table invalid
+    VectD vals2;
+    vals2.reserve( na2 * np2 );
+    for ( std::size_t i2 = 0; i2 < na2; ++i2 ) {
+      const bool odd_a = refine_a && ( i2 % 2 );
+      const std::size_t i = ( refine_a ? i2 / 2 : i2 );
+      for ( std::size_t j2 = 0; j2 < np2; ++j2 ) {
+        const bool odd_p = refine_p && ( j2 % 2 );
+        const std::size_t j = ( refine_p ? j2 / 2 : j2 );
+        if ( odd_a && odd_p )
+          vals2.push_back( evalPt( double(i2) / ( na2 - 1 ), double(j2) / ( np2 - 1 ) ) );
+        else if ( odd_a )
+          vals2.push_back( mida[i*np+j] );
+        else if ( odd_p )
+          vals2.push_back( midp[i*(np-1)+j] );
+        else
+          vals2.push_back( vals[i*np+j] );
+      }
+    }
+    vals.swap( vals2 );
+    na = na2;
+    np = np2;
+  }
+
+  m_vals = std::move( vals );
+  m_np = np;
+  m_na_m1 = na - 1.0;
+  m_np_m1_over_pi = ( np - 1.0 ) / kPi;
+  m_inv_alphamax = 1.0 / alphamax;
+  m_inv_truncangle = 1.0 / truncangle;
+}
+
+namespace NCrystal {
+  namespace {
+    //Tables depend only on (sigma,truncangle,prec), so they can be shared:
+    using GOSCITableKey = std::tuple<double,double,double>;
+    template<class TTable>
+    class GOSCITableFactory : public CachedFactoryBase<GOSCITableKey,TTable> {
+      using base = CachedFactoryBase<GOSCITableKey,TTable>;
+    public:
+      const char* factoryName() const final { return "GOSCircleIntegralTableFactory"; }
+      std::string keyToString( const GOSCITableKey& key ) const final
+      {
+        std::ostringstream ss;
+        ss<<"(sigma="<<std::get<0>(key)<<";truncangle="<<std::get<1>(key)<<";prec="<<std::get<2>(key)<<")";
+        return ss.str();
+      }
+    protected:
+      typename base::ShPtr actualCreate( const GOSCITableKey& key ) const final
+      {
+        GaussOnSphere gos( std::get<0>(key), std::get<1>(key), std::get<2>(key) );
+        return std::make_shared<const TTable>( gos );
+      }
+    };
+  }
+}
+
+void NC::GaussOnSphere::enableCircleIntegralTable()
+{
+  m_citable_enabled = true;
+  updateCircleIntegralTable();
+}
+
+void NC::GaussOnSphere::updateCircleIntegralTable()
+{
+  m_citable.reset();
+  if ( !m_citable_enabled || !isValid() || !( m_prec < 1.0 ) || !( m_circleint_k1 < 1.0 ) )
+    return;
+  static GOSCITableFactory<CircleIntegralTable> s_factory;
+  auto table = s_factory.create( GOSCITableKey( m_sigma, m_truncangle, m_prec ) );
+  if ( table->isValid() )
+    m_citable = std::move(table);
+}
+
+void NC::GaussOnSphere::circleIntegralMany( Span<const double> cosgammas, double ca, double sa,
+                                            Span<double> out ) const
+{
+  nc_assert(isValid());
+  nc_assert(ncabs(ca*ca+sa*sa-1.0)<1e-6);
+  nc_assert(cosgammas.size()==out.size());
+  constexpr std::size_t nchunk = 32;
+  double cds[nchunk];
+  double sgs[nchunk];
+  std::size_t fastidx[nchunk];
+  const std::size_t n = out.size();
+  for ( std::size_t ichunk = 0; ichunk < n; ichunk += nchunk ) {
+    const std::size_t iend = ncmin( n, ichunk + nchunk );
+    //First find the circles where the approximation formula can be used (see
+    //circleIntegral), and handle the special cases directly:
+    std::size_t nfast = 0;
+    for ( std::size_t i = ichunk; i < iend; ++i ) {
+      const double cg = cosgammas[i];
+      const double sg = std::sqrt(1.0-cg*cg);
+      const double sasg = sa*sg; nc_assert(sasg>=0.0);
+      const double cacg = ca*cg;
+      const double cd = cacg+sasg;
+      if (cd>m_cta&&sasg>=1e-14&&m_circleint_k2 > m_circleint_k1*sasg+cacg) {
+        cds[nfast] = cd;
+        sgs[nfast] = sg;
+        fastidx[nfast++] = i;
+      } else {
+        NCRYSTAL_COUNT(GOSCircleIntSlow);
+        out[i] = circleIntegralSlow( cg,sg,ca,sa );
+      }
+    }
+    //And then the rest with a batched lookup:
+    Span<double> cdspan( &cds[0], &cds[0] + nfast );
+    m_lt_sofcosd.evalMany( cdspan, cdspan );
+    for ( std::size_t j = 0; j < nfast; ++j )
+      out[fastidx[j]] = cds[j]*std::sqrt(sa/sgs[j]);
+  }
 }
 
 double NC::GaussOnSphere::circleIntegralSlow( double cg, double sg, double ca, double sa ) const
@@ -391,7 +607,14 @@ double NC::GaussOnSphere::circleIntegralSlow( double cg, double sg, double ca, d
     return k2Pi*sa*evalCosX(ca);
   }
 
+  if ( m_citable ) {
+    double h = m_citable->lookup( std::atan2(sa,ca), std::atan2(sg,cg) );
+    if ( h >= 0.0 )
+      return sa * h;
+  }
+
   //full numerical integration required:
+  NCRYSTAL_COUNT(GOSCircleIntNumInt);
   nc_assert(sasg>0);
   double cos_tmax =  (m_cta-cacg)/sasg;
   double tmax = ( cos_tmax<=-1.0 ? kPi : std::acos(NC::ncmin(1.0,cos_tmax)) );
@@ -457,6 +680,48 @@ bool NC::GaussOnSphere::genPointOnCircle( RNG& rng, double cg, double sg, double
   double cos_tmax =  (m_cta-cacg)/sasg;
   if (cos_tmax>=1.0)//vanishing length of circle inside truncation zone
     return false;
+
+  //When the Gaussian is narrow compared to the circle, most of the density is
+  //concentrated near t=0 and uniform proposals for t are inefficient
+  //(acceptance rate around 37%, independently of the mosaicity). Instead, use
+  //that 1-cos(delta) <= delta^2/2, so with u=1-cos(t) and cos(delta)=cd-sasg*u
+  //the density is bounded from above by F(u)=norm*exp(-(1-cd+sasg*u)/sigma^2).
+  //Changing variables to v=sqrt(u), the density of t implied by F(u) is
+  //proportional to exp(-k*v^2)/sqrt(2-u) with k=sasg/sigma^2, so v can be
+  //sampled directly from a Gaussian, leaving only the approximation of delta^2
+  //and the 1/sqrt(2-u) factor for the rejection step. Restricting this to
+  //u<=1 (i.e. t<=pi/2), acceptance rates are typically around 90%:
+  const double umax = 1.0 - ncmax( -1.0, cos_tmax );
+  const double k = -2.0 * m_expfact * sasg;//m_expfact = -1/(2*sigma^2)
+  if ( umax <= 1.0 && k * umax >= 1.0 ) {
+    const double inv2k = 0.5 / k;
+    const double fexpfact = 2.0 * m_expfact;
+    const double cmaj = 1.01 * m_norm;//1.01 is safety for lookup table imprecision
+    const double invsqrt2mumax = 1.0 / std::sqrt( 2.0 - umax );
+    int triesleft = 1001;
+    double g[2];
+    int ng = 0;
+    while (--triesleft) {
+      if ( !ng ) {
+        randNorm( rng, g[0], g[1] );
+        ng = 2;
+      }
+      const double gg = g[--ng];
+      const double u = gg * gg * inv2k;
+      if ( u > umax )
+        continue;
+      const double cd_at_u = ncmax( m_cta, cd - sasg * u );
+      const double maj = cmaj * exp_negarg_approx( fexpfact * ( 1.0 - cd_at_u ) ) * std::sqrt( 2.0 - u ) * invsqrt2mumax;
+      if ( evalCosXInRange( cd_at_u ) > maj * rng.generate() ) {
+        ct = 1.0 - u;
+        st = std::sqrt( u * ( 2.0 - u ) );
+        st = (rng.coinflip()?st:-st);//pick t in [-pi,pi], not just in [0,pi]
+        return true;
+      }
+    }
+    //Should essentially never happen, but fall back to the method below.
+  }
+
   double tmax = ( cos_tmax<=-1.0 ? kPi : std::acos(cos_tmax) );
 
   //The highest contribution is at t=0, at which cos(delta) = cd. Generate t via MC-rejection.
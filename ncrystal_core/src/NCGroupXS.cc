@@ -0,0 +1,261 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+//  This file is part of NCrystal (see https://mctools.github.io/ncrystal/)   //
+//                                                                            //
+//  Copyright 2015-2021 NCrystal developers                                   //
+//                                                                            //
+//  Licensed under the Apache License, Version 2.0 (the "License");           //
+//  you may not use this file except in compliance with the License.          //
+//  You may obtain a copy of the License at                                   //
+//                                                                            //
+//      http://www.apache.org/licenses/LICENSE-2.0                            //
+//                                                                            //
+//  Unless required by applicable law or agreed to in writing, software       //
+//  distributed under the License is distributed on an "AS IS" BASIS,         //
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  //
+//  See the License for the specific language governing permissions and       //
+//  limitations under the License.                                            //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include "NCrystal/internal/NCRomberg.hh"
+#include "NCrystal/internal/NCMath.hh"
+#include "NCrystal/internal/NCGroupXS.hh"
+#include "NCrystal/internal/NCPCBragg.hh"
+#include "NCrystal/internal/NCSABScatter.hh"
+#include "NCrystal/internal/NCRomberg.hh"
+#include "NCrystal/internal/NCThreadUtils.hh"
+#include "NCrystal/internal/NCMath.hh"
+#include <thread>
+
+namespace NC = NCrystal;
+
+namespace NCrystal {
+  namespace {
+
+    //Energies at which cross sections of the process have kinks or
+    //discontinuities:
+    void addKnots( const ProcImpl::Process& p, VectD& knots )
+    {
+      auto d = p.domain();
+      knots.push_back( d.elow.dbl() );
+      knots.push_back( d.ehigh.dbl() );
+      if ( auto pcbragg = dynamic_cast<const PCBragg*>( &p ) ) {
+        const auto& be = pcbragg->braggEdgeEnergies();
+        knots.insert( knots.end(), be.begin(), be.end() );
+      } else if ( auto sab = dynamic_cast<const SABScatter*>( &p ) ) {
+        sab->addXSGridEnergies( knots );
+      } else if ( auto sabt = dynamic_cast<const SABTInterpScatter*>( &p ) ) {
+        sabt->addXSGridEnergies( knots );
+      } else if ( auto pc = dynamic_cast<const ProcImpl::ProcComposition*>( &p ) ) {
+        for ( const auto& comp : pc->components() )
+          addKnots( *comp.process, knots );
+      } else if ( auto pp = dynamic_cast<const ProcImpl::ProfiledProcess*>( &p ) ) {
+        addKnots( pp->wrapped(), knots );
+      } else if ( auto at = dynamic_cast<const ProcImpl::AdaptiveTabulatedXS*>( &p ) ) {
+        addKnots( at->wrapped(), knots );
+      } else if ( auto lp = dynamic_cast<const ProcImpl::LazyProcess*>( &p ) ) {
+        addKnots( lp->process(), knots );
+      }
+    }
+
+    //Interval between knots, inside a single group. The flux is linear in
+    //between the end points, with values flux_a and flux_b:
+    struct Segment {
+      double ea, eb;
+      double flux_a, flux_b;
+      std::size_t group;
+      bool inDomain;
+    };
+
+    //Integrates xs(E)*flux(E)*E over u=ln(E):
+    class SegmentIntegrator final : public Romberg {
+    public:
+      SegmentIntegrator( const ProcImpl::Process& p, double precision, bool invEFlux )
+        : m_proc(p), m_precision(precision), m_invEFlux(invEFlux)
+      {
+      }
+
+      double integrate( const Segment& seg )
+      {
+        m_seg = &seg;
+        return integrateRange( seg.ea, seg.eb, 0 );
+      }
+
+      double evalFunc( double u ) const override
+      {
+        double f;
+        evalFuncMany( &f, 1, u, 0.0 );
+        return f;
+      }
+
+      void evalFuncMany( double* fvals, unsigned n, double offset, double delta ) const override
+      {
+        //Energies are clamped to the current range, using the limit from
+        //below at the upper end (Bragg edges are included at their own
+        //energy, so the cross section is only continuous from the right):
+        double ekin[maxBatchSize];
+        for ( unsigned i0 = 0; i0 < n; i0 += maxBatchSize ) {
+          const unsigned nb = std::min<unsigned>( maxBatchSize, n - i0 );
+          for ( unsigned i = 0; i < nb; ++i )
+            ekin[i] = ncclamp( std::exp( offset + delta * ( i0 + i ) ), m_ea, m_eb_below );
+          m_proc.evalManyXSIsotropic( m_cache, ekin, nb, fvals + i0 );
+          if ( !m_invEFlux ) {
+            const Segment& s = *m_seg;
+            const double slope = ( s.flux_b - s.flux_a ) / ( s.eb - s.ea );
+            for ( unsigned i = 0; i < nb; ++i )
+              fvals[i0+i] *= ( s.flux_a + slope * ( ekin[i] - s.ea ) ) * ekin[i];
+          }
+        }
+      }
+
+      bool accept( unsigned level, double prev_estimate, double estimate, double, double ) const override
+      {
+        if ( ncabs( estimate - prev_estimate ) <= m_precision * ncabs( estimate ) )
+          return true;
+        if ( level < maxlevel )
+          return false;
+        m_converged = false;
+        return true;
+      }
+
+      void convergenceError( double, double ) const override
+      {
+        //Never reached, since accept gives up at maxlevel.
+      }
+
+    private:
+      static constexpr unsigned maxlevel = 8;
+      static constexpr unsigned maxdepth = 30;
+      const ProcImpl::Process& m_proc;
+      double m_precision;
+      bool m_invEFlux;
+      const Segment * m_seg = nullptr;
+      double m_ea = 0.0;
+      double m_eb_below = 0.0;
+      mutable CachePtr m_cache;
+      mutable bool m_converged = true;
+
+      double integrateRange( double ea, double eb, unsigned depth )
+      {
+        m_ea = ea;
+        m_eb_below = ncmax( ea, std::nextafter( eb, 0.0 ) );
+        m_converged = true;
+        const double result = Romberg::integrate( std::log( ea ), std::log( eb ) );
+        if ( m_converged || depth >= maxdepth )
+          return result;
+        //Bisect (in ln(E)) and try again:
+        const double emid = std::sqrt( ea * eb );
+        if ( !( emid > ea && emid < eb ) )
+          return result;
+        return integrateRange( ea, emid, depth + 1 ) + integrateRange( emid, eb, depth + 1 );
+      }
+    };
+
+  }
+}
+
+NC::VectD NC::groupAveragedXS( const ProcImpl::Process& proc,
+                               const VectD& groupBounds,
+                               const VectD& fluxEnergies,
+                               const VectD& fluxValues,
+                               const GroupXSParams& params )
+{
+  if ( proc.materialType() != MaterialType::Isotropic )
+    NCRYSTAL_THROW(BadInput,"groupAveragedXS: only isotropic processes are supported.");
+  if ( !( params.precision > 0.0 && params.precision < 1.0 ) )
+    NCRYSTAL_THROW(BadInput,"groupAveragedXS: precision must be in the range (0,1).");
+  if ( groupBounds.size() < 2 )
+    NCRYSTAL_THROW(BadInput,"groupAveragedXS: at least two group bounds must be provided.");
+  for ( std::size_t i = 0; i < groupBounds.size(); ++i )
+    if ( !( groupBounds[i] > 0.0 && std::isfinite( groupBounds[i] ) )
+         || ( i > 0 && !( groupBounds[i] > groupBounds[i-1] ) ) )
+      NCRYSTAL_THROW(BadInput,"groupAveragedXS: group bounds must be positive, finite and strictly increasing.");
+
+  const bool invEFlux = fluxEnergies.empty();
+  if ( !invEFlux ) {
+    if ( fluxEnergies.size() < 2 || fluxEnergies.size() != fluxValues.size() )
+      NCRYSTAL_THROW(BadInput,"groupAveragedXS: flux table must have at least two points,"
+                     " and the same number of energies and values.");
+    for ( std::size_t i = 0; i < fluxEnergies.size(); ++i )
+      if ( !( fluxValues[i] >= 0.0 && std::isfinite( fluxValues[i] ) )
+           || ( i > 0 && !( fluxEnergies[i] > fluxEnergies[i-1] ) ) )
+        NCRYSTAL_THROW(BadInput,"groupAveragedXS: flux values must be non-negative and finite, and flux"
+                       " energies strictly increasing.");
+    if ( fluxEnergies.front() > groupBounds.front() || fluxEnergies.back() < groupBounds.back() )
+      NCRYSTAL_THROW(BadInput,"groupAveragedXS: flux table does not cover all groups.");
+  } else if ( !fluxValues.empty() ) {
+    NCRYSTAL_THROW(BadInput,"groupAveragedXS: flux values provided without energies.");
+  }
+
+  //All knots, sorted:
+  VectD knots;
+  addKnots( proc, knots );
+  knots.insert( knots.end(), fluxEnergies.begin(), fluxEnergies.end() );
+  std::sort( knots.begin(), knots.end() );
+  knots.erase( std::unique( knots.begin(), knots.end() ), knots.end() );
+
+  auto fluxAt = [&fluxEnergies,&fluxValues]( double e )
+  {
+    std::size_t i = std::upper_bound( fluxEnergies.begin(), fluxEnergies.end(), e ) - fluxEnergies.begin();
+    i = std::max<std::size_t>( 1, std::min<std::size_t>( i, fluxEnergies.size() - 1 ) );
+    const double t = ( e - fluxEnergies[i-1] ) / ( fluxEnergies[i] - fluxEnergies[i-1] );
+    return fluxValues[i-1] + t * ( fluxValues[i] - fluxValues[i-1] );
+  };
+
+  //Split groups into segments:
+  const std::size_t ngroups = groupBounds.size() - 1;
+  const EnergyDomain domain = proc.domain();
+  std::vector<Segment> segments;
+  for ( std::size_t g = 0; g < ngroups; ++g ) {
+    const double elow = groupBounds[g];
+    const double ehigh = groupBounds[g+1];
+    auto it = std::upper_bound( knots.begin(), knots.end(), elow );
+    double ea = elow;
+    while ( true ) {
+      const double eb = ( it != knots.end() && *it < ehigh ) ? *it++ : ehigh;
+      Segment s;
+      s.ea = ea;
+      s.eb = eb;
+      s.flux_a = invEFlux ? 0.0 : fluxAt( ea );
+      s.flux_b = invEFlux ? 0.0 : fluxAt( eb );
+      s.group = g;
+      s.inDomain = domain.contains( NeutronEnergy{ std::sqrt( ea * eb ) } );
+      segments.push_back( s );
+      if ( eb == ehigh )
+        break;
+      ea = eb;
+    }
+  }
+
+  //Integrate segments in parallel, in chunks sharing an integrator (and its
+  //cache):
+  unsigned nthreads = params.nthreads;
+  if ( nthreads == 0 )
+    nthreads = std::max<unsigned>( 1, std::thread::hardware_concurrency() );
+  constexpr std::size_t chunksize = 64;
+  const std::size_t nchunks = ( segments.size() + chunksize - 1 ) / chunksize;
+  VectD seg_xsflux( segments.size(), 0.0 );
+  parallelFor( nchunks, nthreads, [&]( std::size_t ichunk )
+  {
+    SegmentIntegrator integrator( proc, params.precision, invEFlux );
+    const std::size_t iend = std::min<std::size_t>( segments.size(), ( ichunk + 1 ) * chunksize );
+    for ( std::size_t i = ichunk * chunksize; i < iend; ++i )
+      if ( segments[i].inDomain )
+        seg_xsflux[i] = integrator.integrate( segments[i] );
+  } );
+
+  //Combine (in fixed order, so results do not depend on nthreads):
+  VectD num( ngroups, 0.0 ), denom( ngroups, 0.0 );
+  for ( std::size_t i = 0; i < segments.size(); ++i ) {
+    const Segment& s = segments[i];
+    num[s.group] += seg_xsflux[i];
+    denom[s.group] += ( invEFlux
+                        ? std::log( s.eb / s.ea )
+                        : 0.5 * ( s.flux_a + s.flux_b ) * ( s.eb - s.ea ) );
+  }
+  VectD result( ngroups );
+  for ( std::size_t g = 0; g < ngroups; ++g )
+    result[g] = ( denom[g] > 0.0 ? num[g] / denom[g] : 0.0 );
+  return result;
+}
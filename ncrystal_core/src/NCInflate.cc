@@ -0,0 +1,298 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+//  This file is part of NCrystal (see https://mctools.github.io/ncrystal/)   //
+//                                                                            //
+//  Copyright 2015-2021 NCrystal developers                                   //
+//                                                                            //
+//  Licensed under the Apache License, Version 2.0 (the "License");           //
+//  you may not use this file except in compliance with the License.          //
+//  You may obtain a copy of the License at                                   //
+//                                                                            //
+//      http://www.apache.org/licenses/LICENSE-2.0                            //
+//                                                                            //
+//  Unless required by applicable law or agreed to in writing, software       //
+//  distributed under the License is distributed on an "AS IS" BASIS,         //
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  //
+//  See the License for the specific language governing permissions and       //
+//  limitations under the License.                                            //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include "NCrystal/internal/NCDebyeMSD.hh"
+#include "NCrystal/internal/NCMath.hh"
+
+#include "NCrystal/internal/NCInflate.hh"
+
+namespace NC = NCrystal;
+
+namespace NCrystal {
+  namespace {
+
+    //Decoder closely following the structure of Mark Adler's "puff" reference
+    //implementation: canonical Huffman codes are decoded a bit at a time, which
+    //is plenty fast for one-off unpacking of data files.
+
+    constexpr unsigned inflate_maxbits = 15;
+    constexpr unsigned inflate_maxlcodes = 286;
+    constexpr unsigned inflate_maxdcodes = 30;
+    constexpr unsigned inflate_fixlcodes = 288;
+
+    struct InflateHuffman {
+      short count[inflate_maxbits+1];
+      short symbol[inflate_fixlcodes];
+    };
+
+    class InflateState {
+    public:
+      InflateState( const unsigned char* data, std::size_t n, std::size_t expected_size )
+        : m_in(data), m_inlen(n), m_expected(expected_size)
+      {
+        m_out.reserve(expected_size);
+      }
+
+      std::string inflate()
+      {
+        unsigned last;
+        do {
+          last = bits(1);
+          const unsigned type = bits(2);
+          if ( type == 0 )
+            stored();
+          else if ( type == 1 )
+            fixed();
+          else if ( type == 2 )
+            dynamic();
+          else
+            fail("invalid block type");
+        } while ( !last );
+        if ( m_out.size() != m_expected )
+          fail("unexpected size of decompressed data");
+        return std::move(m_out);
+      }
+
+    private:
+      const unsigned char* m_in;
+      std::size_t m_inlen;
+      std::size_t m_incnt = 0;
+      std::size_t m_expected;
+      std::uint32_t m_bitbuf = 0;
+      unsigned m_bitcnt = 0;
+      std::string m_out;
+
+      [[noreturn]] static void fail( const char * what )
+      {
+        NCRYSTAL_THROW2(BadInput,"Corrupt compressed data stream ("<<what<<")");
+      }
+
+      unsigned bits( unsigned need )
+      {
+        std::uint32_t val = m_bitbuf;
+        while ( m_bitcnt < need ) {
+          if ( m_incnt == m_inlen )
+            fail("premature end of input");
+          val |= static_cast<std::uint32_t>(m_in[m_incnt++]) << m_bitcnt;
+          m_bitcnt += 8;
+        }
+        m_bitbuf = val >> need;
+        m_bitcnt -= need;
+        return static_cast<unsigned>( val & ((1UL << need) - 1) );
+      }
+
+      void putByte( char c )
+      {
+        if ( m_out.size() >= m_expected )
+          fail("decompressed data exceeds expected size");
+        m_out.push_back(c);
+      }
+
+      void stored()
+      {
+        //Discard leftover bits from current byte:
+        m_bitbuf = 0;
+        m_bitcnt = 0;
+        if ( m_incnt + 4 > m_inlen )
+          fail("premature end of input");
+        unsigned len = m_in[m_incnt] | ( m_in[m_incnt+1] << 8 );
+        const unsigned nlen = m_in[m_incnt+2] | ( m_in[m_incnt+3] << 8 );
+        m_incnt += 4;
+        if ( len != ( ~nlen & 0xffff ) )
+          fail("stored block length mismatch");
+        if ( m_incnt + len > m_inlen )
+          fail("premature end of input");
+        if ( m_out.size() + len > m_expected )
+          fail("decompressed data exceeds expected size");
+        m_out.append( reinterpret_cast<const char*>(m_in + m_incnt), len );
+        m_incnt += len;
+      }
+
+      int decode( const InflateHuffman& h )
+      {
+        int code = 0, first = 0, index = 0;
+        for ( unsigned len = 1; len <= inflate_maxbits; ++len ) {
+          code |= static_cast<int>(bits(1));
+          const int count = h.count[len];
+          if ( code - count < first )
+            return h.symbol[ index + ( code - first ) ];
+          index += count;
+          first += count;
+          first <<= 1;
+          code <<= 1;
+        }
+        fail("invalid Huffman code");
+      }
+
+      //Returns 0 for a complete code, >0 for an incomplete one and <0 for an
+      //over-subscribed (invalid) one.
+      static int construct( InflateHuffman& h, const short* length, unsigned n )
+      {
+        for ( unsigned len = 0; len <= inflate_maxbits; ++len )
+          h.count[len] = 0;
+        for ( unsigned symbol = 0; symbol < n; ++symbol )
+          ++h.count[length[symbol]];
+        if ( h.count[0] == static_cast<short>(n) )
+          return 0;
+        int left = 1;
+        for ( unsigned len = 1; len <= inflate_maxbits; ++len ) {
+          left <<= 1;
+          left -= h.count[len];
+          if ( left < 0 )
+            return left;
+        }
+        short offs[inflate_maxbits+1];
+        offs[1] = 0;
+        for ( unsigned len = 1; len < inflate_maxbits; ++len )
+          offs[len+1] = static_cast<short>( offs[len] + h.count[len] );
+        for ( unsigned symbol = 0; symbol < n; ++symbol )
+          if ( length[symbol] != 0 )
+            h.symbol[ offs[length[symbol]]++ ] = static_cast<short>(symbol);
+        return left;
+      }
+
+      void codes( const InflateHuffman& lencode, const InflateHuffman& distcode )
+      {
+        static const short lbase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+                                         35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+        static const short lext[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+                                        3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+        static const short dbase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+                                         257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+                                         8193, 12289, 16385, 24577 };
+        static const short dext[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+                                        7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+        while ( true ) {
+          int symbol = decode(lencode);
+          if ( symbol < 256 ) {
+            putByte( static_cast<char>(static_cast<unsigned char>(symbol)) );
+            continue;
+          }
+          if ( symbol == 256 )
+            return;//end of block
+          symbol -= 257;
+          if ( symbol >= 29 )
+            fail("invalid length symbol");
+          const std::size_t len = lbase[symbol] + bits(lext[symbol]);
+          symbol = decode(distcode);
+          if ( symbol < 0 || symbol >= 30 )
+            fail("invalid distance symbol");
+          const std::size_t dist = dbase[symbol] + bits(dext[symbol]);
+          if ( dist > m_out.size() )
+            fail("distance too far back");
+          if ( m_out.size() + len > m_expected )
+            fail("decompressed data exceeds expected size");
+          //Byte-wise copy since source and destination may overlap:
+          std::size_t from = m_out.size() - dist;
+          for ( std::size_t i = 0; i < len; ++i )
+            m_out.push_back( m_out[from++] );
+        }
+      }
+
+      void fixed()
+      {
+        static const std::pair<InflateHuffman,InflateHuffman> tables = []()
+        {
+          std::pair<InflateHuffman,InflateHuffman> res;
+          short lengths[inflate_fixlcodes];
+          unsigned symbol = 0;
+          for ( ; symbol < 144; ++symbol )
+            lengths[symbol] = 8;
+          for ( ; symbol < 256; ++symbol )
+            lengths[symbol] = 9;
+          for ( ; symbol < 280; ++symbol )
+            lengths[symbol] = 7;
+          for ( ; symbol < inflate_fixlcodes; ++symbol )
+            lengths[symbol] = 8;
+          construct( res.first, lengths, inflate_fixlcodes );
+          for ( symbol = 0; symbol < inflate_maxdcodes; ++symbol )
+            lengths[symbol] = 5;
+          construct( res.second, lengths, inflate_maxdcodes );
+          return res;
+        }();
+        codes( tables.first, tables.second );
+      }
+
+      void dynamic()
+      {
+        static const short order[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+        const unsigned nlen = bits(5) + 257;
+        const unsigned ndist = bits(5) + 1;
+        const unsigned ncode = bits(4) + 4;
+        if ( nlen > inflate_maxlcodes || ndist > inflate_maxdcodes )
+          fail("bad counts");
+
+        short lengths[inflate_maxlcodes+inflate_maxdcodes];
+        unsigned index = 0;
+        for ( ; index < ncode; ++index )
+          lengths[order[index]] = static_cast<short>(bits(3));
+        for ( ; index < 19; ++index )
+          lengths[order[index]] = 0;
+
+        InflateHuffman lencode, distcode;
+        if ( construct( lencode, lengths, 19 ) != 0 )
+          fail("incomplete code length code");
+
+        index = 0;
+        while ( index < nlen + ndist ) {
+          int symbol = decode(lencode);
+          if ( symbol < 16 ) {
+            lengths[index++] = static_cast<short>(symbol);
+            continue;
+          }
+          short len = 0;
+          unsigned nrepeat;
+          if ( symbol == 16 ) {
+            if ( index == 0 )
+              fail("repeat with no previous length");
+            len = lengths[index-1];
+            nrepeat = 3 + bits(2);
+          } else if ( symbol == 17 ) {
+            nrepeat = 3 + bits(3);
+          } else {
+            nrepeat = 11 + bits(7);
+          }
+          if ( index + nrepeat > nlen + ndist )
+            fail("too many lengths");
+          while ( nrepeat-- )
+            lengths[index++] = len;
+        }
+        if ( lengths[256] == 0 )
+          fail("missing end-of-block code");
+
+        //Incomplete codes are only allowed for a single length-1 code:
+        int err = construct( lencode, lengths, nlen );
+        if ( err < 0 || ( err > 0 && nlen - lencode.count[0] != 1 ) )
+          fail("invalid literal/length code");
+        err = construct( distcode, lengths + nlen, ndist );
+        if ( err < 0 || ( err > 0 && ndist - distcode.count[0] != 1 ) )
+          fail("invalid distance code");
+        codes( lencode, distcode );
+      }
+    };
+  }
+}
+
+std::string NC::inflateRawDeflate( const unsigned char* data,
+                                   std::size_t nbytes,
+                                   std::size_t expected_size )
+{
+  return InflateState( data, nbytes, expected_size ).inflate();
+}
@@ -136,6 +136,7 @@ void NC::Info::objectDone()
 
     //Sort positions, ensuring a well defined ordering:
     std::stable_sort(itAtm->m_pos.begin(),itAtm->m_pos.end(),atominfo_pos_compare);
+    itAtm->m_pos.shrink_to_fit();
 
     if (!itAtm->numberPerUnitCell())
       NCRYSTAL_THROW(BadInput,"atominfo found for element with number_per_unit_cell=0!.");
@@ -408,6 +409,20 @@ void NC::Info::objectDone()
       m_atomDataSPs.emplace_back(std::move(e));
 
   }
+  //The object is immutable from now on, so release any excess capacity left
+  //over from building up the various lists (this reduces memory usage and
+  //fragmentation in long-running processes holding many Info objects):
+  m_atomlist.shrink_to_fit();
+  m_dyninfolist.shrink_to_fit();
+  m_composition.shrink_to_fit();
+  m_displayLabels.shrink_to_fit();
+  m_custom.shrink_to_fit();
+  for ( auto& section : m_custom ) {
+    section.second.shrink_to_fit();
+    for ( auto& line : section.second )
+      line.shrink_to_fit();
+  }
+
   //Setup AtomInfo<->DynamicInfo links:
   if ( !m_atomlist.empty() && !m_dyninfolist.empty()) {
     nc_assert_always( m_dyninfolist.size() == m_atomlist.size() );
@@ -515,6 +530,12 @@ bool NC::DI_ScatKnlDirect::hasBuiltSAB() const
   return !! m_sabdata;
 }
 
+void NC::DI_ScatKnlDirect::accountMemory( MemoryFootprint& mf ) const
+{
+  NCRYSTAL_LOCK_GUARD(m_mutex);
+  mf.addSharedObject( m_sabdata );
+}
+
 std::shared_ptr<const NC::SABData> NC::DI_ScatKnlDirect::ensureBuildThenReturnSAB() const
 {
   NCRYSTAL_LOCK_GUARD(m_mutex);
@@ -580,3 +601,32 @@ NC::AtomInfo::AtomInfo( IndexedAtomData iad,
     NCRYSTAL_THROW2(LogicError,"Invalid debye temperature value passed to AtomInfo constructor: " << m_dt.value());
 }
 
+
+void NC::Info::accountMemory( MemoryFootprint& mf ) const
+{
+  std::size_t n = sizeof(Info);
+  for ( auto& hkl : m_hkllist ) {
+    n += sizeof(HKLInfo) + hkl.demi_normals.size() * sizeof(HKLInfo::Normal);
+    if ( hkl.eqv_hkl )
+      n += hkl.demi_normals.size() * 3 * sizeof(short);
+  }
+  for ( auto& ai : m_atomlist )
+    n += sizeof(AtomInfo) + ai.unitCellPositions().size() * sizeof(AtomInfo::Pos);
+  for ( auto& section : m_custom ) {
+    n += section.first.size();
+    for ( auto& line : section.second )
+      for ( auto& word : line )
+        n += sizeof(std::string) + word.size();
+  }
+  mf.add( n );
+  for ( auto& di : m_dyninfolist ) {
+    mf.add( sizeof(DynamicInfo) );
+    auto di_vdos = dynamic_cast<const DI_VDOS*>(di.get());
+    if ( di_vdos )
+      mf.add( ( di_vdos->vdosOrigEgrid().size() + di_vdos->vdosOrigDensity().size()
+                + di_vdos->vdosData().vdos_density().size() ) * sizeof(double) );
+    auto di_skd = dynamic_cast<const DI_ScatKnlDirect*>(di.get());
+    if ( di_skd )
+      di_skd->accountMemory( mf );
+  }
+}
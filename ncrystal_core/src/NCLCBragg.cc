@@ -27,6 +27,8 @@
 #include "NCrystal/internal/NCLatticeUtils.hh"
 #include "NCrystal/internal/NCOrientUtils.hh"
 #include "NCrystal/internal/NCPlaneProvider.hh"
+#include "NCrystal/internal/NCRandUtils.hh"
+#include <algorithm>
 
 namespace NC = NCrystal;
 
@@ -36,7 +38,9 @@ namespace NCrystal{
 
     pimpl(LCBragg * lcbragg, LCAxis lcaxis, int mode,
           SCOrientation sco, const Info& cinfo, PlaneProvider * plane_provider,
-          MosaicityFWHM mosaicity, double delta_d, double prec,double ntrunc)
+          MosaicityFWHM mosaicity, double delta_d, double prec,double ntrunc,
+          bool circint_table, double xstable_prec, bool fixed_rotations,
+          optional_shared_obj<const SCBragg::Geometry> scgeometry)
       : m_ekin_low(-1)
     {
       nc_assert_always(lcbragg);
@@ -47,7 +51,11 @@ namespace NCrystal{
       LCAxis lcaxis_labframe = (cry2lab * lcaxis.as<Vector>()).unit().as<LCAxis>();
 
       if (mode==0) {
+        if ( scgeometry != nullptr )
+          NCRYSTAL_THROW(BadInput,"LCBragg shared SCBragg geometries are only supported for mode!=0.");
         nc_assert_always(delta_d==0);//mode=0 does not currently support delta_d!=0
+        if ( fixed_rotations )
+          NCRYSTAL_THROW(BadInput,"LCBragg fixed rotations are only supported for mode<0.");
         if (!cinfo.hasStructureInfo())
           NCRYSTAL_THROW(MissingInfo,"Passed Info object lacks structure information.");
         nc_assert_always(cinfo.hasStructureInfo());
@@ -64,18 +72,27 @@ namespace NCrystal{
                                                  mosaicity,
                                                  si.volume * si.n_atoms,
                                                  plane_provider,
-                                                 prec, ntrunc);
+                                                 prec, ntrunc, circint_table);
+
+        if ( xstable_prec )
+          m_lchelper->enableCrossSectionTable( xstable_prec );
 
         m_ekin_low = wl2ekin( m_lchelper->braggThreshold() );
 
       } else {
-        auto scbragg = makeSO<SCBragg>(cinfo,sco,mosaicity,delta_d,plane_provider,prec, ntrunc);
+        if ( xstable_prec )
+          NCRYSTAL_THROW(BadInput,"LCBragg cross-section tables are only supported for mode=0.");
+        auto scbragg = ( scgeometry != nullptr
+                         ? makeSO<SCBragg>(cinfo,sco,mosaicity,std::move(scgeometry),delta_d,prec,ntrunc,circint_table)
+                         : makeSO<SCBragg>(cinfo,sco,mosaicity,delta_d,plane_provider,prec, ntrunc, circint_table) );
         if (mode>0) {
+          if ( fixed_rotations )
+            NCRYSTAL_THROW(BadInput,"LCBragg fixed rotations are only supported for mode<0.");
           m_scmodel = std::make_shared<LCBraggRef>(scbragg, lcaxis_labframe, mode);
         } else {
           int nsample = -mode;
           nc_assert(nsample>0);
-          m_scmodel = std::make_shared<LCBraggRndmRot>(scbragg, lcaxis_labframe, nsample);
+          m_scmodel = std::make_shared<LCBraggRndmRot>(scbragg, lcaxis_labframe, nsample, fixed_rotations);
         }
         m_ekin_low = m_scmodel->domain().elow.get();
         nc_assert(ncisinf(m_scmodel->domain().ehigh.get()));
@@ -95,8 +112,10 @@ namespace NCrystal{
 
 NC::LCBragg::LCBragg( const Info& ci, const SCOrientation& sco, MosaicityFWHM mosaicity,
                       const LCAxis& lcaxis, int mode, double delta_d, PlaneProvider * plane_provider,
-                      double prec, double ntrunc)
-  : m_pimpl(std::make_unique<pimpl>(this,lcaxis,mode,sco,ci,plane_provider,mosaicity,delta_d,prec,ntrunc))
+                      double prec, double ntrunc, bool circint_table, double xstable_prec,
+                      bool fixed_rotations, optional_shared_obj<const SCBragg::Geometry> scgeometry)
+  : m_pimpl(std::make_unique<pimpl>(this,lcaxis,mode,sco,ci,plane_provider,mosaicity,delta_d,prec,ntrunc,
+                                    circint_table,xstable_prec,fixed_rotations,std::move(scgeometry)))
 {
   nc_assert_always(bool(m_pimpl->m_lchelper)!=bool(m_pimpl->m_scmodel!=nullptr));
 }
@@ -124,6 +143,25 @@ NC::CrossSect NC::LCBragg::crossSection(NC::CachePtr& cp, NC::NeutronEnergy ekin
   }
 }
 
+NC::CrossSect NC::LCBragg::majorantCrossSection( EnergyDomain d ) const
+{
+  if ( d.ehigh.get() < m_pimpl->m_ekin_low )
+    return CrossSect{ 0.0 };
+  if ( m_pimpl->m_scmodel )
+    return m_pimpl->m_scmodel->majorantCrossSection( d );
+  const double wl_max = ekin2wl( ncmax( d.elow.get(), m_pimpl->m_ekin_low ) );
+  const double wl_min = ekin2wl( d.ehigh.get() );
+  return CrossSect{ m_pimpl->m_lchelper->majorantCrossSection( wl_min, wl_max ) };
+}
+
+void NC::LCBragg::accountMemory( MemoryFootprint& mf ) const
+{
+  mf.add( sizeof(LCBragg) + sizeof(pimpl) );
+  if ( m_pimpl->m_lchelper )
+    mf.add( m_pimpl->m_lchelper->approxMemoryUsage() );
+  mf.addSharedObject( m_pimpl->m_scmodel );
+}
+
 NC::ScatterOutcome NC::LCBragg::sampleScatter(NC::CachePtr& cp, NC::RNG& rng, NC::NeutronEnergy ekin, const NC::NeutronDirection& indir ) const
 {
   if ( ekin.get() < m_pimpl->m_ekin_low )
@@ -142,3 +180,26 @@ NC::ScatterOutcome NC::LCBragg::sampleScatter(NC::CachePtr& cp, NC::RNG& rng, NC
     return m_pimpl->m_scmodel->sampleScatter( cp, rng, ekin, indir );
   }
 }
+
+void NC::LCBragg::evalManyXS( NC::CachePtr& cp, const double* ekin,
+                              const double* ux, const double* uy, const double* uz,
+                              std::size_t N, double* out_xs ) const
+{
+  if (! m_pimpl->m_scmodel )
+    return ScatterAnisotropicMat::evalManyXS( cp, ekin, ux, uy, uz, N, out_xs );
+  m_pimpl->m_scmodel->evalManyXS( cp, ekin, ux, uy, uz, N, out_xs );
+  for ( std::size_t i = 0; i < N; ++i )
+    if ( ekin[i] < m_pimpl->m_ekin_low )
+      out_xs[i] = 0.0;
+}
+
+void NC::LCBragg::sampleScatterMany( NC::CachePtr& cp, NC::RNG& rng, double* ekin,
+                                     double* ux, double* uy, double* uz,
+                                     std::size_t N ) const
+{
+  //Only pass on the batch if no neutrons should be left untouched:
+  const double ekin_low = m_pimpl->m_ekin_low;
+  if ( !m_pimpl->m_scmodel || useLegacyRandSampling() || std::any_of( ekin, ekin + N, [ekin_low]( double e ) { return e < ekin_low; } ) )
+    return ScatterAnisotropicMat::sampleScatterMany( cp, rng, ekin, ux, uy, uz, N );
+  m_pimpl->m_scmodel->sampleScatterMany( cp, rng, ekin, ux, uy, uz, N );
+}
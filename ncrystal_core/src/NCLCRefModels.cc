@@ -38,6 +38,13 @@ NC::EnergyDomain NC::LCBraggRef::domain() const noexcept
   return m_sc->domain();
 }
 
+NC::CrossSect NC::LCBraggRef::majorantCrossSection( EnergyDomain d ) const
+{
+  //Cross sections are averages over rotated crystallites, and the bound of
+  //the single crystal model does not depend on its orientation:
+  return m_sc->majorantCrossSection( d );
+}
+
 NC::CrossSect NC::LCBraggRef::crossSection(CachePtr& cp, NeutronEnergy ekin, const NeutronDirection& indir_nd ) const
 {
   const Vector indir = indir_nd.as<Vector>().unit();
@@ -90,12 +97,24 @@ NC::ScatterOutcome NC::LCBraggRef::sampleScatter(CachePtr& cp, RNG& rng, Neutron
   return { ekin, outdir };
 }
 
-NC::LCBraggRndmRot::LCBraggRndmRot(ProcImpl::ProcPtr scb, LCAxis lcaxis_lab, unsigned nsample)
+NC::LCBraggRndmRot::LCBraggRndmRot(ProcImpl::ProcPtr scb, LCAxis lcaxis_lab, unsigned nsample, bool fixed_rotations)
   : m_sc(std::move(scb)),
     m_lcaxislab(lcaxis_lab.as<Vector>().unit()),
     m_nsample(nsample)
 {
   nc_assert_always(nsample>0);
+  if ( fixed_rotations ) {
+    //Cross-sections are smooth periodic functions of the rotation angle, for
+    //which equidistant angles give much faster convergence than (quasi-)random
+    //ones. As in LCBraggRef, a prime number of angles avoids aliasing with
+    //rotational symmetries of the crystal around the lcaxis:
+    while (!isPrime(m_nsample))
+      ++m_nsample;
+    const double dphi = k2Pi / m_nsample;
+    m_fixedrot.reserve(m_nsample);
+    for (unsigned i = 0; i<m_nsample; ++i)
+      m_fixedrot.emplace_back( i * dphi - kPi );
+  }
 }
 
 NC::EnergyDomain NC::LCBraggRndmRot::domain() const noexcept
@@ -103,6 +122,13 @@ NC::EnergyDomain NC::LCBraggRndmRot::domain() const noexcept
   return m_sc->domain();
 }
 
+NC::CrossSect NC::LCBraggRndmRot::majorantCrossSection( EnergyDomain d ) const
+{
+  //Cross sections are averages over rotated crystallites, and the bound of
+  //the single crystal model does not depend on its orientation:
+  return m_sc->majorantCrossSection( d );
+}
+
 void NC::LCBraggRndmRot::updateCache(Cache& cache, NeutronEnergy ekin, const Vector& indir) const
 {
   cache.neutron_state = std::make_pair(ekin,indir);
@@ -113,6 +139,30 @@ void NC::LCBraggRndmRot::updateCache(Cache& cache, NeutronEnergy ekin, const Vec
   const Vector lccross = m_lcaxislab.cross(indir);
   const double lcdot = m_lcaxislab.dot(indir);
   StableSum sumxs;
+
+  if ( !m_fixedrot.empty() ) {
+    //Evaluate the single crystal model at all fixed rotations in one go:
+    const std::size_t n = m_fixedrot.size();
+    cache.ekin.assign(n,ekin.get());
+    cache.ux.resize(n);
+    cache.uy.resize(n);
+    cache.uz.resize(n);
+    cache.xs.resize(n);
+    for (std::size_t i = 0; i<n; ++i) {
+      const Vector nd = m_fixedrot[i].rotateVectorAroundAxis( indir, m_lcaxislab, lccross, lcdot );
+      cache.ux[i] = nd.x();
+      cache.uy[i] = nd.y();
+      cache.uz[i] = nd.z();
+    }
+    m_sc->evalManyXS( cache.sc_cacheptr, cache.ekin.data(), cache.ux.data(), cache.uy.data(),
+                      cache.uz.data(), n, cache.xs.data() );
+    for ( auto xs : cache.xs ) {
+      sumxs.add(xs);
+      cache.xscommul.push_back(sumxs.sum());
+    }
+    return;
+  }
+
   //This reference model is unusual and needs RNG even to calculate cross
   //sections. As a workaround we use a global method to get an RNG stream, which
   //potentially makes this model MT-unsafe (although since getRNG creates an
@@ -135,7 +185,8 @@ NC::CrossSect NC::LCBraggRndmRot::crossSection(CachePtr&cp, NeutronEnergy ekin,
 {
   const Vector indir = indir_nd.as<Vector>().unit();
   auto& cache = accessCache<Cache>(cp);
-  updateCache(cache,ekin,indir);//We always regenerate directions on each cross-section call!
+  if ( m_fixedrot.empty() || cache.xscommul.empty() || cache.neutron_state!=std::make_pair(ekin,indir) )
+    updateCache(cache,ekin,indir);//Without fixed rotations, we always regenerate directions on each cross-section call!
   return CrossSect{ cache.xscommul.back()/m_nsample };
 }
 
@@ -144,7 +195,7 @@ NC::ScatterOutcome NC::LCBraggRndmRot::sampleScatter(CachePtr&cp, RNG& rng, Neut
   const Vector indir = indir_nd.as<Vector>().unit();
   auto& cache = accessCache<Cache>(cp);
 
-  if (cache.rotations.empty()||cache.neutron_state!=std::make_pair(ekin,indir)) {
+  if (cache.xscommul.empty()||cache.neutron_state!=std::make_pair(ekin,indir)) {
     //trigger generation of random directions and calculate cross sections:
     updateCache(cache,ekin,indir);
   }
@@ -156,7 +207,8 @@ NC::ScatterOutcome NC::LCBraggRndmRot::sampleScatter(CachePtr&cp, RNG& rng, Neut
   }
 
   //Select one phi rotation at random:
-  const PhiRot& phirot = cache.rotations.at(pickRandIdxByWeight(rng,cache.xscommul));
+  const auto& rotations = ( m_fixedrot.empty() ? cache.rotations : m_fixedrot );
+  const PhiRot& phirot = rotations.at(pickRandIdxByWeight(rng,cache.xscommul));
 
   //Scatter!
   auto ndir = phirot.rotateVectorAroundAxis( indir, m_lcaxislab).as<NeutronDirection>();
@@ -25,6 +25,7 @@
 #include "NCrystal/internal/NCRomberg.hh"
 #include "NCrystal/internal/NCRandUtils.hh"
 #include "NCrystal/internal/NCRotMatrix.hh"
+#include "NCrystal/internal/NCCounters.hh"
 #include <cstring>
 #include <iostream>
 #include <functional>//std::greater
@@ -62,9 +63,10 @@ NC::LCHelper::LCHelper( NC::LCAxis lcaxis,
                         double unitcell_volume_times_natoms,
                         PlaneProvider* pp,
                         double prec,
-                        double ntrunc )
+                        double ntrunc,
+                        bool circint_table )
   : m_lcaxislab(lcaxis_labframe.as<Vector>().unit()),
-    m_lcstdframe(mosaicity_fwhm,prec,ntrunc),
+    m_lcstdframe(mosaicity_fwhm,prec,ntrunc,circint_table),
     m_xsfact( 1.0 / unitcell_volume_times_natoms )
 {
   nc_assert(pp);
@@ -152,11 +154,317 @@ NC::LCPlaneSet::LCPlaneSet(double dspacing, double thealpha,
   nc_assert(cosalphaplus<cosalphaminus);
 }
 
+NC::LCHelper::~LCHelper() = default;
+
+class NC::LCHelper::XSTable : private NoCopyMove {
+public:
+  //Table of the (m_xsfact-scaled) contributions from off-axis normals, on a
+  //grid in (wl,|c3|) with row-major storage (rows correspond to wl nodes). The
+  //table is built on first use, under a lock:
+  XSTable( double prec ) : m_prec(prec) {}
+
+  void ensureBuilt( const LCHelper& lch )
+  {
+    if ( m_ready.load() )
+      return;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if ( m_ready.load() )
+      return;
+    build( lch );
+    m_ready.store( true );
+  }
+
+  double lookup( double wl, double c3abs ) const
+  {
+    nc_assert( m_ready.load() );
+    nc_assert( c3abs >= 0.0 && c3abs <= 1.0 );
+    if ( !( wl < m_wlmax ) )
+      return 0.0;
+    const std::size_t nc3 = m_c3.size();
+    const std::size_t iwl = findInterval( m_wl, wl );
+    const std::size_t ic3 = findInterval( m_c3, c3abs );
+    const double fwl = ( wl - m_wl[iwl] ) / ( m_wl[iwl+1] - m_wl[iwl] );
+    const double fc3 = ( c3abs - m_c3[ic3] ) / ( m_c3[ic3+1] - m_c3[ic3] );
+    const double * v0 = &m_vals[iwl*nc3+ic3];
+    const double * v1 = v0 + nc3;
+    const double a = v0[0] + fc3 * ( v0[1] - v0[0] );
+    const double b = v1[0] + fc3 * ( v1[1] - v1[0] );
+    return a + fwl * ( b - a );
+  }
+
+  const std::vector<const LCPlaneSet*>& onAxisPlanes() const { return m_onaxis; }
+
+  std::size_t approxMemoryUsage() const
+  {
+    //Tables are only accessed once built:
+    std::size_t n = sizeof(XSTable);
+    if ( m_ready.load() )
+      n += ( m_wl.size() + m_c3.size() + m_vals.size() ) * sizeof(double)
+        + m_onaxis.size() * sizeof(const LCPlaneSet*);
+    return n;
+  }
+
+private:
+  const double m_prec;
+  std::atomic<bool> m_ready = {false};
+  std::mutex m_mutex;
+  double m_wlmax = 0.0;//off-axis contributions vanish at wl>=m_wlmax
+  VectD m_wl;
+  VectD m_c3;
+  VectD m_vals;
+  std::vector<const LCPlaneSet*> m_onaxis;//sorted by dspacing, largest first.
+
+  static std::size_t findInterval( const VectD& v, double x )
+  {
+    nc_assert(v.size()>=2);
+    auto it = std::upper_bound( v.begin(), v.end(), x );
+    std::size_t i = ( it == v.begin() ? 0 : std::size_t( it - v.begin() ) - 1 );
+    return ncmin( i, v.size() - 2 );
+  }
+
+  void build( const LCHelper& );
+};
+
+void NC::LCHelper::XSTable::build( const LCHelper& lch )
+{
+  for ( const auto& ps : lch.m_planes ) {
+    if ( ps.isOnAxis() )
+      m_onaxis.push_back( &ps );
+    else if ( !m_wlmax )
+      m_wlmax = ps.twodsp;
+  }
+  if ( !m_wlmax ) {
+    //No off-axis normals, degenerate table of zeroes:
+    m_wl = { 0.0, 1.0 };
+    m_c3 = { 0.0, 1.0 };
+    m_vals.assign( 4, 0.0 );
+    return;
+  }
+
+  //Cross-sections are discontinuous at the Bragg thresholds, wl=2*dspacing,
+  //of each plane. Place pairs of nodes immediately below and above each of
+  //them, and complete the initial grids with coarse uniform nodes:
+  const double minwidth_wl = 1e-6 * m_wlmax;
+  const double minwidth_c3 = 1e-6;
+  const double edge_eps = 1e-9;
+  const std::size_t ninit = 33;
+  VectD wlnodes, c3nodes;
+  for ( const auto& ps : lch.m_planes ) {
+    if ( ps.isOnAxis() )
+      continue;
+    if ( !wlnodes.empty() && wlnodes.back() - ps.twodsp * ( 1.0 + edge_eps ) < minwidth_wl )
+      continue;
+    wlnodes.push_back( ps.twodsp * ( 1.0 + edge_eps ) );
+    wlnodes.push_back( ps.twodsp * ( 1.0 - edge_eps ) );
+  }
+  std::reverse( wlnodes.begin(), wlnodes.end() );
+  {
+    const VectD edgenodes = wlnodes;
+    for ( std::size_t i = 0; i+1 < ninit; ++i ) {
+      const double wl = m_wlmax * i / ( ninit - 1.0 );
+      auto it = std::lower_bound( edgenodes.begin(), edgenodes.end(), wl );
+      if ( ( it == edgenodes.end() || *it - wl > minwidth_wl )
+           && ( it == edgenodes.begin() || wl - *std::prev(it) > minwidth_wl ) )
+        wlnodes.push_back( wl );
+    }
+    std::sort( wlnodes.begin(), wlnodes.end() );
+  }
+  for ( std::size_t i = 0; i < ninit; ++i )
+    c3nodes.push_back( double(i) / ( ninit - 1.0 ) );
+  c3nodes.back() = 1.0;
+
+  Cache cache;
+  auto evalRow = [&lch,&cache]( double wl, const VectD& c3s, VectD& out )
+  {
+    out.clear();
+    if ( !wl ) {
+      //Cross-sections vanish in the limit wl->0:
+      out.resize( c3s.size(), 0.0 );
+      return;
+    }
+    out.reserve( c3s.size() );
+    for ( auto c3 : c3s )
+      out.push_back( lch.crossSectionOffAxisNoTable( cache, wl, c3 ) );
+  };
+  std::vector<VectD> rows( wlnodes.size() );
+  for ( std::size_t i = 0; i < wlnodes.size(); ++i )
+    evalRow( wlnodes[i], c3nodes, rows[i] );
+
+  double vmax = 0.0;
+  for ( const auto& row : rows )
+    for ( auto v : row )
+      vmax = ncmax( vmax, v );
+
+  //Refine intervals in each dimension, by checking linear interpolation at
+  //their midpoints against exact evaluations. To avoid spending resources on
+  //irrelevant details, an absolute floor of 1e-3*vmax is added to the
+  //tolerance, and intervals are not split below certain widths:
+  auto isAccurate = [this,&vmax]( double exact, double interp )
+  {
+    return ncabs( exact - interp ) <= m_prec * ( ncabs( exact ) + 1e-3 * vmax );
+  };
+  const std::size_t nmax = 4000000;
+  std::vector<char> wl_done( wlnodes.size() - 1, 0 );
+  std::vector<char> c3_done( c3nodes.size() - 1, 0 );
+  bool changed = true;
+  bool capped = false;
+  VectD tmp;
+  while ( changed ) {
+    changed = false;
+
+    //Wavelength intervals:
+    {
+      std::vector<VectD> newrows;
+      VectD newwl;
+      std::vector<char> newdone;
+      std::size_t ninserted = 0;
+      newrows.reserve( rows.size() );
+      for ( std::size_t i = 0; i+1 < wlnodes.size(); ++i ) {
+        newwl.push_back( wlnodes[i] );
+        newrows.push_back( std::move( rows[i] ) );
+        if ( wl_done[i] ) {
+          newdone.push_back( 1 );
+          continue;
+        }
+        const double wlmid = 0.5 * ( wlnodes[i] + wlnodes[i+1] );
+        bool ok = ( wlnodes[i+1] - wlnodes[i] < minwidth_wl );
+        if ( !ok && ( wlnodes.size() + ninserted + 1 ) * c3nodes.size() > nmax )
+          ok = capped = true;
+        if ( !ok ) {
+          evalRow( wlmid, c3nodes, tmp );
+          ok = true;
+          const VectD& r0 = newrows.back();
+          const VectD& r1 = rows[i+1];
+          for ( std::size_t j = 0; ok && j < tmp.size(); ++j )
+            ok = isAccurate( tmp[j], 0.5 * ( r0[j] + r1[j] ) );
+        }
+        if ( ok ) {
+          newdone.push_back( 1 );
+          continue;
+        }
+        ++ninserted;
+        for ( auto v : tmp )
+          vmax = ncmax( vmax, v );
+        newwl.push_back( wlmid );
+        newrows.push_back( tmp );
+        newdone.push_back( 0 );
+        newdone.push_back( 0 );
+        changed = true;
+      }
+      newwl.push_back( wlnodes.back() );
+      newrows.push_back( std::move( rows.back() ) );
+      wlnodes.swap( newwl );
+      rows.swap( newrows );
+      wl_done.swap( newdone );
+    }
+
+    //Intervals in c3:
+    {
+      VectD newc3;
+      std::vector<char> newdone;
+      std::vector<std::size_t> insert_after;
+      std::vector<VectD> newcols;
+      VectD col;
+      for ( std::size_t j = 0; j+1 < c3nodes.size(); ++j ) {
+        newc3.push_back( c3nodes[j] );
+        if ( c3_done[j] ) {
+          newdone.push_back( 1 );
+          continue;
+        }
+        const double c3mid = 0.5 * ( c3nodes[j] + c3nodes[j+1] );
+        bool ok = ( c3nodes[j+1] - c3nodes[j] < minwidth_c3 );
+        if ( !ok && ( c3nodes.size() + newcols.size() + 1 ) * wlnodes.size() > nmax )
+          ok = capped = true;
+        if ( !ok ) {
+          col.clear();
+          ok = true;
+          for ( std::size_t i = 0; i < wlnodes.size(); ++i ) {
+            col.push_back( wlnodes[i] ? lch.crossSectionOffAxisNoTable( cache, wlnodes[i], c3mid ) : 0.0 );
+            ok = ok && isAccurate( col.back(), 0.5 * ( rows[i][j] + rows[i][j+1] ) );
+          }
+        }
+        if ( ok ) {
+          newdone.push_back( 1 );
+          continue;
+        }
+        for ( auto v : col )
+          vmax = ncmax( vmax, v );
+        newc3.push_back( c3mid );
+        insert_after.push_back( j );
+        newcols.push_back( col );
+        newdone.push_back( 0 );
+        newdone.push_back( 0 );
+        changed = true;
+      }
+      newc3.push_back( c3nodes.back() );
+      if ( !newcols.empty() ) {
+        for ( std::size_t i = 0; i < wlnodes.size(); ++i ) {
+          const VectD& row = rows[i];
+          tmp.clear();
+          tmp.reserve( newc3.size() );
+          std::size_t k = 0;
+          for ( std::size_t j = 0; j < row.size(); ++j ) {
+            tmp.push_back( row[j] );
+            if ( k < insert_after.size() && insert_after[k] == j )
+              tmp.push_back( newcols[k++][i] );
+          }
+          rows[i] = tmp;
+        }
+      }
+      c3nodes.swap( newc3 );
+      c3_done.swap( newdone );
+    }
+  }
+
+  if ( capped ) {
+    static std::atomic<bool> first(true);
+    if ( first.exchange(false) )
+      std::cout<<"NCrystal WARNING: LCHelper cross-section table was truncated at "<<nmax<<" entries"
+        " before reaching the requested precision of "<<m_prec<<". Further warnings of this type"
+        " will not be emitted."<<std::endl;
+  }
+  m_wl.swap( wlnodes );
+  m_c3.swap( c3nodes );
+  m_vals.reserve( m_wl.size() * m_c3.size() );
+  for ( const auto& row : rows ) {
+    nc_assert( row.size() == m_c3.size() );
+    m_vals.insert( m_vals.end(), row.begin(), row.end() );
+  }
+}
+
+std::size_t NC::LCHelper::approxMemoryUsage() const
+{
+  return sizeof(LCHelper) + m_planes.size() * sizeof(LCPlaneSet)
+    + ( m_xstable ? m_xstable->approxMemoryUsage() : 0 );
+}
+
+void NC::LCHelper::enableCrossSectionTable( double precision )
+{
+  nc_assert_always( precision > 0.0 && precision < 1.0 );
+  m_xstable = std::make_unique<XSTable>( precision );
+}
+
 double NC::LCHelper::braggThreshold() const
 {
   return m_planes.empty() ? 0.0 : m_planes.begin()->twodsp;
 }
 
+double NC::LCHelper::majorantCrossSection( double wl_min, double wl_max ) const
+{
+  nc_assert(wl_min>=0.0&&wl_min<=wl_max);
+  //Cross-sections are averaged over crystallite rotations, so can be bounded
+  //by the sum of the upper bounds for each normal (and anti-normal) of all
+  //planes which might contribute:
+  const GaussMos& gm = m_lcstdframe.gaussMos();
+  double xs = 0.0;
+  for ( const auto& ps : m_planes ) {
+    if ( wl_min >= ps.twodsp )
+      break;//no other planes can contribute, since m_planes is sorted by dspacing
+    xs += 2.0 * gm.calcMaxCrossSectionValue( wl_max, ps.inv_twodsp, ps.fsq );
+  }
+  return m_xsfact * xs;
+}
+
 NC::LCROIFinder::LCROIFinder(double wl, double c3, double cta, double sta)
   : m_wl(wl),
     m_c3(ncabs(c3)),//ncabs, to ensure alpha_neutron < pi/2 (rotation symmetry guarantees same results)
@@ -338,14 +646,17 @@ void NC::LCHelper::ensureValid(NC::LCHelper::Cache& cache, double wl, const NC::
   nc_assert(wl>=0&&wl<1e7&&c3>=-1.0&&c3<=1.0);
   uint64_t discrwl = LCdiscretizeValue(wl);
   uint64_t discrc3 = LCdiscretizeValue(ncabs(c3));
-  if ( cache.m_signature.first == discrwl && cache.m_signature.second == discrc3 )
+  if ( cache.m_signature.first == discrwl && cache.m_signature.second == discrc3 ) {
+    NCRYSTAL_COUNT(LCBraggCacheHit);
     return;
+  }
   forceUpdateCache(cache,discrwl,discrc3);
 }
 
 
 void NC::LCHelper::forceUpdateCache( NC::LCHelper::Cache& cache, uint64_t discr_wl, uint64_t discr_c3 ) const
 {
+  NCRYSTAL_COUNT(LCBraggCacheMiss);
   cache.m_signature.first = discr_wl;
   cache.m_signature.second = discr_c3;
   cache.m_wl = LCdediscretizeValue(discr_wl);
@@ -441,10 +752,63 @@ void NC::LCHelper::forceUpdateCache( NC::LCHelper::Cache& cache, uint64_t discr_
 
 double NC::LCHelper::crossSection( NC::LCHelper::Cache& cache, double wl, const NC::Vector& indir ) const
 {
+  if ( m_xstable ) {
+    nc_assert(wl>0.0);
+    nc_assert(indir.isUnitVector());
+    m_xstable->ensureBuilt( *this );
+    const double c3 = ncmin( 1.0, ncabs( m_lcaxislab.dot(indir) ) );
+    return crossSectionOnAxis( cache, wl, c3 ) + m_xstable->lookup( wl, c3 );
+  }
   ensureValid(cache,wl,indir);
   return cache.m_roixs_commul.empty() ? 0.0 : (m_xsfact * cache.m_roixs_commul.back());
 }
 
+double NC::LCHelper::crossSectionOffAxisNoTable( NC::LCHelper::Cache& cache, double wl, double c3 ) const
+{
+  //Exact cross-section, excluding contributions from on-axis normals:
+  const uint64_t discrwl = LCdiscretizeValue(wl);
+  const uint64_t discrc3 = LCdiscretizeValue(ncabs(c3));
+  if ( !( cache.m_signature.first == discrwl && cache.m_signature.second == discrc3 ) )
+    forceUpdateCache(cache,discrwl,discrc3);
+  else
+    NCRYSTAL_COUNT(LCBraggCacheHit);
+  double sumxs = 0.0;
+  double prev = 0.0;
+  for ( std::size_t i = 0; i < cache.m_roilist.size(); ++i ) {
+    const double commul = cache.m_roixs_commul[i];
+    if ( !cache.m_roilist[i].planeset->isOnAxis() )
+      sumxs += commul - prev;
+    prev = commul;
+  }
+  return m_xsfact * sumxs;
+}
+
+double NC::LCHelper::crossSectionOnAxis( NC::LCHelper::Cache& cache, double wl, double c3 ) const
+{
+  //Exact cross-section from on-axis normals only (which do not need any
+  //integration over crystallite rotations):
+  nc_assert(m_xstable);
+  nc_assert(c3>=0.0&&c3<=1.0);
+  const auto& planes = m_xstable->onAxisPlanes();
+  if ( planes.empty() || wl > planes.front()->twodsp )
+    return 0.0;
+  const double s3 = std::sqrt( ncmax( 0.0, 1.0 - c3*c3 ) );
+  const GaussMos& gm = m_lcstdframe.gaussMos();
+  LCROIFinder roifinder(wl,c3,gm.mosaicityCosTruncationAngle(),gm.mosaicitySinTruncationAngle());
+  auto& roilist = cache.m_onaxis_roilist;
+  roilist.clear();
+  for ( auto ps : planes ) {
+    if ( wl > ps->twodsp )
+      break;
+    roifinder.findROIs(ps,roilist);
+  }
+  LCStdFrame::NeutronPars neutron(wl,c3,s3);
+  double xs = 0.0;
+  for ( const auto& roi : roilist )
+    xs += m_lcstdframe.calcXS_OnAxis(neutron,LCStdFrame::NormalPars(roi.planeset,roi.normal_sign));
+  return m_xsfact * xs;
+}
+
 void NC::LCHelper::Cache::reset()
 {
   //same result as Cache() constructor
@@ -476,7 +840,7 @@ namespace NCrystal {
 
     virtual double evalFunc(double) const {
       //Must be implemented, but should never be called since we provide
-      //evalFuncMany+evalFuncManySum.
+      //evalFuncMany.
       nc_assert_always(false);
     }
 
@@ -489,22 +853,10 @@ namespace NCrystal {
       do {
         double cosgamma = m_sinnormalmults3 * grid.current_cosval() + m_cosnormalmultc3;
         nc_assert(NC::ncabs(cosgamma)<1.000000001);
-        fvals[i++] = m_gm->calcRawCrossSectionValue(m_ip,cosgamma);
-      } while (grid.step());
-    }
-
-    virtual double evalFuncManySum(unsigned n, double offset, double delta) const
-    {
-      nc_assert(offset>=0&&offset<kPi*1.00001);
-      nc_assert(delta>0&&delta*n<=kPi*1.00001);
-      CosSinGridGen grid(n,offset,delta);
-      double sum(0.);
-      do {
-        double cosgamma = m_sinnormalmults3 * grid.current_cosval() + m_cosnormalmultc3;
-        nc_assert(NC::ncabs(cosgamma)<1.000000001);
-        sum += m_gm->calcRawCrossSectionValue(m_ip,cosgamma);
+        fvals[i++] = ncclamp(cosgamma,-1.0,1.0);//rounding errors, e.g. for perpendicular neutrons
       } while (grid.step());
-      return sum;
+      Span<double> fv( fvals, fvals + n );
+      m_gm->calcRawCrossSectionValues( m_ip, fv, fv );
     }
 
   private:
@@ -516,12 +868,12 @@ namespace NCrystal {
   };
 }
 
-void NC::LCHelper::genPhiVal(RNG& rng, const LCROI& roi, const Overlay& overlay, double& phi, double& overlay_at_phi)
+void NC::LCHelper::genPhiVal(RNG& rng, const LCROI& roi, const float* overlay, double& phi, double& overlay_at_phi)
 {
-  const float* it = std::lower_bound( overlay.data, overlay.data+Overlay::ndata, overlay.data[Overlay::ndata-1] * rng.generate() );
-  unsigned ichoice = std::min<unsigned>((unsigned)(it - overlay.data),Overlay::ndata-1);
-  overlay_at_phi = overlay.nonCommulVal(ichoice);
-  double rel_phi_pos = (ichoice + rng.generate())/Overlay::ndata;
+  const float* it = std::lower_bound( overlay, overlay+overlay_ndata, overlay[overlay_ndata-1] * rng.generate() );
+  unsigned ichoice = std::min<unsigned>((unsigned)(it - overlay),overlay_ndata-1);
+  overlay_at_phi = overlayNonCommulVal(overlay,ichoice);
+  double rel_phi_pos = (ichoice + rng.generate())/overlay_ndata;
   phi = roi.rotmin + rel_phi_pos*roi.length();
 }
 
@@ -562,25 +914,26 @@ void NC::LCHelper::genScatter( LCHelper::Cache& cache, RNG& rng, double wl, cons
       cosphi = cos_mpipi(phi);
     } else {
 
-      //Find overlay object:
+      //Find overlay (buffer is (re)initialised with zeroes on first use after
+      //each cache update, reusing its memory):
       if (cache.m_roi_overlays.empty())
-        cache.m_roi_overlays.resize(cache.m_roilist.size());
-      nc_assert(idx<cache.m_roi_overlays.size());
-      Overlay& overlay = cache.m_roi_overlays[idx];
+        cache.m_roi_overlays.resize(cache.m_roilist.size()*overlay_ndata,0.0f);
+      nc_assert(idx*overlay_ndata<cache.m_roi_overlays.size());
+      float * overlay = &cache.m_roi_overlays[idx*overlay_ndata];
 
-      if (!overlay.data) {
+      if (!overlay[overlay_ndata-1]) {
 
         //Didn't scatter on this normal before, prepare overlay by sampling xs
         //values at edges of overlay histogram bins (For convenience and
         //consistency, use the integrator class to do this):
-        double tmp[Overlay::ndata+1];
+        double tmp[overlay_ndata+1];
         LCStdFrameIntegrator integrator(&m_lcstdframe.gaussMos(), normal,neutron);
-        integrator.evalFuncMany(&tmp[0], Overlay::ndata+1, roi.rotmin, roi.length()/Overlay::ndata);
+        integrator.evalFuncMany(&tmp[0], overlay_ndata+1, roi.rotmin, roi.length()/overlay_ndata);
 
         //Adding 2% of maxval to all bins significantly increases safety
         //of non-central bins, with low impact on the acceptance rate:
         double * it(&tmp[0]);
-        double * itLast(it+Overlay::ndata);
+        double * itLast(it+overlay_ndata);
         double * itE(itLast+1);
         double maxval = 0.0;
         for (;it!=itE;++it)
@@ -591,9 +944,8 @@ void NC::LCHelper::genScatter( LCHelper::Cache& cache, RNG& rng, double wl, cons
         //never be too small in central bins:
         const double safety_factor = 1.7;
 
-        //Finally, put into overlay.data as commulative array:
-        overlay.prepareNullArray();
-        float * itData = overlay.data;
+        //Finally, put into overlay as commulative array:
+        float * itData = overlay;
         float sum(0.0);
         for (it = &tmp[0]; it!=itLast ; ++it, ++itData )
           *itData = ( sum += (ncmax(*it,*(it+1)) * safety_factor+safety_offset) );
@@ -625,10 +977,10 @@ void NC::LCHelper::genScatter( LCHelper::Cache& cache, RNG& rng, double wl, cons
             double ph = roi.rotmin + i*ddd;
             double overlay_relphi= i*(1.0/(n-1));//maps [rotmin,rotmax] to [0,1]
             nc_assert(overlay_relphi>=0.&&overlay_relphi<=1.+1e-13);
-            unsigned overlay_bin = std::min<unsigned>(Overlay::ndata-1,(unsigned)(overlay_relphi*Overlay::ndata));
+            unsigned overlay_bin = std::min<unsigned>(overlay_ndata-1,(unsigned)(overlay_relphi*overlay_ndata));
             ofs << sampleoverlay.at(i).first << " " << sampleoverlay.at(i).second << " "
                 << ph << " " << m_lcstdframe.calcXS(neutron,normal,std::cos(ph)) << " "
-                << overlay.nonCommulVal(overlay_bin) << "\n";
+                << overlayNonCommulVal(overlay,overlay_bin) << "\n";
           }
         }
       }
@@ -685,9 +1037,11 @@ void NC::LCHelper::genScatter( LCHelper::Cache& cache, RNG& rng, double wl, cons
   outdir *= -1.0;
 }
 
-NC::LCStdFrame::LCStdFrame(MosaicityFWHM mosaicity, double prec, double ntrunc)
+NC::LCStdFrame::LCStdFrame(MosaicityFWHM mosaicity, double prec, double ntrunc, bool circint_table)
   : m_gm(mosaicity,prec,ntrunc)
 {
+  if ( circint_table )
+    m_gm.enableCircleIntegralTable();
 }
 
 double NC::LCStdFrame::calcXS_OnAxis( const NC::LCStdFrame::NeutronPars& neutron,
@@ -732,7 +1086,7 @@ double NC::LCStdFrame::calcXS( const NC::LCStdFrame::NeutronPars& neutron,
   //gamma is angle between neutron and plane normal:
   const double c1 = normal.planeset->cosalpha;
   const double s1 = normal.planeset->sinalpha;
-  const double cosgamma = (s1 * neutron.s3 * cosphi + c1 * neutron.c3)*normal.sign;//normal.sign multiplies both cosphi and c1
+  const double cosgamma = ncclamp((s1 * neutron.s3 * cosphi + c1 * neutron.c3)*normal.sign,-1.0,1.0);//normal.sign multiplies both cosphi and c1
   GaussMos::InteractionPars ip(neutron.wl, normal.planeset->inv_twodsp, normal.planeset->fsq);
   return m_gm.calcRawCrossSectionValue( ip, cosgamma );
 }
@@ -0,0 +1,66 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+//  This file is part of NCrystal (see https://mctools.github.io/ncrystal/)   //
+//                                                                            //
+//  Copyright 2015-2021 NCrystal developers                                   //
+//                                                                            //
+//  Licensed under the Apache License, Version 2.0 (the "License");           //
+//  you may not use this file except in compliance with the License.          //
+//  You may obtain a copy of the License at                                   //
+//                                                                            //
+//      http://www.apache.org/licenses/LICENSE-2.0                            //
+//                                                                            //
+//  Unless required by applicable law or agreed to in writing, software       //
+//  distributed under the License is distributed on an "AS IS" BASIS,         //
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  //
+//  See the License for the specific language governing permissions and       //
+//  limitations under the License.                                            //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include "NCrystal/internal/NCLargeAlloc.hh"
+#include "NCrystal/internal/NCString.hh"
+#ifdef __linux__
+#  include <sys/mman.h>
+#endif
+
+namespace NC = NCrystal;
+
+bool NC::hugePagesEnabled()
+{
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+  static const bool s_enabled = ncgetenv_bool("HUGEPAGES");
+  return s_enabled;
+#else
+  return false;
+#endif
+}
+
+std::shared_ptr<void> NC::allocateLargeTable( std::size_t nbytes )
+{
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+  constexpr std::size_t hugepagesize = 2*1024*1024;
+  if ( nbytes >= hugepagesize && hugePagesEnabled() ) {
+    //Map a bit more than needed, so an aligned region can be carved out (and
+    //the unneeded head and tail unmapped again):
+    const std::size_t len = ( ( nbytes + hugepagesize - 1 ) / hugepagesize ) * hugepagesize;
+    void * p = mmap( nullptr, len + hugepagesize, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+    if ( p != MAP_FAILED ) {
+      const std::uintptr_t praw = reinterpret_cast<std::uintptr_t>( p );
+      const std::uintptr_t paligned = ( ( praw + hugepagesize - 1 ) / hugepagesize ) * hugepagesize;
+      const std::size_t head = paligned - praw;
+      if ( head )
+        munmap( p, head );
+      const std::size_t tail = hugepagesize - head;
+      if ( tail )
+        munmap( reinterpret_cast<void*>( paligned + len ), tail );
+      void * aligned = reinterpret_cast<void*>( paligned );
+      madvise( aligned, len, MADV_HUGEPAGE );//failure is harmless
+      return std::shared_ptr<void>( aligned, [len]( void * q ) { munmap( q, len ); } );
+    }
+    //Fall back to ordinary allocation below.
+  }
+#endif
+  return std::shared_ptr<void>( ::operator new( nbytes ), []( void * q ) { ::operator delete( q ); } );
+}
@@ -34,6 +34,7 @@
 #include "NCrystal/internal/NCScatKnlData.hh"
 #include "NCrystal/internal/NCVDOSEval.hh"
 #include "NCrystal/internal/NCDynInfoUtils.hh"
+#include "NCrystal/internal/NCSABDiskCache.hh"
 #include <iostream>
 #include <cstdlib>
 
@@ -48,9 +49,13 @@ namespace NCrystal {
     DI_ScatKnlImpl( double fraction,
                     IndexedAtomData atom,
                     VectD&& egrid,
-                    ScatKnlData&& data )
+                    ScatKnlData&& data,
+                    NCMATData::DynInfo::DeferredFieldDecoder&& sabDecoder = nullptr,
+                    std::pair<const char*,const char*> sabText = { nullptr, nullptr } )
       : DI_ScatKnlDirect(fraction,std::move(atom),data.temperature),
-        m_inputdata(std::make_unique<ScatKnlData>(std::move(data)))
+        m_inputdata(std::make_unique<ScatKnlData>(std::move(data))),
+        m_sabDecoder(std::move(sabDecoder)),
+        m_sabText(sabText)
     {
       if (!egrid.empty())
         m_egrid = std::make_shared<const VectD>(std::move(egrid));
@@ -69,11 +74,35 @@ namespace NCrystal {
       //
       //NB: Invocation of this method is protected by object-specific mutex lock.
       nc_assert_always(!!m_inputdata);
-      SABData data = SABUtils::transformKernelToStdFormat(std::move(*m_inputdata));
-      return std::make_shared<const SABData>(std::move(data));
+      std::string cachekey;
+      if ( m_sabDecoder ) {
+        //Kernel table was not yet decoded from the input data. Decoding
+        //dominates the cost, so the result might be found in the SAB disk
+        //cache or a snapshot, based on the raw text of the table:
+        nc_assert_always(m_inputdata->sab.empty());
+        if ( m_sabText.first ) {
+          cachekey = SAB::convertedKernelCacheKey( *m_inputdata, m_sabText.first, m_sabText.second );
+          if ( !cachekey.empty() ) {
+            auto cached = SAB::loadConvertedKernelFromDiskCache( cachekey );
+            if ( cached ) {
+              m_inputdata.reset();
+              m_sabDecoder = nullptr;
+              return cached;
+            }
+          }
+        }
+        m_inputdata->sab = m_sabDecoder();
+        m_sabDecoder = nullptr;
+      }
+      auto res = std::make_shared<const SABData>(SABUtils::transformKernelToStdFormat(std::move(*m_inputdata)));
+      if ( !cachekey.empty() )
+        SAB::saveConvertedKernelToDiskCache( cachekey, *res );
+      return res;
     }
   private:
     mutable std::unique_ptr<ScatKnlData> m_inputdata;
+    mutable NCMATData::DynInfo::DeferredFieldDecoder m_sabDecoder;
+    std::pair<const char*,const char*> m_sabText;
     std::shared_ptr<const VectD> m_egrid;
   };
 
@@ -147,19 +176,26 @@ NC::Info NC::loadNCMAT( const TextData& inputText,
   const bool doFinalValidation = false;
   //don't validate at end of the parseNCMATData call, since the loadNCMAT call
   //anyway validates.
-  NCMATData data = parseNCMATData( inputText, doFinalValidation);
+  //
+  //Large kernel tables are only decoded if and when the scattering kernel is
+  //actually needed (i.e. not for Info-only usage or with inelas=0):
+  const bool deferLargeFields = true;
+  NCMATData data = parseNCMATData( inputText, doFinalValidation, deferLargeFields );
   return loadNCMAT( std::move(data), std::move(cfgvars) );
 }
 
 
 NC::Info NC::loadNCMAT( const MatInfoCfg& cfg )
 {
-  cfg.infofactopt_validate({"expandhkl"});//only this infofactopt is supported
+  cfg.infofactopt_validate({"expandhkl","compacthkl"});//only these infofactopts are supported
   NCMATCfgVars ncmatcfgvars;
   ncmatcfgvars.temp      = cfg.get_temp();
   ncmatcfgvars.dcutoff   = cfg.get_dcutoff();
   ncmatcfgvars.dcutoffup = cfg.get_dcutoffup();
+  ncmatcfgvars.emax      = cfg.get_emax();
+  ncmatcfgvars.propsonly = cfg.get_propsonly();
   ncmatcfgvars.expandhkl = cfg.get_infofactopt_flag("expandhkl");
+  ncmatcfgvars.compacthkl = cfg.get_infofactopt_flag("compacthkl");
   ncmatcfgvars.atomdb    = cfg.get_atomdb_parsed();
   return loadNCMAT( cfg.textData(), std::move(ncmatcfgvars) );
 }
@@ -180,7 +216,10 @@ NC::Info NC::loadNCMAT( NCMATData&& data,
              <<", temp="<<cfgvars.temp
              <<", dcutoff="<<cfgvars.dcutoff
              <<", dcutoffup="<<cfgvars.dcutoffup
+             <<", emax="<<cfgvars.emax
+             <<", propsonly="<<cfgvars.propsonly
              <<", expandhkl="<<cfgvars.expandhkl
+             <<", compacthkl="<<cfgvars.compacthkl
              <<", atomdb=";
     if (cfgvars.atomdb.empty()) {
       std::cout<<"<none>";
@@ -379,6 +418,7 @@ NC::Info NC::loadNCMAT( NCMATData&& data,
                   };
 
   if (data_hasDynInfo) {
+    dyninfolist.reserve( data.dyninfos.size() );
     for (auto& e : data.dyninfos) {
       const auto& iad = elementname_2_indexedatomdata(e.element_name);
       nc_assert_always(e.fraction>0.0&&e.fraction<=1.0);
@@ -429,25 +469,42 @@ NC::Info NC::loadNCMAT( NCMATData&& data,
           knldata.temperature = cfgvars.temp;
           knldata.boundXS = iad.data().scatteringXS();//(full xs, incoherent approximation)
           knldata.elementMassAMU = iad.data().averageMassAMU();
-          //Move acquire expensive fields:
-          if (e.fields.count("sab")) {
+          //Move acquire expensive fields (the kernel table itself might not yet
+          //be decoded, in which case we pass on the decoder instead):
+          NCMATData::DynInfo::DeferredFieldDecoder sabDecoder;
+          std::pair<const char*,const char*> sabText = { nullptr, nullptr };
+          auto acquireKnlTable = [&e,&sabDecoder,&sabText]( const std::string& name )
+          {
+            auto itDeferred = e.deferredFields.find(name);
+            if ( itDeferred == e.deferredFields.end() )
+              return std::move(e.fields.at(name));
+            sabDecoder = std::move(itDeferred->second);
+            e.deferredFields.erase(itDeferred);
+            auto itText = e.deferredFieldTexts.find(name);
+            if ( itText != e.deferredFieldTexts.end() ) {
+              sabText = itText->second;
+              e.deferredFieldTexts.erase(itText);
+            }
+            return VectD();
+          };
+          if (e.hasField("sab")) {
             knldata.alphaGrid = std::move(e.fields.at("alphagrid"));
             knldata.betaGrid = std::move(e.fields.at("betagrid"));
-            knldata.sab = std::move(e.fields.at("sab"));
+            knldata.sab = acquireKnlTable("sab");
             knldata.knltype = ScatKnlData::KnlType::SAB;
-          } else if (e.fields.count("sab_scaled")) {
+          } else if (e.hasField("sab_scaled")) {
             knldata.alphaGrid = std::move(e.fields.at("alphagrid"));
             knldata.betaGrid = std::move(e.fields.at("betagrid"));
-            knldata.sab = std::move(e.fields.at("sab_scaled"));
+            knldata.sab = acquireKnlTable("sab_scaled");
             nc_assert_always(knldata.betaGrid.size()>0);
             if (knldata.betaGrid.front()==0.0)
               knldata.knltype = ScatKnlData::KnlType::SCALED_SYM_SAB;
             else
               knldata.knltype = ScatKnlData::KnlType::SCALED_SAB;
-          } else if (e.fields.count("sqw")) {
+          } else if (e.hasField("sqw")) {
             knldata.alphaGrid = std::move(e.fields.at("qgrid"));
             knldata.betaGrid = std::move(e.fields.at("omegagrid"));
-            knldata.sab = std::move(e.fields.at("sqw"));
+            knldata.sab = acquireKnlTable("sqw");
             knldata.knltype = ScatKnlData::KnlType::SQW;
           } else {
             NCRYSTAL_THROW(LogicError,"Unexpected SAB type in input data");//logic-error, since we should have caught this earlier.
@@ -457,7 +514,9 @@ NC::Info NC::loadNCMAT( NCMATData&& data,
           VectD egrid = getEgrid(e.fields);
           di = std::make_unique<DI_ScatKnlImpl>(e.fraction, iad,
                                                 std::move(egrid),
-                                                std::move(knldata));
+                                                std::move(knldata),
+                                                std::move(sabDecoder),
+                                                sabText);
         }
         break;
       default:
@@ -642,8 +701,9 @@ NC::Info NC::loadNCMAT( NCMATData&& data,
   info.setDensity( density );
   info.setNumberDensity( numberdensity );
 
-  //==> Finally populate HKL list if appropriate:
-  if ( data_hasUnitCell ) {
+  //==> Finally populate HKL list if appropriate (never needed when only basic
+  //properties were requested):
+  if ( data_hasUnitCell && !cfgvars.propsonly ) {
     if(cfgvars.dcutoff==0) {
       //Very simple heuristics here for now to select appropriate dcutoff value
       //(specifically we needed to raise the value for expensive Y2O3/SiLu2O5
@@ -658,12 +718,26 @@ NC::Info NC::loadNCMAT( NCMATData&& data,
       if (verbose)
         std::cout<<"NCrystal::NCMATFactory::automatically selected dcutoff level "<< cfgvars.dcutoff << " Aa"<<cmt<<std::endl;
     }
+    if ( cfgvars.dcutoff != -1 && cfgvars.emax > 0.0 ) {
+      //Planes with d-spacing below lambda/2 can never satisfy the Bragg
+      //condition, so when neutron energies are restricted to be at most emax,
+      //there is no need to generate planes with d-spacing below
+      //lambda(emax)/2 (with a tiny safety margin against rounding):
+      const double dcutoff_window = 0.5 * ekin2wl( cfgvars.emax ) * ( 1.0 - 1e-9 );
+      if ( dcutoff_window > cfgvars.dcutoff && dcutoff_window < cfgvars.dcutoffup ) {
+        cfgvars.dcutoff = dcutoff_window;
+        if (verbose)
+          std::cout<<"NCrystal::NCMATFactory::raised dcutoff level to "<< cfgvars.dcutoff
+                   << " Aa due to emax="<<cfgvars.emax<<"eV"<<std::endl;
+      }
+    }
     if ( cfgvars.dcutoff != -1 ) {
 
       FillHKLCfg hklcfg;
       hklcfg.dcutoff = cfgvars.dcutoff;
       hklcfg.dcutoffup = cfgvars.dcutoffup;
       hklcfg.expandhkl = cfgvars.expandhkl;
+      hklcfg.compact = cfgvars.compacthkl;
 
       fillHKL( info,  hklcfg );
     }
@@ -26,6 +26,7 @@
 #include "NCrystal/internal/NCVector.hh"
 #include "NCrystal/internal/NCAtomUtils.hh"
 #include "NCrystal/internal/NCFileUtils.hh"
+#include "NCrystal/internal/NCFactoryUtils.hh"
 #include "NCrystal/internal/NCString.hh"
 #include <sstream>
 #include <iomanip>
@@ -100,23 +101,36 @@ struct NC::MatCfg::Impl {
                     PAR_absnfactory = 0,
                     PAR_atomdb,
                     PAR_coh_elas,
+                    PAR_dbintol,
                     PAR_dcutoff,
                     PAR_dcutoffup,
                     PAR_dir1,
                     PAR_dir2,
                     PAR_dirtol,
+                    PAR_emax,
+                    PAR_fgtab,
                     PAR_incoh_elas,
                     PAR_inelas,
                     PAR_infofactory,
                     PAR_lcaxis,
+                    PAR_lcfixedrot,
                     PAR_lcmode,
+                    PAR_lctabprec,
                     PAR_mos,
                     PAR_mosprec,
+                    PAR_mostab,
                     PAR_packfact,
+                    PAR_propsonly,
+                    PAR_sabalias,
+                    PAR_sabfloat32,
+                    PAR_sabtinterp,
                     PAR_scatfactory,
                     PAR_sccutoff,
                     PAR_temp,
                     PAR_vdoslux,
+                    PAR_vdosthintol,
+                    PAR_xsquant,
+                    PAR_xstabprec,
                     PAR_NMAX };
   using ParametersSet = std::set<PARAMETERS>;
 
@@ -134,6 +148,13 @@ struct NC::MatCfg::Impl {
   //Array where we keep the actual configuration:
   std::array<std::unique_ptr<ValBase>,PAR_NMAX> m_parlist;
 
+  //Cache keys (see MatCfg::cacheKey) are computed on demand, and must be reset
+  //whenever a parameter is modified (not copied in the clone constructor):
+  mutable std::mutex m_cacheKeyMutex;
+  mutable MatCfg::CacheKeySP m_cacheKey, m_cacheKeyInfo;
+  void invalidateCacheKeys() { m_cacheKey.reset(); m_cacheKeyInfo.reset(); }
+  MatCfg::CacheKeySP getCacheKey( const ParametersSet * only_pars ) const;
+
   bool hasPar(PARAMETERS par) const { return m_parlist[par]!=nullptr; }
 
   struct ValDbl : public ValBase {
@@ -460,6 +481,7 @@ struct NC::MatCfg::Impl {
 
   template <class ValType>
   ValType* getValTypeForSet(PARAMETERS par) {
+    invalidateCacheKeys();
     ValBase * vb = m_parlist[par].get();
     if (vb) {
       nc_assert( dynamic_cast<ValType*>(vb) );
@@ -668,7 +690,9 @@ struct NC::MatCfg::Impl {
       MatCfg::Impl::PAR_atomdb,
       MatCfg::Impl::PAR_dcutoff,
       MatCfg::Impl::PAR_dcutoffup,
+      MatCfg::Impl::PAR_emax,
       MatCfg::Impl::PAR_infofactory,
+      MatCfg::Impl::PAR_propsonly,
       MatCfg::Impl::PAR_temp
     };
     return &info_pars;
@@ -710,43 +734,69 @@ namespace NCrystal {
   std::array<std::string,MatCfg::Impl::PAR_NMAX> MatCfg::Impl::parnames = { "absnfactory",
                                                    "atomdb",
                                                    "coh_elas",
+                                                   "dbintol",
                                                    "dcutoff",
                                                    "dcutoffup",
                                                    "dir1",
                                                    "dir2",
                                                    "dirtol",
+                                                   "emax",
+                                                   "fgtab",
                                                    "incoh_elas",
                                                    "inelas",
                                                    "infofactory",
                                                    "lcaxis",
+                                                   "lcfixedrot",
                                                    "lcmode",
+                                                   "lctabprec",
                                                    "mos",
                                                    "mosprec",
+                                                   "mostab",
                                                    "packfact",
+                                                   "propsonly",
+                                                   "sabalias",
+                                                   "sabfloat32",
+                                                   "sabtinterp",
                                                    "scatfactory",
                                                    "sccutoff",
                                                    "temp",
-                                                   "vdoslux" };
+                                                   "vdoslux",
+                                                   "vdosthintol",
+                                                   "xsquant",
+                                                   "xstabprec" };
   std::array<MatCfg::Impl::VALTYPE,MatCfg::Impl::PAR_NMAX> MatCfg::Impl::partypes = { VALTYPE_STR,
                                                              VALTYPE_ATOMDB,
                                                              VALTYPE_BOOL,
                                                              VALTYPE_DBL,
                                                              VALTYPE_DBL,
+                                                             VALTYPE_DBL,
                                                              VALTYPE_ORIENTDIR,
                                                              VALTYPE_ORIENTDIR,
                                                              VALTYPE_DBL,
+                                                             VALTYPE_DBL,
+                                                             VALTYPE_BOOL,
                                                              VALTYPE_BOOL,
                                                              VALTYPE_STR,
                                                              VALTYPE_STR,
                                                              VALTYPE_VECTOR,
+                                                             VALTYPE_BOOL,
                                                              VALTYPE_INT,
                                                              VALTYPE_DBL,
                                                              VALTYPE_DBL,
                                                              VALTYPE_DBL,
+                                                             VALTYPE_BOOL,
+                                                             VALTYPE_DBL,
+                                                             VALTYPE_BOOL,
+                                                             VALTYPE_BOOL,
+                                                             VALTYPE_BOOL,
+                                                             VALTYPE_DBL,
                                                              VALTYPE_STR,
                                                              VALTYPE_DBL,
                                                              VALTYPE_DBL,
-                                                             VALTYPE_INT };
+                                                             VALTYPE_INT,
+                                                             VALTYPE_DBL,
+                                                             VALTYPE_DBL,
+                                                             VALTYPE_DBL };
   template<>
   void MatCfg::Impl::addUnitsForValType(ValDbl* vt, PARAMETERS par) {
     switch(par) {
@@ -848,6 +898,27 @@ void NC::MatCfg::checkConsistency() const
     NCRYSTAL_THROW(BadInput,"sccutoff must be >=0.0");
   if (parval_dirtol<=0.0||parval_dirtol>kPi)
     NCRYSTAL_THROW(BadInput,"dirtol must be in range (0.0,pi]");
+  const double parval_xstabprec = get_xstabprec();
+  if ( parval_xstabprec != 0.0 && ! (valueInInterval(0.9999e-9,0.10000001,parval_xstabprec) ) )
+    NCRYSTAL_THROW(BadInput,"xstabprec must be 0 or in the range [1e-9,1e-1].");
+  const double parval_xsquant = get_xsquant();
+  if ( parval_xsquant != 0.0 && ! (valueInInterval(0.9999e-9,0.10000001,parval_xsquant) ) )
+    NCRYSTAL_THROW(BadInput,"xsquant must be 0 or in the range [1e-9,1e-1].");
+  const double parval_vdosthintol = get_vdosthintol();
+  if ( parval_vdosthintol != 0.0 && ! (valueInInterval(0.9999e-9,0.10000001,parval_vdosthintol) ) )
+    NCRYSTAL_THROW(BadInput,"vdosthintol must be 0 or in the range [1e-9,1e-1].");
+  const double parval_dbintol = get_dbintol();
+  if ( parval_dbintol != 0.0 && ! (valueInInterval(0.9999e-9,0.10000001,parval_dbintol) ) )
+    NCRYSTAL_THROW(BadInput,"dbintol must be 0 or in the range [1e-9,1e-1].");
+  const double parval_emax = get_emax();
+  if ( parval_emax != 0.0 && ! (valueInInterval(0.9999e-5,1.0000001e3,parval_emax) ) )
+    NCRYSTAL_THROW(BadInput,"emax must be 0 or in the range [1e-5,1e3].");
+  const double parval_sabtinterp = get_sabtinterp();
+  if ( parval_sabtinterp != 0.0 && ! (valueInInterval(0.9999e-3,1.0000001e3,parval_sabtinterp) ) )
+    NCRYSTAL_THROW(BadInput,"sabtinterp must be 0 or in the range [1e-3,1e3].");
+  const double parval_lctabprec = get_lctabprec();
+  if ( parval_lctabprec != 0.0 && ! (valueInInterval(0.9999e-5,0.10000001,parval_lctabprec) ) )
+    NCRYSTAL_THROW(BadInput,"lctabprec must be 0 or in the range [1e-5,1e-1].");
   const double parval_mosprec = get_mosprec();
   if ( ! (valueInInterval(0.9999e-7,0.10000001,parval_mosprec) ) )
     NCRYSTAL_THROW(BadInput,"mosprec must be in the range [1e-7,1e-1].");
@@ -1005,35 +1076,84 @@ void NC::MatCfg::applyStrCfg( const std::string& str )
 
 void NC::MatCfg::Impl::applyStrCfg( const std::string& str )
 {
-  if (!isSimpleASCII(str,true,true))
-    NCRYSTAL_THROW(BadInput,"Non-ASCII characters in parameter specification!");
-
-  if (contains_any(str,NCMATCFG_FORBIDDEN_CHARS))
-    NCRYSTAL_THROW(BadInput,"Forbidden characters in parameter specification!");
-
-  VectS par_and_val;
-  VectS parts = split2(str,0,';');
-
-  for (size_t i = 0; i<parts.size();++i) {
-    trim(parts.at(i));
-    if (parts.at(i).empty()) {
+  //Single pass over the input, validating the characters and noting down the
+  //boundaries of the trimmed "name=value" parts (without allocating strings
+  //for the parts):
+  struct Part {
+    std::size_t b, e;//[b,e) is the trimmed part
+    std::size_t eq;//position of first '='
+    unsigned neq;//number of '=' chars
+  };
+  SmallVector<Part,16> partlist;
+  bool bad_ascii(false), bad_chars(false);
+  const char * data = str.data();
+  const std::size_t n = str.size();
+  auto isws = [](char c) { return c==' ' || c=='\t'|| c=='\r'|| c=='\n' ; };
+  auto trimRange = [data,&isws]( std::size_t& b, std::size_t& e )
+  {
+    while ( b < e && isws(data[b]) )
+      ++b;
+    while ( e > b && isws(data[e-1]) )
+      --e;
+  };
+  std::size_t partb(0), eq(0);
+  unsigned neq(0);
+  for ( std::size_t i = 0; i <= n; ++i ) {
+    if ( i == n || data[i] == ';' ) {
+      std::size_t b(partb), e(i);
+      trimRange(b,e);
       //be flexible and simply ignore missing parts (so for instance
       //MatCfg("myfile.ncmat;") will still work).
+      if ( b < e )
+        partlist.push_back( Part{ b, e, eq, neq } );
+      partb = i + 1;
+      neq = 0;
       continue;
     }
-    if (parts.at(i)=="ignorefilecfg") {
+    const char c = data[i];
+    if ( c < 32 ) {
+      if ( !( c=='\t' || c=='\n' || c=='\r' ) )
+        bad_ascii = true;
+    } else if ( c > 126 ) {
+      bad_ascii = true;
+    } else {
+      switch ( c ) {
+      case '"': case '\'': case '|': case '>': case '<': case '(':
+      case ')': case '{': case '}': case '[': case ']':
+        bad_chars = true;
+        break;
+      case '=':
+        if ( !neq++ )
+          eq = i;
+        break;
+      default:
+        break;
+      }
+    }
+  }
+  static_assert(sizeof(NCMATCFG_FORBIDDEN_CHARS)==12,"update switch above if changing NCMATCFG_FORBIDDEN_CHARS");
+
+  if ( bad_ascii )
+    NCRYSTAL_THROW(BadInput,"Non-ASCII characters in parameter specification!");
+
+  if ( bad_chars )
+    NCRYSTAL_THROW(BadInput,"Forbidden characters in parameter specification!");
+
+  for ( const auto& part : partlist ) {
+    const std::size_t len = part.e - part.b;
+    if ( len == 13 && str.compare(part.b,len,"ignorefilecfg") == 0 ) {
       NCRYSTAL_THROW2(BadInput,"The \"ignorefilecfg\" keyword can only be used in the MatCfg "
                       "constructor (and only directly after the filename)");
     }
-    split(par_and_val,parts.at(i),0,'=');
-    if (par_and_val.size()!=2) {
-      NCRYSTAL_THROW2(BadInput,"Bad syntax in parameter specification: \""<<parts.at(i)<<"\"");
+    if ( part.neq != 1 ) {
+      NCRYSTAL_THROW2(BadInput,"Bad syntax in parameter specification: \""<<str.substr(part.b,len)<<"\"");
     }
-    trim(par_and_val.at(0));
-    trim(par_and_val.at(1));
-    if (par_and_val.at(0).empty())
+    std::size_t nb(part.b), ne(part.eq), vb(part.eq+1), ve(part.e);
+    trimRange(nb,ne);
+    trimRange(vb,ve);
+    if ( nb == ne )
       NCRYSTAL_THROW(BadInput,"Missing parameter name");
-    this->setValByStr(par_and_val.at(0),par_and_val.at(1));
+    this->setValByStr( str.substr(nb,ne-nb), str.substr(vb,ve-vb) );
   }
 }
 
@@ -1101,13 +1221,101 @@ NC::MatCfg::MatCfg( from_raw_t, std::string&& data, std::string pars, std::strin
 {
 }
 
+namespace NCrystal {
+  namespace {
+
+    //Memo of recently constructed MatCfg objects, since applications
+    //typically process the same configuration strings repeatedly. Entries
+    //are keyed on the TextDataUID of the input data (thus any change to the
+    //data results in a new key) along with the original file name and
+    //parameter string, and are kept as thinned objects sharing the parsed
+    //internal data:
+    class MatCfgParseMemo {
+    public:
+      Optional<MatCfg> lookup( uint64_t uid, const std::string& origfn, const std::string& pars )
+      {
+        NCRYSTAL_LOCK_GUARD(m_mtx);
+        for ( std::size_t i = 0; i < m_entries.size(); ++i ) {
+          const Entry& e = m_entries[i];
+          if ( e.uid == uid && e.pars == pars && e.origfn == origfn ) {
+            ++m_nhits;
+            //Move to front (most recently used):
+            std::rotate( m_entries.begin(), m_entries.begin() + i, m_entries.begin() + i + 1 );
+            return m_entries.front().cfg;
+          }
+        }
+        ++m_nmisses;
+        return NullOpt;
+      }
+      void store( uint64_t uid, std::string origfn, std::string pars, MatCfg cfg )
+      {
+        NCRYSTAL_LOCK_GUARD(m_mtx);
+        if ( m_entries.size() >= nmax )
+          m_entries.pop_back();
+        m_entries.insert( m_entries.begin(), Entry{ uid, std::move(origfn), std::move(pars), std::move(cfg) } );
+      }
+      void clear()
+      {
+        NCRYSTAL_LOCK_GUARD(m_mtx);
+        m_entries.clear();
+      }
+      FactoryCacheStats stats()
+      {
+        NCRYSTAL_LOCK_GUARD(m_mtx);
+        FactoryCacheStats s;
+        s.name = "MatCfgParseMemo";
+        s.nstrongrefs = s.nentries = m_entries.size();
+        s.nhits = m_nhits;
+        s.nmisses = m_nmisses;
+        return s;
+      }
+    private:
+      static constexpr std::size_t nmax = 64;
+      struct Entry {
+        uint64_t uid;
+        std::string origfn, pars;
+        MatCfg cfg;
+      };
+      std::mutex m_mtx;
+      std::vector<Entry> m_entries;
+      uint64_t m_nhits = 0, m_nmisses = 0;
+    };
+
+    MatCfgParseMemo& matCfgParseMemo()
+    {
+      static MatCfgParseMemo s_memo;
+      static bool s_registered = [](){
+        registerCacheCleanupFunction( [](){ s_memo.clear(); } );
+        registerFactoryCacheStatsFunction( [](){ return s_memo.stats(); } );
+        return true;
+      }();
+      (void)s_registered;
+      return s_memo;
+    }
+  }
+}
+
 NC::MatCfg::MatCfg( constructor_args&& args )
 {
+  const TextData& textData = *args.td;
+
+  //Reuse the parsed data of an identical recent request if possible:
+  const uint64_t memo_uid = ( FactImpl::getCachingEnabled() ? textData.dataUID().value() : 0 );
+  std::string memo_pars;
+  if ( memo_uid ) {
+    auto hit = matCfgParseMemo().lookup( memo_uid, args.origfn, args.pars );
+    if ( hit.has_value() ) {
+      m_impl = std::move(hit.value().m_impl);
+      m_textDataSP = std::move(args.td);
+      return;
+    }
+    memo_pars = args.pars;
+  }
+
   auto mod = m_impl.modifyWithoutLocking();//we just constructed m_impl from
                                            //scratch, no need to lock as no one
                                            //else can refer to it.
 
-  const TextData& textData = *args.td;
   m_textDataSP = std::move(args.td);
 
   //Cache TextData meta data which should remain even if thinned:
@@ -1134,6 +1342,11 @@ NC::MatCfg::MatCfg( constructor_args&& args )
 
   if (!cfgstr.empty())
     mod->applyStrCfg( cfgstr );
+
+  if ( memo_uid ) {
+    { auto release_mod = std::move(mod); }//done modifying
+    matCfgParseMemo().store( memo_uid, args.origfn, std::move(memo_pars), cloneThinned() );
+  }
 }
 
 std::string NC::MatCfg::Impl::extractFileCfgStr( const TextData& input ) const
@@ -1176,6 +1389,7 @@ double NC::MatCfg::get_dcutoffup() const { return m_impl->getVal<Impl::ValDbl>(I
 double NC::MatCfg::get_packfact() const { return m_impl->getVal<Impl::ValDbl>(Impl::PAR_packfact,1.0); }
 NC::MosaicityFWHM NC::MatCfg::get_mos() const { return MosaicityFWHM{ m_impl->getValNoFallback<Impl::ValDbl>(Impl::PAR_mos) }; }
 double NC::MatCfg::get_mosprec() const { return m_impl->getVal<Impl::ValDbl>(Impl::PAR_mosprec,1e-3); }
+bool NC::MatCfg::get_mostab() const { return m_impl->getVal<Impl::ValBool>(Impl::PAR_mostab,false); }
 double NC::MatCfg::get_sccutoff() const { return m_impl->getVal<Impl::ValDbl>(Impl::PAR_sccutoff,0.4); }
 double NC::MatCfg::get_dirtol() const { return m_impl->getVal<Impl::ValDbl>(Impl::PAR_dirtol,1e-4); }
 bool NC::MatCfg::get_coh_elas() const { return m_impl->getVal<Impl::ValBool>(Impl::PAR_coh_elas,true); }
@@ -1195,6 +1409,7 @@ void NC::MatCfg::set_dcutoffup( double v ) { auto mod = m_impl.modify(); mod->se
 void NC::MatCfg::set_packfact( double v ) { auto mod = m_impl.modify(); mod->setVal<Impl::ValDbl>(Impl::PAR_packfact,v); }
 void NC::MatCfg::set_mos( MosaicityFWHM v ) { auto mod = m_impl.modify(); mod->setVal<Impl::ValDbl>(Impl::PAR_mos,v.dbl()); }
 void NC::MatCfg::set_mosprec( double v ) { auto mod = m_impl.modify(); mod->setVal<Impl::ValDbl>(Impl::PAR_mosprec,v); }
+void NC::MatCfg::set_mostab( bool v ) { auto mod = m_impl.modify(); mod->setVal<Impl::ValBool>(Impl::PAR_mostab,v); }
 void NC::MatCfg::set_sccutoff( double v ) { auto mod = m_impl.modify(); mod->setVal<Impl::ValDbl>(Impl::PAR_sccutoff,v); }
 void NC::MatCfg::set_dirtol( double v ) { auto mod = m_impl.modify(); mod->setVal<Impl::ValDbl>(Impl::PAR_dirtol,v); }
 void NC::MatCfg::set_coh_elas( bool v ) { auto mod = m_impl.modify(); mod->setVal<Impl::ValBool>(Impl::PAR_coh_elas,v); }
@@ -1205,8 +1420,32 @@ void NC::MatCfg::set_scatfactory( const std::string& v ) { auto mod = m_impl.mod
 void NC::MatCfg::set_absnfactory( const std::string& v ) { auto mod = m_impl.modify(); mod->setVal<Impl::ValStr>(Impl::PAR_absnfactory,v); }
 void NC::MatCfg::set_lcmode( int v ) { auto mod = m_impl.modify(); mod->setVal<Impl::ValInt>(Impl::PAR_lcmode,v); }
 int NC::MatCfg::get_lcmode() const { return m_impl->getVal<Impl::ValInt>(Impl::PAR_lcmode,0); }
+void NC::MatCfg::set_lcfixedrot( bool v ) { auto mod = m_impl.modify(); mod->setVal<Impl::ValBool>(Impl::PAR_lcfixedrot,v); }
+bool NC::MatCfg::get_lcfixedrot() const { return m_impl->getVal<Impl::ValBool>(Impl::PAR_lcfixedrot,false); }
+void NC::MatCfg::set_lctabprec( double v ) { auto mod = m_impl.modify(); mod->setVal<Impl::ValDbl>(Impl::PAR_lctabprec,v); }
+double NC::MatCfg::get_lctabprec() const { return m_impl->getVal<Impl::ValDbl>(Impl::PAR_lctabprec,0.0); }
 void NC::MatCfg::set_vdoslux( int v ) { auto mod = m_impl.modify(); mod->setVal<Impl::ValInt>(Impl::PAR_vdoslux,v); }
 int NC::MatCfg::get_vdoslux() const { return m_impl->getVal<Impl::ValInt>(Impl::PAR_vdoslux,3); }
+void NC::MatCfg::set_vdosthintol( double v ) { auto mod = m_impl.modify(); mod->setVal<Impl::ValDbl>(Impl::PAR_vdosthintol,v); }
+double NC::MatCfg::get_vdosthintol() const { return m_impl->getVal<Impl::ValDbl>(Impl::PAR_vdosthintol,0.0); }
+void NC::MatCfg::set_sabalias( bool v ) { auto mod = m_impl.modify(); mod->setVal<Impl::ValBool>(Impl::PAR_sabalias,v); }
+bool NC::MatCfg::get_sabalias() const { return m_impl->getVal<Impl::ValBool>(Impl::PAR_sabalias,false); }
+void NC::MatCfg::set_sabfloat32( bool v ) { auto mod = m_impl.modify(); mod->setVal<Impl::ValBool>(Impl::PAR_sabfloat32,v); }
+bool NC::MatCfg::get_sabfloat32() const { return m_impl->getVal<Impl::ValBool>(Impl::PAR_sabfloat32,false); }
+void NC::MatCfg::set_fgtab( bool v ) { auto mod = m_impl.modify(); mod->setVal<Impl::ValBool>(Impl::PAR_fgtab,v); }
+bool NC::MatCfg::get_fgtab() const { return m_impl->getVal<Impl::ValBool>(Impl::PAR_fgtab,false); }
+void NC::MatCfg::set_dbintol( double v ) { auto mod = m_impl.modify(); mod->setVal<Impl::ValDbl>(Impl::PAR_dbintol,v); }
+double NC::MatCfg::get_dbintol() const { return m_impl->getVal<Impl::ValDbl>(Impl::PAR_dbintol,0.0); }
+void NC::MatCfg::set_propsonly( bool v ) { auto mod = m_impl.modify(); mod->setVal<Impl::ValBool>(Impl::PAR_propsonly,v); }
+bool NC::MatCfg::get_propsonly() const { return m_impl->getVal<Impl::ValBool>(Impl::PAR_propsonly,false); }
+void NC::MatCfg::set_emax( double v ) { auto mod = m_impl.modify(); mod->setVal<Impl::ValDbl>(Impl::PAR_emax,v); }
+double NC::MatCfg::get_emax() const { return m_impl->getVal<Impl::ValDbl>(Impl::PAR_emax,0.0); }
+void NC::MatCfg::set_sabtinterp( double v ) { auto mod = m_impl.modify(); mod->setVal<Impl::ValDbl>(Impl::PAR_sabtinterp,v); }
+double NC::MatCfg::get_sabtinterp() const { return m_impl->getVal<Impl::ValDbl>(Impl::PAR_sabtinterp,0.0); }
+void NC::MatCfg::set_xstabprec( double v ) { auto mod = m_impl.modify(); mod->setVal<Impl::ValDbl>(Impl::PAR_xstabprec,v); }
+double NC::MatCfg::get_xstabprec() const { return m_impl->getVal<Impl::ValDbl>(Impl::PAR_xstabprec,0.0); }
+void NC::MatCfg::set_xsquant( double v ) { auto mod = m_impl.modify(); mod->setVal<Impl::ValDbl>(Impl::PAR_xsquant,v); }
+double NC::MatCfg::get_xsquant() const { return m_impl->getVal<Impl::ValDbl>(Impl::PAR_xsquant,0.0); }
 
 const std::string& NC::MatCfg::get_atomdb() const {
   const Impl::ValAtomDB * vt = m_impl->getValType<Impl::ValAtomDB>(Impl::PAR_atomdb);
@@ -1370,6 +1609,17 @@ NC::MatCfg NC::MatCfg::cloneThinned() const
   return cfg;
 }
 
+NC::MatCfg NC::MatCfg::cloneWithoutPackfact() const
+{
+  MatCfg cfg(*this);
+  if ( cfg.m_impl->hasPar(Impl::PAR_packfact) ) {
+    auto modimpl = cfg.m_impl.modify();
+    modimpl->invalidateCacheKeys();
+    modimpl->m_parlist[Impl::PAR_packfact].reset();
+  }
+  return cfg;
+}
+
 NC::TextDataSP NC::MatCfg::textDataSP() const
 {
   if ( m_textDataSP == nullptr )
@@ -1384,7 +1634,10 @@ bool NC::MatCfg::Impl::compareIgnoringTextDataUID(const MatCfg& o, const MatCfg:
   if ( this == oimpl )
     return false;//same internal data instance, must be equal
 
-  if ( this->m_datafile_orig != oimpl->m_datafile_orig )
+  //The file name as originally specified only matters in the absence of a
+  //TextDataUID, since objects sharing a UID have identical data (possibly from
+  //differently named sources, see FactImpl::setTextDataDeduplicationEnabled):
+  if ( m_textDataUID.isUnset() && this->m_datafile_orig != oimpl->m_datafile_orig )
     return this->m_datafile_orig < oimpl->m_datafile_orig;
   if ( this->m_textDataType != oimpl->m_textDataType )
     return this->m_textDataType < oimpl->m_textDataType;
@@ -1417,6 +1670,56 @@ bool NC::MatCfg::Impl::compareIgnoringTextDataUID(const MatCfg& o, const MatCfg:
   return false;
 }
 
+NC::MatCfg::CacheKeySP NC::MatCfg::Impl::getCacheKey( const MatCfg::Impl::ParametersSet * only_pars ) const
+{
+  //NB: Must be kept consistent with compareIgnoringTextDataUID!
+  NCRYSTAL_LOCK_GUARD(m_cacheKeyMutex);
+  MatCfg::CacheKeySP& cached = ( only_pars ? m_cacheKeyInfo : m_cacheKey );
+  if ( cached != nullptr )
+    return cached;
+  std::string str;
+  auto addField = [&str]( const std::string& f )
+  {
+    //Length-prefixed to keep the encoding unambiguous:
+    str += std::to_string(f.size());
+    str += ':';
+    str += f;
+  };
+  str += std::to_string( m_textDataUID.value() );
+  str += ( m_ignoredfilecfg ? 'I' : '_' );
+  if ( m_textDataUID.isUnset() )
+    addField( m_datafile_orig );
+  addField( m_textDataType );
+  for (int i = PAR_FIRST; i<PAR_NMAX; ++i) {
+    ValBase * vb = m_parlist[i].get();
+    if ( !vb )
+      continue;
+    if ( only_pars && only_pars->count(static_cast<decltype(PAR_FIRST)>(i))==0 )
+      continue;
+    str += std::to_string(i);
+    str += '=';
+    addField( vb->to_strrep(true) );
+  }
+  //64 bit FNV-1a hash:
+  uint64_t hash = 0xcbf29ce484222325ull;
+  for ( char c : str ) {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= 0x100000001b3ull;
+  }
+  cached = std::make_shared<const MatCfg::CacheKey>( MatCfg::CacheKey{ hash, std::move(str) } );
+  return cached;
+}
+
+NC::MatCfg::CacheKeySP NC::MatCfg::cacheKey() const
+{
+  return m_impl->getCacheKey( nullptr );
+}
+
+NC::MatCfg::CacheKeySP NC::MatInfoCfg::cacheKey() const
+{
+  return m_cfg.m_impl->getCacheKey( MatCfg::Impl::onlyInfoPars() );
+}
+
 bool NC::MatCfg::operator<( const MatCfg& o ) const
 {
   if ( m_impl->m_textDataUID != o.m_impl->m_textDataUID )
@@ -19,10 +19,12 @@
 ////////////////////////////////////////////////////////////////////////////////
 
 #include "NCrystal/internal/NCMath.hh"
+#include "NCrystal/internal/NCCPUDispatch.hh"
 #include "NCrystal/internal/NCRotMatrix.hh"
 #include "NCrystal/internal/NCIter.hh"
 #include <sstream>
 #include <list>
+#include <cstring>
 
 namespace NC = NCrystal;
 
@@ -257,6 +259,138 @@ double NC::sin_mpi8pi8(double x)
               )))))));
 }
 
+namespace NCrystal {
+  namespace {
+    //For conversion to/from bit patterns without UB (optimised away):
+    NCRYSTAL_KERNEL_INLINE uint64_t mathkernel_d2u( double x ) { uint64_t u; std::memcpy(&u,&x,sizeof(u)); return u; }
+    NCRYSTAL_KERNEL_INLINE double mathkernel_u2d( uint64_t u ) { double x; std::memcpy(&x,&u,sizeof(x)); return x; }
+    //Adding and subtracting this rounds to nearest integer (for |x|<2^51),
+    //leaving the integer in the lower bits of the intermediate value:
+    constexpr double mathkernel_round_magic = 6755399441055744.0;//1.5*2^52
+  }
+}
+
+//NB: The main loops below contain no floating point comparisons (which would
+//prevent vectorisation unless compiling with -fno-trapping-math). Instead, the
+//results for out-of-range input values are simply overwritten afterwards.
+
+namespace NCrystal {
+  namespace {
+    //Elementwise kernels for exp_many/log_many/sincos_many, compiled for
+    //several instruction sets (see NCCPUDispatch.hh):
+
+    struct ExpKernel {
+      NCRYSTAL_KERNEL_INLINE static void eval( const double* x, double* out, double*, std::size_t i )
+      {
+        const uint64_t magic_bits = mathkernel_d2u( mathkernel_round_magic );
+        //x = k*ln(2) + r, with |r|<=ln(2)/2 and exp(x) = 2^k * exp(r):
+        const double t = x[i] * 1.44269504088896340736 + mathkernel_round_magic;//1/ln(2)
+        const double k = t - mathkernel_round_magic;
+        const uint64_t kbits = mathkernel_d2u(t) - magic_bits + 1023;
+        const double r = ( x[i] - k * 6.93147180369123816490e-01 ) - k * 1.90821492927058770002e-10;//ln2 split in hi+lo
+        //13th order Taylor expansion (error < 1e-17 for |r|<=ln(2)/2):
+        const double p = 1.0+r*(1.0+r*(1.0/2+r*(1.0/6+r*(1.0/24+r*(1.0/120+r*(1.0/720+r*(1.0/5040
+                         +r*(1.0/40320+r*(1.0/362880+r*(1.0/3628800+r*(1.0/39916800
+                         +r*(1.0/479001600+r*(1.0/6227020800.0)))))))))))));
+        out[i] = p * mathkernel_u2d( kbits << 52 );
+      }
+    };
+
+    struct LogKernel {
+      NCRYSTAL_KERNEL_INLINE static void eval( const double* x, double* out, double*, std::size_t i )
+      {
+        constexpr uint64_t mantissa_mask = 0x000FFFFFFFFFFFFFull;
+        constexpr uint64_t mantissa_sqrt2 = 0x0006A09E667F3BCDull;//mantissa bits of sqrt(2)
+        const uint64_t magic_bits = mathkernel_d2u( mathkernel_round_magic );
+        //x = m * 2^e, with m in [sqrt(0.5),sqrt(2)):
+        const uint64_t bits = mathkernel_d2u( x[i] );
+        const uint64_t mantissa = bits & mantissa_mask;
+        const uint64_t large = ( mantissa + ( mantissa_mask - mantissa_sqrt2 ) ) >> 52;//1 if m>sqrt(2)
+        const double m = mathkernel_u2d( mantissa | ( ( 1023 - large ) << 52 ) );
+        const uint64_t ebits = ( ( bits >> 52 ) & 0x7FF ) + large;//biased exponent
+        const double e = mathkernel_u2d( magic_bits + ebits ) - ( mathkernel_round_magic + 1023.0 );
+        //log(m) = 2*atanh(s) with s = (m-1)/(m+1), |s|<=0.1716, and summing
+        //terms up to s^21 (error < 1e-17):
+        const double s = ( m - 1.0 ) / ( m + 1.0 );
+        const double z = s * s;
+        const double logm = 2.0*s*(1.0+z*(1.0/3+z*(1.0/5+z*(1.0/7+z*(1.0/9+z*(1.0/11+z*(1.0/13
+                            +z*(1.0/15+z*(1.0/17+z*(1.0/19+z*(1.0/21)))))))))));
+        out[i] = e * 6.93147180369123816490e-01 + ( logm + e * 1.90821492927058770002e-10 );
+      }
+    };
+
+    struct SinCosKernel {
+      NCRYSTAL_KERNEL_INLINE static void eval( const double* x, double* out_cos, double* out_sin, std::size_t i )
+      {
+        const uint64_t magic_bits = mathkernel_d2u( mathkernel_round_magic );
+        //x = q*pi/2 + r, with |r|<=pi/4. Splitting pi/2 in three parts (the first
+        //two with 33 significant bits) makes r accurate for |q|<2^20:
+        const double t = x[i] * 0.636619772367581343076 + mathkernel_round_magic;//2/pi
+        const double q = t - mathkernel_round_magic;
+        const uint64_t qi = mathkernel_d2u(t) - magic_bits;
+        const double r = ( ( x[i] - q * 1.57079632673412561417e+00 )
+                           - q * 6.07710050630396597660e-11 ) - q * 2.02226624879595063154e-21;
+        //Taylor expansions (errors < 1e-16 for |r|<=pi/4):
+        const double r2 = r * r;
+        const double sr = r*(1.0-r2*(1.0/6-r2*(1.0/120-r2*(1.0/5040-r2*(1.0/362880-r2*(1.0/39916800
+                          -r2*(1.0/6227020800.0-r2*(1.0/1307674368000.0))))))));
+        const double cr = 1.0-r2*(1.0/2-r2*(1.0/24-r2*(1.0/720-r2*(1.0/40320-r2*(1.0/3628800-r2*(1.0/479001600
+                          -r2*(1.0/87178291200.0-r2*(1.0/20922789888000.0))))))));
+        //Select according to quadrant (swapping and flipping signs as needed):
+        const uint64_t swapmask = uint64_t(0) - ( qi & 1 );
+        const uint64_t srbits = mathkernel_d2u( sr );
+        const uint64_t crbits = mathkernel_d2u( cr );
+        const uint64_t svbits = ( srbits & ~swapmask ) | ( crbits & swapmask );
+        const uint64_t cvbits = ( crbits & ~swapmask ) | ( srbits & swapmask );
+        out_sin[i] = mathkernel_u2d( svbits ^ ( ( qi & 2 ) << 62 ) );
+        out_cos[i] = mathkernel_u2d( cvbits ^ ( ( ( qi + 1 ) & 2 ) << 62 ) );
+      }
+    };
+  }
+}
+
+void NC::exp_many( Span<const double> xs, double* out )
+{
+  constexpr double xmin = -708.0;
+  constexpr double xmax = 709.0;
+  const std::size_t n = static_cast<std::size_t>( xs.size() );
+  const double * x = xs.data();
+  static const CPUDispatch::KernelFct s_kernel = CPUDispatch::selectKernel<ExpKernel>();
+  s_kernel( x, out, nullptr, n );
+  for ( std::size_t i = 0; i < n; ++i )
+    if ( !( x[i] >= xmin && x[i] <= xmax ) )
+      out[i] = std::exp( x[i] );
+}
+
+void NC::log_many( Span<const double> xs, double* out )
+{
+  constexpr double xmin = std::numeric_limits<double>::min();
+  constexpr double xmax = std::numeric_limits<double>::max();
+  const std::size_t n = static_cast<std::size_t>( xs.size() );
+  const double * x = xs.data();
+  static const CPUDispatch::KernelFct s_kernel = CPUDispatch::selectKernel<LogKernel>();
+  s_kernel( x, out, nullptr, n );
+  for ( std::size_t i = 0; i < n; ++i )
+    if ( !( x[i] >= xmin && x[i] <= xmax ) )
+      out[i] = std::log( x[i] );
+}
+
+void NC::sincos_many( Span<const double> xs, double* out_cos, double* out_sin )
+{
+  constexpr double xmax = 1e5;
+  const std::size_t n = static_cast<std::size_t>( xs.size() );
+  const double * x = xs.data();
+  static const CPUDispatch::KernelFct s_kernel = CPUDispatch::selectKernel<SinCosKernel>();
+  s_kernel( x, out_cos, out_sin, n );
+  for ( std::size_t i = 0; i < n; ++i ) {
+    if ( !( ncabs( x[i] ) <= xmax ) ) {
+      const double xx = x[i];
+      out_cos[i] = std::cos( xx );
+      out_sin[i] = std::sin( xx );
+    }
+  }
+}
+
 double NC::estimateDerivative(const Fct1D* f, double x, double h, unsigned order)
 {
   nc_assert(f);
@@ -430,9 +564,12 @@ std::pair<NC::VectD,NC::VectD> NC::reducePtsInDistribution( const NC::VectD& x,
   const double inv_ymax = 1.0/ymax;
 
   //Put point-data (including caches of expensive std::log results) into
-  //doubly linked list:
+  //doubly linked list. The many list and map nodes are allocated from a
+  //MemPool and released at once at the end:
   struct PtData;
-  typedef std::multimap<double,std::list<PtData>::iterator> ImpMap_t;
+  using PtList_t = std::list<PtData,MemPoolAllocator<PtData>>;
+  using ImpMap_t = std::multimap<double,PtList_t::iterator,std::less<double>,
+                                 MemPoolAllocator<std::pair<const double,PtList_t::iterator>>>;
   struct PtData {
     double x,y,lny;
     ImpMap_t::iterator impMapIter;
@@ -440,8 +577,10 @@ std::pair<NC::VectD,NC::VectD> NC::reducePtsInDistribution( const NC::VectD& x,
       :x(x_), y(y_), lny(lny_), impMapIter(it_) {}
   };
 
-  std::list<PtData> pts;
-  ImpMap_t importanceMap;
+  MemPool pool( 1048576 );
+  MemPoolAllocator<PtData> poolalloc( &pool );
+  PtList_t pts( poolalloc );
+  ImpMap_t importanceMap( std::less<double>(), poolalloc );
 
   for ( auto&& e: enumerate(x) ) {
     double xval(e.val), yval(y.at(e.idx));
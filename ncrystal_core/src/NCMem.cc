@@ -20,8 +20,12 @@
 
 #include "NCrystal/NCMem.hh"
 #include "NCrystal/NCDefs.hh"
+#include "NCrystal/internal/NCThreadUtils.hh"
 #include <vector>
 #include <mutex>
+#ifndef _WIN32
+#  include <stdlib.h>
+#endif
 
 namespace NC = NCrystal;
 
@@ -29,6 +33,9 @@ namespace NCrystal {
   namespace {
     static std::mutex s_cacheCleanerMutex;
     static std::vector<std::function<void()>> s_cacheCleanerMutexFcts;
+    //Set while the cleanup functions are invoked by clearCachesAsync (in the
+    //same thread):
+    thread_local bool s_disposeInBackground = false;
   }
 }
 
@@ -39,6 +46,33 @@ void NC::clearCaches()
     f();
 }
 
+void NC::clearCachesAsync()
+{
+  NCRYSTAL_LOCK_GUARD(s_cacheCleanerMutex);
+  s_disposeInBackground = true;
+  try {
+    for (auto& f : s_cacheCleanerMutexFcts)
+      f();
+  } catch (...) {
+    s_disposeInBackground = false;
+    throw;
+  }
+  s_disposeInBackground = false;
+}
+
+void NC::disposeReleasedCacheObjects( std::vector<std::shared_ptr<const void>>&& objs )
+{
+  if ( objs.empty() )
+    return;
+  if ( !s_disposeInBackground ) {
+    objs.clear();
+    return;
+  }
+  //NB: std::function requires copyable callables, so wrap in shared_ptr:
+  auto sp = std::make_shared<std::vector<std::shared_ptr<const void>>>( std::move(objs) );
+  runInBackground( [sp]() { sp->clear(); } );
+}
+
 void NC::registerCacheCleanupFunction( std::function<void()> f )
 {
   NCRYSTAL_LOCK_GUARD(s_cacheCleanerMutex);
@@ -65,9 +99,17 @@ void * NC::detail::bigAlignedAlloc( std::size_t alignment, std::size_t size )
   //from std:: namespace:
   //    result = std::aligned_alloc(alignment,size);
   result = aligned_alloc(alignment,size);
+#endif
+#ifndef _WIN32
+  //posix_memalign is available regardless of C++ standard, and (unlike the
+  //over-allocation below) returns memory which can be released with std::free
+  //(alignment is here always a power of two larger than sizeof(void*)):
+  if ( result == nullptr && posix_memalign( &result, alignment, size ) != 0 )
+    result = nullptr;
 #endif
   if ( result == nullptr ) {
-    //Try to over allocate and then trim off something:
+    //Last resort on platforms without posix_memalign. Try to over allocate and
+    //then trim off something (NB: the result can not be passed to std::free):
     std::size_t sa = size+alignment;
     void * buf = std::malloc(sa);
     if ( buf != nullptr ) {
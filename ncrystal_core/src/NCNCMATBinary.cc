@@ -0,0 +1,330 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+//  This file is part of NCrystal (see https://mctools.github.io/ncrystal/)   //
+//                                                                            //
+//  Copyright 2015-2021 NCrystal developers                                   //
+//                                                                            //
+//  Licensed under the Apache License, Version 2.0 (the "License");           //
+//  you may not use this file except in compliance with the License.          //
+//  You may obtain a copy of the License at                                   //
+//                                                                            //
+//      http://www.apache.org/licenses/LICENSE-2.0                            //
+//                                                                            //
+//  Unless required by applicable law or agreed to in writing, software       //
+//  distributed under the License is distributed on an "AS IS" BASIS,         //
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  //
+//  See the License for the specific language governing permissions and       //
+//  limitations under the License.                                            //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include "NCrystal/internal/NCNCMATBinary.hh"
+#include "NCrystal/NCParseNCMAT.hh"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace NC = NCrystal;
+
+namespace NCrystal {
+  namespace {
+
+    constexpr char s_magic[] = "\x89" "NCMATBIN\n";
+    constexpr std::size_t s_magic_len = sizeof(s_magic) - 1;
+    constexpr std::size_t s_payload_alignment = 8;
+    constexpr uint32_t s_endian_tag = 0x01020304;
+    constexpr uint32_t s_endian_tag_swapped = 0x04030201;
+
+    void swapBytes( void * data, std::size_t n )
+    {
+      char * b = static_cast<char*>(data);
+      std::reverse( b, b + n );
+    }
+
+    class BinWriter {
+    public:
+      BinWriter( std::string& out ) : m_out(out) {}
+      template<class T>
+      void pod( T val )
+      {
+        static_assert(std::is_trivially_copyable<T>::value,"");
+        m_out.append( reinterpret_cast<const char*>(&val), sizeof(T) );
+      }
+      void count( std::size_t n ) { pod<uint64_t>( n ); }
+      void str( const std::string& s ) { count( s.size() ); m_out.append( s ); }
+      void strs( const VectS& v ) { count( v.size() ); for ( auto& s : v ) str( s ); }
+      void dbls( const VectD& v )
+      {
+        count( v.size() );
+        m_out.append( reinterpret_cast<const char*>(v.data()), v.size()*sizeof(double) );
+      }
+    private:
+      std::string& m_out;
+    };
+
+    class BinReader {
+    public:
+      BinReader( const char * b, const char * e, const std::string& descr )
+        : m_c(b), m_e(e), m_descr(descr) {}
+      void setSwapBytes( bool b ) { m_swap = b; }
+      bool atEnd() const { return m_c == m_e; }
+      void raw( void * dest, std::size_t n )
+      {
+        if ( n > remaining() )
+          fail();
+        std::memcpy( dest, m_c, n );
+        m_c += n;
+      }
+      template<class T>
+      T pod()
+      {
+        static_assert(std::is_trivially_copyable<T>::value,"");
+        T val;
+        raw( &val, sizeof(T) );
+        if ( m_swap )
+          swapBytes( &val, sizeof(T) );
+        return val;
+      }
+      std::size_t count()
+      {
+        //Any entry occupies at least one byte, so larger counts indicate
+        //corrupted data (and must not trigger huge allocations):
+        uint64_t n = pod<uint64_t>();
+        if ( n > remaining() )
+          fail();
+        return static_cast<std::size_t>( n );
+      }
+      std::string str()
+      {
+        auto n = count();
+        std::string s( m_c, n );
+        m_c += n;
+        return s;
+      }
+      VectS strs()
+      {
+        VectS v;
+        v.resize( count() );
+        for ( auto& s : v )
+          s = str();
+        return v;
+      }
+      VectD dbls()
+      {
+        VectD v;
+        v.resize( count() );
+        raw( v.data(), v.size()*sizeof(double) );
+        if ( m_swap )
+          for ( auto& e : v )
+            swapBytes( &e, sizeof(double) );
+        return v;
+      }
+      void fail() const
+      {
+        NCRYSTAL_THROW2(BadInput,"Truncated or corrupted binary NCMAT data: "<<m_descr);
+      }
+    private:
+      std::size_t remaining() const { return static_cast<std::size_t>( m_e - m_c ); }
+      const char * m_c;
+      const char * m_e;
+      const std::string& m_descr;
+      bool m_swap = false;
+    };
+
+  }
+}
+
+bool NC::isNCMATBinaryData( const char * dataBegin, const char * dataEnd ) noexcept
+{
+  return static_cast<std::size_t>( dataEnd - dataBegin ) >= s_magic_len
+    && std::memcmp( dataBegin, s_magic, s_magic_len ) == 0;
+}
+
+std::string NC::encodeNCMATBinary( const NCMATData& data, const VectS& preambleLines )
+{
+  std::string out( s_magic, s_magic_len );
+  for ( auto& line : preambleLines ) {
+    if ( line.find_first_of( std::string("\r\n\0",3) ) != std::string::npos )
+      NCRYSTAL_THROW(BadInput,"Preamble lines for binary NCMAT data can not contain newline or null characters");
+    out += line;
+    out += '\n';
+  }
+  out += '\0';
+  if ( out.size() % s_payload_alignment )
+    out.append( s_payload_alignment - out.size() % s_payload_alignment, '\0' );
+
+  BinWriter w( out );
+  w.pod<uint32_t>( s_endian_tag );
+  w.pod<uint32_t>( ncmatBinaryFormatVersion );
+  w.pod<int32_t>( data.version );
+
+  for ( auto v : data.cell.lengths )
+    w.pod<double>( v );
+  for ( auto v : data.cell.angles )
+    w.pod<double>( v );
+
+  w.count( data.atompos.size() );
+  for ( auto& e : data.atompos ) {
+    w.str( e.first );
+    for ( auto v : e.second )
+      w.pod<double>( v );
+  }
+
+  w.pod<int32_t>( data.spacegroup );
+
+  w.pod<uint8_t>( data.debyetemp_global.has_value() ? 1 : 0 );
+  w.pod<double>( data.debyetemp_global.has_value() ? data.debyetemp_global.value().dbl() : 0.0 );
+  w.count( data.debyetemp_perelement.size() );
+  for ( auto& e : data.debyetemp_perelement ) {
+    w.str( e.first );
+    w.pod<double>( e.second.dbl() );
+  }
+
+  w.count( data.dyninfos.size() );
+  for ( auto& di : data.dyninfos ) {
+    w.pod<uint32_t>( static_cast<uint32_t>( di.dyninfo_type ) );
+    w.str( di.element_name );
+    w.pod<double>( di.fraction );
+    w.count( di.fields.size() );
+    for ( auto& f : di.fields ) {
+      w.str( f.first );
+      w.dbls( f.second );
+    }
+  }
+
+  w.pod<uint32_t>( static_cast<uint32_t>( data.density_unit ) );
+  w.pod<double>( data.density );
+
+  w.count( data.atomDBLines.size() );
+  for ( auto& line : data.atomDBLines )
+    w.strs( line );
+
+  w.count( data.customSections.size() );
+  for ( auto& cs : data.customSections ) {
+    w.str( cs.first );
+    w.count( cs.second.size() );
+    for ( auto& line : cs.second )
+      w.strs( line );
+  }
+
+  return out;
+}
+
+std::string NC::convertToNCMATBinary( const TextData& input )
+{
+  NCMATData data = parseNCMATData( input );
+  VectS preambleLines;
+  for ( const std::string& line : input ) {
+    if ( line.find("NCRYSTALMATCFG") != std::string::npos )
+      preambleLines.push_back( line );
+  }
+  return encodeNCMATBinary( data, preambleLines );
+}
+
+void NC::writeNCMATBinaryFile( const TextData& input, const std::string& path )
+{
+  std::string out = convertToNCMATBinary( input );
+  std::ofstream fh( path, std::ios_base::binary | std::ios_base::trunc );
+  if ( fh.good() )
+    fh.write( out.data(), out.size() );
+  if ( !fh.good() )
+    NCRYSTAL_THROW2(DataLoadError,"Could not write binary NCMAT file: "<<path);
+}
+
+NC::NCMATData NC::decodeNCMATBinary( const TextData& input, bool doFinalValidation )
+{
+  const std::string descr = input.description();
+  const char * b = input.rawData().begin();
+  const char * e = input.rawData().end();
+  if ( !isNCMATBinaryData( b, e ) )
+    NCRYSTAL_THROW2(BadInput,"Not binary NCMAT data: "<<descr);
+
+  //Skip preamble and padding:
+  std::size_t offset = static_cast<std::size_t>( std::find( b + s_magic_len, e, '\0' ) - b ) + 1;
+  if ( offset % s_payload_alignment )
+    offset += s_payload_alignment - offset % s_payload_alignment;
+  if ( offset > static_cast<std::size_t>( e - b ) )
+    NCRYSTAL_THROW2(BadInput,"Truncated or corrupted binary NCMAT data: "<<descr);
+  BinReader r( b + offset, e, descr );
+
+  const uint32_t endian_tag = r.pod<uint32_t>();
+  if ( endian_tag == s_endian_tag_swapped )
+    r.setSwapBytes( true );
+  else if ( endian_tag != s_endian_tag )
+    r.fail();
+  const uint32_t formatVersion = r.pod<uint32_t>();
+  if ( formatVersion != ncmatBinaryFormatVersion )
+    NCRYSTAL_THROW2(BadInput,"Unsupported binary NCMAT format version ("<<formatVersion
+                    <<", expected "<<ncmatBinaryFormatVersion<<") in: "<<descr
+                    <<" (it must be regenerated from the original .ncmat file)");
+
+  NCMATData data;
+  data.sourceDescription = descr;
+  data.version = r.pod<int32_t>();
+  if ( data.version < 1 || data.version > NCMATData::latest_version )
+    r.fail();
+
+  for ( auto& v : data.cell.lengths )
+    v = r.pod<double>();
+  for ( auto& v : data.cell.angles )
+    v = r.pod<double>();
+
+  data.atompos.resize( r.count() );
+  for ( auto& ap : data.atompos ) {
+    ap.first = r.str();
+    for ( auto& v : ap.second )
+      v = r.pod<double>();
+  }
+
+  data.spacegroup = r.pod<int32_t>();
+
+  const bool has_debyetemp_global = ( r.pod<uint8_t>() != 0 );
+  const double debyetemp_global = r.pod<double>();
+  if ( has_debyetemp_global )
+    data.debyetemp_global = DebyeTemperature{ debyetemp_global };
+  data.debyetemp_perelement.resize( r.count() );
+  for ( auto& dt : data.debyetemp_perelement ) {
+    dt.first = r.str();
+    dt.second = DebyeTemperature{ r.pod<double>() };
+  }
+
+  data.dyninfos.resize( r.count() );
+  for ( auto& di : data.dyninfos ) {
+    const uint32_t ditype = r.pod<uint32_t>();
+    if ( ditype >= static_cast<uint32_t>( NCMATData::DynInfo::Undefined ) )
+      r.fail();
+    di.dyninfo_type = static_cast<NCMATData::DynInfo::DynInfoType>( ditype );
+    di.element_name = r.str();
+    di.fraction = r.pod<double>();
+    auto nfields = r.count();
+    for ( std::size_t i = 0; i < nfields; ++i ) {
+      std::string key = r.str();
+      di.fields[key] = r.dbls();
+    }
+  }
+
+  const uint32_t density_unit = r.pod<uint32_t>();
+  if ( density_unit > static_cast<uint32_t>( NCMATData::KG_PER_M3 ) )
+    r.fail();
+  data.density_unit = static_cast<NCMATData::DensityUnit>( density_unit );
+  data.density = r.pod<double>();
+
+  data.atomDBLines.resize( r.count() );
+  for ( auto& line : data.atomDBLines )
+    line = r.strs();
+
+  data.customSections.resize( r.count() );
+  for ( auto& cs : data.customSections ) {
+    cs.first = r.str();
+    cs.second.resize( r.count() );
+    for ( auto& line : cs.second )
+      line = r.strs();
+  }
+
+  if ( !r.atEnd() )
+    r.fail();
+
+  if ( doFinalValidation )
+    data.validate();
+  return data;
+}
@@ -25,6 +25,16 @@
 #include "NCrystal/internal/NCIter.hh"
 namespace NC = NCrystal;
 
+void NC::NCMATData::DynInfo::decodeDeferredFields()
+{
+  for ( auto& e : deferredFields ) {
+    nc_assert_always( !fields.count(e.first) );
+    fields[e.first] = e.second();
+  }
+  deferredFields.clear();
+  deferredFieldTexts.clear();
+}
+
 void NC::NCMATData::DynInfo::validate() const
 {
   //Check that required fields were present:
@@ -43,7 +53,7 @@ void NC::NCMATData::DynInfo::validate() const
     requiredfields.insert("temperature");
     optionalfields.insert("egrid");
     //Must be exactly one sqw/sab/sab_scaled field:
-    bool sk_sab(fields.count("sab")), sk_sab_scaled(fields.count("sab_scaled")), sk_sqw(fields.count("sqw"));
+    bool sk_sab(hasField("sab")), sk_sab_scaled(hasField("sab_scaled")), sk_sqw(hasField("sqw"));
     auto nsk = (sk_sab?1:0) + (sk_sab_scaled?1:0) + (sk_sqw?1:0);
     if ( nsk > 1 )
       NCRYSTAL_THROW(BadInput,"Can not specify more than one of the following fields: \"sab\", \"sab_scaled\", and \"sqw\"");
@@ -71,17 +81,20 @@ void NC::NCMATData::DynInfo::validate() const
   {
     std::set<std::string>::const_iterator it(requiredfields.begin()),itE(requiredfields.end());
     for (;it!=itE;++it)
-      if (!fields.count(*it))
+      if (!hasField(*it))
         NCRYSTAL_THROW2(BadInput,"missing field \""<<*it<<"\" (always required for this type of dynamic info)");
   }
 
   //Check that no unexpected fields were present:
+  auto checkFieldName = [&requiredfields,&optionalfields](const std::string& fn)
   {
-    FieldMapT::const_iterator it(fields.begin()), itE(fields.end());
-    for (;it!=itE;++it)
-      if ( !requiredfields.count(it->first) && !optionalfields.count(it->first))
-        NCRYSTAL_THROW2(BadInput,"Invalid (at least for this type of dynamic info) field \""<<it->first<<"\" specified");
-  }
+    if ( !requiredfields.count(fn) && !optionalfields.count(fn) )
+      NCRYSTAL_THROW2(BadInput,"Invalid (at least for this type of dynamic info) field \""<<fn<<"\" specified");
+  };
+  for ( auto& e : fields )
+    checkFieldName(e.first);
+  for ( auto& e : deferredFields )
+    checkFieldName(e.first);
 
 
   //Validate specific entries:
@@ -140,7 +153,7 @@ void NC::NCMATData::DynInfo::validate() const
     if (fields.count("alphagrid")) {
       sa = "alphagrid";
       sb = "betagrid";
-      ssab = fields.count("sab") ? "sab" : "sab_scaled";
+      ssab = hasField("sab") ? "sab" : "sab_scaled";
     } else {
       sa = "qgrid";
       sb = "omegagrid";
@@ -149,16 +162,18 @@ void NC::NCMATData::DynInfo::validate() const
 
     auto& v_a = fields.at(sa);
     auto& v_b = fields.at(sb);
-    auto& v_sab = fields.at(ssab);
     if ( v_a.size() < 5 )
       NCRYSTAL_THROW2(BadInput,"too few "<<sa<<" parameters");
     if ( v_b.size() < 5 )
       NCRYSTAL_THROW2(BadInput,"too few "<<sb<<" parameters");
-    if ( v_sab.size()!=v_a.size()*v_b.size() )
-      NCRYSTAL_THROW2(BadInput,"number of "<<ssab<<" entries is not (size of "<<sa<<")*(size of "<<sb<<")");
     valvector(sa,v_a, true);
     valvector(sb,v_b, false);
-    valvector(ssab,v_sab, false);
+    if ( !deferredFields.count(ssab) ) {
+      auto& v_sab = fields.at(ssab);
+      if ( v_sab.size()!=v_a.size()*v_b.size() )
+        NCRYSTAL_THROW2(BadInput,"number of "<<ssab<<" entries is not (size of "<<sa<<")*(size of "<<sb<<")");
+      valvector(ssab,v_sab, false);
+    }
 
   }
 
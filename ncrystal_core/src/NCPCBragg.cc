@@ -28,22 +28,127 @@ namespace NCrystal
 {
   namespace {
     constexpr double dspacing_merge_tolerance = 1e-11;
+
+    class PCBraggCache final : public CacheBase {
+    public:
+      void invalidateCache() override { lastidx = 0; }
+      //Plane index found in the most recent search (always a valid index when
+      //the plane list is non-empty, so can be tested without bounds checks):
+      std::size_t lastidx = 0;
+    };
+
+    //Searches in Eytzinger layout (1-based array eytz of n entries). Returns
+    //the position of the first entry which is > x (upper) or >= x (lower), or
+    //0 if no such entry exists:
+    inline std::size_t eytzUpperBound( const double * eytz, std::size_t n, double x )
+    {
+      std::size_t k = 1;
+      while ( k <= n )
+        k = 2 * k + ( eytz[k] <= x ? 1 : 0 );
+      //Undo the final run of right-turns (plus one left-turn):
+      while ( k & 1 )
+        k >>= 1;
+      return k >> 1;
+    }
+
+    //Same as eytzUpperBound, but for g searches at once. The searches descend
+    //the tree in lockstep, prefetching the entries four levels below the
+    //current nodes (the 16 entries from index 16*k), so the cache misses of
+    //the different searches overlap rather than follow each other:
+    inline void eytzUpperBoundInterleaved( const double * eytz, std::size_t n,
+                                           const double * x, std::size_t * k,
+                                           std::size_t g )
+    {
+      for ( std::size_t j = 0; j < g; ++j )
+        k[j] = 1;
+      bool active = true;
+      while ( active ) {
+        active = false;
+        for ( std::size_t j = 0; j < g; ++j ) {
+          if ( k[j] > n )
+            continue;
+          ncprefetch( eytz + std::min<std::size_t>( 16 * k[j], n ) );
+          k[j] = 2 * k[j] + ( eytz[k[j]] <= x[j] ? 1 : 0 );
+          active = true;
+        }
+      }
+      for ( std::size_t j = 0; j < g; ++j ) {
+        while ( k[j] & 1 )
+          k[j] >>= 1;
+        k[j] >>= 1;
+      }
+    }
+
+    inline std::size_t eytzLowerBound( const double * eytz, std::size_t n, double x )
+    {
+      std::size_t k = 1;
+      while ( k <= n )
+        k = 2 * k + ( eytz[k] < x ? 1 : 0 );
+      while ( k & 1 )
+        k >>= 1;
+      return k >> 1;
+    }
+  }
+}
+
+void NC::PCBragg::initSearchIndex()
+{
+  nc_assert_always( m_2dE.size() == m_fdm_commul.size() );
+  const std::size_t n = m_2dE.size();
+  if ( n >= std::numeric_limits<std::uint32_t>::max() )
+    NCRYSTAL_THROW(CalcError,"Too many planes in PCBragg.");
+  VectD e2dE, efdm;
+  std::vector<std::uint32_t> eperm;
+  if ( n ) {
+    e2dE.resize( n + 1, 0.0 );
+    efdm.resize( n + 1, 0.0 );
+    eperm.resize( n + 1, static_cast<std::uint32_t>(n) );
+    //In-order traversal of the implicit tree visits the sorted entries in
+    //order (iterative, using the fact that the depth is at most ~32):
+    std::size_t i = 0;
+    std::size_t k = 1;
+    while ( i < n ) {
+      while ( 2 * k <= n )
+        k *= 2;//descend left as far as possible
+      for (;;) {
+        e2dE[k] = m_2dE[i];
+        efdm[k] = m_fdm_commul[i];
+        eperm[k] = static_cast<std::uint32_t>(i);
+        ++i;
+        if ( 2 * k + 1 <= n ) {
+          k = 2 * k + 1;//right subtree, then descend left again
+          break;
+        }
+        //climb up until we arrive from a left child:
+        while ( k & 1 )
+          k >>= 1;
+        k >>= 1;
+        if ( !k )
+          break;
+      }
+    }
+    nc_assert_always( i == n );
   }
+  m_eytz_2dE.swap( e2dE );
+  m_eytz_fdm.swap( efdm );
+  m_eytz_perm.swap( eperm );
 }
 
-void NC::PCBragg::init( const StructureInfo& si, VectDFM&& data )
+void NC::PCBragg::init( const StructureInfo& si, VectDFM&& data, double dbintol )
 {
   nc_assert_always(si.n_atoms>0);
   nc_assert_always(si.volume>0);
   if (!(si.volume>0) || !(si.n_atoms>=1) )
     NCRYSTAL_THROW(BadInput,"Passed structure info object has invalid volume or n_atoms fields.");
-  init(si.volume * si.n_atoms, std::move(data));
+  init(si.volume * si.n_atoms, std::move(data), dbintol);
 }
 
-void NC::PCBragg::init( double v0_times_natoms, VectDFM&& origdata )
+void NC::PCBragg::init( double v0_times_natoms, VectDFM&& origdata, double dbintol )
 {
   if (!(v0_times_natoms>0) )
     NCRYSTAL_THROW(BadInput,"v0_times_natoms is not a positive number.");
+  if ( !(dbintol>=0.0) || dbintol >= 1.0 )
+    NCRYSTAL_THROW(BadInput,"dbintol must be in the range [0,1).");
   double xsectfact = 0.5/v0_times_natoms;
   xsectfact *= wl2ekin(1.0);//Adjust units so we can get cross sections through
                             //multiplication with 1/ekin instead of wl^2.
@@ -55,16 +160,21 @@ void NC::PCBragg::init( double v0_times_natoms, VectDFM&& origdata )
   fdm_commul.reserve(data.size());
   StableSum fdmsum2;
   VectDFM::const_iterator it(data.begin()),itE(data.end());
+  //Planes are merged into the previous edge when their d-spacing is
+  //(essentially) identical, or when within the relative binning tolerance
+  //below the d-spacing of the edge:
   double prev_dsp = -kInfinity;
+  double bin_dsp_low = kInfinity;
   for (;it!=itE;++it) {
     if (!(it->first>0.0))
       NCRYSTAL_THROW(CalcError,"Inconsistent plane data implies non-positive (or NaN) d_spacing.");
-    if ( ncabs(prev_dsp-it->first) < dspacing_merge_tolerance ) {
+    if ( ncabs(prev_dsp-it->first) < dspacing_merge_tolerance || it->first >= bin_dsp_low ) {
       double c = it->first * it->second * xsectfact;
       fdmsum2.add(c);
       fdm_commul.back() = fdmsum2.sum();
     } else {
       prev_dsp = it->first;
+      bin_dsp_low = ( dbintol > 0.0 ? prev_dsp * ( 1.0 - dbintol ) : kInfinity );
       double c = it->first * it->second * xsectfact;
       fdmsum2.add(c);
       fdm_commul.push_back(fdmsum2.sum());
@@ -81,19 +191,20 @@ void NC::PCBragg::init( double v0_times_natoms, VectDFM&& origdata )
   VectD(fdm_commul.begin(),fdm_commul.end()).swap(m_fdm_commul);
   VectD(v2dE.begin(),v2dE.end()).swap(m_2dE);
   nc_assert( m_threshold.get() > 0.0 );
+  initSearchIndex();
 }
 
-NC::PCBragg::PCBragg( const StructureInfo& si, VectDFM&&  data)
+NC::PCBragg::PCBragg( const StructureInfo& si, VectDFM&&  data, double dbintol )
 {
-  init(si,std::move(data));
+  init(si,std::move(data),dbintol);
 }
 
-NC::PCBragg::PCBragg( double v0_times_natoms, VectDFM&&  data)
+NC::PCBragg::PCBragg( double v0_times_natoms, VectDFM&&  data, double dbintol )
 {
-  init(v0_times_natoms,std::move(data));
+  init(v0_times_natoms,std::move(data),dbintol);
 }
 
-NC::PCBragg::PCBragg(const Info&ci)
+NC::PCBragg::PCBragg( const Info& ci, double dbintol )
 {
   if (!ci.hasHKLInfo())
     NCRYSTAL_THROW(MissingInfo,"Passed Info object lacks HKL information.");
@@ -113,7 +224,7 @@ NC::PCBragg::PCBragg(const Info&ci)
       data.back().second += f;
     }
   }
-  init(ci.getStructureInfo(),std::move(data));
+  init(ci.getStructureInfo(),std::move(data),dbintol);
 }
 
 NC::EnergyDomain NC::PCBragg::domain() const noexcept
@@ -125,35 +236,198 @@ std::size_t NC::PCBragg::findLastValidPlaneIdx( NC::NeutronEnergy ekin) const {
   //Quick binary search to find index of the plane with the smallest d-spacing
   //satisfying wl<=2d, but in energy-space: Finding the index of the plane with
   //the largest value of ekin2wl(2d) satisfying ekin>=ekin2wl(2d).  We already
-  //know that ekin>=m_2dE[0], so we search from one past this entry:
+  //know that ekin>=m_2dE[0], so the entry found will always be at least at
+  //index 1 (or the end):
   nc_assert( ekin >= m_threshold );
-  return (std::upper_bound(m_2dE.begin() + 1,m_2dE.end(),ekin.get()) - m_2dE.begin()) - 1;
+  nc_assert( m_eytz_perm.size() == m_2dE.size() + 1 );
+  std::size_t k = eytzUpperBound( m_eytz_2dE.data(), m_2dE.size(), ekin.get() );
+  std::size_t idx = m_eytz_perm[k];
+  nc_assert( idx >= 1 && idx <= m_2dE.size() );
+  nc_assert( idx == (std::size_t)( std::upper_bound(m_2dE.begin() + 1,m_2dE.end(),ekin.get()) - m_2dE.begin() ) );
+  return idx - 1;
+}
+
+std::size_t NC::PCBragg::findLastValidPlaneIdx( std::size_t& lastidx, double ekin ) const
+{
+  //Successive calls often have similar energies, so first check if the
+  //neutron is still in the same interval between Bragg edges as last time:
+  nc_assert( ekin >= m_threshold.dbl() );
+  nc_assert( lastidx < m_2dE.size() );
+  const std::size_t n = m_2dE.size();
+  if ( m_2dE[lastidx] <= ekin && ( lastidx + 1 == n || ekin < m_2dE[lastidx+1] ) )
+    return lastidx;
+  return ( lastidx = findLastValidPlaneIdx( NeutronEnergy{ ekin } ) );
+}
+
+
+void NC::PCBragg::findLastValidPlaneIdxMany( std::size_t& lastidx, const double* ekin,
+                                             std::size_t N, std::size_t* out_idx ) const
+{
+  constexpr std::size_t nmax = 64;
+  nc_assert( N <= nmax );
+  const double threshold = m_threshold.dbl();
+  if ( std::is_sorted( ekin, ekin + N ) ) {
+    //Ordered energies benefit more from checking the previous interval first:
+    for ( std::size_t i = 0; i < N; ++i )
+      if ( ekin[i] >= threshold )
+        out_idx[i] = findLastValidPlaneIdx( lastidx, ekin[i] );
+    return;
+  }
+  //Resolve the energies still in the interval of lastidx directly, and
+  //collect the rest for interleaved searches in groups:
+  const std::size_t n = m_2dE.size();
+  std::size_t pending[nmax];
+  std::size_t npending = 0;
+  for ( std::size_t i = 0; i < N; ++i ) {
+    const double e = ekin[i];
+    if ( !( e >= threshold ) )
+      continue;
+    if ( m_2dE[lastidx] <= e && ( lastidx + 1 == n || e < m_2dE[lastidx+1] ) )
+      out_idx[i] = lastidx;
+    else
+      pending[npending++] = i;
+  }
+  constexpr std::size_t G = 8;
+  double x[G];
+  std::size_t k[G];
+  for ( std::size_t p0 = 0; p0 < npending; p0 += G ) {
+    const std::size_t g = std::min<std::size_t>( G, npending - p0 );
+    for ( std::size_t j = 0; j < g; ++j )
+      x[j] = ekin[pending[p0+j]];
+    eytzUpperBoundInterleaved( m_eytz_2dE.data(), n, x, k, g );
+    for ( std::size_t j = 0; j < g; ++j ) {
+      const std::size_t idx = m_eytz_perm[k[j]];
+      nc_assert( idx >= 1 && idx <= n );
+      nc_assert( idx - 1 == findLastValidPlaneIdx( NeutronEnergy{ x[j] } ) );
+      out_idx[pending[p0+j]] = idx - 1;
+    }
+    lastidx = m_eytz_perm[k[g-1]] - 1;
+  }
 }
 
 
-NC::CrossSect NC::PCBragg::crossSectionIsotropic( NC::CachePtr&, NC::NeutronEnergy ekin ) const
+NC::CrossSect NC::PCBragg::crossSectionIsotropic( NC::CachePtr& cp, NC::NeutronEnergy ekin ) const
 {
   if ( ekin < m_threshold)
     return CrossSect{0.0};
-  std::size_t idx = findLastValidPlaneIdx(ekin);
+  auto& cache = accessCache<PCBraggCache>(cp);
+  std::size_t idx = findLastValidPlaneIdx(cache.lastidx,ekin.get());
   nc_assert(idx<m_fdm_commul.size());
   return CrossSect{ m_fdm_commul[idx] / ekin.get() };
 }
 
-NC::CosineScatAngle NC::PCBragg::genScatterMu( RNG& rng, NeutronEnergy ekin) const
+void NC::PCBragg::accountMemory( MemoryFootprint& mf ) const
 {
-  nc_assert( ekin >= m_threshold );
+  mf.add( sizeof(PCBragg)
+          + ( m_2dE.size() + m_fdm_commul.size() + m_eytz_2dE.size() + m_eytz_fdm.size() ) * sizeof(double)
+          + m_eytz_perm.size() * sizeof(std::uint32_t) );
+}
 
-  std::size_t idx = findLastValidPlaneIdx(ekin);
+NC::CrossSect NC::PCBragg::majorantCrossSection( EnergyDomain d ) const
+{
+  if ( m_2dE.empty() || d.ehigh < m_threshold )
+    return CrossSect{0.0};
+  //Between Bragg edges the cross section falls off as 1/ekin, so the maximum
+  //is found either at the lower end of the domain or at one of the edges
+  //inside the domain:
+  const NeutronEnergy elow{ std::max<double>( d.elow.dbl(), m_threshold.dbl() ) };
+  std::size_t idx = findLastValidPlaneIdx(elow);
   nc_assert(idx<m_fdm_commul.size());
+  double xsmax = m_fdm_commul[idx] / elow.get();
+  for ( ++idx; idx < m_2dE.size() && m_2dE[idx] <= d.ehigh.dbl(); ++idx )
+    xsmax = std::max<double>( xsmax, m_fdm_commul[idx] / m_2dE[idx] );
+  return CrossSect{ xsmax };
+}
 
-  //randomly select one plane by contribution:
-  VectD::const_iterator itFCUpper = std::next( m_fdm_commul.begin(), idx );
-  VectD::const_iterator itFC = std::lower_bound( m_fdm_commul.begin(),
-                                                 itFCUpper,
-                                                 rng.generate() * (*itFCUpper) );
-  std::size_t idx_rand = (std::size_t)( itFC - m_fdm_commul.begin() );
-  nc_assert(idx_rand<m_2dE.size());
+void NC::PCBragg::evalManyXSIsotropic( CachePtr& cp, const double* ekin, std::size_t N,
+                                       double* out_xs ) const
+{
+  if ( m_2dE.empty() ) {
+    std::fill( out_xs, out_xs + N, 0.0 );
+    return;
+  }
+  auto& cache = accessCache<PCBraggCache>(cp);
+  std::size_t lastidx = cache.lastidx;
+  if ( evalManyXSSorted( lastidx, ekin, N, out_xs ) ) {
+    cache.lastidx = lastidx;
+    return;
+  }
+  const double threshold = m_threshold.dbl();
+  const double * fdm_commul = m_fdm_commul.data();
+  constexpr std::size_t nblock = 64;
+  std::size_t idxs[nblock];
+  for ( std::size_t i0 = 0; i0 < N; i0 += nblock ) {
+    const std::size_t nb = std::min<std::size_t>( nblock, N - i0 );
+    findLastValidPlaneIdxMany( lastidx, ekin + i0, nb, idxs );
+    for ( std::size_t j = 0; j < nb; ++j ) {
+      const double e = ekin[i0+j];
+      if ( !( e >= threshold ) ) {
+        out_xs[i0+j] = 0.0;
+        continue;
+      }
+      nc_assert(idxs[j]<m_fdm_commul.size());
+      out_xs[i0+j] = fdm_commul[idxs[j]] / e;
+    }
+  }
+  cache.lastidx = lastidx;
+}
+
+bool NC::PCBragg::evalManyXSSorted( std::size_t& lastidx, const double* ekin, std::size_t N,
+                                    double* out_xs ) const
+{
+  if ( N < 2 )
+    return false;
+  //Check ordering first (NaN entries fail both checks):
+  const bool ascending = ekin[0] <= ekin[N-1];
+  for ( std::size_t i = 1; i < N; ++i )
+    if ( !( ascending ? ekin[i-1] <= ekin[i] : ekin[i-1] >= ekin[i] ) )
+      return false;
+
+  //Locate the first edge with a normal search, and then step through the
+  //edges, so the total cost is O(N+M) for M edges:
+  const double threshold = m_threshold.dbl();
+  const double * e2d = m_2dE.data();
+  const double * fdm_commul = m_fdm_commul.data();
+  const std::size_t n = m_2dE.size();
+  bool located = false;
+  std::size_t idx = lastidx;
+  for ( std::size_t i = 0; i < N; ++i ) {
+    const double e = ekin[i];
+    if ( e < threshold ) {
+      out_xs[i] = 0.0;
+      continue;
+    }
+    if ( !located ) {
+      idx = findLastValidPlaneIdx( lastidx, e );
+      located = true;
+    } else if ( ascending ) {
+      while ( idx + 1 < n && e2d[idx+1] <= e )
+        ++idx;
+    } else {
+      while ( e2d[idx] > e )
+        --idx;//terminates since e2d[0]==threshold<=e
+    }
+    nc_assert( idx == findLastValidPlaneIdx( NeutronEnergy{ e } ) );
+    out_xs[i] = fdm_commul[idx] / e;
+  }
+  lastidx = idx;
+  return true;
+}
+
+NC::CosineScatAngle NC::PCBragg::genScatterMu( RNG& rng, NeutronEnergy ekin, std::size_t idx ) const
+{
+  nc_assert( ekin >= m_threshold );
+  nc_assert(idx<m_fdm_commul.size());
+
+  //randomly select one plane by contribution. Since m_fdm_commul is
+  //increasing and the target is at most m_fdm_commul[idx], a search over the
+  //full (Eytzinger) array gives the same result as one restricted to [0,idx]:
+  const double target = rng.generate() * m_fdm_commul[idx];
+  std::size_t idx_rand = m_eytz_perm[ eytzLowerBound( m_eytz_fdm.data(), m_fdm_commul.size(), target ) ];
+  nc_assert(idx_rand<=idx);
+  nc_assert(idx_rand == (std::size_t)( std::lower_bound( m_fdm_commul.begin(),
+                                                         std::next( m_fdm_commul.begin(), idx ),
+                                                         target ) - m_fdm_commul.begin() ) );
   double sin_theta_bragg_squared = m_2dE[idx_rand] / ekin.get();
 
   //scatter angle A=2*theta_bragg, so with x=sin^2(theta_bragg), we have:
@@ -163,7 +437,7 @@ NC::CosineScatAngle NC::PCBragg::genScatterMu( RNG& rng, NeutronEnergy ekin) con
   return CosineScatAngle{mu};
 }
 
-NC::ScatterOutcomeIsotropic NC::PCBragg::sampleScatterIsotropic( NC::CachePtr&,
+NC::ScatterOutcomeIsotropic NC::PCBragg::sampleScatterIsotropic( NC::CachePtr& cp,
                                                                  NC::RNG& rng,
                                                                  NC::NeutronEnergy ekin ) const
 {
@@ -172,8 +446,75 @@ NC::ScatterOutcomeIsotropic NC::PCBragg::sampleScatterIsotropic( NC::CachePtr&,
     //scatterings not possible here
     return { ekin, CosineScatAngle{1.0} };
   } else {
-    return { ekin, genScatterMu(rng,ekin) };
+    auto& cache = accessCache<PCBraggCache>(cp);
+    return { ekin, genScatterMu(rng,ekin,findLastValidPlaneIdx(cache.lastidx,ekin.get())) };
+  }
+}
+
+void NC::PCBragg::sampleScatterIsotropicMany( CachePtr& cp, RNG& rng, double* ekin, std::size_t N,
+                                              double* out_mu ) const
+{
+  //elastic: ekin unchanged
+  if ( useLegacyRandSampling() )
+    return ScatterIsotropicMat::sampleScatterIsotropicMany( cp, rng, ekin, N, out_mu );
+  const double threshold = m_threshold.dbl();
+  if ( !N || m_2dE.empty() ) {
+    std::fill( out_mu, out_mu + N, 1.0 );
+    return;
+  }
+  auto& cache = accessCache<PCBraggCache>(cp);
+  std::size_t lastidx = cache.lastidx;
+  constexpr std::size_t nblock = 64;
+  std::size_t idxs[nblock];
+  for ( std::size_t i0 = 0; i0 < N; i0 += nblock ) {
+    const std::size_t nb = std::min<std::size_t>( nblock, N - i0 );
+    findLastValidPlaneIdxMany( lastidx, ekin + i0, nb, idxs );
+    for ( std::size_t j = 0; j < nb; ++j ) {
+      const double e = ekin[i0+j];
+      if ( !( e >= threshold ) ) {
+        out_mu[i0+j] = 1.0;
+        continue;
+      }
+      out_mu[i0+j] = genScatterMu( rng, NeutronEnergy{e}, idxs[j] ).dbl();
+    }
   }
+  cache.lastidx = lastidx;
+}
+
+NC::BiasedScatterOutcomeIsotropic NC::PCBragg::sampleScatterIsotropicBiased( CachePtr& cp,
+                                                                             RNG& rng,
+                                                                             NeutronEnergy ekin,
+                                                                             const ScatterWindow& window ) const
+{
+  //Scatterings are elastic and each plane scatters at a fixed angle, so we can
+  //sample directly among the planes scattering into the window, using their
+  //fraction of the cross section as weight:
+  BiasedScatterOutcomeIsotropic res{ { ekin, CosineScatAngle{1.0} }, 0.0 };
+  if ( ekin < m_threshold || !( ekin >= window.ekin_min && ekin <= window.ekin_max ) )
+    return res;
+  auto& cache = accessCache<PCBraggCache>(cp);
+  const std::size_t idx = findLastValidPlaneIdx(cache.lastidx,ekin.get());
+
+  //mu=1-2*m_2dE[i]/ekin decreases with i, so planes inside the window form a
+  //contiguous range [ia,ib):
+  const double e = ekin.get();
+  auto it2dE_end = std::next( m_2dE.begin(), idx + 1 );
+  const std::size_t ia = std::lower_bound( m_2dE.begin(), it2dE_end, 0.5 * ( 1.0 - window.mu_max ) * e ) - m_2dE.begin();
+  const std::size_t ib = std::upper_bound( m_2dE.begin(), it2dE_end, 0.5 * ( 1.0 - window.mu_min ) * e ) - m_2dE.begin();
+  if ( ia >= ib )
+    return res;
+  const double commul_low = ( ia ? m_fdm_commul[ia-1] : 0.0 );
+  const double commul_high = m_fdm_commul[ib-1];
+  if ( !( commul_high > commul_low ) )
+    return res;
+
+  const double target = commul_low + rng.generate() * ( commul_high - commul_low );
+  auto itFdm = std::lower_bound( std::next( m_fdm_commul.begin(), ia ),
+                                 std::next( m_fdm_commul.begin(), ib ), target );
+  const std::size_t idx_rand = std::min<std::size_t>( itFdm - m_fdm_commul.begin(), ib - 1 );
+  res.outcome.mu = CosineScatAngle{ ncclamp( 1.0 - 2.0 * m_2dE[idx_rand] / e, -1.0, 1.0 ) };
+  res.weight = ( commul_high - commul_low ) / m_fdm_commul[idx];
+  return res;
 }
 
 std::shared_ptr<NC::ProcImpl::Process> NC::PCBragg::createMerged( const Process& oraw ) const
@@ -184,7 +525,11 @@ std::shared_ptr<NC::ProcImpl::Process> NC::PCBragg::createMerged( const Process&
   auto& o = *optr;
 
   auto result = std::make_shared<PCBragg>( no_init );//empty instance
-  auto fixThreshold = [&result]() { result->m_threshold = NeutronEnergy{ result->m_2dE.front() }; };
+  auto fixThreshold = [&result]()
+  {
+    result->m_threshold = NeutronEnergy{ result->m_2dE.front() };
+    result->initSearchIndex();
+  };
 
   //transfer "a" (2dE) and "b" (fdm_commul) vectors, sorted by a:
   VectD& new_a = result->m_2dE;
@@ -22,6 +22,8 @@
 #include "NCrystal/NCException.hh"
 #include "NCrystal/internal/NCString.hh"
 #include "NCrystal/internal/NCMath.hh"
+#include "NCrystal/internal/NCNCMATBinary.hh"
+#include "NCrystal/internal/NCThreadUtils.hh"
 #include <iostream>
 #include <sstream>
 #if __cplusplus >= 201703L
@@ -43,10 +45,30 @@ namespace NCrystal {
     //sections and will call NCMATData::validate), but not a full validation of
     //data (a more complete validation is typically carried out afterwards by
     //the NCMAT Loader code). It will always clear the input pointer
-    //(i.e. release/close the resource).
-    NCMATParser(const TextData&);
+    //(i.e. release/close the resource). If deferLargeFields is set, large
+    //kernel tables in @DYNINFO sections are not decoded, but are instead
+    //placed in DynInfo::deferredFields.
+    NCMATParser(const TextData&, bool deferLargeFields = false );
     ~NCMATParser() = default;
 
+    //Decode a field whose decoding was deferred (the range [begin,end) must
+    //contain the complete lines of the field, starting with the keyword which
+    //must be in line number lineno):
+    static VectD decodeDeferredField( const RawStrData&,
+                                      const std::string& sourceDescription,
+                                      const std::string& fieldName,
+                                      const char * begin, const char * end,
+                                      unsigned lineno );
+
+    //Decode the numbers of a vector field in the range [begin,end) like
+    //decodeDeferredField. Large ranges are split at line boundaries into
+    //chunks which are decoded concurrently (when allowed by
+    //getNThreadsFromEnv()) and then concatenated in order:
+    static VectD decodeVectorField( const std::string& sourceDescription,
+                                    const std::string& fieldName,
+                                    const char * begin, const char * end,
+                                    unsigned lineno, bool allownegative );
+
     NCMATData&& getData() { return std::move(m_data); }
 
   private:
@@ -54,8 +76,19 @@ namespace NCrystal {
     typedef VectS Parts;
     void parseFile( TextData::Iterator itLine, TextData::Iterator itLineE );
     void parseLine( const std::string&, Parts&, unsigned linenumber ) const;
+    //Version placing views into [begin,end) in parts (no string allocations):
+    using PartViews = std::vector<StrView>;
+    void parseLineViews( const char * begin, const char * end, PartViews&, unsigned linenumber ) const;
+    mutable PartViews m_partviews;//buffer for parseLine
     void validateElementName(const std::string& s, unsigned lineno) const;
     double str2dbl_withfractions(const std::string&) const;
+    template<class TParts>
+    void parseVectorEntries( const TParts&, std::size_t ibegin,
+                             unsigned lineno, VectD& target, bool allownegative ) const;
+
+    //Constructor which only prepares for decoding deferred fields:
+    struct decode_only_t {};
+    NCMATParser( decode_only_t, const std::string& sourceDescription );
 
     //Section handling:
     typedef void (NCMATParser::*handleSectionDataFn)(const Parts&,unsigned);
@@ -77,6 +110,26 @@ namespace NCrystal {
     VectD * m_dyninfo_active_vector_field;
     bool m_dyninfo_active_vector_field_allownegative;
 
+    //Deferred decoding of large vector fields in @DYNINFO sections (while a
+    //field is active, parseFile simply skips past its lines of numbers). When
+    //multiple threads are available, multi-line vector fields which are not
+    //deferred are also collected like this, and then decoded in parallel
+    //chunks once the field ends (decodeNow=true):
+    struct DeferredField {
+      std::string name;
+      const char * begin;
+      unsigned lineno;
+      bool decodeNow;
+      bool allownegative;
+    };
+    bool m_deferLargeFields;
+    bool m_collectVectorFields;
+    const RawStrData * m_rawdata;
+    const char * m_currentLineBegin;
+    Optional<DeferredField> m_deferred_field;
+    void closeDeferredField( const char * end );
+    static bool isVectorContinuationLine( const std::string& );
+
     //Handle "cubic" keyword in @CELL section:
     Optional<double> m_cell_cubic;
 
@@ -92,9 +145,11 @@ namespace NCrystal {
     }
   };
 
-  NCMATData parseNCMATData( const TextData& text, bool doFinalValidation )
+  NCMATData parseNCMATData( const TextData& text, bool doFinalValidation, bool deferLargeFields )
   {
-    NCMATParser parser( text );
+    if ( isNCMATBinaryData( text.rawData().begin(), text.rawData().end() ) )
+      return decodeNCMATBinary( text, doFinalValidation );
+    NCMATParser parser( text, deferLargeFields );
     if (!doFinalValidation)
       return parser.getData();
     NCMATData data = parser.getData();
@@ -128,13 +183,31 @@ if (!contains(ss,'/'))
  return a/b;
 }
 
-NC::NCMATParser::NCMATParser( const TextData& input )
+NC::NCMATParser::NCMATParser( decode_only_t, const std::string& sourceDescription )
+  : m_active_dyninfo(nullptr),
+    m_dyninfo_active_vector_field(nullptr),
+    m_dyninfo_active_vector_field_allownegative(false),
+    m_deferLargeFields(false),
+    m_collectVectorFields(false),
+    m_rawdata(nullptr),
+    m_currentLineBegin(nullptr)
+{
+  m_data.sourceDescription = sourceDescription;
+  m_partviews.reserve(16);
+}
+
+NC::NCMATParser::NCMATParser( const TextData& input, bool deferLargeFields )
   : m_active_dyninfo(nullptr),
     m_dyninfo_active_vector_field(nullptr),
-    m_dyninfo_active_vector_field_allownegative(false)
+    m_dyninfo_active_vector_field_allownegative(false),
+    m_deferLargeFields(deferLargeFields),
+    m_collectVectorFields( getNThreadsFromEnv() > 1 ),
+    m_rawdata(&input.rawData()),
+    m_currentLineBegin(nullptr)
 {
   //Setup source description strings first as it is used in error messages:
   m_data.sourceDescription = input.description();
+  m_partviews.reserve(16);
 
   //Inspect first line to ensure format is NCMAT and extract version:
   auto itLine = input.begin();
@@ -172,6 +245,7 @@ NC::NCMATParser::NCMATParser( const TextData& input )
 
   //Initial song and dance to classify source and format is now done, so proceed to parse rest of file:
   parseFile( ++itLine, input.end() );
+  m_rawdata = nullptr;
 
   //Unalias element names:
   m_data.unaliasElementNames();
@@ -222,7 +296,25 @@ void NC::NCMATParser::parseFile( TextData::Iterator itLine, TextData::Iterator i
   bool sawAnySection = false;
   for ( ; itLine != itLineE; ++itLine ) {
     const std::string& line = *itLine;
-    parseLine(line,parts,++lineno);
+    ++lineno;
+    if ( m_deferred_field.has_value() ) {
+      //Lines of numbers belonging to a field with deferred decoding are
+      //skipped without parsing:
+      if ( isVectorContinuationLine( line ) )
+        continue;
+      closeDeferredField( itLine.rawLineBegin() );
+    }
+    m_currentLineBegin = itLine.rawLineBegin();
+    if ( m_dyninfo_active_vector_field && isVectorContinuationLine( line ) ) {
+      //Lines of numbers continuing a vector field in a @DYNINFO section are
+      //decoded directly from views into the line (skipping the generic
+      //handling via handleSectionData_DYNINFO):
+      parseLineViews( line.data(), line.data() + line.size(), m_partviews, lineno );
+      parseVectorEntries( m_partviews, 0, lineno, *m_dyninfo_active_vector_field,
+                          m_dyninfo_active_vector_field_allownegative );
+      continue;
+    }
+    parseLine(line,parts,lineno);
 
     if (m_data.version==1 && contains(line,'#')) {
       if (sawAnySection||(!parts.empty()&&parts.at(0)[0]=='@')||line.at(0)!='#')
@@ -306,7 +398,10 @@ void NC::NCMATParser::parseFile( TextData::Iterator itLine, TextData::Iterator i
 #endif
   }
 
-  //End of input. Close current section by sending it an empty parts list.
+  //End of input. Close any deferred field and the current section (by sending
+  //it an empty parts list).
+  if ( m_deferred_field.has_value() )
+    closeDeferredField( itLineE.rawLineBegin() );
   parts.clear();
 #if __cplusplus >= 201703L
   std::invoke(itSection->second,*this,parts,lineno);
@@ -317,9 +412,151 @@ void NC::NCMATParser::parseFile( TextData::Iterator itLine, TextData::Iterator i
 }
 
 
+bool NC::NCMATParser::isVectorContinuationLine( const std::string& line )
+{
+  //Lines which are blank, only contain comments, or which start with a number
+  //(as opposed to a keyword or a section marker):
+  for ( char c : line ) {
+    if ( c == ' ' || c == '\t' )
+      continue;
+    return c == '#' || c == '.' || c == '-' || c == '+' || ( c >= '0' && c <= '9' );
+  }
+  return true;
+}
+
+void NC::NCMATParser::closeDeferredField( const char * end )
+{
+  nc_assert_always( m_deferred_field.has_value() && m_active_dyninfo && m_rawdata );
+  nc_assert_always( !m_active_dyninfo->deferredFields.count( m_deferred_field.value().name ) );
+  if ( m_deferred_field.value().decodeNow ) {
+    const auto& df = m_deferred_field.value();
+    m_active_dyninfo->fields[df.name] = decodeVectorField( m_data.sourceDescription, df.name,
+                                                           df.begin, end, df.lineno,
+                                                           df.allownegative );
+    m_deferred_field.reset();
+    return;
+  }
+  //The decoder keeps a reference to the raw data, keeping it alive:
+  RawStrData rawdata = *m_rawdata;
+  std::string sd = m_data.sourceDescription;
+  std::string name = m_deferred_field.value().name;
+  const char * begin = m_deferred_field.value().begin;
+  unsigned lineno = m_deferred_field.value().lineno;
+  m_active_dyninfo->deferredFields[name] = [rawdata,sd,name,begin,end,lineno]()
+  {
+    return decodeDeferredField( rawdata, sd, name, begin, end, lineno );
+  };
+  m_active_dyninfo->deferredFieldTexts[name] = { begin, end };
+  m_deferred_field.reset();
+}
+
+NC::VectD NC::NCMATParser::decodeDeferredField( const RawStrData& rawdata,
+                                                const std::string& sourceDescription,
+                                                const std::string& fieldName,
+                                                const char * begin, const char * end,
+                                                unsigned lineno )
+{
+  nc_assert_always( begin >= rawdata.begin() && begin < end && end <= rawdata.end() );
+  const bool allownegative = false;//currently only used for kernel tables
+  return decodeVectorField( sourceDescription, fieldName, begin, end, lineno, allownegative );
+}
+
+NC::VectD NC::NCMATParser::decodeVectorField( const std::string& sourceDescription,
+                                              const std::string& fieldName,
+                                              const char * begin, const char * end,
+                                              unsigned lineno, bool allownegative )
+{
+  nc_assert_always( begin < end );
+
+  //Decode the lines in [c,cEnd), starting with line number lineno. Only the
+  //first chunk starts with the line holding the keyword:
+  auto decodeChunk = [&sourceDescription,&fieldName,allownegative]
+    ( const char * c, const char * cEnd, unsigned lineno, bool first, VectD& result )
+  {
+    NCMATParser parser( decode_only_t(), sourceDescription );
+    result.reserve( static_cast<std::size_t>( ( cEnd - c ) / 8 ) );//will be squeezed later
+    PartViews parts;
+    parts.reserve(16);
+    while ( c != cEnd ) {
+      const char * cE = std::find( c, cEnd, '\n' );
+      const char * cNext = ( cE == cEnd ? cEnd : cE + 1 );
+      if ( cE != c && *std::prev(cE) == '\r' )
+        --cE;
+      parser.parseLineViews( c, cE, parts, lineno );
+      std::size_t ibegin = 0;
+      if ( first ) {
+        nc_assert_always( !parts.empty() && parts.front() == StrView(fieldName) );
+        first = false;
+        ibegin = 1;
+      }
+      parser.parseVectorEntries( parts, ibegin, lineno, result, allownegative );
+      c = cNext;
+      ++lineno;
+    }
+  };
+
+  //Split at line boundaries into chunks of at least 256kB, using a few chunks
+  //per thread for load balancing:
+  constexpr std::size_t min_chunk_bytes = 262144;
+  const std::size_t nbytes = static_cast<std::size_t>( end - begin );
+  const unsigned nthreads = ( nbytes >= 2 * min_chunk_bytes ? getNThreadsFromEnv() : 1 );
+  const std::size_t nchunks_wanted = ( nthreads > 1
+                                       ? std::min<std::size_t>( 4 * nthreads, nbytes / min_chunk_bytes )
+                                       : 1 );
+  if ( nchunks_wanted <= 1 ) {
+    VectD result;
+    decodeChunk( begin, end, lineno, true, result );
+    result.shrink_to_fit();
+    return result;
+  }
+
+  struct Chunk { const char * begin; const char * end; unsigned lineno; };
+  std::vector<Chunk> chunks;
+  chunks.reserve( nchunks_wanted );
+  const char * c = begin;
+  for ( std::size_t i = 1; c != end; ++i ) {
+    const char * cE = end;
+    if ( i < nchunks_wanted ) {
+      cE = std::find( std::max( c, begin + ( nbytes * i ) / nchunks_wanted ), end, '\n' );
+      if ( cE != end )
+        ++cE;//include the newline
+    }
+    chunks.push_back( Chunk{ c, cE, lineno } );
+    lineno += static_cast<unsigned>( std::count( c, cE, '\n' ) );
+    c = cE;
+  }
+
+  std::vector<VectD> results( chunks.size() );
+  parallelFor( chunks.size(), nthreads,
+               [&chunks,&results,&decodeChunk]( std::size_t i )
+               {
+                 decodeChunk( chunks[i].begin, chunks[i].end, chunks[i].lineno, i == 0, results[i] );
+               } );
+
+  std::size_t ntot = 0;
+  for ( const auto& r : results )
+    ntot += r.size();
+  VectD result;
+  result.reserve( ntot );
+  for ( const auto& r : results )
+    result.insert( result.end(), r.begin(), r.end() );
+  return result;
+}
+
 void NC::NCMATParser::parseLine( const std::string& line,
                                  Parts& parts,
                                  unsigned lineno ) const
+{
+  parseLineViews( line.data(), line.data() + line.size(), m_partviews, lineno );
+  parts.clear();
+  for ( const auto& e : m_partviews )
+    parts.emplace_back( e.data(), e.size() );
+}
+
+void NC::NCMATParser::parseLineViews( const char * lineBegin,
+                                      const char * lineEnd,
+                                      PartViews& parts,
+                                      unsigned lineno ) const
 {
   //Ignore trailing comments and split line on all whitespace to return the
   //actual parts in a vector. This function is a bit like
@@ -345,8 +582,8 @@ void NC::NCMATParser::parseLine( const std::string& line,
   //127-255: forbidden (127 is control char, others are not ASCII but could indicate UTF-8 multibyte char)
 
   parts.clear();
-  const char * c = &line[0];
-  const char * cE = c + line.size();
+  const char * c = lineBegin;
+  const char * cE = lineEnd;
   const char * partbegin = nullptr;
   for (;c!=cE;++c) {
     if ( *c < 127 && ( *c > 32 && *c != '#') ) {
@@ -401,7 +638,7 @@ void NC::NCMATParser::parseLine( const std::string& line,
       if (*c=='\r') {
         if ( (c+1)!=cE && *(c+1)!='\n' ) {
           NCRYSTAL_THROW2(BadInput,descr()<<": contains invalid character at position "
-                          <<(c-&line[0])<<" in line "<<lineno<<". Carriage return codes (aka \\r) "
+                          <<(c-lineBegin)<<" in line "<<lineno<<". Carriage return codes (aka \\r) "
                           " are not allowed unless used as part of DOS line endings.");
         }
       }
@@ -410,7 +647,7 @@ void NC::NCMATParser::parseLine( const std::string& line,
     }
     //Only reach here in case of errors:
     NCRYSTAL_THROW2(BadInput,descr()<<": contains invalid character at position "
-                    <<(c-&line[0])<<" in line "<<lineno<<". Only regular ASCII characters"
+                    <<(c-lineBegin)<<" in line "<<lineno<<". Only regular ASCII characters"
                     " (including spaces) are allowed outside comments (comments can be UTF-8)");
   }
   if (partbegin) {
@@ -429,7 +666,7 @@ void NC::NCMATParser::parseLine( const std::string& line,
     if (*c=='\r') {
       if ( (c+1)!=cE && *(c+1)!='\n' ) {
         NCRYSTAL_THROW2(BadInput,descr()<<": contains invalid character at position "
-                        <<(c-&line[0])<<" in line "<<lineno<<". Carriage return codes (aka \\r) "
+                        <<(c-lineBegin)<<" in line "<<lineno<<". Carriage return codes (aka \\r) "
                         " are not allowed unless used as part of DOS line endings.");
       }
       continue;
@@ -629,10 +866,9 @@ void NC::NCMATParser::handleSectionData_DEBYETEMPERATURE(const Parts& parts, uns
 
 void NC::NCMATParser::handleSectionData_DYNINFO(const Parts& parts, unsigned lineno)
 {
-  std::string e1 = descr();
   if (parts.empty()) {
     if (!m_active_dyninfo)
-      NCRYSTAL_THROW2(BadInput,e1<<": no input found in @DYNINFO section (expected in line "<<lineno<<")");
+      NCRYSTAL_THROW2(BadInput,descr()<<": no input found in @DYNINFO section (expected in line "<<lineno<<")");
     try {
       m_active_dyninfo->validate();
     } catch (Error::BadInput&e) {
@@ -668,7 +904,7 @@ void NC::NCMATParser::handleSectionData_DYNINFO(const Parts& parts, unsigned lin
     //line begins with a keyword
 
     if (parts.size()<2)
-      NCRYSTAL_THROW2(BadInput,e1<<": provides no arguments for keyword \""<<p0<<"\" in line "<<lineno);
+      NCRYSTAL_THROW2(BadInput,descr()<<": provides no arguments for keyword \""<<p0<<"\" in line "<<lineno);
 
     m_dyninfo_active_vector_field = nullptr;//new keyword, deactivate active field.
     m_dyninfo_active_vector_field_allownegative = false;//forbid negative numbers except where we explicitly allow them
@@ -682,11 +918,11 @@ void NC::NCMATParser::handleSectionData_DYNINFO(const Parts& parts, unsigned lin
       //Handle common fields "fraction", "element", "type":
 
       if (parts.size()!=2)
-        NCRYSTAL_THROW2(BadInput,e1<<": does not provide exactly one argument to keyword \""<<p0<<"\" in line "<<lineno);
+        NCRYSTAL_THROW2(BadInput,descr()<<": does not provide exactly one argument to keyword \""<<p0<<"\" in line "<<lineno);
       if ( ( p0 == "fraction" && di.fraction != -1.0 )
            || ( p0 == "element" && !di.element_name.empty() )
            || ( p0 == "type" && di.dyninfo_type != NCMATData::DynInfo::Undefined ) )
-        NCRYSTAL_THROW2(BadInput,e1<<": keyword \""<<p0<<"\" is specified a second time in line "<<lineno);
+        NCRYSTAL_THROW2(BadInput,descr()<<": keyword \""<<p0<<"\" is specified a second time in line "<<lineno);
 
       //Specific handling of each:
       if ( p0 == "fraction" ) {
@@ -694,10 +930,10 @@ void NC::NCMATParser::handleSectionData_DYNINFO(const Parts& parts, unsigned lin
         try {
           fr = str2dbl_withfractions(p1);
         } catch (Error::BadInput&e) {
-          NCRYSTAL_THROW2(BadInput,e1<<": problem while decoding fraction parameter in line "<<lineno<<" : "<<e.what());
+          NCRYSTAL_THROW2(BadInput,descr()<<": problem while decoding fraction parameter in line "<<lineno<<" : "<<e.what());
         }
         if ( !(fr<=1.0) || !(fr>0.0) )//this also tests for NaN
-          NCRYSTAL_THROW2(BadInput,e1<<": problem while decoding fraction parameter in line "<<lineno<<" (must result in a number greater than 0.0 and at most 1.0)");
+          NCRYSTAL_THROW2(BadInput,descr()<<": problem while decoding fraction parameter in line "<<lineno<<" (must result in a number greater than 0.0 and at most 1.0)");
         di.fraction = fr;
       } else if ( p0 == "element" ) {
         validateElementName(p1,lineno);
@@ -714,7 +950,7 @@ void NC::NCMATParser::handleSectionData_DYNINFO(const Parts& parts, unsigned lin
         else if ( p1 == "sterile" )
           di.dyninfo_type = NCMATData::DynInfo::Sterile;
         else
-          NCRYSTAL_THROW2(BadInput,e1<<": invalid @DYNINFO type specified in line "
+          NCRYSTAL_THROW2(BadInput,descr()<<": invalid @DYNINFO type specified in line "
                           <<lineno<<" (must be one of \"scatknl\", \"vdos\", \"vdosdebye\", \"freegas\", \"sterile\")");
       }
       return;
@@ -723,8 +959,25 @@ void NC::NCMATParser::handleSectionData_DYNINFO(const Parts& parts, unsigned lin
     //////////////////////////////////////////////////////////////
     //Not a common field, parse into generic DynInfo::fields map :
 
-    if ( di.fields.find(p0) != di.fields.end() )
-      NCRYSTAL_THROW2(BadInput,e1<<": keyword \""<<p0<<"\" is specified a second time in line "<<lineno);
+    if ( di.hasField(p0) )
+      NCRYSTAL_THROW2(BadInput,descr()<<": keyword \""<<p0<<"\" is specified a second time in line "<<lineno);
+
+    if ( m_deferLargeFields && isOneOf(p0,"sab","sab_scaled") ) {
+      //Postpone decoding of kernel table until it is actually needed (parseFile
+      //will skip subsequent lines of numbers until the field ends):
+      nc_assert_always( m_currentLineBegin != nullptr );
+      m_deferred_field = DeferredField{ p0, m_currentLineBegin, lineno, false, false };
+      return;
+    }
+
+    if ( m_collectVectorFields && isOneOf(p0,"sab","sab_scaled","alphagrid","betagrid",
+                                          "egrid","vdos_egrid","vdos_density") ) {
+      //Collect the lines of the field, to decode them all in one go (in
+      //parallel chunks if large) once the field ends:
+      nc_assert_always( m_currentLineBegin != nullptr );
+      m_deferred_field = DeferredField{ p0, m_currentLineBegin, lineno, true, p0=="betagrid" };
+      return;
+    }
 
     //Setup new vector for parsing into:
     di.fields[p0] = VectD();
@@ -751,39 +1004,43 @@ void NC::NCMATParser::handleSectionData_DYNINFO(const Parts& parts, unsigned lin
   if ( !parse_target )
     NCRYSTAL_THROW2(BadInput,descr()<<": Unexpected content in line "<<lineno<<": "<<parts.front());
   nc_assert_always( itParseToVect != itParseToVectE );
-  std::size_t idx = (itParseToVect-parts.begin());
-  std::string tmp_strcache0, tmp_strcache1;
-  for (; itParseToVect!=itParseToVectE; ++itParseToVect,++idx) {
+  parseVectorEntries( parts, static_cast<std::size_t>( itParseToVect - parts.begin() ), lineno,
+                      *parse_target, m_dyninfo_active_vector_field_allownegative );
+}
+
+template<class TParts>
+void NC::NCMATParser::parseVectorEntries( const TParts& parts, std::size_t ibegin,
+                                          unsigned lineno, VectD& target, bool allownegative ) const
+{
+  for ( std::size_t ipart = ibegin; ipart < parts.size(); ++ipart ) {
     double val;
-    const std::string * srcnumstr = &(*itParseToVect);
-    const std::string * srcrepeatstr = nullptr;
+    StrView srcnumstr( parts[ipart] );
+    StrView srcrepeatstr;
     //First check for compact notation of repeated entries:
-    auto idx_repeat_marker = srcnumstr->find('r');
-    if (idx_repeat_marker != std::string::npos) {
-      tmp_strcache0.assign(*srcnumstr,0,idx_repeat_marker);
-      tmp_strcache1.assign(*srcnumstr,idx_repeat_marker+1,srcnumstr->size()-(idx_repeat_marker+1));
-      srcnumstr = &tmp_strcache0;
-      srcrepeatstr = &tmp_strcache1;
+    auto idx_repeat_marker = srcnumstr.find('r');
+    if (idx_repeat_marker != StrView::npos) {
+      srcrepeatstr = srcnumstr.substr(idx_repeat_marker+1);
+      srcnumstr = srcnumstr.substr(0,idx_repeat_marker);
     }
 
     unsigned repeat_count = 1;
     try {
-      if (srcrepeatstr) {
-        int irc = str2int(*srcrepeatstr);
+      if (idx_repeat_marker != StrView::npos) {
+        int irc = str2int(srcrepeatstr);
         if (irc<2)
           NCRYSTAL_THROW2(BadInput,"repeated entry count parameter must be >= 2");
         repeat_count = irc;
       }
-      val = str2dbl(*srcnumstr);
+      val = str2dbl(srcnumstr);
     } catch (Error::BadInput&e) {
-      NCRYSTAL_THROW2(BadInput,e1<<": problem while decoding vector entry #"<<1+(itParseToVect-parts.begin())<<" in line "<<lineno<<" : "<<e.what());
+      NCRYSTAL_THROW2(BadInput,descr()<<": problem while decoding vector entry #"<<1+ipart<<" in line "<<lineno<<" : "<<e.what());
     }
     if (ncisnan(val)||ncisinf(val))
-      NCRYSTAL_THROW2(BadInput,e1<<": problem while decoding vector entry #"<<1+(itParseToVect-parts.begin())<<" in line "<<lineno<<" : NaN or infinite number");
-    if ( !m_dyninfo_active_vector_field_allownegative && val<0.0 )
-      NCRYSTAL_THROW2(BadInput,e1<<": problem while decoding vector entry #"<<1+(itParseToVect-parts.begin())<<" in line "<<lineno<<" : Negative number");
+      NCRYSTAL_THROW2(BadInput,descr()<<": problem while decoding vector entry #"<<1+ipart<<" in line "<<lineno<<" : NaN or infinite number");
+    if ( !allownegative && val<0.0 )
+      NCRYSTAL_THROW2(BadInput,descr()<<": problem while decoding vector entry #"<<1+ipart<<" in line "<<lineno<<" : Negative number");
     while (repeat_count--)
-      parse_target->push_back(val);
+      target.push_back(val);
   }
 
 }
@@ -29,6 +29,16 @@ namespace NCrystal {
   PlaneProvider::PlaneProvider() = default;
   PlaneProvider::~PlaneProvider() = default;
 
+  void PlaneProvider::getAllPlanes( PlaneList& pl )
+  {
+    pl.clear();
+    prepareLoop();
+    double dspacing, fsq;
+    Vector demi_normal;
+    while ( getNextPlane( dspacing, fsq, demi_normal ) )
+      pl.add( dspacing, fsq, demi_normal );
+  }
+
   class PlaneProviderStd final : public PlaneProvider {
   public:
 
@@ -39,6 +49,7 @@ namespace NCrystal {
     bool canProvide() const final;
     void prepareLoop() final;
     bool getNextPlane(double& dspacing, double& fsq, Vector& demi_normal) final;
+    void getAllPlanes( PlaneList& ) final;
 
   private:
     optional_shared_obj<const Info> m_info_strongref;
@@ -61,7 +72,7 @@ namespace NCrystal {
   struct PlaneProviderStd::StrSG {
     StrSG(int spacegroup) : m_eqreflcalc(spacegroup) {}
     void prepareLoop(int h, int k, int l, unsigned expected_multiplicity ) {
-      const std::set<EqRefl::HKL>& el = m_eqreflcalc.getEquivalentReflections(h,k,l);
+      const std::vector<EqRefl::HKL>& el = m_eqreflcalc.getEquivalentReflections(h,k,l);
       if ( el.size() * 2 != expected_multiplicity ) {
         NCRYSTAL_THROW2(MissingInfo,"Incomplete information for selected modeling: Neither"
                         " HKL normals nor expanded HKL info available, and the HKL grouping in the"
@@ -73,7 +84,7 @@ namespace NCrystal {
       it = el.begin();
       itE = el.end();
     }
-    std::set<EqRefl::HKL>::const_iterator it,itE;
+    std::vector<EqRefl::HKL>::const_iterator it,itE;
   private:
     EqRefl m_eqreflcalc;
   };
@@ -144,6 +155,36 @@ namespace NCrystal {
     return false;
   }
 
+  void PlaneProviderStd::getAllPlanes( PlaneList& pl )
+  {
+    pl.clear();
+    prepareLoop();//throws in case of STRAT_MISSING
+    std::size_t n = 0;
+    for ( auto it = m_info->hklBegin(); it != m_info->hklEnd(); ++it )
+      n += ( m_strategy == STRAT_DEMINORMAL ? it->demi_normals.size() : it->multiplicity / 2 );
+    pl.reserve( n );
+    //Same loops as in getNextPlane, but without the virtual call and strategy
+    //dispatch for each plane:
+    double dspacing, fsq;
+    Vector demi_normal;
+    switch(m_strategy) {
+    case STRAT_DEMINORMAL:
+      while ( gnp_de(dspacing,fsq,demi_normal) )
+        pl.add( dspacing, fsq, demi_normal );
+      break;
+    case STRAT_EXPHKL:
+      while ( gnp_eh(dspacing,fsq,demi_normal) )
+        pl.add( dspacing, fsq, demi_normal );
+      break;
+    case STRAT_SPACEGROUP:
+      while ( gnp_sg(dspacing,fsq,demi_normal) )
+        pl.add( dspacing, fsq, demi_normal );
+      break;
+    case STRAT_MISSING:
+      nc_assert_always(false);
+    };
+  }
+
   bool PlaneProviderStd::gnp_de(double& dspacing, double& fsq, Vector& demi_normal)
   {
     if (m_it_hkl == m_it_hklE)
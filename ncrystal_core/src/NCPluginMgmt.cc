@@ -19,8 +19,11 @@
 ////////////////////////////////////////////////////////////////////////////////
 
 #include "NCrystal/NCPluginMgmt.hh"
+#include "NCrystal/NCFactImpl.hh"
+#include "NCrystal/NCInfo.hh"
 #include "NCrystal/internal/NCDynLoader.hh"
 #include "NCrystal/internal/NCString.hh"
+#include "NCrystal/internal/NCFileUtils.hh"
 #include <iostream>
 
 //MT TODO: Do we need to make these thread-safe?
@@ -99,6 +102,18 @@ namespace NCrystal {
           pinfo.pluginName = dl.getFunction<const char*()>("ncplugin_getname")();
         auto regfct = dl.getFunction<void()>(regfctname);
 
+        //Plugins providing physics processes must be compiled against the
+        //same virtual interface of ProcImpl::Process (plugins from before the
+        //version was recorded used version 1):
+        auto ifversion_fct = dl.tryGetFunction<unsigned()>("ncplugin_getprocinterfaceversion");
+        const unsigned ifversion = ifversion_fct.first ? ifversion_fct.second() : 1;
+        if ( ifversion != ProcImpl::processInterfaceVersion )
+          NCRYSTAL_THROW2(DataLoadError,"Plugin "<<pinfo.pluginName<<" in "<<pinfo.fileName
+                          <<" was compiled against an incompatible version of the NCrystal"
+                          " process interface (version "<<ifversion<<" while this NCrystal"
+                          " installation uses version "<<ProcImpl::processInterfaceVersion
+                          <<"). The plugin must be recompiled.");
+
         dl.doNotClose();//avoid dlclose (sadly, this is leaky but otherwise we
         //might get segfaults at programme shutdown...)
 
@@ -137,6 +152,253 @@ std::vector<NCP::PluginInfo> NCP::loadedPlugins()
   return result;
 }
 
+namespace NCrystal {
+  namespace Plugins {
+    namespace {
+
+      using FactImpl::FactoryType;
+
+      struct PluginManifest {
+        std::string pluginName;
+        std::vector<std::pair<FactoryType,std::string>> factories;
+        std::set<std::string> dataTypes;
+        std::set<std::string> customSections;
+      };
+
+      Optional<PluginManifest> readPluginManifest( const std::string& path_to_shared_lib )
+      {
+        const std::string fn = path_to_shared_lib + ".ncplugin";
+        if ( !file_exists( fn ) )
+          return NullOpt;
+        auto content = readEntireFileToString( fn );
+        if ( !content.has_value() )
+          return NullOpt;
+        PluginManifest mf;
+        bool seenHeader = false;
+        for ( auto& line : split2( content.value(), 0, '\n' ) ) {
+          auto icomment = line.find('#');
+          if ( icomment != std::string::npos )
+            line.resize( icomment );
+          auto parts = split2( line );
+          if ( parts.empty() )
+            continue;
+          if ( !seenHeader ) {
+            if ( parts.size() != 2 || parts.at(0) != "NCPluginManifest" || parts.at(1) != "v1" )
+              NCRYSTAL_THROW2(BadInput,"Plugin manifest does not start with \"NCPluginManifest v1\": "<<fn);
+            seenHeader = true;
+            continue;
+          }
+          const std::string& kw = parts.at(0);
+          if ( kw == "name" && parts.size() == 2 ) {
+            mf.pluginName = parts.at(1);
+          } else if ( kw == "factory" && parts.size() == 3 ) {
+            const std::string& ft = parts.at(1);
+            FactoryType t;
+            if ( ft == "textdata" )
+              t = FactoryType::TextData;
+            else if ( ft == "info" )
+              t = FactoryType::Info;
+            else if ( ft == "scatter" )
+              t = FactoryType::Scatter;
+            else if ( ft == "absorption" )
+              t = FactoryType::Absorption;
+            else
+              NCRYSTAL_THROW2(BadInput,"Unknown factory type \""<<ft<<"\" in plugin manifest: "<<fn);
+            mf.factories.emplace_back( t, parts.at(2) );
+          } else if ( kw == "datatypes" ) {
+            mf.dataTypes.insert( std::next(parts.begin()), parts.end() );
+          } else if ( kw == "customsections" ) {
+            mf.customSections.insert( std::next(parts.begin()), parts.end() );
+          } else {
+            NCRYSTAL_THROW2(BadInput,"Invalid line \""<<line<<"\" in plugin manifest: "<<fn);
+          }
+        }
+        if ( !seenHeader || mf.pluginName.empty() || mf.factories.empty() )
+          NCRYSTAL_THROW2(BadInput,"Plugin manifest must declare both name and factories: "<<fn);
+        return mf;
+      }
+
+      class DeferredPlugin : private NoCopyMove {
+        //Plugin whose library is only loaded once one of its proxy factories
+        //(see below) is actually needed.
+      public:
+        DeferredPlugin( std::string path_to_shared_lib, PluginManifest&& mf )
+          : m_path(std::move(path_to_shared_lib)), m_mf(std::move(mf))
+        {
+        }
+
+        const PluginManifest& manifest() const { return m_mf; }
+
+        void ensureLoaded() const
+        {
+          NCRYSTAL_LOCK_GUARD(m_mtx);
+          if ( m_loaded )
+            return;
+          if (ncgetenv_bool("DEBUG_PLUGIN"))
+            std::cout<<"NCrystal: Loading deferred plugin \""<<m_mf.pluginName<<"\" since it is needed."<<std::endl;
+          loadDynamicPluginImpl( m_path, m_mf.pluginName, "ncplugin_register" );
+          m_loaded = true;
+        }
+
+        bool isLoaded() const
+        {
+          NCRYSTAL_LOCK_GUARD(m_mtx);
+          return m_loaded;
+        }
+
+        bool triggeredByDataType( const std::string& dt ) const { return m_mf.dataTypes.count( dt ) > 0; }
+
+        bool triggeredByCustomSections( const MatCfg& cfg ) const
+        {
+          if ( m_mf.customSections.empty() )
+            return false;
+          auto info = FactImpl::createInfo( cfg );
+          for ( const auto& e : info->getAllCustomSections() )
+            if ( m_mf.customSections.count( e.first ) )
+              return true;
+          return false;
+        }
+
+      private:
+        mutable std::mutex m_mtx;
+        std::string m_path;
+        PluginManifest m_mf;
+        mutable bool m_loaded = false;
+      };
+
+      //Whether or not a given request needs a deferred plugin:
+      bool needsDeferredPlugin( const DeferredPlugin& pl, const std::string& factName, const TextDataPath& key )
+      {
+        return key.fact() == factName || pl.triggeredByDataType( getfileext( key.path() ) );
+      }
+      bool needsDeferredPlugin( const DeferredPlugin& pl, const std::string& factName, const MatInfoCfg& key )
+      {
+        return key.get_infofact_name() == factName || pl.triggeredByDataType( key.getDataType() );
+      }
+      bool needsDeferredPlugin( const DeferredPlugin& pl, const std::string& factName,
+                                const MatCfg& key, FactoryType ft )
+      {
+        nc_assert( ft == FactoryType::Scatter || ft == FactoryType::Absorption );
+        auto req = ( ft == FactoryType::Scatter ? key.get_scatfactory_parsed() : key.get_absnfactory_parsed() );
+        if ( req.excluded.count( factName ) )
+          return false;
+        return req.specific == factName
+          || pl.triggeredByDataType( key.getDataType() )
+          || pl.triggeredByCustomSections( key );
+      }
+
+      std::vector<shared_obj<const FactImpl::TextDataFactory>> factoryList( const FactImpl::TextDataFactory* ) { return FactImpl::getTextDataFactoryList(); }
+      std::vector<shared_obj<const FactImpl::InfoFactory>> factoryList( const FactImpl::InfoFactory* ) { return FactImpl::getInfoFactoryList(); }
+      std::vector<shared_obj<const FactImpl::ScatterFactory>> factoryList( const FactImpl::ScatterFactory* ) { return FactImpl::getScatterFactoryList(); }
+      std::vector<shared_obj<const FactImpl::AbsorptionFactory>> factoryList( const FactImpl::AbsorptionFactory* ) { return FactImpl::getAbsorptionFactoryList(); }
+
+      template<class TFactory>
+      class DeferredFactoryBase : public TFactory {
+        //Stand-in for a factory of a deferred plugin. When it is needed, the
+        //plugin is loaded (which replaces this object in the global factory
+        //lists with the real factory of the same name), and all calls are
+        //forwarded to the real factory.
+      public:
+        using key_type = typename TFactory::key_type;
+        using Priority = ::NCrystal::Priority;
+
+        DeferredFactoryBase( shared_obj<DeferredPlugin> pl, std::string name )
+          : m_plugin(std::move(pl)), m_name(std::move(name))
+        {
+        }
+
+        const char * name() const noexcept override { return m_name.c_str(); }
+
+      protected:
+        shared_obj<const TFactory> realFactory() const
+        {
+          m_plugin->ensureLoaded();
+          for ( auto& f : factoryList( static_cast<const TFactory*>(nullptr) ) ) {
+            if ( m_name == f->name() && static_cast<const TFactory*>(this) != &*f )
+              return f;
+          }
+          NCRYSTAL_THROW2(BadInput,"Plugin \""<<m_plugin->manifest().pluginName
+                          <<"\" did not register the factory \""<<m_name<<"\" declared in its manifest.");
+        }
+        template<class TNeeded>
+        Priority queryImpl( const key_type& key, TNeeded needed ) const
+        {
+          if ( !m_plugin->isLoaded() && !needed() )
+            return Priority{Priority::Unable};
+          return realFactory()->query( key );
+        }
+        shared_obj<DeferredPlugin> m_plugin;
+        std::string m_name;
+      };
+
+      class DeferredTextDataFactory final : public DeferredFactoryBase<FactImpl::TextDataFactory> {
+      public:
+        using DeferredFactoryBase::DeferredFactoryBase;
+        Priority query( const TextDataPath& key ) const override
+        {
+          return queryImpl( key, [this,&key]{ return needsDeferredPlugin( *m_plugin, m_name, key ); } );
+        }
+        TextDataSource produce( const TextDataPath& key ) const override { return realFactory()->produce( key ); }
+        BrowseList browse() const override { return realFactory()->browse(); }
+      };
+
+      class DeferredInfoFactory final : public DeferredFactoryBase<FactImpl::InfoFactory> {
+      public:
+        using DeferredFactoryBase::DeferredFactoryBase;
+        Priority query( const MatInfoCfg& key ) const override
+        {
+          return queryImpl( key, [this,&key]{ return needsDeferredPlugin( *m_plugin, m_name, key ); } );
+        }
+        InfoPtr produce( const MatInfoCfg& key ) const override { return realFactory()->produce( key ); }
+      };
+
+      class DeferredScatterFactory final : public DeferredFactoryBase<FactImpl::ScatterFactory> {
+      public:
+        using DeferredFactoryBase::DeferredFactoryBase;
+        Priority query( const MatCfg& key ) const override
+        {
+          return queryImpl( key, [this,&key]{ return needsDeferredPlugin( *m_plugin, m_name, key, FactoryType::Scatter ); } );
+        }
+        ProcPtr produce( const MatCfg& key ) const override { return realFactory()->produce( key ); }
+      };
+
+      class DeferredAbsorptionFactory final : public DeferredFactoryBase<FactImpl::AbsorptionFactory> {
+      public:
+        using DeferredFactoryBase::DeferredFactoryBase;
+        Priority query( const MatCfg& key ) const override
+        {
+          return queryImpl( key, [this,&key]{ return needsDeferredPlugin( *m_plugin, m_name, key, FactoryType::Absorption ); } );
+        }
+        ProcImpl::ProcPtr produce( const MatCfg& key ) const override { return realFactory()->produce( key ); }
+      };
+
+      void registerDeferredPlugin( std::string path_to_shared_lib, PluginManifest&& mf )
+      {
+        if (ncgetenv_bool("DEBUG_PLUGIN"))
+          std::cout<<"NCrystal: Deferring loading of plugin \""<<mf.pluginName<<"\" from "
+                   <<path_to_shared_lib<<" until needed."<<std::endl;
+        auto pl = makeSO<DeferredPlugin>( std::move(path_to_shared_lib), std::move(mf) );
+        for ( const auto& f : pl->manifest().factories ) {
+          switch ( f.first ) {
+          case FactoryType::TextData:
+            FactImpl::registerFactory( std::make_unique<DeferredTextDataFactory>( pl, f.second ) );
+            break;
+          case FactoryType::Info:
+            FactImpl::registerFactory( std::make_unique<DeferredInfoFactory>( pl, f.second ) );
+            break;
+          case FactoryType::Scatter:
+            FactImpl::registerFactory( std::make_unique<DeferredScatterFactory>( pl, f.second ) );
+            break;
+          case FactoryType::Absorption:
+            FactImpl::registerFactory( std::make_unique<DeferredAbsorptionFactory>( pl, f.second ) );
+            break;
+          }
+        }
+      }
+    }
+  }
+}
+
 //Automatic enablement of .nxs/.laz support is controlled via the
 //NCRYSTAL_ENABLE_NXSLAZ macro, and the nxs/laz factories must obviously have
 //been built for this to work. Support for .ncmat files is on the other hand
@@ -212,11 +474,17 @@ void NCP::ensurePluginsLoaded()
   provideBuiltinPlugins();
 #endif
 
-  //Dynamic custom plugins, as indicated by environment variable:
+  //Dynamic custom plugins, as indicated by environment variable (deferring the
+  //actual loading for plugins with a manifest):
+  const bool nodefer = ncgetenv_bool("PLUGIN_NODEFER");
   for (auto& pluginlib : split2(ncgetenv("PLUGIN_LIST"),0,':')) {
     trim(pluginlib);
     if (pluginlib.empty())
       continue;
-    Plugins::loadDynamicPlugin(pluginlib);
+    auto manifest = ( nodefer ? NullOpt : readPluginManifest(pluginlib) );
+    if ( manifest.has_value() )
+      registerDeferredPlugin( pluginlib, std::move(manifest.value()) );
+    else
+      Plugins::loadDynamicPlugin(pluginlib);
   }
 }
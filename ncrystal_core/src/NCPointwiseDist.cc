@@ -21,6 +21,7 @@
 #include "NCrystal/internal/NCPointwiseDist.hh"
 #include "NCrystal/internal/NCMath.hh"
 #include <cstdio>
+#include <limits>
 
 NCrystal::PointwiseDist::PointwiseDist(const VectD &xvals, const VectD &yvals, double iw)
   : m_x(xvals), m_y(yvals), m_iweight(iw)
@@ -62,19 +63,83 @@ NCrystal::PointwiseDist::PointwiseDist(const VectD &xvals, const VectD &yvals, d
     m_cdf[i] *= normfact;
     m_y[i] *= normfact;
   }
+  initGuide();
+}
+
+void NCrystal::PointwiseDist::initGuide()
+{
+  //Guide table with one entry per bin (plus one), where m_guide[k] is the
+  //index of the first CDF value >= k/nguide:
+  m_guide.clear();
+  constexpr std::size_t nmin = 16;//binary search is fast enough for tiny tables
+  const std::size_t ncdf = m_cdf.size();
+  if ( ncdf < nmin || ncdf >= std::numeric_limits<uint32_t>::max() )
+    return;
+  const std::size_t nguide = ncdf - 1;
+  m_guide.reserve( nguide + 1 );
+  std::size_t i = 0;
+  for ( std::size_t k = 0; k <= nguide; ++k ) {
+    const double pk = double(k) / nguide;
+    while ( i < ncdf && m_cdf[i] < pk )
+      ++i;
+    m_guide.push_back( static_cast<uint32_t>( i ) );
+  }
+  m_guide.shrink_to_fit();
+}
+
+std::size_t NCrystal::PointwiseDist::approxMemoryUsage() const
+{
+  return ( m_x.size() + m_y.size() + m_cdf.size() ) * sizeof(double) + m_guide.size() * sizeof(uint32_t);
+}
+
+std::size_t NCrystal::PointwiseDist::findBin( double p ) const
+{
+  //Returns the same as std::lower_bound over m_cdf, but when a guide table is
+  //available the search range is limited to [m_guide[k],m_guide[k+1]] for
+  //k/nguide <= p < (k+1)/nguide:
+  if ( m_guide.empty() )
+    return std::lower_bound(m_cdf.begin(), m_cdf.end(), p)-m_cdf.begin();
+  const std::size_t nguide = m_guide.size() - 1;
+  const std::size_t k = std::min<std::size_t>( static_cast<std::size_t>( p * nguide ), nguide - 1 );
+  auto itB = m_cdf.begin() + m_guide[k];
+  auto itE = m_cdf.begin() + std::min<std::size_t>( std::size_t(m_guide[k+1]) + 1, m_cdf.size() );
+  return std::lower_bound( itB, itE, p ) - m_cdf.begin();
+}
+
+void NCrystal::PointwiseDist::sampleMany( RNG& rng, Span<double> out ) const
+{
+  if ( out.empty() )
+    return;
+  rng.generateMany( out.size(), out.data() );
+  for ( auto& e : out )
+    e = percentileWithIndex( e ).first;
 }
 
 NCrystal::PointwiseDist::~PointwiseDist()
 {
 }
 
+NCrystal::PointwiseDist::PointwiseDist( internal_data_t, VectD&& x, VectD&& y, VectD&& cdf, double iw )
+  : m_cdf(std::move(cdf)), m_x(std::move(x)), m_y(std::move(y)), m_iweight(iw)
+{
+  if ( m_x.size() != m_y.size() || m_x.size() != m_cdf.size() || m_x.size() < 2 )
+    NCRYSTAL_THROW(CalcError, "input vector size error.");
+  initGuide();
+}
+
+NCrystal::PointwiseDist NCrystal::PointwiseDist::createFromInternalData( VectD&& x, VectD&& y, VectD&& cdf,
+                                                                         double iw )
+{
+  return PointwiseDist( internal_data_t(), std::move(x), std::move(y), std::move(cdf), iw );
+}
+
 std::pair<double,unsigned> NCrystal::PointwiseDist::percentileWithIndex(double p ) const
 {
   nc_assert(p>=0.&&p<=1.0);
   if(p==1.)
     return std::pair<double,unsigned>(m_x.back(), m_x.size()-2);
 
-  std::size_t i = std::max<std::size_t>(std::min<std::size_t>(std::lower_bound(m_cdf.begin(), m_cdf.end(), p)-m_cdf.begin(),m_cdf.size()-1),1);
+  std::size_t i = std::max<std::size_t>(std::min<std::size_t>(findBin(p),m_cdf.size()-1),1);
   nc_assert( i>0 && i < m_x.size() );
   double dx = m_x[i]-m_x[i-1];
   double c = (p-m_cdf[i-1]);
@@ -123,6 +188,7 @@ NCrystal::PointwiseDist& NCrystal::PointwiseDist::operator+=(const NCrystal::Poi
   }
 
   this->m_iweight = totweight;
+  initGuide();
 
   return *this;
 }
@@ -19,6 +19,7 @@
 ////////////////////////////////////////////////////////////////////////////////
 
 #include "NCrystal/NCProc.hh"
+#include "NCrystal/internal/NCAbsOOV.hh"
 
 namespace NC = NCrystal;
 
@@ -34,6 +35,13 @@ NC::Scatter NC::Scatter::clone()
                   m_proc );
 }
 
+NC::Scatter NC::Scatter::clone( CachePool& pool )
+{
+  Scatter res( m_rngproducer, m_rngproducer->produce(), m_proc );
+  res.m_cachePtr = pool.acquire( *m_proc );
+  return res;
+}
+
 NC::Scatter NC::Scatter::cloneByIdx( RNGStreamIndex idx )
 {
   return Scatter( m_rngproducer,
@@ -72,7 +80,156 @@ void NC::Scatter::replaceRNGAndUpdateProducer( shared_obj<RNGStream> r )
   m_rng = std::move(r);
 }
 
+void NC::Scatter::replaceRNGWithSubstream( const RNGStream& base, uint64_t number )
+{
+  if ( !base.isSubstreamCapable() )
+    NCRYSTAL_THROW(BadInput,"Scatter::replaceRNGWithSubstream requires an RNG stream which is capable of creating substreams.");
+  m_rng = base.createSubstream( number );
+}
+
 NC::Absorption NC::Absorption::clone() const
 {
   return Absorption( m_proc );
 }
+
+NC::Absorption NC::Absorption::clone( CachePool& pool ) const
+{
+  Absorption res( m_proc );
+  res.m_cachePtr = pool.acquire( *m_proc );
+  return res;
+}
+
+NC::CachePtr NC::CachePool::acquire( const ProcImpl::Process& proc )
+{
+  const auto procid = proc.getUniqueID();
+  for ( auto it = m_entries.rbegin(); it != m_entries.rend(); ++it ) {
+    if ( it->procid == procid ) {
+      CachePtr res = std::move( it->cache );
+      m_entries.erase( std::next(it).base() );
+      return res;
+    }
+  }
+  return nullptr;
+}
+
+void NC::CachePool::release( const ProcImpl::Process& proc, CachePtr&& cp )
+{
+  if ( !cp )
+    return;
+  cp->invalidateCache();
+  m_entries.push_back( Entry{ proc.getUniqueID(), std::move(cp) } );
+}
+
+NC::MultiMaterialScatter::MultiMaterialScatter( std::vector<Scatter> materials )
+  : m_materials( std::move(materials) )
+{
+  if ( m_materials.empty() )
+    NCRYSTAL_THROW(BadInput,"MultiMaterialScatter: no materials provided.");
+}
+
+void NC::MultiMaterialScatter::groupByMaterial( const unsigned* imat, std::size_t N )
+{
+  //Counting sort of neutron indices by material, resulting in m_order[i] for
+  //i in [m_offsets[k],m_offsets[k+1]) being the neutrons in material k:
+  const std::size_t nmat = m_materials.size();
+  m_offsets.assign( nmat + 1, 0 );
+  for ( std::size_t i = 0; i < N; ++i ) {
+    if ( !( imat[i] < nmat ) )
+      NCRYSTAL_THROW2(BadInput,"MultiMaterialScatter: invalid material index "<<imat[i]);
+    ++m_offsets[imat[i]+1];
+  }
+  for ( std::size_t k = 0; k < nmat; ++k )
+    m_offsets[k+1] += m_offsets[k];
+  m_order.resize( N );
+  m_pos.assign( m_offsets.begin(), std::prev( m_offsets.end() ) );
+  for ( std::size_t i = 0; i < N; ++i )
+    m_order[m_pos[imat[i]]++] = i;
+  m_buf.resize( 5 * N );
+}
+
+void NC::MultiMaterialScatter::evalManyXS( const unsigned* imat, const double* ekin,
+                                           const double* ux, const double* uy, const double* uz,
+                                           std::size_t N, double* out_xs )
+{
+  if ( !N )
+    return;
+  groupByMaterial( imat, N );
+  double * g_ekin = m_buf.data();
+  double * g_ux = g_ekin + N;
+  double * g_uy = g_ux + N;
+  double * g_uz = g_uy + N;
+  double * g_xs = g_uz + N;
+  for ( std::size_t i = 0; i < N; ++i ) {
+    const std::size_t j = m_order[i];
+    g_ekin[i] = ekin[j];
+    g_ux[i] = ux[j];
+    g_uy[i] = uy[j];
+    g_uz[i] = uz[j];
+  }
+  for ( std::size_t k = 0; k < m_materials.size(); ++k ) {
+    const std::size_t b = m_offsets[k];
+    const std::size_t n = m_offsets[k+1] - b;
+    if ( n )
+      m_materials[k].evalManyXS( g_ekin + b, g_ux + b, g_uy + b, g_uz + b, n, g_xs + b );
+  }
+  for ( std::size_t i = 0; i < N; ++i )
+    out_xs[m_order[i]] = g_xs[i];
+}
+
+void NC::MultiMaterialScatter::sampleScatterMany( const unsigned* imat, double* ekin,
+                                                  double* ux, double* uy, double* uz, std::size_t N )
+{
+  if ( !N )
+    return;
+  groupByMaterial( imat, N );
+  double * g_ekin = m_buf.data();
+  double * g_ux = g_ekin + N;
+  double * g_uy = g_ux + N;
+  double * g_uz = g_uy + N;
+  for ( std::size_t i = 0; i < N; ++i ) {
+    const std::size_t j = m_order[i];
+    g_ekin[i] = ekin[j];
+    g_ux[i] = ux[j];
+    g_uy[i] = uy[j];
+    g_uz[i] = uz[j];
+  }
+  for ( std::size_t k = 0; k < m_materials.size(); ++k ) {
+    const std::size_t b = m_offsets[k];
+    const std::size_t n = m_offsets[k+1] - b;
+    if ( n )
+      m_materials[k].sampleScatterMany( g_ekin + b, g_ux + b, g_uy + b, g_uz + b, n );
+  }
+  for ( std::size_t i = 0; i < N; ++i ) {
+    const std::size_t j = m_order[i];
+    ekin[j] = g_ekin[i];
+    ux[j] = g_ux[i];
+    uy[j] = g_uy[i];
+    uz[j] = g_uz[i];
+  }
+}
+
+NC::TotalXS::TotalXS( Scatter scat, Absorption absn )
+  : m_scat( std::move(scat) ),
+    m_abs( std::move(absn) )
+{
+  if ( m_abs.isNull() ) {
+    m_absInline = true;
+  } else if ( auto oov = dynamic_cast<const AbsOOV*>( &m_abs.underlying() ) ) {
+    m_absInline = true;
+    m_oovConst = oov->oovConstant();
+  }
+}
+
+void NC::TotalXS::evalManyXSIsotropic( const double* ekin, std::size_t N,
+                                       double* out_scatter, double* out_absorption )
+{
+  m_scat.evalManyXSIsotropic( ekin, N, out_scatter );
+  if ( !m_absInline ) {
+    m_abs.evalManyXSIsotropic( ekin, N, out_absorption );
+  } else if ( m_oovConst == 0.0 ) {
+    std::fill( out_absorption, out_absorption + N, 0.0 );
+  } else {
+    for ( std::size_t i = 0; i < N; ++i )
+      out_absorption[i] = ekin[i] ? m_oovConst / std::sqrt( ekin[i] ) : kInfinity;
+  }
+}
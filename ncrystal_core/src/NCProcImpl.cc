@@ -20,6 +20,17 @@
 
 #include "NCrystal/NCProcImpl.hh"
 #include "NCrystal/internal/NCRandUtils.hh"
+#include "NCrystal/internal/NCPCBragg.hh"
+#include "NCrystal/internal/NCElIncScatter.hh"
+#include "NCrystal/internal/NCSABScatter.hh"
+#include "NCrystal/internal/NCBkgdExtCurve.hh"
+#include "NCrystal/internal/NCCounters.hh"
+#include "NCrystal/internal/NCString.hh"
+#include "NCrystal/internal/NCThreadUtils.hh"
+#include <functional>
+#include <chrono>
+#include <list>
+#include <unordered_map>
 
 namespace NC = NCrystal;
 namespace NCPI = NCrystal::ProcImpl;
@@ -34,12 +45,146 @@ NC::ScatterOutcome NCPI::ScatterIsotropicMat::sampleScatter( CachePtr& cp,
   return { outcome_isotropic.ekin, outdir };
 }
 
+void NCPI::Process::evalManyXS( CachePtr& cp, const double* ekin,
+                               const double* ux, const double* uy, const double* uz,
+                               std::size_t N, double* out_xs ) const
+{
+  for ( std::size_t i = 0; i < N; ++i )
+    out_xs[i] = crossSection( cp, NeutronEnergy{ekin[i]}, NeutronDirection{ux[i],uy[i],uz[i]} ).get();
+}
+
+void NCPI::Process::evalManyXSIsotropic( CachePtr& cp, const double* ekin, std::size_t N,
+                                        double* out_xs ) const
+{
+  for ( std::size_t i = 0; i < N; ++i )
+    out_xs[i] = crossSectionIsotropic( cp, NeutronEnergy{ekin[i]} ).dbl();
+}
+
+void NCPI::Process::sampleScatterMany( CachePtr& cp, RNG& rng, double* ekin,
+                                      double* ux, double* uy, double* uz,
+                                      std::size_t N ) const
+{
+  for ( std::size_t i = 0; i < N; ++i ) {
+    auto outcome = sampleScatter( cp, rng, NeutronEnergy{ekin[i]}, NeutronDirection{ux[i],uy[i],uz[i]} );
+    ekin[i] = outcome.ekin.dbl();
+    ux[i] = outcome.direction[0];
+    uy[i] = outcome.direction[1];
+    uz[i] = outcome.direction[2];
+  }
+}
+
+void NCPI::Process::sampleScatterIsotropicMany( CachePtr& cp, RNG& rng, double* ekin, std::size_t N,
+                                               double* out_mu ) const
+{
+  for ( std::size_t i = 0; i < N; ++i ) {
+    auto outcome = sampleScatterIsotropic( cp, rng, NeutronEnergy{ekin[i]} );
+    ekin[i] = outcome.ekin.dbl();
+    out_mu[i] = outcome.mu.dbl();
+  }
+}
+
+void NCPI::ScatterIsotropicMat::sampleScatterMany( CachePtr& cp, RNG& rng, double* ekin,
+                                                  double* ux, double* uy, double* uz,
+                                                  std::size_t N ) const
+{
+  if ( useLegacyRandSampling() )
+    return Process::sampleScatterMany( cp, rng, ekin, ux, uy, uz, N );
+  constexpr std::size_t nchunk = 128;
+  double mu[nchunk];
+  for ( std::size_t offset = 0; offset < N; offset += nchunk ) {
+    const std::size_t n = std::min<std::size_t>( nchunk, N - offset );
+    sampleScatterIsotropicMany( cp, rng, ekin + offset, n, mu );
+    randNeutronDirectionsGivenScatterMu( rng, mu, ux + offset, uy + offset, uz + offset, n );
+  }
+}
+
+NC::BiasedScatterOutcome NCPI::Process::sampleScatterBiased( CachePtr& cp, RNG& rng,
+                                                             NeutronEnergy ekin,
+                                                             const NeutronDirection& indir,
+                                                             const ScatterWindow& window ) const
+{
+  //Sample unbiased scatterings, keeping a uniformly chosen one of those inside
+  //the window (reservoir sampling):
+  nc_assert_always( window.ntrials > 0 );
+  BiasedScatterOutcome res{ { ekin, indir }, 0.0 };
+  std::size_t nhits = 0;
+  for ( unsigned i = 0; i < window.ntrials; ++i ) {
+    auto outcome = sampleScatter( cp, rng, ekin, indir );
+    const double mu = indir.as<Vector>().dot( outcome.direction.as<Vector>() );
+    if ( !window.contains( outcome.ekin, mu ) )
+      continue;
+    ++nhits;
+    if ( nhits == 1 || rng.generate() * nhits < 1.0 )
+      res.outcome = outcome;
+  }
+  res.weight = double(nhits) / window.ntrials;
+  return res;
+}
+
+NC::BiasedScatterOutcomeIsotropic NCPI::Process::sampleScatterIsotropicBiased( CachePtr& cp, RNG& rng,
+                                                                               NeutronEnergy ekin,
+                                                                               const ScatterWindow& window ) const
+{
+  //Same as sampleScatterBiased, but sampling the unbiased scatterings in
+  //chunks via sampleScatterIsotropicMany:
+  nc_assert_always( window.ntrials > 0 );
+  BiasedScatterOutcomeIsotropic res{ { ekin, CosineScatAngle{1.0} }, 0.0 };
+  constexpr std::size_t nchunk = 128;
+  double buf_ekin[nchunk];
+  double buf_mu[nchunk];
+  std::size_t nhits = 0;
+  for ( std::size_t offset = 0; offset < window.ntrials; offset += nchunk ) {
+    const std::size_t n = std::min<std::size_t>( nchunk, window.ntrials - offset );
+    std::fill( buf_ekin, buf_ekin + n, ekin.dbl() );
+    sampleScatterIsotropicMany( cp, rng, buf_ekin, n, buf_mu );
+    for ( std::size_t i = 0; i < n; ++i ) {
+      if ( !window.contains( NeutronEnergy{buf_ekin[i]}, buf_mu[i] ) )
+        continue;
+      ++nhits;
+      if ( nhits == 1 || rng.generate() * nhits < 1.0 )
+        res.outcome = { NeutronEnergy{buf_ekin[i]}, CosineScatAngle{buf_mu[i]} };
+    }
+  }
+  res.weight = double(nhits) / window.ntrials;
+  return res;
+}
+
+NC::BiasedScatterOutcome NCPI::ScatterIsotropicMat::sampleScatterBiased( CachePtr& cp, RNG& rng,
+                                                                         NeutronEnergy ekin,
+                                                                         const NeutronDirection& indir,
+                                                                         const ScatterWindow& window ) const
+{
+  auto res_isotropic = sampleScatterIsotropicBiased( cp, rng, ekin, window );
+  if ( !res_isotropic.weight )
+    return { { ekin, indir }, 0.0 };
+  auto outdir = randNeutronDirectionGivenScatterMu( rng, res_isotropic.outcome.mu.get(), indir.as<Vector>() );
+  return { { res_isotropic.outcome.ekin, outdir }, res_isotropic.weight };
+}
+
 NC::CrossSect NCPI::ScatterAnisotropicMat::crossSectionIsotropic( CachePtr&, NeutronEnergy ) const
 {
   NCRYSTAL_THROW(LogicError,"Process::crossSectionIsotropic can only be called for isotropic materials.");
   return CrossSect{0.0};
 }
 
+void NCPI::ScatterAnisotropicMat::evalManyXSIsotropic( CachePtr&, const double*, std::size_t, double* ) const
+{
+  NCRYSTAL_THROW(LogicError,"Process::evalManyXSIsotropic can only be called for isotropic materials.");
+}
+
+void NCPI::ScatterAnisotropicMat::sampleScatterIsotropicMany( CachePtr&, RNG&, double*, std::size_t, double* ) const
+{
+  NCRYSTAL_THROW(LogicError,"Process::sampleScatterIsotropicMany can only be called for isotropic materials.");
+}
+
+NC::BiasedScatterOutcomeIsotropic NCPI::ScatterAnisotropicMat::sampleScatterIsotropicBiased( CachePtr&, RNG&,
+                                                                                             NeutronEnergy,
+                                                                                             const ScatterWindow& ) const
+{
+  NCRYSTAL_THROW(LogicError,"Process::sampleScatterIsotropicBiased can only be called for isotropic materials.");
+  return { { NeutronEnergy{0.0}, CosineScatAngle{0.0} }, 0.0 };
+}
+
 NC::ScatterOutcomeIsotropic NCPI::ScatterAnisotropicMat::sampleScatterIsotropic( CachePtr&,
                                                                                  RNG&,
                                                                                  NeutronEnergy ) const
@@ -65,6 +210,35 @@ NC::ScatterOutcomeIsotropic NCPI::AbsorptionIsotropicMat::sampleScatterIsotropic
   return { NeutronEnergy{0.0}, CosineScatAngle{0.0} };
 }
 
+void NCPI::AbsorptionIsotropicMat::sampleScatterMany( CachePtr&, RNG&, double*, double*,
+                                                     double*, double*, std::size_t ) const
+{
+  NCRYSTAL_THROW(LogicError,"Process::sampleScatterMany can not be called for an absorption process.");
+}
+
+void NCPI::AbsorptionIsotropicMat::sampleScatterIsotropicMany( CachePtr&, RNG&, double*,
+                                                              std::size_t, double* ) const
+{
+  NCRYSTAL_THROW(LogicError,"Process::sampleScatterIsotropicMany can not be called for an absorption process.");
+}
+
+NC::BiasedScatterOutcome NCPI::AbsorptionIsotropicMat::sampleScatterBiased( CachePtr&, RNG&,
+                                                                            NeutronEnergy,
+                                                                            const NeutronDirection&,
+                                                                            const ScatterWindow& ) const
+{
+  NCRYSTAL_THROW(LogicError,"Process::sampleScatterBiased can not be called for an absorption process.");
+  return { { NeutronEnergy{0.0}, NeutronDirection{0,0,1} }, 0.0 };
+}
+
+NC::BiasedScatterOutcomeIsotropic NCPI::AbsorptionIsotropicMat::sampleScatterIsotropicBiased( CachePtr&, RNG&,
+                                                                                              NeutronEnergy,
+                                                                                              const ScatterWindow& ) const
+{
+  NCRYSTAL_THROW(LogicError,"Process::sampleScatterIsotropicBiased can not be called for an absorption process.");
+  return { { NeutronEnergy{0.0}, CosineScatAngle{0.0} }, 0.0 };
+}
+
 NC::ScatterOutcomeIsotropic NC::ProcImpl::NullProcess::sampleScatterIsotropic( CachePtr&,
                                                                                RNG&,
                                                                                NeutronEnergy ekin ) const
@@ -83,34 +257,387 @@ NC::ScatterOutcome NC::ProcImpl::NullProcess::sampleScatter( CachePtr&,
 namespace NCrystal {
   namespace ProcImpl {
 
+    //The most common components (for instance the PCBragg, ElIncScatter,
+    //SABScatter and BkgdExtCurve objects created by the standard factory for
+    //powders) are classified when caches are initialised, so their (final)
+    //cross section methods can be called without virtual dispatch:
+    namespace {
+      enum class ComponentKind : unsigned { Generic, PCBragg, ElIncScatter, SABScatter, BkgdExtCurve };
+
+      ComponentKind classifyComponent( const Process& p )
+      {
+        if ( dynamic_cast<const NC::PCBragg*>(&p) )
+          return ComponentKind::PCBragg;
+        if ( dynamic_cast<const NC::ElIncScatter*>(&p) )
+          return ComponentKind::ElIncScatter;
+        if ( dynamic_cast<const NC::SABScatter*>(&p) )
+          return ComponentKind::SABScatter;
+        if ( dynamic_cast<const NC::BkgdExtCurve*>(&p) )
+          return ComponentKind::BkgdExtCurve;
+        return ComponentKind::Generic;
+      }
+
+      inline CrossSect componentXSIsotropic( ComponentKind kind, const Process& p,
+                                             CachePtr& cp, NeutronEnergy ekin )
+      {
+        switch ( kind ) {
+        case ComponentKind::PCBragg:
+          return static_cast<const NC::PCBragg&>(p).crossSectionIsotropic(cp,ekin);
+        case ComponentKind::ElIncScatter:
+          return static_cast<const NC::ElIncScatter&>(p).crossSectionIsotropic(cp,ekin);
+        case ComponentKind::SABScatter:
+          return static_cast<const NC::SABScatter&>(p).crossSectionIsotropic(cp,ekin);
+        case ComponentKind::BkgdExtCurve:
+          return static_cast<const NC::BkgdExtCurve&>(p).crossSectionIsotropic(cp,ekin);
+        default:
+          return p.crossSectionIsotropic(cp,ekin);
+        }
+      }
+
+      //Global cache of cross sections in anisotropic materials, keyed on
+      //quantised (ekin,dir) values. It is used by ProcComposition objects for
+      //which enableXSQuantisation was called (usually via the xsquant cfg
+      //parameter), with the tolerance used both as the bin width of the
+      //direction components and as the relative bin width in
+      //energy. Component cross sections are evaluated at the bin centres and
+      //shared between all threads, which for instance benefits collimated
+      //monochromatic beams where many neutrons are effectively identical. At
+      //most NCRYSTAL_ANISOXS_CACHESIZE entries (default 100000) are kept,
+      //discarding the least recently used ones.
+      class AnisoXSCache final : private MoveOnly {
+      public:
+
+        static AnisoXSCache& get()
+        {
+          static AnisoXSCache s_cache( []()
+          {
+            const int nmax = ncgetenv_int("ANISOXS_CACHESIZE",100000);
+            if ( nmax < 1 )
+              NCRYSTAL_THROW2(BadInput,"Invalid value of NCRYSTAL_ANISOXS_CACHESIZE: "<<nmax);
+            return static_cast<std::size_t>(nmax);
+          }() );
+          return s_cache;
+        }
+
+        AnisoXSCache( std::size_t nmax )
+          : m_nmaxPerShard( ( nmax + nshards - 1 ) / nshards )
+        {
+        }
+
+        struct Key {
+          uint64_t procid;
+          unsigned nhistory;
+          std::int64_t ie, ix, iy, iz;
+          bool operator==( const Key& o ) const noexcept
+          {
+            return ie == o.ie && ix == o.ix && iy == o.iy && iz == o.iz
+              && procid == o.procid && nhistory == o.nhistory;
+          }
+        };
+
+        //NB: The tolerance of a given process (and nhistory value) must be
+        //fixed, since it is not part of the key:
+        static Key key( UniqueIDValue procid, unsigned nhistory, double tol,
+                        NeutronEnergy ekin, const NeutronDirection& dir )
+        {
+          nc_assert( ekin.dbl() > 0.0 );
+          nc_assert( tol > 0.0 );
+          const double invtol = 1.0 / tol;
+          return { procid.value, nhistory, bin( std::log( ekin.dbl() ), invtol ),
+                   bin( dir[0], invtol ), bin( dir[1], invtol ), bin( dir[2], invtol ) };
+        }
+
+        static void binCentre( const Key& k, double tol, NeutronEnergy& ekin, NeutronDirection& dir )
+        {
+          ekin = NeutronEnergy{ std::exp( ( k.ie + 0.5 ) * tol ) };
+          Vector v( ( k.ix + 0.5 ) * tol, ( k.iy + 0.5 ) * tol, ( k.iz + 0.5 ) * tol );
+          v.normalise();
+          dir = v.as<NeutronDirection>();
+        }
+
+        //Copy n cumulative component cross sections from the cache into
+        //out_commul if available:
+        bool lookup( const Key& k, double * out_commul, std::size_t n )
+        {
+          auto& shard = shardOf( k );
+          NCRYSTAL_LOCK_GUARD( shard.mtx );
+          auto it = shard.index.find( k );
+          if ( it == shard.index.end() )
+            return false;
+          shard.entries.splice( shard.entries.begin(), shard.entries, it->second );
+          const auto& v = it->second->second;
+          nc_assert_always( v.size() == n );
+          std::copy( v.begin(), v.end(), out_commul );
+          return true;
+        }
+
+        void insert( const Key& k, const double * commul, std::size_t n )
+        {
+          auto& shard = shardOf( k );
+          NCRYSTAL_LOCK_GUARD( shard.mtx );
+          if ( shard.index.find( k ) != shard.index.end() )
+            return;//another thread got there first (with identical values).
+          shard.entries.emplace_front( k, VectD( commul, commul + n ) );
+          shard.index[k] = shard.entries.begin();
+          if ( shard.entries.size() > m_nmaxPerShard ) {
+            shard.index.erase( shard.entries.back().first );
+            shard.entries.pop_back();
+          }
+        }
+
+      private:
+        static constexpr std::size_t nshards = 16;
+        struct KeyHash {
+          std::size_t operator()( const Key& k ) const noexcept
+          {
+            uint64_t h = k.procid * 0x9E3779B97F4A7C15ull + k.nhistory;
+            for ( auto v : { k.ie, k.ix, k.iy, k.iz } )
+              h = ( h ^ static_cast<uint64_t>( v ) ) * 0x100000001B3ull;
+            return static_cast<std::size_t>( h ^ ( h >> 29 ) );
+          }
+        };
+        struct Shard {
+          std::mutex mtx;
+          std::list<std::pair<Key,VectD>> entries;//most recently used first
+          std::unordered_map<Key,decltype(entries)::iterator,KeyHash> index;
+        };
+        std::size_t m_nmaxPerShard;
+        Shard m_shards[nshards];
+
+        static std::int64_t bin( double x, double invtol )
+        {
+          return static_cast<std::int64_t>( std::floor( x * invtol ) );
+        }
+
+        Shard& shardOf( const Key& k )
+        {
+          return m_shards[ ( KeyHash()( k ) >> 7 ) % nshards ];
+        }
+      };
+    }
+
     class CacheProcComp final : public CacheBase {
     public:
-      void invalidateCache() override { key_ekin = NeutronEnergy{-1.0}; }
+      void invalidateCache() override { key_ekin = NeutronEnergy{-1.0}; has_key_bin = false; }
 
       unsigned nHistory = 0;
       NeutronEnergy key_ekin = NeutronEnergy{-1.0};
       NeutronDirection key_dir = NeutronDirection{0.,0.,0.};//only used for anisotropic materials
       double tot_xs = -1.0;
+      AnisoXSCache::Key key_bin;//only used with AnisoXSCache
+      bool has_key_bin = false;
       struct ComponentCache {
         CachePtr cachePtr;
-        EnergyDomain domain;
       };
       SmallVector<ComponentCache,6> componentCache;
       SmallVector<double,6> componentXSectCommul;
+      CachedRandIdxPicker componentPicker;//must be invalidated when componentXSectCommul changes
 
-      void reset(unsigned nhist,const ProcComposition::ComponentList& comps) {
+      void reset(unsigned nhist,std::size_t ncomp) {
         nHistory = nhist;
         key_ekin = NeutronEnergy{-1.0};
         key_dir = NeutronDirection{0.,0.,0.};
         tot_xs = -1.0;
+        has_key_bin = false;
         componentCache.clear();
-        componentCache.reserve_hint(comps.size());
-        for ( auto e : comps )
-          componentCache.push_back({{nullptr},e.process->domain()});
+        componentCache.resize(ncomp);
         componentXSectCommul.clear();
-        componentXSectCommul.resize(comps.size(),0.0);
+        componentXSectCommul.resize(ncomp,0.0);
+        componentPicker.invalidate();
+      }
+      CacheProcComp() { reset(nHistory,0); }
+    };
+
+    class ProcComposition::EvalPlan {
+    public:
+      //Flat copy of the information needed for evaluating the components,
+      //stored contiguously so the hot loops do not have to chase the
+      //ProcPtr's or call virtual domain() methods. Only the per-component
+      //cache objects (which are polymorphic and created lazily by each
+      //component) are kept in the CacheProcComp objects:
+      struct Entry {
+        const Process* process;
+        double scale;
+        EnergyDomain domain;
+        ComponentKind kind;
+      };
+
+      EvalPlan( const ComponentList& comps )
+      {
+        m_entries.reserve( comps.size() );
+        for ( const auto& e : comps )
+          m_entries.push_back( Entry{ e.process.get(), e.scale,
+                                      e.process->domain(),
+                                      classifyComponent( *e.process ) } );
+        initSkipList();
+      }
+
+      std::size_t size() const noexcept { return m_entries.size(); }
+      const Entry& operator[]( std::size_t i ) const noexcept
+      {
+        nc_assert( i < m_entries.size() );
+        return m_entries[i];
+      }
+      const Entry* begin() const noexcept { return m_entries.data(); }
+      const Entry* end() const noexcept { return m_entries.data() + m_entries.size(); }
+
+      //The domain edges of the components split the energy axis into
+      //intervals inside which the set of active components is constant. For
+      //energies strictly inside such an interval, this returns the (sorted)
+      //indices of the components which must be evaluated. For energies
+      //exactly at an edge, where domains are inclusive at both ends, nullptr
+      //is returned and all domains must be tested:
+      const unsigned * activeComponents( NeutronEnergy ekin, unsigned& nactive ) const
+      {
+        const double e = ekin.dbl();
+        const std::size_t i = std::upper_bound( m_edges.begin(), m_edges.end(), e ) - m_edges.begin();
+        if ( i > 0 && m_edges[i-1] == e )
+          return nullptr;
+        nc_assert( i + 1 < m_intervals.size() );
+        const unsigned ibegin = m_intervals[i];
+        nactive = m_intervals[i+1] - ibegin;
+        return m_active.data() + ibegin;
+      }
+
+    private:
+      std::vector<Entry> m_entries;
+      VectD m_edges;//sorted unique domain edges
+      std::vector<unsigned> m_intervals;//offsets into m_active, m_edges.size()+2 entries
+      std::vector<unsigned> m_active;
+
+      void initSkipList()
+      {
+        for ( const auto& e : m_entries ) {
+          m_edges.push_back( e.domain.elow.dbl() );
+          m_edges.push_back( e.domain.ehigh.dbl() );
+        }
+        std::sort( m_edges.begin(), m_edges.end() );
+        m_edges.erase( std::unique( m_edges.begin(), m_edges.end() ), m_edges.end() );
+        //Interval i is the open range (m_edges[i-1],m_edges[i]), with
+        //-inf/+inf used beyond the first/last edge:
+        m_intervals.reserve( m_edges.size() + 2 );
+        for ( std::size_t i = 0; i <= m_edges.size(); ++i ) {
+          const double a = ( i == 0 ? -kInfinity : m_edges[i-1] );
+          const double b = ( i == m_edges.size() ? kInfinity : m_edges[i] );
+          m_intervals.push_back( static_cast<unsigned>( m_active.size() ) );
+          for ( unsigned icomp = 0; icomp < m_entries.size(); ++icomp ) {
+            const auto& d = m_entries[icomp].domain;
+            if ( d.elow.dbl() <= a && b <= d.ehigh.dbl() )
+              m_active.push_back( icomp );
+          }
+        }
+        m_intervals.push_back( static_cast<unsigned>( m_active.size() ) );
+      }
+    };
+
+    class XSTable {
+    public:
+      //Table of ncomp cumulative cross sections (e.g. of components, including
+      //scale factors) on a union energy grid. At each grid point both the
+      //value at the point itself and the limit from below are stored, making
+      //it possible to represent discontinuities exactly.
+      //
+      //The table covers [emin,emax], and is refined until linear interpolation
+      //reproduces exact values (provided by evaluators fct(ekin,out_commul)
+      //created with evalFactory) to the requested relative precision of the
+      //total. Energies in knownEdges are placed at grid points. Evaluators are
+      //not shared between threads:
+      using EvalFct = std::function<void(double,double*)>;
+      //
+      //If NUMA replication is enabled (cf. NCThreadUtils.hh), lookups use
+      //copies of the table local to the NUMA node of the calling thread:
+      XSTable( unsigned ncomp, double emin, double emax, VectD knownEdges,
+               double precision, unsigned nthreads,
+               const std::function<EvalFct()>& evalFactory );
+
+      //Create table for isotropic ProcComposition:
+      static std::shared_ptr<const XSTable> create( const ProcComposition&, double precision );
+
+      //Add energies where cross sections of process are known to be
+      //discontinuous (domain edges and Bragg edges of PCBragg instances,
+      //including those inside a ProcComposition):
+      static void addKnownEdges( const Process&, VectD& edges );
+
+      double emin() const noexcept { return m_emin; }
+      double emax() const noexcept { return m_emax; }
+
+      bool covers( double ekin ) const noexcept
+      {
+        return ekin >= m_emin && ekin <= m_emax;
+      }
+
+      //Fill out_commul with ncomp cumulative cross sections at ekin (which
+      //must be covered), returning the total:
+      double lookup( double ekin, double * out_commul ) const
+      {
+        const double * right_a;
+        const double * left_b;
+        const double t = locate( ekin, right_a, left_b );
+        for ( unsigned c = 0; c < m_ncomp; ++c )
+          out_commul[c] = right_a[c] + t * ( left_b[c] - right_a[c] );
+        return out_commul[m_ncomp-1];
+      }
+
+      std::size_t approxMemoryUsage() const noexcept
+      {
+        const Data& d = m_data.original();
+        return sizeof(XSTable) + ( 1 + m_data.nReplicas() ) * ( sizeof(Data) + ( d.egrid.size() + d.right.size() + d.left.size() ) * sizeof(double) );
+      }
+
+      double lookupTotal( double ekin ) const
+      {
+        const double * right_a;
+        const double * left_b;
+        const double t = locate( ekin, right_a, left_b );
+        const unsigned c = m_ncomp - 1;
+        return right_a[c] + t * ( left_b[c] - right_a[c] );
+      }
+
+      //Largest tabulated total in the grid points bracketing [e0,e1] (which
+      //must overlap the table), which is thus also an upper bound on
+      //interpolated totals in [e0,e1]:
+      double maxTotal( double e0, double e1 ) const
+      {
+        nc_assert( e0 <= e1 && e1 >= emin() && e0 <= emax() );
+        const Data& d = m_data.get();
+        std::size_t i0 = std::upper_bound( d.egrid.begin(), d.egrid.end(), e0 ) - d.egrid.begin();
+        std::size_t i1 = std::lower_bound( d.egrid.begin(), d.egrid.end(), e1 ) - d.egrid.begin();
+        i0 = ( i0 > 0 ? i0 - 1 : 0 );
+        i1 = std::min<std::size_t>( i1, d.egrid.size() - 1 );
+        double res = 0.0;
+        for ( std::size_t i = i0; i <= i1; ++i )
+          res = ncmax( res, ncmax( d.right[(i+1)*m_ncomp-1], d.left[(i+1)*m_ncomp-1] ) );
+        return res;
+      }
+
+    private:
+      struct Data {
+        VectD egrid;
+        VectD right;//values at grid points, ncomp per grid point
+        VectD left;//limits from below at grid points, ncomp per grid point
+      };
+      unsigned m_ncomp;
+      NUMAReplicated<Data> m_data;
+      double m_emin, m_emax;
+
+      static std::shared_ptr<const Data> build( unsigned ncomp, double emin, double emax, VectD knownEdges,
+                                                double precision, unsigned nthreads,
+                                                const std::function<EvalFct()>& evalFactory );
+
+      double locate( double ekin, const double *& right_a, const double *& left_b ) const
+      {
+        nc_assert( covers(ekin) );
+        const Data& d = m_data.get();
+        std::size_t i = ( std::upper_bound( d.egrid.begin(), d.egrid.end(), ekin ) - d.egrid.begin() ) - 1;
+        nc_assert( i < d.egrid.size() );
+        right_a = &d.right[ i * m_ncomp ];
+        if ( ekin == d.egrid[i] || i + 1 == d.egrid.size() ) {
+          left_b = right_a;
+          return 0.0;
+        }
+        left_b = &d.left[ ( i + 1 ) * m_ncomp ];
+        return ( ekin - d.egrid[i] ) / ( d.egrid[i+1] - d.egrid[i] );
       }
-      CacheProcComp() { reset(nHistory,{}); }
     };
 
     class ProcComposition::Impl {
@@ -124,7 +651,7 @@ namespace NCrystal {
           if ( THIS->m_components.empty() )
             NCRYSTAL_THROW(CalcError,"Attempting to use ProcComposition which has no components (if"
                            " intended to be vanishing use a NullProcess component instead).");
-          cache.reset(THIS->m_nHistory,THIS->m_components);
+          cache.reset(THIS->m_nHistory,THIS->m_components.size());
         }
         nc_assert(cache.componentCache.size()==THIS->m_components.size());
         nc_assert(cache.componentXSectCommul.size()==THIS->m_components.size());
@@ -142,30 +669,37 @@ namespace NCrystal {
         nc_assert(cache.key_dir.as<Vector>().isStrictNullVector());//no mixing between anisotropic and isotropic cache.
 
         //Compare cached ekin to provided value.
-        if ( cache.key_ekin == ekin )
+        if ( cache.key_ekin == ekin ) {
+          NCRYSTAL_COUNT(ProcCompCacheHit);
           return cache;
+        }
 
         //Try a bit more FP-sensible cache checking, in case 80-bit registers
         //are somehow messing up stuff (although it is rather unlikely that they
         //will given the non-inlined source of ekin):
-        if ( floateq(cache.key_ekin.dbl(),ekin.dbl(),1e-15,0.0) )
+        if ( floateq(cache.key_ekin.dbl(),ekin.dbl(),1e-15,0.0) ) {
+          NCRYSTAL_COUNT(ProcCompCacheHit);
           return cache;
+        }
 
         //Ok, cache was not valid!
+        NCRYSTAL_COUNT(ProcCompCacheMiss);
         cache.key_ekin = NeutronEnergy{-1.0};//put to invalid value while
                                              //updating for exception safety.
+        cache.componentPicker.invalidate();
 
-        unsigned ncomp = THIS->m_components.size();
-        cache.tot_xs = 0.0;
-        for ( unsigned i = 0; i < ncomp; ++ i ) {
-          auto comp = THIS->m_components[i];
-          auto& compCache = cache.componentCache[i];
-          CrossSect xs = ( compCache.domain.contains(ekin)
-                           ? comp.process->crossSectionIsotropic(compCache.cachePtr,ekin)
-                           : CrossSect{0.0} );
-          cache.componentXSectCommul[i] = ( cache.tot_xs += ( comp.scale * xs.dbl() ) );
+        if ( THIS->m_xstable && THIS->m_xstable->covers( ekin.dbl() ) ) {
+          cache.tot_xs = THIS->m_xstable->lookup( ekin.dbl(), cache.componentXSectCommul.data() );
+          cache.key_ekin = ekin;
+          return cache;
         }
 
+        calcComponents( THIS, cache, ekin,
+                        [ekin]( const EvalPlan::Entry& comp, CachePtr& cp )
+                        {
+                          return componentXSIsotropic( comp.kind, *comp.process, cp, ekin ).dbl();
+                        } );
+
         //All ok:
         cache.key_ekin = ekin;
         return cache;
@@ -182,8 +716,10 @@ namespace NCrystal {
         auto& cache = initAndAccessCache(THIS,cacheptr);
 
         //Compare cached ekin to provided value.
-        if ( cache.key_ekin == ekin && cache.key_dir == dir )
+        if ( cache.key_ekin == ekin && cache.key_dir == dir ) {
+          NCRYSTAL_COUNT(ProcCompCacheHit);
           return cache;
+        }
 
         //Try a bit more FP-sensible cache checking, in case 80-bit registers
         //are somehow messing up stuff (although it is rather unlikely that they
@@ -192,30 +728,182 @@ namespace NCrystal {
         if ( cmpfloat( cache.key_ekin.dbl(),ekin.dbl() )
              && cmpfloat( cache.key_dir[0],dir[0] )
              && cmpfloat( cache.key_dir[1],dir[1] )
-             && cmpfloat( cache.key_dir[2],dir[2] ) )
+             && cmpfloat( cache.key_dir[2],dir[2] ) ) {
+          NCRYSTAL_COUNT(ProcCompCacheHit);
           return cache;
+        }
+
+        if ( THIS->m_xsquant > 0.0 && ekin.dbl() > 0.0 )
+          return updateCacheQuantised( THIS, cache, ekin, dir );
 
         //Ok, cache was not valid!
+        NCRYSTAL_COUNT(ProcCompCacheMiss);
         cache.key_ekin = NeutronEnergy{-1.0};//put to invalid value while
                                              //updating for exception safety.
+        cache.has_key_bin = false;
+        cache.componentPicker.invalidate();
+        calcComponentsAnisotropic( THIS, cache, ekin, dir );
+
+        //All ok:
+        cache.key_ekin = ekin;
+        cache.key_dir = dir;
+        return cache;
+      }
+
+      static void calcComponentsAnisotropic( const ProcComposition* THIS,
+                                             CacheProcComp& cache,
+                                             NeutronEnergy ekin,
+                                             const NeutronDirection& dir )
+      {
+        calcComponents( THIS, cache, ekin,
+                        [ekin,&dir]( const EvalPlan::Entry& comp, CachePtr& cp )
+                        {
+                          return comp.process->crossSection( cp, ekin, dir ).dbl();
+                        } );
+      }
 
-        unsigned ncomp = THIS->m_components.size();
-        cache.tot_xs = 0.0;
-        for ( unsigned i = 0; i < ncomp; ++ i ) {
-          auto comp = THIS->m_components[i];
-          auto& compCache = cache.componentCache[i];
-          CrossSect xs = ( compCache.domain.contains(ekin)
-                           ? comp.process->crossSection(compCache.cachePtr,ekin,dir)
-                           : CrossSect{0.0} );
-          cache.componentXSectCommul[i] = ( cache.tot_xs += ( comp.scale * xs.get() ) );
+      template<class TFctXS>
+      static void calcComponents( const ProcComposition* THIS,
+                                  CacheProcComp& cache,
+                                  NeutronEnergy ekin,
+                                  TFctXS&& fctxs )
+      {
+        //Fill cache.componentXSectCommul and cache.tot_xs, evaluating only
+        //the components whose domain contains ekin:
+        const auto& plan = *THIS->m_plan;
+        const unsigned ncomp = plan.size();
+        double * commul = cache.componentXSectCommul.data();
+        double tot = 0.0;
+        unsigned nactive;
+        const unsigned * active = plan.activeComponents( ekin, nactive );
+        if ( active ) {
+          unsigned i = 0;
+          for ( unsigned ia = 0; ia < nactive; ++ia ) {
+            for ( ; i < active[ia]; ++i )
+              commul[i] = tot;
+            const auto& comp = plan[i];
+            commul[i] = ( tot += comp.scale * fctxs( comp, cache.componentCache[i].cachePtr ) );
+            ++i;
+          }
+          for ( ; i < ncomp; ++i )
+            commul[i] = tot;
+        } else {
+          for ( unsigned i = 0; i < ncomp; ++ i ) {
+            const auto& comp = plan[i];
+            if ( comp.domain.contains(ekin) )
+              tot += comp.scale * fctxs( comp, cache.componentCache[i].cachePtr );
+            commul[i] = tot;
+          }
         }
+        cache.tot_xs = tot;
+      }
 
-        //All ok:
+      static CacheProcComp& updateCacheQuantised( const ProcComposition* THIS,
+                                                  CacheProcComp& cache,
+                                                  NeutronEnergy ekin,
+                                                  const NeutronDirection& dir )
+      {
+        //Neutrons in the same (ekin,dir) bin share the cross sections
+        //evaluated at the bin centre:
+        const double tol = THIS->m_xsquant;
+        const auto key = AnisoXSCache::key( THIS->getUniqueID(), THIS->m_nHistory, tol, ekin, dir );
+        if ( cache.has_key_bin && cache.key_bin == key ) {
+          NCRYSTAL_COUNT(ProcCompCacheHit);
+          cache.key_ekin = ekin;
+          cache.key_dir = dir;
+          return cache;
+        }
+        NCRYSTAL_COUNT(ProcCompCacheMiss);
+        cache.key_ekin = NeutronEnergy{-1.0};
+        cache.has_key_bin = false;
+        cache.componentPicker.invalidate();
+        const std::size_t ncomp = THIS->m_components.size();
+        auto& qcache = AnisoXSCache::get();
+        if ( qcache.lookup( key, cache.componentXSectCommul.data(), ncomp ) ) {
+          cache.tot_xs = cache.componentXSectCommul[ncomp-1];
+        } else {
+          NeutronEnergy ekin_centre;
+          NeutronDirection dir_centre;
+          AnisoXSCache::binCentre( key, tol, ekin_centre, dir_centre );
+          calcComponentsAnisotropic( THIS, cache, ekin_centre, dir_centre );
+          qcache.insert( key, cache.componentXSectCommul.data(), ncomp );
+        }
         cache.key_ekin = ekin;
         cache.key_dir = dir;
+        cache.key_bin = key;
+        cache.has_key_bin = true;
         return cache;
       }
 
+      template<class TFctEvalComponentChunk>
+      static void evalMany( const ProcComposition* THIS,
+                            CachePtr& cacheptr,
+                            const double* ekin,
+                            std::size_t N,
+                            double* out_xs,
+                            TFctEvalComponentChunk&& evalComponentChunk )
+      {
+        //Evaluate in chunks, using a fixed size buffer for component cross
+        //sections. The contributions are added up in the same order as in
+        //updateCacheIsotropic/updateCacheAnisotropic, so results are identical
+        //to those of the single-neutron methods:
+        std::fill( out_xs, out_xs + N, 0.0 );
+        if ( N == 0 || THIS->m_components.empty() )
+          return;
+        auto& cache = initAndAccessCache(THIS,cacheptr);
+        constexpr std::size_t nchunk = 128;
+        double buf[nchunk];
+        const auto& plan = *THIS->m_plan;
+        const unsigned ncomp = plan.size();
+        for ( std::size_t offset = 0; offset < N; offset += nchunk ) {
+          const std::size_t n = std::min<std::size_t>( nchunk, N - offset );
+          const double * chunk_ekin = ekin + offset;
+          double * chunk_xs = out_xs + offset;
+          for ( unsigned i = 0; i < ncomp; ++ i ) {
+            const auto& comp = plan[i];
+            evalComponentChunk( *comp.process, cache.componentCache[i].cachePtr, offset, n, buf );
+            const double scale = comp.scale;
+            for ( std::size_t j = 0; j < n; ++j )
+              if ( comp.domain.contains( NeutronEnergy{chunk_ekin[j]} ) )
+                chunk_xs[j] += scale * buf[j];
+          }
+        }
+      }
+
+      template<class TFctSelectChunk, class TFctSampleComponentChunk>
+      static void sampleMany( const ProcComposition* THIS,
+                              CachePtr& cacheptr,
+                              std::size_t N,
+                              TFctSelectChunk&& selectChunk,
+                              TFctSampleComponentChunk&& sampleComponentChunk )
+      {
+        //First select components for all neutrons in a chunk, then let each
+        //component sample all the neutrons selected for it in one go. The
+        //value ncomp is used to indicate neutrons outside the domain, which
+        //should be left unchanged.
+        if ( N == 0 || THIS->m_components.empty() )
+          return;
+        constexpr std::size_t nchunk = 128;
+        unsigned choices[nchunk];
+        std::size_t selected[nchunk];
+        const unsigned ncomp = THIS->m_components.size();
+        for ( std::size_t offset = 0; offset < N; offset += nchunk ) {
+          const std::size_t n = std::min<std::size_t>( nchunk, N - offset );
+          selectChunk( offset, n, choices );
+          auto& cache = initAndAccessCache(THIS,cacheptr);
+          for ( unsigned i = 0; i < ncomp; ++ i ) {
+            std::size_t nselected = 0;
+            for ( std::size_t j = 0; j < n; ++j )
+              if ( choices[j] == i )
+                selected[nselected++] = offset + j;
+            if ( nselected > 0 )
+              sampleComponentChunk( *THIS->m_components[i].process,
+                                    cache.componentCache[i].cachePtr,
+                                    selected, nselected );
+          }
+        }
+      }
+
     };
   }
 }
@@ -229,6 +917,13 @@ NCPI::ProcComposition::ProcComposition( ComponentList components,
 }
 
 void NCPI::ProcComposition::addComponent( NCPI::ProcPtr process, double scale )
+{
+  ComponentList l;
+  l.push_back( Component{ scale, std::move(process) } );
+  addComponents( std::move(l) );
+}
+
+void NCPI::ProcComposition::addComponentImpl( NCPI::ProcPtr process, double scale )
 {
   if ( !process ) {
     NCRYSTAL_THROW(BadInput,"Trying to add nullptr component!");
@@ -246,11 +941,12 @@ void NCPI::ProcComposition::addComponent( NCPI::ProcPtr process, double scale )
   if (asproccomp) {
     if ( asproccomp == this )
       NCRYSTAL_THROW(BadInput,"It is not allowed to add a ProcComposition object as a component of itself");
-    addComponents( {SVAllowCopy,asproccomp->components()}, scale );
-
+    for ( const auto& e : asproccomp->components() )
+      addComponentImpl( e.process, e.scale * scale );
     return;
   }
   ++m_nHistory;//record changes to m_components.
+  m_xstable.reset();//any table is no longer valid
   auto expandDomain = [this]( EnergyDomain d )
   {
     if ( d.elow>=d.ehigh )
@@ -287,6 +983,17 @@ void NCPI::ProcComposition::addComponent( NCPI::ProcPtr process, double scale )
         return;
       }
     }
+    //Processes with different scales can only be merged if the resulting
+    //process incorporates the scales:
+    auto merged_process = e.process->createMergedScaled( *process, e.scale, scale );
+    if (merged_process!=nullptr) {
+      e.process = std::move(merged_process);
+      e.scale = 1.0;
+      if (e.process->materialType()==MaterialType::Anisotropic)
+        m_materialType = MaterialType::Anisotropic;
+      expandDomain(e.process->domain());
+      return;
+    }
   }
   //Add new component:
   if (process->materialType()==MaterialType::Anisotropic)
@@ -300,8 +1007,16 @@ void NCPI::ProcComposition::addComponent( NCPI::ProcPtr process, double scale )
 void NCPI::ProcComposition::addComponents( NCPI::ProcComposition::ComponentList components, double scale )
 {
   m_components.reserve_hint( m_components.size() + components.size() );
-  for ( auto&& e : components )
-    addComponent(std::move(e.process),e.scale*scale);
+  //Keep the evaluation plan in sync with m_components, even if an exception
+  //is thrown after some of the components were added:
+  try {
+    for ( auto&& e : components )
+      addComponentImpl(std::move(e.process),e.scale*scale);
+  } catch (...) {
+    m_plan = std::make_shared<const EvalPlan>( m_components );
+    throw;
+  }
+  m_plan = std::make_shared<const EvalPlan>( m_components );
 }
 
 NC::CrossSect NCPI::ProcComposition::crossSection( CachePtr& cacheptr,
@@ -325,6 +1040,374 @@ NC::CrossSect NCPI::ProcComposition::crossSectionIsotropic( CachePtr& cacheptr,
   return CrossSect{cache.tot_xs};
 }
 
+void NCPI::ProcComposition::evalManyXS( CachePtr& cacheptr, const double* ekin,
+                                       const double* ux, const double* uy, const double* uz,
+                                       std::size_t N, double* out_xs ) const
+{
+  if ( m_materialType == MaterialType::Isotropic )
+    return evalManyXSIsotropic( cacheptr, ekin, N, out_xs );
+  if ( m_xsquant > 0.0 ) {
+    //Use the shared cache of quantised cross sections:
+    for ( std::size_t i = 0; i < N; ++i )
+      out_xs[i] = crossSection( cacheptr, NeutronEnergy{ekin[i]},
+                                NeutronDirection{ux[i],uy[i],uz[i]} ).get();
+    return;
+  }
+  Impl::evalMany( this, cacheptr, ekin, N, out_xs,
+                  [ekin,ux,uy,uz]( const Process& p, CachePtr& cp,
+                                   std::size_t offset, std::size_t n, double * buf )
+                  {
+                    p.evalManyXS( cp, ekin + offset, ux + offset, uy + offset, uz + offset, n, buf );
+                  } );
+}
+
+void NCPI::ProcComposition::evalManyXSIsotropic( CachePtr& cacheptr, const double* ekin,
+                                                std::size_t N, double* out_xs ) const
+{
+  nc_assert( m_materialType == MaterialType::Isotropic );
+  if ( m_xstable ) {
+    for ( std::size_t j = 0; j < N; ++j ) {
+      const double e = ekin[j];
+      if ( !m_domain.contains( NeutronEnergy{e} ) )
+        out_xs[j] = 0.0;
+      else if ( m_xstable->covers( e ) )
+        out_xs[j] = m_xstable->lookupTotal( e );
+      else
+        out_xs[j] = Impl::updateCacheIsotropic( this, cacheptr, NeutronEnergy{e} ).tot_xs;
+    }
+    return;
+  }
+  Impl::evalMany( this, cacheptr, ekin, N, out_xs,
+                  [ekin]( const Process& p, CachePtr& cp,
+                          std::size_t offset, std::size_t n, double * buf )
+                  {
+                    p.evalManyXSIsotropic( cp, ekin + offset, n, buf );
+                  } );
+}
+
+void NCPI::ProcComposition::sampleScatterMany( CachePtr& cacheptr, RNG& rng, double* ekin,
+                                              double* ux, double* uy, double* uz,
+                                              std::size_t N ) const
+{
+  if ( useLegacyRandSampling() )
+    return Process::sampleScatterMany( cacheptr, rng, ekin, ux, uy, uz, N );
+  const bool anisotropic = ( m_materialType == MaterialType::Anisotropic );
+  const unsigned ncomp = m_components.size();
+  auto selectChunk = [this,&cacheptr,&rng,anisotropic,ncomp,ekin,ux,uy,uz]( std::size_t offset,
+                                                                            std::size_t n,
+                                                                            unsigned * choices )
+  {
+    for ( std::size_t j = 0; j < n; ++j ) {
+      const std::size_t idx = offset + j;
+      NeutronEnergy e{ekin[idx]};
+      if ( !m_domain.contains(e) ) {
+        choices[j] = ncomp;//no effect when xs=0
+        continue;
+      }
+      auto& cache = ( anisotropic
+                      ? Impl::updateCacheAnisotropic( this, cacheptr, e, NeutronDirection{ux[idx],uy[idx],uz[idx]} )
+                      : Impl::updateCacheIsotropic( this, cacheptr, e ) );
+      choices[j] = static_cast<unsigned>( cache.componentPicker.pick( rng, cache.componentXSectCommul ) );
+    }
+  };
+  constexpr std::size_t nchunk = 128;
+  double buf_ekin[nchunk], buf_ux[nchunk], buf_uy[nchunk], buf_uz[nchunk];
+  auto sampleComponentChunk = [&rng,ekin,ux,uy,uz,&buf_ekin,&buf_ux,&buf_uy,&buf_uz]( const Process& p,
+                                                                                       CachePtr& cp,
+                                                                                       const std::size_t * selected,
+                                                                                       std::size_t nselected )
+  {
+    for ( std::size_t k = 0; k < nselected; ++k ) {
+      const std::size_t idx = selected[k];
+      buf_ekin[k] = ekin[idx];
+      buf_ux[k] = ux[idx];
+      buf_uy[k] = uy[idx];
+      buf_uz[k] = uz[idx];
+    }
+    p.sampleScatterMany( cp, rng, buf_ekin, buf_ux, buf_uy, buf_uz, nselected );
+    for ( std::size_t k = 0; k < nselected; ++k ) {
+      const std::size_t idx = selected[k];
+      ekin[idx] = buf_ekin[k];
+      ux[idx] = buf_ux[k];
+      uy[idx] = buf_uy[k];
+      uz[idx] = buf_uz[k];
+    }
+  };
+  Impl::sampleMany( this, cacheptr, N, selectChunk, sampleComponentChunk );
+}
+
+void NCPI::ProcComposition::sampleScatterIsotropicMany( CachePtr& cacheptr, RNG& rng, double* ekin,
+                                                       std::size_t N, double* out_mu ) const
+{
+  nc_assert( m_materialType == MaterialType::Isotropic );
+  if ( useLegacyRandSampling() )
+    return Process::sampleScatterIsotropicMany( cacheptr, rng, ekin, N, out_mu );
+  const unsigned ncomp = m_components.size();
+  auto selectChunk = [this,&cacheptr,&rng,ncomp,ekin,out_mu]( std::size_t offset,
+                                                             std::size_t n,
+                                                             unsigned * choices )
+  {
+    for ( std::size_t j = 0; j < n; ++j ) {
+      const std::size_t idx = offset + j;
+      NeutronEnergy e{ekin[idx]};
+      if ( !m_domain.contains(e) ) {
+        choices[j] = ncomp;
+        out_mu[idx] = 1.0;//no effect when xs=0
+        continue;
+      }
+      auto& cache = Impl::updateCacheIsotropic( this, cacheptr, e );
+      choices[j] = static_cast<unsigned>( cache.componentPicker.pick( rng, cache.componentXSectCommul ) );
+    }
+  };
+  constexpr std::size_t nchunk = 128;
+  double buf_ekin[nchunk], buf_mu[nchunk];
+  auto sampleComponentChunk = [&rng,ekin,out_mu,&buf_ekin,&buf_mu]( const Process& p,
+                                                                   CachePtr& cp,
+                                                                   const std::size_t * selected,
+                                                                   std::size_t nselected )
+  {
+    for ( std::size_t k = 0; k < nselected; ++k )
+      buf_ekin[k] = ekin[selected[k]];
+    p.sampleScatterIsotropicMany( cp, rng, buf_ekin, nselected, buf_mu );
+    for ( std::size_t k = 0; k < nselected; ++k ) {
+      const std::size_t idx = selected[k];
+      ekin[idx] = buf_ekin[k];
+      out_mu[idx] = buf_mu[k];
+    }
+  };
+  Impl::sampleMany( this, cacheptr, N, selectChunk, sampleComponentChunk );
+}
+
+NC::CrossSect NCPI::ProcComposition::majorantCrossSection( EnergyDomain d ) const
+{
+  double result = 0.0;
+  for ( const auto& comp : m_components ) {
+    auto cd = comp.process->domain();
+    const double elow = std::max<double>( d.elow.dbl(), cd.elow.dbl() );
+    const double ehigh = std::min<double>( d.ehigh.dbl(), cd.ehigh.dbl() );
+    if ( elow > ehigh )
+      continue;//no overlap
+    result += comp.scale * comp.process->majorantCrossSection( { NeutronEnergy{elow}, NeutronEnergy{ehigh} } ).dbl();
+  }
+  return CrossSect{ result };
+}
+
+void NCPI::ProcComposition::accountMemory( MemoryFootprint& mf ) const
+{
+  mf.add( sizeof(ProcComposition) + m_components.size() * sizeof(Component) );
+  for ( const auto& comp : m_components )
+    mf.addSharedObject( comp.process );
+  if ( m_xstable )
+    mf.add( m_xstable->approxMemoryUsage() );
+}
+
+std::shared_ptr<const NCPI::XSTable> NCPI::XSTable::create( const ProcComposition& pc, double precision )
+{
+  const unsigned ncomp = static_cast<unsigned>( pc.m_components.size() );
+  nc_assert_always( ncomp > 0 );
+  nc_assert_always( pc.m_materialType == MaterialType::Isotropic );
+
+  //Range of table (outside which exact evaluations are always used):
+  constexpr double table_emin = 1e-5;//eV
+  constexpr double table_emax = 10.0;//eV
+  const double emin = std::max<double>( table_emin, pc.m_domain.elow.dbl() );
+  const double emax = std::min<double>( table_emax, pc.m_domain.ehigh.dbl() );
+  if ( !( emin < emax ) )
+    NCRYSTAL_THROW(BadInput,"ProcComposition::enableXSTable: process has no"
+                   " domain inside energy range covered by tables.");
+
+  //Collect energies of known discontinuities:
+  VectD edges;
+  for ( const auto& comp : pc.m_components )
+    addKnownEdges( *comp.process, edges );
+
+  //Exact evaluation, in the same manner as in Impl::updateCacheIsotropic:
+  auto evalFactory = [&pc,ncomp]() -> EvalFct
+  {
+    auto caches = std::make_shared<std::vector<CachePtr>>( ncomp );
+    return [&pc,ncomp,caches]( double e, double * out_commul )
+    {
+      const NeutronEnergy ekin{e};
+      double tot_xs = 0.0;
+      for ( unsigned i = 0; i < ncomp; ++i ) {
+        const auto& comp = pc.m_components[i];
+        CrossSect xs = ( comp.process->domain().contains(ekin)
+                         ? comp.process->crossSectionIsotropic((*caches)[i],ekin)
+                         : CrossSect{0.0} );
+        out_commul[i] = ( tot_xs += ( comp.scale * xs.dbl() ) );
+      }
+    };
+  };
+
+  return std::make_shared<const XSTable>( ncomp, emin, emax, std::move(edges), precision,
+                                          getNThreadsFromEnv(), evalFactory );
+}
+
+void NCPI::XSTable::addKnownEdges( const Process& p, VectD& edges )
+{
+  auto d = p.domain();
+  edges.push_back( d.elow.dbl() );
+  edges.push_back( d.ehigh.dbl() );
+  auto pcbragg = dynamic_cast<const PCBragg*>( &p );
+  if ( pcbragg ) {
+    const auto& be = pcbragg->braggEdgeEnergies();
+    edges.insert( edges.end(), be.begin(), be.end() );
+  }
+  auto pc = dynamic_cast<const ProcComposition*>( &p );
+  if ( pc ) {
+    for ( const auto& comp : pc->components() )
+      addKnownEdges( *comp.process, edges );
+  }
+}
+
+NCPI::XSTable::XSTable( unsigned ncomp, double emin, double emax, VectD edges,
+                        double precision, unsigned nthreads,
+                        const std::function<EvalFct()>& evalFactory )
+  : m_ncomp( ncomp ),
+    m_data( build( ncomp, emin, emax, std::move(edges), precision, nthreads, evalFactory ) ),
+    m_emin( m_data.original().egrid.front() ),
+    m_emax( m_data.original().egrid.back() )
+{
+}
+
+std::shared_ptr<const NCPI::XSTable::Data> NCPI::XSTable::build( unsigned ncomp, double emin, double emax, VectD edges,
+                                                                 double precision, unsigned nthreads,
+                                                                 const std::function<EvalFct()>& evalFactory )
+{
+  nc_assert_always( ncomp > 0 );
+  nc_assert_always( emin > 0.0 && emin < emax && std::isfinite( emax ) );
+  nc_assert_always( precision > 0.0 && precision < 1.0 );
+
+  //Initial grid, logarithmically spaced with the edges mixed in:
+  struct Node { double e; bool edge; };
+  std::vector<Node> initnodes;
+  constexpr unsigned npts_per_decade = 20;
+  const unsigned ninit = std::max<unsigned>( 2, static_cast<unsigned>( npts_per_decade * std::log10( emax / emin ) ) + 1 );
+  initnodes.reserve( ninit + edges.size() );
+  for ( unsigned i = 0; i < ninit; ++i )
+    initnodes.push_back( { ( i + 1 == ninit ? emax : emin * std::pow( emax / emin, double(i) / ( ninit - 1 ) ) ), false } );
+  for ( auto e : edges )
+    if ( e > emin && e < emax )
+      initnodes.push_back( { e, true } );
+  std::stable_sort( initnodes.begin(), initnodes.end(),
+                    []( const Node& a, const Node& b ) { return a.e < b.e; } );
+
+  //Merge duplicates (keeping the edge flag):
+  std::vector<Node> nodes;
+  nodes.reserve( initnodes.size() );
+  for ( std::size_t i = 0; i < initnodes.size(); ++i ) {
+    Node n = initnodes[i];
+    for ( ; i + 1 < initnodes.size() && initnodes[i+1].e == n.e; ++i )
+      n.edge = n.edge || initnodes[i+1].edge;
+    nodes.push_back( n );
+  }
+
+  //Evaluate at initial nodes:
+  const std::size_t ninitnodes = nodes.size();
+  VectD right_init( ninitnodes * ncomp ), left_init( ninitnodes * ncomp );
+  parallelFor( ninitnodes, nthreads, [&]( std::size_t i )
+  {
+    auto evalExact = evalFactory();
+    const Node& n = nodes[i];
+    evalExact( n.e, &right_init[i*ncomp] );
+    if ( n.edge )
+      evalExact( std::nextafter( n.e, 0.0 ), &left_init[i*ncomp] );
+    else
+      std::copy_n( &right_init[i*ncomp], ncomp, &left_init[i*ncomp] );
+  } );
+
+  //Refine intervals until linear interpolation at the midpoints reproduces
+  //exact values to the requested precision. The initial intervals are
+  //independent, so they are refined as separate tasks:
+  struct Points { VectD egrid, right, left; };
+  std::vector<Points> refined( ninitnodes > 0 ? ninitnodes - 1 : 0 );
+  parallelFor( refined.size(), nthreads, [&]( std::size_t iinterval )
+  {
+    const unsigned nc = ncomp;
+    Points& pts = refined[iinterval];
+    auto evalExact = evalFactory();
+    auto pushPoint = [&pts,nc]( double e, const double * right, const double * left )
+    {
+      pts.egrid.push_back( e );
+      pts.right.insert( pts.right.end(), right, right + nc );
+      pts.left.insert( pts.left.end(), left, left + nc );
+    };
+
+    VectD exact_mid( nc );
+    std::function<void(double,const double*,double,const double*,const double*)> refine;
+    refine = [&]( double ea, const double * right_a, double eb, const double * left_b, const double * right_b )
+    {
+      //Adds points in (ea,eb], assuming ea was already added.
+      const double em = 0.5 * ( ea + eb );
+      bool ok = !( em > ea && em < eb ) || ( eb - ea ) < 1e-10 * em;
+      if ( !ok ) {
+        evalExact( em, exact_mid.data() );
+        //Errors elsewhere in the interval might slightly exceed the one at the
+        //midpoint, so aim a bit lower than requested:
+        const double tol = 0.5 * precision * exact_mid[nc-1];
+        ok = true;
+        for ( unsigned c = 0; c < nc; ++c ) {
+          if ( !( ncabs( 0.5 * ( right_a[c] + left_b[c] ) - exact_mid[c] ) <= tol ) ) {
+            ok = false;
+            break;
+          }
+        }
+      }
+      if ( ok ) {
+        pushPoint( eb, right_b, left_b );
+        return;
+      }
+      VectD mid( exact_mid.begin(), exact_mid.end() );
+      refine( ea, right_a, em, mid.data(), mid.data() );
+      refine( em, mid.data(), eb, left_b, right_b );
+    };
+
+    const std::size_t i = iinterval;
+    refine( nodes[i].e, &right_init[i*nc],
+            nodes[i+1].e, &left_init[(i+1)*nc], &right_init[(i+1)*nc] );
+  } );
+
+  //Concatenate:
+  std::size_t ntot = 1;
+  for ( const auto& pts : refined )
+    ntot += pts.egrid.size();
+  auto res = std::make_shared<Data>();
+  res->egrid.reserve( ntot );
+  res->right.reserve( ntot * ncomp );
+  res->left.reserve( ntot * ncomp );
+  res->egrid.push_back( nodes.front().e );
+  res->right.insert( res->right.end(), &right_init[0], &right_init[0] + ncomp );
+  res->left.insert( res->left.end(), &left_init[0], &left_init[0] + ncomp );
+  for ( const auto& pts : refined ) {
+    res->egrid.insert( res->egrid.end(), pts.egrid.begin(), pts.egrid.end() );
+    res->right.insert( res->right.end(), pts.right.begin(), pts.right.end() );
+    res->left.insert( res->left.end(), pts.left.begin(), pts.left.end() );
+  }
+  return res;
+}
+
+void NCPI::ProcComposition::enableXSTable( double precision )
+{
+  if ( !( precision > 0.0 && precision < 1.0 ) )
+    NCRYSTAL_THROW2(BadInput,"ProcComposition::enableXSTable: invalid precision: "<<precision);
+  if ( m_materialType != MaterialType::Isotropic )
+    NCRYSTAL_THROW(BadInput,"ProcComposition::enableXSTable: only supported for isotropic materials.");
+  if ( m_components.empty() )
+    NCRYSTAL_THROW(BadInput,"ProcComposition::enableXSTable: no components.");
+  m_xstable = XSTable::create( *this, precision );
+  ++m_nHistory;//invalidate existing caches
+}
+
+void NCPI::ProcComposition::enableXSQuantisation( double tolerance )
+{
+  if ( !( tolerance > 0.0 && tolerance <= 0.1 ) )
+    NCRYSTAL_THROW2(BadInput,"ProcComposition::enableXSQuantisation: invalid tolerance: "<<tolerance);
+  if ( m_materialType != MaterialType::Anisotropic )
+    NCRYSTAL_THROW(BadInput,"ProcComposition::enableXSQuantisation: only supported for anisotropic materials.");
+  m_xsquant = tolerance;
+  ++m_nHistory;//invalidate existing caches (and entries in the shared cache)
+}
+
 NC::ScatterOutcome NCPI::ProcComposition::sampleScatter( CachePtr& cacheptr,
                                                          RNG& rng,
                                                          NeutronEnergy ekin,
@@ -336,7 +1419,7 @@ NC::ScatterOutcome NCPI::ProcComposition::sampleScatter( CachePtr& cacheptr,
   auto& cache = ( m_materialType == MaterialType::Anisotropic
                   ? Impl::updateCacheAnisotropic( this, cacheptr, ekin, dir )
                   : Impl::updateCacheIsotropic( this, cacheptr, ekin ) );
-  auto ichoice = pickRandIdxByWeight( rng, cache.componentXSectCommul );
+  auto ichoice = cache.componentPicker.pick( rng, cache.componentXSectCommul );
   return m_components[ichoice].process->sampleScatter(cache.componentCache[ichoice].cachePtr,rng,ekin,dir);
 }
 
@@ -348,10 +1431,104 @@ NC::ScatterOutcomeIsotropic NCPI::ProcComposition::sampleScatterIsotropic( Cache
     return { ekin, CosineScatAngle{1.0} };//no effect when xs=0
   nc_assert( m_materialType == MaterialType::Isotropic );
   auto& cache = Impl::updateCacheIsotropic( this, cacheptr, ekin );
-  auto ichoice = pickRandIdxByWeight( rng, cache.componentXSectCommul );
+  auto ichoice = cache.componentPicker.pick( rng, cache.componentXSectCommul );
   return m_components[ichoice].process->sampleScatterIsotropic(cache.componentCache[ichoice].cachePtr,rng,ekin);
 }
 
+NC::CrossSect NCPI::ProcComposition::componentCrossSections( CachePtr& cacheptr,
+                                                             NeutronEnergy ekin,
+                                                             const NeutronDirection& dir,
+                                                             double* out_commul ) const
+{
+  if ( ! m_domain.contains(ekin) ) {
+    std::fill( out_commul, out_commul + m_components.size(), 0.0 );
+    return CrossSect{ 0.0 };
+  }
+  auto& cache = ( m_materialType == MaterialType::Anisotropic
+                  ? Impl::updateCacheAnisotropic( this, cacheptr, ekin, dir )
+                  : Impl::updateCacheIsotropic( this, cacheptr, ekin ) );
+  std::copy( cache.componentXSectCommul.begin(), cache.componentXSectCommul.end(), out_commul );
+  return CrossSect{ cache.tot_xs };
+}
+
+NC::CrossSect NCPI::ProcComposition::componentCrossSectionsIsotropic( CachePtr& cacheptr,
+                                                                     NeutronEnergy ekin,
+                                                                     double* out_commul ) const
+{
+  if ( ! m_domain.contains(ekin) ) {
+    std::fill( out_commul, out_commul + m_components.size(), 0.0 );
+    return CrossSect{ 0.0 };
+  }
+  auto& cache = Impl::updateCacheIsotropic( this, cacheptr, ekin );
+  std::copy( cache.componentXSectCommul.begin(), cache.componentXSectCommul.end(), out_commul );
+  return CrossSect{ cache.tot_xs };
+}
+
+NC::ScatterOutcome NCPI::ProcComposition::sampleScatterComponent( CachePtr& cacheptr,
+                                                                  RNG& rng,
+                                                                  unsigned icomponent,
+                                                                  NeutronEnergy ekin,
+                                                                  const NeutronDirection& dir ) const
+{
+  if ( !( icomponent < m_components.size() ) )
+    NCRYSTAL_THROW2(BadInput,"ProcComposition::sampleScatterComponent: invalid component index "<<icomponent);
+  auto& cache = Impl::initAndAccessCache( this, cacheptr );
+  auto& compCache = cache.componentCache[icomponent];
+  if ( !(*m_plan)[icomponent].domain.contains(ekin) )
+    return { ekin, dir };//no effect when xs=0
+  return m_components[icomponent].process->sampleScatter( compCache.cachePtr, rng, ekin, dir );
+}
+
+NC::ScatterOutcomeIsotropic NCPI::ProcComposition::sampleScatterIsotropicComponent( CachePtr& cacheptr,
+                                                                                    RNG& rng,
+                                                                                    unsigned icomponent,
+                                                                                    NeutronEnergy ekin ) const
+{
+  if ( !( icomponent < m_components.size() ) )
+    NCRYSTAL_THROW2(BadInput,"ProcComposition::sampleScatterIsotropicComponent: invalid component index "<<icomponent);
+  nc_assert( m_materialType == MaterialType::Isotropic );
+  auto& cache = Impl::initAndAccessCache( this, cacheptr );
+  auto& compCache = cache.componentCache[icomponent];
+  if ( !(*m_plan)[icomponent].domain.contains(ekin) )
+    return { ekin, CosineScatAngle{1.0} };//no effect when xs=0
+  return m_components[icomponent].process->sampleScatterIsotropic( compCache.cachePtr, rng, ekin );
+}
+
+NC::BiasedScatterOutcome NCPI::ProcComposition::sampleScatterBiased( CachePtr& cacheptr,
+                                                                     RNG& rng,
+                                                                     NeutronEnergy ekin,
+                                                                     const NeutronDirection& dir,
+                                                                     const ScatterWindow& window ) const
+{
+  if (!m_domain.contains(ekin))
+    return { { ekin, dir }, 0.0 };//no scatterings when xs=0
+
+  auto& cache = ( m_materialType == MaterialType::Anisotropic
+                  ? Impl::updateCacheAnisotropic( this, cacheptr, ekin, dir )
+                  : Impl::updateCacheIsotropic( this, cacheptr, ekin ) );
+  if ( !( cache.tot_xs > 0.0 ) )
+    return { { ekin, dir }, 0.0 };
+  auto ichoice = cache.componentPicker.pick( rng, cache.componentXSectCommul );
+  return m_components[ichoice].process->sampleScatterBiased( cache.componentCache[ichoice].cachePtr,
+                                                             rng, ekin, dir, window );
+}
+
+NC::BiasedScatterOutcomeIsotropic NCPI::ProcComposition::sampleScatterIsotropicBiased( CachePtr& cacheptr,
+                                                                                       RNG& rng,
+                                                                                       NeutronEnergy ekin,
+                                                                                       const ScatterWindow& window ) const
+{
+  if (!m_domain.contains(ekin))
+    return { { ekin, CosineScatAngle{1.0} }, 0.0 };//no scatterings when xs=0
+  nc_assert( m_materialType == MaterialType::Isotropic );
+  auto& cache = Impl::updateCacheIsotropic( this, cacheptr, ekin );
+  if ( !( cache.tot_xs > 0.0 ) )
+    return { { ekin, CosineScatAngle{1.0} }, 0.0 };
+  auto ichoice = cache.componentPicker.pick( rng, cache.componentXSectCommul );
+  return m_components[ichoice].process->sampleScatterIsotropicBiased( cache.componentCache[ichoice].cachePtr,
+                                                                      rng, ekin, window );
+}
+
 NC::ProcImpl::ProcPtr NCPI::ProcComposition::combine( const ComponentList& components,
                                                       ProcessType processType )
 {
@@ -412,3 +1589,680 @@ void NC::ProcImpl::Process::initCachePtr(CachePtr& cp) const
   }
 
 }
+
+struct NCPI::ProfiledProcess::Shared {
+  Callback callback;
+  uint64_t reportInterval;
+  uint64_t stride;
+  std::atomic<uint64_t> ntopcalls{0};
+  std::mutex mtx;
+  //All nodes in the tree, top-level first (NB: raw pointers, since all nodes
+  //are kept alive by the top-level one):
+  std::vector<const ProfiledProcess*> nodes;
+};
+
+NCPI::ProfiledProcess::ProfiledProcess( ProcPtr p, std::shared_ptr<Shared> shared, unsigned depth )
+  : m_proc(std::move(p)),
+    m_shared(std::move(shared)),
+    m_depth(depth)
+{
+}
+
+NCPI::ProfiledProcess::~ProfiledProcess() = default;
+
+NC::ProcImpl::ProcPtr NCPI::ProfiledProcess::wrap( ProcPtr proc, Callback callback,
+                                                    uint64_t reportInterval, double sampleFraction )
+{
+  if ( !callback )
+    NCRYSTAL_THROW(BadInput,"ProfiledProcess::wrap: no callback provided");
+  if ( !reportInterval )
+    NCRYSTAL_THROW(BadInput,"ProfiledProcess::wrap: reportInterval must be positive");
+  if ( !(sampleFraction>0.0) || !(sampleFraction<=1.0) )
+    NCRYSTAL_THROW2(BadInput,"ProfiledProcess::wrap: sampleFraction must be in (0,1] (got "<<sampleFraction<<")");
+  if ( dynamic_cast<const ProfiledProcess*>(proc.get()) )
+    NCRYSTAL_THROW(BadInput,"ProfiledProcess::wrap: process is already profiled");
+
+  auto shared = std::make_shared<Shared>();
+  shared->callback = std::move(callback);
+  shared->reportInterval = reportInterval;
+  shared->stride = std::max<uint64_t>( 1, static_cast<uint64_t>( std::round( 1.0 / sampleFraction ) ) );
+
+  std::vector<const ProfiledProcess*> components;
+  auto asproccomp = dynamic_cast<const ProcComposition*>(proc.get());
+  if ( asproccomp ) {
+    //Profile each component, by placing wrapped components in a new
+    //ProcComposition. Components of a ProcComposition are never themselves
+    //ProcComposition objects, and they have already been merged, so the two
+    //lists of components will correspond exactly:
+    auto pc = makeSO<ProcComposition>( ProcComposition::ComponentList(), asproccomp->processType() );
+    for ( auto& c : asproccomp->components() ) {
+      auto pp = makeSO<ProfiledProcess>( c.process, shared, 1 );
+      components.push_back( pp.get() );
+      pc->addComponent( std::move(pp), c.scale );
+    }
+    nc_assert_always( pc->components().size() == asproccomp->components().size() );
+    //Any cross section table only depends on the physics of the components,
+    //and can thus be shared:
+    pc->m_xstable = asproccomp->m_xstable;
+    proc = std::move(pc);
+  }
+  auto top = makeSO<ProfiledProcess>( std::move(proc), shared, 0 );
+  shared->nodes.push_back( top.get() );
+  for ( auto c : components )
+    shared->nodes.push_back( c );
+  return top;
+}
+
+template<class TFct>
+inline void NCPI::ProfiledProcess::profile( Stats& stats, std::size_t n, TFct&& fct ) const
+{
+  const uint64_t stride = m_shared->stride;
+  const uint64_t before = stats.ncalls.fetch_add( n, std::memory_order_relaxed );
+  if ( before / stride != ( before + n ) / stride ) {
+    auto t0 = std::chrono::steady_clock::now();
+    fct();
+    auto dt = std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now() - t0 ).count();
+    stats.nsampled.fetch_add( n, std::memory_order_relaxed );
+    stats.sampledTime.fetch_add( static_cast<uint64_t>( std::max<decltype(dt)>(0,dt) ), std::memory_order_relaxed );
+  } else {
+    fct();
+  }
+  if ( m_depth == 0 ) {
+    const uint64_t interval = m_shared->reportInterval;
+    const uint64_t ntop = m_shared->ntopcalls.fetch_add( n, std::memory_order_relaxed );
+    if ( ntop / interval != ( ntop + n ) / interval ) {
+      NCRYSTAL_LOCK_GUARD(m_shared->mtx);
+      m_shared->callback( summary() );
+    }
+  }
+}
+
+std::vector<NCPI::ProfiledProcess::Entry> NCPI::ProfiledProcess::summary() const
+{
+  auto estimate = []( const Stats& s )
+  {
+    const uint64_t nsampled = s.nsampled.load( std::memory_order_relaxed );
+    if ( !nsampled )
+      return 0.0;
+    return 1e-9 * s.sampledTime.load( std::memory_order_relaxed )
+      * ( static_cast<double>( s.ncalls.load( std::memory_order_relaxed ) ) / nsampled );
+  };
+  std::vector<Entry> res;
+  res.reserve( m_shared->nodes.size() );
+  for ( auto node : m_shared->nodes ) {
+    Entry e;
+    e.name = node->m_proc->name();
+    e.depth = node->m_depth;
+    e.nCallsXS = node->m_statsXS.ncalls.load( std::memory_order_relaxed );
+    e.nCallsSampling = node->m_statsSampling.ncalls.load( std::memory_order_relaxed );
+    e.timeXS = estimate( node->m_statsXS );
+    e.timeSampling = estimate( node->m_statsSampling );
+    res.push_back( e );
+  }
+  return res;
+}
+
+NC::CrossSect NCPI::ProfiledProcess::crossSection( CachePtr& cp, NeutronEnergy ekin, const NeutronDirection& dir ) const
+{
+  CrossSect res;
+  profile( m_statsXS, 1, [&](){ res = m_proc->crossSection( cp, ekin, dir ); } );
+  return res;
+}
+
+NC::CrossSect NCPI::ProfiledProcess::crossSectionIsotropic( CachePtr& cp, NeutronEnergy ekin ) const
+{
+  CrossSect res;
+  profile( m_statsXS, 1, [&](){ res = m_proc->crossSectionIsotropic( cp, ekin ); } );
+  return res;
+}
+
+NC::ScatterOutcome NCPI::ProfiledProcess::sampleScatter( CachePtr& cp, RNG& rng, NeutronEnergy ekin,
+                                                         const NeutronDirection& dir ) const
+{
+  //NB: ScatterOutcome has no default constructor:
+  ScatterOutcome res{ ekin, dir };
+  profile( m_statsSampling, 1, [&](){ res = m_proc->sampleScatter( cp, rng, ekin, dir ); } );
+  return res;
+}
+
+NC::ScatterOutcomeIsotropic NCPI::ProfiledProcess::sampleScatterIsotropic( CachePtr& cp, RNG& rng, NeutronEnergy ekin ) const
+{
+  ScatterOutcomeIsotropic res{ ekin, CosineScatAngle{1.0} };
+  profile( m_statsSampling, 1, [&](){ res = m_proc->sampleScatterIsotropic( cp, rng, ekin ); } );
+  return res;
+}
+
+NC::BiasedScatterOutcome NCPI::ProfiledProcess::sampleScatterBiased( CachePtr& cp, RNG& rng, NeutronEnergy ekin,
+                                                                     const NeutronDirection& dir,
+                                                                     const ScatterWindow& window ) const
+{
+  BiasedScatterOutcome res{ { ekin, dir }, 0.0 };
+  profile( m_statsSampling, 1, [&](){ res = m_proc->sampleScatterBiased( cp, rng, ekin, dir, window ); } );
+  return res;
+}
+
+NC::BiasedScatterOutcomeIsotropic NCPI::ProfiledProcess::sampleScatterIsotropicBiased( CachePtr& cp, RNG& rng,
+                                                                                       NeutronEnergy ekin,
+                                                                                       const ScatterWindow& window ) const
+{
+  BiasedScatterOutcomeIsotropic res{ { ekin, CosineScatAngle{1.0} }, 0.0 };
+  profile( m_statsSampling, 1, [&](){ res = m_proc->sampleScatterIsotropicBiased( cp, rng, ekin, window ); } );
+  return res;
+}
+
+void NCPI::ProfiledProcess::evalManyXS( CachePtr& cp, const double* ekin,
+                                        const double* ux, const double* uy, const double* uz,
+                                        std::size_t N, double* out_xs ) const
+{
+  profile( m_statsXS, N, [&](){ m_proc->evalManyXS( cp, ekin, ux, uy, uz, N, out_xs ); } );
+}
+
+void NCPI::ProfiledProcess::evalManyXSIsotropic( CachePtr& cp, const double* ekin, std::size_t N,
+                                                 double* out_xs ) const
+{
+  profile( m_statsXS, N, [&](){ m_proc->evalManyXSIsotropic( cp, ekin, N, out_xs ); } );
+}
+
+void NCPI::ProfiledProcess::sampleScatterMany( CachePtr& cp, RNG& rng, double* ekin,
+                                               double* ux, double* uy, double* uz,
+                                               std::size_t N ) const
+{
+  profile( m_statsSampling, N, [&](){ m_proc->sampleScatterMany( cp, rng, ekin, ux, uy, uz, N ); } );
+}
+
+void NCPI::ProfiledProcess::sampleScatterIsotropicMany( CachePtr& cp, RNG& rng, double* ekin, std::size_t N,
+                                                        double* out_mu ) const
+{
+  profile( m_statsSampling, N, [&](){ m_proc->sampleScatterIsotropicMany( cp, rng, ekin, N, out_mu ); } );
+}
+
+void NCPI::ProfiledProcess::accountMemory( MemoryFootprint& mf ) const
+{
+  mf.add( sizeof(ProfiledProcess) );
+  mf.addSharedObject( m_proc );
+}
+
+NCPI::TabulatedXS::TabulatedXS( ProcPtr proc )
+  : TabulatedXS( std::move(proc), Params() )
+{
+}
+
+NCPI::TabulatedXS::TabulatedXS( ProcPtr proc, const Params& pars )
+  : m_proc( std::move(proc) )
+{
+  if ( m_proc->processType() != ProcessType::Scatter || m_proc->materialType() != MaterialType::Isotropic )
+    NCRYSTAL_THROW2(BadInput,"TabulatedXS: only isotropic scattering processes can be wrapped (got \""
+                    <<m_proc->name()<<"\").");
+  if ( !( pars.precision > 0.0 && pars.precision < 1.0 ) )
+    NCRYSTAL_THROW2(BadInput,"TabulatedXS: invalid precision: "<<pars.precision);
+  if ( !( pars.emin > 0.0 && pars.emin < pars.emax && std::isfinite( pars.emax ) ) )
+    NCRYSTAL_THROW2(BadInput,"TabulatedXS: invalid energy range: ["<<pars.emin<<", "<<pars.emax<<"]");
+
+  const auto dom = m_proc->domain();
+  const double emin = std::max<double>( pars.emin, dom.elow.dbl() );
+  const double emax = std::min<double>( pars.emax, dom.ehigh.dbl() );
+  if ( !( emin < emax ) )
+    return;//nothing to tabulate, always use exact evaluations
+
+  //Collect energies of known discontinuities:
+  VectD edges = pars.knownEdges;
+  XSTable::addKnownEdges( *m_proc, edges );
+
+  const Process& p = *m_proc;
+  auto evalFactory = [&p]() -> XSTable::EvalFct
+  {
+    auto cache = std::make_shared<CachePtr>();
+    return [&p,cache]( double e, double * out )
+    {
+      const NeutronEnergy ekin{e};
+      *out = ( p.domain().contains(ekin) ? p.crossSectionIsotropic( *cache, ekin ).dbl() : 0.0 );
+    };
+  };
+  m_table = std::make_shared<const XSTable>( 1, emin, emax, std::move(edges), pars.precision,
+                                             ( pars.nthreads ? pars.nthreads : getNThreadsFromEnv() ),
+                                             evalFactory );
+}
+
+NCPI::TabulatedXS::~TabulatedXS() = default;
+
+NC::CrossSect NCPI::TabulatedXS::crossSectionIsotropic( CachePtr& cp, NeutronEnergy ekin ) const
+{
+  if ( m_table && m_table->covers( ekin.dbl() ) )
+    return CrossSect{ m_table->lookupTotal( ekin.dbl() ) };
+  return m_proc->crossSectionIsotropic( cp, ekin );
+}
+
+void NCPI::TabulatedXS::evalManyXSIsotropic( CachePtr& cp, const double* ekin, std::size_t N,
+                                             double* out_xs ) const
+{
+  for ( std::size_t i = 0; i < N; ++i ) {
+    const double e = ekin[i];
+    out_xs[i] = ( m_table && m_table->covers( e )
+                  ? m_table->lookupTotal( e )
+                  : m_proc->crossSectionIsotropic( cp, NeutronEnergy{e} ).dbl() );
+  }
+}
+
+NC::ScatterOutcome NCPI::TabulatedXS::sampleScatter( CachePtr& cp, RNG& rng, NeutronEnergy ekin,
+                                                     const NeutronDirection& dir ) const
+{
+  return m_proc->sampleScatter( cp, rng, ekin, dir );
+}
+
+NC::ScatterOutcomeIsotropic NCPI::TabulatedXS::sampleScatterIsotropic( CachePtr& cp, RNG& rng,
+                                                                       NeutronEnergy ekin ) const
+{
+  return m_proc->sampleScatterIsotropic( cp, rng, ekin );
+}
+
+void NCPI::TabulatedXS::sampleScatterMany( CachePtr& cp, RNG& rng, double* ekin,
+                                           double* ux, double* uy, double* uz,
+                                           std::size_t N ) const
+{
+  m_proc->sampleScatterMany( cp, rng, ekin, ux, uy, uz, N );
+}
+
+void NCPI::TabulatedXS::sampleScatterIsotropicMany( CachePtr& cp, RNG& rng, double* ekin, std::size_t N,
+                                                    double* out_mu ) const
+{
+  m_proc->sampleScatterIsotropicMany( cp, rng, ekin, N, out_mu );
+}
+
+NC::BiasedScatterOutcome NCPI::TabulatedXS::sampleScatterBiased( CachePtr& cp, RNG& rng, NeutronEnergy ekin,
+                                                                 const NeutronDirection& dir,
+                                                                 const ScatterWindow& window ) const
+{
+  return m_proc->sampleScatterBiased( cp, rng, ekin, dir, window );
+}
+
+NC::BiasedScatterOutcomeIsotropic NCPI::TabulatedXS::sampleScatterIsotropicBiased( CachePtr& cp, RNG& rng,
+                                                                                   NeutronEnergy ekin,
+                                                                                   const ScatterWindow& window ) const
+{
+  return m_proc->sampleScatterIsotropicBiased( cp, rng, ekin, window );
+}
+
+NC::CrossSect NCPI::TabulatedXS::majorantCrossSection( EnergyDomain d ) const
+{
+  const double e0 = d.elow.dbl();
+  const double e1 = d.ehigh.dbl();
+  if ( !m_table || !( e0 <= e1 ) || e1 < m_table->emin() || e0 > m_table->emax() )
+    return m_proc->majorantCrossSection( d );
+  double res = m_table->maxTotal( e0, e1 );
+  //Parts of the domain outside the table use exact evaluations:
+  if ( e0 < m_table->emin() )
+    res = ncmax( res, m_proc->majorantCrossSection( { d.elow, NeutronEnergy{ m_table->emin() } } ).dbl() );
+  if ( e1 > m_table->emax() )
+    res = ncmax( res, m_proc->majorantCrossSection( { NeutronEnergy{ m_table->emax() }, d.ehigh } ).dbl() );
+  return CrossSect{ res };
+}
+
+void NCPI::TabulatedXS::accountMemory( MemoryFootprint& mf ) const
+{
+  mf.add( sizeof(TabulatedXS) );
+  if ( m_table )
+    mf.add( m_table->approxMemoryUsage() );
+  mf.addSharedObject( m_proc );
+}
+
+namespace NCrystal {
+  namespace ProcImpl {
+    namespace {
+      //Histogram of AdaptiveTabulatedXS covers [1e-8,1e4] eV (values outside
+      //are put in the first or last bin):
+      constexpr double adaptxs_log10emin = -8.0;
+      constexpr double adaptxs_log10emax = 4.0;
+    }
+  }
+}
+
+NCPI::AdaptiveTabulatedXS::AdaptiveTabulatedXS( ProcPtr proc )
+  : AdaptiveTabulatedXS( std::move(proc), Params() )
+{
+}
+
+NCPI::AdaptiveTabulatedXS::AdaptiveTabulatedXS( ProcPtr proc, const Params& pars )
+  : m_proc( std::move(proc) ),
+    m_pars( pars )
+{
+  if ( m_proc->processType() != ProcessType::Scatter || m_proc->materialType() != MaterialType::Isotropic )
+    NCRYSTAL_THROW2(BadInput,"AdaptiveTabulatedXS: only isotropic scattering processes can be wrapped (got \""
+                    <<m_proc->name()<<"\").");
+  if ( !( pars.precision > 0.0 && pars.precision < 1.0 ) )
+    NCRYSTAL_THROW2(BadInput,"AdaptiveTabulatedXS: invalid precision: "<<pars.precision);
+  if ( pars.nlearn < 1 )
+    NCRYSTAL_THROW(BadInput,"AdaptiveTabulatedXS: nlearn must be at least 1");
+  if ( pars.binsPerDecade < 1 || pars.binsPerDecade > 1000 )
+    NCRYSTAL_THROW2(BadInput,"AdaptiveTabulatedXS: invalid binsPerDecade: "<<pars.binsPerDecade);
+  m_nbins = static_cast<std::size_t>( ( adaptxs_log10emax - adaptxs_log10emin ) * pars.binsPerDecade );
+  m_hist.reset( new std::atomic<uint64_t>[m_nbins] );
+  for ( std::size_t i = 0; i < m_nbins; ++i )
+    m_hist[i].store( 0, std::memory_order_relaxed );
+}
+
+NCPI::AdaptiveTabulatedXS::~AdaptiveTabulatedXS() = default;
+
+void NCPI::AdaptiveTabulatedXS::record( const double* ekin, std::size_t N ) const
+{
+  const double bpd = m_pars.binsPerDecade;
+  const double xmax = static_cast<double>( m_nbins - 1 );
+  for ( std::size_t i = 0; i < N; ++i ) {
+    if ( !( ekin[i] > 0.0 ) )
+      continue;//also skips NaN
+    const double x = ncclamp( ( std::log10( ekin[i] ) - adaptxs_log10emin ) * bpd, 0.0, xmax );
+    m_hist[ static_cast<std::size_t>( x ) ].fetch_add( 1, std::memory_order_relaxed );
+  }
+  NCRYSTAL_COUNT_N( AdaptXSLearn, N );
+  //The table is built by the thread completing the learning phase:
+  const uint64_t n0 = m_ncalls.fetch_add( N, std::memory_order_relaxed );
+  if ( n0 < m_pars.nlearn && n0 + N >= m_pars.nlearn )
+    buildTable();
+}
+
+void NCPI::AdaptiveTabulatedXS::buildTable() const
+{
+  std::size_t ilow = m_nbins;
+  std::size_t ihigh = 0;
+  for ( std::size_t i = 0; i < m_nbins; ++i ) {
+    if ( m_hist[i].load( std::memory_order_relaxed ) ) {
+      ilow = std::min( ilow, i );
+      ihigh = i;
+    }
+  }
+  if ( ilow == m_nbins )
+    return;//no valid energies seen, keep using exact evaluations
+  //Widen by one bin on each side:
+  const double bpd = m_pars.binsPerDecade;
+  TabulatedXS::Params tpars;
+  tpars.precision = m_pars.precision;
+  tpars.emin = std::pow( 10.0, adaptxs_log10emin + ( ilow ? ilow - 1 : 0 ) / bpd );
+  tpars.emax = std::pow( 10.0, adaptxs_log10emin + std::min( ihigh + 2, m_nbins ) / bpd );
+  tpars.knownEdges = m_pars.knownEdges;
+  tpars.nthreads = m_pars.nthreads;
+  m_tabOwner = std::make_shared<const TabulatedXS>( m_proc, tpars );
+  m_tab.store( m_tabOwner.get(), std::memory_order_release );
+}
+
+NC::CrossSect NCPI::AdaptiveTabulatedXS::crossSectionIsotropic( CachePtr& cp, NeutronEnergy ekin ) const
+{
+  if ( auto t = tabulated() ) {
+    NCRYSTAL_COUNT( AdaptXSTable );
+    return t->crossSectionIsotropic( cp, ekin );
+  }
+  auto res = m_proc->crossSectionIsotropic( cp, ekin );
+  if ( m_ncalls.load( std::memory_order_relaxed ) < m_pars.nlearn )
+    record( &ekin.get(), 1 );
+  return res;
+}
+
+void NCPI::AdaptiveTabulatedXS::evalManyXSIsotropic( CachePtr& cp, const double* ekin, std::size_t N,
+                                                     double* out_xs ) const
+{
+  if ( auto t = tabulated() ) {
+    NCRYSTAL_COUNT_N( AdaptXSTable, N );
+    t->evalManyXSIsotropic( cp, ekin, N, out_xs );
+    return;
+  }
+  m_proc->evalManyXSIsotropic( cp, ekin, N, out_xs );
+  if ( m_ncalls.load( std::memory_order_relaxed ) < m_pars.nlearn )
+    record( ekin, N );
+}
+
+NC::ScatterOutcome NCPI::AdaptiveTabulatedXS::sampleScatter( CachePtr& cp, RNG& rng, NeutronEnergy ekin,
+                                                             const NeutronDirection& dir ) const
+{
+  return m_proc->sampleScatter( cp, rng, ekin, dir );
+}
+
+NC::ScatterOutcomeIsotropic NCPI::AdaptiveTabulatedXS::sampleScatterIsotropic( CachePtr& cp, RNG& rng,
+                                                                               NeutronEnergy ekin ) const
+{
+  return m_proc->sampleScatterIsotropic( cp, rng, ekin );
+}
+
+void NCPI::AdaptiveTabulatedXS::sampleScatterMany( CachePtr& cp, RNG& rng, double* ekin,
+                                                   double* ux, double* uy, double* uz,
+                                                   std::size_t N ) const
+{
+  m_proc->sampleScatterMany( cp, rng, ekin, ux, uy, uz, N );
+}
+
+void NCPI::AdaptiveTabulatedXS::sampleScatterIsotropicMany( CachePtr& cp, RNG& rng, double* ekin, std::size_t N,
+                                                            double* out_mu ) const
+{
+  m_proc->sampleScatterIsotropicMany( cp, rng, ekin, N, out_mu );
+}
+
+NC::BiasedScatterOutcome NCPI::AdaptiveTabulatedXS::sampleScatterBiased( CachePtr& cp, RNG& rng, NeutronEnergy ekin,
+                                                                         const NeutronDirection& dir,
+                                                                         const ScatterWindow& window ) const
+{
+  return m_proc->sampleScatterBiased( cp, rng, ekin, dir, window );
+}
+
+NC::BiasedScatterOutcomeIsotropic NCPI::AdaptiveTabulatedXS::sampleScatterIsotropicBiased( CachePtr& cp, RNG& rng,
+                                                                                           NeutronEnergy ekin,
+                                                                                           const ScatterWindow& window ) const
+{
+  return m_proc->sampleScatterIsotropicBiased( cp, rng, ekin, window );
+}
+
+void NCPI::AdaptiveTabulatedXS::accountMemory( MemoryFootprint& mf ) const
+{
+  mf.add( sizeof(AdaptiveTabulatedXS) + m_nbins * sizeof(std::atomic<uint64_t>) );
+  //The table is owned exclusively, and also accounts for the wrapped process:
+  if ( auto t = tabulated() )
+    t->accountMemory( mf );
+  else
+    mf.addSharedObject( m_proc );
+}
+
+NCPI::TabulatedMuSampling::TabulatedMuSampling( ProcPtr proc )
+  : TabulatedMuSampling( std::move(proc), Params() )
+{
+}
+
+NCPI::TabulatedMuSampling::TabulatedMuSampling( ProcPtr proc, const Params& pars )
+  : m_proc( std::move(proc) )
+{
+  if ( m_proc->processType() != ProcessType::Scatter || m_proc->materialType() != MaterialType::Isotropic )
+    NCRYSTAL_THROW2(BadInput,"TabulatedMuSampling: only isotropic scattering processes can be wrapped (got \""
+                    <<m_proc->name()<<"\").");
+  if ( !( pars.emin > 0.0 && pars.emin < pars.emax && std::isfinite( pars.emax ) ) )
+    NCRYSTAL_THROW2(BadInput,"TabulatedMuSampling: invalid energy range: ["<<pars.emin<<", "<<pars.emax<<"]");
+  if ( !( pars.nptsPerDecade > 0 && pars.nquantiles >= 2 && pars.nquantiles <= 1000000
+          && pars.nsamples >= pars.nquantiles && pars.nsamples <= 1000000000 ) )
+    NCRYSTAL_THROW2(BadInput,"TabulatedMuSampling: invalid parameters (nptsPerDecade="<<pars.nptsPerDecade
+                    <<", nquantiles="<<pars.nquantiles<<", nsamples="<<pars.nsamples
+                    <<"). Requires nptsPerDecade>0 and 2<=nquantiles<=nsamples.");
+
+  const auto dom = m_proc->domain();
+  const double emin = std::max<double>( pars.emin, dom.elow.dbl() );
+  const double emax = std::min<double>( pars.emax, dom.ehigh.dbl() );
+  if ( !( emin < emax ) )
+    return;//nothing to tabulate, always use the wrapped process
+
+  m_ngrid = std::max<std::size_t>( 2, static_cast<std::size_t>( pars.nptsPerDecade * std::log10( emax / emin ) ) + 1 );
+  m_logemin = std::log( emin );
+  const double dlog = ( std::log( emax ) - m_logemin ) / ( m_ngrid - 1 );
+  m_invdlog = 1.0 / dlog;
+  m_nquantiles = pars.nquantiles;
+  const unsigned nq1 = m_nquantiles + 1;
+  m_quantiles.resize( m_ngrid * nq1 );
+  m_valid.resize( m_ngrid, 0 );
+
+  const Process& p = *m_proc;
+  const unsigned nsamples = pars.nsamples;
+  auto fillGridPoint = [&]( std::size_t i )
+  {
+    const NeutronEnergy ekin{ ( i + 1 == m_ngrid ? emax : std::exp( m_logemin + i * dlog ) ) };
+    CachePtr cp;
+    if ( !p.domain().contains( ekin ) || !( p.crossSectionIsotropic( cp, ekin ).dbl() > 0.0 ) )
+      return;//no scatterings here
+    auto rng = createCounterBasedRNG( pars.seed, RNGStreamIndex{ i } );
+    VectD mu;
+    mu.reserve( nsamples );
+    for ( unsigned j = 0; j < nsamples; ++j ) {
+      auto outcome = p.sampleScatterIsotropic( cp, rng, ekin );
+      if ( outcome.ekin != ekin )
+        NCRYSTAL_THROW2(BadInput,"TabulatedMuSampling: wrapped process (\""<<p.name()<<"\") is not elastic.");
+      mu.push_back( outcome.mu.dbl() );
+    }
+    std::sort( mu.begin(), mu.end() );
+    //Quantiles at u=k/nquantiles, by linear interpolation in the sorted
+    //samples (placed at u=(j+0.5)/nsamples), keeping the extreme samples as
+    //end points:
+    double * q = &m_quantiles[ i * nq1 ];
+    for ( unsigned k = 0; k < nq1; ++k ) {
+      const double x = ncclamp( double(k) / m_nquantiles * nsamples - 0.5, 0.0, nsamples - 1.0 );
+      const std::size_t j = std::min<std::size_t>( static_cast<std::size_t>( x ), nsamples - 2 );
+      const double t = x - j;
+      q[k] = ncclamp( mu[j] + t * ( mu[j+1] - mu[j] ), -1.0, 1.0 );
+    }
+    q[0] = mu.front();
+    q[m_nquantiles] = mu.back();
+    m_valid[i] = 1;
+  };
+  parallelFor( m_ngrid, ( pars.nthreads ? pars.nthreads : getNThreadsFromEnv() ), fillGridPoint );
+}
+
+NCPI::TabulatedMuSampling::~TabulatedMuSampling() = default;
+
+NC::ScatterOutcomeIsotropic NCPI::TabulatedMuSampling::sampleScatterIsotropic( CachePtr& cp, RNG& rng,
+                                                                               NeutronEnergy ekin ) const
+{
+  const double x = ( m_ngrid ? ( std::log( ekin.dbl() ) - m_logemin ) * m_invdlog : -1.0 );
+  if ( !( x >= 0.0 && x <= double( m_ngrid - 1 ) ) )
+    return m_proc->sampleScatterIsotropic( cp, rng, ekin );
+  const std::size_t i = std::min<std::size_t>( static_cast<std::size_t>( x ), m_ngrid - 2 );
+  if ( !m_valid[i] || !m_valid[i+1] )
+    return m_proc->sampleScatterIsotropic( cp, rng, ekin );
+  const double t = x - i;
+
+  //Evaluate quantile functions at both grid points and interpolate:
+  const double y = rng.generate() * m_nquantiles;
+  const std::size_t k = std::min<std::size_t>( static_cast<std::size_t>( y ), m_nquantiles - 1 );
+  const double s = y - k;
+  const unsigned nq1 = m_nquantiles + 1;
+  const double * qa = &m_quantiles[ i * nq1 + k ];
+  const double * qb = qa + nq1;
+  const double mua = qa[0] + s * ( qa[1] - qa[0] );
+  const double mub = qb[0] + s * ( qb[1] - qb[0] );
+  return { ekin, CosineScatAngle{ ncclamp( mua + t * ( mub - mua ), -1.0, 1.0 ) } };
+}
+
+void NCPI::TabulatedMuSampling::accountMemory( MemoryFootprint& mf ) const
+{
+  mf.add( sizeof(TabulatedMuSampling) + m_quantiles.capacity() * sizeof(double) + m_valid.capacity() );
+  mf.addSharedObject( m_proc );
+}
+
+NCPI::LazyProcess::LazyProcess( MaterialType mt, ProcessType pt, EnergyDomain dom, Creator creator )
+  : m_materialType( mt ),
+    m_processType( pt ),
+    m_domain( dom ),
+    m_creator( std::move(creator) )
+{
+  if ( !m_creator )
+    NCRYSTAL_THROW(BadInput,"LazyProcess: no creator function provided");
+}
+
+NCPI::LazyProcess::~LazyProcess() = default;
+
+const NCPI::Process& NCPI::LazyProcess::process() const
+{
+  auto p = m_created.load( std::memory_order_acquire );
+  return p ? *p : createProcess();
+}
+
+const NCPI::Process& NCPI::LazyProcess::createProcess() const
+{
+  NCRYSTAL_LOCK_GUARD(m_mutex);
+  if ( m_proc != nullptr )
+    return *m_proc;
+  ProcPtr proc = m_creator();
+  if ( proc->materialType() != m_materialType || proc->processType() != m_processType )
+    NCRYSTAL_THROW2(LogicError,"LazyProcess: created process (\""<<proc->name()
+                    <<"\") has material or process type different from the declared one.");
+  auto d = proc->domain();
+  if ( !proc->isNull() && ( d.elow < m_domain.elow || d.ehigh > m_domain.ehigh ) )
+    NCRYSTAL_THROW2(LogicError,"LazyProcess: created process (\""<<proc->name()
+                    <<"\") has domain outside the declared one.");
+  m_proc = proc.getsp();
+  m_created.store( m_proc.get(), std::memory_order_release );
+  return *m_proc;
+}
+
+NC::CrossSect NCPI::LazyProcess::crossSection( CachePtr& cp, NeutronEnergy ekin, const NeutronDirection& dir ) const
+{
+  return process().crossSection( cp, ekin, dir );
+}
+
+NC::CrossSect NCPI::LazyProcess::crossSectionIsotropic( CachePtr& cp, NeutronEnergy ekin ) const
+{
+  return process().crossSectionIsotropic( cp, ekin );
+}
+
+NC::ScatterOutcome NCPI::LazyProcess::sampleScatter( CachePtr& cp, RNG& rng, NeutronEnergy ekin,
+                                                     const NeutronDirection& dir ) const
+{
+  return process().sampleScatter( cp, rng, ekin, dir );
+}
+
+NC::ScatterOutcomeIsotropic NCPI::LazyProcess::sampleScatterIsotropic( CachePtr& cp, RNG& rng,
+                                                                       NeutronEnergy ekin ) const
+{
+  return process().sampleScatterIsotropic( cp, rng, ekin );
+}
+
+void NCPI::LazyProcess::evalManyXS( CachePtr& cp, const double* ekin,
+                                    const double* ux, const double* uy, const double* uz,
+                                    std::size_t N, double* out_xs ) const
+{
+  process().evalManyXS( cp, ekin, ux, uy, uz, N, out_xs );
+}
+
+void NCPI::LazyProcess::evalManyXSIsotropic( CachePtr& cp, const double* ekin, std::size_t N,
+                                             double* out_xs ) const
+{
+  process().evalManyXSIsotropic( cp, ekin, N, out_xs );
+}
+
+void NCPI::LazyProcess::sampleScatterMany( CachePtr& cp, RNG& rng, double* ekin,
+                                           double* ux, double* uy, double* uz,
+                                           std::size_t N ) const
+{
+  process().sampleScatterMany( cp, rng, ekin, ux, uy, uz, N );
+}
+
+void NCPI::LazyProcess::sampleScatterIsotropicMany( CachePtr& cp, RNG& rng, double* ekin, std::size_t N,
+                                                    double* out_mu ) const
+{
+  process().sampleScatterIsotropicMany( cp, rng, ekin, N, out_mu );
+}
+
+NC::BiasedScatterOutcome NCPI::LazyProcess::sampleScatterBiased( CachePtr& cp, RNG& rng, NeutronEnergy ekin,
+                                                                 const NeutronDirection& dir,
+                                                                 const ScatterWindow& window ) const
+{
+  return process().sampleScatterBiased( cp, rng, ekin, dir, window );
+}
+
+NC::BiasedScatterOutcomeIsotropic NCPI::LazyProcess::sampleScatterIsotropicBiased( CachePtr& cp, RNG& rng,
+                                                                                   NeutronEnergy ekin,
+                                                                                   const ScatterWindow& window ) const
+{
+  return process().sampleScatterIsotropicBiased( cp, rng, ekin, window );
+}
+
+NC::CrossSect NCPI::LazyProcess::majorantCrossSection( EnergyDomain d ) const
+{
+  return process().majorantCrossSection( d );
+}
+
+void NCPI::LazyProcess::accountMemory( MemoryFootprint& mf ) const
+{
+  mf.add( sizeof(LazyProcess) );
+  if ( isCreated() )
+    mf.addSharedObject( m_proc );
+}
@@ -21,6 +21,8 @@
 #include "NCrystal/NCRNG.hh"
 #include "NCrystal/internal/NCRandUtils.hh"
 #include "NCrystal/internal/NCString.hh"
+#include "NCrystal/internal/NCCounters.hh"
+#include <cstring>
 
 #ifndef NCRYSTAL_DISABLE_THREADS
 #  include <thread>
@@ -131,6 +133,18 @@ NC::shared_obj<NC::RNGStream> NC::RNGStream::createJumped() const
   return optional_shared_obj<RNGStream>{nullptr};//can't just return nullptr when return type is shared_obj
 }
 
+NC::shared_obj<NC::RNGStream> NC::RNGStream::createForIndex( RNGStreamIndex ) const
+{
+  NCRYSTAL_THROW(LogicError,"createForIndex() is not supported by this RNG stream (check isIndexCapable() before calling).");
+  return optional_shared_obj<RNGStream>{nullptr};//can't just return nullptr when return type is shared_obj
+}
+
+NC::shared_obj<NC::RNGStream> NC::RNGStream::createSubstream( uint64_t ) const
+{
+  NCRYSTAL_THROW(LogicError,"createSubstream() is not supported by this RNG stream (check isSubstreamCapable() before calling).");
+  return optional_shared_obj<RNGStream>{nullptr};//can't just return nullptr when return type is shared_obj
+}
+
 bool NC::stateIsFromBuiltinRNG( const RNGStreamState& state )
 {
   return RNGStream_detail::extractStateUID( "NCrystal::stateIsFromBuiltinRNG", state.get() ) == RNGStream_detail::builtinRNGStateTypeUID;
@@ -144,13 +158,14 @@ namespace NCrystal {
     RNG_XRSR( RandXRSRImpl&& impl ) : m_impl(std::move(impl)) {}
     RNG_XRSR( no_init_t ) : m_impl(no_init) {}
 
-    bool coinflip() override { return m_impl.coinflip(); }
-    uint64_t generate64RndmBits() override { return m_impl.genUInt64(); }
-    uint32_t generate32RndmBits() override { return m_impl.genUInt32(); }
+    bool coinflip() override { NCRYSTAL_COUNT(RNGDraws); return m_impl.coinflip(); }
+    uint64_t generate64RndmBits() override { NCRYSTAL_COUNT(RNGDraws); return m_impl.genUInt64(); }
+    uint32_t generate32RndmBits() override { NCRYSTAL_COUNT(RNGDraws); return m_impl.genUInt32(); }
 
   protected:
 
-    double actualGenerate() override { return m_impl.generate(); }
+    double actualGenerate() override { NCRYSTAL_COUNT(RNGDraws); return m_impl.generate(); }
+    void actualGenerateMany( std::size_t n, double* tgt ) override { NCRYSTAL_COUNT_N(RNGDraws,n); m_impl.generateMany(n,tgt); }
 
     uint32_t stateTypeUID() const noexcept override {
       return RNGStream_detail::builtinRNGStateTypeUID;
@@ -197,6 +212,19 @@ namespace NCrystal {
       return clone;
     }
 
+    //Substreams are placed after a long-jump (i.e. 2^32 jumps) and then n
+    //additional jumps, to avoid clashes with the first 2^32 streams produced
+    //by jumping from the same state:
+    bool isSubstreamCapable() const override { return true; }
+
+    shared_obj<RNGStream> createSubstream( uint64_t n ) const override
+    {
+      auto clone = makeSO<RNG_XRSR>(RandXRSRImpl(m_impl.state()));
+      clone->m_impl.longJump();
+      clone->m_impl.jump( n );
+      return clone;
+    }
+
   private:
     RandXRSRImpl m_impl;
   };
@@ -207,9 +235,404 @@ namespace NCrystal {
     bool useInAllThreads() const override { return true; }
   protected:
     double actualGenerate() override { return m_fct(); }
+    void actualGenerateMany( std::size_t n, double* tgt ) override
+    {
+      for ( std::size_t i = 0; i < n; ++i )
+        tgt[i] = m_fct();
+    }
   private:
     std::function<double()> m_fct;
   };
+
+  class RNG_BulkFctForAllThreads final : public RNGStream {
+  public:
+    RNG_BulkFctForAllThreads( std::function<void(double*,unsigned)> fct, unsigned bufsize )
+      : m_fct{std::move(fct)}, m_bufsize(bufsize), m_serial(newSerial())
+    {
+      nc_assert_always(m_bufsize>0);
+    }
+    bool useInAllThreads() const override { return true; }
+  protected:
+    double actualGenerate() override
+    {
+      auto& tb = threadBuffer();
+      if ( tb.pos == tb.buf.size() )
+        refill(tb);
+      return tb.buf[tb.pos++];
+    }
+    void actualGenerateMany( std::size_t n, double* tgt ) override
+    {
+      auto& tb = threadBuffer();
+      while ( n ) {
+        if ( tb.pos == tb.buf.size() ) {
+          if ( n >= m_bufsize ) {
+            //Large request, bypass buffer:
+            const unsigned nchunk = static_cast<unsigned>( std::min<std::size_t>( n, std::numeric_limits<unsigned>::max() ) );
+            m_fct( tgt, nchunk );
+            tgt += nchunk;
+            n -= nchunk;
+            continue;
+          }
+          refill(tb);
+        }
+        const std::size_t nc = std::min<std::size_t>( n, tb.buf.size() - tb.pos );
+        std::copy( tb.buf.begin() + tb.pos, tb.buf.begin() + tb.pos + nc, tgt );
+        tb.pos += nc;
+        tgt += nc;
+        n -= nc;
+      }
+    }
+  private:
+    std::function<void(double*,unsigned)> m_fct;
+    unsigned m_bufsize;
+    uint64_t m_serial;//to detect buffers belonging to other (deleted) instances
+
+    struct ThreadBuffer {
+      uint64_t owner = 0;
+      std::vector<double> buf;
+      std::size_t pos = 0;
+    };
+    ThreadBuffer& threadBuffer()
+    {
+#ifndef NCRYSTAL_DISABLE_THREADS
+      thread_local ThreadBuffer t_buf;
+#else
+      static ThreadBuffer t_buf;
+#endif
+      if ( t_buf.owner != m_serial ) {
+        //Unused numbers from any previous owner are discarded
+        t_buf.owner = m_serial;
+        t_buf.buf.clear();
+        t_buf.pos = 0;
+      }
+      return t_buf;
+    }
+    void refill( ThreadBuffer& tb )
+    {
+      tb.buf.resize( m_bufsize );
+      m_fct( tb.buf.data(), m_bufsize );
+      tb.pos = 0;
+    }
+    static uint64_t newSerial()
+    {
+      static std::atomic<uint64_t> s_serial( 0 );
+      return ++s_serial;
+    }
+  };
+}
+
+namespace NCrystal {
+  template<unsigned NLANES>
+  class RNG_XRSRMultiLane final : public RNGStream {
+  public:
+    //NLANES interleaved xoroshiro128+ generators, with lane k starting k jumps
+    //(i.e. 2^64 steps) after lane 0, which starts in the same state as
+    //RNG_XRSR with the same seed. Numbers are generated a block at a time (one
+    //number per lane), using plain loops over the lanes which compilers can
+    //vectorise when wide registers are available (e.g. with AVX2 or AVX-512
+    //enabled). The stream is the sequence of blocks, each consumed in lane
+    //order, so results only depend on the seed and not on how the numbers are
+    //requested.
+    static_assert( NLANES == 4 || NLANES == 8, "" );
+    static constexpr uint32_t typeUID() { return NLANES == 4 ? 0x3e9a7c51 : 0x7d14b2e6; }//randomly generated
+
+    RNG_XRSRMultiLane( uint64_t seed )
+    {
+      RandXRSRImpl r(seed);
+      for ( unsigned k = 0; k < NLANES; ++k ) {
+        if ( k )
+          r.jump();
+        m_s0[k] = r.state()[0];
+        m_s1[k] = r.state()[1];
+      }
+    }
+    RNG_XRSRMultiLane( no_init_t ) {}
+
+  protected:
+
+    double actualGenerate() override
+    {
+      if ( m_pos == NLANES ) {
+        genBlock( m_buf );
+        m_pos = 0;
+      }
+      return m_buf[m_pos++];
+    }
+
+    void actualGenerateMany( std::size_t n, double* tgt ) override
+    {
+      //First any remaining numbers from the current block, then full blocks
+      //directly into the target:
+      for ( ; n && m_pos < NLANES; --n )
+        *tgt++ = m_buf[m_pos++];
+      for ( ; n >= NLANES; n -= NLANES, tgt += NLANES )
+        genBlock( tgt );
+      for ( ; n; --n )
+        *tgt++ = actualGenerate();
+    }
+
+    uint32_t stateTypeUID() const noexcept override { return typeUID(); }
+
+    //State is the lane states, the position in the current block, and the
+    //remaining numbers of the block:
+    void actualSetState( std::vector<uint8_t>&& v ) override
+    {
+      nc_assert_always( v.size() == (3*NLANES+1)*sizeof(uint64_t) );
+      for ( unsigned k = NLANES; k > 0; --k ) {
+        uint64_t bits = popFromStateVector<uint64_t>(v);
+        std::memcpy( &m_buf[k-1], &bits, sizeof(bits) );
+      }
+      const uint64_t pos = popFromStateVector<uint64_t>(v);
+      if ( pos > NLANES )
+        NCRYSTAL_THROW(BadInput,"Invalid RNG state.");
+      m_pos = static_cast<unsigned>(pos);
+      for ( unsigned k = NLANES; k > 0; --k ) {
+        m_s1[k-1] = popFromStateVector<uint64_t>(v);
+        m_s0[k-1] = popFromStateVector<uint64_t>(v);
+      }
+      nc_assert(v.empty());
+    }
+
+    std::vector<uint8_t> actualGetState() const override
+    {
+      std::vector<uint8_t> v;
+      v.reserve( (3*NLANES+1)*sizeof(uint64_t) );
+      for ( unsigned k = 0; k < NLANES; ++k ) {
+        appendToStateVector<uint64_t>(v,m_s0[k]);
+        appendToStateVector<uint64_t>(v,m_s1[k]);
+      }
+      appendToStateVector<uint64_t>(v,m_pos);
+      for ( unsigned k = 0; k < NLANES; ++k ) {
+        //Already consumed numbers are irrelevant (and zeroed, so equivalent
+        //streams always have identical states):
+        uint64_t bits = 0;
+        if ( k >= m_pos )
+          std::memcpy( &bits, &m_buf[k], sizeof(bits) );
+        appendToStateVector<uint64_t>(v,bits);
+      }
+      return v;
+    }
+
+    shared_obj<RNGStream> actualCloneWithNewState( std::vector<uint8_t>&& v ) const override
+    {
+      auto rng = makeSO<RNG_XRSRMultiLane>( no_init );
+      rng->actualSetState( std::move(v) );
+      return rng;
+    }
+
+    bool isJumpCapable() const override
+    {
+      return true;
+    }
+
+    shared_obj<RNGStream> createJumped() const override
+    {
+      //Jump all lanes NLANES times, so the lanes of the new stream follow
+      //after all the lanes of this one:
+      auto clone = makeSO<RNG_XRSRMultiLane>( no_init );
+      for ( unsigned k = 0; k < NLANES; ++k ) {
+        RandXRSRImpl r( RandXRSRImpl::state_t{ { m_s0[k], m_s1[k] } } );
+        for ( unsigned j = 0; j < NLANES; ++j )
+          r.jump();
+        clone->m_s0[k] = r.state()[0];
+        clone->m_s1[k] = r.state()[1];
+      }
+      return clone;
+    }
+
+  private:
+    uint64_t m_s0[NLANES];
+    uint64_t m_s1[NLANES];
+    double m_buf[NLANES];
+    unsigned m_pos = NLANES;//NLANES means that m_buf is used up
+
+    void genBlock( double * out )
+    {
+      //Same as RandXRSRImpl::genUInt64WithBadLowerBits, for all lanes at once:
+      for ( unsigned k = 0; k < NLANES; ++k ) {
+        const uint64_t s0 = m_s0[k];
+        uint64_t s1 = m_s1[k];
+        const uint64_t result = s0 + s1;
+        s1 ^= s0;
+        m_s0[k] = ((s0 << 55) | (s0 >> 9)) ^ s1 ^ (s1 << 14);
+        m_s1[k] = (s1 << 36) | (s1 >> 28);
+        out[k] = randUInt64ToFP01( result );
+      }
+    }
+  };
+}
+
+namespace NCrystal {
+  class RNG_Philox final : public RNGStream {
+  public:
+    //Counter-based generator, Philox4x32-10 (J. K. Salmon et al., "Parallel
+    //random numbers: as easy as 1, 2, 3", SC'11, doi:10.1145/2063384.2063405).
+    //The 64 bit seed is the key, and the 128 bit counter is composed of the
+    //64 bit stream index and the 64 bit index of the block in the stream. Each
+    //block provides 128 random bits, used for two numbers.
+
+    RNG_Philox( uint64_t seed, uint64_t streamidx ) : m_key(seed), m_stream(streamidx) {}
+
+    //Jumping simply increments the stream index, while streams created with
+    //createForIndex get the highest bit set, to avoid clashes between streams
+    //from RNGProducer::produce() and RNGProducer::produceByIdx():
+    static constexpr uint64_t indexedStreamBit = 0x8000000000000000ull;
+
+  protected:
+
+    double actualGenerate() override
+    {
+      if ( m_pos == 2 ) {
+        genBlock( m_nextBlock++, m_buf );
+        m_pos = 0;
+      }
+      return randUInt64ToFP01( m_buf[m_pos++] );
+    }
+
+    void actualGenerateMany( std::size_t n, double* tgt ) override
+    {
+      for ( ; n && m_pos < 2; --n )
+        *tgt++ = randUInt64ToFP01( m_buf[m_pos++] );
+      uint64_t blk[2];
+      for ( ; n >= 2; n -= 2 ) {
+        genBlock( m_nextBlock++, blk );
+        *tgt++ = randUInt64ToFP01( blk[0] );
+        *tgt++ = randUInt64ToFP01( blk[1] );
+      }
+      for ( ; n; --n )
+        *tgt++ = actualGenerate();
+    }
+
+    uint32_t stateTypeUID() const noexcept override { return 0x91c4e27a; }//randomly generated
+
+    //State is simply (key, stream index, next block index, position in current
+    //block), since the current block can be recalculated from these:
+    void actualSetState( std::vector<uint8_t>&& v ) override
+    {
+      nc_assert_always( v.size() == 4*sizeof(uint64_t) );
+      const uint64_t pos = popFromStateVector<uint64_t>(v);
+      m_nextBlock = popFromStateVector<uint64_t>(v);
+      m_stream = popFromStateVector<uint64_t>(v);
+      m_key = popFromStateVector<uint64_t>(v);
+      nc_assert(v.empty());
+      if ( pos > 2 || ( pos < 2 && m_nextBlock == 0 ) )
+        NCRYSTAL_THROW(BadInput,"Invalid RNG state.");
+      m_pos = static_cast<unsigned>(pos);
+      if ( m_pos < 2 )
+        genBlock( m_nextBlock - 1, m_buf );
+    }
+
+    std::vector<uint8_t> actualGetState() const override
+    {
+      std::vector<uint8_t> v;
+      v.reserve( 4*sizeof(uint64_t) );
+      appendToStateVector<uint64_t>(v,m_key);
+      appendToStateVector<uint64_t>(v,m_stream);
+      appendToStateVector<uint64_t>(v,m_nextBlock);
+      appendToStateVector<uint64_t>(v,m_pos);
+      return v;
+    }
+
+    shared_obj<RNGStream> actualCloneWithNewState( std::vector<uint8_t>&& v ) const override
+    {
+      auto rng = makeSO<RNG_Philox>( 0, 0 );
+      rng->actualSetState( std::move(v) );
+      return rng;
+    }
+
+    bool isJumpCapable() const override { return true; }
+
+    shared_obj<RNGStream> createJumped() const override
+    {
+      return makeSO<RNG_Philox>( m_key, m_stream + 1 );
+    }
+
+    bool isIndexCapable() const override { return true; }
+
+    shared_obj<RNGStream> createForIndex( RNGStreamIndex idx ) const override
+    {
+      if ( idx.get() & indexedStreamBit )
+        NCRYSTAL_THROW2(BadInput,"RNG stream index "<<idx.get()<<" too large for createForIndex (highest bit must be clear).");
+      return makeSO<RNG_Philox>( m_key, idx.get() | indexedStreamBit );
+    }
+
+    //Substreams use the number as stream index, with a key derived from the
+    //current key and stream index:
+    bool isSubstreamCapable() const override { return true; }
+
+    shared_obj<RNGStream> createSubstream( uint64_t n ) const override
+    {
+      uint64_t x = m_key;
+      uint64_t key = RandXRSRImpl::splitmix64(x);
+      x ^= m_stream;
+      key ^= RandXRSRImpl::splitmix64(x);
+      return makeSO<RNG_Philox>( key, n );
+    }
+
+  private:
+    uint64_t m_key;
+    uint64_t m_stream;
+    uint64_t m_nextBlock = 0;
+    uint64_t m_buf[2];
+    unsigned m_pos = 2;//2 means that m_buf is used up
+
+    void genBlock( uint64_t blockidx, uint64_t * out ) const
+    {
+      uint32_t c0 = static_cast<uint32_t>(blockidx);
+      uint32_t c1 = static_cast<uint32_t>(blockidx>>32);
+      uint32_t c2 = static_cast<uint32_t>(m_stream);
+      uint32_t c3 = static_cast<uint32_t>(m_stream>>32);
+      uint32_t k0 = static_cast<uint32_t>(m_key);
+      uint32_t k1 = static_cast<uint32_t>(m_key>>32);
+      for ( unsigned r = 0; r < 10; ++r ) {
+        if ( r ) {
+          k0 += 0x9E3779B9u;
+          k1 += 0xBB67AE85u;
+        }
+        const uint64_t p0 = static_cast<uint64_t>(0xD2511F53u) * c0;
+        const uint64_t p1 = static_cast<uint64_t>(0xCD9E8D57u) * c2;
+        const uint32_t hi0 = static_cast<uint32_t>(p0>>32), lo0 = static_cast<uint32_t>(p0);
+        const uint32_t hi1 = static_cast<uint32_t>(p1>>32), lo1 = static_cast<uint32_t>(p1);
+        c0 = hi1 ^ c1 ^ k0;
+        c1 = lo1;
+        c2 = hi0 ^ c3 ^ k1;
+        c3 = lo0;
+      }
+      out[0] = ( static_cast<uint64_t>(c1) << 32 ) | c0;
+      out[1] = ( static_cast<uint64_t>(c3) << 32 ) | c2;
+    }
+  };
+}
+
+NC::shared_obj<NC::RNGStream> NC::createCounterBasedRNG( uint64_t seed, RNGStreamIndex idx )
+{
+  if ( idx.get() & RNG_Philox::indexedStreamBit )
+    NCRYSTAL_THROW2(BadInput,"RNG stream index "<<idx.get()<<" too large for createCounterBasedRNG (highest bit must be clear).");
+  return makeSO<RNG_Philox>( seed, idx.get() );
+}
+
+NC::shared_obj<NC::RNGStream> NC::createBuiltinMultiLaneRNG( unsigned nlanes, uint64_t seed )
+{
+  if ( nlanes == 4 )
+    return makeSO<RNG_XRSRMultiLane<4>>(seed);
+  if ( nlanes == 8 )
+    return makeSO<RNG_XRSRMultiLane<8>>(seed);
+  NCRYSTAL_THROW2(BadInput,"createBuiltinMultiLaneRNG: unsupported number of lanes ("<<nlanes<<"), must be 4 or 8.");
+  return optional_shared_obj<RNGStream>{nullptr};//dummy
+}
+
+NC::shared_obj<NC::RNGStream> NC::createBuiltinMultiLaneRNG( const RNGStreamState& state )
+{
+  const uint32_t uid = RNGStream_detail::extractStateUID( "NCrystal::createBuiltinMultiLaneRNG", state.get() );
+  optional_shared_obj<RNGStream> rng;
+  if ( uid == RNG_XRSRMultiLane<4>::typeUID() )
+    rng = makeSO<RNG_XRSRMultiLane<4>>( no_init );
+  else if ( uid == RNG_XRSRMultiLane<8>::typeUID() )
+    rng = makeSO<RNG_XRSRMultiLane<8>>( no_init );
+  else
+    NCRYSTAL_THROW(BadInput,"createBuiltinMultiLaneRNG: state is not from a multi-lane builtin RNG.");
+  rng->setState(state);
+  return rng;
 }
 
 NC::shared_obj<NC::RNGStream> NC::createBuiltinRNG( uint64_t seed )
@@ -266,12 +689,22 @@ void NC::setDefaultRNGFctForAllThreads( std::function<double()> fct )
   setDefaultRNG(makeSO<RNG_OneFctForAllThreads>(fct));
 }
 
+void NC::setDefaultRNGBulkFctForAllThreads( std::function<void(double*,unsigned)> fct, unsigned bufsize )
+{
+  if ( !bufsize )
+    NCRYSTAL_THROW(BadInput,"setDefaultRNGBulkFctForAllThreads: bufsize must be positive");
+  setDefaultRNG(makeSO<RNG_BulkFctForAllThreads>(std::move(fct),bufsize));
+}
+
 namespace NCrystal {
   struct RNGProducer::Impl {
     Impl( shared_obj<RNGStream> rng ) : m_nextproduct( std::move(rng) ) {}
     Impl( no_init_t ) {}
+    //Unique (never reused) id, used for validating per-thread cache entries:
+    const uint64_t m_serial = newSerial();
     optional_shared_obj<RNGStream> m_nextproduct;
     optional_shared_obj<RNGStream> m_nextnextproduct;
+    optional_shared_obj<RNGStream> m_indexsource;//set if streams can be created directly by index
     std::map<RNGStreamIndex,optional_shared_obj<RNGStream>> m_idxdb;
     std::map<ThreadID,optional_shared_obj<RNGStream>> m_thread_idxdb;
     std::mutex m_mtx;
@@ -280,7 +713,54 @@ namespace NCrystal {
     shared_obj<RNGStream> produceByIdxUnlocked( RNGStreamIndex );
     shared_obj<RNGStream> produceByThreadIdxUnlocked( ThreadID );
     static uint64_t currentThreadID();
+    static uint64_t newSerial()
+    {
+      static std::atomic<uint64_t> s_serial( 0 );
+      return ++s_serial;
+    }
   };
+
+  namespace {
+    //Tiny per-thread cache of streams already produced for the current thread
+    //by recently used producers, allowing produceForCurrentThread() to skip
+    //the producer mutex on repeated calls (the producer's thread map is still
+    //the authoritative record, so the same streams are returned as before):
+    struct ThreadStreamCache {
+      static constexpr unsigned nentries = 4;
+      struct Entry {
+        uint64_t serial = 0;
+        optional_shared_obj<RNGStream> stream;
+      };
+      std::array<Entry,nentries> entries;
+      unsigned nextSlot = 0;
+
+      const optional_shared_obj<RNGStream>* find( uint64_t serial ) const
+      {
+        for ( auto& e : entries )
+          if ( e.serial == serial )
+            return &e.stream;
+        return nullptr;
+      }
+
+      void add( uint64_t serial, shared_obj<RNGStream> stream )
+      {
+        auto& e = entries[nextSlot];
+        nextSlot = ( nextSlot + 1 ) % nentries;
+        e.serial = serial;
+        e.stream = std::move(stream);
+      }
+    };
+
+    ThreadStreamCache& threadStreamCache()
+    {
+#ifndef NCRYSTAL_DISABLE_THREADS
+      thread_local ThreadStreamCache t_cache;
+#else
+      static ThreadStreamCache t_cache;
+#endif
+      return t_cache;
+    }
+  }
 }
 void NC::RNGProducer::Impl::jumpFillNextNextIfAppropriate()
 {
@@ -310,7 +790,7 @@ NC::shared_obj<NC::RNGStream> NC::RNGProducer::Impl::produceByIdxUnlocked( RNGSt
 {
   optional_shared_obj<RNGStream>& entry = m_idxdb[idx];
   if ( entry == nullptr )
-    entry = produceUnlocked();
+    entry = ( m_indexsource != nullptr ? m_indexsource->createForIndex( idx ) : produceUnlocked() );
   return entry;
 }
 
@@ -341,8 +821,18 @@ NC::shared_obj<NC::RNGStream> NC::RNGProducer::produceForCurrentThread()
 #else
   ThreadID thread_id = 1;//always the same!
 #endif
-  NCRYSTAL_LOCK_GUARD(m_impl->m_mtx);
-  return m_impl->produceByThreadIdxUnlocked(thread_id);
+  auto& tcache = threadStreamCache();
+  const uint64_t serial = m_impl->m_serial;
+  auto cached = tcache.find( serial );
+  if ( cached )
+    return *cached;
+  optional_shared_obj<RNGStream> result;
+  {
+    NCRYSTAL_LOCK_GUARD(m_impl->m_mtx);
+    result = m_impl->produceByThreadIdxUnlocked(thread_id);
+  }
+  tcache.add( serial, result );
+  return result;
 }
 
 NC::RNGProducer::RNGProducer( no_init_t )
@@ -360,6 +850,11 @@ NC::shared_obj<NC::RNGProducer> NC::RNGProducer::getNullProducer()
 NC::RNGProducer::RNGProducer( shared_obj<RNGStream> rng, SkipOriginal skip_orig )
   : m_impl( std::move(rng) )
 {
+  //For index capable streams, keep a private stream for creating streams by
+  //index (to not depend on the state of streams handed out):
+  if ( !m_impl->m_nextproduct->useInAllThreads() && m_impl->m_nextproduct->isIndexCapable() )
+    m_impl->m_indexsource = m_impl->m_nextproduct->createForIndex( RNGStreamIndex{0} );
+
   //Create jumped state immediately if possible (before anyone consumes
   //numbers from m_nextproduct, thereby modifying the state):
   m_impl->jumpFillNextNextIfAppropriate();
@@ -20,8 +20,52 @@
 
 #include "NCrystal/internal/NCRandUtils.hh"
 #include "NCrystal/internal/NCMath.hh"
+#include "NCrystal/internal/NCString.hh"
+#include "NCrystal/NCSmallVector.hh"
 namespace NC=NCrystal;
 
+namespace NCrystal {
+  namespace {
+    static const bool s_legacyRandSampling = ncgetenv_bool("LEGACY_RNG_SAMPLING");
+
+    inline void rotateDirectionGivenScatterMu( double mu, double cosphi, double sinphi,
+                                               double& ux, double& uy, double& uz )
+    {
+      //Apply the scattering (with the given cos(theta) and azimuthal angle) in an
+      //orthonormal basis constructed from the incoming direction, u. All
+      //calculations are free of branches and loop-carried dependencies, so they
+      //can be vectorised by the compiler when used in loops:
+      nc_assert(ncabs(mu)<=1.);
+      //Normalise incoming direction, u:
+      const double invm = 1.0 / std::sqrt( ux*ux + uy*uy + uz*uz );
+      const double x = ux * invm;
+      const double y = uy * invm;
+      const double z = uz * invm;
+      //Unit vector a perpendicular to u, via cross product of u with the z-axis
+      //(or the x-axis, if u is too close to the z-axis):
+      const bool usez = ncabs(z) < 0.9;
+      double ax = usez ? y : 0.0;
+      double ay = usez ? -x : z;
+      double az = usez ? 0.0 : -y;
+      const double inva = 1.0 / std::sqrt( ax*ax + ay*ay + az*az );
+      ax *= inva;
+      ay *= inva;
+      az *= inva;
+      //Unit vector b = u x a completes the basis:
+      const double bx = y*az - z*ay;
+      const double by = z*ax - x*az;
+      const double bz = x*ay - y*ax;
+      //Final direction:
+      const double s = std::sqrt( ncmax( 0.0, 1.0 - mu*mu ) );
+      const double ka = s * cosphi;
+      const double kb = s * sinphi;
+      ux = mu*x + ka*ax + kb*bx;
+      uy = mu*y + ka*ay + kb*by;
+      uz = mu*z + ka*az + kb*bz;
+    }
+  }
+}
+
 NC::Vector NC::randIsotropicDirection( RNG& rng )
 {
   //Very fast method (Marsaglia 1972) for generating points uniformly on the
@@ -33,9 +77,11 @@ NC::Vector NC::randIsotropicDirection( RNG& rng )
   //Available at https://projecteuclid.org/euclid.aoms/1177692644
 
   double x0,x1,s;
+  double r[2];
   do {
-    x0 = 2.0*rng.generate()-1.0;
-    x1 = 2.0*rng.generate()-1.0;
+    rng.generateMany(2,r);
+    x0 = 2.0*r[0]-1.0;
+    x1 = 2.0*r[1]-1.0;
     s = x0*x0 + x1*x1;
   } while (!s||s>=1);
   double t = 2.0*std::sqrt(1-s);
@@ -76,14 +122,53 @@ NC::Vector NC::randDirectionGivenScatterMu( RNG& rng, double mu, const Vector& i
   return { u.x()+k*xx, u.y()+k*yy, u.z()+k*zz };
 }
 
+bool NC::useLegacyRandSampling()
+{
+  return s_legacyRandSampling;
+}
+
+void NC::randNeutronDirectionsGivenScatterMu( RNG& rng, const double* mu,
+                                              double* ux, double* uy, double* uz,
+                                              std::size_t N )
+{
+  //Rather than using the rejection method to find a random vector perpendicular
+  //to the incoming direction (as in randDirectionGivenScatterMu), we sample a
+  //random azimuthal angle and apply it in an orthonormal basis constructed from
+  //the incoming direction (unless NCRYSTAL_LEGACY_RNG_SAMPLING is set):
+  if ( s_legacyRandSampling ) {
+    for ( std::size_t i = 0; i < N; ++i ) {
+      auto d = randDirectionGivenScatterMu( rng, mu[i], Vector( ux[i], uy[i], uz[i] ) );
+      ux[i] = d.x();
+      uy[i] = d.y();
+      uz[i] = d.z();
+    }
+    return;
+  }
+  constexpr std::size_t nchunk = 128;
+  double cosphi[nchunk];
+  double sinphi[nchunk];
+  for ( std::size_t offset = 0; offset < N; offset += nchunk ) {
+    const std::size_t n = std::min<std::size_t>( nchunk, N - offset );
+    randPointsOnUnitCircle( rng, n, cosphi, sinphi );
+    const double * cmu = mu + offset;
+    double * cx = ux + offset;
+    double * cy = uy + offset;
+    double * cz = uz + offset;
+    for ( std::size_t j = 0; j < n; ++j )
+      rotateDirectionGivenScatterMu( cmu[j], cosphi[j], sinphi[j], cx[j], cy[j], cz[j] );
+  }
+}
+
 NC::PairDD NC::randPointOnUnitCircle( RNG& rng )
 {
   //Sample a random point on the unit circle. This is equivalent to sampling phi
   //randomly in [0,2pi) and letting (x,y)=(cosphi,sinphi).
   double a,b,m2;
+  double r[2];
   do {
-    a = -1.0+rng.generate()*2.0;
-    b = -1.0+rng.generate()*2.0;
+    rng.generateMany(2,r);
+    a = -1.0+r[0]*2.0;
+    b = -1.0+r[1]*2.0;
     m2 = a*a + b*b;
   } while ( !valueInInterval(0.001,1.0,m2) );
 
@@ -91,6 +176,22 @@ NC::PairDD NC::randPointOnUnitCircle( RNG& rng )
   return { a * m, b * m };
 }
 
+void NC::randPointsOnUnitCircle( RNG& rng, std::size_t N, double* cosphi, double* sinphi )
+{
+  //Sample phi directly (rather than using the rejection method of
+  //randPointOnUnitCircle, unless NCRYSTAL_LEGACY_RNG_SAMPLING is set), using
+  //sinphi as temporary storage:
+  if ( s_legacyRandSampling ) {
+    for ( std::size_t i = 0; i < N; ++i )
+      std::tie(cosphi[i],sinphi[i]) = randPointOnUnitCircle( rng );
+    return;
+  }
+  rng.generateMany( N, sinphi );
+  for ( std::size_t i = 0; i < N; ++i )
+    sinphi[i] = k2Pi * sinphi[i];
+  sincos_many( Span<const double>( sinphi, sinphi + N ), cosphi, sinphi );
+}
+
 double NC::randNorm( NC::RNG& rng )
 {
   //sample a single value from a unit normal distribution via the ratio method.
@@ -102,11 +203,13 @@ double NC::randNorm( NC::RNG& rng )
   //0.167 times per call (hence the speedup).
 
   double g, g2(0),u,v,invu;
+  double r[2];
   do {
-    u = rng.generate();
+    rng.generateMany(2,r);
+    u = r[0];
     nc_assert(u);
     invu = 1.0/u;
-    v = rng.generate();
+    v = r[1];
     g = 1.71552776992141354 * (v-0.5)*invu;
     g2 = g*g;
     if ( g2 <= 5.0 - 5.13610166675096558 * u )
@@ -124,9 +227,11 @@ void NC::randNorm( NC::RNG& rng, double&g1, double&g2)
   //The loop runs on average 4/pi ~= 1.27 times.
 
   double t;
+  double r[2];
   do {
-    g1 = 2.0 * rng.generate() - 1.0;
-    g2 = 2.0 * rng.generate() - 1.0;
+    rng.generateMany(2,r);
+    g1 = 2.0 * r[0] - 1.0;
+    g2 = 2.0 * r[1] - 1.0;
     t = g1 * g1 + g2 * g2;
   } while ( t >= 1.0 || !t );
   t = std::sqrt( (-2.0 * std::log( t ) ) / t );
@@ -202,6 +307,95 @@ std::size_t NC::pickRandIdxByWeight( RNG& rng, Span<const double> commulvals)
   return std::min<std::size_t>((std::size_t)(it-itB),n-1);
 }
 
+NC::RandAliasSampler::RandAliasSampler( Span<const double> weights )
+{
+  const std::size_t n = weights.size();
+  if ( !n || n >= std::numeric_limits<uint32_t>::max() )
+    NCRYSTAL_THROW(BadInput,"RandAliasSampler: invalid number of weights");
+  StableSum sum;
+  std::size_t imax = 0;
+  for ( std::size_t i = 0; i < n; ++i ) {
+    const double w = weights[i];
+    if ( !(w>=0.0) || ncisinf(w) )
+      NCRYSTAL_THROW(BadInput,"RandAliasSampler: weights must be finite and non-negative");
+    sum.add(w);
+    if ( w > weights[imax] )
+      imax = i;
+  }
+  const double wsum = sum.sum();
+  if ( !(wsum>0.0) )
+    NCRYSTAL_THROW(BadInput,"RandAliasSampler: weights sum to zero");
+
+  //Scale weights so the average is 1, and split into the entries below
+  //(small) and above (large) 1:
+  m_prob.resize(n);
+  m_alias.resize(n);
+  const double scale = n / wsum;
+  std::vector<uint32_t> small, large;
+  for ( std::size_t i = 0; i < n; ++i ) {
+    m_prob[i] = weights[i] * scale;
+    m_alias[i] = static_cast<uint32_t>(i);
+    ( m_prob[i] < 1.0 ? small : large ).push_back( static_cast<uint32_t>(i) );
+  }
+  //Let each small entry be topped up by a large entry:
+  while ( !small.empty() && !large.empty() ) {
+    const uint32_t is = small.back();
+    small.pop_back();
+    const uint32_t il = large.back();
+    m_alias[is] = il;
+    m_prob[il] -= ( 1.0 - m_prob[is] );
+    if ( m_prob[il] < 1.0 ) {
+      large.pop_back();
+      small.push_back( il );
+    }
+  }
+  //Any leftovers are due to numerical round-off and are (apart from entries
+  //with vanishing weights) equal to 1 within precision:
+  for ( auto i : large )
+    m_prob[i] = 1.0;
+  for ( auto i : small ) {
+    if ( weights[i] > 0.0 ) {
+      m_prob[i] = 1.0;
+    } else {
+      m_prob[i] = 0.0;
+      m_alias[i] = static_cast<uint32_t>(imax);
+    }
+  }
+}
+
+std::size_t NC::CachedRandIdxPicker::buildAndPick( RNG& rng, Span<const double> commulvals )
+{
+  //Only worth it for more than a few weights (pickRandIdxByWeight uses a
+  //linear search for those):
+  constexpr std::ptrdiff_t nweights_min = 8;
+  nc_assert( m_npicks == s_npicks_before_build );
+  if ( commulvals.size() < nweights_min || !( commulvals.back() > 0.0 ) || s_legacyRandSampling )
+    return pickRandIdxByWeight( rng, commulvals );
+  SmallVector<double,64> weights;
+  weights.reserve_hint( commulvals.size() );
+  double prev = 0.0;
+  for ( auto c : commulvals ) {
+    weights.push_back( ncmax( 0.0, c - prev ) );
+    prev = c;
+  }
+  m_sampler = RandAliasSampler( weights );
+  ++m_npicks;
+  return m_sampler.sample(rng);
+}
+
+NC::RandAliasSampler NC::RandAliasSampler::createFromInternalData( VectD&& probs, std::vector<uint32_t>&& aliases )
+{
+  if ( probs.empty() || probs.size() != aliases.size() )
+    NCRYSTAL_THROW(BadInput,"RandAliasSampler: inconsistent internal data");
+  for ( auto a : aliases )
+    if ( a >= aliases.size() )
+      NCRYSTAL_THROW(BadInput,"RandAliasSampler: inconsistent internal data");
+  RandAliasSampler res;
+  res.m_prob = std::move(probs);
+  res.m_alias = std::move(aliases);
+  return res;
+}
+
 double NC::randExpDivSqrt( RNG& rng, double c, double a, double b )
 {
   //Sample f(x) = exp(-c*x)/sqrt(x) on [a,b], a>=0 b>a, c>0:
@@ -529,6 +723,67 @@ void NC::RandXRSRImpl::jump()
   m_s[1] = s1;
 }
 
+namespace NCrystal {
+  namespace {
+    //The state transitions of xoroshiro128+ are linear over GF(2), so jumping
+    //can be represented by a 128x128 bit matrix, J. In order to jump n times
+    //in O(log(n)), we precalculate the matrices for J^(2^k), k=0..63:
+    struct XRSRJumpTable {
+      using state_t = RandXRSRImpl::state_t;
+      //Matrices are stored as the images of the 128 unit vectors:
+      using Matrix = std::array<state_t,128>;
+      std::array<Matrix,64> jumpPow2;
+
+      static state_t apply( const Matrix& m, const state_t& v )
+      {
+        state_t res = { 0, 0 };
+        for ( unsigned i = 0; i < 128; ++i ) {
+          //Branch-free, since the bits are random:
+          const uint64_t mask = uint64_t(0) - ( (v[i/64]>>(i%64)) & 1 );
+          res[0] ^= m[i][0] & mask;
+          res[1] ^= m[i][1] & mask;
+        }
+        return res;
+      }
+
+      XRSRJumpTable()
+      {
+        for ( unsigned i = 0; i < 128; ++i ) {
+          state_t unitvect = { 0, 0 };
+          unitvect[i/64] = uint64_t(1) << (i%64);
+          RandXRSRImpl r( unitvect );
+          r.jump();
+          jumpPow2[0][i] = r.state();
+        }
+        for ( unsigned k = 1; k < 64; ++k )
+          for ( unsigned i = 0; i < 128; ++i )
+            jumpPow2[k][i] = apply( jumpPow2[k-1], jumpPow2[k-1][i] );
+      }
+    };
+  }
+}
+
+void NC::RandXRSRImpl::jump( uint64_t n )
+{
+  if ( n < 8 ) {
+    while ( n-- )
+      jump();
+    return;
+  }
+  static const XRSRJumpTable s_table;
+  for ( unsigned k = 0; n; ++k, n >>= 1 )
+    if ( n & 1 )
+      m_s = XRSRJumpTable::apply( s_table.jumpPow2[k], m_s );
+}
+
+void NC::RandXRSRImpl::longJump()
+{
+  //NB: The LONG_JUMP polynomial published along with the reference
+  //implementation is for newer parameters of xoroshiro128+, so simply use the
+  //jump table:
+  jump( uint64_t(1) << 32 );
+}
+
 uint64_t NC::RandXRSRImpl::splitmix64(uint64_t& x)
 {
   uint64_t z = (x += 0x9e3779b97f4a7c15);
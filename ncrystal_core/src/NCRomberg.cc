@@ -30,12 +30,18 @@ void NCrystal::Romberg::evalFuncMany(double* fvals, unsigned n, double offset, d
     *(it++) = evalFunc( offset + delta * i );
 }
 
+constexpr unsigned NCrystal::Romberg::maxBatchSize;
+
 double NCrystal::Romberg::evalFuncManySum(unsigned n, double offset, double delta) const
 {
+  double fvals[maxBatchSize];
   double sum = 0.0;
-  double nn = n;//only cast once
-  for ( double i = 0; i < nn; ++i )
-    sum += evalFunc( offset + delta * i );
+  for ( unsigned ibegin = 0; ibegin < n; ibegin += maxBatchSize ) {
+    const unsigned nbatch = ncmin( maxBatchSize, n - ibegin );
+    evalFuncMany( &fvals[0], nbatch, offset + delta * ibegin, delta );
+    for ( unsigned i = 0; i < nbatch; ++i )
+      sum += fvals[i];
+  }
   return sum;
 }
 
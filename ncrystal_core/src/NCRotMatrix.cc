@@ -69,6 +69,23 @@ double NCrystal::RotMatrix::determinant() const
   return m[0]*(m[4]*m[8]-m[5]*m[7]) + m[1]*(m[5]*m[6]-m[3]*m[8]) + m[2]*(m[3]*m[7]-m[4]*m[6]);
 }
 
+void NCrystal::RotMatrix::rotateMany( const double* x, const double* y, const double* z,
+                                     double* out_x, double* out_y, double* out_z,
+                                     std::size_t N ) const
+{
+  nc_assert( m_colcount==3 && m_rowcount==3 );
+  //Copy matrix elements to locals, so the compiler knows they are not modified
+  //by the writes (allowing the loop to be vectorised):
+  const double * d = &m_data[0];
+  const double d0(d[0]), d1(d[1]), d2(d[2]), d3(d[3]), d4(d[4]), d5(d[5]), d6(d[6]), d7(d[7]), d8(d[8]);
+  for ( std::size_t i = 0; i < N; ++i ) {
+    const double vx = x[i], vy = y[i], vz = z[i];
+    out_x[i] = d0*vx + d1*vy + d2*vz;
+    out_y[i] = d3*vx + d4*vy + d5*vz;
+    out_z[i] = d6*vx + d7*vy + d8*vz;
+  }
+}
+
 void NCrystal::rotateToFrame( double sinab, double cosab, const Vector& a, const Vector& b, Vector&v, RNG * rng )
 {
   nc_assert(v.isUnitVector(1e-3));
@@ -65,3 +65,8 @@ NC::VDOSData::VDOSData( PairDD egrid,
   nc_assert( m_d.size()>=2 );
   nc_assert( *std::min_element(m_d.begin(),m_d.end())>=0.0);
 }
+
+void NC::SABData::accountMemory( MemoryFootprint& mf ) const
+{
+  mf.add( sizeof(SABData) + ( m_a.size() + m_b.size() + m_sab.size() ) * sizeof(double) );
+}
@@ -0,0 +1,968 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+//  This file is part of NCrystal (see https://mctools.github.io/ncrystal/)   //
+//                                                                            //
+//  Copyright 2015-2021 NCrystal developers                                   //
+//                                                                            //
+//  Licensed under the Apache License, Version 2.0 (the "License");           //
+//  you may not use this file except in compliance with the License.          //
+//  You may obtain a copy of the License at                                   //
+//                                                                            //
+//      http://www.apache.org/licenses/LICENSE-2.0                            //
+//                                                                            //
+//  Unless required by applicable law or agreed to in writing, software       //
+//  distributed under the License is distributed on an "AS IS" BASIS,         //
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  //
+//  See the License for the specific language governing permissions and       //
+//  limitations under the License.                                            //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include "NCrystal/internal/NCSABDiskCache.hh"
+#include "NCrystal/internal/NCFileUtils.hh"
+#include "NCrystal/internal/NCString.hh"
+#include "NCrystal/NCVersion.hh"
+#include <fstream>
+#include <functional>
+#include <atomic>
+#include <sstream>
+#include <set>
+#include <type_traits>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <iomanip>
+#ifndef NCRYSTAL_DISABLE_THREADS
+#  include <thread>
+#endif
+
+namespace NC = NCrystal;
+namespace NS = NCrystal::SAB;
+
+namespace NCrystal {
+  namespace SAB {
+    namespace {
+
+      //Increase whenever the file layout changes:
+      constexpr uint32_t diskcache_format_version = 1;
+      constexpr char diskcache_magic[8] = { 'N','C','S','A','B','C','A','C' };
+      constexpr uint32_t diskcache_endian_marker = 0x01020304;
+
+      enum class SamplerTag : uint8_t { NoScatter = 0, Alg1 = 1, Alias = 2 };
+
+      using AlphaSampleInfo = SABSamplerAtE_Alg1::AlphaSampleInfo;
+      using CommonCache = SABSamplerAtE_Alg1::CommonCache;
+
+      class ContentHash {
+        //Simple 64 bit hash, which (unlike std::hash) is guaranteed to be
+        //stable between processes and builds. Large arrays are processed one
+        //64 bit word at a time (FNV-1a style, with an extra final mixing), so
+        //hashing even large S(alpha,beta) tables is cheap:
+      public:
+        void addWord( uint64_t w )
+        {
+          m_h ^= w;
+          m_h *= 1099511628211ull;
+          m_h ^= ( m_h >> 29 );
+        }
+        template<class T>
+        void add( const T& t )
+        {
+          static_assert(std::is_trivially_copyable<T>::value,"");
+          static_assert(sizeof(T)<=sizeof(uint64_t),"");
+          uint64_t w(0);
+          std::memcpy( &w, &t, sizeof(T) );
+          addWord( w );
+        }
+        void add( const VectD& v )
+        {
+          static_assert(sizeof(double)==sizeof(uint64_t),"");
+          addWord( static_cast<uint64_t>(v.size()) );
+          for ( auto e : v ) {
+            uint64_t w;
+            std::memcpy( &w, &e, sizeof(w) );
+            addWord( w );
+          }
+        }
+        void addBytes( const char * begin, const char * end )
+        {
+          nc_assert( begin <= end );
+          const std::size_t n = static_cast<std::size_t>( end - begin );
+          addWord( static_cast<uint64_t>(n) );
+          const char * itE = begin + ( n - n % sizeof(uint64_t) );
+          for ( const char * it = begin; it != itE; it += sizeof(uint64_t) ) {
+            uint64_t w;
+            std::memcpy( &w, it, sizeof(w) );
+            addWord( w );
+          }
+          if ( itE != end ) {
+            uint64_t w(0);
+            std::memcpy( &w, itE, static_cast<std::size_t>( end - itE ) );
+            addWord( w );
+          }
+        }
+        uint64_t value() const
+        {
+          uint64_t h = m_h;
+          h ^= ( h >> 33 );
+          h *= 0xff51afd7ed558ccdull;
+          h ^= ( h >> 33 );
+          return h;
+        }
+      private:
+        uint64_t m_h = 14695981039346656037ull;
+      };
+
+      class Writer {
+      public:
+        template<class T>
+        void put( const T& t )
+        {
+          static_assert(std::is_trivially_copyable<T>::value,"");
+          m_buf.append( reinterpret_cast<const char*>(&t), sizeof(T) );
+        }
+        template<class T>
+        void putVect( const std::vector<T>& v )
+        {
+          put( static_cast<uint64_t>(v.size()) );
+          if ( !v.empty() )
+            m_buf.append( reinterpret_cast<const char*>(&v[0]), v.size()*sizeof(T) );
+        }
+        void putInfos( const std::vector<AlphaSampleInfo>& v )
+        {
+          put( static_cast<uint64_t>(v.size()) );
+          for ( auto& e : v ) {
+            for ( auto pt : { &e.pt_front, &e.pt_back } ) {
+              put( pt->alpha );
+              put( pt->sval );
+              put( pt->logsval );
+              put( static_cast<uint32_t>(pt->alpha_idx) );
+            }
+            put( e.prob_front );
+            put( e.prob_notback );
+          }
+        }
+        const std::string& buffer() const { return m_buf; }
+      private:
+        std::string m_buf;
+      };
+
+      struct ReadError {};
+
+      class Reader {
+        //Reads from buffer, throwing ReadError if running out of data:
+      public:
+        Reader( Span<const char> buf ) : m_buf(buf) {}
+        void getBytes( void* dest, std::size_t n )
+        {
+          if ( n > static_cast<std::size_t>(m_buf.size()) - m_pos )
+            throw ReadError();
+          if ( n )
+            std::memcpy( dest, m_buf.data() + m_pos, n );
+          m_pos += n;
+        }
+        template<class T>
+        T get()
+        {
+          static_assert(std::is_trivially_copyable<T>::value,"");
+          T t;
+          getBytes( &t, sizeof(T) );
+          return t;
+        }
+        template<class T>
+        std::vector<T> getVect()
+        {
+          const uint64_t n = get<uint64_t>();
+          if ( n > ( static_cast<std::size_t>(m_buf.size()) - m_pos ) / sizeof(T) )
+            throw ReadError();
+          std::vector<T> v( static_cast<std::size_t>(n) );
+          if ( n )
+            getBytes( &v[0], v.size()*sizeof(T) );
+          return v;
+        }
+        std::vector<AlphaSampleInfo> getInfos()
+        {
+          const uint64_t n = get<uint64_t>();
+          constexpr std::size_t bytes_per_info = 2*(3*sizeof(double)+sizeof(uint32_t))+2*sizeof(double);
+          if ( n > ( static_cast<std::size_t>(m_buf.size()) - m_pos ) / bytes_per_info )
+            throw ReadError();
+          std::vector<AlphaSampleInfo> v( static_cast<std::size_t>(n) );
+          for ( auto& e : v ) {
+            for ( auto pt : { &e.pt_front, &e.pt_back } ) {
+              pt->alpha = get<double>();
+              pt->sval = get<double>();
+              pt->logsval = get<double>();
+              pt->alpha_idx = get<uint32_t>();
+            }
+            e.prob_front = get<double>();
+            e.prob_notback = get<double>();
+          }
+          return v;
+        }
+        bool atEnd() const { return m_pos == static_cast<std::size_t>(m_buf.size()); }
+      private:
+        Span<const char> m_buf;
+        std::size_t m_pos = 0;
+      };
+
+      void writeHeader( Writer& w )
+      {
+        for ( auto c : diskcache_magic )
+          w.put( c );
+        w.put( diskcache_format_version );
+        w.put( diskcache_endian_marker );
+        w.put( static_cast<uint32_t>(NCRYSTAL_VERSION) );
+      }
+
+      bool checkHeader( Reader& r )
+      {
+        for ( auto c : diskcache_magic )
+          if ( r.get<char>() != c )
+            return false;
+        return ( r.get<uint32_t>() == diskcache_format_version
+                 && r.get<uint32_t>() == diskcache_endian_marker
+                 && r.get<uint32_t>() == static_cast<uint32_t>(NCRYSTAL_VERSION) );
+      }
+
+      void warnOnce( const std::string& msg )
+      {
+        static std::atomic<bool> s_warned(false);
+        if ( !s_warned.exchange(true) )
+          std::cout<<"NCrystal WARNING: "<<msg<<" (further SAB disk cache warnings will be suppressed)."<<std::endl;
+      }
+
+      std::string uniqueTmpSuffix()
+      {
+        ContentHash h;
+        h.add( std::chrono::steady_clock::now().time_since_epoch().count() );
+        h.add( std::chrono::system_clock::now().time_since_epoch().count() );
+#ifndef NCRYSTAL_DISABLE_THREADS
+        h.add( std::hash<std::thread::id>()( std::this_thread::get_id() ) );
+#endif
+        static std::atomic<uint64_t> s_counter(0);
+        h.add( ++s_counter );
+        std::ostringstream ss;
+        ss << ".tmp" << std::hex << h.value();
+        return ss.str();
+      }
+
+      bool writeFileAtomically( const std::string& path,
+                                const std::function<void(std::ostream&)>& writeContent )
+      {
+        //Write to temporary file, then rename to final path (atomic on POSIX
+        //systems, so concurrent readers never see incomplete files):
+        const std::string tmppath = path + uniqueTmpSuffix();
+        bool ok;
+        {
+          std::ofstream fh( tmppath, std::ios_base::binary | std::ios_base::trunc );
+          ok = fh.good();
+          if ( ok ) {
+            writeContent( fh );
+            fh.close();
+            ok = !fh.fail();
+          }
+        }
+        if ( ok )
+          ok = ( std::rename( tmppath.c_str(), path.c_str() ) == 0 );
+        if ( !ok )
+          std::remove( tmppath.c_str() );
+        return ok;
+      }
+
+      const std::string& cacheDir()
+      {
+        static const std::string s_dir = ncgetenv("SAB_CACHEDIR");
+        return s_dir;
+      }
+
+      void addToHash( ContentHash& h, const SABData& data )
+      {
+        h.add( diskcache_format_version );
+        h.add( static_cast<uint32_t>(NCRYSTAL_VERSION) );
+        h.add( data.alphaGrid() );
+        h.add( data.betaGrid() );
+        h.add( data.sab() );
+        h.add( data.temperature().dbl() );
+        h.add( data.boundXS().dbl() );
+        h.add( data.elementMassAMU().dbl() );
+        h.add( data.suggestedEmax() );
+      }
+
+      std::string cacheKey( const char * prefix, uint64_t hashval )
+      {
+        //Keys are the file names used inside the cache directory:
+        std::ostringstream ss;
+        ss << prefix << std::hex << std::setw(16) << std::setfill('0') << hashval << ".bin";
+        return ss.str();
+      }
+
+      struct BlobRef {
+        Span<const char> data;
+        std::shared_ptr<const void> keepAlive;
+      };
+
+      std::shared_ptr<const std::string> readFileToBuffer( const std::string& path )
+      {
+        std::ifstream fh( path, std::ios_base::binary | std::ios_base::ate );
+        if ( !fh.good() )
+          return nullptr;
+        const auto fsize = fh.tellg();
+        if ( !( fsize > 0 ) )
+          return nullptr;
+        auto buf = std::make_shared<std::string>();
+        buf->resize( static_cast<std::size_t>(fsize) );
+        fh.seekg( 0 );
+        if ( !fh.read( &(*buf)[0], fsize ) )
+          return nullptr;
+        return buf;
+      }
+
+      class SnapshotStore {
+        //Entries from loaded snapshot files (which take precedence over the
+        //cache directory), and entries recorded for a snapshot being prepared:
+      public:
+        bool active() const { return m_active; }
+        bool recording()
+        {
+          if ( !m_active )
+            return false;
+          NCRYSTAL_LOCK_GUARD(m_mutex);
+          return m_recording;
+        }
+
+        Optional<BlobRef> find( const std::string& key )
+        {
+          if ( !m_active )
+            return NullOpt;
+          NCRYSTAL_LOCK_GUARD(m_mutex);
+          auto it = m_loaded.find( key );
+          if ( it == m_loaded.end() )
+            return NullOpt;
+          return it->second;
+        }
+
+        void record( const std::string& key, Span<const char> data )
+        {
+          if ( !m_active )
+            return;
+          NCRYSTAL_LOCK_GUARD(m_mutex);
+          if ( m_recording && !m_recorded.count(key) )
+            m_recorded[key] = std::string( data.begin(), data.end() );
+        }
+
+        void beginRecording()
+        {
+          NCRYSTAL_LOCK_GUARD(m_mutex);
+          if ( m_recording )
+            NCRYSTAL_THROW(LogicError,"Snapshot recording already in progress");
+          m_recording = true;
+          m_recorded.clear();
+          updateActive();
+        }
+
+        std::map<std::string,std::string> endRecording()
+        {
+          NCRYSTAL_LOCK_GUARD(m_mutex);
+          m_recording = false;
+          updateActive();
+          std::map<std::string,std::string> res;
+          std::swap( res, m_recorded );
+          return res;
+        }
+
+        void addLoaded( std::map<std::string,BlobRef>&& entries )
+        {
+          NCRYSTAL_LOCK_GUARD(m_mutex);
+          for ( auto& e : entries ) {
+            m_loadedPrefixes.insert( e.first.substr( 0, e.first.rfind('_') + 1 ) );
+            m_loaded[e.first] = std::move(e.second);
+          }
+          updateActive();
+        }
+
+        //Whether entries with keys starting with the given prefix (up to and
+        //including the last underscore) might be found or recorded. This
+        //allows callers to skip calculation of expensive keys:
+        bool mightUse( const char * prefix )
+        {
+          if ( !m_active )
+            return false;
+          NCRYSTAL_LOCK_GUARD(m_mutex);
+          return m_recording || m_loadedPrefixes.count( prefix );
+        }
+
+      private:
+        void updateActive() { m_active = ( m_recording || !m_loaded.empty() ); }
+        std::mutex m_mutex;
+        std::atomic<bool> m_active{false};
+        bool m_recording = false;
+        std::map<std::string,BlobRef> m_loaded;
+        std::set<std::string> m_loadedPrefixes;
+        std::map<std::string,std::string> m_recorded;
+      };
+
+      SnapshotStore& snapshotStore()
+      {
+        static SnapshotStore s_store;
+        return s_store;
+      }
+
+      bool cacheActive( const char * keyprefix )
+      {
+        return !cacheDir().empty() || snapshotStore().mightUse( keyprefix );
+      }
+
+      bool storesWanted()
+      {
+        //Entries can be found via loaded snapshots without being stored anywhere:
+        return !cacheDir().empty() || snapshotStore().recording();
+      }
+
+      Optional<BlobRef> findBlob( const std::string& key )
+      {
+        //Look in snapshots first, then in the cache directory (recording any
+        //hits for snapshots being prepared):
+        Optional<BlobRef> res = snapshotStore().find( key );
+        if ( !res.has_value() && !cacheDir().empty() ) {
+          auto buf = readFileToBuffer( path_join( cacheDir(), key ) );
+          if ( buf )
+            res = BlobRef{ Span<const char>( buf->data(), buf->data() + buf->size() ), buf };
+        }
+        if ( res.has_value() )
+          snapshotStore().record( key, res.value().data );
+        return res;
+      }
+
+      void storeBlob( const std::string& key, const std::string& buf )
+      {
+        snapshotStore().record( key, Span<const char>( buf.data(), buf.data() + buf.size() ) );
+        if ( cacheDir().empty() )
+          return;
+        const std::string path = path_join( cacheDir(), key );
+        if ( !writeFileAtomically( path, [&buf](std::ostream& os)
+                                   { os.write( buf.data(), static_cast<std::streamsize>(buf.size()) ); } ) )
+          warnOnce("Could not write SAB disk cache file "+path);
+      }
+
+    }
+  }
+}
+
+std::string NS::diskCacheKey( const SABData& data, const VectD& egrid_input, SamplerAtEType samplerType,
+                              bool singlePrecisionTables )
+{
+  if ( !cacheActive( "ncrystal_sab_" ) )
+    return std::string();
+  ContentHash h;
+  addToHash( h, data );
+  h.add( static_cast<uint32_t>( singlePrecisionTables ? 1 : 0 ) );
+  h.add( static_cast<uint32_t>( samplerType == SamplerAtEType::AliasTable ? 1 : 0 ) );
+  h.add( egrid_input );
+  return cacheKey( "ncrystal_sab_", h.value() );
+}
+
+bool NS::loadFromDiskCache( const std::string& key,
+                            std::shared_ptr<const CommonCache> common,
+                            VectD& out_egrid,
+                            VectD& out_xsvals,
+                            std::vector<std::unique_ptr<SABSamplerAtE>>& out_samplers )
+{
+  nc_assert_always( !!common );
+  auto blob = findBlob( key );
+  if ( !blob.has_value() )
+    return false;//not in cache
+
+  try {
+    Reader r( blob.value().data );
+    if ( !checkHeader( r ) ) {
+      warnOnce("Ignoring incompatible SAB disk cache entry "+key);
+      return false;
+    }
+    VectD egrid = r.getVect<double>();
+    VectD xsvals = r.getVect<double>();
+    const uint64_t nsamplers = r.get<uint64_t>();
+    if ( egrid.size() < 2 || xsvals.size() != egrid.size() || nsamplers != egrid.size() )
+      throw ReadError();
+    std::vector<std::unique_ptr<SABSamplerAtE>> samplers;
+    samplers.reserve( egrid.size() );
+    for ( uint64_t i = 0; i < nsamplers; ++i ) {
+      const auto tag = r.get<uint8_t>();
+      if ( tag == static_cast<uint8_t>(SamplerTag::NoScatter) ) {
+        samplers.emplace_back( std::make_unique<SABSamplerAtE_NoScatter>() );
+      } else if ( tag == static_cast<uint8_t>(SamplerTag::Alg1) ) {
+        const auto ibetaOffset = r.get<uint64_t>();
+        auto x = r.getVect<double>();
+        auto y = r.getVect<double>();
+        auto cdf = r.getVect<double>();
+        const double iw = r.get<double>();
+        auto infos = r.getInfos();
+        if ( x.size() < 2 || infos.size() + 1 != x.size()
+             || ibetaOffset + x.size() != common->data->betaGrid().size() + 1 )
+          throw ReadError();
+        samplers.emplace_back( std::make_unique<SABSamplerAtE_Alg1>( common,
+                                                                     PointwiseDist::createFromInternalData( std::move(x),
+                                                                                                            std::move(y),
+                                                                                                            std::move(cdf),
+                                                                                                            iw ),
+                                                                     std::move(infos),
+                                                                     static_cast<std::size_t>(ibetaOffset) ) );
+      } else if ( tag == static_cast<uint8_t>(SamplerTag::Alias) ) {
+        const double eiDivKT = r.get<double>();
+        const auto ibetaOffset = r.get<uint64_t>();
+        auto betaVals = r.getVect<double>();
+        auto probs = r.getVect<double>();
+        auto aliases = r.getVect<uint32_t>();
+        auto infos = r.getInfos();
+        if ( betaVals.size() < 2 || infos.size() + 1 != betaVals.size()
+             || probs.size() != 2 * ( betaVals.size() - 1 )
+             || ibetaOffset + betaVals.size() != common->data->betaGrid().size() + 1 )
+          throw ReadError();
+        samplers.emplace_back( std::make_unique<SABSamplerAtE_Alias>( common, eiDivKT, std::move(betaVals),
+                                                                      RandAliasSampler::createFromInternalData( std::move(probs),
+                                                                                                                std::move(aliases) ),
+                                                                      std::move(infos),
+                                                                      static_cast<std::size_t>(ibetaOffset) ) );
+      } else {
+        throw ReadError();
+      }
+    }
+    if ( !r.atEnd() )
+      throw ReadError();
+    out_egrid = std::move(egrid);
+    out_xsvals = std::move(xsvals);
+    out_samplers = std::move(samplers);
+    return true;
+  } catch ( ReadError& ) {
+    warnOnce("Ignoring corrupted SAB disk cache entry "+key);
+  } catch ( std::exception& e ) {
+    warnOnce("Ignoring SAB disk cache entry "+key+" which could not be loaded ("+e.what()+")");
+  }
+  return false;
+}
+
+void NS::saveToDiskCache( const std::string& key,
+                          const VectD& egrid,
+                          const VectD& xsvals,
+                          const std::vector<std::unique_ptr<SABSamplerAtE>>& samplers )
+{
+  if ( !storesWanted() )
+    return;
+  nc_assert_always( egrid.size() == xsvals.size() && egrid.size() == samplers.size() );
+  Writer w;
+  writeHeader( w );
+  w.putVect( egrid );
+  w.putVect( xsvals );
+  w.put( static_cast<uint64_t>(samplers.size()) );
+  for ( auto& sptr : samplers ) {
+    nc_assert_always( !!sptr );
+    if ( dynamic_cast<const SABSamplerAtE_NoScatter*>( sptr.get() ) ) {
+      w.put( static_cast<uint8_t>(SamplerTag::NoScatter) );
+    } else if ( auto s1 = dynamic_cast<const SABSamplerAtE_Alg1*>( sptr.get() ) ) {
+      w.put( static_cast<uint8_t>(SamplerTag::Alg1) );
+      w.put( static_cast<uint64_t>(s1->ibetaOffset()) );
+      w.putVect( s1->betaSampler().getXVals() );
+      w.putVect( s1->betaSampler().getYVals() );
+      w.putVect( s1->betaSampler().getCDFVals() );
+      w.put( s1->betaSampler().getIntegralWeight() );
+      w.putInfos( s1->alphaSampleInfos() );
+    } else if ( auto s2 = dynamic_cast<const SABSamplerAtE_Alias*>( sptr.get() ) ) {
+      w.put( static_cast<uint8_t>(SamplerTag::Alias) );
+      w.put( s2->eiDivKT() );
+      w.put( static_cast<uint64_t>(s2->ibetaOffset()) );
+      w.putVect( s2->betaVals() );
+      w.putVect( s2->componentSampler().internalProbs() );
+      w.putVect( s2->componentSampler().internalAliases() );
+      w.putInfos( s2->alphaSampleInfos() );
+    } else {
+      NCRYSTAL_THROW(LogicError,"saveToDiskCache: unsupported SABSamplerAtE type");
+    }
+  }
+
+  storeBlob( key, w.buffer() );
+}
+
+std::shared_ptr<const NS::SABSamplerAtE_Alg1::CommonCache>
+NS::mapSharedCommonCache( std::shared_ptr<const CommonCache> common )
+{
+  nc_assert_always( !!common && !!common->data );
+  if ( !cacheActive( "ncrystal_sabtables_" ) )
+    return common;
+  const SABData& data = *common->data;
+  const bool sp = common->isSinglePrecision();
+  const std::size_t elemsize = ( sp ? sizeof(float) : sizeof(double) );
+  ContentHash h;
+  addToHash( h, data );
+  h.add( static_cast<uint32_t>(elemsize) );
+  const std::string key = cacheKey( "ncrystal_sabtables_", h.value() );
+  const uint64_t n = data.sab().size();
+  const void * tbl_logsab = ( sp ? static_cast<const void*>( common->logsab_f32.data() )
+                              : static_cast<const void*>( common->logsab.data() ) );
+  const void * tbl_cumul = ( sp ? static_cast<const void*>( common->alphaintegrals_cumul_f32.data() )
+                             : static_cast<const void*>( common->alphaintegrals_cumul.data() ) );
+  nc_assert_always( static_cast<uint64_t>( sp ? common->logsab_f32.size() : common->logsab.size() ) == n
+                    && static_cast<uint64_t>( sp ? common->alphaintegrals_cumul_f32.size()
+                                              : common->alphaintegrals_cumul.size() ) == n );
+
+  //Layout: 32 byte header followed by the two tables (the header size keeps
+  //the tables properly aligned, since mapped memory is page aligned):
+  Writer hw;
+  writeHeader( hw );
+  hw.put( static_cast<uint32_t>(elemsize) );
+  hw.put( n );
+  const std::string header = hw.buffer();
+  nc_assert_always( header.size() == 32 );
+  const std::size_t tblbytes = static_cast<std::size_t>( n ) * elemsize;
+  const std::size_t expected_size = header.size() + 2 * tblbytes;
+
+  auto isUsable = [&header,expected_size]( Span<const char> d )
+  {
+    return ( static_cast<std::size_t>(d.size()) == expected_size
+             && std::memcmp( d.data(), header.data(), header.size() ) == 0 );
+  };
+
+  //Snapshots take precedence (note that in case of a memory mapped snapshot
+  //file, the tables are used directly from the mapped memory):
+  Optional<BlobRef> blob = snapshotStore().find( key );
+  if ( blob.has_value() && !isUsable( blob.value().data ) )
+    blob = NullOpt;
+
+  if ( !blob.has_value() && !cacheDir().empty() ) {
+    const std::string path = path_join( cacheDir(), key );
+    auto tryMap = [&path,&isUsable]() -> std::shared_ptr<const MappedFile>
+    {
+      auto mf = MappedFile::mapFile( path );
+      return ( mf && isUsable( mf->data() ) ) ? mf : nullptr;
+    };
+    auto mf = tryMap();
+    if ( !mf ) {
+      //Not present (or unusable), (re)create it:
+      auto writeTables = [&header,tbl_logsab,tbl_cumul,tblbytes](std::ostream& os)
+      {
+        os.write( header.data(), static_cast<std::streamsize>(header.size()) );
+        for ( auto tbl : { tbl_logsab, tbl_cumul } )
+          os.write( static_cast<const char*>( tbl ), static_cast<std::streamsize>( tblbytes ) );
+      };
+      if ( !writeFileAtomically( path, writeTables ) )
+        warnOnce("Could not write SAB disk cache file "+path);
+      else if ( !( mf = tryMap() ) )
+        warnOnce("Could not memory map SAB disk cache file "+path);
+    }
+    if ( mf )
+      blob = BlobRef{ mf->data(), mf };
+  }
+
+  if ( !blob.has_value() ) {
+    //Only recording a snapshot, or the cache directory could not be used:
+    if ( snapshotStore().recording() ) {
+      std::string buf = header;
+      for ( auto tbl : { tbl_logsab, tbl_cumul } )
+        buf.append( static_cast<const char*>( tbl ), tblbytes );
+      snapshotStore().record( key, Span<const char>( buf.data(), buf.data() + buf.size() ) );
+    }
+    return common;
+  }
+
+  snapshotStore().record( key, blob.value().data );
+  auto storage = std::move(blob.value().keepAlive);
+  const char * tables = blob.value().data.data() + header.size();
+  const std::size_t nn = static_cast<std::size_t>(n);
+  if ( sp ) {
+    auto t = reinterpret_cast<const float*>( tables );
+    return std::make_shared<const CommonCache>( CommonCache{ common->data, {}, {},
+                                                             Span<const float>( t, t + nn ),
+                                                             Span<const float>( t + nn, t + 2*nn ),
+                                                             std::move(storage) } );
+  }
+  auto t = reinterpret_cast<const double*>( tables );
+  return std::make_shared<const CommonCache>( CommonCache{ common->data,
+                                                           Span<const double>( t, t + nn ),
+                                                           Span<const double>( t + nn, t + 2*nn ),
+                                                           {}, {}, std::move(storage) } );
+}
+
+std::string NS::expandedVDOSCacheKey( const VDOSData& vd, unsigned vdoslux, double requestedEmax,
+                                      double vdosthintol )
+{
+  if ( !cacheActive( "ncrystal_vdossab_" ) )
+    return std::string();
+  ContentHash h;
+  h.add( diskcache_format_version );
+  h.add( static_cast<uint32_t>(NCRYSTAL_VERSION) );
+  h.add( vd.vdos_egrid().first );
+  h.add( vd.vdos_egrid().second );
+  h.add( vd.vdos_density() );
+  h.add( vd.temperature().dbl() );
+  h.add( vd.boundXS().dbl() );
+  h.add( vd.elementMassAMU().dbl() );
+  h.add( vdoslux );
+  h.add( requestedEmax );
+  if ( vdosthintol > 0.0 )
+    h.add( vdosthintol );//only when enabled, to keep keys of unthinned kernels
+  return cacheKey( "ncrystal_vdossab_", h.value() );
+}
+
+namespace NCrystal {
+  namespace SAB {
+    namespace {
+      std::shared_ptr<const SABData> loadSABDataEntry( const std::string& key )
+      {
+        auto blob = findBlob( key );
+        if ( !blob.has_value() )
+          return nullptr;//not in cache
+        try {
+          Reader r( blob.value().data );
+          if ( !checkHeader( r ) ) {
+            warnOnce("Ignoring incompatible SAB disk cache entry "+key);
+            return nullptr;
+          }
+          VectD alphaGrid = r.getVect<double>();
+          VectD betaGrid = r.getVect<double>();
+          VectD sab = r.getVect<double>();
+          const double temperature = r.get<double>();
+          const double boundXS = r.get<double>();
+          const double mass = r.get<double>();
+          const double suggestedEmax = r.get<double>();
+          if ( !r.atEnd() )
+            throw ReadError();
+          return std::make_shared<const SABData>( std::move(alphaGrid), std::move(betaGrid), std::move(sab),
+                                                  Temperature{temperature}, SigmaBound{boundXS},
+                                                  AtomMass{mass}, suggestedEmax );
+        } catch ( ReadError& ) {
+          warnOnce("Ignoring corrupted SAB disk cache entry "+key);
+        } catch ( std::exception& e ) {
+          warnOnce("Ignoring SAB disk cache entry "+key+" which could not be loaded ("+e.what()+")");
+        }
+        return nullptr;
+      }
+
+      void saveSABDataEntry( const std::string& key, const SABData& data )
+      {
+        if ( !storesWanted() )
+          return;
+        Writer w;
+        writeHeader( w );
+        w.putVect( data.alphaGrid() );
+        w.putVect( data.betaGrid() );
+        w.putVect( data.sab() );
+        w.put( data.temperature().dbl() );
+        w.put( data.boundXS().dbl() );
+        w.put( data.elementMassAMU().dbl() );
+        w.put( data.suggestedEmax() );
+        storeBlob( key, w.buffer() );
+      }
+    }
+  }
+}
+
+std::shared_ptr<const NC::SABData> NS::loadExpandedVDOSFromDiskCache( const std::string& key )
+{
+  return loadSABDataEntry( key );
+}
+
+void NS::saveExpandedVDOSToDiskCache( const std::string& key, const SABData& data )
+{
+  saveSABDataEntry( key, data );
+}
+
+std::string NS::convertedKernelCacheKey( const ScatKnlData& knl, const char * tableBegin, const char * tableEnd )
+{
+  if ( !cacheActive( "ncrystal_knlsab_" ) )
+    return std::string();
+  ContentHash h;
+  h.add( diskcache_format_version );
+  h.add( static_cast<uint32_t>(NCRYSTAL_VERSION) );
+  h.add( static_cast<uint32_t>(knl.knltype) );
+  h.add( knl.alphaGrid );
+  h.add( knl.betaGrid );
+  h.addBytes( tableBegin, tableEnd );
+  h.add( knl.temperature.dbl() );
+  h.add( knl.boundXS.dbl() );
+  h.add( knl.elementMassAMU.dbl() );
+  h.add( knl.suggestedEmax );
+  return cacheKey( "ncrystal_knlsab_", h.value() );
+}
+
+std::shared_ptr<const NC::SABData> NS::loadConvertedKernelFromDiskCache( const std::string& key )
+{
+  return loadSABDataEntry( key );
+}
+
+void NS::saveConvertedKernelToDiskCache( const std::string& key, const SABData& data )
+{
+  saveSABDataEntry( key, data );
+}
+
+namespace NCrystal {
+  namespace SAB {
+    namespace {
+      //Snapshot files contain a header, an index of (key,offset,size) entries
+      //and the entry data (each entry aligned to 64 bytes, so tables retain
+      //their alignment when used directly from the mapped file):
+      constexpr char snapshot_magic[8] = { 'N','C','S','N','A','P','S','H' };
+      constexpr std::size_t snapshot_alignment = 64;
+      std::size_t snapshotAlign( std::size_t n )
+      {
+        return ( ( n + snapshot_alignment - 1 ) / snapshot_alignment ) * snapshot_alignment;
+      }
+    }
+  }
+}
+
+void NS::beginSnapshotRecording()
+{
+  snapshotStore().beginRecording();
+}
+
+namespace NCrystal {
+  namespace SAB {
+    namespace {
+      //Writes snapshot file content for the recorded entries to a stream:
+      void writeSnapshotContent( const std::map<std::string,std::string>& entries, std::ostream& os )
+      {
+        Writer w;
+        for ( auto c : snapshot_magic )
+          w.put( c );
+        w.put( diskcache_format_version );
+        w.put( diskcache_endian_marker );
+        w.put( static_cast<uint32_t>(NCRYSTAL_VERSION) );
+        w.put( static_cast<uint64_t>(entries.size()) );
+        std::size_t indexsize = w.buffer().size();
+        for ( auto& e : entries )
+          indexsize += sizeof(uint64_t) + e.first.size() + 2*sizeof(uint64_t);
+        std::size_t offset = snapshotAlign( indexsize );
+        for ( auto& e : entries ) {
+          w.put( static_cast<uint64_t>(e.first.size()) );
+          for ( auto c : e.first )
+            w.put( c );
+          w.put( static_cast<uint64_t>(offset) );
+          w.put( static_cast<uint64_t>(e.second.size()) );
+          offset = snapshotAlign( offset + e.second.size() );
+        }
+        nc_assert_always( w.buffer().size() == indexsize );
+
+        const std::string padding( snapshot_alignment, '\0' );
+        std::size_t pos = w.buffer().size();
+        os.write( w.buffer().data(), static_cast<std::streamsize>(pos) );
+        for ( auto& e : entries ) {
+          os.write( padding.data(), static_cast<std::streamsize>( snapshotAlign(pos) - pos ) );
+          pos = snapshotAlign(pos);
+          os.write( e.second.data(), static_cast<std::streamsize>(e.second.size()) );
+          pos += e.second.size();
+        }
+      }
+    }
+  }
+}
+
+void NS::endSnapshotRecording( const std::string& path )
+{
+  auto entries = snapshotStore().endRecording();
+  if ( path.empty() )
+    return;//aborted
+  auto writeContent = [&entries](std::ostream& os) { writeSnapshotContent( entries, os ); };
+  if ( !writeFileAtomically( path, writeContent ) )
+    NCRYSTAL_THROW2(DataLoadError,"Could not write snapshot file: "<<path);
+}
+
+std::string NS::endSnapshotRecordingToMemory()
+{
+  auto entries = snapshotStore().endRecording();
+  std::ostringstream os;
+  writeSnapshotContent( entries, os );
+  return os.str();
+}
+
+namespace NCrystal {
+  namespace SAB {
+    namespace {
+      void loadSnapshotData( Span<const char> data,
+                             std::shared_ptr<const void> keepAlive,
+                             const std::string& path );
+    }
+  }
+}
+
+void NS::loadSnapshot( const std::string& path )
+{
+  //Map the file if possible (so tables can be used directly from the mapped
+  //memory), otherwise read it into memory:
+  std::shared_ptr<const void> keepAlive;
+  Span<const char> data;
+  auto mf = MappedFile::mapFile( path );
+  if ( mf ) {
+    data = mf->data();
+    keepAlive = std::move(mf);
+  } else {
+    auto buf = readFileToBuffer( path );
+    if ( !buf )
+      NCRYSTAL_THROW2(FileNotFound,"Could not read snapshot file: "<<path);
+    data = Span<const char>( buf->data(), buf->data() + buf->size() );
+    keepAlive = std::move(buf);
+  }
+  loadSnapshotData( data, std::move(keepAlive), path );
+}
+
+void NS::loadSnapshotFromMemory( const char * data, std::size_t size )
+{
+  nc_assert_always( data != nullptr );
+  if ( reinterpret_cast<std::uintptr_t>(data) % snapshot_alignment != 0 )
+    NCRYSTAL_THROW2(BadInput,"In-memory snapshot data must be aligned to "<<snapshot_alignment<<" bytes");
+  loadSnapshotData( Span<const char>( data, data + size ), nullptr, "<in-memory data>" );
+}
+
+bool NS::snapshotsMightUse( const char * keyprefix )
+{
+  return snapshotStore().mightUse( keyprefix );
+}
+
+NC::Optional<std::string> NS::findSnapshotEntry( const std::string& key )
+{
+  Optional<BlobRef> blob = snapshotStore().find( key );
+  if ( !blob.has_value() )
+    return NullOpt;
+  snapshotStore().record( key, blob.value().data );
+  return std::string( blob.value().data.begin(), blob.value().data.end() );
+}
+
+void NS::recordSnapshotEntry( const std::string& key, const std::string& data )
+{
+  snapshotStore().record( key, Span<const char>( data.data(), data.data() + data.size() ) );
+}
+
+namespace NCrystal {
+  namespace SAB {
+    namespace {
+      void loadSnapshotData( Span<const char> data,
+                             std::shared_ptr<const void> keepAlive,
+                             const std::string& path )
+      {
+        std::map<std::string,BlobRef> entries;
+        try {
+          Reader r( data );
+          for ( auto c : snapshot_magic )
+            if ( r.get<char>() != c )
+              NCRYSTAL_THROW2(DataLoadError,"Not an NCrystal snapshot file: "<<path);
+          if ( r.get<uint32_t>() != diskcache_format_version
+               || r.get<uint32_t>() != diskcache_endian_marker
+               || r.get<uint32_t>() != static_cast<uint32_t>(NCRYSTAL_VERSION) )
+            NCRYSTAL_THROW2(DataLoadError,"Snapshot file was created by an incompatible NCrystal"
+                            " version or on a different architecture: "<<path);
+          const uint64_t n = r.get<uint64_t>();
+          for ( uint64_t i = 0; i < n; ++i ) {
+            auto keychars = r.getVect<char>();
+            const uint64_t offset = r.get<uint64_t>();
+            const uint64_t size = r.get<uint64_t>();
+            if ( offset > static_cast<uint64_t>(data.size()) || size > static_cast<uint64_t>(data.size()) - offset )
+              throw ReadError();
+            const char * b = data.data() + offset;
+            entries[std::string(keychars.begin(),keychars.end())] = BlobRef{ Span<const char>( b, b + size ), keepAlive };
+          }
+        } catch ( ReadError& ) {
+          NCRYSTAL_THROW2(DataLoadError,"Corrupted snapshot file: "<<path);
+        }
+        snapshotStore().addLoaded( std::move(entries) );
+      }
+    }
+  }
+}
@@ -0,0 +1,134 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+//  This file is part of NCrystal (see https://mctools.github.io/ncrystal/)   //
+//                                                                            //
+//  Copyright 2015-2021 NCrystal developers                                   //
+//                                                                            //
+//  Licensed under the Apache License, Version 2.0 (the "License");           //
+//  you may not use this file except in compliance with the License.          //
+//  You may obtain a copy of the License at                                   //
+//                                                                            //
+//      http://www.apache.org/licenses/LICENSE-2.0                            //
+//                                                                            //
+//  Unless required by applicable law or agreed to in writing, software       //
+//  distributed under the License is distributed on an "AS IS" BASIS,         //
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  //
+//  See the License for the specific language governing permissions and       //
+//  limitations under the License.                                            //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include "NCrystal/internal/NCSABXSProvider.hh"
+
+
+#include "NCrystal/internal/NCSABEGridIndex.hh"
+
+namespace NC = NCrystal;
+
+NC::SAB::EGridIndex::~EGridIndex() = default;
+
+NC::SAB::EGridIndex::EGridIndex( VectD&& egrid )
+  : m_egrid(std::move(egrid))
+{
+  nc_assert_always( !m_egrid.empty() && m_egrid.front() > 0.0 );
+  nc_assert_always( std::is_sorted( m_egrid.begin(), m_egrid.end() ) );
+  nc_assert_always( m_egrid.size() < std::numeric_limits<uint32_t>::max() );
+
+  //About two buckets per grid point is enough to give each bucket only a
+  //couple of points to search, even for grids which are not quite log-spaced:
+  const std::size_t nbuckets = ncmin( 2*m_egrid.size(), std::size_t(1000000) );
+  m_logEmin = std::log( m_egrid.front() );
+  const double logEmax = std::log( m_egrid.back() );
+  const double width = ( logEmax - m_logEmin ) / nbuckets;
+  m_invLogBucketWidth = width > 0.0 ? 1.0 / width : 0.0;
+
+  auto ub = [this]( double e ) -> uint32_t
+  {
+    return static_cast<uint32_t>( binSlow( e ) );
+  };
+  constexpr double eps = 1e-9;//much larger than rounding errors in bin(..)
+  m_buckets.reserve( nbuckets );
+  for ( std::size_t i = 0; i < nbuckets; ++i ) {
+    const double elow = std::exp( m_logEmin + i * width );
+    const double ehigh = std::exp( m_logEmin + ( i + 1 ) * width );
+    m_buckets.emplace_back( ub( elow * ( 1.0 - eps ) ), ub( ehigh * ( 1.0 + eps ) ) );
+  }
+}
+
+void NC::SAB::EGridIndex::binMany( const double* ekin, std::size_t N, std::size_t* out_bins ) const
+{
+  //Same as bin(..), but split in stages over groups of energies, so the
+  //bucket and grid lookups of all energies in a group are in flight at once:
+  constexpr std::size_t G = 16;
+  constexpr std::size_t outside = std::numeric_limits<std::size_t>::max();
+  const std::size_t n = m_egrid.size();
+  const double emin = m_egrid.front();
+  const double emax = m_egrid.back();
+  const std::size_t ibmax = m_buckets.size() - 1;
+  std::size_t ib[G];
+  for ( std::size_t i0 = 0; i0 < N; i0 += G ) {
+    const std::size_t g = std::min<std::size_t>( G, N - i0 );
+    const double * e = ekin + i0;
+    std::size_t * res = out_bins + i0;
+    for ( std::size_t j = 0; j < g; ++j ) {
+      if ( !( e[j] >= emin ) ) {
+        res[j] = 0;//also handles NaN
+        ib[j] = outside;
+      } else if ( e[j] >= emax ) {
+        res[j] = n;
+        ib[j] = outside;
+      } else {
+        const double x = ( std::log( e[j] ) - m_logEmin ) * m_invLogBucketWidth;
+        ib[j] = std::min<std::size_t>( static_cast<std::size_t>( ncmax( 0.0, x ) ), ibmax );
+        ncprefetch( &m_buckets[ib[j]] );
+      }
+    }
+    for ( std::size_t j = 0; j < g; ++j )
+      if ( ib[j] != outside )
+        ncprefetch( m_egrid.data() + m_buckets[ib[j]].first );
+    for ( std::size_t j = 0; j < g; ++j ) {
+      if ( ib[j] == outside )
+        continue;
+      const auto& b = m_buckets[ib[j]];
+      res[j] = std::upper_bound( m_egrid.begin() + b.first, m_egrid.begin() + b.second, e[j] ) - m_egrid.begin();
+      nc_assert( res[j] == binSlow( e[j] ) );
+    }
+  }
+}
+
+std::size_t NC::SAB::EGridIndex::approxMemoryUsage() const
+{
+  return sizeof(*this) + m_egrid.size() * sizeof(double)
+    + m_buckets.size() * sizeof(m_buckets.front());
+}
+
+void NC::SAB::EGridIndex::binManySorted( const double* ekin, std::size_t N, std::size_t* out_bins ) const
+{
+  if ( N == 0 )
+    return;
+  const std::size_t n = m_egrid.size();
+  const double * g = m_egrid.data();
+  std::size_t i = bin( ekin[0] );
+  out_bins[0] = i;
+  for ( std::size_t j = 1; j < N; ++j ) {
+    const double e = ekin[j];
+    nc_assert( e >= ekin[j-1] );
+    //Result is at least i, since g[i-1] <= ekin[j-1] <= e. Only move forward
+    //if needed, with an exponential search for the range (so large jumps in
+    //energy are also handled efficiently):
+    if ( i < n && !( e < g[i] ) ) {
+      std::size_t lo = i + 1;
+      std::size_t hi = lo;
+      std::size_t step = 1;
+      while ( hi < n && !( e < g[hi] ) ) {
+        lo = hi + 1;
+        hi = lo + step;
+        step *= 2;
+      }
+      hi = std::min<std::size_t>( hi, n );
+      i = std::upper_bound( g + lo, g + hi, e ) - g;
+    }
+    nc_assert( i == binSlow( e ) );
+    out_bins[j] = i;
+  }
+}
@@ -19,22 +19,51 @@
 ////////////////////////////////////////////////////////////////////////////////
 
 #include "NCrystal/internal/NCSABExtender.hh"
+#include <atomic>
+#include <mutex>
 namespace NC = NCrystal;
 
 NC::SAB::SABExtender::~SABExtender() = default;
 
+struct NC::SAB::SABFGExtender::BetaTables {
+  std::atomic<bool> ready = {false};
+  std::mutex mutex;
+  std::shared_ptr<const FreeGasBetaTable> standard;
+  std::shared_ptr<const FreeGasBetaTable> highE;
+};
+
 NC::SAB::SABFGExtender::SABFGExtender( Temperature temp_k, AtomMass mass, NC::SigmaFree sigma )
   : m_xsprovider(temp_k,mass,sigma),
     m_t(DoValidate,temp_k),
-    m_m(DoValidate,mass)
+    m_m(DoValidate,mass),
+    m_betaTables(std::make_unique<BetaTables>())
 {
 }
 
 NC::SAB::SABFGExtender::SABFGExtender( Temperature temp_k, AtomMass mass, NC::SigmaBound sigma )
   : m_xsprovider(temp_k,mass,sigma),
     m_t(DoValidate,temp_k),
-    m_m(DoValidate,mass)
+    m_m(DoValidate,mass),
+    m_betaTables(std::make_unique<BetaTables>())
+{
+}
+
+const NC::FreeGasBetaTable* NC::SAB::SABFGExtender::betaTable( double c ) const
 {
+  auto& bt = *m_betaTables;
+  if ( !bt.ready.load() ) {
+    std::lock_guard<std::mutex> lock(bt.mutex);
+    if ( !bt.ready.load() ) {
+      bt.standard = FreeGasBetaTable::getShared( m_m ).getsp();
+      bt.highE = FreeGasBetaTable::getSharedHighE( m_m ).getsp();
+      bt.ready.store( true );
+    }
+  }
+  if ( bt.standard->covers( c ) )
+    return bt.standard.get();
+  if ( bt.highE->covers( c ) )
+    return bt.highE.get();
+  return nullptr;
 }
 
 NC::SAB::SABFGExtender::~SABFGExtender() = default;
@@ -46,5 +75,5 @@ NC::CrossSect NC::SAB::SABFGExtender::crossSection(NeutronEnergy ekin) const
 
 NC::PairDD NC::SAB::SABFGExtender::sampleAlphaBeta( RNG& rng, NeutronEnergy ekin ) const
 {
-  return FreeGasSampler(ekin, m_t, m_m).sampleAlphaBeta(rng);
+  return FreeGasSampler(ekin, m_t, m_m, betaTable( ekin.dbl() / m_t.kT() )).sampleAlphaBeta(rng);
 }
@@ -28,8 +28,9 @@ namespace NC = NCrystal;
 namespace NCrystal {
   namespace SAB {
 
-    //Cache key is (sabdata uid, egrid uid, sabdata ptr):
-    typedef std::tuple<UniqueIDValue,UniqueIDValue,shared_obj<const NC::SABData>*> ScatHelperCacheKey;
+    //Cache key is (sabdata uid, egrid uid, sampler type, single precision
+    //tables, sabdata ptr):
+    typedef std::tuple<UniqueIDValue,UniqueIDValue,SamplerAtEType,bool,shared_obj<const NC::SABData>*> ScatHelperCacheKey;
 
     class ScatterHelperFactory : public NC::CachedFactoryBase<ScatHelperCacheKey,SABScatterHelper> {
     public:
@@ -37,16 +38,22 @@ namespace NCrystal {
       std::string keyToString( const ScatHelperCacheKey& key ) const final
       {
         std::ostringstream ss;
-        ss<<"(SABData id="<<std::get<0>(key).value<<";egrid id="<<std::get<1>(key).value<<")";
+        ss<<"(SABData id="<<std::get<0>(key).value<<";egrid id="<<std::get<1>(key).value
+          <<";sampler="<<( std::get<2>(key) == SamplerAtEType::AliasTable ? "AliasTable" : "Alg1" )
+          <<";float32="<<( std::get<3>(key) ? "yes" : "no" )<<")";
         return ss.str();
       }
     protected:
       virtual ShPtr actualCreate( const ScatHelperCacheKey& key ) const final
       {
-        auto sabdata_shptr = *std::get<2>(key);
+        auto sabdata_shptr = *std::get<4>(key);
         nc_assert( sabdata_shptr->getUniqueID() == std::get<0>(key) );
         auto egrid_shptr = egridFromUniqueID(std::get<1>(key));
-        return createScatterHelper(std::move(sabdata_shptr),std::move(egrid_shptr));
+        return createScatterHelper(std::move(sabdata_shptr),std::move(egrid_shptr),std::get<2>(key),std::get<3>(key));
+      }
+      std::size_t approxMemoryUsage( const SABScatterHelper& sh ) const final
+      {
+        return sh.approxMemoryUsage();
       }
     };
 
@@ -55,10 +62,12 @@ namespace NCrystal {
 }
 
 std::unique_ptr<const NC::SAB::SABScatterHelper> NC::SAB::createScatterHelper( shared_obj<const NC::SABData> data,
-                                                                               std::shared_ptr<const VectD> energyGrid )
+                                                                               std::shared_ptr<const VectD> energyGrid,
+                                                                               SamplerAtEType samplerType,
+                                                                               bool singlePrecisionTables )
 {
   nc_assert(!!data);
-  SABIntegrator si(data,energyGrid.get());
+  SABIntegrator si(data,energyGrid.get(),nullptr,samplerType,singlePrecisionTables);
   auto sh = si.createScatterHelper();
   return std::make_unique<SABScatterHelper>(std::move(sh));
 }
@@ -68,12 +77,16 @@ void NC::SAB::clearScatterHelperCache() {
 }
 
 NC::shared_obj<const NC::SAB::SABScatterHelper> NC::SAB::createScatterHelperWithCache( shared_obj<const NC::SABData> dataptr,
-                                                                                       std::shared_ptr<const VectD> egrid )
+                                                                                       std::shared_ptr<const VectD> egrid,
+                                                                                       SamplerAtEType samplerType,
+                                                                                       bool singlePrecisionTables )
 {
   nc_assert_always(!!dataptr);
 
   ScatHelperCacheKey key( dataptr->getUniqueID(),
                           egridToUniqueID( egrid ),
+                          samplerType,
+                          singlePrecisionTables,
                           &dataptr );
 
   return s_scathelperfact.create(key);
@@ -87,6 +100,29 @@ namespace NCrystal {
     static std::map< HashValue, std::vector<std::pair<std::shared_ptr<const VectD>, UniqueID>>> s_egridHashCache;
     static std::map< uint64_t, std::shared_ptr<const VectD>* > s_uid2egrid;
     static std::mutex s_egrid2uid_mutex;
+    static uint64_t s_egrid_nhits = 0;
+    static uint64_t s_egrid_nmisses = 0;
+
+    FactoryCacheStats egridCacheStats()
+    {
+      NCRYSTAL_LOCK_GUARD(s_egrid2uid_mutex);
+      FactoryCacheStats s;
+      s.name = "EGridCache";
+      s.nstrongrefs = s.nentries = s_uid2egrid.size();
+      for ( auto& e : s_uid2egrid )
+        s.nbytes += sizeof(VectD) + (*e.second)->size() * sizeof(double);
+      s.nhits = s_egrid_nhits;
+      s.nmisses = s_egrid_nmisses;
+      return s;
+    }
+
+    //Must hold s_egrid2uid_mutex:
+    void egridCacheRecordAccess( bool hit )
+    {
+      if ( s_egrid_nhits + s_egrid_nmisses == 0 )
+        registerFactoryCacheStatsFunction(egridCacheStats);
+      ++( hit ? s_egrid_nhits : s_egrid_nmisses );
+    }
   }
 }
 
@@ -97,10 +133,13 @@ NC::UniqueIDValue NC::SAB::egridToUniqueID(const NC::VectD& egrid)
   NCRYSTAL_LOCK_GUARD(s_egrid2uid_mutex);
   auto& v = s_egridHashCache[hash];//In absence of hash collisions, v will have length 0 or 1.
   for (auto& e : v) {
-    if ( *e.first == egrid )
+    if ( *e.first == egrid ) {
+      egridCacheRecordAccess(true);
       return e.second.getUniqueID();//exists in cache already
+    }
   }
   //Add new:
+  egridCacheRecordAccess(false);
   v.emplace_back(std::make_shared<const VectD>(egrid),UniqueID() );
   auto uidval = v.back().second.getUniqueID();
   s_uid2egrid[uidval.value] = &v.back().first;
@@ -117,10 +156,13 @@ NC::UniqueIDValue NC::SAB::egridToUniqueID(const std::shared_ptr<const NC::VectD
   NCRYSTAL_LOCK_GUARD(s_egrid2uid_mutex);
   auto& v = s_egridHashCache[hash];//In absence of hash collisions, v will have length 0 or 1.
   for (auto& e : v) {
-    if ( *e.first == *egrid )
+    if ( *e.first == *egrid ) {
+      egridCacheRecordAccess(true);
       return e.second.getUniqueID();//exists in cache already
+    }
   }
   //Add new:
+  egridCacheRecordAccess(false);
   v.emplace_back( egrid, UniqueID() );
   auto uidval = v.back().second.getUniqueID();
   s_uid2egrid[uidval.value] = &v.back().first;
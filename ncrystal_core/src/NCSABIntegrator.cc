@@ -20,9 +20,13 @@
 
 #include "NCrystal/internal/NCSABIntegrator.hh"
 #include "NCrystal/internal/NCSABSamplerModels.hh"
+#include "NCrystal/internal/NCSABDiskCache.hh"
 #include "NCrystal/internal/NCSABUtils.hh"
 #include "NCrystal/internal/NCFactoryUtils.hh"
 #include "NCrystal/internal/NCIter.hh"
+#include "NCrystal/internal/NCLargeAlloc.hh"
+#include "NCrystal/internal/NCThreadUtils.hh"
+#include "NCrystal/internal/NCTrace.hh"
 #include <iostream>
 
 namespace NC = NCrystal;
@@ -32,7 +36,8 @@ struct NC::SAB::SABIntegrator::Impl : private NoCopyMove {
 
   Impl( shared_obj<const SABData>,
         const VectD* egrid,
-        std::shared_ptr<const SABExtender> );
+        std::shared_ptr<const SABExtender>,
+        SamplerAtEType, bool );
   void doit(SABXSProvider *, SABSampler*);
   double determineEMax( const double ) const;
   double determineEMin( const double ) const;
@@ -42,6 +47,9 @@ struct NC::SAB::SABIntegrator::Impl : private NoCopyMove {
   shared_obj<const SABData> m_data;
   VectD m_egrid;
   std::shared_ptr<const SABExtender> m_extender;
+  SamplerAtEType m_samplerType;
+  bool m_singlePrecisionTables;
+  bool m_defaultExtender;
 
   //Data derived from m_data:
   std::shared_ptr<const SABSamplerAtE_Alg1::CommonCache> m_derivedData;
@@ -60,29 +68,38 @@ NS::SABIntegrator::~SABIntegrator() = default;
 
 NS::SABIntegrator::SABIntegrator( shared_obj<const SABData> data,
                                   const VectD* egrid,
-                                  std::shared_ptr<const SABExtender> sabextender )
-  : m_impl(std::move(data),egrid,std::move(sabextender))
+                                  std::shared_ptr<const SABExtender> sabextender,
+                                  SamplerAtEType samplerType,
+                                  bool singlePrecisionTables )
+  : m_impl(std::move(data),egrid,std::move(sabextender),samplerType,singlePrecisionTables)
 {
 }
 
 void NS::SABIntegrator::doit(SABXSProvider * out_xs, SABSampler* out_sampler)
 {
+  Trace::Span span("SABIntegrator");
   m_impl->doit(out_xs,out_sampler);
 }
 
 NS::SABIntegrator::Impl::Impl( shared_obj<const SABData> data,
                                const VectD* egrid,
-                               std::shared_ptr<const SABExtender> sabextender )
+                               std::shared_ptr<const SABExtender> sabextender,
+                               SamplerAtEType samplerType,
+                               bool singlePrecisionTables )
   : m_data(std::move(data)),
     m_egrid((egrid&&!egrid->empty())?*egrid:VectD()),
-    m_extender(!sabextender?std::make_unique<SABFGExtender>(m_data->temperature(),m_data->elementMassAMU(),m_data->boundXS()):std::move(sabextender))
+    m_extender(!sabextender?std::make_unique<SABFGExtender>(m_data->temperature(),m_data->elementMassAMU(),m_data->boundXS()):std::move(sabextender)),
+    m_samplerType(samplerType),
+    m_singlePrecisionTables(singlePrecisionTables),
+    m_defaultExtender(!sabextender)
 {
 }
 
 namespace NCrystal {
   namespace {
-    //Derived data factory:
-    typedef std::pair<UniqueIDValue, shared_obj<const SABData>* > D2DDKey;
+    //Derived data factory. Cache key is (sabdata uid, single precision tables,
+    //sabdata ptr):
+    typedef std::tuple<UniqueIDValue, bool, shared_obj<const SABData>* > D2DDKey;
     typedef SAB::SABSamplerAtE_Alg1::CommonCache DerivedData;
     class SABData2DerivedDataFactory : public NC::CachedFactoryBase<D2DDKey,DerivedData> {
     public:
@@ -90,45 +107,76 @@ namespace NCrystal {
       std::string keyToString( const D2DDKey& key ) const final
       {
         std::ostringstream ss;
-        ss<<"(SABData id="<<key.first.value<<")";
+        ss<<"(SABData id="<<std::get<0>(key).value<<";float32="<<( std::get<1>(key) ? "yes" : "no" )<<")";
         return ss.str();
       }
     protected:
       virtual ShPtr actualCreate( const D2DDKey& key ) const final
       {
-        shared_obj<const SABData> data = *key.second;
-        nc_assert( !!data && data->getUniqueID()==key.first );
+        shared_obj<const SABData> data = *std::get<2>(key);
+        nc_assert( !!data && data->getUniqueID()==std::get<0>(key) );
+        const bool sp = std::get<1>(key);
 
         const auto& alphaGrid = data->alphaGrid();
         const auto& sab = data->sab();
         const std::size_t nalpha = alphaGrid.size();
         const std::size_t nbeta = data->betaGrid().size();
-        const std::size_t nalpham1 = nalpha-1;
 
         //Calculate log(S) values:
         VectD logsab;
-        logsab.reserve(sab.size());
-        for (auto e: sab)
-          logsab.push_back( e>0.0 ? std::log(e) : -kInfinity);
+        logsab.resize(sab.size());
+        SABUtils::calcLogSAB( sab, logsab );
 
-        //For each beta-idx, integrate each grid cell along alpha:
+        //For each beta-idx, integrate each grid cell along alpha (row by row):
         VectD alphaintegrals_cumul;
         alphaintegrals_cumul.resize(sab.size(),0.);
-        std::size_t global_idx(0);
-        for (std::size_t ibeta = 0; ibeta<nbeta; ++ibeta, ++global_idx) {
-          double cumul = 0.0;
-          for (std::size_t ai = 0; ai < nalpham1; ++ai, ++global_idx) {
-            auto next_idx = global_idx + 1;
-            double integ = SABUtils::integrateAlphaInterval_fast( vectAt( alphaGrid, ai ), vectAt( sab, global_idx ),
-                                                                  vectAt( alphaGrid, ai+1 ), vectAt( sab,  next_idx ),
-                                                                  vectAt( logsab, global_idx ), vectAt( logsab,  next_idx ) );
-            vectAt( alphaintegrals_cumul, next_idx ) = (cumul += integ);
+        for (std::size_t ibeta = 0; ibeta<nbeta; ++ibeta)
+          SABUtils::integrateAlphaRow_fast( alphaGrid,
+                                            SABUtils::sliceSABAtBetaIdx_const( sab, nalpha, ibeta ),
+                                            SABUtils::sliceSABAtBetaIdx_const( logsab, nalpha, ibeta ),
+                                            SABUtils::sliceSABAtBetaIdx( alphaintegrals_cumul, nalpha, ibeta ) );
+
+        //Wrap up and return (sharing tables via the disk cache if enabled). The
+        //tables are accessed randomly during sampling, so if huge pages are
+        //enabled (cf. NCLargeAlloc.hh), they are moved into such memory:
+        std::shared_ptr<const DerivedData> dd;
+        const std::size_t n = logsab.size();
+        if ( hugePagesEnabled() ) {
+          auto storage = allocateLargeTable( 2 * std::max<std::size_t>( n, 1 ) * ( sp ? sizeof(float) : sizeof(double) ) );
+          if ( sp ) {
+            float * t = static_cast<float*>( storage.get() );
+            std::copy( logsab.begin(), logsab.end(), t );
+            std::copy( alphaintegrals_cumul.begin(), alphaintegrals_cumul.end(), t + n );
+            dd = std::make_shared<const DerivedData>( DerivedData{ data, {}, {},
+                                                                   Span<const float>( t, t + n ),
+                                                                   Span<const float>( t + n, t + 2*n ),
+                                                                   std::move(storage) } );
+          } else {
+            double * t = static_cast<double*>( storage.get() );
+            std::copy( logsab.begin(), logsab.end(), t );
+            std::copy( alphaintegrals_cumul.begin(), alphaintegrals_cumul.end(), t + n );
+            dd = std::make_shared<const DerivedData>( DerivedData{ data,
+                                                                   Span<const double>( t, t + n ),
+                                                                   Span<const double>( t + n, t + 2*n ),
+                                                                   {}, {}, std::move(storage) } );
           }
+        } else if ( sp ) {
+          auto storage = std::make_shared<std::pair<std::vector<float>,std::vector<float>>>();
+          storage->first.assign( logsab.begin(), logsab.end() );
+          storage->second.assign( alphaintegrals_cumul.begin(), alphaintegrals_cumul.end() );
+          dd = std::make_shared<const DerivedData>( DerivedData{ data, {}, {},
+                                                                 storage->first, storage->second,
+                                                                 storage } );
+        } else {
+          auto storage = std::make_shared<const std::pair<VectD,VectD>>( std::move(logsab), std::move(alphaintegrals_cumul) );
+          dd = std::make_shared<const DerivedData>( DerivedData{ data, storage->first, storage->second,
+                                                                 {}, {}, storage } );
         }
-        nc_assert(global_idx==sab.size());
-
-        //Wrap up and return:
-        return std::make_shared<const DerivedData>(DerivedData{data,std::move(logsab),std::move(alphaintegrals_cumul)});
+        return SAB::mapSharedCommonCache( std::move(dd) );
+      }
+      std::size_t approxMemoryUsage( const DerivedData& dd ) const final
+      {
+        return dd.approxMemoryUsage();
       }
     };
     static SABData2DerivedDataFactory s_SABData2DerivedDataFactory;
@@ -272,37 +320,70 @@ void NS::SABIntegrator::Impl::doit(SABXSProvider * out_xs, SABSampler* out_sampl
 {
   nc_assert_always( out_xs || out_sampler );
   if ( !m_derivedData )
-    m_derivedData = s_SABData2DerivedDataFactory.create(D2DDKey(m_data->getUniqueID(),&m_data));
+    m_derivedData = s_SABData2DerivedDataFactory.create(D2DDKey(m_data->getUniqueID(),m_singlePrecisionTables,&m_data));
 
   const bool doSampler = out_sampler!=nullptr;
 
+  //The on-disk cache (if enabled) is only used for complete results with the
+  //default extender, since custom extenders are not part of the cache key:
+  const std::string diskCacheKey = ( out_xs && out_sampler && m_defaultExtender
+                                     ? SAB::diskCacheKey( *m_data, m_egrid, m_samplerType,
+                                                          m_derivedData->isSinglePrecision() )
+                                     : std::string() );
+  auto setOutputs = [this,out_xs,out_sampler]( std::vector<std::unique_ptr<SABSamplerAtE>>&& samplers,
+                                               VectD&& xsvals )
+  {
+    //Energy grid and its index are shared, so bins looked up by one can be
+    //reused by the other:
+    auto egridIndex = std::make_shared<const SAB::EGridIndex>( VectD(m_egrid.begin(),m_egrid.end()) );
+    if ( out_sampler )
+      out_sampler->setData( m_data->temperature(),
+                            egridIndex,
+                            std::move(samplers),
+                            m_extender, xsvals.back() );
+    if ( out_xs )
+      out_xs->setData( std::move(egridIndex),
+                       std::move(xsvals),
+                       m_extender );
+  };
+
+  if ( !diskCacheKey.empty() ) {
+    VectD cached_egrid, cached_xsvals;
+    std::vector<std::unique_ptr<SABSamplerAtE>> cached_samplers;
+    if ( loadFromDiskCache( diskCacheKey, m_derivedData, cached_egrid, cached_xsvals, cached_samplers ) ) {
+      m_egrid = std::move(cached_egrid);
+      setOutputs( std::move(cached_samplers), std::move(cached_xsvals) );
+      return;
+    }
+  }
+
   //Prepare and validate energy grid:
   setupEnergyGrid();
 
+  //Analyse each energy point. These are independent, so the work can be
+  //shared among several threads (each writing to its own pre-allocated
+  //output slots), without affecting the results:
+  const std::size_t npts = m_egrid.size();
   std::vector<std::unique_ptr<SABSamplerAtE>> energyPointSamplers;
   if ( doSampler )
-    energyPointSamplers.reserve(m_egrid.size());
-  VectD xsvals;
-  xsvals.reserve(m_egrid.size());
-
-  for (const auto& energy : m_egrid ) {
-    nc_assert(energy>0.0);
-    auto sampleruptr_and_xs =  analyseEnergyPoint(energy, doSampler );
-    if ( doSampler )
-      energyPointSamplers.emplace_back(std::move(sampleruptr_and_xs.first));
-    xsvals.emplace_back( sampleruptr_and_xs.second );
-  }
-
-  if ( doSampler )
-    out_sampler->setData( m_data->temperature(),
-                          VectD(m_egrid.begin(),m_egrid.end()),
-                          std::move(energyPointSamplers),
-                          m_extender, xsvals.back() );
-  if ( out_xs )
-    out_xs->setData( VectD(m_egrid.begin(),m_egrid.end()),
-                     std::move(xsvals),
-                     m_extender );
-
+    energyPointSamplers.resize(npts);
+  VectD xsvals(npts,0.0);
+
+  parallelFor( npts, getNThreadsFromEnv(),
+               [this,doSampler,&energyPointSamplers,&xsvals](std::size_t i)
+               {
+                 const double energy = m_egrid[i];
+                 nc_assert(energy>0.0);
+                 auto sampleruptr_and_xs =  analyseEnergyPoint(energy, doSampler );
+                 if ( doSampler )
+                   energyPointSamplers[i] = std::move(sampleruptr_and_xs.first);
+                 xsvals[i] = sampleruptr_and_xs.second;
+               } );
+
+  if ( !diskCacheKey.empty() )
+    saveToDiskCache( diskCacheKey, m_egrid, xsvals, energyPointSamplers );
+
+  setOutputs( std::move(energyPointSamplers), std::move(xsvals) );
 }
 
 std::pair<NS::SABIntegrator::Impl::SamplerAtE_uptr,double> NS::SABIntegrator::Impl::analyseEnergyPoint(double ekin, bool doSampler ) const
@@ -316,16 +397,15 @@ std::pair<NS::SABIntegrator::Impl::SamplerAtE_uptr,double> NS::SABIntegrator::Im
   //middle bins.
   //
   //If also setting up sampling, an SamplerAtE instance will also be prepared
-  //and returned. It is likely to change in the future, but for now we only
-  //support the SABSamplerAtE_Alg1 type, which also needs the same information
-  //and breakdown into front/middle/back parts as was used to calculate the
-  //cross section.
+  //and returned. Both the SABSamplerAtE_Alg1 and SABSamplerAtE_Alias types
+  //need the same information and breakdown into front/middle/back parts as
+  //was used to calculate the cross section.
 
   const auto& betaGrid = m_data->betaGrid();
   auto alphaGrid_span = Span<const double>(m_data->alphaGrid());
   nc_assert(!!m_derivedData);
-  const VectD& logsab = m_derivedData->logsab;
-  const VectD& alphaintegrals_cumul = m_derivedData->alphaintegrals_cumul;
+  const bool singlePrecisionTables = m_derivedData->isSinglePrecision();
+  VectD logsab_buf, alphaintegrals_cumul_buf;//for single precision tables
 
   nc_assert(ekin>=0.);
   const double kT = m_data->temperature().kT();
@@ -409,8 +489,26 @@ std::pair<NS::SABIntegrator::Impl::SamplerAtE_uptr,double> NS::SABIntegrator::Im
       const auto nalpha = m_data->alphaGrid().size();
       auto slice_idx = nalpha*(beta.idx + ibeta_low);
       auto sab_slice = Span<const double>(&m_data->sab()[0]+slice_idx,&m_data->sab()[0]+slice_idx+nalpha);
-      auto logsab_slice = Span<const double>(&logsab[0]+slice_idx,&logsab[0]+slice_idx+nalpha);
-      auto alphaIntegrals_cumul_slice = Span<const double>(&alphaintegrals_cumul[0]+slice_idx,&alphaintegrals_cumul[0]+slice_idx+nalpha);
+      Span<const double> logsab_slice, alphaIntegrals_cumul_slice;
+      if ( singlePrecisionTables ) {
+        //Convert rows to double precision for the following calculations. Only
+        //entries in [aidx_low,aidx_upp] (i.e. the kinematically accessible
+        //part of the row) are used by createTailedBreakdown, so other entries
+        //of the buffers are simply left stale:
+        const float * logsab_f32 = m_derivedData->logsab_f32.data() + slice_idx;
+        const float * cumul_f32 = m_derivedData->alphaintegrals_cumul_f32.data() + slice_idx;
+        logsab_buf.resize( nalpha );
+        alphaintegrals_cumul_buf.resize( nalpha );
+        std::copy( logsab_f32 + aidx_low, logsab_f32 + aidx_upp + 1, logsab_buf.begin() + aidx_low );
+        std::copy( cumul_f32 + aidx_low, cumul_f32 + aidx_upp + 1, alphaintegrals_cumul_buf.begin() + aidx_low );
+        logsab_slice = logsab_buf;
+        alphaIntegrals_cumul_slice = alphaintegrals_cumul_buf;
+      } else {
+        const double * logsab = m_derivedData->logsab.data() + slice_idx;
+        const double * cumul = m_derivedData->alphaintegrals_cumul.data() + slice_idx;
+        logsab_slice = Span<const double>( logsab, logsab + nalpha );
+        alphaIntegrals_cumul_slice = Span<const double>( cumul, cumul + nalpha );
+      }
       tb = SABUtils::createTailedBreakdown( alphaGrid_span, sab_slice, logsab_slice, alphaIntegrals_cumul_slice,
                                             alow, aupp, aidx_low, aidx_upp );
       xs_at_this_beta = tb.xs_front + tb.xs_back + tb.xs_middle;
@@ -474,6 +572,14 @@ std::pair<NS::SABIntegrator::Impl::SamplerAtE_uptr,double> NS::SABIntegrator::Im
     return { std::make_unique<SABSamplerAtE_NoScatter>(), xs_total };
 
   nc_assert(!!m_derivedData);
+  if ( m_samplerType == SamplerAtEType::AliasTable )
+    return { std::make_unique<SABSamplerAtE_Alias>( m_derivedData,
+                                                    ekin_div_kT,
+                                                    std::move(betasampler_vals),
+                                                    betasampler_weights,
+                                                    std::move(sampler_infos),
+                                                    ibeta_low ),
+             xs_total };
   SamplerAtE_uptr up = std::make_unique<SABSamplerAtE_Alg1>( m_derivedData,
                                                              std::move(betasampler_vals),
                                                              std::move(betasampler_weights),
@@ -25,6 +25,24 @@ namespace NC = NCrystal;
 
 NC::SABSampler::~SABSampler() = default;
 
+std::size_t NC::SABSampler::approxMemoryUsage() const
+{
+  std::size_t n = sizeof(*this) + ( m_egridIndex ? m_egridIndex->approxMemoryUsage() : 0 )
+    + m_samplers.size() * sizeof(std::unique_ptr<SABSamplerAtE>);
+  for ( auto& s : m_samplers )
+    if ( s )
+      n += s->approxMemoryUsage();
+  return n;
+}
+
+void NC::SABSampler::accountMemory( MemoryFootprint& mf ) const
+{
+  mf.add( approxMemoryUsage() );
+  for ( auto& s : m_samplers )
+    if ( s )
+      s->accountSharedMemory( mf );
+}
+
 NC::SABSampler::SABSampler( Temperature temperature,
                             VectD&& egrid,
                             std::vector<std::unique_ptr<SABSamplerAtE>>&& samplers,
@@ -41,26 +59,37 @@ void NC::SABSampler::setData( Temperature temperature,
                               std::shared_ptr<const SAB::SABExtender> extender,
                               double xsAtEmax )
 {
-  m_egrid = std::move(egrid);
+  nc_assert_always(!egrid.empty());
+  setData( temperature, std::make_shared<const SAB::EGridIndex>( std::move(egrid) ),
+           std::move(samplers), std::move(extender), xsAtEmax );
+}
+
+void NC::SABSampler::setData( Temperature temperature,
+                              std::shared_ptr<const SAB::EGridIndex> egridIndex,
+                              std::vector<std::unique_ptr<SABSamplerAtE>>&& samplers,
+                              std::shared_ptr<const SAB::SABExtender> extender,
+                              double xsAtEmax )
+{
+  nc_assert_always(!!egridIndex);
+  m_egridIndex = std::move(egridIndex);
   m_samplers = std::move(samplers);
   m_kT = temperature.kT();
   m_extender = std::move(extender);
   m_xsAtEmax = xsAtEmax;
-  m_k1 = m_xsAtEmax * m_egrid.back();
-  m_k2 = m_extender->crossSection( NeutronEnergy{m_egrid.back()} ).dbl() * m_egrid.back();
-
+  m_k1 = m_xsAtEmax * egrid().back();
+  m_k2 = m_extender->crossSection( NeutronEnergy{egrid().back()} ).dbl() * egrid().back();
 }
 
 NC::PairDD NC::SABSampler::sampleHighE(NeutronEnergy ekin, RNG& rng) const
 {
-  const double emax = m_egrid.back();
+  const double emax = egrid().back();
   nc_assert( ekin.get() >= emax );
   //Sample (alpha,beta) using provided SABExtender. A returned alpha value of
   //-1.0 indicates that the usual code should sample (alpha,beta) from the
-  //tabulated kernel with ekin=m_egrid.back().
+  //tabulated kernel with ekin=egrid().back().
 
   //Principle: Inside the kinematic curve corresponding to
-  //E=Emax=m_egrid.back(), S(alpha,beta) is given by the tabulated kernel, and
+  //E=Emax=egrid().back(), S(alpha,beta) is given by the tabulated kernel, and
   //outside the curve it is modelled by the S(alpha,beta) values represented by
   //m_extender.
 
@@ -152,26 +181,33 @@ NC::PairDD NC::SABSampler::sampleHighE(NeutronEnergy ekin, RNG& rng) const
 
 NC::PairDD NC::SABSampler::sampleAlphaBeta(NeutronEnergy ekin, RNG& rng) const
 {
-  nc_assert( m_egrid.size()>1 && m_egrid.size()==m_samplers.size() );
+  nc_assert( egrid().size()>1 && egrid().size()==m_samplers.size() );
+  return sampleAlphaBetaInBin( ekin, gridBin( ekin.dbl() ), rng );
+}
+
+NC::PairDD NC::SABSampler::sampleAlphaBetaInBin(NeutronEnergy ekin, std::size_t ibin, RNG& rng) const
+{
+  nc_assert( egrid().size()>1 && egrid().size()==m_samplers.size() );
+  nc_assert( ibin == gridBin( ekin.dbl() ) );
   double alpha,beta;
 
   decltype(m_samplers.begin()) itSampler;
 
-  auto itEkinUpper = std::upper_bound ( m_egrid.begin(), m_egrid.end(), ekin.dbl() );
+  auto itEkinUpper = egrid().begin() + ibin;
   bool ultra_small_ekin_mode = false;
-  const double ultra_small_ekin = m_egrid.front();
+  const double ultra_small_ekin = egrid().front();
 
-  if ( itEkinUpper == m_egrid.end() ) {
+  if ( itEkinUpper == egrid().end() ) {
 
     //High-E extrapolation via m_extender.
     auto alphabeta =  sampleHighE(ekin, rng);
     if (alphabeta.first>=0.0)
       return alphabeta;
     //HighE code decided that we must sample the kernel with ekin=emax:
-    ekin = NeutronEnergy{m_egrid.back()};
+    ekin = NeutronEnergy{egrid().back()};
     itSampler = std::prev(m_samplers.end());
 
-  } else if ( itEkinUpper == m_egrid.begin() ) {
+  } else if ( itEkinUpper == egrid().begin() ) {
 
     //Low-E extrapolation. Beta-distribution is essentially unchanged at this
     //energy, but must treat alpha-sampling specially.
@@ -181,7 +217,7 @@ NC::PairDD NC::SABSampler::sampleAlphaBeta(NeutronEnergy ekin, RNG& rng) const
   } else {
 
     //Inside range of energy grid.
-    itSampler = m_samplers.begin()+std::distance(m_egrid.begin(), itEkinUpper);
+    itSampler = m_samplers.begin()+std::distance(egrid().begin(), itEkinUpper);
 
   }
 
@@ -216,8 +252,90 @@ NC::PairDD NC::SABSampler::sampleAlphaBeta(NeutronEnergy ekin, RNG& rng) const
 
 NC::PairDD NC::SABSampler::sampleDeltaEMu(NeutronEnergy ekin, RNG& rng) const
 {
-  auto alphabeta = sampleAlphaBeta(ekin,rng);
+  return alphaBetaToDeltaEMu( sampleAlphaBeta(ekin,rng), ekin, rng );
+}
+
+NC::PairDD NC::SABSampler::sampleDeltaEMuInBin(NeutronEnergy ekin, std::size_t ibin, RNG& rng) const
+{
+  return alphaBetaToDeltaEMu( sampleAlphaBetaInBin(ekin,ibin,rng), ekin, rng );
+}
+
+NC::PairDD NC::SABSampler::alphaBetaToDeltaEMu( const PairDD& alphabeta, NeutronEnergy ekin, RNG& rng ) const
+{
   if ( NC::muIsotropicAtBeta(alphabeta.second,ekin.get()/m_kT) )
     return std::make_pair( alphabeta.second*m_kT, rng.generate()*2.0 - 1.0 );
   return convertAlphaBetaToDeltaEMu(alphabeta,ekin,m_kT);
 }
+
+void NC::SABSampler::sampleDeltaEMuMany( RNG& rng, const double* ekin, std::size_t N,
+                                         double* out_deltaE, double* out_mu,
+                                         BatchOrder order ) const
+{
+  nc_assert( egrid().size()>1 && egrid().size()==m_samplers.size() );
+  auto sampleOne = [this,&rng,ekin,out_deltaE,out_mu]( std::size_t i, std::size_t ibin )
+  {
+    const NeutronEnergy e{ ekin[i] };
+    std::tie(out_deltaE[i],out_mu[i]) = alphaBetaToDeltaEMu( sampleAlphaBetaInBin( e, ibin, rng ), e, rng );
+  };
+
+  //Small batches do not benefit from sorting:
+  constexpr std::size_t nmin_sort = 64;
+  if ( order == BatchOrder::SortInternally && N < nmin_sort )
+    order = BatchOrder::Unsorted;
+
+  switch ( order ) {
+  case BatchOrder::Unsorted:
+    {
+      //Bin lookups are done a block at a time, interleaving their searches:
+      constexpr std::size_t nblock = 64;
+      std::size_t bins[nblock];
+      for ( std::size_t i0 = 0; i0 < N; i0 += nblock ) {
+        const std::size_t nb = std::min<std::size_t>( nblock, N - i0 );
+        m_egridIndex->binMany( ekin + i0, nb, bins );
+        for ( std::size_t j = 0; j < nb; ++j )
+          sampleOne( i0 + j, bins[j] );
+      }
+    }
+    return;
+  case BatchOrder::Sorted:
+    {
+      //Walk the grid along with the (ascending) energies:
+      nc_assert( std::is_sorted( ekin, ekin + N ) );
+      const std::size_t ngrid = egrid().size();
+      std::size_t ibin = 0;
+      for ( std::size_t i = 0; i < N; ++i ) {
+        while ( ibin < ngrid && egrid()[ibin] <= ekin[i] )
+          ++ibin;
+        sampleOne( i, ibin );
+      }
+    }
+    return;
+  case BatchOrder::SortInternally:
+    {
+      //Counting sort of the neutrons by grid bin (bins run from 0 to ngrid,
+      //where 0 is below and ngrid above the grid), after which the neutrons
+      //are processed bin by bin:
+      const std::size_t nbins = egrid().size() + 1;
+      std::vector<uint32_t> bins, offsets( nbins + 1, 0 ), sorted_idx;
+      bins.reserve( N );
+      constexpr std::size_t nblock = 64;
+      std::size_t blockbins[nblock];
+      for ( std::size_t i0 = 0; i0 < N; i0 += nblock ) {
+        const std::size_t nb = std::min<std::size_t>( nblock, N - i0 );
+        m_egridIndex->binMany( ekin + i0, nb, blockbins );
+        for ( std::size_t j = 0; j < nb; ++j ) {
+          bins.push_back( static_cast<uint32_t>( blockbins[j] ) );
+          ++offsets[ blockbins[j] + 1 ];
+        }
+      }
+      for ( std::size_t b = 1; b <= nbins; ++b )
+        offsets[b] += offsets[b-1];
+      sorted_idx.resize( N );
+      for ( std::size_t i = 0; i < N; ++i )
+        sorted_idx[ offsets[ bins[i] ]++ ] = static_cast<uint32_t>( i );
+      for ( auto i : sorted_idx )
+        sampleOne( i, bins[i] );
+    }
+    return;
+  }
+}
@@ -21,6 +21,7 @@
 #include "NCrystal/internal/NCSABSamplerModels.hh"
 #include "NCrystal/internal/NCSABUtils.hh"
 #include "NCrystal/internal/NCString.hh"
+#include "NCrystal/internal/NCCounters.hh"
 namespace NC = NCrystal;
 
 NC::SAB::SABSamplerAtE_Alg1::SABSamplerAtE_Alg1( std::shared_ptr<const CommonCache> common,
@@ -42,6 +43,27 @@ NC::SAB::SABSamplerAtE_Alg1::SABSamplerAtE_Alg1( std::shared_ptr<const CommonCac
   nc_assert( ibetaOffset+betaVals.size() == m_common->data->betaGrid().size()+1 );
 }
 
+NC::SAB::SABSamplerAtE_Alg1::SABSamplerAtE_Alg1( std::shared_ptr<const CommonCache> common,
+                                                 PointwiseDist&& betaSampler,
+                                                 std::vector<AlphaSampleInfo>&& alphaSamplerInfos,
+                                                 std::size_t ibetaOffset )
+  : m_common( std::move(common) ),
+    m_betaSampler( std::move(betaSampler) ),
+    m_alphaSamplerInfos( std::move(alphaSamplerInfos) ),
+    m_ibetaOffset( ibetaOffset )
+{
+  nc_assert_always( !!m_common );
+  nc_assert_always( m_alphaSamplerInfos.size()+1 == m_betaSampler.getXVals().size() );
+  nc_assert_always( ibetaOffset+m_betaSampler.getXVals().size() == m_common->data->betaGrid().size()+1 );
+}
+
+std::size_t NC::SAB::SABSamplerAtE_Alg1::approxMemoryUsage() const
+{
+  //NB: The shared m_common object is accounted by its own factory.
+  return sizeof(*this) + m_alphaSamplerInfos.size() * sizeof(AlphaSampleInfo)
+    + m_betaSampler.approxMemoryUsage();
+}
+
 NC::PairDD NC::SAB::SABSamplerAtE_Alg1::sampleAlphaBeta(double ekin_div_kT, RNG&rng) const
 {
   nc_assert(!!m_common);
@@ -56,8 +78,10 @@ NC::PairDD NC::SAB::SABSamplerAtE_Alg1::sampleAlphaBeta(double ekin_div_kT, RNG&
                                       auto envstr = getenv("NCRYSTAL_SABSAMPLE_LOOPMAX");
                                       return envstr ? str2int(envstr) : 100;
                                     }();
+  NCRYSTAL_COUNT(SABAlg1Samples);
   unsigned iloopmax(s_loopmax+1);
   while (--iloopmax) {
+    NCRYSTAL_COUNT(SABAlg1Iterations);
     double beta;
     unsigned ibetaSampled;
     std::tie(beta,ibetaSampled) = m_betaSampler.sampleWithIndex( rng );
@@ -129,78 +153,221 @@ double NC::SAB::SABSamplerAtE_Alg1::sampleBeta(RNG& rng) const
 double NC::SAB::SABSamplerAtE_Alg1::sampleAlpha(std::size_t ibeta, double rand_percentile) const
 {
   nc_assert( ibeta >= m_ibetaOffset );
-  const auto& info = vectAt(m_alphaSamplerInfos,ibeta-m_ibetaOffset);
-
-  const auto& cd = m_common->data;
-  auto nalpha = cd->alphaGrid().size();
-  auto cumul = SABUtils::sliceSABAtBetaIdx_const(m_common->alphaintegrals_cumul,nalpha,ibeta);
-  auto sab = SABUtils::sliceSABAtBetaIdx_const(cd->sab(),nalpha,ibeta);
-  auto logsab = SABUtils::sliceSABAtBetaIdx_const(m_common->logsab,nalpha,ibeta);
-  auto clampRandNum = [](double r) { return ncclamp( r, std::numeric_limits<double>::min(), 1.0 ); };//ensure r is in (0,1]
-  auto clampUnitInterval = [](double r) { return ncclamp( r, 0.0, 1.0 ); };//ensure r is in [0,1]
-
-  if ( rand_percentile <= info.prob_front) {
-    if ( info.prob_front == 2.0) {
-      //special value indicating 0 cross-section at value, sample linearly in
-      //[pt_front.alpha,pt_back.alpha] for lack of better options..
-      double da = info.pt_back.alpha-info.pt_front.alpha;
-      nc_assert(da>=0.0);
-      return info.pt_front.alpha + rand_percentile*da;
-    } else if ( info.prob_front == 1.0) {
-      //Valid alpha range is narrow and contained within a single bin.
-      return SABUtils::sampleLogLinDist_fast( info.pt_front.alpha, info.pt_front.sval,
-                                              info.pt_back.alpha, info.pt_back.sval,
-                                              rand_percentile,
-                                              info.pt_front.logsval, info.pt_back.logsval );
-    } else {
-      //Sample front tail
-      double percentile2 = clampRandNum( rand_percentile / info.prob_front );
-      return SABUtils::sampleLogLinDist_fast( info.pt_front.alpha, info.pt_front.sval,
-                                              vectAt(cd->alphaGrid(),info.pt_front.alpha_idx), sab[info.pt_front.alpha_idx],
-                                              percentile2,
-                                              info.pt_front.logsval, logsab[info.pt_front.alpha_idx] );
+  return sampleAlphaAtRow( *m_common, vectAt(m_alphaSamplerInfos,ibeta-m_ibetaOffset), ibeta, rand_percentile );
+}
+
+namespace NCrystal {
+  namespace SAB {
+    namespace {
+      template<class TTable>
+      double sampleAlphaAtRowImpl( const SABSamplerAtE_Alg1::CommonCache& common,
+                                   Span<const TTable> all_cumul,
+                                   Span<const TTable> all_logsab,
+                                   const SABSamplerAtE_Alg1::AlphaSampleInfo& info,
+                                   std::size_t ibeta,
+                                   double rand_percentile )
+      {
+        //Templated on the storage type of the logsab and alphaintegrals_cumul
+        //tables. All calculations are carried out in double precision.
+        const auto& cd = common.data;
+        auto nalpha = cd->alphaGrid().size();
+        nc_assert( (ibeta+1) * nalpha <= static_cast<std::size_t>(all_cumul.size()) );
+        nc_assert( all_cumul.size() == all_logsab.size() );
+        auto cumul = Span<const TTable>( all_cumul.data() + ibeta*nalpha, all_cumul.data() + (ibeta+1)*nalpha );
+        auto sab = SABUtils::sliceSABAtBetaIdx_const(cd->sab(),nalpha,ibeta);
+        auto logsab = Span<const TTable>( all_logsab.data() + ibeta*nalpha, all_logsab.data() + (ibeta+1)*nalpha );
+        auto clampRandNum = [](double r) { return ncclamp( r, std::numeric_limits<double>::min(), 1.0 ); };//ensure r is in (0,1]
+        auto clampUnitInterval = [](double r) { return ncclamp( r, 0.0, 1.0 ); };//ensure r is in [0,1]
+
+        if ( rand_percentile <= info.prob_front) {
+          if ( info.prob_front == 2.0) {
+            //special value indicating 0 cross-section at value, sample linearly in
+            //[pt_front.alpha,pt_back.alpha] for lack of better options..
+            double da = info.pt_back.alpha-info.pt_front.alpha;
+            nc_assert(da>=0.0);
+            return info.pt_front.alpha + rand_percentile*da;
+          } else if ( info.prob_front == 1.0) {
+            //Valid alpha range is narrow and contained within a single bin.
+            return SABUtils::sampleLogLinDist_fast( info.pt_front.alpha, info.pt_front.sval,
+                                                    info.pt_back.alpha, info.pt_back.sval,
+                                                    rand_percentile,
+                                                    info.pt_front.logsval, info.pt_back.logsval );
+          } else {
+            //Sample front tail
+            double percentile2 = clampRandNum( rand_percentile / info.prob_front );
+            return SABUtils::sampleLogLinDist_fast( info.pt_front.alpha, info.pt_front.sval,
+                                                    vectAt(cd->alphaGrid(),info.pt_front.alpha_idx), sab[info.pt_front.alpha_idx],
+                                                    percentile2,
+                                                    info.pt_front.logsval, logsab[info.pt_front.alpha_idx] );
+          }
+        } else if ( rand_percentile <= info.prob_notback ) {
+          //Middle section - sample over entire alpha bins.
+          nc_assert( info.prob_notback - info.prob_front > 0.0 );
+          double percentile2 = clampUnitInterval( ( rand_percentile - info.prob_front ) / ( info.prob_notback - info.prob_front ) );
+          unsigned alphaidx_low(info.pt_front.alpha_idx), alphaidx_upp(info.pt_back.alpha_idx);
+          auto itCumul_low = std::next(cumul.begin(),alphaidx_low);
+          auto itCumul_upp = std::next(cumul.begin(),alphaidx_upp);
+          nc_assert( itCumul_upp > itCumul_low && itCumul_upp<cumul.end() );
+          const double cumul_low = *itCumul_low;
+          double selectedArea = cumul_low + percentile2 * ( double(*itCumul_upp) - cumul_low );
+          auto itCumul_selected_edgeupp = std::upper_bound(itCumul_low, std::next(itCumul_upp), selectedArea);
+          if ( itCumul_selected_edgeupp > itCumul_upp )
+            return vectAt( cd->alphaGrid(), alphaidx_upp );
+          if ( itCumul_selected_edgeupp <= itCumul_low )
+            return vectAt( cd->alphaGrid(), alphaidx_low );
+
+          nc_assert(itCumul_selected_edgeupp>itCumul_low);
+          auto itCumul_selected_edgelow = std::prev(itCumul_selected_edgeupp);
+          const double cumul_edgelow = *itCumul_selected_edgelow;
+          nc_assert( cumul_edgelow <= selectedArea );
+          nc_assert( double(*itCumul_selected_edgeupp) >= selectedArea );
+          double binArea = double(*itCumul_selected_edgeupp) - cumul_edgelow;
+          nc_assert( binArea > 0.0);
+          //rescale leftover parts of rand_percentile back to the unit interval:
+          double rand_rescaled = clampRandNum((selectedArea-cumul_edgelow)/binArea);
+          nc_assert( rand_rescaled >= 0.0 );
+          nc_assert( rand_rescaled <= 1.0 );
+          auto a0 = itCumul_selected_edgelow - cumul.begin();
+          auto a1 = a0 + 1;
+          //Interpolate in selected bin for alpha value:
+          return SABUtils::sampleLogLinDist_fast( vectAt(cd->alphaGrid(),a0), sab[a0],
+                                                  vectAt(cd->alphaGrid(),a1), sab[a1],
+                                                  rand_rescaled,
+                                                  logsab[a0], logsab[a1] );
+        } else {
+          //Sample back tail
+          nc_assert( 1.0 - info.prob_notback > 0.0 );
+          double percentile2 = clampRandNum ( ( rand_percentile - info.prob_notback ) / ( 1.0 - info.prob_notback ) );
+          return SABUtils::sampleLogLinDist_fast( vectAt(cd->alphaGrid(),info.pt_back.alpha_idx), sab[info.pt_back.alpha_idx],
+                                                  info.pt_back.alpha, info.pt_back.sval,
+                                                  percentile2,
+                                                  logsab[info.pt_back.alpha_idx], info.pt_back.logsval );
+
+        }
+
+      }
     }
-  } else if ( rand_percentile <= info.prob_notback ) {
-    //Middle section - sample over entire alpha bins.
-    nc_assert( info.prob_notback - info.prob_front > 0.0 );
-    double percentile2 = clampUnitInterval( ( rand_percentile - info.prob_front ) / ( info.prob_notback - info.prob_front ) );
-    unsigned alphaidx_low(info.pt_front.alpha_idx), alphaidx_upp(info.pt_back.alpha_idx);
-    auto itCumul_low = std::next(cumul.begin(),alphaidx_low);
-    auto itCumul_upp = std::next(cumul.begin(),alphaidx_upp);
-    nc_assert( itCumul_upp > itCumul_low && itCumul_upp<cumul.end() );
-    double selectedArea = *itCumul_low + percentile2 * ( *itCumul_upp - *itCumul_low );
-    auto itCumul_selected_edgeupp = std::upper_bound(itCumul_low, std::next(itCumul_upp), selectedArea);
-    if ( itCumul_selected_edgeupp > itCumul_upp )
-      return vectAt( cd->alphaGrid(), alphaidx_upp );
-    if ( itCumul_selected_edgeupp <= itCumul_low )
-      return vectAt( cd->alphaGrid(), alphaidx_low );
-
-    nc_assert(itCumul_selected_edgeupp>itCumul_low);
-    auto itCumul_selected_edgelow = std::prev(itCumul_selected_edgeupp);
-    nc_assert( *itCumul_selected_edgelow <= selectedArea );
-    nc_assert( *itCumul_selected_edgeupp >= selectedArea );
-    double binArea = *itCumul_selected_edgeupp - *itCumul_selected_edgelow;
-    nc_assert( binArea > 0.0);
-    //rescale leftover parts of rand_percentile back to the unit interval:
-    double rand_rescaled = clampRandNum((selectedArea-*itCumul_selected_edgelow)/binArea);
-    nc_assert( rand_rescaled >= 0.0 );
-    nc_assert( rand_rescaled <= 1.0 );
-    auto a0 = itCumul_selected_edgelow - cumul.begin();
-    auto a1 = a0 + 1;
-    //Interpolate in selected bin for alpha value:
-    return SABUtils::sampleLogLinDist_fast( vectAt(cd->alphaGrid(),a0), sab[a0],
-                                            vectAt(cd->alphaGrid(),a1), sab[a1],
-                                            rand_rescaled,
-                                            logsab[a0], logsab[a1] );
-  } else {
-    //Sample back tail
-    nc_assert( 1.0 - info.prob_notback > 0.0 );
-    double percentile2 = clampRandNum ( ( rand_percentile - info.prob_notback ) / ( 1.0 - info.prob_notback ) );
-    return SABUtils::sampleLogLinDist_fast( vectAt(cd->alphaGrid(),info.pt_back.alpha_idx), sab[info.pt_back.alpha_idx],
-                                            info.pt_back.alpha, info.pt_back.sval,
-                                            percentile2,
-                                            logsab[info.pt_back.alpha_idx], info.pt_back.logsval );
+  }
+}
+
+double NC::SAB::SABSamplerAtE_Alg1::sampleAlphaAtRow( const CommonCache& common,
+                                                       const AlphaSampleInfo& info,
+                                                       std::size_t ibeta,
+                                                       double rand_percentile )
+{
+  if ( common.isSinglePrecision() )
+    return sampleAlphaAtRowImpl<float>( common, common.alphaintegrals_cumul_f32, common.logsab_f32,
+                                        info, ibeta, rand_percentile );
+  return sampleAlphaAtRowImpl<double>( common, common.alphaintegrals_cumul, common.logsab,
+                                       info, ibeta, rand_percentile );
+}
 
+NC::SAB::SABSamplerAtE_Alias::SABSamplerAtE_Alias( std::shared_ptr<const CommonCache> common,
+                                                   double ei_div_kT,
+                                                   VectD&& betaVals,
+                                                   const VectD& betaWeights,
+                                                   std::vector<AlphaSampleInfo>&& alphaSamplerInfos,
+                                                   std::size_t ibetaOffset )
+  : m_common( std::move(common) ),
+    m_eiDivKT( ei_div_kT ),
+    m_betaVals( std::move(betaVals) ),
+    m_alphaSamplerInfos( std::move(alphaSamplerInfos) ),
+    m_ibetaOffset( ibetaOffset )
+{
+  nc_assert_always( !!m_common );
+  nc_assert_always( betaWeights.size() == m_betaVals.size() );
+  nc_assert_always( m_betaVals.size() >= 2 );
+  //+1 since vals,weights starts with (beta_lower,0.0):
+  nc_assert_always( m_alphaSamplerInfos.size()+1 == m_betaVals.size() );
+  nc_assert_always( ibetaOffset+m_betaVals.size() == m_common->data->betaGrid().size()+1 );
+
+  //The trapezoidal area of bin j, 0.5*(b[j+1]-b[j])*(w[j]+w[j+1]), is split
+  //into components 2j (density falling linearly from w[j] at b[j] to 0 at
+  //b[j+1]) and 2j+1 (rising linearly from 0 at b[j] to w[j+1] at b[j+1]):
+  const std::size_t nbins = m_betaVals.size() - 1;
+  VectD compweights;
+  compweights.reserve( 2 * nbins );
+  for ( std::size_t j = 0; j < nbins; ++j ) {
+    const double db = m_betaVals[j+1] - m_betaVals[j];
+    nc_assert_always( db >= 0.0 );
+    compweights.push_back( 0.5 * db * betaWeights[j] );
+    compweights.push_back( 0.5 * db * betaWeights[j+1] );
   }
+  m_componentSampler = RandAliasSampler( compweights );
+}
+
+NC::SAB::SABSamplerAtE_Alias::SABSamplerAtE_Alias( std::shared_ptr<const CommonCache> common,
+                                                   double ei_div_kT,
+                                                   VectD&& betaVals,
+                                                   RandAliasSampler&& componentSampler,
+                                                   std::vector<AlphaSampleInfo>&& alphaSamplerInfos,
+                                                   std::size_t ibetaOffset )
+  : m_common( std::move(common) ),
+    m_eiDivKT( ei_div_kT ),
+    m_betaVals( std::move(betaVals) ),
+    m_componentSampler( std::move(componentSampler) ),
+    m_alphaSamplerInfos( std::move(alphaSamplerInfos) ),
+    m_ibetaOffset( ibetaOffset )
+{
+  nc_assert_always( !!m_common );
+  nc_assert_always( m_betaVals.size() >= 2 );
+  nc_assert_always( m_componentSampler.size() == 2 * ( m_betaVals.size() - 1 ) );
+  nc_assert_always( m_alphaSamplerInfos.size()+1 == m_betaVals.size() );
+  nc_assert_always( ibetaOffset+m_betaVals.size() == m_common->data->betaGrid().size()+1 );
+}
+
+NC::PairDD NC::SAB::SABSamplerAtE_Alias::alphaRangeAtEi( double beta ) const
+{
+  //Alpha range at Ei, constrained to the grid (where S is modelled as 0
+  //outside) unless this would leave nothing:
+  const auto& alphaGrid = m_common->data->alphaGrid();
+  auto alim = getAlphaLimits( m_eiDivKT, beta );
+  const double a0 = ncclamp( alim.first, alphaGrid.front(), alphaGrid.back() );
+  const double a1 = ncclamp( alim.second, alphaGrid.front(), alphaGrid.back() );
+  return a1 > a0 ? PairDD(a0,a1) : alim;
+}
+
+std::size_t NC::SAB::SABSamplerAtE_Alias::approxMemoryUsage() const
+{
+  //NB: The shared m_common object is accounted by its own factory.
+  return sizeof(*this) + m_alphaSamplerInfos.size() * sizeof(AlphaSampleInfo)
+    + m_betaVals.size() * sizeof(double)
+    + m_componentSampler.internalProbs().size() * sizeof(double)
+    + m_componentSampler.internalAliases().size() * sizeof(uint32_t);
+}
+
+NC::PairDD NC::SAB::SABSamplerAtE_Alias::sampleAlphaBeta(double, RNG&rng) const
+{
+  //NB: The ekin_div_kT argument is ignored, since the returned points are
+  //always sampled at Ei (see class description).
+
+  //Select bin edge component and sample beta linearly inside the bin:
+  const std::size_t icomp = m_componentSampler.sample( rng );
+  const std::size_t jbin = icomp / 2;
+  const bool upperEdge = ( icomp % 2 ) == 1;
+  nc_assert( jbin + 1 < m_betaVals.size() );
+  const double b0 = m_betaVals[jbin];
+  const double b1 = m_betaVals[jbin+1];
+  const double r = std::sqrt( rng.generate() );
+  const double beta = ncclamp( upperEdge ? b0 + ( b1 - b0 ) * r : b1 - ( b1 - b0 ) * r, b0, b1 );
+
+  //Sample alpha in the grid row at the chosen bin edge. Entry 0 of
+  //m_betaVals is the lower beta limit with vanishing weight, so the row has
+  //index k>=1 in m_betaVals:
+  const std::size_t k = jbin + ( upperEdge ? 1 : 0 );
+  nc_assert( k >= 1 && k < m_betaVals.size() );
+  const double alpha_row = SABSamplerAtE_Alg1::sampleAlphaAtRow( *m_common, vectAt(m_alphaSamplerInfos,k-1),
+                                                                 m_ibetaOffset + k - 1, rng.generate() );
+
+  //Map linearly from the alpha range of the row onto that at the sampled beta:
+  const auto range_row = alphaRangeAtEi( m_betaVals[k] );
+  const auto range_beta = alphaRangeAtEi( beta );
+  const double drow = range_row.second - range_row.first;
+  const double t = ( drow > 0.0 ? ncclamp( ( alpha_row - range_row.first ) / drow, 0.0, 1.0 ) : 0.5 );
+  double alpha = range_beta.first + t * ( range_beta.second - range_beta.first );
 
+  //Guard against numerical issues for the final result:
+  auto alim = getAlphaLimits( m_eiDivKT, beta );
+  alpha = ncclamp( alpha, alim.first, alim.second );
+  return { alpha, beta };
 }
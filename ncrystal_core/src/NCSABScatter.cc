@@ -26,9 +26,146 @@
 #include "NCrystal/internal/NCVDOSToScatKnl.hh"
 namespace NC = NCrystal;
 
+namespace NCrystal {
+  namespace {
+    class SABScatterCache final : public CacheBase {
+    public:
+      void invalidateCache() override { egridIndex = nullptr; }
+      //Energy grid bin found at the most recent cross section evaluation. Since
+      //the sampler normally shares the EGridIndex of the xsprovider, the bin
+      //can be reused when the same neutron is subsequently scattered:
+      const SAB::EGridIndex * egridIndex = nullptr;
+      double ekin = -1.0;
+      std::size_t ibin = 0;
+    };
+  }
+}
+
+class NC::SABScatter::MergedKernels : private NoCopyMove {
+public:
+  struct Kernel {
+    double weight;
+    shared_obj<const SAB::SABScatterHelper> sh;
+  };
+  using KernelList = SmallVector<Kernel,8>;
+
+  MergedKernels( KernelList&& kernels )
+    : m_kernels( std::move(kernels) )
+  {
+    nc_assert_always( m_kernels.size() >= 2 );
+    //Cross sections of each kernel are linearly interpolated between its
+    //energy grid points, so the weighted sum is exactly represented by linear
+    //interpolation on the union of the grids (inside the range covered by all
+    //of them):
+    double elow = 0.0;
+    double ehigh = kInfinity;
+    for ( auto& k : m_kernels ) {
+      const auto& eg = k.sh->xsprovider.internalEGrid();
+      elow = ncmax( elow, eg.front() );
+      ehigh = ncmin( ehigh, eg.back() );
+    }
+    if ( !( elow < ehigh ) )
+      return;
+    for ( auto& k : m_kernels ) {
+      const auto& eg = k.sh->xsprovider.internalEGrid();
+      for ( auto e : eg )
+        if ( e >= elow && e <= ehigh )
+          m_egrid.push_back( e );
+    }
+    std::sort( m_egrid.begin(), m_egrid.end() );
+    m_egrid.erase( std::unique( m_egrid.begin(), m_egrid.end() ), m_egrid.end() );
+    m_egrid.shrink_to_fit();
+    m_commul.reserve( m_egrid.size() * m_kernels.size() );
+    for ( auto e : m_egrid ) {
+      double sum = 0.0;
+      for ( auto& k : m_kernels )
+        m_commul.push_back( sum += k.weight * k.sh->xsprovider.crossSection( NeutronEnergy{ e } ).dbl() );
+    }
+  }
+
+  const KernelList& kernels() const { return m_kernels; }
+
+  //Fill out_commul (one entry per kernel) with cumulative weighted cross
+  //sections, returning the total:
+  double crossSections( NeutronEnergy ekin, double * out_commul ) const
+  {
+    const std::size_t n = m_kernels.size();
+    const double e = ekin.dbl();
+    if ( m_egrid.empty() || !( e >= m_egrid.front() && e <= m_egrid.back() ) ) {
+      double sum = 0.0;
+      for ( std::size_t i = 0; i < n; ++i )
+        out_commul[i] = ( sum += m_kernels[i].weight * m_kernels[i].sh->xsprovider.crossSection( ekin ).dbl() );
+      return sum;
+    }
+    const double * a;
+    const double * b;
+    const double t = locate( e, a, b );
+    for ( std::size_t i = 0; i < n; ++i )
+      out_commul[i] = a[i] + t * ( b[i] - a[i] );
+    return out_commul[n-1];
+  }
+
+  double totalCrossSection( NeutronEnergy ekin ) const
+  {
+    const double e = ekin.dbl();
+    if ( m_egrid.empty() || !( e >= m_egrid.front() && e <= m_egrid.back() ) ) {
+      double sum = 0.0;
+      for ( auto& k : m_kernels )
+        sum += k.weight * k.sh->xsprovider.crossSection( ekin ).dbl();
+      return sum;
+    }
+    const double * a;
+    const double * b;
+    const double t = locate( e, a, b );
+    const std::size_t i = m_kernels.size() - 1;
+    return a[i] + t * ( b[i] - a[i] );
+  }
+
+  void accountMemory( MemoryFootprint& mf ) const
+  {
+    mf.add( sizeof(MergedKernels) + ( m_egrid.size() + m_commul.size() ) * sizeof(double) );
+    for ( auto& k : m_kernels )
+      mf.addSharedObject( k.sh );
+  }
+
+private:
+  KernelList m_kernels;
+  VectD m_egrid;
+  VectD m_commul;//cumulative weighted cross sections, one entry per kernel for each grid point
+
+  double locate( double e, const double *& a, const double *& b ) const
+  {
+    nc_assert( m_egrid.size() >= 2 );
+    std::size_t ib = std::upper_bound( m_egrid.begin(), m_egrid.end(), e ) - m_egrid.begin();
+    ib = std::max<std::size_t>( 1, std::min<std::size_t>( ib, m_egrid.size() - 1 ) );
+    const std::size_t n = m_kernels.size();
+    a = &m_commul[ ( ib - 1 ) * n ];
+    b = &m_commul[ ib * n ];
+    return ( e - m_egrid[ib-1] ) / ( m_egrid[ib] - m_egrid[ib-1] );
+  }
+};
+
 struct NC::SABScatter::Impl {
-  Impl(shared_obj<const SAB::SABScatterHelper> sp) : m_scathelper_shptr(std::move(sp)) {}
-  shared_obj<const SAB::SABScatterHelper> m_scathelper_shptr;
+  Impl(shared_obj<const SAB::SABScatterHelper> sp) : m_scathelper_shptr(sp.getsp()) {}
+  Impl(shared_obj<const MergedKernels> mk) : m_merged(mk.getsp()) {}
+  std::shared_ptr<const SAB::SABScatterHelper> m_scathelper_shptr;//not for merged instances
+  std::shared_ptr<const MergedKernels> m_merged;//only for merged instances
+
+  PairDD sampleDeltaEMuMerged( NeutronEnergy ekin, RNG& rng ) const
+  {
+    nc_assert( m_merged != nullptr );
+    const auto& kernels = m_merged->kernels();
+    SmallVector<double,8> commul;
+    commul.resize_uninitialized( kernels.size() );//filled by crossSections
+    const double xstot = m_merged->crossSections( ekin, commul.data() );
+    std::size_t idx = 0;
+    if ( xstot > 0.0 ) {
+      const double r = rng.generate() * xstot;
+      idx = std::upper_bound( commul.begin(), commul.end(), r ) - commul.begin();
+      idx = ncmin( idx, kernels.size() - 1 );
+    }
+    return kernels[idx].sh->sampler.sampleDeltaEMu( ekin, rng );
+  }
 };
 
 NC::SABScatter::~SABScatter() = default;
@@ -36,7 +173,57 @@ NC::SABScatter::~SABScatter() = default;
 NC::SABScatter::SABScatter( shared_obj<const NC::SAB::SABScatterHelper> sh )
   : m_impl(std::move(sh)), m_sh(m_impl->m_scathelper_shptr.get())
 {
-  //All other constructors delegate to this one.
+  //All other public constructors delegate to this one.
+}
+
+NC::SABScatter::SABScatter( merged_t, shared_obj<const MergedKernels> mk )
+  : m_impl(std::move(mk)), m_sh(nullptr)
+{
+}
+
+std::shared_ptr<NC::ProcImpl::Process> NC::SABScatter::createMerged( const Process& o ) const
+{
+  return createMergedScaled( o, 1.0, 1.0 );
+}
+
+std::shared_ptr<NC::ProcImpl::Process> NC::SABScatter::createMergedScaled( const Process& oraw,
+                                                                           double scale_this,
+                                                                           double scale_other ) const
+{
+  auto optr = dynamic_cast<const SABScatter*>(&oraw);
+  if ( !optr || !(scale_this>0.0) || !(scale_other>0.0) )
+    return nullptr;
+  MergedKernels::KernelList kernels;
+  auto addKernel = [&kernels]( double weight, const shared_obj<const SAB::SABScatterHelper>& sh )
+  {
+    for ( auto& k : kernels ) {
+      if ( k.sh.get() == sh.get() ) {
+        k.weight += weight;
+        return;
+      }
+    }
+    kernels.push_back( MergedKernels::Kernel{ weight, sh } );
+  };
+  auto addProcess = [&addKernel]( const SABScatter& p, double scale )
+  {
+    if ( p.m_sh ) {
+      addKernel( scale, shared_obj<const SAB::SABScatterHelper>( p.m_impl->m_scathelper_shptr ) );
+    } else {
+      for ( auto& k : p.m_impl->m_merged->kernels() )
+        addKernel( scale * k.weight, k.sh );
+    }
+  };
+  addProcess( *this, scale_this );
+  addProcess( *optr, scale_other );
+  if ( kernels.size() < 2 )
+    return nullptr;//same kernel, nothing to gain
+  return std::shared_ptr<SABScatter>( new SABScatter( merged_t(),
+                                                      makeSO<const MergedKernels>( std::move(kernels) ) ) );
+}
+
+double NC::SABScatter::mergedCrossSection( NeutronEnergy ekin ) const
+{
+  return m_impl->m_merged->totalCrossSection( ekin );
 }
 
 NC::SABScatter::SABScatter( std::unique_ptr<const NC::SAB::SABScatterHelper> upsh )
@@ -49,16 +236,25 @@ NC::SABScatter::SABScatter( NC::SAB::SABScatterHelper&& sh )
 {
 }
 
-NC::SABScatter::SABScatter( const DI_ScatKnl& di_sk, unsigned vdoslux, bool useCache )
-  : SABScatter( [&di_sk,vdoslux,useCache]()
+NC::SABScatter::SABScatter( const DI_ScatKnl& di_sk, unsigned vdoslux, bool useCache,
+                            bool useAliasSampler, double vdosthintol,
+                            bool singlePrecisionTables )
+  : SABScatter( [&di_sk,vdoslux,useCache,useAliasSampler,vdosthintol,singlePrecisionTables]()
                 {
-                  auto sabdata_ptr = extractSABDataFromDynInfo(&di_sk,vdoslux,useCache);
+                  auto sabdata_ptr = extractSABDataFromDynInfo(&di_sk,vdoslux,useCache,vdosthintol);
                   nc_assert_always(!!sabdata_ptr);
+                  const auto samplerType = ( useAliasSampler
+                                             ? SAB::SamplerAtEType::AliasTable
+                                             : SAB::SamplerAtEType::Alg1 );
                   return ( useCache
                            ? SAB::createScatterHelperWithCache( std::move(sabdata_ptr),
-                                                                di_sk.energyGrid() )
+                                                                di_sk.energyGrid(),
+                                                                samplerType,
+                                                                singlePrecisionTables )
                            : SAB::createScatterHelper( std::move(sabdata_ptr),
-                                                       di_sk.energyGrid() ) );
+                                                       di_sk.energyGrid(),
+                                                       samplerType,
+                                                       singlePrecisionTables ) );
                 }() )
 {
 }
@@ -83,15 +279,232 @@ NC::SABScatter::SABScatter( shared_obj<const SABData> sabdata_shptr,
 {
 }
 
-NC::CrossSect NC::SABScatter::crossSectionIsotropic( CachePtr&, NeutronEnergy ekin ) const
+NC::CrossSect NC::SABScatter::crossSectionIsotropic( CachePtr& cp, NeutronEnergy ekin ) const
+{
+  if ( !m_sh )
+    return CrossSect{ mergedCrossSection(ekin) };
+  auto& cache = accessCache<SABScatterCache>(cp);
+  cache.egridIndex = &m_sh->xsprovider.egridIndex();
+  cache.ekin = ekin.dbl();
+  cache.ibin = m_sh->xsprovider.gridBin(ekin);
+  return m_sh->xsprovider.crossSectionInBin( ekin, cache.ibin );
+}
+
+NC::CrossSect NC::SABScatter::majorantCrossSection( EnergyDomain d ) const
+{
+  if ( !m_sh ) {
+    //Weighted sum of majorants is a majorant of the weighted sum:
+    double xs = 0.0;
+    for ( auto& k : m_impl->m_merged->kernels() )
+      xs += k.weight * k.sh->xsprovider.majorantCrossSection( d ).get();
+    return CrossSect{ xs };
+  }
+  return m_sh->xsprovider.majorantCrossSection( d );
+}
+
+void NC::SABScatter::accountMemory( MemoryFootprint& mf ) const
 {
-  return CrossSect{ m_sh->xsprovider.crossSection(ekin) };
+  mf.add( sizeof(SABScatter) + sizeof(Impl) );
+  if ( m_sh )
+    mf.addSharedObject( m_impl->m_scathelper_shptr );
+  else
+    mf.addSharedObject( m_impl->m_merged );
 }
 
-NC::ScatterOutcomeIsotropic NC::SABScatter::sampleScatterIsotropic( CachePtr&, RNG& rng, NeutronEnergy ekin ) const
+void NC::SABScatter::addXSGridEnergies( VectD& v ) const
+{
+  auto add = [&v]( const SAB::SABScatterHelper& sh )
+  {
+    const auto& eg = sh.xsprovider.internalEGrid();
+    v.insert( v.end(), eg.begin(), eg.end() );
+  };
+  if ( m_sh ) {
+    add( *m_sh );
+    return;
+  }
+  for ( auto& k : m_impl->m_merged->kernels() )
+    add( *k.sh );
+}
+
+void NC::SABScatter::evalManyXSIsotropic( CachePtr&, const double* ekin, std::size_t N,
+                                         double* out_xs ) const
+{
+  if ( !m_sh ) {
+    for ( std::size_t i = 0; i < N; ++i )
+      out_xs[i] = mergedCrossSection( NeutronEnergy{ ekin[i] } );
+    return;
+  }
+  m_sh->xsprovider.evalManyXS( ekin, N, out_xs );
+}
+
+NC::ScatterOutcomeIsotropic NC::SABScatter::sampleScatterIsotropic( CachePtr& cp, RNG& rng, NeutronEnergy ekin ) const
 {
   double delta_e, mu;
-  std::tie(delta_e,mu) = m_sh->sampler.sampleDeltaEMu(ekin, rng);
+  if ( m_sh ) {
+    auto& cache = accessCache<SABScatterCache>(cp);
+    const bool reuseBin = ( cache.egridIndex == &m_sh->sampler.egridIndex()
+                            && cache.ekin == ekin.dbl() );
+    const std::size_t ibin = reuseBin ? cache.ibin : m_sh->sampler.gridBin( ekin.dbl() );
+    std::tie(delta_e,mu) = m_sh->sampler.sampleDeltaEMuInBin( ekin, ibin, rng );
+  } else {
+    std::tie(delta_e,mu) = m_impl->sampleDeltaEMuMerged(ekin, rng);
+  }
   nc_assert( mu >= -1.0 && mu <= 1.0 );
   return { NeutronEnergy{ncmax(0.0,ekin.get()+delta_e)}, CosineScatAngle{mu} };
 }
+
+void NC::SABScatter::sampleScatterIsotropicMany( CachePtr&, RNG& rng, double* ekin, std::size_t N,
+                                                 double* out_mu ) const
+{
+  if ( !m_sh ) {
+    double delta_e, mu;
+    for ( std::size_t i = 0; i < N; ++i ) {
+      std::tie(delta_e,mu) = m_impl->sampleDeltaEMuMerged( NeutronEnergy{ekin[i]}, rng );
+      nc_assert( mu >= -1.0 && mu <= 1.0 );
+      ekin[i] = ncmax( 0.0, ekin[i] + delta_e );
+      out_mu[i] = mu;
+    }
+    return;
+  }
+  //Let the sampler process neutrons grouped by energy (taking advantage of
+  //any existing ordering):
+  const auto order = ( std::is_sorted( ekin, ekin + N )
+                       ? SABSampler::BatchOrder::Sorted
+                       : SABSampler::BatchOrder::SortInternally );
+  VectD deltae( N );
+  m_sh->sampler.sampleDeltaEMuMany( rng, ekin, N, deltae.data(), out_mu, order );
+  for ( std::size_t i = 0; i < N; ++i ) {
+    nc_assert( out_mu[i] >= -1.0 && out_mu[i] <= 1.0 );
+    ekin[i] = ncmax( 0.0, ekin[i] + deltae[i] );
+  }
+}
+
+NC::SABTInterpScatter::~SABTInterpScatter() = default;
+
+NC::SABTInterpScatter::SABTInterpScatter( shared_obj<const NC::SAB::SABScatterHelper> sh_lo,
+                                          shared_obj<const NC::SAB::SABScatterHelper> sh_hi,
+                                          double weight_hi )
+  : m_sh_lo(std::move(sh_lo)),
+    m_sh_hi(std::move(sh_hi)),
+    m_wlo(1.0-weight_hi),
+    m_whi(weight_hi)
+{
+  if ( !(weight_hi>0.0) || !(weight_hi<1.0) )
+    NCRYSTAL_THROW2(BadInput,"SABTInterpScatter: weight must be in the range (0,1) (got "<<weight_hi<<")");
+}
+
+NC::ProcImpl::ProcPtr NC::SABTInterpScatter::createOnTemperatureGrid( Temperature temperature,
+                                                                      double gridSpacing,
+                                                                      const HelperAtTemperatureFct& helperAtTemperature )
+{
+  temperature.validate();
+  if ( !(gridSpacing>0.0) || ncisinf(gridSpacing) )
+    NCRYSTAL_THROW2(BadInput,"SABTInterpScatter: invalid temperature grid spacing: "<<gridSpacing);
+  const double T = temperature.get();
+  const double k_lo = std::floor( T / gridSpacing );
+  const double T_lo = k_lo * gridSpacing;
+  const double T_hi = ( k_lo + 1.0 ) * gridSpacing;
+  //Snap to grid points when very close (to avoid useless interpolation when
+  //the temperature is specified with limited precision):
+  const double snaptol = 1e-9 * T;
+  if ( !(T_lo > 0.0) || T - T_lo <= snaptol )
+    return makeSO<SABScatter>( helperAtTemperature( T_lo > 0.0 ? Temperature{T_lo} : temperature ) );
+  if ( T_hi - T <= snaptol )
+    return makeSO<SABScatter>( helperAtTemperature( Temperature{T_hi} ) );
+  return makeSO<SABTInterpScatter>( helperAtTemperature( Temperature{T_lo} ),
+                                    helperAtTemperature( Temperature{T_hi} ),
+                                    ( T - T_lo ) / gridSpacing );
+}
+
+NC::ProcImpl::ProcPtr NC::SABTInterpScatter::createOnTemperatureGrid( const DI_ScatKnl& di_sk,
+                                                                      double gridSpacing,
+                                                                      unsigned vdoslux,
+                                                                      bool useAliasSampler,
+                                                                      double vdosthintol,
+                                                                      bool singlePrecisionTables )
+{
+  const auto samplerType = ( useAliasSampler
+                             ? SAB::SamplerAtEType::AliasTable
+                             : SAB::SamplerAtEType::Alg1 );
+  auto helperAtT = [&di_sk,vdoslux,vdosthintol,samplerType,singlePrecisionTables](Temperature t)
+  {
+    auto sabdata_ptr = extractSABDataFromDynInfoAtTemperature( &di_sk, t, vdoslux, true, vdosthintol );
+    nc_assert_always(!!sabdata_ptr);
+    return SAB::createScatterHelperWithCache( std::move(sabdata_ptr), di_sk.energyGrid(),
+                                              samplerType, singlePrecisionTables );
+  };
+  return createOnTemperatureGrid( di_sk.temperature(), gridSpacing, helperAtT );
+}
+
+NC::CrossSect NC::SABTInterpScatter::crossSectionIsotropic( CachePtr&, NeutronEnergy ekin ) const
+{
+  return CrossSect{ m_wlo * m_sh_lo->xsprovider.crossSection(ekin).get()
+                    + m_whi * m_sh_hi->xsprovider.crossSection(ekin).get() };
+}
+
+NC::CrossSect NC::SABTInterpScatter::majorantCrossSection( EnergyDomain d ) const
+{
+  //Weighted sum of majorants is a majorant of the weighted sum:
+  return CrossSect{ m_wlo * m_sh_lo->xsprovider.majorantCrossSection( d ).get()
+                    + m_whi * m_sh_hi->xsprovider.majorantCrossSection( d ).get() };
+}
+
+void NC::SABTInterpScatter::accountMemory( MemoryFootprint& mf ) const
+{
+  mf.add( sizeof(SABTInterpScatter) );
+  mf.addSharedObject( m_sh_lo );
+  mf.addSharedObject( m_sh_hi );
+}
+
+void NC::SABTInterpScatter::addXSGridEnergies( VectD& v ) const
+{
+  for ( auto& sh : { m_sh_lo.get(), m_sh_hi.get() } ) {
+    const auto& eg = sh->xsprovider.internalEGrid();
+    v.insert( v.end(), eg.begin(), eg.end() );
+  }
+}
+
+void NC::SABTInterpScatter::evalManyXSIsotropic( CachePtr&, const double* ekin, std::size_t N,
+                                                double* out_xs ) const
+{
+  constexpr std::size_t nchunk = 256;
+  double buf[nchunk];
+  while ( N ) {
+    const std::size_t n = ( N < nchunk ? N : nchunk );
+    m_sh_lo->xsprovider.evalManyXS( ekin, n, out_xs );
+    m_sh_hi->xsprovider.evalManyXS( ekin, n, buf );
+    for ( std::size_t i = 0; i < n; ++i )
+      out_xs[i] = m_wlo * out_xs[i] + m_whi * buf[i];
+    ekin += n;
+    out_xs += n;
+    N -= n;
+  }
+}
+
+NC::PairDD NC::SABTInterpScatter::sampleDeltaEMu( RNG& rng, NeutronEnergy ekin ) const
+{
+  const double xs_lo = m_wlo * m_sh_lo->xsprovider.crossSection(ekin).get();
+  const double xs_hi = m_whi * m_sh_hi->xsprovider.crossSection(ekin).get();
+  const bool pick_hi = ( xs_hi > 0.0 && rng.generate() * ( xs_lo + xs_hi ) >= xs_lo );
+  return ( pick_hi ? m_sh_hi : m_sh_lo )->sampler.sampleDeltaEMu( ekin, rng );
+}
+
+NC::ScatterOutcomeIsotropic NC::SABTInterpScatter::sampleScatterIsotropic( CachePtr&, RNG& rng, NeutronEnergy ekin ) const
+{
+  double delta_e, mu;
+  std::tie(delta_e,mu) = sampleDeltaEMu( rng, ekin );
+  nc_assert( mu >= -1.0 && mu <= 1.0 );
+  return { NeutronEnergy{ncmax(0.0,ekin.get()+delta_e)}, CosineScatAngle{mu} };
+}
+
+void NC::SABTInterpScatter::sampleScatterIsotropicMany( CachePtr&, RNG& rng, double* ekin, std::size_t N,
+                                                        double* out_mu ) const
+{
+  double delta_e, mu;
+  for ( std::size_t i = 0; i < N; ++i ) {
+    std::tie(delta_e,mu) = sampleDeltaEMu( rng, NeutronEnergy{ekin[i]} );
+    nc_assert( mu >= -1.0 && mu <= 1.0 );
+    ekin[i] = ncmax( 0.0, ekin[i] + delta_e );
+    out_mu[i] = mu;
+  }
+}
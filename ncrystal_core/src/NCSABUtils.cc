@@ -21,6 +21,8 @@
 #include "NCrystal/internal/NCSABUtils.hh"
 #include "NCrystal/internal/NCIter.hh"
 #include "NCrystal/internal/NCString.hh"
+#include <cstring>
+#include <limits>
 namespace NC = NCrystal;
 
 NC::SABData NC::SABUtils::transformKernelToStdFormat( NC::ScatKnlData&& input )
@@ -499,3 +501,79 @@ NC::SABUtils::TailedBreakdown NC::SABUtils::createTailedBreakdown( const NC::Spa
                    : 0.0 );
   return tb;
 }
+
+namespace NCrystal {
+  namespace SABUtils {
+    namespace {
+      inline double logNoBranches( double x )
+      {
+        //Log of positive, finite and normal (i.e. not subnormal) x,
+        //implemented without branches so that loops calling it can be
+        //vectorised. Using the same approach as e.g. fdlibm, x is written as
+        //2^k*m with m in [sqrt(1/2),sqrt(2)), after which log(m) is evaluated
+        //with the series 2*atanh(s)=log((1+s)/(1-s)), s=(m-1)/(m+1),
+        //|s|<0.172. Terms up to s^23 are included, which is enough to reach
+        //double precision.
+        static_assert(sizeof(double)==sizeof(uint64_t),"");
+        uint64_t bits;
+        std::memcpy(&bits,&x,sizeof(bits));
+        constexpr uint64_t bits_sqrthalf = 0x3fe6a09e667f3bcdULL;
+        const uint64_t bits_shifted = bits - bits_sqrthalf;
+        const int32_t k = static_cast<int32_t>( static_cast<int64_t>(bits_shifted) >> 52 );
+        const uint64_t bits_m = ( bits_shifted & 0x000fffffffffffffULL ) + bits_sqrthalf;
+        double m;
+        std::memcpy(&m,&bits_m,sizeof(m));
+        const double s = (m-1.0)/(m+1.0);
+        const double z = s*s;
+        const double p = 1.0+z*(1.0/3+z*(1.0/5+z*(1.0/7+z*(1.0/9+z*(1.0/11+z*(1.0/13+z*(1.0/15+z*(1.0/17
+                                                                                    +z*(1.0/19+z*(1.0/21+z*(1.0/23)))))))))));
+        constexpr double ln2_hi = 6.93147180369123816490e-01;//trailing zero bits, so k*ln2_hi is exact
+        constexpr double ln2_lo = 1.90821492927058770002e-10;
+        const double dk = static_cast<double>(k);
+        return dk*ln2_hi + ( 2.0*s*p + dk*ln2_lo );
+      }
+    }
+  }
+}
+
+void NC::SABUtils::calcLogSAB( Span<const double> sab, Span<double> out_logsab )
+{
+  nc_assert_always( sab.size() == out_logsab.size() );
+  const std::size_t n = static_cast<std::size_t>(sab.size());
+  const double * in = sab.data();
+  double * out = out_logsab.data();
+  for ( std::size_t i = 0; i < n; ++i ) {
+    nc_assert( in[i] >= 0.0 && !ncisinf(in[i]) );
+    out[i] = logNoBranches( in[i] );
+  }
+  //Fix up the (rare) zero or subnormal entries in a separate loop, to keep the
+  //loop above free of branches:
+  constexpr double smallest_normal = std::numeric_limits<double>::min();
+  for ( std::size_t i = 0; i < n; ++i ) {
+    if ( in[i] < smallest_normal )
+      out[i] = ( in[i] > 0.0 ? std::log( in[i] ) : -kInfinity );
+  }
+}
+
+void NC::SABUtils::integrateAlphaRow_fast( Span<const double> alphaspan, Span<const double> sabspan,
+                                           Span<const double> logsabspan, Span<double> out_cumul )
+{
+  const std::size_t n = static_cast<std::size_t>(alphaspan.size());
+  nc_assert_always( n>0 && static_cast<std::size_t>(sabspan.size()) == n
+                    && static_cast<std::size_t>(logsabspan.size()) == n
+                    && static_cast<std::size_t>(out_cumul.size()) == n );
+  const double * alpha = alphaspan.data();
+  const double * sab = sabspan.data();
+  const double * logsab = logsabspan.data();
+  double * out = out_cumul.data();
+
+  //NB: Evaluating all branches of integrateAlphaInterval_fast and selecting
+  //afterwards (to allow vectorisation) was found to not be faster than this
+  //simple loop, since the cost is dominated by the division in the analytical
+  //expression:
+  out[0] = 0.0;
+  double cumul = 0.0;
+  for ( std::size_t i = 1; i < n; ++i )
+    out[i] = ( cumul += integrateAlphaInterval_fast( alpha[i-1], sab[i-1], alpha[i], sab[i],
+                                                     logsab[i-1], logsab[i] ) );
+}
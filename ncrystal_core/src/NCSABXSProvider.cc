@@ -24,6 +24,12 @@ namespace NC = NCrystal;
 
 NC::SABXSProvider::~SABXSProvider() = default;
 
+std::size_t NC::SABXSProvider::approxMemoryUsage() const
+{
+  return sizeof(*this) + m_xs.size() * sizeof(double)
+    + ( m_egridIndex ? m_egridIndex->approxMemoryUsage() : 0 );
+}
+
 NC::SABXSProvider::SABXSProvider( VectD&& egrid,
                                   VectD&& xsvals,
                                   std::shared_ptr<const SAB::SABExtender> extender )
@@ -36,14 +42,24 @@ void NC::SABXSProvider::setData( VectD&& egrid,
                                  VectD&& xsvals,
                                  std::shared_ptr<const SAB::SABExtender> extender )
 {
-  m_egrid = std::move(egrid);
+  nc_assert_always(!egrid.empty());
+  setData( std::make_shared<const SAB::EGridIndex>( std::move(egrid) ),
+           std::move(xsvals), std::move(extender) );
+}
+
+void NC::SABXSProvider::setData( std::shared_ptr<const SAB::EGridIndex> egridIndex,
+                                 VectD&& xsvals,
+                                 std::shared_ptr<const SAB::SABExtender> extender )
+{
+  m_egridIndex = std::move(egridIndex);
   m_xs = std::move(xsvals);
   m_extender = std::move(extender);
   nc_assert_always(!!m_extender);
-  nc_assert_always(!m_egrid.empty());
+  nc_assert_always(!!m_egridIndex);
   nc_assert_always(!m_xs.empty());
+  nc_assert_always(m_xs.size()==m_egridIndex->grid().size());
 
-  const double emax = m_egrid.back();
+  const double emax = m_egridIndex->grid().back();
   const double extenderXS_emax = m_extender->crossSection(NeutronEnergy{emax}).dbl();
   const double tableXS_emax = m_xs.back();
   //constant needed for high-E extrapolation (see comments below where it is
@@ -51,19 +67,82 @@ void NC::SABXSProvider::setData( VectD&& egrid,
   m_kExtension = ( tableXS_emax - extenderXS_emax ) * emax;
 }
 
+void NC::SABXSProvider::evalManyXS( const double* ekin, std::size_t N, double* out_xs ) const
+{
+  //Non-decreasing energies (e.g. a grid for tabulating cross sections) are
+  //binned by walking the grid once. Otherwise, grid bins are looked up a block
+  //at a time (interleaving the searches), and the cross section values needed
+  //are prefetched before using them. NB: NaN values fail the sorting check:
+  bool sorted = true;
+  for ( std::size_t i = 1; i < N; ++i )
+    sorted &= ( ekin[i] >= ekin[i-1] );
+  constexpr std::size_t nblock = 64;
+  std::size_t bins[nblock];
+  const std::size_t nxs = m_xs.size();
+  for ( std::size_t i0 = 0; i0 < N; i0 += nblock ) {
+    const std::size_t nb = std::min<std::size_t>( nblock, N - i0 );
+    if ( sorted ) {
+      m_egridIndex->binManySorted( ekin + i0, nb, bins );
+    } else {
+      m_egridIndex->binMany( ekin + i0, nb, bins );
+      for ( std::size_t j = 0; j < nb; ++j )
+        if ( bins[j] > 0 && bins[j] < nxs )
+          ncprefetch( m_xs.data() + bins[j] - 1 );
+    }
+    for ( std::size_t j = 0; j < nb; ++j )
+      out_xs[i0+j] = crossSectionInBin( NeutronEnergy{ ekin[i0+j] }, bins[j] ).dbl();
+  }
+}
+
+NC::CrossSect NC::SABXSProvider::majorantCrossSection( EnergyDomain d ) const
+{
+  const VectD& egrid = m_egridIndex->grid();
+  nc_assert( ! m_xs.empty() && m_xs.size() == egrid.size() );
+  const double elow = d.elow.dbl();
+  const double ehigh = d.ehigh.dbl();
+
+  //Cross sections are decreasing below the grid, so the value at elow covers
+  //that region (and is infinite for elow=0):
+  double xsmax = crossSection( d.elow ).dbl();
+
+  //Linear interpolation inside the grid, so maximum is found either at the
+  //ends of the domain or at grid points inside it:
+  if ( std::isfinite( ehigh ) )
+    xsmax = ncmax( xsmax, crossSection( d.ehigh ).dbl() );
+  auto itB = egrid.begin() + m_egridIndex->bin( elow );
+  auto itE = std::upper_bound( itB, egrid.end(), ehigh );
+  for ( auto it = itB; it != itE; ++it )
+    xsmax = ncmax( xsmax, m_xs[ std::distance( egrid.begin(), it ) ] );
+
+  //Above the grid, cross sections are k/E + extenderXS_E (see crossSection
+  //below), so the maximum is at the lowest energy:
+  if ( ehigh > egrid.back() ) {
+    const double e0 = ncmax( elow, egrid.back() );
+    xsmax = ncmax( xsmax, ncmax( 0.0, m_kExtension ) / e0 + m_extender->crossSection( NeutronEnergy{ e0 } ).dbl() );
+  }
+  return CrossSect{ xsmax };
+}
+
 NC::CrossSect NC::SABXSProvider::crossSection( NeutronEnergy ekin ) const
 {
-  nc_assert( ! m_xs.empty() && m_xs.size() == m_egrid.size() );
+  return crossSectionInBin( ekin, m_egridIndex->bin( ekin.dbl() ) );
+}
+
+NC::CrossSect NC::SABXSProvider::crossSectionInBin( NeutronEnergy ekin, std::size_t ibin ) const
+{
+  const VectD& egrid = m_egridIndex->grid();
+  nc_assert( ! m_xs.empty() && m_xs.size() == egrid.size() );
+  nc_assert( ibin == m_egridIndex->bin( ekin.dbl() ) );
 
-  auto itEkinUpper = std::upper_bound ( m_egrid.begin(), m_egrid.end(), ekin.dbl() );
-  if ( itEkinUpper == m_egrid.end()) {
+  auto itEkinUpper = egrid.begin() + ibin;
+  if ( itEkinUpper == egrid.end()) {
     //  integral_E(S) = (tableintegral_Emax(S)-extenderintegral_Emax(S))+extenderintegral_E(S)
     //  Now, in general XS(E) = [C/E] * integral_E(S),   C=sigmaB*kT/4. So:
     //    XS_E = [C/E] * integral_E(S)
     //            = [Emax/E]*([C/Emax]*tableintegral_Emax(S)-[C/Emax]*extenderintegral_Emax(S))+[C/E]*extenderintegral_E(S)
     //            = [Emax/E] *(tableXS_Emax-extenderXS_Emax) + extenderXS_E = k / E + extenderXS_E
     return CrossSect{ m_kExtension / ekin.dbl() + m_extender->crossSection( ekin ).dbl() };
-  } else if ( itEkinUpper == m_egrid.begin() ) {
+  } else if ( itEkinUpper == egrid.begin() ) {
 
     //Energy is below lowest tabulated energy. At very small energies, the
     //kinematically allowed region of (alpha,beta) space becomes ever thinner,
@@ -77,11 +156,11 @@ NC::CrossSect NC::SABXSProvider::crossSection( NeutronEnergy ekin ) const
     //will decrease as 1/sqrt(E) for small energies (we have thus essentially
     //derived, or at least argued for, the "1/v law").
 
-    return CrossSect { ekin.dbl() > 0.0 ? std::sqrt( m_egrid.front() / ekin.dbl() ) * m_xs.front() : kInfinity };
+    return CrossSect { ekin.dbl() > 0.0 ? std::sqrt( egrid.front() / ekin.dbl() ) * m_xs.front() : kInfinity };
   } else {
     //linear interpolation in grid
     auto itEkinLower = std::prev(itEkinUpper);
-    auto itXSLower = m_xs.begin() + std::distance(m_egrid.begin(), itEkinLower);
+    auto itXSLower = m_xs.begin() + std::distance(egrid.begin(), itEkinLower);
     auto itXSUpper = std::next(itXSLower);
     const double dXS = *itXSUpper - *itXSLower;
     const double dEkin = *itEkinUpper - *itEkinLower;
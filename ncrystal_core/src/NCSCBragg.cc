@@ -26,16 +26,24 @@
 #include "NCrystal/internal/NCVector.hh"
 #include "NCrystal/internal/NCOrientUtils.hh"
 #include "NCrystal/internal/NCPlaneProvider.hh"
-#include <functional>//std::greater
+#include "NCrystal/internal/NCCounters.hh"
+#include "NCrystal/internal/NCString.hh"
+#include <algorithm>
+#include <mutex>
 namespace NC=NCrystal;
 
-struct NC::SCBragg::pimpl {
+//Reflection families and their deminormals in the crystal frame, which do not
+//depend on the crystal orientation (calculations are carried out in the
+//crystal frame, with neutron directions rotated into it):
+class NC::SCBragg::Geometry : private ::NC::MoveOnly {
+public:
 
   class ReflectionFamily : private ::NC::MoveOnly {//"::NC::" is needed to avoid compilation error (SCBragg inherits from private MoveOnly)
   public:
     //A familiy is here taken to be all planes sharing d-spacing and fsquared.
+    //The deminormals of all families are kept together in m_normals (see
+    //below).
 
-    std::vector<Vector> deminormals;
     double xsfact;// = fsquared / (unit_cell_volume * unit_cell_natoms)
     double inv2d;
 
@@ -54,45 +62,146 @@ struct NC::SCBragg::pimpl {
     }
   };
 
-  typedef std::map<std::pair<uint64_t,uint64_t>,std::vector<Vector>,
-                   std::greater<std::pair<uint64_t,uint64_t> > > SCBraggSortMap;
 
-  pimpl( const NC::Info&, MosaicityFWHM, double dd,
-         const SCOrientation&, PlaneProvider * plane_provider,
-         double prec, double ntrunc );
+  struct AngularBin {
+    Vector center;//unit vector
+    std::size_t entries_begin, entries_end;//range in m_binEntries
+  };
 
   double setupFamilies( const Info& cinfo,
-                        const RotMatrix& cry2lab,
                         PlaneProvider * plane_provider,
                         double V0numAtom );
 
-  class Cache : public CacheBase {
-  public:
-    void invalidateCache() override { ekin = -1.0; }
-    //cache signature:
+  //Angular index of all deminormals, making it possible to quickly locate
+  //those which might contribute for a given neutron direction. The
+  //deminormals are folded into the z>=0 hemisphere and binned on a cubed
+  //sphere. It is only set up for crystals with many deminormals:
+  void setupIndex();
+
+  std::vector<ReflectionFamily> m_reflfamilies;
+  std::vector<AngularBin> m_bins;
+  std::vector<uint32_t> m_binEntries;//global deminormal indices, sorted within each bin
+  VectD m_binEntryInv2d;//inv2d of the family of each entry in m_binEntries
+  std::vector<std::size_t> m_famOffsets;//global index of first deminormal in each family (+ total at end)
+  GaussMos::NormalsSoA m_normals;//deminormals of all families in the crystal frame, indexed by global index
+  VectD m_faminv2d;//inv2d of each family
+  double m_binRadius = 0.0;//max angle between a bin center and any of its deminormals
+  double m_maxdspacing = 0.0;
+
+  void accountMemory( MemoryFootprint& ) const;
+};
+
+struct NC::SCBragg::pimpl {
+
+  pimpl( const NC::Info&, MosaicityFWHM, double dd,
+         const SCOrientation&, GeometryPtr,
+         double prec, double ntrunc, bool circint_table );
+
+  bool useIndex( std::size_t nfam ) const;//nfam: number of families below wavelength cutoff
+
+  //Results for a given (ekin,dir) state:
+  struct CacheEntry {
+    //cache signature (rounded ekin and direction exactly as passed in, so
+    //repeated calls with the same neutron state are recognised without
+    //recomputing any derived quantities):
     double ekin = -1.0;//Start with invalid cache
     Vector dir;
     //cache contents:
+    Vector dircry;//dir in the crystal frame
     double wl;
     VectD xs_commul;
+    CachedRandIdxPicker picker;//must be invalidated when xs_commul changes
+    std::vector<GaussMos::ScatCache> scatcache;
+    std::uint64_t lastUse = 0;
+  };
+
+  //Small associative cache of the most recently used (ekin,dir) states, so
+  //alternating between a few neutron states (e.g. when several materials or
+  //neutrons share the cache object) does not trigger full recalculations. The
+  //number of entries can be set with the NCRYSTAL_SCBRAGG_CACHESIZE
+  //environment variable (default 4). Evicted entries are recycled, keeping the
+  //capacity of their vectors:
+  class Cache : public CacheBase {
+  public:
+    Cache() : entries( nCacheEntries() ) {}
+    void invalidateCache() override { for ( auto& e : entries ) e.ekin = -1.0; }
+    std::vector<CacheEntry> entries;
+    std::size_t lastIdx = 0;
+    std::uint64_t useCount = 0;
+    //work buffers for usage with angular index:
+    std::vector<uint32_t> candidates;
+    std::vector<Vector> normals;
+    //work buffers and state for sampling without a cache entry (see
+    //sampleUncached):
+    struct FamContrib {
+      std::size_t ifam;
+      std::size_t ibegin, iend;//range in candidates (or in all normals, if no candidates)
+      double xs_commul;
+    };
+    std::vector<FamContrib> famcontribs;
     std::vector<GaussMos::ScatCache> scatcache;
+    VectD xs_commul;
+    double uncached_ekin = -1.0;
+    Vector uncached_dir;
+    static std::size_t nCacheEntries()
+    {
+      static const std::size_t s_n = static_cast<std::size_t>( ncclamp( ncgetenv_int("SCBRAGG_CACHESIZE",4), 1, 64 ) );
+      return s_n;
+    }
   };
 
-  void genScat( Cache&, RNG&, Vector& outdir ) const;
-  void updateCache( Cache&, NeutronEnergy, const Vector& ) const;
+  //Neutron directions are rotated into the crystal frame with toCrystalFrame
+  //(the result is not yet normalised, which is done where it is needed). The
+  //batched methods below rotate many directions at once with
+  //RotMatrix::rotateMany, with identical results:
+  Vector toCrystalFrame( const Vector& dir ) const
+  {
+    Vector d = dir;
+    d.normalise();
+    return m_lab2cry * d;
+  }
+  void toCrystalFrameMany( const double* ux, const double* uy, const double* uz,
+                           std::size_t n, double* cx, double* cy, double* cz ) const;
+
+  //genScat and sampleCry provide the outgoing direction in the crystal frame
+  //(dircry is calculated with toCrystalFrame when needed, if not provided):
+  void genScat( CacheEntry&, RNG&, Vector& outdircry ) const;
+  bool sampleCry( Cache&, RNG&, NeutronEnergy, const Vector& dir, const Vector* dircry, Vector& outdircry ) const;
+
+  //If the crystal frame direction is already available (from toCrystalFrame),
+  //it can be passed in to avoid recalculating it:
+  CacheEntry& updateCache( Cache&, NeutronEnergy, const Vector&, const Vector* dircry = nullptr ) const;
+  CacheEntry* findCacheEntry( Cache&, double ekin_rounded, const Vector& ) const;
+
+  //Number of families below the wavelength cutoff, and (if the angular index
+  //should be used) the sorted global indices of the deminormals which might
+  //contribute in cachedb.candidates:
+  std::size_t collectCandidates( Cache&, double wl, const Vector& dircry, bool& use_index ) const;
+
+  //Sample a scattering without calculating and storing the contributions of
+  //all deminormals: First only the total cross-section of each family is
+  //found, and after picking a family, only the contributions of the
+  //deminormals in that family are calculated. Returns false if no scattering
+  //is possible:
+  bool sampleUncached( Cache&, double ekin_rounded, const Vector& dircry, RNG&, Vector& outdircry ) const;
 
   double m_threshold_ekin;
-  std::vector<ReflectionFamily> m_reflfamilies;
   GaussMos m_gm;
+  RotMatrix m_cry2lab;
+  RotMatrix m_lab2cry;
+  GeometryPtr m_geom;
 };
 
 NC::SCBragg::pimpl::pimpl(const NC::Info& cinfo, MosaicityFWHM mosaicity,
-                          double dd, const SCOrientation& sco, PlaneProvider * plane_provider,
-                          double prec, double ntrunc)
+                          double dd, const SCOrientation& sco, GeometryPtr geom,
+                          double prec, double ntrunc, bool circint_table)
   : m_threshold_ekin(kInfinity),
-    m_gm(mosaicity,prec,ntrunc)
+    m_gm(mosaicity,prec,ntrunc),
+    m_geom(std::move(geom))
 {
   m_gm.setDSpacingSpread(dd);
+  if ( circint_table )
+    m_gm.enableCircleIntegralTable();
 
   //Always needs structure info:
   if (!cinfo.hasStructureInfo())
@@ -100,12 +209,11 @@ NC::SCBragg::pimpl::pimpl(const NC::Info& cinfo, MosaicityFWHM mosaicity,
 
   //Setup based on structure info:
   RotMatrix reci_lattice = getReciprocalLatticeRot( cinfo );
-  RotMatrix cry2lab = getCrystal2LabRot( sco, reci_lattice );
-  double V0numAtom = cinfo.getStructureInfo().n_atoms * cinfo.getStructureInfo().volume;
+  m_cry2lab = getCrystal2LabRot( sco, reci_lattice );
+  m_lab2cry = Matrix( MatrixAllowCopy, m_cry2lab );
+  m_lab2cry.transpose();//a pure rotation, so the inverse is the transpose
 
-  double maxdsp = setupFamilies( cinfo, cry2lab, plane_provider, V0numAtom );
-
-  m_threshold_ekin = wl2ekin(maxdsp * 2.0);
+  m_threshold_ekin = wl2ekin(m_geom->m_maxdspacing * 2.0);
 
 }
 
@@ -114,110 +222,255 @@ NC::SCBragg::SCBragg( const NC::Info& cinfo,
                       MosaicityFWHM mosaicity,
                       double dd,
                       PlaneProvider * plane_provider,
-                      double prec, double ntrunc)
-  : m_pimpl(std::make_unique<pimpl>(cinfo,mosaicity,dd,sco,plane_provider,prec,ntrunc))
+                      double prec, double ntrunc, bool circint_table)
+  : m_pimpl(std::make_unique<pimpl>(cinfo,mosaicity,dd,sco,createGeometry(cinfo,plane_provider),
+                                    prec,ntrunc,circint_table))
+{
+}
+
+NC::SCBragg::SCBragg( const NC::Info& cinfo,
+                      const SCOrientation& sco,
+                      MosaicityFWHM mosaicity,
+                      GeometryPtr geom,
+                      double dd,
+                      double prec, double ntrunc, bool circint_table)
+  : m_pimpl(std::make_unique<pimpl>(cinfo,mosaicity,dd,sco,std::move(geom),prec,ntrunc,circint_table))
 {
 }
 
 NC::SCBragg::~SCBragg() = default;
 
-double NC::SCBragg::pimpl::setupFamilies( const NC::Info& cinfo,
-                                          const NC::RotMatrix& cry2lab,
-                                          NC::PlaneProvider * plane_provider,
-                                          double V0numAtom )
+double NC::SCBragg::Geometry::setupFamilies( const NC::Info& cinfo,
+                                              NC::PlaneProvider * plane_provider,
+                                              double V0numAtom )
 {
   //expand crystal info
   nc_assert_always(cinfo.hasHKLInfo());
   nc_assert_always(cinfo.hasStructureInfo());
   nc_assert(m_reflfamilies.empty());
 
-  //collect all planes, sorted by (dsp,fsq). To avoid issues connected to
-  //floating point number keys, we store dspacing/fsquared as integers, keeping
-  //precision down to 1e-10 angstrom and 1e-10 barn respectively.
-  SCBraggSortMap planes;
-  //but also try to avoid rounding issues when floating point values are not misbehaving:
-  std::map<uint64_t,double> origvals_dsp;
-  std::map<uint64_t,double> origvals_fsq;
-
-  double dsp, fsq;
-  Vector demi_normal;
-  const double two30 = 1073741824.0;//2^30 ~= 1.07e9
-
   std::unique_ptr<PlaneProvider> ppguard;
   if (!plane_provider) {
     //fall back to standard plane provider
     ppguard = createStdPlaneProvider(&cinfo);//NB: cinfo must outlive ppguard!
     plane_provider = ppguard.get();
-  } else {
-    //use supplied plane provider - we must reset looping since we don't know
-    //its current state:
-    plane_provider->prepareLoop();
   }
 
+  //collect all planes (getAllPlanes always performs a complete loop, so it
+  //does not matter what the state of a supplied plane provider is):
+  PlaneProvider::PlaneList pl;
+  plane_provider->getAllPlanes( pl );
+  const std::size_t nplanes = pl.size();
+
+  //Sort them by (dsp,fsq), both descending. To avoid issues connected to
+  //floating point number keys, we use dspacing/fsquared as integers, keeping
+  //precision down to 1e-10 angstrom and 1e-10 barn respectively. Ties are
+  //broken by the original plane order, so the deminormals of each family
+  //keep the order in which they were provided:
+  const double two30 = 1073741824.0;//2^30 ~= 1.07e9
+  struct PlaneKey { uint64_t dsp, fsq; std::size_t idx; };
+  std::vector<PlaneKey> keys;
+  keys.reserve( nplanes );
   double maxdspacing(0);
-
-  while (plane_provider->getNextPlane(dsp, fsq, demi_normal)) {
-
+  for ( std::size_t i = 0; i < nplanes; ++i ) {
+    const double dsp = pl.dspacings[i];
+    const double fsq = pl.fsquareds[i];
     if (dsp>maxdspacing)
       maxdspacing = dsp;
-
     nc_assert(dsp>0.0&&fsq>0.0&&dsp<1e7&&fsq<1e7);
-    uint64_t ui_dsp = (uint64_t)(dsp*two30+0.5);
-    uint64_t ui_fsq = (uint64_t)(fsq*two30+0.5);
-
-    //a bit messy, but nice to preserve values when possible:
-    std::map<uint64_t,double>::iterator itOrig = origvals_dsp.find(ui_dsp);
-    if (itOrig==origvals_dsp.end()) {
-      origvals_dsp[ui_dsp] = dsp;
-    } else if (ncabs(dsp-itOrig->second)>1e-12) {
-      itOrig->second = -1;//multiple values observed ...!
-    }
-    itOrig = origvals_fsq.find(ui_fsq);
-    if (itOrig==origvals_fsq.end()) {
-      origvals_fsq[ui_fsq] = fsq;
-    } else if (ncabs(fsq-itOrig->second)>1e-12) {
-      itOrig->second = -1;//multiple values observed ...!
+    keys.push_back( PlaneKey{ (uint64_t)(dsp*two30+0.5), (uint64_t)(fsq*two30+0.5), i } );
+  }
+  std::sort( keys.begin(), keys.end(),
+             []( const PlaneKey& a, const PlaneKey& b )
+             {
+               if ( a.dsp != b.dsp ) return a.dsp > b.dsp;
+               if ( a.fsq != b.fsq ) return a.fsq > b.fsq;
+               return a.idx < b.idx;
+             } );
+
+  //A bit messy, but nice to preserve the original floating point values when
+  //possible, i.e. when all values mapping to a given integer agree with the
+  //first one provided (to within 1e-12):
+  auto resolveOrigVals = [nplanes,two30]( const VectD& vals )
+  {
+    std::vector<std::pair<uint64_t,std::size_t>> v;
+    v.reserve( nplanes );
+    for ( std::size_t i = 0; i < nplanes; ++i )
+      v.emplace_back( (uint64_t)(vals[i]*two30+0.5), i );
+    std::sort( v.begin(), v.end() );
+    std::vector<std::pair<uint64_t,double>> res;
+    for ( auto it = v.begin(); it != v.end(); ) {
+      auto itE = it;
+      const double first = vals[it->second];
+      double resolved = first;
+      for ( ; itE != v.end() && itE->first == it->first; ++itE )
+        if ( ncabs( vals[itE->second] - first ) > 1e-12 )
+          resolved = it->first / two30;//multiple values observed ...!
+      res.emplace_back( it->first, resolved );
+      it = itE;
     }
+    return res;
+  };
+  const auto origvals_dsp = resolveOrigVals( pl.dspacings );
+  const auto origvals_fsq = resolveOrigVals( pl.fsquareds );
+  auto lookupOrigVal = []( const std::vector<std::pair<uint64_t,double>>& origvals, uint64_t ui )
+  {
+    auto it = std::lower_bound( origvals.begin(), origvals.end(), std::make_pair( ui, -kInfinity ) );
+    nc_assert( it != origvals.end() && it->first == ui );
+    return it->second;
+  };
 
-    std::pair<uint64_t,uint64_t> key(ui_dsp,ui_fsq);
-
-    SCBraggSortMap::iterator it = planes.find(key);
-    if ( it != planes.end() ) {
-      it->second.push_back(demi_normal);
-    } else {
-      std::pair<PairDD,std::vector<Vector> > newentry;
-      newentry.first = key;
-      newentry.second.push_back(demi_normal);
-      planes.insert(it,newentry);
+  //Group into families, transferring the deminormals into the shared normals:
+  std::size_t nfam = 0;
+  for ( std::size_t i = 0; i < nplanes; ++i )
+    if ( i == 0 || keys[i].dsp != keys[i-1].dsp || keys[i].fsq != keys[i-1].fsq )
+      ++nfam;
+  m_reflfamilies.reserve(nfam);
+  m_famOffsets.reserve(nfam+1);
+  m_normals = GaussMos::NormalsSoA( nplanes );
+  for ( std::size_t i = 0; i < nplanes; ++i ) {
+    const PlaneKey& k = keys[i];
+    if ( i == 0 || k.dsp != keys[i-1].dsp || k.fsq != keys[i-1].fsq ) {
+      m_famOffsets.push_back( i );
+      m_reflfamilies.emplace_back( lookupOrigVal( origvals_fsq, k.fsq ) / V0numAtom,
+                                   lookupOrigVal( origvals_dsp, k.dsp ) );
     }
+    m_normals.set( i, pl.demi_normals[k.idx] );
   }
+  m_famOffsets.push_back( nplanes );
+  nc_assert( m_reflfamilies.size() == nfam );
 
-  m_reflfamilies.reserve(planes.size());
-  SCBraggSortMap::const_iterator it = planes.begin();
-  for (;it!=planes.end();++it) {
-
-    std::map<uint64_t,double>::iterator itOrig = origvals_dsp.find(it->first.first);
-    nc_assert(itOrig!=origvals_dsp.end());
-    dsp = (itOrig->second > 0 ? itOrig->second : it->first.first / two30);
+  return maxdspacing;
+}
 
-    itOrig = origvals_fsq.find(it->first.second);
-    nc_assert(itOrig!=origvals_fsq.end());
-    fsq = (itOrig->second > 0 ? itOrig->second : it->first.second / two30);
 
-    m_reflfamilies.emplace_back(fsq/V0numAtom,dsp);
+void NC::SCBragg::Geometry::setupIndex()
+{
+  nc_assert( m_famOffsets.size() == m_reflfamilies.size() + 1 );
+  m_faminv2d.reserve( m_reflfamilies.size() );
+  for ( const auto& fam : m_reflfamilies )
+    m_faminv2d.push_back( fam.inv2d );
+  const std::size_t ntot = m_normals.size();
+
+  //Testing a deminormal directly costs only a few floating point operations,
+  //so the index only pays off for crystals with a very large number of them:
+  if ( ntot < 65536 )
+    return;
+  nc_assert_always( ntot < std::numeric_limits<uint32_t>::max() );
+
+  //Aim for roughly 64 deminormals per bin (the folded normals populate half
+  //the area of the cube):
+  const unsigned nface = std::min<unsigned>( 128, std::max<unsigned>( 1, static_cast<unsigned>( std::sqrt( ntot / (3*64.0) ) + 0.5 ) ) );
+  auto fold = []( const Vector& n ) { return n.z() < 0.0 ? -n : n; };
+  auto binKey = [nface]( const Vector& n )
+  {
+    //Equal-angle cubed sphere binning:
+    const double ax = ncabs(n.x()), ay = ncabs(n.y()), az = ncabs(n.z());
+    unsigned face;
+    double a, b, m;
+    if ( ax >= ay && ax >= az ) {
+      face = ( n.x() > 0.0 ? 0 : 1 ); a = n.y(); b = n.z(); m = ax;
+    } else if ( ay >= az ) {
+      face = ( n.y() > 0.0 ? 2 : 3 ); a = n.x(); b = n.z(); m = ay;
+    } else {
+      face = ( n.z() > 0.0 ? 4 : 5 ); a = n.x(); b = n.y(); m = az;
+    }
+    auto toIdx = [nface,m]( double v )
+    {
+      const double f = 0.5 * ( std::atan( v / m ) * ( 4.0 / kPi ) + 1.0 );
+      return std::min<unsigned>( nface - 1, static_cast<unsigned>( ncmax( 0.0, f ) * nface ) );
+    };
+    return ( face * nface + toIdx(a) ) * nface + toIdx(b);
+  };
 
-    //transfer it->second into final vector and put in the lab frame:
-    ReflectionFamily& fam = m_reflfamilies.back();
-    fam.deminormals.reserve(it->second.size());
-    std::vector<Vector>::const_iterator itDN(it->second.begin()), itDNE(it->second.end());
-    for (;itDN!=itDNE;++itDN)
-      fam.deminormals.push_back( cry2lab * (*itDN) );
-    nc_assert(m_reflfamilies.back().deminormals.size()==it->second.size());
+  std::vector<std::pair<unsigned,uint32_t>> keys;
+  keys.reserve( ntot );
+  for ( uint32_t gi = 0; gi < ntot; ++gi )
+    keys.emplace_back( binKey( fold( m_normals.at(gi) ) ), gi );
+  std::sort( keys.begin(), keys.end() );
+
+  m_binEntries.reserve( ntot );
+  auto normalOfEntry = [this]( uint32_t idx ) { return m_normals.at(idx); };
+  for ( std::size_t i = 0; i < keys.size(); ) {
+    AngularBin bin;
+    bin.entries_begin = m_binEntries.size();
+    Vector sum(0.,0.,0.);
+    const unsigned key = keys[i].first;
+    for ( ; i < keys.size() && keys[i].first == key; ++i ) {
+      m_binEntries.push_back( keys[i].second );
+      m_binEntryInv2d.push_back( m_faminv2d[ ( std::upper_bound( m_famOffsets.begin(), m_famOffsets.end(), keys[i].second ) - m_famOffsets.begin() ) - 1 ] );
+      sum += fold( normalOfEntry( keys[i].second ) );
+    }
+    bin.entries_end = m_binEntries.size();
+    bin.center = sum.unit();
+    for ( std::size_t j = bin.entries_begin; j < bin.entries_end; ++j ) {
+      //Precise angle, valid also for tiny angles:
+      const double chord = ( fold( normalOfEntry( m_binEntries[j] ) ) - bin.center ).mag();
+      m_binRadius = ncmax( m_binRadius, 2.0 * std::asin( ncmin( 1.0, 0.5 * chord ) ) );
+    }
+    m_bins.push_back( bin );
   }
+  m_binRadius += 1e-9;//safety margin
+}
 
-  return maxdspacing;
+NC::SCBragg::GeometryPtr NC::SCBragg::createGeometry( const NC::Info& cinfo,
+                                                      NC::PlaneProvider * plane_provider )
+{
+  if (!cinfo.hasStructureInfo())
+    NCRYSTAL_THROW(MissingInfo,"Passed Info object lacks Structure information.");
+  auto create = [&cinfo,plane_provider]()
+  {
+    const double V0numAtom = cinfo.getStructureInfo().n_atoms * cinfo.getStructureInfo().volume;
+    auto g = makeSO<Geometry>();
+    g->m_maxdspacing = g->setupFamilies( cinfo, plane_provider, V0numAtom );
+    g->setupIndex();
+    return g;
+  };
+  //Custom plane providers might provide any planes, so only share the result
+  //of the standard one (keyed on the Info object, whose planes never change):
+  if ( plane_provider )
+    return create();
+
+  static std::mutex s_mutex;
+  static std::map<UniqueIDValue,std::weak_ptr<const Geometry>> s_db;
+  const auto key = cinfo.getUniqueID();
+  {
+    NCRYSTAL_LOCK_GUARD(s_mutex);
+    auto it = s_db.find( key );
+    if ( it != s_db.end() ) {
+      auto sp = it->second.lock();
+      if ( sp )
+        return sp;
+    }
+  }
+  GeometryPtr g = create();
+  NCRYSTAL_LOCK_GUARD(s_mutex);
+  //Forget entries of geometries no longer in use:
+  for ( auto it = s_db.begin(); it != s_db.end(); ) {
+    if ( it->second.expired() )
+      it = s_db.erase( it );
+    else
+      ++it;
+  }
+  auto& entry = s_db[key];
+  auto existing = entry.lock();
+  if ( existing )
+    return existing;//created concurrently by another thread
+  entry = g.getsp();
+  return g;
 }
 
+bool NC::SCBragg::pimpl::useIndex( std::size_t nfam ) const
+{
+  //Visiting a bin is much more expensive than testing a single deminormal, so
+  //only use the index when the bins are narrow compared to the hemisphere and
+  //there are many deminormals below the wavelength cutoff:
+  const Geometry& g = *m_geom;
+  nc_assert( !g.m_bins.empty() );
+  if ( !( m_gm.mosaicityTruncationAngle() + g.m_binRadius < 0.1 ) )
+    return false;
+  return g.m_famOffsets[nfam] >= 64 * g.m_bins.size();
+}
 
 namespace NCrystal {
   inline double SCBragg_cacheRound(double x) {
@@ -226,9 +479,14 @@ namespace NCrystal {
     //get call-order irreproducibilities.
     return std::floor(x*1e15+0.5)*1e-15;
   }
+  inline bool SCBragg_sameDir( const Vector& a, const Vector& b ) {
+    //Identical input is by far the most common case, and is checked before
+    //the expensive angle calculation:
+    return ( a.x() == b.x() && a.y() == b.y() && a.z() == b.z() ) || a.angle_highres(b) < 1.0e-12;
+  }
 }
 
-void NC::SCBragg::pimpl::updateCache( Cache& cache, NeutronEnergy ekin_raw, const NC::Vector& dir ) const
+NC::SCBragg::pimpl::CacheEntry* NC::SCBragg::pimpl::findCacheEntry( Cache& cachedb, double ekin, const NC::Vector& dir ) const
 {
   //We check the cache validity on the rounded ekin value, but for simplicity we
   //keep the direction as it is. We could consider rounding the direction as
@@ -236,15 +494,49 @@ void NC::SCBragg::pimpl::updateCache( Cache& cache, NeutronEnergy ekin_raw, cons
   //NB: We used to check co-alignment of angles via a dot-product, but that is
   //actually numerically imprecise for small angles, leading to occurances of
   //cache validity where it should have been invalid.
+  auto& entries = cachedb.entries;
+  nc_assert( !entries.empty() && cachedb.lastIdx < entries.size() );
+  auto isValidFor = [ekin,&dir]( const CacheEntry& e )
+  {
+    return e.ekin==ekin && SCBragg_sameDir( dir, e.dir );
+  };
+  //Most recently used entry first, then the others:
+  if ( isValidFor( entries[cachedb.lastIdx] ) )
+    return &entries[cachedb.lastIdx];
+  for ( std::size_t i = 0; i < entries.size(); ++i ) {
+    if ( i != cachedb.lastIdx && isValidFor( entries[i] ) ) {
+      cachedb.lastIdx = i;
+      entries[i].lastUse = ++cachedb.useCount;
+      return &entries[i];
+    }
+  }
+  return nullptr;
+}
+
+NC::SCBragg::pimpl::CacheEntry& NC::SCBragg::pimpl::updateCache( Cache& cachedb, NeutronEnergy ekin_raw,
+                                                                 const NC::Vector& dir, const NC::Vector* dircry ) const
+{
   double ekin = SCBragg_cacheRound(ekin_raw.get());
-  if ( cache.ekin==ekin && dir.angle_highres(cache.dir)<1.0e-12 ) {
+  CacheEntry * found = findCacheEntry( cachedb, ekin, dir );
+  if ( found ) {
     //cache already valid!
-    return;
+    NCRYSTAL_COUNT(SCBraggCacheHit);
+    return *found;
   }
 
-  //Cache not valid!
+  //Cache not valid, recalculate in the least recently used entry:
+  NCRYSTAL_COUNT(SCBraggCacheMiss);
+  auto& entries = cachedb.entries;
+  std::size_t ievict = 0;
+  for ( std::size_t i = 1; i < entries.size(); ++i )
+    if ( entries[i].lastUse < entries[ievict].lastUse )
+      ievict = i;
+  cachedb.lastIdx = ievict;
+  CacheEntry& cache = entries[ievict];
+  cache.lastUse = ++cachedb.useCount;
   cache.dir = dir;
-  cache.dir.normalise();
+  cache.dircry = ( dircry ? *dircry : m_lab2cry * dir.unit() );
+  cache.dircry.normalise();
 
   //Energy or direction is new, we must recalculate.
 
@@ -253,36 +545,265 @@ void NC::SCBragg::pimpl::updateCache( Cache& cache, NeutronEnergy ekin_raw, cons
   nc_assert(cache.wl>=0);
   cache.scatcache.clear();
   cache.xs_commul.clear();
+  cache.picker.invalidate();
   if (cache.wl==0)
-    return;//done, all cross-sections will be zero
-
-  std::vector<ReflectionFamily>::const_iterator it(m_reflfamilies.begin()), itE(m_reflfamilies.end());
-
-  double inv2dcutoff = (1.0-2*std::numeric_limits<double>::epsilon())/cache.wl;
+    return cache;//done, all cross-sections will be zero
 
+  const Geometry& g = *m_geom;
   GaussMos::InteractionPars interactionpars;
-  for( ; it!=itE; ++it) {
-    const ReflectionFamily& fam = *it;
-    if( fam.inv2d >= inv2dcutoff )
-      break;//stop here, no more families fulfill w<2d requirement.
+  bool use_index;
+  const std::size_t nfam = collectCandidates( cachedb, cache.wl, cache.dircry, use_index );
+
+  if ( use_index ) {
+    //Process candidates family by family and in the original order, so
+    //results are identical to those obtained without the index:
+    const auto& candidates = cachedb.candidates;
+    std::size_t ifam = 0;
+    for ( std::size_t i = 0; i < candidates.size(); ) {
+      while ( g.m_famOffsets[ifam+1] <= candidates[i] )
+        ++ifam;
+      const Geometry::ReflectionFamily& fam = g.m_reflfamilies[ifam];
+      const std::size_t offset_next = g.m_famOffsets[ifam+1];
+      auto& normals = cachedb.normals;
+      normals.clear();
+      for ( ; i < candidates.size() && candidates[i] < offset_next; ++i )
+        normals.push_back( g.m_normals.at( candidates[i] ) );
+      interactionpars.set(cache.wl, fam.inv2d, fam.xsfact);
+      m_gm.calcCrossSections(interactionpars, cache.dircry, normals, cache.scatcache,cache.xs_commul);
+    }
+    nc_assert(cache.xs_commul.empty()||cache.xs_commul.back()>0.0);
+    return cache;
+  }
+
+  for ( std::size_t ifam = 0; ifam < nfam; ++ifam ) {
+    const Geometry::ReflectionFamily& fam = g.m_reflfamilies[ifam];
     interactionpars.set(cache.wl, fam.inv2d, fam.xsfact);
-    m_gm.calcCrossSections(interactionpars, cache.dir, fam.deminormals, cache.scatcache,cache.xs_commul);
+    m_gm.calcCrossSections(interactionpars, cache.dircry, g.m_normals, g.m_famOffsets[ifam], g.m_famOffsets[ifam+1],
+                           cache.scatcache,cache.xs_commul);
   }
 
   nc_assert(cache.xs_commul.empty()||cache.xs_commul.back()>0.0);
+  return cache;
+}
+
+std::size_t NC::SCBragg::pimpl::collectCandidates( Cache& cachedb, double wl, const NC::Vector& dircry, bool& use_index ) const
+{
+  nc_assert( wl > 0.0 );
+  const Geometry& g = *m_geom;
+  double inv2dcutoff = (1.0-2*std::numeric_limits<double>::epsilon())/wl;
+
+  //Families are sorted by inv2d, so those which can fulfill the w<2d
+  //requirement are exactly the first nfam ones. For a given wavelength, this
+  //is also the set of families which can contribute for some direction, since
+  //the Bragg angle of any of them can be reached by a suitable orientation:
+  const std::size_t nfam = std::lower_bound( g.m_faminv2d.begin(), g.m_faminv2d.end(), inv2dcutoff ) - g.m_faminv2d.begin();
+
+  use_index = !g.m_bins.empty() && useIndex( nfam );
+  if ( !use_index )
+    return nfam;
+
+  //Use angular index. A deminormal at an angle delta from the plane
+  //perpendicular to the neutron direction can only contribute if
+  //|delta-thetabragg|<truncangle, and all deminormals in a bin have delta
+  //within m_binRadius of that of the bin center. Thus, for each bin, we only
+  //need to consider families with sin(thetabragg)=wl*inv2d in the range
+  //[sin(delta-w),sin(delta+w)] with w=truncangle+m_binRadius:
+  const double w = m_gm.mosaicityTruncationAngle() + g.m_binRadius;
+  const bool wfull = !( w < kPiHalf );
+  const double cw = std::cos(w);
+  const double sw = std::sin(w);
+  const double invwl = 1.0 / wl;
+  auto& candidates = cachedb.candidates;
+  candidates.clear();
+  const uint32_t * entries = g.m_binEntries.data();
+  const double * entries_inv2d = g.m_binEntryInv2d.data();
+  for ( const auto& bin : g.m_bins ) {
+    const double x = ncmin( 1.0, ncabs( bin.center.dot( dircry ) ) );//sin(delta)
+    const double y = std::sqrt( 1.0 - x * x );//cos(delta)
+    double inv2d_lo = 0.0;
+    double inv2d_hi = inv2dcutoff;
+    if ( !wfull ) {
+      const double slo = x * cw - y * sw;//sin(delta-w)
+      if ( slo > 0.0 )
+        inv2d_lo = slo * invwl * ( 1.0 - 1e-12 );
+      if ( y * cw - x * sw > 0.0 )//delta+w < pi/2
+        inv2d_hi = ncmin( inv2d_hi, ( x * cw + y * sw ) * invwl * ( 1.0 + 1e-12 ) );
+    }
+    //Entries are sorted by family and therefore also by inv2d:
+    const double * itB = std::lower_bound( entries_inv2d + bin.entries_begin, entries_inv2d + bin.entries_end, inv2d_lo );
+    const double * itE = std::lower_bound( itB, entries_inv2d + bin.entries_end, inv2d_hi );
+    candidates.insert( candidates.end(), entries + ( itB - entries_inv2d ), entries + ( itE - entries_inv2d ) );
+  }
+  std::sort( candidates.begin(), candidates.end() );
+  return nfam;
+}
+
+bool NC::SCBragg::pimpl::sampleUncached( Cache& cachedb, double ekin, const NC::Vector& dircry_in, NC::RNG& rng, NC::Vector& outdircry ) const
+{
+  const double wl = ekin2wl(ekin);
+  nc_assert(wl>=0);
+  if ( wl == 0.0 )
+    return false;
+  Vector dircry = dircry_in;
+  dircry.normalise();
+
+  const Geometry& g = *m_geom;
+  GaussMos::InteractionPars interactionpars;
+  bool use_index;
+  const std::size_t nfam = collectCandidates( cachedb, wl, dircry, use_index );
+  const auto& candidates = cachedb.candidates;
+  auto& normals = cachedb.normals;
+  auto setNormals = [&g,&candidates,&normals]( const Cache::FamContrib& fc )
+  {
+    normals.clear();
+    for ( std::size_t i = fc.ibegin; i < fc.iend; ++i )
+      normals.push_back( g.m_normals.at( candidates[i] ) );
+  };
+
+  //Total cross-section of each family (with commulative values calculated
+  //exactly as in updateCache):
+  auto& famcontribs = cachedb.famcontribs;
+  famcontribs.clear();
+  double xs_commul = 0.0;
+  auto addFamily = [&]( std::size_t ifam, std::size_t ibegin, std::size_t iend )
+  {
+    const Geometry::ReflectionFamily& fam = g.m_reflfamilies[ifam];
+    Cache::FamContrib fc{ ifam, ibegin, iend, 0.0 };
+    interactionpars.set(wl, fam.inv2d, fam.xsfact);
+    double xs;
+    if ( use_index ) {
+      setNormals( fc );
+      xs = m_gm.calcTotalCrossSection( interactionpars, dircry, normals );
+    } else {
+      xs = m_gm.calcTotalCrossSection( interactionpars, dircry, g.m_normals, ibegin, iend );
+    }
+    if ( xs > 0.0 ) {
+      fc.xs_commul = ( xs_commul += xs );
+      famcontribs.push_back( fc );
+    }
+  };
+  if ( use_index ) {
+    std::size_t ifam = 0;
+    for ( std::size_t i = 0; i < candidates.size(); ) {
+      while ( g.m_famOffsets[ifam+1] <= candidates[i] )
+        ++ifam;
+      const std::size_t offset_next = g.m_famOffsets[ifam+1];
+      const std::size_t ibegin = i;
+      while ( i < candidates.size() && candidates[i] < offset_next )
+        ++i;
+      addFamily( ifam, ibegin, i );
+    }
+  } else {
+    for ( std::size_t ifam = 0; ifam < nfam; ++ifam )
+      addFamily( ifam, g.m_famOffsets[ifam], g.m_famOffsets[ifam+1] );
+  }
+  if ( famcontribs.empty() )
+    return false;
+
+  //Pick a family and then a deminormal within it, using the same random
+  //number for both:
+  std::size_t ichosen = 0;
+  double rand_choice = -1.0;
+  if ( famcontribs.size() > 1 ) {
+    rand_choice = xs_commul * rng.generate();
+    auto it = std::lower_bound( famcontribs.begin(), famcontribs.end(), rand_choice,
+                                []( const Cache::FamContrib& fc, double v ) { return fc.xs_commul < v; } );
+    ichosen = std::min<std::size_t>( (std::size_t)( it - famcontribs.begin() ), famcontribs.size() - 1 );
+  }
+  const Cache::FamContrib& fc = famcontribs[ichosen];
+  const Geometry::ReflectionFamily& fam = g.m_reflfamilies[fc.ifam];
+  auto& scatcache = cachedb.scatcache;
+  auto& xs_commul_fam = cachedb.xs_commul;
+  scatcache.clear();
+  xs_commul_fam.clear();
+  interactionpars.set(wl, fam.inv2d, fam.xsfact);
+  if ( ichosen > 0 )
+    xs_commul_fam.push_back( famcontribs[ichosen-1].xs_commul );//offset
+  if ( use_index ) {
+    setNormals( fc );
+    m_gm.calcCrossSections( interactionpars, dircry, normals, scatcache, xs_commul_fam );
+  } else {
+    m_gm.calcCrossSections( interactionpars, dircry, g.m_normals, fc.ibegin, fc.iend, scatcache, xs_commul_fam );
+  }
+  if ( ichosen > 0 )
+    xs_commul_fam.erase( xs_commul_fam.begin() );
+  nc_assert( !scatcache.empty() && scatcache.size() == xs_commul_fam.size() );
+  std::size_t idx;
+  if ( rand_choice < 0.0 ) {
+    idx = pickRandIdxByWeight( rng, xs_commul_fam );
+  } else {
+    auto it = std::lower_bound( xs_commul_fam.begin(), xs_commul_fam.end(), rand_choice );
+    idx = std::min<std::size_t>( (std::size_t)( it - xs_commul_fam.begin() ), xs_commul_fam.size() - 1 );
+  }
+
+  m_gm.genScat( rng, scatcache[idx], wl, dircry, outdircry );
+  return true;
 }
 
-void NC::SCBragg::pimpl::genScat( Cache& cache, RNG& rng, NC::Vector& outdir ) const
+void NC::SCBragg::pimpl::genScat( CacheEntry& cache, RNG& rng, NC::Vector& outdircry ) const
 {
   nc_assert(!cache.xs_commul.empty());
   nc_assert(cache.xs_commul.back()>0.0);
   nc_assert(cache.xs_commul.size()==cache.scatcache.size());
 
-  std::size_t idx = pickRandIdxByWeight(rng,cache.xs_commul);
+  std::size_t idx = cache.picker.pick(rng,cache.xs_commul);
   nc_assert(idx<cache.scatcache.size());
   GaussMos::ScatCache& chosen_scatcache = cache.scatcache[idx];
 
-  m_gm.genScat( rng, chosen_scatcache, cache.wl, cache.dir, outdir );
+  m_gm.genScat( rng, chosen_scatcache, cache.wl, cache.dircry, outdircry );
+}
+
+void NC::SCBragg::pimpl::toCrystalFrameMany( const double* ux, const double* uy, const double* uz,
+                                             std::size_t n, double* cx, double* cy, double* cz ) const
+{
+  for ( std::size_t i = 0; i < n; ++i ) {
+    Vector d( ux[i], uy[i], uz[i] );
+    d.normalise();
+    cx[i] = d.x();
+    cy[i] = d.y();
+    cz[i] = d.z();
+  }
+  m_lab2cry.rotateMany( cx, cy, cz, cx, cy, cz, n );
+}
+
+bool NC::SCBragg::pimpl::sampleCry( Cache& cachedb, RNG& rng, NeutronEnergy ekin,
+                                    const NC::Vector& dir, const NC::Vector* dircry,
+                                    NC::Vector& outdircry ) const
+{
+  if ( ekin.get() <= m_threshold_ekin ) {
+    //Scatterings not actually possible at this configuration:
+    return false;
+  }
+
+  const double ekin_rounded = SCBragg_cacheRound(ekin.get());
+  CacheEntry * found = findCacheEntry( cachedb, ekin_rounded, dir );
+  if ( !found ) {
+    //Sampling at a new state (e.g. after a forced collision) does not need the
+    //contributions of all deminormals. However, if the same new state is
+    //sampled again, we assume that more will follow and fill a cache entry
+    //instead:
+    const bool repeated = ( cachedb.uncached_ekin == ekin_rounded
+                            && SCBragg_sameDir( dir, cachedb.uncached_dir ) );
+    if ( !repeated ) {
+      NCRYSTAL_COUNT(SCBraggCacheMiss);
+      cachedb.uncached_ekin = ekin_rounded;
+      cachedb.uncached_dir = dir;
+      return sampleUncached( cachedb, ekin_rounded, dircry ? *dircry : toCrystalFrame( dir ), rng, outdircry );
+    }
+  }
+
+  if ( found )
+    NCRYSTAL_COUNT(SCBraggCacheHit);
+  //Reuse the entry already found rather than repeating the lookup:
+  auto& cache = ( found ? *found : updateCache( cachedb, ekin, dir, dircry ) );
+
+  if ( cache.xs_commul.empty() || cache.xs_commul.back()<=0.0 ) {
+    //Again, scatterings are not actually possible here:
+    return false;
+  }
+
+  genScat( cache, rng, outdircry );
+  return true;
 }
 
 NC::EnergyDomain NC::SCBragg::domain() const noexcept
@@ -294,28 +815,123 @@ NC::CrossSect NC::SCBragg::crossSection(CachePtr& cp, NeutronEnergy ekin, const
 {
   if ( ekin.get() <= m_pimpl->m_threshold_ekin )
     return CrossSect{ 0.0 };
-  auto& cache = accessCache<pimpl::Cache>(cp);
-  m_pimpl->updateCache( cache, ekin, dir.as<Vector>() );
+  auto& cache = m_pimpl->updateCache( accessCache<pimpl::Cache>(cp), ekin, dir.as<Vector>() );
   return CrossSect{ cache.xs_commul.empty() ? 0.0 : cache.xs_commul.back() };
 }
 
+NC::CrossSect NC::SCBragg::majorantCrossSection( EnergyDomain d ) const
+{
+  if ( d.ehigh.get() <= m_pimpl->m_threshold_ekin )
+    return CrossSect{ 0.0 };
+  const double wl_max = ekin2wl( ncmax( d.elow.get(), m_pimpl->m_threshold_ekin ) );
+  const double wl_min = ekin2wl( d.ehigh.get() );
+  double xs = 0.0;
+  const auto& g = *m_pimpl->m_geom;
+  const auto& famOffsets = g.m_famOffsets;
+  for ( std::size_t ifam = 0; ifam < g.m_reflfamilies.size(); ++ifam ) {
+    const auto& fam = g.m_reflfamilies[ifam];
+    if ( fam.inv2d * wl_min >= 1.0 )
+      break;//stop here, no more families fulfill w<2d requirement.
+    //Both the normal and anti-normal of each deminormal might contribute:
+    const std::size_t nnormals = famOffsets[ifam+1] - famOffsets[ifam];
+    xs += 2.0 * nnormals * m_pimpl->m_gm.calcMaxCrossSectionValue( wl_max, fam.inv2d, fam.xsfact );
+  }
+  return CrossSect{ xs };
+}
+
+void NC::SCBragg::Geometry::accountMemory( MemoryFootprint& mf ) const
+{
+  mf.add( sizeof(Geometry)
+          + m_bins.size() * sizeof(AngularBin)
+          + m_binEntries.size() * sizeof(uint32_t)
+          + ( m_binEntryInv2d.size() + m_faminv2d.size() + 3 * m_normals.size() ) * sizeof(double)
+          + m_famOffsets.size() * sizeof(std::size_t)
+          + m_reflfamilies.size() * sizeof(ReflectionFamily) );
+}
+
+void NC::SCBragg::accountMemory( MemoryFootprint& mf ) const
+{
+  mf.add( sizeof(SCBragg) + sizeof(pimpl) );
+  mf.addSharedObject( m_pimpl->m_geom );
+}
+
 NC::ScatterOutcome NC::SCBragg::sampleScatter( CachePtr& cp, RNG& rng, NeutronEnergy ekin, const NeutronDirection& indir ) const
 {
-  if ( ekin.get() <= m_pimpl->m_threshold_ekin ) {
+  const Vector& dir = indir.as<Vector>();
+  Vector outdircry;
+  if ( !m_pimpl->sampleCry( accessCache<pimpl::Cache>(cp), rng, ekin, dir, nullptr, outdircry ) ) {
     //Scatterings not actually possible at this configuration, so don't change
     //state:
     return { ekin, indir };
   }
+  //Rotate the result to the lab frame:
+  NeutronDirection outdir;
+  outdir.as<Vector>() = m_pimpl->m_cry2lab * outdircry;
+  outdir.as<Vector>().normalise();
+  return { ekin, outdir };
+}
 
-  auto& cache = accessCache<pimpl::Cache>(cp);
-  m_pimpl->updateCache( cache, ekin, indir.as<Vector>() );
-
-  if ( cache.xs_commul.empty() || cache.xs_commul.back()<=0.0 ) {
-    //Again, scatterings are not actually possible here:
-    return { ekin, indir };
+void NC::SCBragg::evalManyXS( CachePtr& cp, const double* ekin,
+                              const double* ux, const double* uy, const double* uz,
+                              std::size_t N, double* out_xs ) const
+{
+  auto& cachedb = accessCache<pimpl::Cache>(cp);
+  const double threshold_ekin = m_pimpl->m_threshold_ekin;
+  constexpr std::size_t nchunk = 128;
+  double cx[nchunk], cy[nchunk], cz[nchunk];
+  for ( std::size_t offset = 0; offset < N; offset += nchunk ) {
+    const std::size_t n = std::min<std::size_t>( nchunk, N - offset );
+    m_pimpl->toCrystalFrameMany( ux + offset, uy + offset, uz + offset, n, cx, cy, cz );
+    for ( std::size_t j = 0; j < n; ++j ) {
+      const std::size_t i = offset + j;
+      if ( ekin[i] <= threshold_ekin ) {
+        out_xs[i] = 0.0;
+        continue;
+      }
+      const Vector dircry( cx[j], cy[j], cz[j] );
+      auto& cache = m_pimpl->updateCache( cachedb, NeutronEnergy{ekin[i]}, Vector( ux[i], uy[i], uz[i] ), &dircry );
+      out_xs[i] = ( cache.xs_commul.empty() ? 0.0 : cache.xs_commul.back() );
+    }
   }
+}
 
-  NeutronDirection outdir;
-  m_pimpl->genScat( cache, rng, outdir.as<Vector>() );
-  return { ekin, outdir };
+void NC::SCBragg::sampleScatterMany( CachePtr& cp, RNG& rng, double* ekin,
+                                     double* ux, double* uy, double* uz,
+                                     std::size_t N ) const
+{
+  if ( useLegacyRandSampling() )
+    return ScatterAnisotropicMat::sampleScatterMany( cp, rng, ekin, ux, uy, uz, N );
+  auto& cachedb = accessCache<pimpl::Cache>(cp);
+  constexpr std::size_t nchunk = 128;
+  double cx[nchunk], cy[nchunk], cz[nchunk];
+  std::size_t scattered[nchunk];
+  for ( std::size_t offset = 0; offset < N; offset += nchunk ) {
+    const std::size_t n = std::min<std::size_t>( nchunk, N - offset );
+    m_pimpl->toCrystalFrameMany( ux + offset, uy + offset, uz + offset, n, cx, cy, cz );
+    //Sample in the crystal frame, collecting the outgoing directions of
+    //neutrons which actually scattered at the front of the arrays:
+    std::size_t nscat = 0;
+    for ( std::size_t j = 0; j < n; ++j ) {
+      const std::size_t i = offset + j;
+      const Vector dircry( cx[j], cy[j], cz[j] );
+      Vector outdircry;
+      if ( !m_pimpl->sampleCry( cachedb, rng, NeutronEnergy{ekin[i]}, Vector( ux[i], uy[i], uz[i] ),
+                                &dircry, outdircry ) )
+        continue;//state unchanged
+      cx[nscat] = outdircry.x();
+      cy[nscat] = outdircry.y();
+      cz[nscat] = outdircry.z();
+      scattered[nscat++] = i;
+    }
+    //Rotate them all to the lab frame:
+    m_pimpl->m_cry2lab.rotateMany( cx, cy, cz, cx, cy, cz, nscat );
+    for ( std::size_t k = 0; k < nscat; ++k ) {
+      Vector outdir( cx[k], cy[k], cz[k] );
+      outdir.normalise();
+      const std::size_t i = scattered[k];
+      ux[i] = outdir.x();
+      uy[i] = outdir.y();
+      uz[i] = outdir.z();
+    }
+  }
 }
@@ -55,15 +55,15 @@ void NCrystal::CubicSpline::set( const VectD& y,
     y2[km1] *= y2[k];
     y2[km1] += u[km1];
   }
-  std::vector<PairDD > data;
-  data.reserve(y.size());
-  for (std::size_t i = 0; i < y.size(); ++i) {
-    data.push_back(std::make_pair(y[i],y2[i]));
-    nc_assert(!ncisnan(data.back().first));
-    nc_assert(!ncisnan(data.back().second));
+#ifndef NDEBUG
+  for (std::size_t i = 0; i < n; ++i) {
+    nc_assert(!ncisnan(y[i]));
+    nc_assert(!ncisnan(y2[i]));
   }
+#endif
   //all good, set:
-  std::swap(m_data,data);
+  m_y = y;
+  std::swap(m_y2,y2);
   m_nm2 = n-2;
 }
 
@@ -162,13 +162,13 @@ void NCrystal::SplinedLookupTable::producefile( const Fct1D* thefct,
   ofs << "#fprime_a = "<<fprime_a<<"\n";
   ofs << "#fprime_b = "<<fprime_b<<"\n";
   ofs << "#input_fvals = ";
-  for (std::size_t i = 0; i < m_spline.m_data.size(); ++i)
-    ofs<<" "<<m_spline.m_data[i].first;
+  for (std::size_t i = 0; i < m_spline.m_y.size(); ++i)
+    ofs<<" "<<m_spline.m_y[i];
   ofs << "\n#data_colums = x,spline_of_x";
   if (thefct)
     ofs <<",truefct_of_x";
   ofs<<"\n";
-  std::size_t numpts = 100*m_spline.m_data.size();
+  std::size_t numpts = 100*m_spline.m_y.size();
   if (numpts>1000000)
     numpts = std::max<std::size_t>(numpts/10,1000000);
   double delta = (m_b-m_a)/(numpts-1.0);
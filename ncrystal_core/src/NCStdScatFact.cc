@@ -33,6 +33,8 @@
 #include "NCrystal/internal/NCSABScatter.hh"
 #include "NCrystal/internal/NCSABFactory.hh"
 #include "NCrystal/internal/NCString.hh"//for safe_str2dbl
+#include "NCrystal/internal/NCThreadUtils.hh"
+#include <mutex>
 
 namespace NC = NCrystal;
 
@@ -74,6 +76,34 @@ namespace NCrystal {
       return false;
     }
 
+    void getAllPlanes( PlaneList& pl ) final
+    {
+      m_withheldPlanes.clear();
+      m_pp->getAllPlanes( pl );
+      //Remove withheld planes in place, keeping the order of the rest:
+      std::size_t nkept = 0;
+      for ( std::size_t i = 0; i < pl.size(); ++i ) {
+        const double dspacing = pl.dspacings[i];
+        if ( dspacing>=m_dcut ) {
+          if ( nkept != i ) {
+            pl.dspacings[nkept] = dspacing;
+            pl.fsquareds[nkept] = pl.fsquareds[i];
+            pl.demi_normals[nkept] = pl.demi_normals[i];
+          }
+          ++nkept;
+        } else {
+          const double fsq = 2*pl.fsquareds[i];//demi-normals, e.g. only half of the normals.
+          if (m_withheldPlanes.empty()||m_withheldPlanes.back().first!=dspacing)
+            m_withheldPlanes.emplace_back(dspacing,fsq);
+          else
+            m_withheldPlanes.back().second += fsq;
+        }
+      }
+      pl.dspacings.resize(nkept);
+      pl.fsquareds.resize(nkept);
+      pl.demi_normals.resize(nkept);
+    }
+
     virtual void prepareLoop() { m_pp->prepareLoop(); m_withheldPlanes.clear(); }
     virtual bool canProvide() const { return m_pp->canProvide(); }
 
@@ -87,6 +117,49 @@ namespace NCrystal {
     PCBragg::VectDFM m_withheldPlanes;
   };
 
+  struct SharedSCBraggGeometry {
+    optional_shared_obj<const SCBragg::Geometry> geom;
+    ProcImpl::OptionalProcPtr pcbragg;//for planes withheld by sccutoff (if any)
+  };
+
+  SharedSCBraggGeometry getSharedSCBraggGeometry( const Info& info, double sccutoff,
+                                                  PlaneProvider * pp, PlaneProviderWCutOff* ppwcutoff )
+  {
+    //Keep weak references to the most recently used geometries, so they can be
+    //reused as long as any Scatter object still keeps them alive:
+    struct Entry {
+      std::weak_ptr<const SCBragg::Geometry> geom;
+      std::weak_ptr<const ProcImpl::Process> pcbragg;
+      bool has_pcbragg;
+    };
+    static std::mutex s_mutex;
+    static std::map<std::pair<UniqueIDValue,double>,Entry> s_db;
+    const auto key = std::make_pair( info.getUniqueID(), ppwcutoff ? sccutoff : 0.0 );
+    {
+      NCRYSTAL_LOCK_GUARD(s_mutex);
+      auto it = s_db.find( key );
+      if ( it != s_db.end() ) {
+        SharedSCBraggGeometry res{ it->second.geom.lock(), it->second.pcbragg.lock() };
+        if ( res.geom != nullptr && ( res.pcbragg != nullptr || !it->second.has_pcbragg ) )
+          return res;
+      }
+    }
+    SharedSCBraggGeometry res{ SCBragg::createGeometry( info, pp ).getsp(), nullptr };
+    if ( ppwcutoff && ppwcutoff->hasPlanesWithheldInLastLoop() ) {
+      nc_assert_always(info.hasStructureInfo());
+      res.pcbragg = makeSO<PCBragg>(info.getStructureInfo(),ppwcutoff->consumePlanesWithheldInLastLoop());
+    }
+    NCRYSTAL_LOCK_GUARD(s_mutex);
+    for ( auto it = s_db.begin(); it != s_db.end(); ) {
+      if ( it->second.geom.expired() )
+        it = s_db.erase( it );
+      else
+        ++it;
+    }
+    s_db[key] = Entry{ res.geom, res.pcbragg, res.pcbragg != nullptr };
+    return res;
+  }
+
   class StdScatFact : public FactImpl::ScatterFactory {
   public:
     const char * name() const noexcept final { return "stdscat"; }
@@ -109,15 +182,24 @@ namespace NCrystal {
 
       nc_assert_always(isOneOf(inelas,"none","external","dyninfo","vdosdebye","freegas"));
 
-      //Collect components:
-      ProcImpl::ProcComposition::ComponentList components;
+      //Collect components. Their construction (which can be expensive, in
+      //particular for scattering kernels) is deferred to a list of independent
+      //tasks, which are afterwards carried out concurrently if requested (see
+      //NCThreadUtils.hh). The resulting components are combined in the order in
+      //which the tasks were added, so results do not depend on the number of
+      //threads used:
+      std::vector<std::function<void(ComponentList&)>> tasks;
+      auto addComponent = [&tasks]( double scale, std::function<ProcImpl::ProcPtr()> create )
+      {
+        tasks.emplace_back( [scale,create]( ComponentList& cl ) { cl.push_back( { scale, create() } ); } );
+      };
 
       ///////////////////////////////////////////////////////////////////////////////////////////////////////////
       //Incoherent-elastic component:
       if ( cfg.get_incoh_elas() && info.isCrystalline() ) {
         const bool has_msd = info.hasAtomMSD() || ( info.hasTemperature() && info.hasDebyeTemperature() );
         if ( has_msd )
-          components.push_back({1.0,makeSO<ElIncScatter>(ElIncScatter::msd_from_atominfo_t(),info)});
+          addComponent( 1.0, [&info](){ return makeSO<ElIncScatter>(ElIncScatter::msd_from_atominfo_t(),info); } );
       }
 
       if ( info.countCustomSections( "SPECIALINCOHELAS" ) > 0 ) {
@@ -166,9 +248,11 @@ namespace NCrystal {
             include_sigma_coh = true;
           }
           if (has_atominfo_msd)
-            components.push_back({1.0,makeSO<ElIncScatter>(ElIncScatter::msd_from_atominfo_t(),info,scale_factor, include_sigma_coh)});
+            addComponent( 1.0, [&info,scale_factor,include_sigma_coh]()
+                          { return makeSO<ElIncScatter>(ElIncScatter::msd_from_atominfo_t(),info,scale_factor, include_sigma_coh); } );
           else
-            components.push_back({1.0,makeSO<ElIncScatter>(ElIncScatter::msd_from_dyninfo_t(),info,scale_factor, include_sigma_coh)});
+            addComponent( 1.0, [&info,scale_factor,include_sigma_coh]()
+                          { return makeSO<ElIncScatter>(ElIncScatter::msd_from_dyninfo_t(),info,scale_factor, include_sigma_coh); } );
         }
       }
 
@@ -177,41 +261,139 @@ namespace NCrystal {
       //Coherent-elastic (Bragg) component:
       if ( cfg.get_coh_elas() && info.isCrystalline() && info.hasHKLInfo() ) {
         if (cfg.isSingleCrystal()) {
-          //TODO: factory function somewhere for this, so can be easily created directly in test-code wo matcfg?
-          auto sc_pp = createStdPlaneProvider( ana.info );
-          PlaneProviderWCutOff* ppwcutoff(nullptr);
-          nc_assert(info.hasHKLInfo());
-          if ( cfg.get_sccutoff() && cfg.get_sccutoff() > info.hklDMinVal() ) {
-            //Improve efficiency by treating planes with dspacing less than
-            //sccutoff as having isotropic mosaicity distribution.
-            auto tmp = std::make_unique<PlaneProviderWCutOff>(cfg.get_sccutoff(),std::move(sc_pp));
-            ppwcutoff = tmp.get();
-            sc_pp = std::move(tmp);
-            nc_assert( sc_pp!=nullptr && (void*)sc_pp.get()==(void*)ppwcutoff );
-          }
-          SCOrientation sco = cfg.createSCOrientation();
-          if (cfg.isLayeredCrystal()) {
-            components.push_back({1.0,makeSO<LCBragg>( info, sco, cfg.get_mos(), cfg.get_lcaxis(), cfg.get_lcmode(),
-                                                       0,sc_pp.get(),cfg.get_mosprec(),0.0 )});
-          } else {
-            components.push_back({1.0,makeSO<SCBragg>( info, sco,cfg.get_mos(),0.0,
-                                                       sc_pp.get(),cfg.get_mosprec(),0.)});
-
-
-          }
-          if ( ppwcutoff && ppwcutoff->hasPlanesWithheldInLastLoop() ) {
-            nc_assert_always(info.hasStructureInfo());
-            components.push_back({1.0,makeSO<PCBragg>(info.getStructureInfo(),ppwcutoff->consumePlanesWithheldInLastLoop())});
-          }
+          //Single task, since any PCBragg component for planes below sccutoff
+          //is only known after the SCBragg/LCBragg construction:
+          tasks.emplace_back( [&info,&cfg,&ana]( ComponentList& components )
+          {
+            //TODO: factory function somewhere for this, so can be easily created directly in test-code wo matcfg?
+            auto sc_pp = createStdPlaneProvider( ana.info );
+            PlaneProviderWCutOff* ppwcutoff(nullptr);
+            nc_assert(info.hasHKLInfo());
+            if ( cfg.get_sccutoff() && cfg.get_sccutoff() > info.hklDMinVal() ) {
+              //Improve efficiency by treating planes with dspacing less than
+              //sccutoff as having isotropic mosaicity distribution.
+              auto tmp = std::make_unique<PlaneProviderWCutOff>(cfg.get_sccutoff(),std::move(sc_pp));
+              ppwcutoff = tmp.get();
+              sc_pp = std::move(tmp);
+              nc_assert( sc_pp!=nullptr && (void*)sc_pp.get()==(void*)ppwcutoff );
+            }
+            SCOrientation sco = cfg.createSCOrientation();
+            if ( cfg.isLayeredCrystal() && cfg.get_lcmode() == 0 ) {
+              components.push_back({1.0,makeSO<LCBragg>( info, sco, cfg.get_mos(), cfg.get_lcaxis(), 0,
+                                                         0,sc_pp.get(),cfg.get_mosprec(),0.0,
+                                                         cfg.get_mostab(),
+                                                         cfg.get_lctabprec() )});
+            } else {
+              //The orientation-independent SCBragg geometry (and the PCBragg
+              //component for any withheld planes) is shared between all
+              //orientations and mosaicities of the same crystal. This includes
+              //layered crystals with lcmode!=0, whose models are built on an
+              //SCBragg model, so instances for different layer axes are cheap:
+              auto shared = getSharedSCBraggGeometry( info, cfg.get_sccutoff(), sc_pp.get(), ppwcutoff );
+              if ( cfg.isLayeredCrystal() ) {
+                components.push_back({1.0,makeSO<LCBragg>( info, sco, cfg.get_mos(), cfg.get_lcaxis(), cfg.get_lcmode(),
+                                                           0,nullptr,cfg.get_mosprec(),0.0,
+                                                           cfg.get_mostab(), 0.0,
+                                                           cfg.get_lcmode()<0 && cfg.get_lcfixedrot(),
+                                                           std::move(shared.geom) )});
+              } else {
+                components.push_back({1.0,makeSO<SCBragg>( info, sco,cfg.get_mos(),std::move(shared.geom),0.0,
+                                                           cfg.get_mosprec(),0.,
+                                                           cfg.get_mostab() )});
+              }
+              if ( shared.pcbragg != nullptr )
+                components.push_back({1.0,std::move(shared.pcbragg)});
+              return;
+            }
+            if ( ppwcutoff && ppwcutoff->hasPlanesWithheldInLastLoop() ) {
+              nc_assert_always(info.hasStructureInfo());
+              components.push_back({1.0,makeSO<PCBragg>(info.getStructureInfo(),ppwcutoff->consumePlanesWithheldInLastLoop())});
+            }
+          } );
         } else {
-          components.push_back({1.0,makeSO<PCBragg>(info)});
+          addComponent( 1.0, [&info,&cfg](){ return makeSO<PCBragg>(info,cfg.get_dbintol()); } );
           //NB: Layered polycrystals get same treatment as unlayered
           //polycrystals in our current modelling.
         }
       }
 
       ///////////////////////////////////////////////////////////////////////////////////////////////////////////
-      //Inelastic components:
+      //Inelastic components. By default these are constructed along with the
+      //other components, but if NCRYSTAL_LAZY_INELAS is set, their
+      //construction is deferred until the first time they are actually
+      //needed. Input validation still happens immediately, by running through
+      //the components without constructing them:
+      static const bool s_lazyInelas = ncgetenv_bool("LAZY_INELAS");
+      if ( s_lazyInelas ) {
+        unsigned ninelas = 0;
+        addInelasticComponents( ana.info, cfg, inelas, [&ninelas]( double, std::function<ProcImpl::ProcPtr()> ) { ++ninelas; } );
+        if ( ninelas > 0 ) {
+          auto infoptr = ana.info;
+          auto lazycfg = cfg;
+          auto lazyinelas = inelas;
+          addComponent( 1.0, [infoptr,lazycfg,lazyinelas]()
+          {
+            return makeSO<ProcImpl::LazyProcess>( MaterialType::Isotropic, ProcessType::Scatter,
+                                                  EnergyDomain{ NeutronEnergy{0.0}, NeutronEnergy{kInfinity} },
+                                                  [infoptr,lazycfg,lazyinelas]()
+                                                  {
+                                                    ComponentList cl;
+                                                    addInelasticComponents( infoptr, lazycfg, lazyinelas,
+                                                                            [&cl]( double scale, std::function<ProcImpl::ProcPtr()> create )
+                                                                            { cl.push_back( { scale, create() } ); } );
+                                                    return ProcImpl::ProcComposition::consumeAndCombine( std::move(cl),
+                                                                                                         ProcessType::Scatter );
+                                                  } );
+          } );
+        }
+      } else {
+        addInelasticComponents( ana.info, cfg, inelas, addComponent );
+      }
+
+      ///////////////////////////////////////////////////////////////////////////////////////////////////////////
+      //Construct components and wrap it up:
+      std::vector<ComponentList> task_components( tasks.size() );
+      parallelFor( tasks.size(), getNThreadsFromEnv(),
+                   [&tasks,&task_components]( std::size_t i ) { tasks[i]( task_components[i] ); } );
+      ComponentList components;
+      for ( auto& tc : task_components )
+        for ( auto& c : tc )
+          components.push_back( std::move(c) );
+      auto result = ProcImpl::ProcComposition::consumeAndCombine( std::move(components), ProcessType::Scatter );
+      const double xstabprec = cfg.get_xstabprec();
+      auto result_pc = dynamic_cast<const ProcImpl::ProcComposition*>( result.get() );
+      if ( xstabprec > 0.0 && result_pc && result_pc->materialType() == MaterialType::Isotropic ) {
+        //Recreate with precomputed cross section table:
+        auto pc = makeSO<ProcImpl::ProcComposition>( ProcImpl::ProcComposition::ComponentList{SVAllowCopy,result_pc->components()},
+                                                     ProcessType::Scatter );
+        pc->enableXSTable( xstabprec );
+        return pc;
+      }
+      const double xsquant = cfg.get_xsquant();
+      if ( xsquant > 0.0 && result->materialType() == MaterialType::Anisotropic ) {
+        //Recreate with quantised cross section evaluations (wrapping a single
+        //component if needed):
+        ComponentList cl;
+        if ( result_pc )
+          cl = ComponentList{ SVAllowCopy, result_pc->components() };
+        else
+          cl.push_back( { 1.0, result } );
+        auto pc = makeSO<ProcImpl::ProcComposition>( std::move(cl), ProcessType::Scatter );
+        pc->enableXSQuantisation( xsquant );
+        return pc;
+      }
+      return result;
+    }
+
+  private:
+    using ComponentList = ProcImpl::ProcComposition::ComponentList;
+    using AddComponentFct = std::function<void(double,std::function<ProcImpl::ProcPtr()>)>;
+
+    static void addInelasticComponents( const shared_obj<const Info>& infoptr, const MatCfg& cfg,
+                                        const std::string& inelas,
+                                        const AddComponentFct& addComponent )
+    {
+      const Info& info = infoptr;
       if ( inelas == "none" ) {
 
         //do not add anything.
@@ -221,7 +403,7 @@ namespace NCrystal {
           NCRYSTAL_THROW2(BadInput,"inelas="<<inelas<<" mode requires input source which provides direct"
                           " parameterisation of (non-Bragg) scattering cross sections (try e.g. inelas=auto instead)");
 
-        components.push_back({1.0,makeSO<BkgdExtCurve>(ana.info)});
+        addComponent( 1.0, [infoptr](){ return makeSO<BkgdExtCurve>(infoptr); } );
 
       } else {
         nc_assert_always( isOneOf(inelas,"dyninfo","freegas", "vdosdebye" ) );
@@ -241,11 +423,31 @@ namespace NCrystal {
           for (auto& di : info.getDynamicInfoList()) {
             const DI_ScatKnl* di_scatknl = dynamic_cast<const DI_ScatKnl*>(di.get());
             if (di_scatknl) {
-              components.push_back({di->fraction(),makeSO<SABScatter>(*di_scatknl, cfg.get_vdoslux())});
+              const bool canInterpolateT = ( dynamic_cast<const DI_VDOS*>(di_scatknl)
+                                             || dynamic_cast<const DI_VDOSDebye*>(di_scatknl) );
+              if ( canInterpolateT && cfg.get_sabtinterp() > 0.0 )
+                addComponent( di->fraction(), [di_scatknl,&cfg]()
+                              {
+                                return SABTInterpScatter::createOnTemperatureGrid( *di_scatknl,
+                                                                                   cfg.get_sabtinterp(),
+                                                                                   cfg.get_vdoslux(),
+                                                                                   cfg.get_sabalias(),
+                                                                                   cfg.get_vdosthintol(),
+                                                                                   cfg.get_sabfloat32() );
+                              } );
+              else
+                addComponent( di->fraction(), [di_scatknl,&cfg]()
+                              {
+                                return makeSO<SABScatter>( *di_scatknl, cfg.get_vdoslux(), true,
+                                                           cfg.get_sabalias(), cfg.get_vdosthintol(),
+                                                           cfg.get_sabfloat32() );
+                              } );
             } else if (dynamic_cast<const DI_Sterile*>(di.get())) {
               continue;//just skip past sterile components
             } else if (dynamic_cast<const DI_FreeGas*>(di.get())) {
-              components.push_back({di->fraction(),makeSO<FreeGas>(info.getTemperature(), di->atomData())});
+              const DynamicInfo* dip = di.get();
+              addComponent( di->fraction(), [dip,&info,&cfg]()
+                            { return makeSO<FreeGas>(info.getTemperature(), dip->atomData(), cfg.get_fgtab()); } );
             } else {
               NCRYSTAL_THROW(LogicError,"Unsupported DynamicInfo entry encountered.");
             }
@@ -254,7 +456,9 @@ namespace NCrystal {
         } else if ( inelas=="freegas" ) {
 
           for ( auto& e : info.getComposition() ) {
-            components.push_back({e.fraction,makeSO<FreeGas>(info.getTemperature(), e.atom.data())});
+            const auto* atom = &e.atom;
+            addComponent( e.fraction, [atom,&info,&cfg]()
+                          { return makeSO<FreeGas>(info.getTemperature(), atom->data(), cfg.get_fgtab()); } );
           }
 
         } else {
@@ -271,24 +475,37 @@ namespace NCrystal {
             ntot += it->numberPerUnitCell();
           for (auto it = info.atomInfoBegin(); it!= info.atomInfoEnd(); ++it) {
             nc_assert_always( it->debyeTemp().has_value() );
-            auto sabdata =  extractSABDataFromVDOSDebyeModel( it->debyeTemp().value(),
-                                                              info.getTemperature(),
-                                                              it->atomData().scatteringXS(),
-                                                              it->atomData().averageMassAMU(),
-                                                              cfg.get_vdoslux() );
-            auto scathelper = SAB::createScatterHelperWithCache( std::move(sabdata) );
-            components.push_back({it->numberPerUnitCell()*1.0/ntot,makeSO<SABScatter>(std::move(scathelper))});
+            auto helperAtT = [it,&cfg](Temperature t)
+            {
+              auto sabdata =  extractSABDataFromVDOSDebyeModel( it->debyeTemp().value(),
+                                                                t,
+                                                                it->atomData().scatteringXS(),
+                                                                it->atomData().averageMassAMU(),
+                                                                cfg.get_vdoslux(),
+                                                                true,
+                                                                cfg.get_vdosthintol() );
+              return SAB::createScatterHelperWithCache( std::move(sabdata), nullptr,
+                                                        ( cfg.get_sabalias()
+                                                          ? SAB::SamplerAtEType::AliasTable
+                                                          : SAB::SamplerAtEType::Alg1 ),
+                                                        cfg.get_sabfloat32() );
+            };
+            if ( cfg.get_sabtinterp() > 0.0 )
+              addComponent( it->numberPerUnitCell()*1.0/ntot, [helperAtT,&info,&cfg]()
+                            {
+                              return SABTInterpScatter::createOnTemperatureGrid( info.getTemperature(),
+                                                                                 cfg.get_sabtinterp(),
+                                                                                 helperAtT );
+                            } );
+            else
+              addComponent( it->numberPerUnitCell()*1.0/ntot, [helperAtT,&info]()
+                            { return makeSO<SABScatter>(helperAtT(info.getTemperature())); } );
 
           }
         }
       }
-
-      ///////////////////////////////////////////////////////////////////////////////////////////////////////////
-      //Wrap it up and return:
-      return ProcImpl::ProcComposition::consumeAndCombine( std::move(components), ProcessType::Scatter );
     }
 
-  private:
     //Common analysis function shared between canCreateScatter and createScatter
     //methods.
     struct CfgAnalysis {
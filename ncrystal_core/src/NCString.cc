@@ -21,6 +21,8 @@
 #include "NCrystal/internal/NCString.hh"
 #include "NCrystal/internal/NCMath.hh"
 #include <cstring>
+#include <cfloat>
+#include <clocale>
 #include <istream>
 #include <iomanip>
 #include <cstdlib>
@@ -76,47 +78,62 @@ NC::VectS NC::split2( const std::string& input, std::size_t maxsplit,  char sep
   return output;
 }
 
-void NC::split(NC::VectS& output, const std::string& input, std::size_t maxsplit, char sep )
-{
-  bool keep_empty = (sep!=0);
-  //Split input on whitespace (" \t\n") with minimal memory allocations and
-  //copying, discarding whitespace which is either leading and trailing or
-  //repeating.
-  nc_assert(bool(sep!='\0')==bool(sep));
-  output.clear();
-
-  if (input.empty()) {
-    if (sep)
-      output.emplace_back();
-    return;
-  }
+namespace NCrystal {
+  namespace {
+    template<class TVect>
+    void splitImpl( TVect& output, StrView input, std::size_t maxsplit, char sep )
+    {
+      bool keep_empty = (sep!=0);
+      //Split input on whitespace (" \t\n") with minimal memory allocations and
+      //copying, discarding whitespace which is either leading and trailing or
+      //repeating.
+      nc_assert(bool(sep!='\0')==bool(sep));
+      output.clear();
+
+      if (input.empty()) {
+        if (sep)
+          output.emplace_back();
+        return;
+      }
 
-  if (sep&&input[0]==sep)
-    output.emplace_back();
-  const char * c = &input[0];
-  const char * cE = c + input.size();
-  const char * partbegin = 0;
-  while (true) {
-    if ( maxsplit && output.size() == maxsplit ) {
-      output.emplace_back(c);
-      return;
-    }
-    if (c==cE||(sep?*c==sep:(*c==' '||*c=='\t'||*c=='\n'||*c=='\r'))) {
-      if (partbegin) {
-        if (keep_empty||c>partbegin) {
-          output.emplace_back(partbegin,c-partbegin);
+      if (sep&&input[0]==sep)
+        output.emplace_back();
+      const char * c = input.begin();
+      const char * cE = input.end();
+      const char * partbegin = 0;
+      while (true) {
+        if ( maxsplit && output.size() == maxsplit ) {
+          output.emplace_back(c,cE-c);
+          return;
+        }
+        if (c==cE||(sep?*c==sep:(*c==' '||*c=='\t'||*c=='\n'||*c=='\r'))) {
+          if (partbegin) {
+            if (keep_empty||c>partbegin) {
+              output.emplace_back(partbegin,c-partbegin);
+            }
+            partbegin= keep_empty ? c+1 : 0;
+          }
+          if (c==cE)
+            return;
+        } else if (!partbegin) {
+          partbegin = c;
         }
-        partbegin= keep_empty ? c+1 : 0;
+        ++c;
       }
-      if (c==cE)
-        return;
-    } else if (!partbegin) {
-      partbegin = c;
     }
-    ++c;
   }
 }
 
+void NC::split(NC::VectS& output, const std::string& input, std::size_t maxsplit, char sep )
+{
+  splitImpl( output, input, maxsplit, sep );
+}
+
+void NC::splitViews( std::vector<StrView>& output, StrView input, std::size_t maxsplit, char sep )
+{
+  splitImpl( output, input, maxsplit, sep );
+}
+
 bool NC::startswith(const std::string& str, const std::string& substr)
 {
   return str.size()>=substr.size() && str.compare(0, substr.size(), substr) == 0;
@@ -150,6 +167,77 @@ bool NC::contains_any(const std::string& haystack, const std::string& needles)
 namespace NCrystal {
   namespace {
 
+    enum class FastStr2Dbl { Done, PlainDecimal, Other };
+    FastStr2Dbl fast_str2dbl( const char * c, const char * cE, double& result )
+    {
+      //Fast locale-independent conversion of plain decimal numbers like
+      //"-1.234e-05", for the (very common) case where the significant digits
+      //fit in 53 bits and the decimal exponent is small enough that a single
+      //multiplication or division by an exactly representable power of ten
+      //gives a correctly rounded result (Clinger's fast path). Other plain
+      //decimal numbers are flagged as such, so callers can use strtod rather
+      //than the slower stream-based conversion which must be used for
+      //anything else (whitespace, "inf", syntax errors, ...).
+      auto isDigit = []( char ch ) { return ch >= '0' && ch <= '9'; };
+      if ( c == cE )
+        return FastStr2Dbl::Other;
+      const bool neg = ( *c == '-' );
+      if ( neg || *c == '+' )
+        ++c;
+      uint64_t mantissa = 0;
+      unsigned ndigits = 0;//significant digits, excluding leading zeroes
+      int exp10 = 0;
+      bool anyDigits = false;
+      auto addDigit = [&mantissa,&ndigits]( char ch )
+      {
+        if ( ( ndigits || ch != '0' ) && ++ndigits <= 19 )
+          mantissa = mantissa * 10 + static_cast<unsigned>( ch - '0' );
+      };
+      for ( ; c != cE && isDigit(*c); ++c ) {
+        anyDigits = true;
+        addDigit( *c );
+      }
+      if ( c != cE && *c == '.' ) {
+        for ( ++c; c != cE && isDigit(*c); ++c ) {
+          anyDigits = true;
+          addDigit( *c );
+          --exp10;
+        }
+      }
+      if ( !anyDigits )
+        return FastStr2Dbl::Other;
+      if ( c != cE && ( *c == 'e' || *c == 'E' ) ) {
+        ++c;
+        const bool expneg = ( c != cE && *c == '-' );
+        if ( c != cE && ( expneg || *c == '+' ) )
+          ++c;
+        if ( c == cE || !isDigit(*c) )
+          return FastStr2Dbl::Other;
+        int e = 0;
+        for ( ; c != cE && isDigit(*c); ++c )
+          e = std::min( e * 10 + ( *c - '0' ), 100000 );
+        exp10 += ( expneg ? -e : e );
+      }
+      if ( c != cE )
+        return FastStr2Dbl::Other;
+#if defined(FLT_EVAL_METHOD) && FLT_EVAL_METHOD == 0
+      //(the fast path is only safe without extended precision intermediates)
+      static const double s_pow10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7,
+                                        1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14,
+                                        1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21,
+                                        1e22 };
+      if ( ndigits <= 19 && mantissa <= ( uint64_t(1) << 53 )
+           && ( mantissa == 0 || ( exp10 >= -22 && exp10 <= 22 ) ) ) {
+        double val = static_cast<double>( mantissa );
+        if ( mantissa != 0 )
+          val = ( exp10 < 0 ? val / s_pow10[-exp10] : val * s_pow10[exp10] );
+        result = ( neg ? -val : val );
+        return FastStr2Dbl::Done;
+      }
+#endif
+      return FastStr2Dbl::PlainDecimal;
+    }
+
   }
 }
 
@@ -161,6 +249,68 @@ double NC::str2dbl(const std::string& s,const char * errmsg)
   return result;
 }
 
+double NC::str2dbl(StrView s,const char * errmsg)
+{
+  double result;
+  if ( !safe_str2dbl(s, result ) )
+    NCRYSTAL_THROW2(BadInput,(errmsg?errmsg:"Invalid number in string is not a double")<<": \""<<s<<"\"");
+  return result;
+}
+
+int NC::str2int(StrView s,const char * errmsg)
+{
+  int result;
+  if ( !safe_str2int(s, result ) )
+    NCRYSTAL_THROW2(BadInput,(errmsg?errmsg:"Invalid number in string is not an integer")<<": \""<<s<<"\"");
+  return result;
+}
+
+bool NC::safe_str2dbl(StrView s, double& result )
+{
+  switch ( fast_str2dbl( s.begin(), s.end(), result ) ) {
+  case FastStr2Dbl::Done:
+    return true;
+  case FastStr2Dbl::PlainDecimal:
+    if ( s.size() < 64 && *std::localeconv()->decimal_point == '.' ) {
+      //Null-terminated copy on the stack for strtod (with the same
+      //overflow/underflow treatment as in the std::string version):
+      char buf[64];
+      std::memcpy( buf, s.data(), s.size() );
+      buf[s.size()] = '\0';
+      char * endptr;
+      double val = std::strtod( buf, &endptr );
+      if ( endptr != buf + s.size() || ncisinf(val) )
+        return false;
+      result = val;
+      return true;
+    }
+    break;
+  case FastStr2Dbl::Other:
+    break;
+  }
+  //Anything else (rare) is handled by the std::string version:
+  return safe_str2dbl( s.to_string(), result );
+}
+
+bool NC::safe_str2int(StrView s, int& result )
+{
+  const char * c = s.begin();
+  const char * cE = s.end();
+  const bool neg = ( c != cE && *c == '-' );
+  if ( c != cE && ( neg || *c == '+' ) )
+    ++c;
+  if ( c != cE && std::distance( c, cE ) <= 9 ) {
+    int v = 0;
+    for ( ; c != cE && *c >= '0' && *c <= '9'; ++c )
+      v = v * 10 + ( *c - '0' );
+    if ( c == cE ) {
+      result = ( neg ? -v : v );
+      return true;
+    }
+  }
+  return safe_str2int( s.to_string(), result );
+}
+
 int NC::str2int(const std::string& s,const char * errmsg)
 {
   int result;
@@ -171,6 +321,24 @@ int NC::str2int(const std::string& s,const char * errmsg)
 
 bool NC::safe_str2dbl(const std::string& s, double& result )
 {
+  switch ( fast_str2dbl( s.data(), s.data() + s.size(), result ) ) {
+  case FastStr2Dbl::Done:
+    return true;
+  case FastStr2Dbl::PlainDecimal:
+    if ( *std::localeconv()->decimal_point == '.' ) {
+      //Like the stream-based conversion below, overflows are rejected while
+      //underflows are accepted:
+      char * endptr;
+      double val = std::strtod( s.c_str(), &endptr );
+      if ( endptr != s.c_str() + s.size() || ncisinf(val) )
+        return false;
+      result = val;
+      return true;
+    }
+    break;
+  case FastStr2Dbl::Other:
+    break;
+  }
   bool ok(true);
   double val;
   std::stringstream ss(s);
@@ -205,6 +373,24 @@ bool NC::safe_str2dbl(const std::string& s, double& result )
 
 bool NC::safe_str2int(const std::string& s, int& result )
 {
+  {
+    //Fast path for plain integers like "-123" (anything else, including
+    //surrounding whitespace, goes through the stream-based conversion below):
+    const char * c = s.data();
+    const char * cE = c + s.size();
+    const bool neg = ( c != cE && *c == '-' );
+    if ( c != cE && ( neg || *c == '+' ) )
+      ++c;
+    if ( c != cE && std::distance( c, cE ) <= 9 ) {
+      int v = 0;
+      for ( ; c != cE && *c >= '0' && *c <= '9'; ++c )
+        v = v * 10 + ( *c - '0' );
+      if ( c == cE ) {
+        result = ( neg ? -v : v );
+        return true;
+      }
+    }
+  }
   int val;
   std::stringstream ss(s);
   ss >> val;
@@ -21,6 +21,7 @@
 #include "NCrystal/NCFactImpl.hh"
 #include "NCrystal/internal/NCFileUtils.hh"
 #include "NCrystal/internal/NCString.hh"
+#include "NCrystal/internal/NCFactoryUtils.hh"
 
 namespace NCrystal {
 
@@ -29,12 +30,14 @@ namespace NCrystal {
     template<std::size_t NCACHED>
     class TDProdDB {
     public:
-      TextDataSP produceTextDataSP_PreferPreviousObject( TextData&& newtd )
+      TextDataSP produceTextDataSP_PreferPreviousObject( TextData&& newtd, bool& foundExisting )
       {
         uint64_t checkSum = newtd.rawData().calcCheckSum();
 
         auto it = m_db.begin();
         auto itE = m_db.end();
+        const bool dedup = getTextDataDeduplicationEnabled();
+        const TextData* sameContent = nullptr;
 
         //First check if we have a compatible object already:
         for ( ; it != itE; ++it ) {
@@ -44,9 +47,16 @@ namespace NCrystal {
             {
               break;//Found!
             }
+          if ( dedup && !sameContent && it->first == checkSum
+               && newtd.dataType() == it->second->dataType()
+               && newtd.rawData().hasSameContent( it->second->rawData() ) )
+            sameContent = it->second.get();
         }
         if ( it == itE ) {
-          //Did not find existing. Create and insert in cache:
+          //Did not find existing. Create and insert in cache (possibly sharing
+          //the UID of an entry with identical content):
+          if ( sameContent )
+            newtd.adoptDataUID( *sameContent );
           auto newtdsp = makeSO<const TextData>(std::move(newtd));
           if ( m_db.size() == NCACHED ) {
             //Must first discard existing entry to make room:
@@ -58,6 +68,7 @@ namespace NCrystal {
           //add to back (which is the correct position indicating most recent
           //access):
           m_db.push_back(std::pair<uint64_t,TextDataSP>(checkSum,newtdsp));
+          foundExisting = false;
           return newtdsp;
         } else {
           //Found existing! But before returning we need to reorder entries,
@@ -68,10 +79,19 @@ namespace NCrystal {
           for ( auto it2 = it; it2 != itLast; ++it2 )
             *it2 = std::move( *std::next(it2) );
           *itLast = std::pair<uint64_t,TextDataSP>(checkSum,result);
+          foundExisting = true;
           return result;
         }
       }
       void clear() { m_db.clear(); }
+      std::size_t size() const { return m_db.size(); }
+      std::size_t nBytes() const
+      {
+        std::size_t n = 0;
+        for ( auto& e : m_db )
+          n += std::distance(e.second->rawData().begin(),e.second->rawData().end());
+        return n;
+      }
     private:
       SmallVector<std::pair<uint64_t,TextDataSP>,NCACHED> m_db;
     };
@@ -94,6 +114,8 @@ namespace NCrystal {
         m_db_large.clear();
         m_db_veryLarge.clear();
       }
+      std::size_t size() const { return m_db_small.size() + m_db_large.size() + m_db_veryLarge.size(); }
+      std::size_t nBytes() const { return m_db_small.nBytes() + m_db_large.nBytes() + m_db_veryLarge.nBytes(); }
 
       static TextData produceTextDataWithoutCache( const TextDataPath& textdatapath, TextDataSource&& tds )
       {
@@ -120,10 +142,23 @@ namespace NCrystal {
             path = std::move(pn);
 
           lastKnownOnDiskPath = TextData::LastKnownOnDiskAbsPath{path};
-          Optional<std::string> content = readEntireFileToString( lastKnownOnDiskPath.value().value );
-          if ( !content.has_value() )
-            NCRYSTAL_THROW2(DataLoadError,"Missing or unreadable file: "<<path);
-          rawdata = RawStrData(std::move(content.value()));
+          static const bool s_mmap = ncgetenv_bool("MMAP_TEXTDATA");
+          if ( s_mmap ) {
+            //Opt-in: iterate lines directly over a read-only mapping of the
+            //file (falls back to a heap read if mapping is not possible):
+            auto mf = MappedFile::mapTextFile( lastKnownOnDiskPath.value().value );
+            if ( mf ) {
+              rawdata = RawStrData( RawStrData::external_storage_t{}, mf,
+                                    mf->data().begin(), mf->data().end(),
+                                    path.c_str() );
+            }
+          }
+          if ( !rawdata.has_value() ) {
+            Optional<std::string> content = readEntireFileToString( lastKnownOnDiskPath.value().value );
+            if ( !content.has_value() )
+              NCRYSTAL_THROW2(DataLoadError,"Missing or unreadable file: "<<path);
+            rawdata = RawStrData(std::move(content.value()));
+          }
 
         } else {
           nc_assert( data.has_value<RawStrData>() );
@@ -141,15 +176,15 @@ namespace NCrystal {
                          std::move(lastKnownOnDiskPath) );
       }
 
-      TextDataSP produceTextDataSP_PreferPreviousObject( TextData&& td )
+      TextDataSP produceTextDataSP_PreferPreviousObject( TextData&& td, bool& foundExisting )
       {
         std::size_t size = std::distance(td.rawData().begin(),td.rawData().end());
         if ( size <= small_threshold_nBytes ) {
-          return m_db_small.produceTextDataSP_PreferPreviousObject(std::move(td));
+          return m_db_small.produceTextDataSP_PreferPreviousObject(std::move(td),foundExisting);
         } else if ( size <= large_threshold_nBytes ) {
-          return m_db_large.produceTextDataSP_PreferPreviousObject(std::move(td));
+          return m_db_large.produceTextDataSP_PreferPreviousObject(std::move(td),foundExisting);
         } else if ( size <= very_large_threshold_nBytes ) {
-          return m_db_veryLarge.produceTextDataSP_PreferPreviousObject(std::move(td));
+          return m_db_veryLarge.produceTextDataSP_PreferPreviousObject(std::move(td),foundExisting);
         } else {
 #ifndef NCRYSTAL_ALLOW_ULTRA_LARGE_FILES
           const char * extraguidance
@@ -165,11 +200,27 @@ namespace NCrystal {
       }
     };
 
+    namespace {
+      static std::atomic<bool> s_textdata_dedup( ncgetenv_bool("TEXTDATA_DEDUP") );
+    }
+
+    void setTextDataDeduplicationEnabled( bool b )
+    {
+      s_textdata_dedup = b;
+    }
+
+    bool getTextDataDeduplicationEnabled()
+    {
+      return s_textdata_dedup;
+    }
+
     ////////////////////////////////////////////////////////////////////////////////////////////////////
     //Global DB:
     struct GlobalTDProd {
       TDProd db;
       std::mutex mtx;
+      uint64_t nhits = 0, nmisses = 0;
+      double loadTime = 0.0;
     };
     GlobalTDProd& globalTDProd() { static GlobalTDProd db; return db; }
     void clearGlobalTDProdCache() {
@@ -177,20 +228,39 @@ namespace NCrystal {
       NCRYSTAL_LOCK_GUARD(db.mtx);
       db.db.clear();
     }
+    FactoryCacheStats globalTDProdCacheStats() {
+      auto& db = globalTDProd();
+      NCRYSTAL_LOCK_GUARD(db.mtx);
+      FactoryCacheStats s;
+      s.name = "TextDataCache";
+      s.nstrongrefs = s.nentries = db.db.size();
+      s.nbytes = db.db.nBytes();
+      s.nhits = db.nhits;
+      s.nmisses = db.nmisses;
+      s.constructionTime = db.loadTime;//NB: data is (re)loaded on every request
+      return s;
+    }
 
     ////////////////////////////////////////////////////////////////////////////////////////////////////
     //Functions fwd declared and used in FactImpl.cc:
     TextDataSP produceTextDataSP_PreferPreviousObject( const TextDataPath& path, TextDataSource&& tds)
     {
+      auto t0 = std::chrono::steady_clock::now();
       TextData td = TDProd::produceTextDataWithoutCache( path, std::move(tds) );
+      const double tload = std::chrono::duration<double>(std::chrono::steady_clock::now()-t0).count();
       auto& db = globalTDProd();
       NCRYSTAL_LOCK_GUARD(db.mtx);
       static bool first = true;
       if ( first ) {
         first = false;
         registerCacheCleanupFunction(clearGlobalTDProdCache);
+        registerFactoryCacheStatsFunction(globalTDProdCacheStats);
       }
-      return db.db.produceTextDataSP_PreferPreviousObject( std::move(td) );
+      db.loadTime += tload;
+      bool foundExisting = false;
+      auto res = db.db.produceTextDataSP_PreferPreviousObject( std::move(td), foundExisting );
+      ++( foundExisting ? db.nhits : db.nmisses );
+      return res;
     }
 
   }
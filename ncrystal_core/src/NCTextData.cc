@@ -21,6 +21,7 @@
 #include "NCrystal/NCTextData.hh"
 #include "NCrystal/internal/NCString.hh"
 #include "NCrystal/internal/NCFileUtils.hh"
+#include "NCrystal/internal/NCNCMATBinary.hh"
 #include <sstream>
 
 namespace NC = NCrystal;
@@ -89,6 +90,79 @@ void NC::TextData::Iterator::setup() {
     ++m_nextData;
 }
 
+NC::TextData::LineIndex::LineIndex( const TextData& td )
+  : m_data( td.rawData() )
+{
+  //Iteration stops at the first null char (which is normally at the end of
+  //the data, unless this is binary NCMAT data):
+  const char * b = m_data.begin();
+  const char * e = static_cast<const char*>( std::memchr( b, '\0', std::distance( b, m_data.end() ) + 1 ) );
+  nc_assert_always( e != nullptr );
+  //Reject lone \r chars, like the iterators do:
+  for ( const char * it = b; ( it = static_cast<const char*>( std::memchr( it, '\r', std::distance( it, e ) ) ) ); ++it ) {
+    if ( *std::next(it) != '\n' )
+      NCRYSTAL_THROW(BadInput,"Data with ancient pre-OSX Mac line-endings is explicitly not allowed!");
+  }
+  const std::size_t n = m_nchars = std::distance( b, e );
+  if ( n == 0 ) {
+    m_starts.push_back( 0 );//just the sentinel
+    return;
+  }
+  m_starts.push_back( 0 );
+  for ( const char * it = b; ( it = static_cast<const char*>( std::memchr( it, '\n', std::distance( it, e ) ) ) ); )
+    m_starts.push_back( std::distance( b, ++it ) );
+  if ( m_starts.back() != n )
+    m_starts.push_back( n + 1 );//last line without trailing newline
+  m_starts.shrink_to_fit();
+}
+
+const char * NC::TextData::LineIndex::lineBegin( std::size_t i ) const noexcept
+{
+  nc_assert( i < size() );
+  return m_data.begin() + m_starts[i];
+}
+
+const char * NC::TextData::LineIndex::lineEnd( std::size_t i ) const noexcept
+{
+  nc_assert( i < size() );
+  const char * e = m_data.begin() + ( m_starts[i+1] - 1 );
+  if ( e > lineBegin( i ) && *std::prev(e) == '\r' )
+    --e;
+  return e;
+}
+
+std::string NC::TextData::LineIndex::line( std::size_t i ) const
+{
+  return std::string( lineBegin(i), lineEnd(i) );
+}
+
+NC::TextData::Iterator NC::TextData::LineIndex::iteratorAt( std::size_t i ) const
+{
+  nc_assert_always( i <= size() );
+  if ( i == size() ) {
+    return Iterator( m_data.begin() + m_nchars, Iterator::is_end_t() );
+  }
+  return Iterator( lineBegin( i ) );
+}
+
+std::vector<std::size_t> NC::TextData::LineIndex::chunkBoundaries( std::size_t nchunks ) const
+{
+  const std::size_t nlines = size();
+  std::vector<std::size_t> res;
+  res.push_back( 0 );
+  nchunks = std::max<std::size_t>( 1, std::min( nchunks, nlines ) );
+  const std::size_t nbytes = m_starts.back();
+  for ( std::size_t ichunk = 1; ichunk < nchunks; ++ichunk ) {
+    //First line starting at or after the target byte offset:
+    const std::size_t target = ( nbytes * ichunk ) / nchunks;
+    const std::size_t iline = std::lower_bound( m_starts.begin(), std::prev( m_starts.end() ), target ) - m_starts.begin();
+    if ( iline > res.back() && iline < nlines )
+      res.push_back( iline );
+  }
+  res.push_back( nlines );
+  return res;
+}
+
 void NC::TextData::verifyOnDiskFileUnchanged() const
 {
   if ( !m_optOnDisk.has_value() )
@@ -161,15 +235,39 @@ NC::TextData::TextData( RawStrData data,
   }
 }
 
+void NC::TextData::adoptDataUID( const TextData& o )
+{
+  if ( m_dt != o.m_dt || !m_data.hasSameContent( o.m_data ) )
+    NCRYSTAL_THROW2(BadInput,"TextData::adoptDataUID can not share UID of object with different"
+                    " data type or content ("<<m_descr<<" vs. "<<o.m_descr<<")");
+  m_uid.set( o.m_uid );
+}
+
 NC::RawStrData::RawStrData( shared_obj<std::string> d, const char * srcdescr )
-  : m_s( std::move(d) )
 {
-  //Verify input data does not contain unexpected null chars:
-  const std::string& s = *m_s;
-  auto n = s.size();
+  const std::string& s = *d;
   m_b = s.c_str();
-  m_e = m_b + n;
-  if ( std::strlen( m_b ) != (std::size_t)n ) {
+  m_e = m_b + s.size();
+  m_storage = std::move(d);
+  validateNoNullChars( srcdescr );
+}
+
+NC::RawStrData::RawStrData( external_storage_t, std::shared_ptr<const void> storage,
+                            const char * dataBegin, const char * dataEnd,
+                            const char * srcdescr )
+  : m_b( dataBegin ), m_e( dataEnd ), m_storage( std::move(storage) )
+{
+  nc_assert_always( m_storage != nullptr && m_b != nullptr && m_e >= m_b && *m_e == '\0' );
+  validateNoNullChars( srcdescr );
+}
+
+void NC::RawStrData::validateNoNullChars( const char * srcdescr ) const
+{
+  //Verify input data does not contain unexpected null chars (binary NCMAT data
+  //is exempt, as it stops looking like text after the preamble):
+  if ( isNCMATBinaryData( m_b, m_e ) )
+    return;
+  if ( std::strlen( m_b ) != static_cast<std::size_t>( std::distance( m_b, m_e ) ) ) {
     //Some extraneous null character must have spoiled it!
     NCRYSTAL_THROW2(BadInput,"Invalid text data"
                     <<(srcdescr?" in ":"")
@@ -0,0 +1,365 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+//  This file is part of NCrystal (see https://mctools.github.io/ncrystal/)   //
+//                                                                            //
+//  Copyright 2015-2021 NCrystal developers                                   //
+//                                                                            //
+//  Licensed under the Apache License, Version 2.0 (the "License");           //
+//  you may not use this file except in compliance with the License.          //
+//  You may obtain a copy of the License at                                   //
+//                                                                            //
+//      http://www.apache.org/licenses/LICENSE-2.0                            //
+//                                                                            //
+//  Unless required by applicable law or agreed to in writing, software       //
+//  distributed under the License is distributed on an "AS IS" BASIS,         //
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  //
+//  See the License for the specific language governing permissions and       //
+//  limitations under the License.                                            //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include "NCrystal/internal/NCThreadUtils.hh"
+#include "NCrystal/internal/NCString.hh"
+#include <atomic>
+#ifdef __linux__
+#  include <unistd.h>
+#  include <sys/syscall.h>
+#endif
+#ifndef NCRYSTAL_DISABLE_THREADS
+#  include <thread>
+#  include <condition_variable>
+#  include <deque>
+#  include <algorithm>
+#endif
+
+namespace NC = NCrystal;
+
+#ifndef NCRYSTAL_DISABLE_THREADS
+namespace NCrystal {
+  namespace {
+    //Value set with setNThreads (-1 if not set):
+    std::atomic<int> s_nthreads_override( -1 );
+
+    unsigned hardwareThreads()
+    {
+      return std::max<unsigned>( 1, std::thread::hardware_concurrency() );
+    }
+
+    const Optional<unsigned>& nthreadsFromEnv()
+    {
+      static const Optional<unsigned> s_nthreads = []()
+      {
+        const std::string ev = ncgetenv("NTHREADS");
+        if ( ev.empty() )
+          return Optional<unsigned>();
+        int n = ( ev == "auto" ? 0 : str2int(ev) );
+        if ( n < 0 )
+          NCRYSTAL_THROW2(BadInput,"Invalid value of NCRYSTAL_NTHREADS environment variable: \""<<ev<<"\"");
+        return Optional<unsigned>( n == 0 ? hardwareThreads() : static_cast<unsigned>( n ) );
+      }();
+      return s_nthreads;
+    }
+
+    //Number of threads explicitly requested by setNThreads or
+    //NCRYSTAL_NTHREADS (if any):
+    Optional<unsigned> requestedNThreads()
+    {
+      const int ov = s_nthreads_override.load();
+      if ( ov >= 0 )
+        return ov == 0 ? hardwareThreads() : static_cast<unsigned>( ov );
+      return nthreadsFromEnv();
+    }
+
+    ExternalTaskPool& externalTaskPool()
+    {
+      static ExternalTaskPool s_ext;
+      return s_ext;
+    }
+    std::mutex& externalTaskPoolMutex()
+    {
+      static std::mutex s_mtx;
+      return s_mtx;
+    }
+
+    class TaskPool : private NoCopyMove {
+    public:
+
+      //A parallelFor call in progress. Threads taking part claim indices one
+      //at a time, and add the number they claimed to ndone when they find no
+      //more left:
+      struct Job : private NoCopyMove {
+        Job( std::size_t nn, unsigned maxpart, const std::function<void(std::size_t)>& f )
+          : fct(f), n(nn), maxParticipants(maxpart) {}
+        const std::function<void(std::size_t)>& fct;
+        const std::size_t n;
+        const unsigned maxParticipants;
+        std::atomic<std::size_t> next = { 0 };
+        std::atomic<bool> failed = { false };
+        unsigned participants = 1;//calling thread (protected by pool mutex)
+        std::mutex mtx;
+        std::condition_variable cv;
+        std::size_t ndone = 0;//protected by mtx
+        std::exception_ptr error;//protected by mtx
+        bool exhausted() const { return next.load() >= n; }
+      };
+
+      void parallelFor( std::size_t n, unsigned nthreads, const std::function<void(std::size_t)>& fct )
+      {
+        auto job = std::make_shared<Job>( n, nthreads, fct );
+        {
+          NCRYSTAL_LOCK_GUARD(m_mtx);
+          ensureWorkers( nthreads - 1 );
+          m_jobs.push_back( job );
+        }
+        for ( unsigned i = 1; i < nthreads; ++i )
+          m_cv.notify_one();
+        work( *job );
+        {
+          NCRYSTAL_LOCK_GUARD(m_mtx);
+          auto it = std::find( m_jobs.begin(), m_jobs.end(), job );
+          if ( it != m_jobs.end() )
+            m_jobs.erase( it );
+        }
+        std::unique_lock<std::mutex> lock( job->mtx );
+        job->cv.wait( lock, [&job](){ return job->ndone == job->n; } );
+        if ( job->error )
+          std::rethrow_exception( job->error );
+      }
+
+      void runInBackground( std::function<void()> fct, unsigned nworkers )
+      {
+        {
+          NCRYSTAL_LOCK_GUARD(m_mtx);
+          ensureWorkers( nworkers );
+          m_bgtasks.push_back( std::move(fct) );
+        }
+        m_cv.notify_one();
+      }
+
+    private:
+      std::mutex m_mtx;
+      std::condition_variable m_cv;
+      std::vector<std::shared_ptr<Job>> m_jobs;//newest last
+      std::deque<std::function<void()>> m_bgtasks;
+      unsigned m_nworkers = 0;
+
+      void ensureWorkers( unsigned n )
+      {
+        //Threads are detached and the pool is never deleted, so shutdown at
+        //process exit does not depend on static destruction order:
+        for ( ; m_nworkers < n; ++m_nworkers )
+          std::thread( [this](){ this->workerLoop(); } ).detach();
+      }
+
+      static void work( Job& job )
+      {
+        std::size_t nclaimed = 0;
+        std::exception_ptr error;
+        while ( true ) {
+          const std::size_t i = job.next++;
+          if ( i >= job.n )
+            break;
+          ++nclaimed;
+          if ( job.failed.load() )
+            continue;//skip remaining tasks
+          try {
+            job.fct(i);
+          } catch (...) {
+            if ( !error )
+              error = std::current_exception();
+            job.failed = true;
+          }
+        }
+        NCRYSTAL_LOCK_GUARD(job.mtx);
+        if ( error && !job.error )
+          job.error = error;
+        job.ndone += nclaimed;
+        if ( job.ndone == job.n )
+          job.cv.notify_all();
+      }
+
+      std::shared_ptr<Job> findJob()
+      {
+        //Prefer the newest jobs, which are often nested in (and thus holding
+        //up) older ones. Exhausted jobs are discarded on the way:
+        for ( std::size_t i = m_jobs.size(); i--; ) {
+          auto& job = m_jobs[i];
+          if ( job->exhausted() ) {
+            m_jobs.erase( m_jobs.begin() + i );
+            continue;
+          }
+          if ( job->participants < job->maxParticipants ) {
+            ++job->participants;
+            return job;
+          }
+        }
+        return nullptr;
+      }
+
+      void workerLoop()
+      {
+        while ( true ) {
+          std::shared_ptr<Job> job;
+          std::function<void()> bgtask;
+          {
+            std::unique_lock<std::mutex> lock(m_mtx);
+            m_cv.wait( lock, [this,&job](){ return ( job = findJob() ) || !m_bgtasks.empty(); } );
+            if ( !job ) {
+              bgtask = std::move( m_bgtasks.front() );
+              m_bgtasks.pop_front();
+            }
+          }
+          if ( job ) {
+            work( *job );
+            continue;
+          }
+          try {
+            bgtask();
+          } catch (...) {
+            //Tasks are supposed to handle their own exceptions.
+          }
+        }
+      }
+    };
+
+    TaskPool& taskPool()
+    {
+      static TaskPool * s_pool = new TaskPool;//never deleted (see above)
+      return *s_pool;
+    }
+  }
+}
+#endif
+
+unsigned NC::getNThreadsFromEnv()
+{
+#ifdef NCRYSTAL_DISABLE_THREADS
+  return 1;
+#else
+  auto n = requestedNThreads();
+  return n.has_value() ? n.value() : 1u;
+#endif
+}
+
+void NC::setNThreads( unsigned n )
+{
+#ifdef NCRYSTAL_DISABLE_THREADS
+  (void)n;
+#else
+  s_nthreads_override = static_cast<int>( std::min<unsigned>( n, 1000000 ) );
+#endif
+}
+
+void NC::setExternalTaskPool( ExternalTaskPool ext )
+{
+#ifdef NCRYSTAL_DISABLE_THREADS
+  (void)ext;
+#else
+  NCRYSTAL_LOCK_GUARD( externalTaskPoolMutex() );
+  externalTaskPool() = std::move(ext);
+#endif
+}
+
+void NC::parallelFor( std::size_t n, unsigned nthreads,
+                      const std::function<void(std::size_t)>& fct )
+{
+#ifdef NCRYSTAL_DISABLE_THREADS
+  nthreads = 1;
+#endif
+  if ( static_cast<std::size_t>(nthreads) > n )
+    nthreads = static_cast<unsigned>( n );
+  if ( nthreads <= 1 ) {
+    for ( std::size_t i = 0; i < n; ++i )
+      fct(i);
+    return;
+  }
+#ifndef NCRYSTAL_DISABLE_THREADS
+  std::function<void(std::size_t, unsigned, const std::function<void(std::size_t)>&)> ext;
+  {
+    NCRYSTAL_LOCK_GUARD( externalTaskPoolMutex() );
+    ext = externalTaskPool().parallelFor;
+  }
+  if ( !ext ) {
+    taskPool().parallelFor( n, nthreads, fct );
+    return;
+  }
+  //Exceptions must not propagate into the external pool:
+  std::atomic<bool> failed(false);
+  std::exception_ptr first_error;
+  std::mutex mtx_error;
+  ext( n, nthreads, [&]( std::size_t i )
+  {
+    if ( failed.load() )
+      return;
+    try {
+      fct(i);
+    } catch (...) {
+      NCRYSTAL_LOCK_GUARD(mtx_error);
+      if ( !first_error )
+        first_error = std::current_exception();
+      failed = true;
+    }
+  } );
+  if ( first_error )
+    std::rethrow_exception( first_error );
+#endif
+}
+
+void NC::runInBackground( std::function<void()> fct )
+{
+#ifdef NCRYSTAL_DISABLE_THREADS
+  try {
+    fct();
+  } catch (...) {
+  }
+#else
+  std::function<void(std::function<void()>)> ext;
+  {
+    NCRYSTAL_LOCK_GUARD( externalTaskPoolMutex() );
+    ext = externalTaskPool().runInBackground;
+  }
+  if ( ext ) {
+    ext( [fct]()
+    {
+      try {
+        fct();
+      } catch (...) {
+      }
+    } );
+    return;
+  }
+  auto nreq = requestedNThreads();
+  taskPool().runInBackground( std::move(fct), nreq.has_value() ? nreq.value() : hardwareThreads() );
+#endif
+}
+
+bool NC::numaReplicationEnabled()
+{
+#ifdef __linux__
+  static const bool s_enabled = ncgetenv_bool("NUMA_REPLICATE");
+  return s_enabled;
+#else
+  return false;
+#endif
+}
+
+unsigned NC::currentNUMANode()
+{
+#if defined(__linux__) && defined(SYS_getcpu)
+  if ( !numaReplicationEnabled() )
+    return 0;
+  //The syscall is not free, so only recheck the node now and then:
+  struct NodeCache { unsigned node = 0; unsigned countdown = 0; };
+  thread_local NodeCache t_cache;
+  if ( t_cache.countdown-- == 0 ) {
+    unsigned cpu(0), node(0);
+    if ( syscall( SYS_getcpu, &cpu, &node, nullptr ) != 0 )
+      node = 0;
+    t_cache.node = node;
+    t_cache.countdown = 1023;
+  }
+  return t_cache.node;
+#else
+  return 0;
+#endif
+}
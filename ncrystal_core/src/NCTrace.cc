@@ -0,0 +1,188 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+//  This file is part of NCrystal (see https://mctools.github.io/ncrystal/)   //
+//                                                                            //
+//  Copyright 2015-2021 NCrystal developers                                   //
+//                                                                            //
+//  Licensed under the Apache License, Version 2.0 (the "License");           //
+//  you may not use this file except in compliance with the License.          //
+//  You may obtain a copy of the License at                                   //
+//                                                                            //
+//      http://www.apache.org/licenses/LICENSE-2.0                            //
+//                                                                            //
+//  Unless required by applicable law or agreed to in writing, software       //
+//  distributed under the License is distributed on an "AS IS" BASIS,         //
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  //
+//  See the License for the specific language governing permissions and       //
+//  limitations under the License.                                            //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include "NCrystal/internal/NCTrace.hh"
+#include "NCrystal/internal/NCString.hh"
+#include <chrono>
+#include <fstream>
+#include <iostream>
+
+namespace NC = NCrystal;
+
+namespace NCrystal {
+  namespace Trace {
+    namespace {
+
+      struct Event {
+        std::string name;
+        std::string detail;
+        unsigned tid;
+        std::uint64_t tstart;//microseconds
+        std::uint64_t duration;//microseconds
+      };
+
+      void writeJSONStr( std::ostream& os, const std::string& s )
+      {
+        os << '"';
+        for ( char c : s ) {
+          if ( c == '"' || c == '\\' )
+            os << '\\' << c;
+          else if ( static_cast<unsigned char>(c) < 0x20 )
+            os << ' ';
+          else
+            os << c;
+        }
+        os << '"';
+      }
+
+      class Recorder : private NoCopyMove {
+      public:
+        Recorder()
+          : m_filename( ncgetenv("TRACE") ),
+            m_t0( std::chrono::steady_clock::now() )
+        {
+        }
+
+        ~Recorder()
+        {
+          //Write everything at process exit:
+          if ( !m_filename.empty() )
+            write();
+        }
+
+        bool enabled() const noexcept { return !m_filename.empty(); }
+
+        std::uint64_t now() const
+        {
+          auto dt = std::chrono::steady_clock::now() - m_t0;
+          return static_cast<std::uint64_t>( std::chrono::duration_cast<std::chrono::microseconds>(dt).count() );
+        }
+
+        unsigned threadIndex()
+        {
+          static thread_local unsigned s_tid = ++m_nthreads;
+          return s_tid;
+        }
+
+        void record( std::string&& name, std::string&& detail, std::uint64_t tstart )
+        {
+          const std::uint64_t tend = now();
+          const unsigned tid = threadIndex();
+          NCRYSTAL_LOCK_GUARD(m_mtx);
+          if ( m_written )
+            return;
+          m_events.push_back( { std::move(name), std::move(detail), tid,
+                                tstart, ( tend > tstart ? tend - tstart : 0 ) } );
+        }
+
+      private:
+        const std::string m_filename;
+        const std::chrono::steady_clock::time_point m_t0;
+        std::atomic<unsigned> m_nthreads{0};
+        std::mutex m_mtx;
+        std::vector<Event> m_events;
+        bool m_written = false;
+
+        void write()
+        {
+          NCRYSTAL_LOCK_GUARD(m_mtx);
+          m_written = true;
+          std::ofstream ofs( m_filename );
+          if ( !ofs.good() ) {
+            std::cout<<"NCrystal WARNING: Could not open file for writing trace: \""<<m_filename<<"\""<<std::endl;
+            return;
+          }
+          ofs << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+          const unsigned nthreads = m_nthreads.load();
+          for ( unsigned tid = 1; tid <= nthreads; ++tid ) {
+            ofs << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tid
+                << ",\"args\":{\"name\":\"NCrystal thread " << tid << "\"}},\n";
+          }
+          bool first = true;
+          for ( auto& e : m_events ) {
+            if ( !first )
+              ofs << ",\n";
+            first = false;
+            ofs << "{\"name\":";
+            writeJSONStr( ofs, e.name );
+            ofs << ",\"cat\":\"ncrystal\",\"ph\":\"X\",\"pid\":1,\"tid\":" << e.tid
+                << ",\"ts\":" << e.tstart << ",\"dur\":" << e.duration;
+            if ( !e.detail.empty() ) {
+              ofs << ",\"args\":{\"detail\":";
+              writeJSONStr( ofs, e.detail );
+              ofs << "}";
+            }
+            ofs << "}";
+          }
+          if ( first )
+            ofs << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"NCrystal\"}}";
+          ofs << "\n]}\n";
+        }
+      };
+
+      Recorder& recorder()
+      {
+        static Recorder s_recorder;
+        return s_recorder;
+      }
+
+    }
+  }
+}
+
+bool NC::Trace::enabled()
+{
+  static const bool s_enabled = recorder().enabled();
+  return s_enabled;
+}
+
+NC::Trace::Span::Span( const char * name )
+  : m_active( enabled() )
+{
+  if ( m_active ) {
+    m_name = name;
+    m_tstart = recorder().now();
+  }
+}
+
+NC::Trace::Span::Span( const std::string& name )
+  : m_active( enabled() )
+{
+  if ( m_active ) {
+    m_name = name;
+    m_tstart = recorder().now();
+  }
+}
+
+NC::Trace::Span::~Span()
+{
+  if ( !m_active )
+    return;
+  try {
+    recorder().record( std::move(m_name), std::move(m_detail), m_tstart );
+  } catch (...) {
+    //Never let tracing interfere with the traced code.
+  }
+}
+
+void NC::Trace::Span::setDetail( std::string s )
+{
+  m_detail = std::move(s);
+}
@@ -26,6 +26,42 @@ namespace NC=NCrystal;
 
 namespace NCrystal {
   static std::atomic<bool> s_verbose_vdoseval( getenv("NCRYSTAL_DEBUG_PHONON")!=nullptr );
+
+  struct VDOSEval::Memo {
+    //Input parameterisation (before any corrections) for which results are
+    //valid, and results of the integrations. Per-temperature results are NaN
+    //until calculated. All access to results must be protected by the global
+    //mutex below:
+    PairDD egrid;
+    VectD density;
+    double originalIntegral;
+    struct TValues { double temperature, gamma0, teff; };
+    std::vector<TValues> tvalues;
+    TValues& valuesForT( double temperature )
+    {
+      for ( auto& e : tvalues )
+        if ( e.temperature == temperature )
+          return e;
+      //Keep memory bounded if the VDOS is used at very many temperatures:
+      if ( tvalues.size() >= 64 )
+        tvalues.erase( tvalues.begin() );
+      tvalues.push_back( { temperature, std::numeric_limits<double>::quiet_NaN(),
+                           std::numeric_limits<double>::quiet_NaN() } );
+      return tvalues.back();
+    }
+    static std::mutex& globalMutex()
+    {
+      static std::mutex mtx;
+      return mtx;
+    }
+    //Most recently used entries last (protected by globalMutex()):
+    static std::vector<std::shared_ptr<Memo>>& globalEntries()
+    {
+      static std::vector<std::shared_ptr<Memo>> entries;
+      return entries;
+    }
+    static constexpr std::size_t maxEntries = 32;
+  };
 }
 
 void NC::VDOSEval::enableVerboseOutput(bool status)
@@ -92,9 +128,37 @@ NC::VDOSEval::VDOSEval(const VDOSData& vd)
   nc_assert_always(m_binwidth>0.0);
   m_invbinwidth = 1.0/m_binwidth;
 
-  //Normalise:
-  m_originalIntegral = integrateWithFunction([](double){return 1.0;},
-                                             [](double e){return e*e;});
+  //Normalise (reusing the integral from memoised results if available):
+  const PairDD egrid_input = vd.vdos_egrid();
+  const VectD& density_input = vd.vdos_density();
+  {
+    NCRYSTAL_LOCK_GUARD(Memo::globalMutex());
+    auto& entries = Memo::globalEntries();
+    for ( auto it = entries.begin(); it != entries.end(); ++it ) {
+      if ( (*it)->egrid == egrid_input && (*it)->density == density_input ) {
+        m_memo = *it;
+        entries.erase(it);
+        entries.push_back(m_memo);
+        break;
+      }
+    }
+  }
+  if ( m_memo ) {
+    m_originalIntegral = m_memo->originalIntegral;
+  } else {
+    m_originalIntegral = integrateWithFunction([](double){return 1.0;},
+                                               [](double e){return e*e;});
+    auto memo = std::make_shared<Memo>();
+    memo->egrid = egrid_input;
+    memo->density = density_input;
+    memo->originalIntegral = m_originalIntegral;
+    m_memo = memo;
+    NCRYSTAL_LOCK_GUARD(Memo::globalMutex());
+    auto& entries = Memo::globalEntries();
+    if ( entries.size() >= Memo::maxEntries )
+      entries.erase( entries.begin() );
+    entries.push_back( std::move(memo) );
+  }
   nc_assert_always(m_originalIntegral>0.0);
   double scalefact = 1.0/m_originalIntegral;
   for (auto& e : m_density)
@@ -123,6 +187,20 @@ NC::VDOSEval::GridInfo NC::VDOSEval::getGridInfo() const
 }
 
 double NC::VDOSEval::calcGamma0() const
+{
+  {
+    NCRYSTAL_LOCK_GUARD(Memo::globalMutex());
+    const double g0 = m_memo->valuesForT( m_temperature.get() ).gamma0;
+    if ( !std::isnan(g0) )
+      return g0;
+  }
+  const double res = calcGamma0Impl();
+  NCRYSTAL_LOCK_GUARD(Memo::globalMutex());
+  m_memo->valuesForT( m_temperature.get() ).gamma0 = res;
+  return res;
+}
+
+double NC::VDOSEval::calcGamma0Impl() const
 {
   //Evaluate Sjolander1958 eq. II.3 with t=0 (NB: Sjolander is missing a factor
   //of emax, since he uses unit-less energies).
@@ -156,6 +234,20 @@ double NC::VDOSEval::calcGamma0() const
 }
 
 double NC::VDOSEval::calcEffectiveTemperature() const
+{
+  {
+    NCRYSTAL_LOCK_GUARD(Memo::globalMutex());
+    const double teff = m_memo->valuesForT( m_temperature.get() ).teff;
+    if ( !std::isnan(teff) )
+      return teff;
+  }
+  const double res = calcEffectiveTemperatureImpl();
+  NCRYSTAL_LOCK_GUARD(Memo::globalMutex());
+  m_memo->valuesForT( m_temperature.get() ).teff = res;
+  return res;
+}
+
+double NC::VDOSEval::calcEffectiveTemperatureImpl() const
 {
   //Defining the effective temperature Teff via
   //k*Teff=mean-energy-per-phonon-state, we can integrate over the energy per
@@ -23,6 +23,7 @@
 #include "NCrystal/internal/NCFastConvolve.hh"
 #include "NCrystal/internal/NCMath.hh"
 #include "NCrystal/internal/NCIter.hh"
+#include "NCrystal/internal/NCTrace.hh"
 #include <iostream>
 namespace NC=NCrystal;
 
@@ -117,6 +118,7 @@ NC::VDOSGn::TruncAndThinningParams::TruncAndThinningParams(TruncAndThinningChoic
 NC::VDOSGn::Impl::Impl(const VDOSEval& vde, const TruncAndThinningParams ttpars)
   : m_ttpars(ttpars)
 {
+  Trace::Span span("VDOSGn");
   auto gridinfo = vde.getGridInfo();
   nc_assert(gridinfo.npts>1);
 
@@ -25,6 +25,7 @@
 #include "NCrystal/internal/NCString.hh"
 #include "NCrystal/internal/NCIter.hh"
 #include "NCrystal/internal/NCSABUtils.hh"
+#include "NCrystal/internal/NCThreadUtils.hh"
 namespace NC=NCrystal;
 #include <iostream>
 
@@ -112,116 +113,151 @@ namespace NCrystal {
       const VectD betaGridNonPositive( betaGrid.begin(), std::next(betaGrid.begin(),idx_zero+1) );//vector instead of span to simplify code below
       auto expbeta_vals_nonposbeta = vectorTrf( betaGridNonPositive, [](double beta){ return std::exp(beta); } );
 
-      //Now we loop and fill the S-table. First over phonon order, n, next over
-      //beta and finally alpha. We take care to keep as many calculations as
-      //possible in the outer loops, while avoiding unnecessarily repeating
-      //calculations or utilising enormous memory caches.
-
-      for ( unsigned n = 1; n <= maxOrder; ++n) {
-
-        //Prepare for Gn(beta)-evaluations:
-        auto betakT_Range = Gn_asym.eRange(n);
-        const double invn = 1.0/n;
-
-        //Preparation of f(x)=exp(-x)*x^n/n! is more tricky, due to reasons of
-        //efficiency and numerical issues. As explained above, for orders below
-        //stirling_threshold, we build up recursively, and above we use
-        //Stirling's formula:
-        if ( n < stirling_threshold ) {
-          //for reasonably low orders we can build up slowly and cheaply (leaving
-          //out of fxn_cache a final factor of expmhalfx for numerical stability):
-          for (auto x : enumerate(x_vals) )
-            vectAt(fxn_cache,x.idx) *= x.val*invn;
-          for (auto fxn : enumerate(fxn_cache) )
-            vectAt(alpha_factors,fxn.idx) = fxn.val * vectAt(expmhalfx_vals,fxn.idx) * kT;
-        } else {
-          //Very high order phonons, f(x) is non-zero at very high values of x, but
-          //exp(-0.5*x) becomes 0, precluding the direct/cheap evaluation. Instead
-          //we evaluate directly, with the help of Stirling's series for the
-          //factorial, n!. Everything is suitably rearranged so cancellations happen
-          //before the exponential is evaluated.
-          const double gn = V2SKDetail::stirlingsSeriesSum9thOrder(invn);
-          const double fact= kT * kInvSqrt2Pi/(std::sqrt(n)*gn);
-          if (!fact)
-            continue;//nothing can contribute at this order (should not really happen?)
-          const double logn = std::log(n);
-          for (auto x : enumerate(x_vals) ) {
-            const double exparg = n * ( vectAt(logx_vals,x.idx) - logn + 1.0 ) - x.val;
-            vectAt(alpha_factors,x.idx) = fact * std::exp(exparg);
+      //Now we loop and fill the S-table. First over blocks of phonon orders,
+      //n, next over beta, then over the orders in the block, and finally
+      //alpha. We take care to keep as many calculations as possible in the
+      //outer loops, while avoiding unnecessarily repeating calculations or
+      //utilising enormous memory caches.
+      //
+      //The alpha factors for all orders in a block are prepared serially
+      //(since they are built up recursively), after which the beta rows are
+      //filled in parallel. Each row (and its positive-beta mirror) is only
+      //written by a single task, and contributions are added in order of
+      //increasing n exactly as in a serial loop, so the results do not depend
+      //on the number of threads.
+
+      constexpr unsigned orderBlockSize = 64;
+      const unsigned nthreads = getNThreadsFromEnv();
+      std::vector<unsigned> block_orders;
+      std::vector<PairDD> block_betakT_ranges;
+      VectD block_alpha_factors;
+      block_orders.reserve(orderBlockSize);
+      block_betakT_ranges.reserve(orderBlockSize);
+      block_alpha_factors.reserve(orderBlockSize*nalpha);
+
+      for ( unsigned nblock_begin = 1; nblock_begin <= maxOrder; nblock_begin += orderBlockSize ) {
+        const unsigned nblock_end = std::min<unsigned>( maxOrder + 1, nblock_begin + orderBlockSize );
+        block_orders.clear();
+        block_betakT_ranges.clear();
+        block_alpha_factors.clear();
+
+        for ( unsigned n = nblock_begin; n < nblock_end; ++n) {
+
+          //Prepare for Gn(beta)-evaluations:
+          auto betakT_Range = Gn_asym.eRange(n);
+          const double invn = 1.0/n;
+
+          //Preparation of f(x)=exp(-x)*x^n/n! is more tricky, due to reasons of
+          //efficiency and numerical issues. As explained above, for orders below
+          //stirling_threshold, we build up recursively, and above we use
+          //Stirling's formula:
+          if ( n < stirling_threshold ) {
+            //for reasonably low orders we can build up slowly and cheaply (leaving
+            //out of fxn_cache a final factor of expmhalfx for numerical stability):
+            for (auto x : enumerate(x_vals) )
+              vectAt(fxn_cache,x.idx) *= x.val*invn;
+            for (auto fxn : enumerate(fxn_cache) )
+              vectAt(alpha_factors,fxn.idx) = fxn.val * vectAt(expmhalfx_vals,fxn.idx) * kT;
+          } else {
+            //Very high order phonons, f(x) is non-zero at very high values of x, but
+            //exp(-0.5*x) becomes 0, precluding the direct/cheap evaluation. Instead
+            //we evaluate directly, with the help of Stirling's series for the
+            //factorial, n!. Everything is suitably rearranged so cancellations happen
+            //before the exponential is evaluated.
+            const double gn = V2SKDetail::stirlingsSeriesSum9thOrder(invn);
+            const double fact= kT * kInvSqrt2Pi/(std::sqrt(n)*gn);
+            if (!fact)
+              continue;//nothing can contribute at this order (should not really happen?)
+            const double logn = std::log(n);
+            for (auto x : enumerate(x_vals) ) {
+              const double exparg = n * ( vectAt(logx_vals,x.idx) - logn + 1.0 ) - x.val;
+              vectAt(alpha_factors,x.idx) = fact * std::exp(exparg);
+            }
           }
+          block_orders.push_back( n );
+          block_betakT_ranges.push_back( betakT_Range );
+          block_alpha_factors.insert( block_alpha_factors.end(), alpha_factors.begin(), alpha_factors.end() );
         }
 
-        for ( auto beta : enumerate(betaGridNonPositive) ) {
+        auto fillBetaRow = [&]( std::size_t beta_idx )
+        {
           //Can evaluate more precisely at negative beta values and simply flip +
           //apply detailed balance factor for positive.
-          nc_assert( beta.val<=0.0 );
-          double energy = beta.val * kT;
-          if (!valueInInterval(betakT_Range,energy))
-            continue;//Gn(beta) zero here.
+          const double beta_val = vectAt( betaGridNonPositive, beta_idx );
+          nc_assert( beta_val<=0.0 );
+          const double energy = beta_val * kT;
 
           double expMbeta(0.0);
           std::size_t posbeta_idx(0);
-          if ( beta.idx >= idx_firstflip ) {
-            posbeta_idx = idx_zero + ( idx_zero - beta.idx );
-            expMbeta = vectAt(expbeta_vals_nonposbeta,beta.idx);
+          if ( beta_idx >= idx_firstflip ) {
+            posbeta_idx = idx_zero + ( idx_zero - beta_idx );
+            expMbeta = vectAt(expbeta_vals_nonposbeta,beta_idx);
           }
 
-          const double Gn_asym_eval = Gn_asym.eval(n,energy);
-          if ( !(Gn_asym_eval>0.0) )
-            continue;
+          for ( auto order : enumerate(block_orders) ) {
+            if (!valueInInterval(vectAt(block_betakT_ranges,order.idx),energy))
+              continue;//Gn(beta) zero here.
 
-#if 0
-          //readable version of innermost loop:
-          const auto offset_alpharow = beta.idx*nalpha;
-          const auto offset_alpharow_posbeta = posbeta_idx*nalpha;
-          for ( auto alpha_fact : enumerate(alpha_factors) ) {
-            if ( !(alpha_fact.val>0.0) )
+            const double Gn_asym_eval = Gn_asym.eval(order.val,energy);
+            if ( !(Gn_asym_eval>0.0) )
               continue;
-            double contrib_S_negbeta = alpha_fact.val * Gn_asym_eval;
-
-            //Negative beta:
-            vectAt( sab, offset_alpharow + alpha_fact.idx ) += contrib_S_negbeta;
-            if ( expMbeta ) {
-              //Expand to beta>0 by first copying S-values,
-              //S(alpha,+beta)=S(alpha,-beta) and then applying the detailed
-              //balance factor, exp(-beta/2) twice to the values at beta>0, thus
-              //ensuring in the end that all entries end up with a correct factor:
-              vectAt( sab, offset_alpharow_posbeta + alpha_fact.idx ) += contrib_S_negbeta * expMbeta;
-            }
-          }//alpha loop
+
+            const double * itAlphaFactB = &block_alpha_factors[0] + order.idx * nalpha;
+#if 0
+            //readable version of innermost loop:
+            const auto offset_alpharow = beta_idx*nalpha;
+            const auto offset_alpharow_posbeta = posbeta_idx*nalpha;
+            for ( std::size_t ia = 0; ia < nalpha; ++ia ) {
+              const double alpha_fact = itAlphaFactB[ia];
+              if ( !(alpha_fact>0.0) )
+                continue;
+              double contrib_S_negbeta = alpha_fact * Gn_asym_eval;
+
+              //Negative beta:
+              vectAt( sab, offset_alpharow + ia ) += contrib_S_negbeta;
+              if ( expMbeta ) {
+                //Expand to beta>0 by first copying S-values,
+                //S(alpha,+beta)=S(alpha,-beta) and then applying the detailed
+                //balance factor, exp(-beta/2) twice to the values at beta>0, thus
+                //ensuring in the end that all entries end up with a correct factor:
+                vectAt( sab, offset_alpharow_posbeta + ia ) += contrib_S_negbeta * expMbeta;
+              }
+            }//alpha loop
 #else
-          //Attempt to super-streamline this innermost loop:
-          nc_assert(nalpha==alpha_factors.size());
-          double * itAlphaFactB = &alpha_factors[0];
-          double * itAlphaFact = itAlphaFactB;
-          double * itAlphaFactE = itAlphaFactB + nalpha;
-          //Alpha-factors increase and then decrease. Thus, if we first skip
-          //over any initial zeros in the alpha factors, we can break (rather
-          //than just continue) in the final loop whenever we see a zero.
-
-          //First skip over any initial zeros in alpha-factors:
-          while( !(*itAlphaFact>0.0) && itAlphaFact!=itAlphaFactE )
-            ++itAlphaFact;
-          double * itSAB = &sab[0] + (beta.idx*nalpha + (itAlphaFact-itAlphaFactB));
-          if ( expMbeta) {
-            double * itSAB_posbeta = &sab[0] + (posbeta_idx*nalpha + (itAlphaFact-itAlphaFactB));
-            for (;itAlphaFact!=itAlphaFactE;++itAlphaFact,++itSAB,++itSAB_posbeta) {
-              if ( !(*itAlphaFact>0.0) )
-                break;
-              double contrib_S_negbeta = *itAlphaFact * Gn_asym_eval;
-              *itSAB += contrib_S_negbeta;
-              *itSAB_posbeta += contrib_S_negbeta*expMbeta;
-            }//alpha loop where +-|beta| is available
-          } else {
-            for (;itAlphaFact!=itAlphaFactE;++itAlphaFact,++itSAB) {
-              if ( !(*itAlphaFact>0.0) )
-                break;
-              *itSAB += *itAlphaFact * Gn_asym_eval;
-            }//alpha loop where only -|beta| is available
-          }
+            //Attempt to super-streamline this innermost loop:
+            const double * itAlphaFact = itAlphaFactB;
+            const double * itAlphaFactE = itAlphaFactB + nalpha;
+            //Alpha-factors increase and then decrease. Thus, if we first skip
+            //over any initial zeros in the alpha factors, we can break (rather
+            //than just continue) in the final loop whenever we see a zero.
+
+            //First skip over any initial zeros in alpha-factors:
+            while( !(*itAlphaFact>0.0) && itAlphaFact!=itAlphaFactE )
+              ++itAlphaFact;
+            double * itSAB = &sab[0] + (beta_idx*nalpha + (itAlphaFact-itAlphaFactB));
+            if ( expMbeta) {
+              double * itSAB_posbeta = &sab[0] + (posbeta_idx*nalpha + (itAlphaFact-itAlphaFactB));
+              for (;itAlphaFact!=itAlphaFactE;++itAlphaFact,++itSAB,++itSAB_posbeta) {
+                if ( !(*itAlphaFact>0.0) )
+                  break;
+                double contrib_S_negbeta = *itAlphaFact * Gn_asym_eval;
+                *itSAB += contrib_S_negbeta;
+                *itSAB_posbeta += contrib_S_negbeta*expMbeta;
+              }//alpha loop where +-|beta| is available
+            } else {
+              for (;itAlphaFact!=itAlphaFactE;++itAlphaFact,++itSAB) {
+                if ( !(*itAlphaFact>0.0) )
+                  break;
+                *itSAB += *itAlphaFact * Gn_asym_eval;
+              }//alpha loop where only -|beta| is available
+            }
 #endif
-        }//beta loop
-      }//phonon order loop
+          }//phonon order loop
+        };
+
+        if ( !block_orders.empty() )
+          parallelFor( betaGridNonPositive.size(), nthreads, fillBetaRow );//beta loop
+      }//phonon order block loop
 
       return sab;
     }
@@ -680,10 +716,110 @@ NC::VectD NC::setupBetaGrid( const NC::VDOSGn& Gn, double betaMax, unsigned vdos
   return grid;
 }
 
+namespace NCrystal {
+  namespace V2SKDetail {
+
+    //Select points of a grid to keep, greedily extending each segment between
+    //kept points as long as canSkip(ikeep,iend) allows all points strictly
+    //between them to be removed:
+    template<class TCanSkip>
+    std::vector<std::size_t> thinGrid( std::size_t n, unsigned maxskip, const TCanSkip& canSkip )
+    {
+      std::vector<std::size_t> keep;
+      keep.reserve(n);
+      std::size_t i0 = 0;
+      keep.push_back(0);
+      while ( i0 + 1 < n ) {
+        std::size_t iend = i0 + 1;
+        while ( iend + 1 < n && iend - i0 <= maxskip && canSkip( i0, iend + 1 ) )
+          ++iend;
+        keep.push_back( iend );
+        i0 = iend;
+      }
+      return keep;
+    }
+
+    bool interpolationOK( double a0, double f0, double a1, double f1, double x, double fx,
+                          double tol, double absfloor )
+    {
+      const double fi = SABUtils::interpolate_loglin_fallbacklinlin( a0, f0, a1, f1, x );
+      return ncabs( fi - fx ) <= tol * ncabs( fx ) + absfloor;
+    }
+
+  }
+}
+
+std::size_t NC::thinScatteringKernel( ScatKnlData& knl, double tol, double protectBeta, unsigned maxskip )
+{
+  nc_assert_always( tol > 0.0 && maxskip > 0 );
+  const std::size_t nalpha = knl.alphaGrid.size();
+  const std::size_t nbeta = knl.betaGrid.size();
+  nc_assert_always( knl.sab.size() == nalpha * nbeta );
+  if ( nalpha < 3 && nbeta < 3 )
+    return 0;
+  //Tiny values are irrelevant for both integrated cross sections and sampling,
+  //so errors are only required to be small relative to the largest value:
+  double smax = 0.0;
+  for ( auto v : knl.sab )
+    smax = ncmax( smax, v );
+  const double absfloor = tol * 1e-8 * smax;
+  const auto& ag = knl.alphaGrid;
+  const auto& bg = knl.betaGrid;
+  const auto& sab = knl.sab;
+
+  //Beta points, requiring all alpha values to be reproduced:
+  auto betaKeep = V2SKDetail::thinGrid( nbeta, maxskip, [&]( std::size_t i0, std::size_t i1 )
+  {
+    for ( std::size_t j = i0 + 1; j < i1; ++j ) {
+      if ( ncabs( bg[j] ) < protectBeta )
+        return false;
+      for ( std::size_t ia = 0; ia < nalpha; ++ia )
+        if ( !V2SKDetail::interpolationOK( bg[i0], sab[i0*nalpha+ia], bg[i1], sab[i1*nalpha+ia],
+                                           bg[j], sab[j*nalpha+ia], tol, absfloor ) )
+          return false;
+    }
+    return true;
+  } );
+
+  //Alpha points, requiring values at all remaining beta values to be reproduced:
+  auto alphaKeep = V2SKDetail::thinGrid( nalpha, maxskip, [&]( std::size_t i0, std::size_t i1 )
+  {
+    for ( std::size_t j = i0 + 1; j < i1; ++j ) {
+      for ( auto ib : betaKeep ) {
+        const double * row = &sab[ib*nalpha];
+        if ( !V2SKDetail::interpolationOK( ag[i0], row[i0], ag[i1], row[i1],
+                                           ag[j], row[j], tol, absfloor ) )
+          return false;
+      }
+    }
+    return true;
+  } );
+
+  const std::size_t nremoved = nalpha * nbeta - alphaKeep.size() * betaKeep.size();
+  if ( !nremoved )
+    return 0;
+  VectD newalpha, newbeta, newsab;
+  newalpha.reserve( alphaKeep.size() );
+  newbeta.reserve( betaKeep.size() );
+  newsab.reserve( alphaKeep.size() * betaKeep.size() );
+  for ( auto ia : alphaKeep )
+    newalpha.push_back( ag[ia] );
+  for ( auto ib : betaKeep ) {
+    newbeta.push_back( bg[ib] );
+    for ( auto ia : alphaKeep )
+      newsab.push_back( sab[ib*nalpha+ia] );
+  }
+  knl.alphaGrid = std::move(newalpha);
+  knl.betaGrid = std::move(newbeta);
+  knl.sab = std::move(newsab);
+  return nremoved;
+}
+
 NC::ScatKnlData NC::createScatteringKernel( const VDOSData& vdosdata,
                                             unsigned vdoslux,
                                             double targetEmax_requested,
-                                            VDOSGn::TruncAndThinningParams ttpars )
+                                            VDOSGn::TruncAndThinningParams ttpars,
+                                            double thintol )
 {
   //Hidden unofficial env-vars used for special debugging purposes:
   auto getEnvInt = [](const char* name) { auto ev = getenv(name); return ev ? str2int(ev) :   0; };
@@ -815,6 +951,17 @@ NC::ScatKnlData NC::createScatteringKernel( const VDOSData& vdosdata,
   out.alphaGrid = std::move(alphaGrid);
   out.betaGrid  = std::move(betaGrid);
   out.sab       = std::move(sab);
+
+  nc_assert_always( thintol >= 0.0 && thintol <= 0.1 );
+  if ( thintol > 0.0 ) {
+    //Protect the fine-grained points near beta=0 added in setupBetaGrid
+    //(placed below 0.1 times the reach of the 1-phonon spectrum):
+    const double G1 = ncabs( Gn_asym.eRange(1).first * invkT );
+    auto nremoved = thinScatteringKernel( out, thintol, 0.1 * G1 * 1.0001 );
+    if (V2SKDetail::s_verbose)
+      std::cout<<"NCrystal::VDOS2SK thinned SK with tolerance "<<thintol<<" to nalpha="<<out.alphaGrid.size()
+               << " nbeta="<<out.betaGrid.size()<<" ("<<nremoved<<" points removed)"<<std::endl;
+  }
   out.temperature = vdoseval.temperature();
   out.boundXS = vdosdata.boundXS();
   out.elementMassAMU = vdosdata.elementMassAMU();
@@ -32,9 +32,17 @@
 #include "NCrystal/internal/NCAtomUtils.hh"
 #include "NCrystal/internal/NCDebyeMSD.hh"
 #include "NCrystal/internal/NCAtomDB.hh"
+#include "NCrystal/internal/NCFactoryUtils.hh"
+#include "NCrystal/internal/NCNCMATBinary.hh"
+#include "NCrystal/internal/NCFlatBlob.hh"
+#include "NCrystal/internal/NCThreadUtils.hh"
+#include "NCrystal/internal/NCCounters.hh"
+#include "NCrystal/internal/NCGroupXS.hh"
 #include <cstring>
 #include <cstdio>
 #include <cstdlib>
+#include <thread>
+#include <atomic>
 
 namespace NCrystal {
 
@@ -229,6 +237,68 @@ namespace NCrystal {
     Wrapped_AtomData& extractWrapper(Wrapped_AtomData::c_handle_type h) { return extractWrapperImpl<Wrapped_AtomData>(h); }
     Wrapped_AtomData::object_type& extract(Wrapped_AtomData::c_handle_type h) { return extractWrapperImpl<Wrapped_AtomData>(h).obj(); }
 
+    ////////////////////////////////////////////////////////////////////////////////////
+    //Batch contexts (all mutable state needed for using a process object in the
+    //batch interfaces, keeping a reference to the physics to guard against
+    //mismatched usage):
+    struct BatchCtx {
+      BatchCtx( ProcImpl::ProcPtr pp, std::shared_ptr<RNG> r )
+        : proc(std::move(pp)), rng(std::move(r)) {}
+      ProcImpl::ProcPtr proc;
+      CachePtr cache;
+      std::shared_ptr<RNG> rng;//null for absorption
+    };
+    //RNG stream delegating to a caller-provided callback, with a userdata
+    //pointer so callers can keep separate generator states per context:
+    class RNG_CtxCallback final : public RNGStream {
+    public:
+      using fct_t = void(*)(void*,double*,unsigned);
+      RNG_CtxCallback( fct_t fct, void* userdata ) : m_fct(fct), m_userdata(userdata) {}
+    protected:
+      double actualGenerate() override
+      {
+        double r;
+        m_fct( m_userdata, &r, 1 );
+        return r;
+      }
+      void actualGenerateMany( std::size_t n, double* tgt ) override
+      {
+        while ( n ) {
+          const unsigned nchunk = static_cast<unsigned>( std::min<std::size_t>( n, std::numeric_limits<unsigned>::max() ) );
+          m_fct( m_userdata, tgt, nchunk );
+          tgt += nchunk;
+          n -= nchunk;
+        }
+      }
+    private:
+      fct_t m_fct;
+      void* m_userdata;
+    };
+    struct WrappedDef_BatchCtx {
+      using object_type = BatchCtx;
+      using c_handle_type = ncrystal_batchctx_t;
+      static constexpr ObjectTypeID object_typeid = 0x3e1f5a0b;//randomly generated 32 bits
+      static constexpr const char * name() { return "BatchCtx"; }
+    };
+    using Wrapped_BatchCtx = Wrapped<WrappedDef_BatchCtx>;
+    Wrapped_BatchCtx::object_type& extract(Wrapped_BatchCtx::c_handle_type h) { return extractWrapperImpl<Wrapped_BatchCtx>(h).obj(); }
+
+    ////////////////////////////////////////////////////////////////////////////////////
+    //Pending results of ncrystal_create_xxx_async calls (only the future
+    //corresponding to the type of object being created is valid):
+    struct PendingResult {
+      std::shared_future<shared_obj<const Info>> info;
+      std::shared_future<shared_obj<const ProcImpl::Process>> scatter, absorption;
+    };
+    struct WrappedDef_Pending {
+      using object_type = PendingResult;
+      using c_handle_type = ncrystal_pending_t;
+      static constexpr ObjectTypeID object_typeid = 0x9b52d7e4;//randomly generated 32 bits
+      static constexpr const char * name() { return "Pending"; }
+    };
+    using Wrapped_Pending = Wrapped<WrappedDef_Pending>;
+    Wrapped_Pending::object_type& extract(Wrapped_Pending::c_handle_type h) { return extractWrapperImpl<Wrapped_Pending>(h).obj(); }
+
     Process& extractProcess(ncrystal_process_t h)
     {
       ObjectTypeID objtypeid = h.internal ? extractObjectTypeID(h.internal) : 0x0;
@@ -249,6 +319,8 @@ namespace NCrystal {
       static_assert(std::is_standard_layout<ncrystal_absorption_t>::value,"");
       static_assert(std::is_standard_layout<ncrystal_atomdata_t>::value,"");
       static_assert(std::is_standard_layout<ncrystal_info_t>::value,"");
+      static_assert(std::is_standard_layout<ncrystal_batchctx_t>::value,"");
+      static_assert(std::is_standard_layout<ncrystal_pending_t>::value,"");
       return *reinterpret_cast<void**>(o);
     }
 
@@ -259,28 +331,51 @@ namespace NCrystal {
                       " not the handle itself.");
     }
 
-    static int quietonerror = 0;
-    static int haltonerror = 1;
-    static int waserror = 0;
-    static char errmsg[512];
-    static char errtype[64];
-    static void (*custom_error_handler)(char *,char*) = 0;
+    //Configuration is global, but the error status itself is by default kept
+    //per thread, so that worker threads can check for errors without
+    //locking. The legacy process-wide status can be enabled with
+    //ncrystal_setthreadlocalerrors(0):
+    static std::atomic<int> quietonerror{0};
+    static std::atomic<int> haltonerror{1};
+    static std::atomic<int> threadlocalerrors{1};
+    static std::atomic<void (*)(char *,char*)> custom_error_handler{nullptr};
+
+    struct ErrorState {
+      int waserror = 0;
+      char errmsg[512];
+      char errtype[64];
+    };
+
+    ErrorState& errorState()
+    {
+      static ErrorState s_global;
+      if ( !threadlocalerrors.load() )
+        return s_global;
+#ifndef NCRYSTAL_DISABLE_THREADS
+      thread_local ErrorState t_state;
+      return t_state;
+#else
+      return s_global;
+#endif
+    }
 
     void setError(const char *msg, const char * etype = 0) throw() {
       if (!etype)
         etype="ncrystal_c-interface";
-      strncpy(errmsg,msg,sizeof(errmsg)-1);
-      strncpy(errtype,etype,sizeof(errtype)-1);
+      ErrorState& es = errorState();
+      strncpy(es.errmsg,msg,sizeof(es.errmsg)-1);
+      strncpy(es.errtype,etype,sizeof(es.errtype)-1);
       //Ensure final null-char in case of very long input strings:
-      errmsg[sizeof(errmsg)-1]='\0';
-      errtype[sizeof(errtype)-1]='\0';
-      if (custom_error_handler) {
-        (*custom_error_handler)(errtype,errmsg);
+      es.errmsg[sizeof(es.errmsg)-1]='\0';
+      es.errtype[sizeof(es.errtype)-1]='\0';
+      auto handler = custom_error_handler.load();
+      if (handler) {
+        (*handler)(es.errtype,es.errmsg);
       }
-      waserror = 1;
-      if (!quietonerror)
-        printf("NCrystal ERROR [%s]: %s\n",errtype,errmsg);
-      if (haltonerror) {
+      es.waserror = 1;
+      if (!quietonerror.load())
+        printf("NCrystal ERROR [%s]: %s\n",es.errtype,es.errmsg);
+      if (haltonerror.load()) {
         printf("NCrystal terminating due to ERROR\n");
         exit(1);
       }
@@ -312,36 +407,39 @@ void ncrystal_seterrhandler(void (*handler)(char*,char*))
 
 int ncrystal_error()
 {
-  return ncc::waserror;
+  return ncc::errorState().waserror;
 }
 
 const char * ncrystal_lasterror()
 {
-  return ncc::waserror ? ncc::errmsg : 0;
+  auto& es = ncc::errorState();
+  return es.waserror ? es.errmsg : 0;
 }
 
 const char * ncrystal_lasterrortype()
 {
-  return ncc::waserror ? ncc::errtype : 0;
+  auto& es = ncc::errorState();
+  return es.waserror ? es.errtype : 0;
 }
 
 void ncrystal_clearerror()
 {
-  ncc::waserror = 0;
+  ncc::errorState().waserror = 0;
 }
 
 int ncrystal_setquietonerror(int q)
 {
-  int old = ncc::quietonerror;
-  ncc::quietonerror = q;
-  return old;
+  return ncc::quietonerror.exchange(q);
 }
 
 int ncrystal_sethaltonerror(int h)
 {
-  int old = ncc::haltonerror;
-  ncc::haltonerror = h;
-  return old;
+  return ncc::haltonerror.exchange(h);
+}
+
+int ncrystal_setthreadlocalerrors(int t)
+{
+  return ncc::threadlocalerrors.exchange(t ? 1 : 0);
 }
 
 int ncrystal_valid(void* object)
@@ -403,6 +501,8 @@ int ncrystal_refcount(void* addrhandle)
       case ncc::Wrapped_Scatter::object_typeid():    return static_cast<int>(ncc::forceCastWrapper<ncc::Wrapped_Scatter>(o).refCount());
       case ncc::Wrapped_Absorption::object_typeid(): return static_cast<int>(ncc::forceCastWrapper<ncc::Wrapped_Absorption>(o).refCount());
       case ncc::Wrapped_AtomData::object_typeid():   return static_cast<int>(ncc::forceCastWrapper<ncc::Wrapped_AtomData>(o).refCount());
+      case ncc::Wrapped_BatchCtx::object_typeid():   return static_cast<int>(ncc::forceCastWrapper<ncc::Wrapped_BatchCtx>(o).refCount());
+      case ncc::Wrapped_Pending::object_typeid():    return static_cast<int>(ncc::forceCastWrapper<ncc::Wrapped_Pending>(o).refCount());
       default: ncc::throwInvalidHandleType("ncrystal_refcount");
     };
   } NCCATCH;
@@ -418,6 +518,8 @@ void ncrystal_ref(void* addrhandle)
       case ncc::Wrapped_Scatter::object_typeid():    return ncc::forceCastWrapper<ncc::Wrapped_Scatter>(o).ref();
       case ncc::Wrapped_Absorption::object_typeid(): return ncc::forceCastWrapper<ncc::Wrapped_Absorption>(o).ref();
       case ncc::Wrapped_AtomData::object_typeid():   return ncc::forceCastWrapper<ncc::Wrapped_AtomData>(o).ref();
+      case ncc::Wrapped_BatchCtx::object_typeid():   return ncc::forceCastWrapper<ncc::Wrapped_BatchCtx>(o).ref();
+      case ncc::Wrapped_Pending::object_typeid():    return ncc::forceCastWrapper<ncc::Wrapped_Pending>(o).ref();
       default: ncc::throwInvalidHandleType("ncrystal_ref");
     };
   } NCCATCH;
@@ -445,6 +547,8 @@ void ncrystal_unref(void* addrhandle)
       case ncc::Wrapped_Scatter::object_typeid():    return ncc::doUnref<ncc::Wrapped_Scatter>(addrhandle);
       case ncc::Wrapped_Absorption::object_typeid(): return ncc::doUnref<ncc::Wrapped_Absorption>(addrhandle);
       case ncc::Wrapped_AtomData::object_typeid():   return ncc::doUnref<ncc::Wrapped_AtomData>(addrhandle);
+      case ncc::Wrapped_BatchCtx::object_typeid():   return ncc::doUnref<ncc::Wrapped_BatchCtx>(addrhandle);
+      case ncc::Wrapped_Pending::object_typeid():    return ncc::doUnref<ncc::Wrapped_Pending>(addrhandle);
       default: ncc::throwInvalidHandleType("ncrystal_unref");
     };
   } NCCATCH;
@@ -459,6 +563,107 @@ void ncrystal_invalidate(void* o)
 
 void ncrystal_dump(ncrystal_info_t ci) { try { NC::dump(ncc::extract(ci)); } NCCATCH; }
 
+void ncrystal_info_memory_footprint( ncrystal_info_t ci,
+                                     double* exclusive_bytes,
+                                     double* shared_bytes )
+{
+  try {
+    auto mf = NC::memoryFootprint( *ncc::extract(ci) );
+    *exclusive_bytes = static_cast<double>( mf.exclusiveBytes() );
+    *shared_bytes = static_cast<double>( mf.sharedBytes() );
+  } NCCATCH;
+}
+
+void ncrystal_process_memory_footprint( ncrystal_process_t o,
+                                        double* exclusive_bytes,
+                                        double* shared_bytes )
+{
+  try {
+    auto mf = NC::memoryFootprint( ncc::extractProcess(o).underlying() );
+    *exclusive_bytes = static_cast<double>( mf.exclusiveBytes() );
+    *shared_bytes = static_cast<double>( mf.sharedBytes() );
+  } NCCATCH;
+}
+
+void ncrystal_dump_info_memory_footprint( ncrystal_info_t ci )
+{
+  try {
+    NC::dumpMemoryFootprint( *ncc::extract(ci) );
+  } NCCATCH;
+}
+
+void ncrystal_dump_process_memory_footprint( ncrystal_process_t o )
+{
+  try {
+    NC::dumpMemoryFootprint( ncc::extractProcess(o).underlying() );
+  } NCCATCH;
+}
+
+namespace NCrystal {
+  namespace NCCInterface {
+    namespace {
+      ProcImpl::ProfiledProcess::Callback wrapProfileCallback( ncrystal_profile_callback_t cb, void* userdata )
+      {
+        if ( !cb )
+          NCRYSTAL_THROW(BadInput,"Profiling callback must not be NULL");
+        return [cb,userdata]( const std::vector<ProcImpl::ProfiledProcess::Entry>& entries )
+        {
+          const std::size_t n = entries.size();
+          std::vector<const char*> names;
+          std::vector<unsigned> depths;
+          std::vector<double> vals;
+          names.reserve( n );
+          depths.reserve( n );
+          vals.resize( 4*n );
+          for ( std::size_t i = 0; i < n; ++i ) {
+            auto& e = entries[i];
+            names.push_back( e.name );
+            depths.push_back( e.depth );
+            vals[i] = static_cast<double>( e.nCallsXS );
+            vals[n+i] = e.timeXS;
+            vals[2*n+i] = static_cast<double>( e.nCallsSampling );
+            vals[3*n+i] = e.timeSampling;
+          }
+          (*cb)( userdata, static_cast<unsigned>( n ), names.data(), depths.data(),
+                 vals.data(), vals.data() + n, vals.data() + 2*n, vals.data() + 3*n );
+        };
+      }
+    }
+  }
+}
+
+ncrystal_scatter_t ncrystal_create_profiled_scatter( ncrystal_scatter_t sh,
+                                                     ncrystal_profile_callback_t cb,
+                                                     void* userdata,
+                                                     unsigned long report_interval,
+                                                     double sample_fraction )
+{
+  try {
+    auto& sc = ncc::extract(sh);
+    auto pp = NC::ProcImpl::ProfiledProcess::wrap( sc.underlyingPtr(), ncc::wrapProfileCallback(cb,userdata),
+                                                   static_cast<uint64_t>(report_interval), sample_fraction );
+    return ncc::createNewCHandle<ncc::Wrapped_Scatter>( NC::Scatter( sc.rngproducerSO(),
+                                                                     sc.rngproducer().produce(),
+                                                                     std::move(pp) ) );
+  } NCCATCH;
+  return {nullptr};
+}
+
+ncrystal_absorption_t ncrystal_create_profiled_absorption( ncrystal_absorption_t ah,
+                                                           ncrystal_profile_callback_t cb,
+                                                           void* userdata,
+                                                           unsigned long report_interval,
+                                                           double sample_fraction )
+{
+  try {
+    auto& absn = ncc::extract(ah);
+    auto pp = NC::ProcImpl::ProfiledProcess::wrap( absn.underlyingPtr(), ncc::wrapProfileCallback(cb,userdata),
+                                                   static_cast<uint64_t>(report_interval), sample_fraction );
+    return ncc::createNewCHandle<ncc::Wrapped_Absorption>( NC::Absorption( std::move(pp) ) );
+  } NCCATCH;
+  return {nullptr};
+}
+
 int ncrystal_info_getstructure( ncrystal_info_t ci,
                                 unsigned* spacegroup,
                                 double* lattice_a, double* lattice_b, double* lattice_c,
@@ -580,6 +785,56 @@ void ncrystal_info_gethkl( ncrystal_info_t ci, int idx,
   *dspacing = *fsquared = -1.0;
 }
 
+void ncrystal_info_gethkl_all( ncrystal_info_t ci,
+                               int* h, int* k, int* l, int* multiplicity,
+                               double * dspacing, double* fsquared )
+{
+  try {
+    auto& info = ncc::extract(ci);
+    std::size_t i = 0;
+    for ( auto& e : info->hklList() ) {
+      h[i] = e.h;
+      k[i] = e.k;
+      l[i] = e.l;
+      multiplicity[i] = e.multiplicity;
+      dspacing[i] = e.dspacing;
+      fsquared[i] = e.fsquared;
+      ++i;
+    }
+  } NCCATCH;
+}
+
+unsigned ncrystal_info_ndeminormals( ncrystal_info_t ci )
+{
+  try {
+    auto& info = ncc::extract(ci);
+    if ( !info->hasHKLDemiNormals() )
+      return 0;
+    std::size_t n = 0;
+    for ( auto& e : info->hklList() )
+      n += e.demi_normals.size();
+    nc_assert_always( n < std::numeric_limits<unsigned>::max() );
+    return static_cast<unsigned>( n );
+  } NCCATCH;
+  return 0;
+}
+
+void ncrystal_info_getdeminormals_all( ncrystal_info_t ci, double* normals )
+{
+  try {
+    auto& info = ncc::extract(ci);
+    if ( !info->hasHKLDemiNormals() )
+      return;
+    for ( auto& e : info->hklList() ) {
+      for ( auto& dn : e.demi_normals ) {
+        *normals++ = dn[0];
+        *normals++ = dn[1];
+        *normals++ = dn[2];
+      }
+    }
+  } NCCATCH;
+}
+
 
 unsigned ncrystal_info_ndyninfo( ncrystal_info_t ci )
 {
@@ -862,6 +1117,165 @@ void ncrystal_crosssection_nonoriented_many( ncrystal_process_t o,
   }
 }
 
+void ncrystal_samplescatterisotropic_hist( ncrystal_scatter_t o,
+                                          double ekin,
+                                          unsigned long n_samples,
+                                          int xvar, unsigned nbinsx,
+                                          double xmin, double xmax,
+                                          int yvar, unsigned nbinsy,
+                                          double ymin, double ymax,
+                                          double temperature,
+                                          unsigned nthreads,
+                                          double * results )
+{
+  const unsigned long nbins_tot = static_cast<unsigned long>(nbinsx) * ( yvar ? nbinsy : 1 );
+  try {
+    auto& sc = ncc::extract(o);
+    if ( sc.isOriented() )
+      NCRYSTAL_THROW(BadInput,"ncrystal_samplescatterisotropic_hist: only supported for non-oriented processes.");
+    auto validVar = []( int v ) { return v >= 1 && v <= 5; };
+    if ( !(ekin>0.0) || !validVar(xvar) || !nbinsx || !(xmax>xmin)
+         || ( yvar && ( !validVar(yvar) || !nbinsy || !(ymax>ymin) ) ) )
+      NCRYSTAL_THROW(BadInput,"ncrystal_samplescatterisotropic_hist: invalid parameters.");
+    const bool needs_kT = ( xvar >= 4 || yvar >= 4 );
+    if ( needs_kT && !(temperature>0.0) )
+      NCRYSTAL_THROW(BadInput,"ncrystal_samplescatterisotropic_hist: alpha and beta require a temperature.");
+    const double inv_kT = needs_kT ? 1.0 / NC::Temperature{temperature}.kT() : 0.0;
+    const double ki_sq = NC::k4PiSq * NC::ekin2wlsqinv(ekin);
+    auto evalVar = [ekin,inv_kT,ki_sq]( int var, double ef, double mu )
+    {
+      switch (var) {
+      case 1: return ef - ekin;
+      case 2: return mu;
+      case 3: {
+        const double kf_sq = NC::k4PiSq * NC::ekin2wlsqinv(ef);
+        return std::sqrt( std::max( 0.0, ki_sq + kf_sq - 2.0 * mu * std::sqrt( ki_sq * kf_sq ) ) );
+      }
+      case 4: return ( ekin + ef - 2.0 * mu * std::sqrt( ekin * ef ) ) * inv_kT;
+      default: return ( ef - ekin ) * inv_kT;
+      };
+    };
+    auto binIdx = []( double v, double vmin, double vmax, unsigned nbins ) -> long
+    {
+      if ( !( v >= vmin && v < vmax ) )
+        return -1;
+      return std::min<long>( nbins - 1, static_cast<long>( ( v - vmin ) / ( vmax - vmin ) * nbins ) );
+    };
+
+    //Fixed size chunks each with their own RNG stream and cache, so results
+    //are independent of the number of threads:
+    constexpr unsigned long chunksize = 100000;
+    const unsigned long nchunks = ( n_samples + chunksize - 1 ) / chunksize;
+    std::vector<NC::shared_obj<NC::RNGStream>> rngs;
+    rngs.reserve( nchunks );
+    for ( unsigned long i = 0; i < nchunks; ++i )
+      rngs.push_back( sc.rngproducer().produce() );
+    if ( nthreads == 0 )
+      nthreads = std::max<unsigned>( 1, std::thread::hardware_concurrency() );
+    const auto& proc = sc.underlying();
+    std::fill( results, results + nbins_tot, 0.0 );
+    std::mutex mtx;
+    NC::parallelFor( nchunks, nthreads, [&]( std::size_t ichunk )
+    {
+      const unsigned long nchunk = std::min( chunksize, n_samples - ichunk * chunksize );
+      NC::VectD hist( nbins_tot, 0.0 );
+      NC::CachePtr cache;
+      constexpr std::size_t nbuf = 4096;
+      NC::VectD buf_ekin( nbuf ), buf_mu( nbuf );
+      for ( unsigned long done = 0; done < nchunk; ) {
+        const std::size_t n = static_cast<std::size_t>( std::min<unsigned long>( nbuf, nchunk - done ) );
+        std::fill( buf_ekin.begin(), buf_ekin.begin() + n, ekin );
+        proc.sampleScatterIsotropicMany( cache, rngs[ichunk], buf_ekin.data(), n, buf_mu.data() );
+        for ( std::size_t i = 0; i < n; ++i ) {
+          const long ix = binIdx( evalVar( xvar, buf_ekin[i], buf_mu[i] ), xmin, xmax, nbinsx );
+          if ( ix < 0 )
+            continue;
+          if ( !yvar ) {
+            hist[ix] += 1.0;
+            continue;
+          }
+          const long iy = binIdx( evalVar( yvar, buf_ekin[i], buf_mu[i] ), ymin, ymax, nbinsy );
+          if ( iy >= 0 )
+            hist[ ix * nbinsy + iy ] += 1.0;
+        }
+        done += n;
+      }
+      //Bin contents are integral counts, so the summation order does not matter:
+      NCRYSTAL_LOCK_GUARD(mtx);
+      for ( unsigned long i = 0; i < nbins_tot; ++i )
+        results[i] += hist[i];
+    } );
+    return;
+  } NCCATCH;
+  std::fill( results, results + nbins_tot, -1.0 );
+}
+
+void ncrystal_crosssection_grid( ncrystal_process_t o,
+                                 const double * ekin,
+                                 unsigned long n_ekin,
+                                 const double (*direction)[3],
+                                 unsigned long n_dir,
+                                 unsigned nthreads,
+                                 double* results )
+{
+  try {
+    const auto& proc = ncc::extractProcess(o).underlying();
+    if ( nthreads == 0 )
+      nthreads = std::max<unsigned>( 1, std::thread::hardware_concurrency() );
+    if ( nthreads > n_ekin )
+      nthreads = static_cast<unsigned>( std::max<unsigned long>( 1, n_ekin ) );
+    //Directions in structure-of-arrays layout for evalManyXS:
+    NC::VectD ux(n_dir), uy(n_dir), uz(n_dir);
+    for ( unsigned long j = 0; j < n_dir; ++j ) {
+      ux[j] = direction[j][0];
+      uy[j] = direction[j][1];
+      uz[j] = direction[j][2];
+    }
+    //One task (and cache) per thread, each handling a contiguous range of energies:
+    NC::parallelFor( nthreads, nthreads, [&]( std::size_t itask )
+    {
+      const unsigned long ibegin = n_ekin * itask / nthreads;
+      const unsigned long iend = n_ekin * ( itask + 1 ) / nthreads;
+      NC::CachePtr cache;
+      NC::VectD ekinbuf( n_dir );
+      for ( unsigned long i = ibegin; i < iend; ++i ) {
+        std::fill( ekinbuf.begin(), ekinbuf.end(), ekin[i] );
+        proc.evalManyXS( cache, ekinbuf.data(), ux.data(), uy.data(), uz.data(),
+                         n_dir, results + i * n_dir );
+      }
+    } );
+    return;
+  } NCCATCH;
+  std::fill( results, results + n_ekin * n_dir, -1.0 );
+}
+
+void ncrystal_groupaveraged_xs( ncrystal_process_t o,
+                                const double * group_bounds,
+                                unsigned long n_bounds,
+                                const double * flux_ekin,
+                                const double * flux_values,
+                                unsigned long n_flux,
+                                double precision,
+                                unsigned nthreads,
+                                double* results )
+{
+  try {
+    const auto& proc = ncc::extractProcess(o).underlying();
+    NC::GroupXSParams params;
+    params.precision = precision;
+    params.nthreads = nthreads;
+    auto xs = NC::groupAveragedXS( proc,
+                                   NC::VectD( group_bounds, group_bounds + n_bounds ),
+                                   NC::VectD( flux_ekin, flux_ekin + n_flux ),
+                                   NC::VectD( flux_values, flux_values + n_flux ),
+                                   params );
+    std::copy( xs.begin(), xs.end(), results );
+    return;
+  } NCCATCH;
+  if ( n_bounds > 1 )
+    std::fill( results, results + ( n_bounds - 1 ), -1.0 );
+}
+
 void ncrystal_samplescatterisotropic( ncrystal_scatter_t o,
                                       double ekin,
                                       double* ekin_final,
@@ -962,6 +1376,342 @@ void ncrystal_samplescatter_many( ncrystal_scatter_t o,
 
 }
 
+namespace NCrystal {
+  namespace NCCInterface {
+    ncrystal_batchctx_t createBatchCtx( ncrystal_process_t o, Optional<RNGStreamIndex> rngidx )
+    {
+      auto& process = extractProcess(o);
+      std::shared_ptr<RNG> rng;
+      auto wsc = tryCastWrapper<Wrapped_Scatter>(o.internal);
+      if ( wsc ) {
+        auto& rngproducer = wsc->obj().rngproducer();
+        rng = ( rngidx.has_value()
+                ? rngproducer.produceByIdx( rngidx.value() )
+                : rngproducer.produceForCurrentThread() ).getsp();
+      }
+      return createNewCHandle<Wrapped_BatchCtx>( process.underlyingPtr(), std::move(rng) );
+    }
+
+    BatchCtx& extractBatchCtx( ncrystal_batchctx_t ctx, const Process& process, bool needsRNG )
+    {
+      auto& bc = extract(ctx);
+      if ( &(*bc.proc) != &process.underlying() )
+        NCRYSTAL_THROW(LogicError,"Batch context was created for a different process object.");
+      if ( needsRNG && !bc.rng )
+        NCRYSTAL_THROW(LogicError,"Batch context has no RNG stream (it was not created for a scatter object).");
+      return bc;
+    }
+  }
+}
+
+ncrystal_batchctx_t ncrystal_create_batchctx( ncrystal_process_t o, unsigned long rngstreamidx )
+{
+  try {
+    return ncc::createBatchCtx( o, NC::RNGStreamIndex{(uint64_t)rngstreamidx} );
+  } NCCATCH;
+  return {nullptr};
+}
+
+ncrystal_batchctx_t ncrystal_create_batchctx_forcurrentthread( ncrystal_process_t o )
+{
+  try {
+    return ncc::createBatchCtx( o, NC::NullOpt );
+  } NCCATCH;
+  return {nullptr};
+}
+
+ncrystal_batchctx_t ncrystal_create_batchctx_customrng( ncrystal_process_t o,
+                                                        void (*rg)(void*,double*,unsigned),
+                                                        void* userdata )
+{
+  try {
+    auto& process = ncc::extractProcess(o);
+    if ( !rg )
+      NCRYSTAL_THROW(BadInput,"ncrystal_create_batchctx_customrng: RNG callback must not be NULL.");
+    std::shared_ptr<NC::RNG> rng;
+    if ( process.processType() == NC::ProcessType::Scatter )
+      rng = std::make_shared<ncc::RNG_CtxCallback>( rg, userdata );
+    return ncc::createNewCHandle<ncc::Wrapped_BatchCtx>( process.underlyingPtr(), std::move(rng) );
+  } NCCATCH;
+  return {nullptr};
+}
+
+void ncrystal_crosssection_nonoriented_ctx( ncrystal_process_t o,
+                                            ncrystal_batchctx_t ctx,
+                                            double ekin,
+                                            double* result )
+{
+  try {
+    auto& bc = ncc::extractBatchCtx( ctx, ncc::extractProcess(o), false );
+    *result = bc.proc->crossSectionIsotropic( bc.cache, NC::NeutronEnergy{ekin} ).get();
+    return;
+  } NCCATCH;
+  *result = -1.0;
+}
+
+void ncrystal_crosssection_ctx( ncrystal_process_t o,
+                                ncrystal_batchctx_t ctx,
+                                double ekin,
+                                const double (*direction)[3],
+                                double* result )
+{
+  try {
+    auto& bc = ncc::extractBatchCtx( ctx, ncc::extractProcess(o), false );
+    *result = bc.proc->crossSection( bc.cache, NC::NeutronEnergy{ekin},
+                                     NC::NeutronDirection{*direction} ).get();
+    return;
+  } NCCATCH;
+  *result = -1.0;
+}
+
+void ncrystal_samplescatterisotropic_ctx( ncrystal_scatter_t o,
+                                          ncrystal_batchctx_t ctx,
+                                          double ekin,
+                                          double* ekin_final,
+                                          double* cos_scat_angle )
+{
+  try {
+    auto& bc = ncc::extractBatchCtx( ctx, ncc::extract(o), true );
+    auto outcome = bc.proc->sampleScatterIsotropic( bc.cache, *bc.rng, NC::NeutronEnergy{ekin} );
+    *ekin_final = outcome.ekin.dbl();
+    *cos_scat_angle = outcome.mu.dbl();
+    return;
+  } NCCATCH;
+  *ekin_final = -1.0;
+  *cos_scat_angle = -999;
+}
+
+void ncrystal_samplescatter_ctx( ncrystal_scatter_t o,
+                                 ncrystal_batchctx_t ctx,
+                                 double ekin,
+                                 const double (*direction)[3],
+                                 double* ekin_final,
+                                 double (*direction_final)[3] )
+{
+  try {
+    auto& bc = ncc::extractBatchCtx( ctx, ncc::extract(o), true );
+    auto outcome = bc.proc->sampleScatter( bc.cache, *bc.rng, NC::NeutronEnergy{ekin},
+                                           NC::NeutronDirection{*direction} );
+    *ekin_final = outcome.ekin.dbl();
+    outcome.direction.applyTo(*direction_final);
+    return;
+  } NCCATCH;
+  *ekin_final = -1.0;
+  (*direction_final)[0] = (*direction_final)[1] = (*direction_final)[2] = 0.0;
+}
+
+namespace NCrystal {
+  namespace NCCInterface {
+    inline BatchCtx& extractUnchecked( ncrystal_fastctx_t h )
+    {
+      nc_assert( h.internal != nullptr );
+      return *static_cast<BatchCtx*>( h.internal );
+    }
+  }
+}
+
+ncrystal_fastctx_t ncrystal_resolve_batchctx( ncrystal_process_t o, ncrystal_batchctx_t ctx )
+{
+  try {
+    auto& bc = ncc::extractBatchCtx( ctx, ncc::extractProcess(o), false );
+    return { &bc };
+  } NCCATCH;
+  return {nullptr};
+}
+
+double ncrystal_crosssection_nonoriented_unchecked( ncrystal_fastctx_t fc, double ekin )
+{
+  try {
+    auto& bc = ncc::extractUnchecked( fc );
+    return bc.proc->crossSectionIsotropic( bc.cache, NC::NeutronEnergy{ekin} ).get();
+  } NCCATCH;
+  return -1.0;
+}
+
+double ncrystal_crosssection_unchecked( ncrystal_fastctx_t fc,
+                                        double ekin,
+                                        const double (*direction)[3] )
+{
+  try {
+    auto& bc = ncc::extractUnchecked( fc );
+    return bc.proc->crossSection( bc.cache, NC::NeutronEnergy{ekin},
+                                  NC::NeutronDirection{*direction} ).get();
+  } NCCATCH;
+  return -1.0;
+}
+
+void ncrystal_samplescatterisotropic_unchecked( ncrystal_fastctx_t fc,
+                                                double ekin,
+                                                double* ekin_final,
+                                                double* cos_scat_angle )
+{
+  try {
+    auto& bc = ncc::extractUnchecked( fc );
+    nc_assert( bc.rng != nullptr );
+    auto outcome = bc.proc->sampleScatterIsotropic( bc.cache, *bc.rng, NC::NeutronEnergy{ekin} );
+    *ekin_final = outcome.ekin.dbl();
+    *cos_scat_angle = outcome.mu.dbl();
+    return;
+  } NCCATCH;
+  *ekin_final = -1.0;
+  *cos_scat_angle = -999;
+}
+
+void ncrystal_samplescatter_unchecked( ncrystal_fastctx_t fc,
+                                       double ekin,
+                                       const double (*direction)[3],
+                                       double* ekin_final,
+                                       double (*direction_final)[3] )
+{
+  try {
+    auto& bc = ncc::extractUnchecked( fc );
+    nc_assert( bc.rng != nullptr );
+    auto outcome = bc.proc->sampleScatter( bc.cache, *bc.rng, NC::NeutronEnergy{ekin},
+                                           NC::NeutronDirection{*direction} );
+    *ekin_final = outcome.ekin.dbl();
+    outcome.direction.applyTo(*direction_final);
+    return;
+  } NCCATCH;
+  *ekin_final = -1.0;
+  (*direction_final)[0] = (*direction_final)[1] = (*direction_final)[2] = 0.0;
+}
+
+void ncrystal_samplescatter_soa( ncrystal_scatter_t o,
+                                 ncrystal_batchctx_t ctx,
+                                 unsigned long n,
+                                 double * ekin,
+                                 double * dirx,
+                                 double * diry,
+                                 double * dirz )
+{
+  try {
+    auto& sc = ncc::extract(o);
+    auto& bc = ncc::extractBatchCtx( ctx, sc, true );
+    bc.proc->sampleScatterMany( bc.cache, *bc.rng, ekin, dirx, diry, dirz, n );
+    return;
+  } NCCATCH;
+  //non-halting-error, invalidate all output:
+  for ( unsigned long i = 0; i < n; ++i ) {
+    ekin[i] = -1.0;
+    dirx[i] = diry[i] = dirz[i] = 0.0;
+  }
+}
+
+void ncrystal_samplescatterisotropic_soa( ncrystal_scatter_t o,
+                                          ncrystal_batchctx_t ctx,
+                                          unsigned long n,
+                                          double * ekin,
+                                          double * results_cos_scat_angle )
+{
+  try {
+    auto& sc = ncc::extract(o);
+    auto& bc = ncc::extractBatchCtx( ctx, sc, true );
+    bc.proc->sampleScatterIsotropicMany( bc.cache, *bc.rng, ekin, n, results_cos_scat_angle );
+    return;
+  } NCCATCH;
+  //non-halting-error, invalidate all output:
+  for ( unsigned long i = 0; i < n; ++i ) {
+    ekin[i] = -1.0;
+    results_cos_scat_angle[i] = -999.0;
+  }
+}
+
+void ncrystal_crosssection_soa( ncrystal_process_t o,
+                                ncrystal_batchctx_t ctx,
+                                unsigned long n,
+                                const double * ekin,
+                                const double * dirx,
+                                const double * diry,
+                                const double * dirz,
+                                double * results )
+{
+  try {
+    auto& bc = ncc::extractBatchCtx( ctx, ncc::extractProcess(o), false );
+    bc.proc->evalManyXS( bc.cache, ekin, dirx, diry, dirz, n, results );
+    return;
+  } NCCATCH;
+  std::fill( results, results + n, -1.0 );
+}
+
+void ncrystal_crosssection_nonoriented_soa( ncrystal_process_t o,
+                                            ncrystal_batchctx_t ctx,
+                                            unsigned long n,
+                                            const double * ekin,
+                                            double * results )
+{
+  try {
+    auto& bc = ncc::extractBatchCtx( ctx, ncc::extractProcess(o), false );
+    bc.proc->evalManyXSIsotropic( bc.cache, ekin, n, results );
+    return;
+  } NCCATCH;
+  std::fill( results, results + n, -1.0 );
+}
+
+void ncrystal_export_flattables( ncrystal_scatter_t o,
+                                 double ekin_min,
+                                 double ekin_max,
+                                 unsigned n_ekin,
+                                 unsigned n_samples,
+                                 double * results_ekin,
+                                 double * results_xs,
+                                 double * results_sampled_dekin,
+                                 double * results_sampled_mu )
+{
+  try {
+    auto& sc = ncc::extract(o);
+    if ( sc.isOriented() )
+      NCRYSTAL_THROW(BadInput,"ncrystal_export_flattables: only supported for non-oriented processes.");
+    if ( !( ekin_min > 0.0 && ekin_min < ekin_max && std::isfinite(ekin_max) ) || n_ekin < 2 || n_samples < 1 )
+      NCRYSTAL_THROW(BadInput,"ncrystal_export_flattables: invalid parameters.");
+    const NC::VectD egrid = NC::logspace( std::log10(ekin_min), std::log10(ekin_max), n_ekin );
+    std::copy( egrid.begin(), egrid.end(), results_ekin );
+    for ( unsigned i = 0; i < n_ekin; ++i ) {
+      results_xs[i] = sc.crossSectionIsotropic( NC::NeutronEnergy{egrid[i]} ).get();
+      double * dekin = results_sampled_dekin + std::size_t(i) * n_samples;
+      double * mu = results_sampled_mu + std::size_t(i) * n_samples;
+      std::fill( dekin, dekin + n_samples, egrid[i] );
+      sc.sampleScatterIsotropicMany( dekin, n_samples, mu );
+      for ( unsigned j = 0; j < n_samples; ++j )
+        dekin[j] -= egrid[i];
+    }
+    return;
+  } NCCATCH;
+  //non-halting-error, invalidate all output:
+  std::fill( results_ekin, results_ekin + n_ekin, -1.0 );
+  std::fill( results_xs, results_xs + n_ekin, -1.0 );
+  std::fill( results_sampled_dekin, results_sampled_dekin + std::size_t(n_ekin) * n_samples, 0.0 );
+  std::fill( results_sampled_mu, results_sampled_mu + std::size_t(n_ekin) * n_samples, -999.0 );
+}
+
+void * ncrystal_export_flatblob( ncrystal_scatter_t o,
+                                 double ekin_min,
+                                 double ekin_max,
+                                 unsigned n_ekin,
+                                 unsigned n_samples,
+                                 unsigned long * result_nbytes )
+{
+  try {
+    auto& sc = ncc::extract(o);
+    NC::FlatBlobCfg cfg;
+    cfg.ekin_min = ekin_min;
+    cfg.ekin_max = ekin_max;
+    cfg.nekin = n_ekin;
+    cfg.nsamples = n_samples;
+    auto blob = NC::exportFlatBlob( sc.underlying(), sc.rng(), cfg );
+    std::uint64_t * res = new std::uint64_t[blob.size()];
+    std::copy( blob.begin(), blob.end(), res );
+    *result_nbytes = static_cast<unsigned long>( blob.size() * sizeof(std::uint64_t) );
+    return res;
+  } NCCATCH;
+  *result_nbytes = 0;
+  return nullptr;
+}
+
+void ncrystal_dealloc_flatblob( void * blob )
+{
+  delete[] static_cast<std::uint64_t*>(blob);
+}
+
 void ncrystal_genscatter_nonoriented( ncrystal_scatter_t o, double ekin, double* result_angle, double* result_dekin )
 {
   //obsolete fct:
@@ -1089,16 +1839,90 @@ void ncrystal_multicreate_direct( const char* data,
     auto cfg = NC::MatCfg::createFromRawData( std::string(data),
                                               std::string(cfg_params?cfg_params:""),
                                               std::string(dataType?dataType:"") );
+    //Create all objects in one pass, sharing a single Info object:
+    auto objs = NC::FactImpl::createMulti( cfg, h_i!=nullptr, h_s!=nullptr, h_a!=nullptr );
     if ( h_i )
-      *h_i = ncc::createNewCHandle<ncc::Wrapped_Info>( NC::createInfo(cfg) );
-    if ( h_s )
-      *h_s = ncc::createNewCHandle<ncc::Wrapped_Scatter>( NC::createScatter(cfg) );
+      *h_i = ncc::createNewCHandle<ncc::Wrapped_Info>( NC::shared_obj<const NC::Info>( std::move(objs.info) ) );
+    if ( h_s ) {
+      auto rngproducer = NC::getDefaultRNGProducer();
+      auto rng = rngproducer->produce();
+      *h_s = ncc::createNewCHandle<ncc::Wrapped_Scatter>( NC::Scatter( std::move(rngproducer),
+                                                                       std::move(rng),
+                                                                       std::move(objs.scatter) ) );
+    }
     if ( h_a )
-      *h_a = ncc::createNewCHandle<ncc::Wrapped_Absorption>( NC::createAbsorption(cfg) );
+      *h_a = ncc::createNewCHandle<ncc::Wrapped_Absorption>( NC::Absorption( std::move(objs.absorption) ) );
   } NCCATCH;
 
 }
 
+ncrystal_pending_t ncrystal_create_info_async( const char * cfgstr )
+{
+  try {
+    ncc::PendingResult pr;
+    pr.info = NC::FactImpl::createInfoAsync( NC::MatCfg(cfgstr) );
+    return ncc::createNewCHandle<ncc::Wrapped_Pending>( std::move(pr) );
+  } NCCATCH;
+  return {nullptr};
+}
+
+ncrystal_pending_t ncrystal_create_scatter_async( const char * cfgstr )
+{
+  try {
+    ncc::PendingResult pr;
+    pr.scatter = NC::FactImpl::createScatterAsync( NC::MatCfg(cfgstr) );
+    return ncc::createNewCHandle<ncc::Wrapped_Pending>( std::move(pr) );
+  } NCCATCH;
+  return {nullptr};
+}
+
+ncrystal_pending_t ncrystal_create_absorption_async( const char * cfgstr )
+{
+  try {
+    ncc::PendingResult pr;
+    pr.absorption = NC::FactImpl::createAbsorptionAsync( NC::MatCfg(cfgstr) );
+    return ncc::createNewCHandle<ncc::Wrapped_Pending>( std::move(pr) );
+  } NCCATCH;
+  return {nullptr};
+}
+
+ncrystal_info_t ncrystal_wait_info( ncrystal_pending_t ph )
+{
+  try {
+    auto& pr = ncc::extract(ph);
+    if ( !pr.info.valid() )
+      NCRYSTAL_THROW(BadInput,"ncrystal_wait_info: handle was not created by ncrystal_create_info_async.");
+    return ncc::createNewCHandle<ncc::Wrapped_Info>( pr.info.get() );
+  } NCCATCH;
+  return {nullptr};
+}
+
+ncrystal_scatter_t ncrystal_wait_scatter( ncrystal_pending_t ph )
+{
+  try {
+    auto& pr = ncc::extract(ph);
+    if ( !pr.scatter.valid() )
+      NCRYSTAL_THROW(BadInput,"ncrystal_wait_scatter: handle was not created by ncrystal_create_scatter_async.");
+    auto rngproducer = NC::getDefaultRNGProducer();
+    auto rng = rngproducer->produce();
+    return ncc::createNewCHandle<ncc::Wrapped_Scatter>( NC::Scatter( std::move(rngproducer),
+                                                                     std::move(rng),
+                                                                     pr.scatter.get() ) );
+  } NCCATCH;
+  return {nullptr};
+}
+
+ncrystal_absorption_t ncrystal_wait_absorption( ncrystal_pending_t ph )
+{
+  try {
+    auto& pr = ncc::extract(ph);
+    if ( !pr.absorption.valid() )
+      NCRYSTAL_THROW(BadInput,"ncrystal_wait_absorption: handle was not created by ncrystal_create_absorption_async.");
+    return ncc::createNewCHandle<ncc::Wrapped_Absorption>( NC::Absorption( pr.absorption.get() ) );
+  } NCCATCH;
+  return {nullptr};
+}
+
 ncrystal_info_t ncrystal_create_info( const char * cfgstr )
 {
   try {
@@ -1195,6 +2019,82 @@ void ncrystal_clear_caches()
   } NCCATCH;
 }
 
+void ncrystal_setnthreads( unsigned n )
+{
+  try {
+    NC::setNThreads( n );
+  } NCCATCH;
+}
+
+void ncrystal_save_snapshot( const char * path, unsigned ncfgstrs, const char ** cfgstrs )
+{
+  try {
+    NC::VectS cfgs;
+    cfgs.reserve( ncfgstrs );
+    for ( unsigned i = 0; i < ncfgstrs; ++i )
+      cfgs.emplace_back( cfgstrs[i] );
+    NC::FactImpl::saveSnapshot( path, cfgs );
+  } NCCATCH;
+}
+
+void ncrystal_save_snapshot_mt( const char * path, unsigned ncfgstrs,
+                                const char ** cfgstrs, unsigned nthreads )
+{
+  try {
+    NC::VectS cfgs;
+    cfgs.reserve( ncfgstrs );
+    for ( unsigned i = 0; i < ncfgstrs; ++i )
+      cfgs.emplace_back( cfgstrs[i] );
+    NC::FactImpl::saveSnapshot( path, cfgs, nthreads );
+  } NCCATCH;
+}
+
+void ncrystal_load_snapshot( const char * path )
+{
+  try {
+    NC::FactImpl::loadSnapshot( path );
+  } NCCATCH;
+}
+
+char* ncrystal_save_snapshot_to_memory( unsigned ncfgstrs, const char ** cfgstrs,
+                                        unsigned nthreads, unsigned long* size )
+{
+  try {
+    NC::VectS cfgs;
+    cfgs.reserve( ncfgstrs );
+    for ( unsigned i = 0; i < ncfgstrs; ++i )
+      cfgs.emplace_back( cfgstrs[i] );
+    std::string data = NC::FactImpl::saveSnapshotToMemory( cfgs, nthreads );
+    nc_assert_always( data.size() < std::numeric_limits<unsigned long>::max() );
+    char * out = new char[data.size()+1];
+    std::memcpy( out, data.data(), data.size() );
+    out[data.size()] = '\0';
+    *size = static_cast<unsigned long>( data.size() );
+    return out;
+  } NCCATCH;
+  *size = 0;
+  return nullptr;
+}
+
+void ncrystal_load_snapshot_from_memory( const char * data, unsigned long size )
+{
+  try {
+    //Snapshot data must be suitably aligned and remain valid for the rest of
+    //the process lifetime, so we keep an (intentionally leaked) copy:
+    auto buf = static_cast<unsigned char*>( NC::alignedAlloc( 64, size ? size : 1 ) );
+    std::memcpy( buf, data, size );
+    NC::FactImpl::loadSnapshotFromMemory( buf, size );
+  } NCCATCH;
+}
+
+void ncrystal_ncmat2binary( const char * datasrc, const char * outpath )
+{
+  try {
+    auto td = NC::FactImpl::createTextData( datasrc );
+    NC::writeNCMATBinaryFile( *td, outpath );
+  } NCCATCH;
+}
+
 void ncrystal_clear_info_caches()
 {
   //deprecated, now simply redirects to ncrystal_clear_caches.
@@ -1215,6 +2115,13 @@ void ncrystal_enable_caching()
   } NCCATCH;
 }
 
+void ncrystal_enable_textdata_dedup( int enable )
+{
+  try {
+    NC::FactImpl::setTextDataDeduplicationEnabled( enable != 0 );
+  } NCCATCH;
+}
+
 int ncrystal_has_factory( const char* name )
 {
   try {
@@ -1300,6 +2207,37 @@ void ncrystal_info_getatompos( ncrystal_info_t ci,
   *x = *y = *z = -999.0;
 }
 
+void ncrystal_info_getatominfo_all( ncrystal_info_t ci,
+                                    unsigned* atomdataindex,
+                                    unsigned* number_per_unit_cell,
+                                    double* debye_temp, double* msd )
+{
+  try {
+    auto& info = ncc::extract(ci);
+    std::size_t i = 0;
+    for ( auto it = info->atomInfoBegin(); it != info->atomInfoEnd(); ++it, ++i ) {
+      atomdataindex[i] = it->atom().index.get();
+      number_per_unit_cell[i] = it->numberPerUnitCell();
+      debye_temp[i] = ( it->debyeTemp().has_value() ? it->debyeTemp().value().dbl() : 0.0 );
+      msd[i] = it->msd().value_or(0.0);
+    }
+  } NCCATCH;
+}
+
+void ncrystal_info_getatompos_all( ncrystal_info_t ci, double* xyz )
+{
+  try {
+    auto& info = ncc::extract(ci);
+    for ( auto it = info->atomInfoBegin(); it != info->atomInfoEnd(); ++it ) {
+      for ( auto& pos : it->unitCellPositions() ) {
+        *xyz++ = pos[0];
+        *xyz++ = pos[1];
+        *xyz++ = pos[2];
+      }
+    }
+  } NCCATCH;
+}
+
 
 
 unsigned ncrystal_info_ncustomsections( ncrystal_info_t ci )
@@ -1537,6 +2475,32 @@ void ncrystal_dealloc_stringlist( unsigned length, char** sl )
   }
 }
 
+void ncrystal_info_getcustomsections_all( ncrystal_info_t ci, unsigned* nstrs, char*** strs )
+{
+  try {
+    NC::VectS strlist;
+    for ( auto& sec : ncc::extract(ci)->getAllCustomSections() ) {
+      std::string content;
+      for ( auto& line : sec.second ) {
+        bool first = true;
+        for ( auto& part : line ) {
+          if ( !first )
+            content += ' ';
+          content += part;
+          first = false;
+        }
+        content += '\n';
+      }
+      strlist.push_back( sec.first );
+      strlist.push_back( std::move(content) );
+    }
+    ncc::createStringList(strlist,strs,nstrs);
+    return;
+  } NCCATCH;
+  *nstrs = 0;
+  *strs = nullptr;
+}
+
 void ncrystal_dealloc_string( char* ss )
 {
   if (ss)
@@ -1553,6 +2517,16 @@ void ncrystal_setrandgen( double (*rg)() )
   } NCCATCH;
 }
 
+void ncrystal_setrandgen_bulk( void (*rg)(double*,unsigned) )
+{
+  try {
+    if (rg)
+      NC::setDefaultRNGBulkFctForAllThreads(rg);
+    else
+      NC::clearDefaultRNG();
+  } NCCATCH;
+}
+
 void ncrystal_setbuiltinrandgen()
 {
   try {
@@ -1688,6 +2662,56 @@ void ncrystal_get_plugin_list( unsigned* nstrs,
   } NCCATCH;
 }
 
+void ncrystal_get_cache_stats( unsigned* nstrs,
+                               char*** strs )
+{
+  try {
+    auto allstats = NC::getAllFactoryCacheStats();
+    NC::VectS strlist;
+    strlist.reserve( 8 * allstats.size() );
+    for ( auto& s : allstats ) {
+      strlist.emplace_back(s.name);
+      strlist.emplace_back(std::to_string(s.nstrongrefs));
+      strlist.emplace_back(std::to_string(s.nentries));
+      strlist.emplace_back(std::to_string(s.nbytes));
+      strlist.emplace_back(std::to_string(s.ninflight));
+      strlist.emplace_back(std::to_string(s.nhits));
+      strlist.emplace_back(std::to_string(s.nmisses));
+      std::ostringstream ss;
+      ss << s.constructionTime;
+      strlist.emplace_back(ss.str());
+    }
+    ncc::createStringList(strlist,strs,nstrs);
+  } NCCATCH;
+}
+
+int ncrystal_counters_enabled()
+{
+  return NC::Counters::enabled() ? 1 : 0;
+}
+
+void ncrystal_get_counters( unsigned* nstrs,
+                            char*** strs )
+{
+  try {
+    auto counters = NC::Counters::getAll();
+    NC::VectS strlist;
+    strlist.reserve( 2 * counters.size() );
+    for ( auto& c : counters ) {
+      strlist.emplace_back(c.first);
+      strlist.emplace_back(std::to_string(c.second));
+    }
+    ncc::createStringList(strlist,strs,nstrs);
+  } NCCATCH;
+}
+
+void ncrystal_reset_counters()
+{
+  try {
+    NC::Counters::resetAll();
+  } NCCATCH;
+}
+
 char* ncrystal_get_file_contents( const char * name )
 {
   try {
@@ -136,10 +136,15 @@ namespace NCrystal {
   {
     if (!uc->hklList)
       return;
-    nxs::NXS_HKL *it = &(uc->hklList[0]);
-    nxs::NXS_HKL *itE = it + uc->nHKL;
-    for (;it!=itE;++it)
-      free(it->equivHKL);
+    if ( uc->equivHKLBuffer ) {
+      free(uc->equivHKLBuffer);
+      uc->equivHKLBuffer = 0;
+    } else {
+      nxs::NXS_HKL *it = &(uc->hklList[0]);
+      nxs::NXS_HKL *itE = it + uc->nHKL;
+      for (;it!=itE;++it)
+        free(it->equivHKL);
+    }
     free(uc->hklList);
     uc->hklList = 0;
     free(uc->sgInfo.ListSeitzMx);
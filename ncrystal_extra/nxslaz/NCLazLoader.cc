@@ -23,6 +23,7 @@
 #include "NCrystal/internal/NCString.hh"
 #include "NCrystal/internal/NCMath.hh"
 #include "NCrystal/internal/NCLatticeUtils.hh"
+#include "NCrystal/internal/NCThreadUtils.hh"
 #include <sstream>
 #include <fstream>
 #include <cstring>
@@ -38,6 +39,42 @@ namespace NC = NCrystal;
 namespace NCrystal {
   double str2dbl_laz(const std::string& s) { return str2dbl(s,"Invalid number in .laz/.lau data"); }
   double str2int_laz(const std::string& s) { return str2int(s,"Invalid integer in .laz/.lau data"); }
+
+  namespace {
+    class LazDataLineParser {
+      //Access to columns of a data line, without copying the entire line.
+    public:
+      void setLine( const char * b, const char * e )
+      {
+        m_cols.clear();
+        while ( true ) {
+          while ( b != e && isWhiteSpace(*b) )
+            ++b;
+          if ( b == e )
+            break;
+          const char * colb = b;
+          while ( b != e && !isWhiteSpace(*b) )
+            ++b;
+          m_cols.emplace_back( colb, b );
+        }
+      }
+      double getDbl( unsigned col_index ) { return str2dbl_laz( column(col_index) ); }
+      double getInt( unsigned col_index ) { return str2int_laz( column(col_index) ); }
+    private:
+      static bool isWhiteSpace( char c ) { return c==' ' || c=='\t' || c=='\r' || c=='\n'; }
+      const std::string& column( unsigned col_index )
+      {
+        //NB: col_index is 1-based as in the file headers
+        if ( col_index == 0 || col_index > m_cols.size() )
+          NCRYSTAL_THROW2(DataLoadError,"Missing column "<<col_index<<" in .laz/.lau data line");
+        const auto& c = m_cols[col_index-1];
+        m_buf.assign( c.first, c.second );
+        return m_buf;
+      }
+      std::vector<std::pair<const char*,const char*>> m_cols;
+      std::string m_buf;
+    };
+  }
 }
 
 bool NC::LazLoader::setupSgInfo(unsigned spaceGroupNbr, nxs::T_SgInfo& sgInfo) {
@@ -87,23 +124,26 @@ NC::LazLoader::LazLoader(const TextData& data,double dcutlow, double dcutup, Tem
     m_temp(temp)
 {
   nc_assert_always( dcutlow==-1 || ( dcutlow>=0 && dcutlow < dcutup ) );
-  preParse(data);//copies all data - pretty obsolete but I don't feel like
-                 //rewriting the Laz loader without some sort of reason...
+  preParse(data);
 }
 
 void NC::LazLoader::preParse(const TextData& data)
 {
-  //copy ascii raw data into memory as a vector of strings
-  for ( const auto& line : data )    {
-    if (line.empty())
-      continue;
-    auto parts = split2( line );
-    if ( parts.empty() )
+  //Split header lines into words, but only keep track of the location of
+  //the (potentially many) data lines in the TextData buffer, which remains
+  //valid since the TextData object outlives this loader:
+  auto itE = data.end();
+  for ( auto it = data.begin(); it != itE; ++it ) {
+    const std::string& line = *it;
+    auto ifirst = line.find_first_not_of(" \t\r\n");
+    if ( ifirst == std::string::npos )
       continue;
-    if (parts.front().at(0)=='#')
-      m_raw_header.push_back(std::move(parts));
-    else
-      m_raw_data.push_back(std::move(parts));
+    if ( line[ifirst]=='#' ) {
+      m_raw_header.push_back(split2( line ));
+    } else {
+      const char * b = it.rawLineBegin();
+      m_data_lines.emplace_back( b, b + line.size() );
+    }
   }
 }
 
@@ -185,12 +225,9 @@ void NC::LazLoader::read()
   if(!search_index("column_l", l_index) )
     NCRYSTAL_THROW2(DataLoadError,"The index for l in the table is not defined in the input data \""<<m_inputDescription<<"\"");
 
-  if (m_raw_data.empty())
+  if (m_data_lines.empty())
     NCRYSTAL_THROW2(DataLoadError,"No data lines found in input data \""<<m_inputDescription<<"\"");
 
-  // double lower_d = str2dbl_laz(m_raw_data.back().at(d_index-1));
-  // double upper_d = str2dbl_laz(m_raw_data.begin()->at(d_index-1));
-
   checkAndCompleteLattice( structure_info.spacegroup, structure_info.lattice_a, structure_info.lattice_b, structure_info.lattice_c );
 
   const bool enable_hkl(m_dcutlow!=-1);
@@ -201,23 +238,49 @@ void NC::LazLoader::read()
     double cache_d =-1.;
     double cache_f =-1.;
 
-    for (RawItr it = m_raw_data.begin() ; it != m_raw_data.end(); ++it)
+    //Parse the data lines in independent blocks (potentially in parallel, see
+    //NCThreadUtils.hh), but process the results below in the original order:
+    struct ParsedLine {
+      bool inRange;
+      HKLInfo info;
+    };
+    const std::size_t nlines = m_data_lines.size();
+    std::vector<ParsedLine> parsed( nlines );
+    const std::size_t blocksize = 4096;
+    const std::size_t nblocks = ( nlines + blocksize - 1 ) / blocksize;
+    const double dcutlow(m_dcutlow), dcutup(m_dcutup);
+    parallelFor( nblocks, getNThreadsFromEnv(),
+                 [&]( std::size_t iblock )
+                 {
+                   LazDataLineParser lp;
+                   const std::size_t iE = std::min( nlines, ( iblock + 1 ) * blocksize );
+                   for ( std::size_t i = iblock * blocksize; i < iE; ++i ) {
+                     lp.setLine( m_data_lines[i].first, m_data_lines[i].second );
+                     auto& pl = parsed[i];
+                     HKLInfo& info = pl.info;
+                     info.dspacing = lp.getDbl(d_index);
+                     pl.inRange = !(info.dspacing<dcutlow||info.dspacing>dcutup);
+                     if (!pl.inRange)
+                       continue;
+                     info.h = lp.getInt(h_index);
+                     info.k = lp.getInt(k_index);
+                     info.l = lp.getInt(l_index);
+                     info.multiplicity = lp.getInt(mul_index);
+                     if(f_index) {
+                       info.fsquared = pow(lp.getDbl(f_index),2) ;
+                     } else {
+                       info.fsquared = lp.getDbl(f2_index) * 0.01;//0.01 is fm^2/barn
+                     }
+                   }
+                 } );
+
+    for ( auto& pl : parsed )
       {
-        double dspacing(str2dbl_laz((*it).at(d_index-1)));
-        if (dspacing<m_dcutlow||dspacing>m_dcutup)
+        if (!pl.inRange)
           continue;
+        HKLInfo& info = pl.info;
+        const double dspacing = info.dspacing;
         if (!dlow||dspacing<dlow) dlow = dspacing;
-        HKLInfo info;
-        info.h = str2int_laz((*it).at(h_index-1));
-        info.k = str2int_laz((*it).at(k_index-1));
-        info.l = str2int_laz((*it).at(l_index-1));
-        info.dspacing = dspacing;
-        info.multiplicity = str2int_laz((*it).at(mul_index-1));
-        if(f_index) {
-          info.fsquared = pow(str2dbl_laz((*it).at(f_index-1)),2) ;
-        } else {
-          info.fsquared = str2dbl_laz((*it).at(f2_index-1)) * 0.01;//0.01 is fm^2/barn
-        }
 
         if(info.fsquared < 1e-20)//NB: Hardcoded to lower value as in
                                  //.nxs/.ncmat factory, since it was actually
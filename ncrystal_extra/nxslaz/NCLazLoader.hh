@@ -38,7 +38,9 @@ namespace NCrystal {
     void preParse(const TextData&);
     std::string m_inputDescription;
     std::vector<VectS> m_raw_header;
-    std::vector<VectS> m_raw_data;
+    //Data lines are not copied, but refer directly to the TextData buffer:
+    using LineSpan = std::pair<const char*,const char*>;
+    std::vector<LineSpan> m_data_lines;
 
 
     shared_obj<Info> m_cinfo;
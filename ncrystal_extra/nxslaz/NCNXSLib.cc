@@ -46,6 +46,9 @@
 
 #define SGCLIB_C__
 #include "NCNXSLib.hh"
+#include "NCrystal/internal/NCThreadUtils.hh"
+#include <unordered_map>
+#include <vector>
 
 #include <math.h>
 #include <stdlib.h>
@@ -859,6 +862,36 @@ int nxs_initHKL( NXS_UnitCell *uc, int fix_incoh_xs )
   //   for (h=minH; h<=max_hkl; h++)
   //   for (k=minK; k<=max_hkl; k++)
   //   for (l=minL; l<=max_hkl; l++)
+  /* The search for previously found equivalent planes was modified by NCrystal */
+  /* developers. Rather than testing against all previous planes with          */
+  /* AreSymEquivalent_hkl (quadratic in the number of planes), a hash map is    */
+  /* looked up with a canonical key of each plane, namely the smallest of the   */
+  /* (packed) indices of the same planes reached by AreSymEquivalent_hkl:      */
+  std::unordered_map<long long,unsigned int> canonical2idx;
+  canonical2idx.reserve( index_count );
+  auto canonicalKey = [&SgInfo]( int hh, int kk, int ll )
+  {
+    auto pack = []( int a, int b, int c )
+    {
+      return ( ( (long long)a + 0x100000 ) << 42 ) | ( ( (long long)b + 0x100000 ) << 21 ) | ( (long long)c + 0x100000 );
+    };
+    long long key = 0;
+    bool first = true;
+    const T_RTMx *lsmx = SgInfo.ListSeitzMx;
+    for( int iList = 0; iList < SgInfo.nList; iList++, lsmx++ )
+    {
+      int hm = lsmx->s.R[0] * hh + lsmx->s.R[3] * kk + lsmx->s.R[6] * ll;
+      int km = lsmx->s.R[1] * hh + lsmx->s.R[4] * kk + lsmx->s.R[7] * ll;
+      int lm = lsmx->s.R[2] * hh + lsmx->s.R[5] * kk + lsmx->s.R[8] * ll;
+      long long k1 = pack( hm, km, lm );
+      long long k2 = pack( -hm, -km, -lm );
+      long long kmin = ( k1 < k2 ? k1 : k2 );
+      if ( first || kmin < key )
+        key = kmin;
+      first = false;
+    }
+    return key;
+  };
   for( h=max_hkl; h>=minH; h-- )
   for( k=max_hkl; k>=minK; k-- )
   for( l=max_hkl; l>=minL; l-- )
@@ -866,36 +899,30 @@ int nxs_initHKL( NXS_UnitCell *uc, int fix_incoh_xs )
     /* do not show hkls that are systematic absent for the space group */
     if( !IsSysAbsent_hkl( &SgInfo, h, k, l, &restriction ) )
     {
-      char is_exclusive;
       /* exclude (hkl)=(000) */
       if( h==0 && k==0 && l==0 )
         continue;
 
-      hkl[i].h = h;
-      hkl[i].k = k;
-      hkl[i].l = l;
-
       /* check if equivalent plane has been found before (and calculated) */
-      is_exclusive = 1;
-      for( j=0; j<i; j++ )
+      auto ins = canonical2idx.emplace( canonicalKey( h, k, l ), i );
+      if ( ins.second )
+      {
+        hkl[i].h = h;
+        hkl[i].k = k;
+        hkl[i].l = l;
+        i++;
+      }
+      else
       {
-        if( AreSymEquivalent_hkl(&SgInfo, h, k, l, hkl[j].h, hkl[j].k, hkl[j].l) )
+        j = ins.first->second;
+        /* sort hkl indices */
+        if( 1E6*h+1E3*k+l > 1E6*hkl[j].h+1E3*hkl[j].k+hkl[j].l )
         {
-          is_exclusive = 0;
-          /* sort hkl indices */
-          if( 1E6*h+1E3*k+l > 1E6*hkl[j].h+1E3*hkl[j].k+hkl[j].l )
-          {
-            hkl[j].h = h;
-            hkl[j].k = k;
-            hkl[j].l = l;
-          }
+          hkl[j].h = h;
+          hkl[j].k = k;
+          hkl[j].l = l;
         }
-        if( !is_exclusive )
-          continue;
       }
-
-      if( is_exclusive )
-        i++;
     }
   }
   /* reduce the allocated memory */
@@ -912,32 +939,36 @@ int nxs_initHKL( NXS_UnitCell *uc, int fix_incoh_xs )
   }
   hkl = realloc_hkl;
 
-  for( i=0; i<uc->nHKL; i++ )
+  /* The following loop was modified by NCrystal developers: Rather than a    */
+  /* separate malloc per plane, all equivalent planes are stored in a single  */
+  /* buffer (each plane using a fixed slice of the maximal size of 24), and   */
+  /* the independent planes are processed in parallel (see NCThreadUtils.hh) */
+  NXS_EquivHKL *equivBuffer = (NXS_EquivHKL*)malloc( sizeof(NXS_EquivHKL)*24*(uc->nHKL?uc->nHKL:1) );
+  if( !equivBuffer )
+    return free(hkl),NXS_ERROR_MEMORYALLOCATIONFAILED;
+  const T_SgInfo *pSgInfo = &SgInfo;
+  parallelFor( uc->nHKL, getNThreadsFromEnv(),
+               [hkl,equivBuffer,pSgInfo,uc]( std::size_t ii )
   {
     /* store the equivalent lattice plane (hkl) */
     T_Eq_hkl eqHKL;
-    NXS_EquivHKL *equivHKL;
-    unsigned int nEqHKL;
-
-    hkl[i].multiplicity = BuildEq_hkl( &SgInfo, &eqHKL, hkl[i].h, hkl[i].k, hkl[i].l );
-    equivHKL = (NXS_EquivHKL*)malloc( sizeof(NXS_EquivHKL)*eqHKL.N );
-    if( !equivHKL )
-      return free(hkl),NXS_ERROR_MEMORYALLOCATIONFAILED;/* "free(hkl)," added by NCrystal developers to fix potential leak detected by static code analysis */
+    NXS_EquivHKL *equivHKL = equivBuffer + 24*ii;
+    int jj;
 
-
-    nEqHKL = eqHKL.N;
-    for( j=0; j<nEqHKL; j++ )
+    hkl[ii].multiplicity = BuildEq_hkl( pSgInfo, &eqHKL, hkl[ii].h, hkl[ii].k, hkl[ii].l );
+    for( jj=0; jj<eqHKL.N; jj++ )
     {
-      equivHKL[j].h = eqHKL.h[j];
-      equivHKL[j].k = eqHKL.k[j];
-      equivHKL[j].l = eqHKL.l[j];
+      equivHKL[jj].h = eqHKL.h[jj];
+      equivHKL[jj].k = eqHKL.k[jj];
+      equivHKL[jj].l = eqHKL.l[jj];
     }
-    hkl[i].equivHKL = equivHKL;
+    hkl[ii].equivHKL = equivHKL;
 
     /* get d-spacing and |F|^2 */
-    hkl[i].dhkl = nxs_calcDhkl( hkl[i].h, hkl[i].k, hkl[i].l, uc );
-    hkl[i].FSquare = nxs_calcFSquare( &(hkl[i]), uc );
-  }
+    hkl[ii].dhkl = nxs_calcDhkl( hkl[ii].h, hkl[ii].k, hkl[ii].l, uc );
+    hkl[ii].FSquare = nxs_calcFSquare( &(hkl[ii]), uc );
+  } );
+  uc->equivHKLBuffer = equivBuffer;
   /* end of initalizing */
 
   /* sort hkl lattice planes by d_hkl */
@@ -2039,6 +2039,9 @@ typedef struct NXS_UnitCell {
   unsigned int nHKL;                     /*!< number of hkl reflections after initUnitCell() */
   unsigned int maxHKL_index;             /*!< maximum hkl index */
   NXS_HKL *hklList;                      /*!< \see NXS_HKL */
+  /* Next field added by NCrystal developers. If not null, the equivHKL arrays */
+  /* of all entries in hklList are slices of this single allocation:           */
+  NXS_EquivHKL *equivHKLBuffer;
   unsigned char __flag_mph_c2;           /*!< flag to indicate if mph_c2 is set or should be calculated */
 } NXS_UnitCell;
 
@@ -34,6 +34,11 @@ namespace G4NCrystal {
   // NB: For this to work, your physics list must have installed exactly one  //
   //    active process derived from G4HadronElasticProcess for neutrons.      //
   //                                                                          //
+  // NB: Process managers are per thread in multi-threaded applications, so   //
+  //    the call must then be made in the master thread as well as in each    //
+  //    worker thread (e.g. from G4UserWorkerInitialization::WorkerRunStart). //
+  //    Repeated calls in the same thread do nothing.                         //
+  //                                                                          //
   //////////////////////////////////////////////////////////////////////////////
 
   void install();
@@ -43,6 +48,16 @@ namespace G4NCrystal {
 
   void installOnDemand();
 
+  //Optionally call after install() or installOnDemand(), to also let the
+  //NCrystal absorption physics (usually a simple 1/v cross section)
+  //associated to any NCrystal G4Materials take over neutron absorption below
+  //5eV. If the physics list has a neutron capture process, it is wrapped and
+  //still used in other materials and above 5eV. Otherwise a new process is
+  //added, so purely thermal simulations can use physics lists without any
+  //capture data. Absorbed neutrons are killed without producing secondaries:
+
+  void installAbsorption();
+
 }
 
 #endif
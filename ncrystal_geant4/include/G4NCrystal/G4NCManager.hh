@@ -23,12 +23,14 @@
 
 #include <map>
 #include <vector>
+#include <array>
+#include <atomic>
 #include "G4Material.hh"
-#include "G4Version.hh"
 #include "G4MaterialPropertiesTable.hh"
 #include "NCrystal/NCProcImpl.hh"
 //Manager class tracking indices of NCrystal::Scatter instances associated to
-//G4Materials, via entries in the G4MaterialPropertiesTable's on the materials.
+//G4Materials, via entries in the G4MaterialPropertiesTable's on the materials
+//(mirrored in a table indexed by G4Material::GetIndex() for fast access).
 
 class G4Material;
 namespace NCrystal {
@@ -51,10 +53,31 @@ namespace G4NCrystal {
     const NCrystal::ProcImpl::Process* getScatterProperty(G4Material*) const;//returns nullptr when absent.
     NCrystal::ProcImpl::OptionalProcPtr getScatterPropertyPtr(G4Material*) const;//returns nullptr when absent.
 
-    //Same but with per-thread per-scatter CachePtr:
+    //Same but with per-thread per-scatter CachePtr. If a cross section table
+    //was built for the scatter property (see buildXSTables), the returned
+    //process is the equivalent table-enabled process. Using the same process
+    //and cache for consecutive cross section and sampling calls at the same
+    //neutron state lets the sampling reuse the cached component cross
+    //sections:
     using ProcAndCache = std::pair<const NCrystal::ProcImpl::Process*,NCrystal::CachePtr*>;
     ProcAndCache getScatterPropertyWithThreadSafeCache(G4Material*) const;
 
+    //Absorption processes associated with G4Materials (used by the optional
+    //absorption process installed with installAbsorption() in G4NCInstall.hh).
+    //Unlike scatter properties these are not added to the property tables on
+    //the materials:
+    void addAbsorptionProperty(G4Material*, NCrystal::ProcImpl::ProcPtr&&);
+    const NCrystal::ProcImpl::Process* getAbsorptionProperty(G4Material*) const;//returns nullptr when absent.
+    ProcAndCache getAbsorptionPropertyWithThreadSafeCache(G4Material*) const;
+
+    //Precompute cross section tables for isotropic scatter properties, for
+    //fast cross section evaluations during tracking. Must be called from the
+    //master thread before the event loop (ProcWrapper::BuildPhysicsTable does
+    //this). The table precision can be changed (or the tables disabled by a
+    //value of 0) via the G4NCRYSTAL_XSTABPREC environment variable (default
+    //1e-3):
+    void buildXSTables();
+
     //Thoroughly clear caches, manager singleton, and possibly NCrystal
     //factories. It is NOT safe to use the Scatter properties of already created
     //G4Materials after this.
@@ -78,10 +101,29 @@ namespace G4NCrystal {
     static Manager * s_mgr;
     std::vector<NCrystal::ProcImpl::ProcPtr> m_scatters;
     std::map<uint64_t,unsigned> m_scat2idx;
+    //Scatter indices of G4Materials, indexed by G4Material::GetIndex() (updated
+    //in addScatterProperty, so the event loop avoids property table lookups):
+    std::vector<unsigned> m_matidx2scatidx;
+    std::vector<std::shared_ptr<const NCrystal::ProcImpl::ProcComposition>> m_xstables;//indexed like m_scatters
+    std::vector<NCrystal::ProcImpl::ProcPtr> m_absorptions;
+    std::map<uint64_t,unsigned> m_abs2idx;
+    std::vector<unsigned> m_matidx2absidx;//like m_matidx2scatidx
     G4String m_key;
-    NCrystal::CachePtr& getCachePtrForCurrentThreadAndProcess( unsigned scatter_idx ) const;
+    //Pool of per-worker cache sets (for the original and table-enabled scatter
+    //processes and for absorption processes, see CacheSlot), indexed by G4
+    //thread id rather than being thread-local, so
+    //they stay bound to G4 worker contexts when G4TaskRunManager executes
+    //work as tasks. Slots are created on first use and kept until the manager
+    //is deleted, so lookups require no locks:
+    enum CacheSlot { CacheSlot_Scatter = 0, CacheSlot_ScatterXSTable = 1, CacheSlot_Absorption = 2 };
+    using CacheSet = std::vector<std::array<NCrystal::CachePtr,3>>;
+    static constexpr unsigned s_nCachePoolSlots = 1026;//G4 thread ids -2..1023
+    mutable std::array<std::atomic<CacheSet*>,s_nCachePoolSlots> m_cachePool;
+    CacheSet& getCacheSetForCurrentWorker() const;
+    NCrystal::CachePtr& getCachePtrForCurrentThreadAndProcess( unsigned idx, CacheSlot ) const;
     //Returns numeric_limits<unsigned>::max() if not available:
     unsigned lookupScatterPropertyIndex(G4Material*) const;
+    unsigned lookupAbsorptionPropertyIndex(G4Material*) const;
 
   };
 
@@ -97,44 +139,41 @@ namespace G4NCrystal {
     if ( scatidx == std::numeric_limits<unsigned>::max() )
       return {nullptr,nullptr};
     assert(scatidx<m_scatters.size());
-    const NCrystal::ProcImpl::Process* sp = m_scatters[scatidx].get();
-    return { sp, &getCachePtrForCurrentThreadAndProcess( scatidx ) };
+    if ( scatidx < m_xstables.size() && m_xstables[scatidx] != nullptr )
+      return { m_xstables[scatidx].get(), &getCachePtrForCurrentThreadAndProcess( scatidx, CacheSlot_ScatterXSTable ) };
+    return { m_scatters[scatidx].get(), &getCachePtrForCurrentThreadAndProcess( scatidx, CacheSlot_Scatter ) };
+  }
+
+  inline std::pair<const NCrystal::ProcImpl::Process*, NCrystal::CachePtr*>
+  Manager::getAbsorptionPropertyWithThreadSafeCache(G4Material* mat) const
+  {
+    unsigned absidx = lookupAbsorptionPropertyIndex(mat);
+    if ( absidx == std::numeric_limits<unsigned>::max() )
+      return {nullptr,nullptr};
+    assert(absidx<m_absorptions.size());
+    return { m_absorptions[absidx].get(), &getCachePtrForCurrentThreadAndProcess( absidx, CacheSlot_Absorption ) };
   }
 
   inline unsigned Manager::lookupScatterPropertyIndex(G4Material*mat) const
   {
-    G4MaterialPropertiesTable* matprop = mat->GetMaterialPropertiesTable();
-    constexpr unsigned not_found = std::numeric_limits<unsigned>::max();
-    if (!matprop)
-      return not_found;
-#if G4VERSION_NUMBER < 1040
-    //Property maps pre-Geant4 10.4
-    using PropMap_T = std::map< G4String, G4double, std::less<G4String> > ;
-    const PropMap_T* propcmap = matprop->GetPropertiesCMap();
-    PropMap_T::size_type size = propcmap->size();
-    //Access property like this instead of via
-    //ConstPropertyExists+GetConstProperty, to avoid needless string allocations
-    //and double map lookup:
-    if (size<=1) {
-      //Optimise to quickly check in small maps, since we are likely the only
-      //user of constant material properties (this check can be removed if the
-      //situation changes drastically):
-      PropMap_T::const_iterator it;
-      return (size && (it=propcmap->begin())->first == m_key) ? static_cast<unsigned>(it->second) : not_found;
-    } else {
-      //Full map search:
-      PropMap_T::const_iterator it = propcmap->find(m_key);
-      return it==propcmap->end() ? not_found : static_cast<unsigned>(it->second);
-    }
-#else
-    //Property maps post Geant4 10.4. Here the internal keys are integers, but
-    //we can't be sure it is always the same in different materials. Unfortunately
-    //GetConstProperty triggers a G4 exception in case the key is not present,
-    //so for safety we have to trigger one extra map search via ConstPropertyExists:
-    if ( matprop->GetConstPropertyMap()->empty() || !matprop->ConstPropertyExists(m_key) )
-      return not_found;
-    return static_cast<unsigned>(matprop->GetConstProperty(m_key));
-#endif
+    //Direct lookup via the material index (materials created after the last
+    //call to addScatterProperty can not have a scatter property):
+    std::size_t matidx = mat->GetIndex();
+    return matidx < m_matidx2scatidx.size() ? m_matidx2scatidx[matidx] : std::numeric_limits<unsigned>::max();
+  }
+
+  inline unsigned Manager::lookupAbsorptionPropertyIndex(G4Material*mat) const
+  {
+    std::size_t matidx = mat->GetIndex();
+    return matidx < m_matidx2absidx.size() ? m_matidx2absidx[matidx] : std::numeric_limits<unsigned>::max();
+  }
+
+  inline const NCrystal::ProcImpl::Process* Manager::getAbsorptionProperty(G4Material*mat) const
+  {
+    unsigned absidx = lookupAbsorptionPropertyIndex(mat);
+    if ( absidx == std::numeric_limits<unsigned>::max() )
+      return nullptr;
+    return m_absorptions.at(absidx).get();
   }
 
   inline const NCrystal::ProcImpl::Process* Manager::getScatterProperty(G4Material*mat) const
@@ -23,6 +23,7 @@
 
 #include "NCrystal/NCMatCfg.hh"
 #include "G4Material.hh"
+#include <vector>
 
 namespace G4NCrystal {
 
@@ -38,6 +39,15 @@ namespace G4NCrystal {
   //Alternatively create, configure and pass in an NCrystal MatCfg object:
   NCRYSTAL_API G4Material * createMaterial( const MatCfg&  cfg );
 
+  //Optionally prepare the NCrystal physics for a list of configuration
+  //strings in parallel (using NCrystal's pool of background threads), which
+  //speeds up initialisation of geometries with several distinct
+  //materials. Subsequent createMaterial calls for these configurations will
+  //then only need to create the G4Material objects themselves (which must
+  //still happen in the thread constructing the geometry, as Geant4 materials
+  //are not thread-safe):
+  NCRYSTAL_API void prepareMaterials( const std::vector<std::string>& cfgstrs );
+
   //Set/disable debug output (off by default unless NCRYSTAL_DEBUG_G4MATERIALS
   //was set when the library was loaded):
   NCRYSTAL_API void enableCreateMaterialVerbosity(bool = true);
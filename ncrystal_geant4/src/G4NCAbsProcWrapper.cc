@@ -0,0 +1,111 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+//  This file is part of NCrystal (see https://mctools.github.io/ncrystal/)   //
+//                                                                            //
+//  Copyright 2015-2021 NCrystal developers                                   //
+//                                                                            //
+//  Licensed under the Apache License, Version 2.0 (the "License");           //
+//  you may not use this file except in compliance with the License.          //
+//  You may obtain a copy of the License at                                   //
+//                                                                            //
+//      http://www.apache.org/licenses/LICENSE-2.0                            //
+//                                                                            //
+//  Unless required by applicable law or agreed to in writing, software       //
+//  distributed under the License is distributed on an "AS IS" BASIS,         //
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  //
+//  See the License for the specific language governing permissions and       //
+//  limitations under the License.                                            //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include "G4NCAbsProcWrapper.hh"
+#include "G4NCrystal/G4NCManager.hh"
+
+#include "G4Step.hh"
+#include "G4Material.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4HadronicProcess.hh"
+#include "G4ParticleDefinition.hh"
+
+namespace NC = NCrystal;
+namespace NCG4 = G4NCrystal;
+
+NCG4::AbsProcWrapper::AbsProcWrapper(G4HadronicProcess * procToWrap,
+                                     const G4String& processName)
+: G4VDiscreteProcess(processName.empty()?(procToWrap?procToWrap->GetProcessName():G4String("ncrystal_abs")):processName),
+  m_wrappedProc(procToWrap), m_mgr(Manager::getInstance())
+{
+  if (verboseLevel>1)
+    G4cout << "G4NCrystal AbsProcWrapper named "<<GetProcessName() << " is created"<< G4endl;
+}
+
+NCG4::AbsProcWrapper::~AbsProcWrapper()
+{
+}
+
+G4VParticleChange* NCG4::AbsProcWrapper::PostStepDoIt(const G4Track& trk, const G4Step& step)
+{
+  assert(trk.GetParticleDefinition()->GetPDGEncoding()==2112);
+
+  const double ekin = trk.GetKineticEnergy();
+
+  //Important to always clear the interaction lengths here, even when we pass on
+  //the call to the wrapped process below (since G4 does not directly interact
+  //with the now disabled wrapped process):
+  ClearNumberOfInteractionLengthLeft();
+
+  if ( !(ekin>0.0)
+       || ekin > 5*CLHEP::eV
+       || m_mgr->getAbsorptionProperty( trk.GetMaterial() ) == nullptr ) {
+    if ( m_wrappedProc )
+      return m_wrappedProc->PostStepDoIt(trk,step);
+    //Should not really get here, since the mean free path was infinite:
+    m_particleChange.Initialize(trk);
+    return &m_particleChange;
+  }
+
+  m_particleChange.Initialize(trk);
+  m_particleChange.ProposeTrackStatus(fStopAndKill);
+  m_particleChange.ProposeEnergy(0.0);
+  m_particleChange.ProposeLocalEnergyDeposit(0.0);
+  return &m_particleChange;
+}
+
+G4double NCG4::AbsProcWrapper::GetMeanFreePath(const G4Track& trk, G4double p, G4ForceCondition* f)
+{
+  assert(trk.GetParticleDefinition()->GetPDGEncoding()==2112);
+  const double ekin = trk.GetKineticEnergy();
+
+  Manager::ProcAndCache procandcache;
+  if ( !(ekin>0.0)
+       || ekin > 5*CLHEP::eV
+       || ( procandcache = m_mgr->getAbsorptionPropertyWithThreadSafeCache( trk.GetMaterial() ) ).first == nullptr )
+    return m_wrappedProc ? m_wrappedProc->GetMeanFreePath(trk,p,f) : NC::kInfinity;
+
+  auto& ncabs = *procandcache.first;
+  assert(procandcache.second!=nullptr);
+  auto& cacheptr = *procandcache.second;
+
+  double xs(0.0);
+  try {
+    //Absorption processes are isotropic (typically simply a 1/v cross
+    //section), so the direction does not matter:
+    constexpr double inv_eV = 1.0/CLHEP::eV;
+    xs = ncabs.crossSectionIsotropic( cacheptr, NC::NeutronEnergy{ekin * inv_eV} ).get() * CLHEP::barn;
+  } catch ( NC::Error::Exception& e ) {
+    Manager::handleError("G4NCrystal::AbsProcWrapper::GetMeanFreePath",102,e);
+  }
+
+  return xs
+      ? 1.0 / ( trk.GetMaterial()->GetTotNbOfAtomsPerVolume() * xs )
+      : NC::kInfinity ;
+}
+
+void NCG4::AbsProcWrapper::BuildPhysicsTable(const G4ParticleDefinition&)
+{
+}
+
+G4bool NCG4::AbsProcWrapper::IsApplicable(const G4ParticleDefinition& pd)
+{
+  return pd.GetPDGEncoding()==2112;
+}
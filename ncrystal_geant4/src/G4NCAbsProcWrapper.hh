@@ -0,0 +1,61 @@
+#ifndef G4NCrystal_AbsProcWrapper_hh
+#define G4NCrystal_AbsProcWrapper_hh
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+//  This file is part of NCrystal (see https://mctools.github.io/ncrystal/)   //
+//                                                                            //
+//  Copyright 2015-2021 NCrystal developers                                   //
+//                                                                            //
+//  Licensed under the Apache License, Version 2.0 (the "License");           //
+//  you may not use this file except in compliance with the License.          //
+//  You may obtain a copy of the License at                                   //
+//                                                                            //
+//      http://www.apache.org/licenses/LICENSE-2.0                            //
+//                                                                            //
+//  Unless required by applicable law or agreed to in writing, software       //
+//  distributed under the License is distributed on an "AS IS" BASIS,         //
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  //
+//  See the License for the specific language governing permissions and       //
+//  limitations under the License.                                            //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include "G4VDiscreteProcess.hh"
+#include "G4ParticleChange.hh"
+
+class G4HadronicProcess;
+
+namespace G4NCrystal {
+
+  class Manager;
+
+  class AbsProcWrapper : public G4VDiscreteProcess
+  {
+    // Process used by G4NCInstall to supply NCrystal absorption physics for
+    // neutrons below 5eV in materials with NCrystal absorption properties. If
+    // the physics list already has a neutron capture process, it is wrapped and
+    // used for all other cases. Otherwise (e.g. in physics lists without
+    // capture data), neutrons are never absorbed in other cases. Absorbed
+    // neutrons are simply killed, without producing any secondaries.
+
+  public:
+    AbsProcWrapper(G4HadronicProcess * procToWrap,//might be nullptr
+                   const G4String& processName = "");
+    virtual ~AbsProcWrapper();
+
+    G4VParticleChange* PostStepDoIt(const G4Track&, const G4Step& ) final;
+    G4double GetMeanFreePath(const G4Track&, G4double, G4ForceCondition*) final;
+
+    void BuildPhysicsTable(const G4ParticleDefinition&) final;
+    G4bool IsApplicable(const G4ParticleDefinition& pd) final;
+
+  private:
+    G4ParticleChange m_particleChange;
+    G4HadronicProcess * m_wrappedProc;
+    Manager * m_mgr;
+  };
+
+}
+
+#endif
@@ -21,6 +21,7 @@
 #include "G4NCrystal/G4NCInstall.hh"
 #include "G4NCrystal/G4NCManager.hh"
 #include "G4NCProcWrapper.hh"
+#include "G4NCAbsProcWrapper.hh"
 
 #include "G4Material.hh"
 #include "G4ProcessManager.hh"
@@ -28,6 +29,7 @@
 #include "G4NistManager.hh"
 #include "G4SystemOfUnits.hh"
 #include "G4HadronElasticProcess.hh"
+#include "G4HadronicProcessType.hh"
 #include "G4RegionStore.hh"
 #include "G4Region.hh"
 #include "globals.hh"
@@ -39,7 +41,8 @@
 namespace G4NCrystal {
   class ProcWrapper;
 
-  static ProcWrapper * s_proc = 0;
+  //Per thread, since worker threads have their own process managers:
+  static G4ThreadLocal ProcWrapper * s_proc = 0;
   void doInstall(bool onDemand) {
     if (s_proc)
       return;
@@ -75,15 +78,10 @@ namespace G4NCrystal {
 
 
 #ifdef G4MULTITHREADED
-    if (dynamic_cast<G4MTRunManager*>(G4RunManager::GetRunManager())) {
-      G4cout<<G4endl;
-      G4cout<<G4endl;
-      G4cout<<G4endl;
-      G4cout<<"G4NCrystal WARNING :: Detected usage of G4MTRunManager - but NCrystal code is not currently supporting multi-threaded mode!!"<<G4endl;
-      G4cout<<G4endl;
-      G4cout<<G4endl;
-      G4cout<<G4endl;
-    }
+    //Both G4MTRunManager and G4TaskRunManager (which derives from it) are
+    //supported, since the Manager binds caches to G4 worker contexts:
+    if (dynamic_cast<G4MTRunManager*>(G4RunManager::GetRunManager()))
+      G4cout<<"G4NCrystal :: Detected multi-threaded run manager, using per-worker caches"<<G4endl;
 #endif
 
     G4ProcessManager* pmanager = G4Neutron::Neutron()->GetProcessManager();
@@ -124,6 +122,50 @@ namespace G4NCrystal {
   }
 }
 
+namespace G4NCrystal {
+  static G4ThreadLocal AbsProcWrapper * s_absproc = 0;
+}
+
+void G4NCrystal::installAbsorption()
+{
+  if (s_absproc)
+    return;
+
+  G4ProcessManager* pmanager = G4Neutron::Neutron()->GetProcessManager();
+  if (!pmanager) {
+    G4Exception("G4NCrystal::installAbsorption","Error",FatalException,
+                "Could not get process manager for neutron");
+    return;//for static analysis code that do not consider G4Exception non-returning
+  }
+
+  const G4ProcessVector* pl = pmanager->GetProcessList();
+  G4HadronicProcess* pCapture(0);
+  for (G4int i=0;i<pl->size();++i) {
+    if (!pmanager->GetProcessActivation(i))
+      continue;
+    G4HadronicProcess* pCaptureTest = dynamic_cast<G4HadronicProcess*>((*pl)[i]);
+    if ( pCaptureTest && pCaptureTest->GetProcessSubType() == fCapture ) {
+      if (pCapture) {
+        G4Exception("G4NCrystal::installAbsorption","Error",FatalException,
+                    "More than one neutron capture process found in active process list for Neutrons");
+      } else {
+        pCapture = pCaptureTest;
+      }
+    }
+  }
+
+  if (pCapture) {
+    G4cout<<"G4NCrystal :: Wrapping and replacing existing "<<
+      pCapture->GetProcessName()<<" process for neutrons"<<G4endl;
+  } else {
+    G4cout<<"G4NCrystal :: No existing neutron capture process found, adding NCrystal absorption process"<<G4endl;
+  }
+  pmanager->AddDiscreteProcess(s_absproc = new G4NCrystal::AbsProcWrapper(pCapture));
+  if ( pCapture && !pmanager->SetProcessActivation(pCapture,false) )
+    G4Exception("G4NCrystal::installAbsorption","Error",FatalException,
+                "Encountered error when deactivating the neutron capture process");
+}
+
 void G4NCrystal::install()
 {
   doInstall(false);
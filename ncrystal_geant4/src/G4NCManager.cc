@@ -21,21 +21,31 @@
 #include "G4NCrystal/G4NCManager.hh"
 
 #include "G4Material.hh"
+#include "G4Threading.hh"
 #include "Randomize.hh"
 #include "globals.hh"
 
 #include <sstream>
 #include <iomanip>
 #include <cassert>
+#include <cstdlib>
+#include <algorithm>
 
 namespace NC = NCrystal;
 namespace NCG4 = G4NCrystal;
 
 NCG4::Manager::Manager()
   : m_key("NCScat")
-{}
+{
+  for ( auto& e : m_cachePool )
+    e.store( nullptr );
+}
 
-NCG4::Manager::~Manager() = default;
+NCG4::Manager::~Manager()
+{
+  for ( auto& e : m_cachePool )
+    delete e.exchange( nullptr );
+}
 
 NCG4::Manager * NCG4::Manager::s_mgr = 0;
 
@@ -47,18 +57,41 @@ NCG4::Manager * NCG4::Manager::getInstance()
   return s_mgr;
 }
 
-NC::CachePtr& NCG4::Manager::getCachePtrForCurrentThreadAndProcess( unsigned scatter_idx ) const {
+NCG4::Manager::CacheSet& NCG4::Manager::getCacheSetForCurrentWorker() const {
+  //Slot 0 is for sequential mode, 1 for the master thread, and the rest for
+  //G4 workers (G4GetThreadId() binds to the G4 worker context, which is what
+  //stays fixed when work is executed as tasks on a thread pool):
+  const int slot = G4Threading::G4GetThreadId() + 2;
+  if ( slot >= 0 && slot < static_cast<int>(s_nCachePoolSlots) ) {
+    auto& entry = m_cachePool[slot];
+    CacheSet* cs = entry.load( std::memory_order_acquire );
+    if ( cs )
+      return *cs;
+    //First usage of this slot. Only the owning worker creates its own entry,
+    //but use compare_exchange anyway for robustness:
+    auto newcs = std::make_unique<CacheSet>();
+    CacheSet* expected = nullptr;
+    if ( entry.compare_exchange_strong( expected, newcs.get(), std::memory_order_acq_rel ) )
+      return *newcs.release();
+    return *expected;
+  }
+  //Unexpected thread id, fall back to a thread-local cache set:
   static
 #ifdef G4MULTITHREADED //protect thread_local keyword to avoid potential headaches in ST builds
  thread_local
 #endif
-    std::unique_ptr<std::vector<NCrystal::CachePtr>> cacheptrs;
-  if ( cacheptrs == nullptr ) {
-    cacheptrs = std::make_unique<decltype(cacheptrs)::element_type>();
-    cacheptrs->resize( m_scatters.size() );
+    CacheSet s_fallback;
+  return s_fallback;
+}
+
+NC::CachePtr& NCG4::Manager::getCachePtrForCurrentThreadAndProcess( unsigned idx, CacheSlot slot ) const {
+  CacheSet& cacheptrs = getCacheSetForCurrentWorker();
+  if ( !( idx < cacheptrs.size() ) ) {
+    //First access, or properties were added since last access:
+    cacheptrs.resize( std::max( m_scatters.size(), m_absorptions.size() ) );
+    assert( idx < cacheptrs.size() );
   }
-  assert( scatter_idx < cacheptrs->size() );
-  return (*cacheptrs)[scatter_idx];
+  return cacheptrs[idx][slot];
 }
 
 NCrystal::ProcImpl::OptionalProcPtr NCG4::Manager::getScatterPropertyPtr(G4Material*mat) const
@@ -106,6 +139,80 @@ void NCG4::Manager::addScatterProperty(G4Material* mat,NCrystal::ProcImpl::ProcP
   }
   assert( unsigned(double(idx)) == idx );//make sure we can get the idx back out
   matprop->AddConstProperty(m_key.c_str(), idx);
+
+  std::size_t matidx = mat->GetIndex();
+  if ( !( matidx < m_matidx2scatidx.size() ) )
+    m_matidx2scatidx.resize( G4Material::GetNumberOfMaterials(), std::numeric_limits<unsigned>::max() );
+  assert( matidx < m_matidx2scatidx.size() );
+  m_matidx2scatidx[matidx] = idx;
+}
+
+void NCG4::Manager::addAbsorptionProperty(G4Material* mat,NCrystal::ProcImpl::ProcPtr&&absn)
+{
+  if ( mat == nullptr || absn == nullptr )
+    G4Exception ("NCG4::Manager::addAbsorptionProperty", "NCAddingNull",
+                 JustWarning, "Got nullptr argument.");
+
+  if ( absn->processType() != NC::ProcessType::Absorption )
+    G4Exception ("NCG4::Manager::addAbsorptionProperty", "NCAddNonAbsorption",
+                 JustWarning, "Can only add absorption process (processType() is not NCrystal::Process::Absorption).");
+
+  unsigned idx = std::numeric_limits<unsigned>::max();
+  uint64_t absuid = absn->getUniqueID().value;
+  auto it = m_abs2idx.find(absuid);
+  if ( it == m_abs2idx.end() ) {
+    idx = m_absorptions.size();
+    m_abs2idx[absuid] = idx;
+    m_absorptions.push_back(std::move(absn));
+  } else {
+    //already known:
+    idx = it->second;
+  }
+
+  std::size_t matidx = mat->GetIndex();
+  if ( !( matidx < m_matidx2absidx.size() ) )
+    m_matidx2absidx.resize( G4Material::GetNumberOfMaterials(), std::numeric_limits<unsigned>::max() );
+  assert( matidx < m_matidx2absidx.size() );
+  m_matidx2absidx[matidx] = idx;
+}
+
+void NCG4::Manager::buildXSTables()
+{
+  static const double s_prec = []()
+  {
+    const char * ev = getenv("G4NCRYSTAL_XSTABPREC");
+    return ev ? std::atof(ev) : 1e-3;
+  }();
+  if ( !( s_prec > 0.0 ) )
+    return;
+  m_xstables.resize( m_scatters.size() );
+  for ( std::size_t i = 0; i < m_scatters.size(); ++i ) {
+    auto& sc = m_scatters.at(i);
+    if ( m_xstables[i] != nullptr || sc->isOriented() || sc->isNull() )
+      continue;
+    try {
+      auto pc = std::dynamic_pointer_cast<const NC::ProcImpl::ProcComposition>( sc.getsp() );
+      if ( pc && pc->hasXSTable() ) {
+        //Already has a table (e.g. configured with xstabprec), use as is:
+        m_xstables[i] = pc;
+        continue;
+      }
+      //Flatten top-level compositions, so their PCBragg components are seen
+      //when placing Bragg edges in the table:
+      auto tab = std::make_shared<NC::ProcImpl::ProcComposition>();
+      if ( pc )
+        tab->addComponents( NC::ProcImpl::ProcComposition::ComponentList{NC::SVAllowCopy,pc->components()} );
+      else
+        tab->addComponent( sc );
+      tab->enableXSTable( s_prec );
+      m_xstables[i] = std::move(tab);
+    } catch ( NC::Error::BadInput& ) {
+      //No part of the domain falls within the range of tables, stay with
+      //exact evaluations.
+    } catch ( NC::Error::Exception& e ) {
+      Manager::handleError("G4NCrystal::Manager::buildXSTables",101,e);
+    }
+  }
 }
 
 void NCG4::Manager::cleanup()
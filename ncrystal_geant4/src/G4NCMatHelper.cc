@@ -203,6 +203,20 @@ namespace G4NCrystal {
     // Cached also based on unique id's of Info objects      //
     ///////////////////////////////////////////////////////////
 
+    //Geometries often request the same few cfg-strings for many volumes, so
+    //final materials are also indexed by the cfg-strings exactly as
+    //provided. This avoids parsing them again and looking up Info objects for
+    //such repeated requests:
+    G4Material * findFinalMaterialByStr( const std::string& cfgstr ) const {
+      auto it = m_g4finalmaterials_bystr.find(cfgstr);
+      return it != m_g4finalmaterials_bystr.end()
+        ? G4Material::GetMaterialTable()->at(it->second)
+        : nullptr;
+    }
+    void addFinalMaterialByStr( const std::string& cfgstr, const G4Material * mat ) {
+      m_g4finalmaterials_bystr[cfgstr] = mat->GetIndex();
+    }
+
     G4Material * getFinalMaterial( const NC::MatCfg& cfg ) {
       G4Material * mat = getFinalMaterialImpl(cfg);
       if (s_verbose) {
@@ -253,9 +267,10 @@ namespace G4NCrystal {
       if (!info->hasComposition())
         NCRYSTAL_THROW(MissingInfo,"Selected crystal info source lacks info about material composition.");
 
-      //Make sure that we are at all able to initialise an NCrystal scatter object
-      //for the given configuration:
+      //Make sure that we are at all able to initialise NCrystal scatter and
+      //absorption objects for the given configuration:
       auto scatter = NC::FactImpl::createScatter(cfg);
+      auto absorption = NC::FactImpl::createAbsorption(cfg);
 
       //Base G4 material for the given chemical composition:
       G4Material * matBase = getBaseMaterial( info->getComposition() );
@@ -277,6 +292,7 @@ namespace G4NCrystal {
                                          matBase, kStateSolid, temp, 1.0 * CLHEP::atmosphere );
 
       G4NCrystal::Manager::getInstance()->addScatterProperty(mat,std::move(scatter));
+      G4NCrystal::Manager::getInstance()->addAbsorptionProperty(mat,std::move(absorption));
 
       //Add to cache and return:
       m_g4finalmaterials[cache_key] = mat->GetIndex();
@@ -292,6 +308,7 @@ namespace G4NCrystal {
     std::map<NCCU::ElementBreakdownLW,G4Index> m_g4elements;
     std::map<NCCU::LWBreakdown,G4Index> m_g4basematerials;
     std::map<std::pair<uint64_t,std::string>,G4Index> m_g4finalmaterials;
+    std::map<std::string,G4Index> m_g4finalmaterials_bystr;
   };
 
   struct NCG4ObjectDB {
@@ -323,10 +340,15 @@ namespace G4NCrystal {
 G4Material * G4NCrystal::createMaterial( const char * cfgstr )
 {
   try {
-    NC::MatCfg cfg(cfgstr);
+    std::string cfgstring(cfgstr);
     auto& db = objDB();
     NCRYSTAL_LOCK_GUARD(db.mtx);
-    return db.db.getFinalMaterial(cfg);
+    G4Material * mat = db.db.findFinalMaterialByStr(cfgstring);
+    if (mat)
+      return mat;
+    mat = db.db.getFinalMaterial(NC::MatCfg(cfgstring));
+    db.db.addFinalMaterialByStr(cfgstring,mat);
+    return mat;
   } catch ( NC::Error::Exception& e ) {
     Manager::handleError("G4NCrystal::createMaterial",101,e);
   }
@@ -350,3 +372,25 @@ G4Material * G4NCrystal::createMaterial( const NC::MatCfg&  cfg )
   }
   return 0;
 }
+
+void G4NCrystal::prepareMaterials( const std::vector<std::string>& cfgstrs )
+{
+  try {
+    //Launch all jobs before waiting for any of them (the objects end up in the
+    //factory caches, from where createMaterial will pick them up):
+    std::vector<std::shared_future<NC::shared_obj<const NC::Info>>> infos;
+    std::vector<std::shared_future<NC::shared_obj<const NC::ProcImpl::Process>>> procs;
+    for ( auto& cfgstr : cfgstrs ) {
+      NC::MatCfg cfg(cfgstr);
+      infos.push_back( NC::FactImpl::createInfoAsync(cfg) );
+      procs.push_back( NC::FactImpl::createScatterAsync(cfg) );
+      procs.push_back( NC::FactImpl::createAbsorptionAsync(cfg) );
+    }
+    for ( auto& f : infos )
+      f.get();
+    for ( auto& f : procs )
+      f.get();
+  } catch ( NC::Error::Exception& e ) {
+    Manager::handleError("G4NCrystal::prepareMaterials",101,e);
+  }
+}
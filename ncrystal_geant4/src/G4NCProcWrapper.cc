@@ -31,6 +31,7 @@
 #include "G4ParticleChange.hh"
 #include "G4VTouchable.hh"
 #include "G4NavigationHistory.hh"
+#include "G4Threading.hh"
 
 namespace NC = NCrystal;
 namespace NCG4 = G4NCrystal;
@@ -52,6 +53,10 @@ namespace G4NCrystal {
       }
     protected:
       double actualGenerate() override { return m_engine->flat(); }
+      void actualGenerateMany( std::size_t n, double* tgt ) override
+      {
+        m_engine->flatArray( static_cast<int>(n), tgt );
+      }
     };
 
   }
@@ -109,12 +114,17 @@ G4VParticleChange* NCG4::ProcWrapper::PostStepDoIt(const G4Track& trk, const G4S
       g4outcome_ekin = outcome.ekin.get() * CLHEP::eV;
       g4outcome_dir.set(outcome.direction[0],outcome.direction[1],outcome.direction[2]);
     } else {
-      //Orientation of material matters, need to transform to-and-from the frame of the volume (touchable):
-      const G4AffineTransform &trf = step.GetPreStepPoint()->GetTouchable()->GetHistory()->GetTopTransform();
-      G4ThreeVector indir_local = trf.TransformAxis(indir);
+      //Orientation of material matters, need to transform to-and-from the
+      //frame of the volume (touchable). Usually this was already done for the
+      //same neutron state in GetMeanFreePath:
+      const G4VTouchable* touchable = step.GetPreStepPoint()->GetTouchable();
+      if ( !m_lastOriented.matches( &ncscat, touchable, ekin, indir ) )
+        m_lastOriented.set( &ncscat, touchable, ekin, indir );
+      const G4ThreeVector& indir_local = m_lastOriented.indir_local;
       auto outcome = ncscat.sampleScatter(cacheptr,rng,nc_ekin_in, NC::NeutronDirection{indir_local.x(),indir_local.y(),indir_local.z()} );
       g4outcome_ekin = outcome.ekin.get() * CLHEP::eV;
-      g4outcome_dir = trf.Inverse().TransformAxis(G4ThreeVector{outcome.direction[0],outcome.direction[1],outcome.direction[2]});
+      g4outcome_dir = m_lastOriented.trf.Inverse().TransformAxis(G4ThreeVector{outcome.direction[0],outcome.direction[1],outcome.direction[2]});
+      m_lastOriented.invalidate();//neutron state is changing
     }
   } catch ( NC::Error::Exception& e ) {
     Manager::handleError("G4NCrystal::ProcWrapper::PostStepDoIt",101,e);
@@ -152,7 +162,9 @@ G4double NCG4::ProcWrapper::GetMeanFreePath(const G4Track& trk, G4double p, G4Fo
     if( ! ncscat.isOriented() ) {
       xs = ncscat.crossSection( cacheptr, nc_ekin_in, NC::NeutronDirection{indir.x(),indir.y(),indir.z()}).get() * CLHEP::barn;
     } else {
-      G4ThreeVector indir_local = trk.GetStep()->GetPreStepPoint()->GetTouchable()->GetHistory()->GetTopTransform().TransformAxis(indir);
+      //Remember the transformation, for usage in PostStepDoIt:
+      m_lastOriented.set( &ncscat, trk.GetStep()->GetPreStepPoint()->GetTouchable(), ekin, indir );
+      const G4ThreeVector& indir_local = m_lastOriented.indir_local;
       xs = ncscat.crossSection( cacheptr, nc_ekin_in, NC::NeutronDirection{indir_local.x(),indir_local.y(),indir_local.z()} ).get() * CLHEP::barn;
     }
   } catch ( NC::Error::Exception& e ) {
@@ -166,6 +178,10 @@ G4double NCG4::ProcWrapper::GetMeanFreePath(const G4Track& trk, G4double p, G4Fo
 
 void NCG4::ProcWrapper::BuildPhysicsTable(const G4ParticleDefinition&)
 {
+  //Tables are shared by all threads, so only build them on the master (which
+  //happens before worker threads start their event loops):
+  if ( G4Threading::IsMasterThread() )
+    m_mgr->buildXSTables();
 }
 
 G4bool NCG4::ProcWrapper::IsApplicable(const G4ParticleDefinition& pd)
@@ -23,6 +23,10 @@
 
 #include "G4VDiscreteProcess.hh"
 #include "G4ParticleChange.hh"
+#include "G4AffineTransform.hh"
+#include "G4ThreeVector.hh"
+#include "G4VTouchable.hh"
+#include "G4NavigationHistory.hh"
 
 class G4HadronElasticProcess;
 class G4Material;
@@ -53,6 +57,33 @@ namespace G4NCrystal {
     G4ParticleChange m_particleChange;
     G4HadronElasticProcess * m_wrappedProc;
     Manager * m_mgr;
+
+    //Neutron state and frame transformation from the last GetMeanFreePath call
+    //in an oriented material, for reuse in a subsequent PostStepDoIt call
+    //(process objects are per-thread, so no locking is needed):
+    struct OrientedState {
+      const void * proc = nullptr;
+      const G4VTouchable * touchable = nullptr;
+      G4double ekin = -1.0;
+      G4ThreeVector indir;
+      G4ThreeVector indir_local;
+      G4AffineTransform trf;
+      bool matches( const void * p, const G4VTouchable * t, G4double e, const G4ThreeVector& d ) const
+      {
+        return proc == p && touchable == t && ekin == e && indir == d;
+      }
+      void set( const void * p, const G4VTouchable * t, G4double e, const G4ThreeVector& d )
+      {
+        proc = p;
+        touchable = t;
+        ekin = e;
+        indir = d;
+        trf = t->GetHistory()->GetTopTransform();
+        indir_local = trf.TransformAxis(d);
+      }
+      void invalidate() { proc = nullptr; }
+    };
+    OrientedState m_lastOriented;
   };
 
 }
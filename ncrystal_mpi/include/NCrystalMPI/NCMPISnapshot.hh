@@ -0,0 +1,62 @@
+#ifndef NCrystalMPI_MPISnapshot_hh
+#define NCrystalMPI_MPISnapshot_hh
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+//  This file is part of NCrystal (see https://mctools.github.io/ncrystal/)   //
+//                                                                            //
+//  Copyright 2015-2021 NCrystal developers                                   //
+//                                                                            //
+//  Licensed under the Apache License, Version 2.0 (the "License");           //
+//  you may not use this file except in compliance with the License.          //
+//  You may obtain a copy of the License at                                   //
+//                                                                            //
+//      http://www.apache.org/licenses/LICENSE-2.0                            //
+//                                                                            //
+//  Unless required by applicable law or agreed to in writing, software       //
+//  distributed under the License is distributed on an "AS IS" BASIS,         //
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  //
+//  See the License for the specific language governing permissions and       //
+//  limitations under the License.                                            //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include "NCrystal/NCDefs.hh"
+#include <mpi.h>
+
+namespace NCrystalMPI {
+
+  //////////////////////////////////////////////////////////////////////////////
+  //                                                                          //
+  // Build materials once per MPI job rather than once per rank. Must be      //
+  // called collectively by all ranks of the communicator, typically right    //
+  // after MPI_Init. Rank 0 creates Info, Scatter and Absorption objects for  //
+  // the given cfg-strings while recording a snapshot of all expensive        //
+  // derived tables (cf. NCrystal::FactImpl::saveSnapshot), which is then     //
+  // broadcast to and loaded by all ranks. Subsequent createScatter(..) etc.  //
+  // calls on any rank find the tables in the snapshot rather than computing  //
+  // them again (input files are still parsed on each rank, which is cheap in //
+  // comparison).                                                             //
+  //                                                                          //
+  // With ShareMode::NodeShared, the snapshot is only sent to one rank per    //
+  // node and placed in an MPI shared memory window, which the tables of all  //
+  // ranks on the node then refer to directly. With ShareMode::PerRank, each  //
+  // rank receives a private copy. The memory holding the snapshot is never   //
+  // released, so NCrystal objects remain usable for the rest of the process  //
+  // (but not after MPI_Finalize in NodeShared mode).                         //
+  //                                                                          //
+  // Failures on rank 0 result in an exception on all ranks. The snapshot is  //
+  // built with nthreads threads on rank 0 (0 means NCRYSTAL_NTHREADS).       //
+  //                                                                          //
+  //////////////////////////////////////////////////////////////////////////////
+
+  enum class ShareMode { PerRank, NodeShared };
+
+  void loadMaterials( MPI_Comm comm,
+                      const NCrystal::VectS& cfgstrs,
+                      ShareMode = ShareMode::NodeShared,
+                      unsigned nthreads = 0 );
+
+}
+
+#endif
@@ -0,0 +1,160 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+//  This file is part of NCrystal (see https://mctools.github.io/ncrystal/)   //
+//                                                                            //
+//  Copyright 2015-2021 NCrystal developers                                   //
+//                                                                            //
+//  Licensed under the Apache License, Version 2.0 (the "License");           //
+//  you may not use this file except in compliance with the License.          //
+//  You may obtain a copy of the License at                                   //
+//                                                                            //
+//      http://www.apache.org/licenses/LICENSE-2.0                            //
+//                                                                            //
+//  Unless required by applicable law or agreed to in writing, software       //
+//  distributed under the License is distributed on an "AS IS" BASIS,         //
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  //
+//  See the License for the specific language governing permissions and       //
+//  limitations under the License.                                            //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include "NCrystalMPI/NCMPISnapshot.hh"
+#include "NCrystal/NCFactImpl.hh"
+#include "NCrystal/internal/NCThreadUtils.hh"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <limits>
+
+namespace NC = NCrystal;
+
+namespace NCrystalMPI {
+  namespace {
+
+    //Same alignment as required by FactImpl::loadSnapshotFromMemory:
+    constexpr std::size_t snapshot_alignment = 64;
+
+    //Size value broadcast in case rank 0 failed to create the snapshot:
+    constexpr uint64_t failure_marker = std::numeric_limits<uint64_t>::max();
+
+    void checkMPI( int ec, const char * what )
+    {
+      if ( ec != MPI_SUCCESS )
+        NCRYSTAL_THROW2(DataLoadError,"NCrystalMPI: "<<what<<" failed (MPI error code "<<ec<<")");
+    }
+
+    //MPI_Bcast takes int counts, so large buffers are sent in chunks:
+    void bcastBytes( char * data, uint64_t size, MPI_Comm comm )
+    {
+      constexpr uint64_t chunk = 1u << 30;
+      for ( uint64_t offset = 0; offset < size; offset += chunk ) {
+        const int n = static_cast<int>( std::min<uint64_t>( chunk, size - offset ) );
+        checkMPI( MPI_Bcast( data + offset, n, MPI_BYTE, 0, comm ), "MPI_Bcast" );
+      }
+    }
+
+    //Memory holding snapshots is never released (tables refer to it directly):
+    char * allocatePrivate( uint64_t size )
+    {
+      return static_cast<char*>( NC::alignedAlloc( snapshot_alignment, std::max<uint64_t>( size, 1 ) ) );
+    }
+
+    bool isAligned( const char * p )
+    {
+      return reinterpret_cast<std::uintptr_t>( p ) % snapshot_alignment == 0;
+    }
+
+    void loadPerRank( MPI_Comm comm, int rank, const std::string& data, uint64_t size )
+    {
+      char * buf = allocatePrivate( size );
+      if ( rank == 0 )
+        std::memcpy( buf, data.data(), size );
+      bcastBytes( buf, size, comm );
+      NC::FactImpl::loadSnapshotFromMemory( reinterpret_cast<const unsigned char*>( buf ), size );
+    }
+
+    void loadNodeShared( MPI_Comm comm, int rank, const std::string& data, uint64_t size )
+    {
+      //Communicator of ranks on the same node (global rank 0 is always node
+      //rank 0, since ranks are ordered by their global rank), and one of the
+      //node leaders:
+      MPI_Comm nodecomm, leadercomm;
+      checkMPI( MPI_Comm_split_type( comm, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL, &nodecomm ),
+                "MPI_Comm_split_type" );
+      int noderank;
+      checkMPI( MPI_Comm_rank( nodecomm, &noderank ), "MPI_Comm_rank" );
+      checkMPI( MPI_Comm_split( comm, noderank == 0 ? 0 : MPI_UNDEFINED, rank, &leadercomm ),
+                "MPI_Comm_split" );
+
+      //Shared window, allocated by the node leader with room for alignment
+      //padding. The window is never freed:
+      const uint64_t winsize = ( noderank == 0 ? size + snapshot_alignment : 0 );
+      char * base = nullptr;
+      MPI_Win win;
+      checkMPI( MPI_Win_allocate_shared( static_cast<MPI_Aint>( winsize ), 1, MPI_INFO_NULL,
+                                         nodecomm, &base, &win ), "MPI_Win_allocate_shared" );
+      if ( noderank != 0 ) {
+        MPI_Aint qsize;
+        int qdisp;
+        checkMPI( MPI_Win_shared_query( win, 0, &qsize, &qdisp, &base ), "MPI_Win_shared_query" );
+      }
+      //The padding is chosen by the leader, since the window might be mapped at
+      //different addresses in each process:
+      uint64_t padding = ( noderank == 0 ? ( snapshot_alignment - reinterpret_cast<std::uintptr_t>( base ) % snapshot_alignment ) % snapshot_alignment : 0 );
+      checkMPI( MPI_Bcast( &padding, 1, MPI_UINT64_T, 0, nodecomm ), "MPI_Bcast" );
+      char * shared = base + padding;
+
+      if ( noderank == 0 ) {
+        if ( rank == 0 )
+          std::memcpy( shared, data.data(), size );
+        bcastBytes( shared, size, leadercomm );
+        checkMPI( MPI_Comm_free( &leadercomm ), "MPI_Comm_free" );
+      }
+      checkMPI( MPI_Barrier( nodecomm ), "MPI_Barrier" );
+
+      //Use the shared copy where it is suitably aligned in this process (which
+      //is normally the case, as windows are page aligned), otherwise fall back
+      //to a private copy:
+      const char * mydata = shared;
+      if ( !isAligned( shared ) ) {
+        char * buf = allocatePrivate( size );
+        std::memcpy( buf, shared, size );
+        mydata = buf;
+      }
+      checkMPI( MPI_Comm_free( &nodecomm ), "MPI_Comm_free" );
+      NC::FactImpl::loadSnapshotFromMemory( reinterpret_cast<const unsigned char*>( mydata ), size );
+    }
+  }
+}
+
+void NCrystalMPI::loadMaterials( MPI_Comm comm, const NC::VectS& cfgstrs, ShareMode mode, unsigned nthreads )
+{
+  int rank;
+  checkMPI( MPI_Comm_rank( comm, &rank ), "MPI_Comm_rank" );
+
+  //Build snapshot on rank 0 (exceptions are rethrown once the other ranks
+  //have been notified, to avoid deadlocks):
+  std::string data;
+  uint64_t size = 0;
+  std::exception_ptr error;
+  if ( rank == 0 ) {
+    try {
+      data = NC::FactImpl::saveSnapshotToMemory( cfgstrs, nthreads ? nthreads : NC::getNThreadsFromEnv() );
+      size = data.size();
+    } catch (...) {
+      error = std::current_exception();
+      size = failure_marker;
+    }
+  }
+  checkMPI( MPI_Bcast( &size, 1, MPI_UINT64_T, 0, comm ), "MPI_Bcast" );
+  if ( error )
+    std::rethrow_exception( error );
+  if ( size == failure_marker )
+    NCRYSTAL_THROW(DataLoadError,"NCrystalMPI: creation of materials failed on rank 0");
+
+  if ( mode == ShareMode::NodeShared )
+    loadNodeShared( comm, rank, data, size );
+  else
+    loadPerRank( comm, rank, data, size );
+}
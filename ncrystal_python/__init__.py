@@ -203,6 +203,18 @@ def _load(nclib_filename):
         a=_np.empty(n,dtype=_uint)
         return a,ndarray_to_uintp(a)
 
+    def _create_bulk_array(ctype,n):
+        #Arrays for bulk data transfer, filled directly by the C code. These are
+        #numpy arrays when possible, and plain ctypes arrays otherwise:
+        if _np is not None:
+            a=_np.empty(n,dtype=ctype)
+            return a,a.ctypes.data_as(ctypes.POINTER(ctype))
+        a=(ctype*n)()
+        return a,ctypes.cast(a,ctypes.POINTER(ctype))
+
+    def _bulk_array_tolist(a):
+        return a.tolist() if _np is not None else a[:]
+
     class ncrystal_info_t(ctypes.Structure):
         _fields_ = [('internal', _voidp)]
     class ncrystal_process_t(ctypes.Structure):
@@ -321,6 +333,19 @@ def _load(nclib_filename):
         _raw_info_getatompos(nfo,iatom,ipos,x,y,z)
         return x.value, y.value, z.value
     functions['ncrystal_info_getatompos'] = ncrystal_info_getatompos
+    _raw_info_getatominfo_all = _wrap('ncrystal_info_getatominfo_all',None,(ncrystal_info_t,_uintp,_uintp,_dblp,_dblp),hide=True)
+    _raw_info_getatompos_all = _wrap('ncrystal_info_getatompos_all',None,(ncrystal_info_t,_dblp),hide=True)
+    def ncrystal_info_getatominfo_all(nfo):
+        n = functions['ncrystal_info_natominfo'](nfo)
+        atomidx,atomidxptr = _create_bulk_array(_uint,n)
+        npos,nposptr = _create_bulk_array(_uint,n)
+        dt,dtptr = _create_bulk_array(_dbl,n)
+        msd,msdptr = _create_bulk_array(_dbl,n)
+        _raw_info_getatominfo_all(nfo,atomidxptr,nposptr,dtptr,msdptr)
+        pos,posptr = _create_bulk_array(_dbl,3*sum(_bulk_array_tolist(npos)))
+        _raw_info_getatompos_all(nfo,posptr)
+        return tuple(_bulk_array_tolist(a) for a in (atomidx,npos,dt,msd,pos))
+    functions['ncrystal_info_getatominfo_all'] = ncrystal_info_getatominfo_all
 
     for s in ('temperature','xsectabsorption','xsectfree','density','numberdensity'):
         _wrap('ncrystal_info_get%s'%s,_dbl,(ncrystal_info_t,))
@@ -340,6 +365,23 @@ def _load(nclib_filename):
     _wrap('ncrystal_info_gethkl',None,(ncrystal_info_t,_int,_intp,_intp,_intp,_intp,_dblp,_dblp))
     _wrap('ncrystal_info_dspacing_from_hkl',_dbl,(ncrystal_info_t,_int,_int,_int))
     functions['ncrystal_info_gethkl_setuppars'] = lambda : (_int(),_int(),_int(),_int(),_dbl(),_dbl())
+    _raw_info_gethkl_all = _wrap('ncrystal_info_gethkl_all',None,(ncrystal_info_t,_intp,_intp,_intp,_intp,_dblp,_dblp),hide=True)
+    def ncrystal_info_gethkl_all(nfo):
+        n = max(0,functions['ncrystal_info_nhkl'](nfo))
+        arrs = [_create_bulk_array(_int,n) for i in range(4)] + [_create_bulk_array(_dbl,n) for i in range(2)]
+        _raw_info_gethkl_all(nfo,*(ptr for a,ptr in arrs))
+        return tuple(a for a,ptr in arrs)
+    functions['ncrystal_info_gethkl_all'] = ncrystal_info_gethkl_all
+    _raw_info_ndeminormals = _wrap('ncrystal_info_ndeminormals',_uint,(ncrystal_info_t,),hide=True)
+    _raw_info_getdeminormals_all = _wrap('ncrystal_info_getdeminormals_all',None,(ncrystal_info_t,_dblp),hide=True)
+    def ncrystal_info_getdeminormals_all(nfo):
+        n = _raw_info_ndeminormals(nfo)
+        if n == 0:
+            return None
+        normals,normalsptr = _create_bulk_array(_dbl,3*n)
+        _raw_info_getdeminormals_all(nfo,normalsptr)
+        return normals
+    functions['ncrystal_info_getdeminormals_all'] = ncrystal_info_getdeminormals_all
 
     _wrap('ncrystal_info_ndyninfo',_uint,(ncrystal_info_t,))
     _raw_di_base = _wrap('ncrystal_dyninfo_base',None,(ncrystal_info_t,_uint,_dblp,_uintp,_dblp,_uintp),hide=True)
@@ -413,27 +455,17 @@ def _load(nclib_filename):
                     ncomp=ncomp.value,z=zval.value,a=aval.value)
     functions['ncrystal_atomdata_getfields'] = ncrystal_atomdata_getfields
 
-    _raw_ncustom = _wrap('ncrystal_info_ncustomsections',_uint,(ncrystal_info_t,),hide=True)
-    _raw_csec_name = _wrap('ncrystal_info_customsec_name',_cstr,(ncrystal_info_t,_uint),hide=True)
-    _raw_csec_nlines = _wrap('ncrystal_info_customsec_nlines',_uint,(ncrystal_info_t,_uint),hide=True)
-    _raw_csec_nparts = _wrap('ncrystal_info_customline_nparts',_uint,(ncrystal_info_t,_uint,_uint),hide=True)
-    _raw_csec_part = _wrap('ncrystal_info_customline_getpart',_cstr,(ncrystal_info_t,_uint,_uint,_uint),hide=True)
+    _raw_csec_getall = _wrap('ncrystal_info_getcustomsections_all',None,(ncrystal_info_t,_uintp,_cstrpp),hide=True)
     def ncrystal_info_getcustomsections(nfo):
-        n=_raw_ncustom(nfo)
-        if n==0:
-            return tuple()
+        n,l = _uint(),_cstrp()
+        _raw_csec_getall(nfo,n,ctypes.byref(l))
+        assert n.value%2==0
         out=[]
-        for isec in range(n):
-            lines=[]
-            secname = _cstr2str(_raw_csec_name(nfo,isec))
-            nlines = _raw_csec_nlines(nfo,isec)
-            for iline in range(nlines):
-                nparts=_raw_csec_nparts(nfo,isec,iline)
-                parts=[]
-                for ipart in range(nparts):
-                    parts.append(_cstr2str(_raw_csec_part(nfo,isec,iline,ipart)))
-                lines.append(tuple(parts))
-            out.append((secname,tuple(lines)))
+        for i in range(n.value//2):
+            secname,content = _cstr2str(l[2*i]),_cstr2str(l[2*i+1])
+            out.append((secname,tuple(tuple(line.split(' ')) if line else tuple()
+                                      for line in content.split('\n')[:-1])))
+        _raw_deallocstrlist(n,l)
         return tuple(out)
     functions['ncrystal_info_getcustomsections'] = ncrystal_info_getcustomsections
 
@@ -449,7 +481,10 @@ def _load(nclib_filename):
         if repeat is None and not hasattr(ekin,'__len__'):
             return None#scalar case, array interface not triggered
         repeat = 1 if repeat is None else repeat
-        ekin = (ekin if hasattr(ekin,'ctypes') else _np.asfarray(ekin) ) if hasattr(ekin,'__len__') else _np.ones(1)*ekin
+        #NB: ascontiguousarray does not copy input which is already a contiguous
+        #array of doubles (the expected case), but protects against passing
+        #along the memory of arrays with other dtypes or strides:
+        ekin = _np.ascontiguousarray(ekin,dtype=_dbl).ravel() if hasattr(ekin,'__len__') else _np.ones(1)*ekin
         #NB: returning the ekin object itself is important in order to keep a reference to it after the call:
         return ndarray_to_dblp(ekin),len(ekin),repeat,ekin
 
@@ -469,6 +504,34 @@ def _load(nclib_filename):
             return xs
     functions['ncrystal_crosssection_nonoriented'] = ncrystal_crosssection_nonoriented
 
+    _raw_xs_grid = _wrap('ncrystal_crosssection_grid',None,(ncrystal_process_t,_dblp,_ulong,_dblp,_ulong,
+                                                            _uint,_dblp),hide=True)
+    def ncrystal_crosssection_grid(proc,ekin,directions,nthreads):
+        _ensure_numpy()
+        ekin = _np.atleast_1d(_np.ascontiguousarray(ekin,dtype=_dbl)).ravel()
+        dirs = _np.ascontiguousarray(directions,dtype=_dbl).reshape(-1,3)
+        xs, xs_ct = _create_numpy_double_array(len(ekin)*len(dirs))
+        _raw_xs_grid(proc,ndarray_to_dblp(ekin),len(ekin),ndarray_to_dblp(dirs),len(dirs),nthreads,xs_ct)
+        return xs.reshape(len(ekin),len(dirs))
+    functions['ncrystal_crosssection_grid'] = ncrystal_crosssection_grid
+
+    _raw_groupavxs = _wrap('ncrystal_groupaveraged_xs',None,(ncrystal_process_t,_dblp,_ulong,_dblp,_dblp,
+                                                             _ulong,_dbl,_uint,_dblp),hide=True)
+    def ncrystal_groupaveraged_xs(proc,group_bounds,flux_ekin,flux_values,precision,nthreads):
+        def _dblarr(vals):
+            vals = [float(e) for e in vals]
+            return (_dbl*max(1,len(vals)))(*vals),len(vals)
+        gb,n_gb = _dblarr(group_bounds)
+        fe,n_fe = _dblarr(flux_ekin)
+        fv,n_fv = _dblarr(flux_values)
+        if n_fe != n_fv:
+            raise NCBadInput('flux_ekin and flux_values must have the same length')
+        res,res_ct = _create_bulk_array(_dbl,max(1,n_gb-1))
+        _raw_groupavxs(proc,ctypes.cast(gb,_dblp),n_gb,ctypes.cast(fe,_dblp),ctypes.cast(fv,_dblp),
+                       n_fe,precision,nthreads,res_ct)
+        return res[0:max(0,n_gb-1)]
+    functions['ncrystal_groupaveraged_xs'] = ncrystal_groupaveraged_xs
+
     _raw_domain = _wrap('ncrystal_domain',None,(ncrystal_process_t,_dblp,_dblp),hide=True)
     def ncrystal_domain(proc):
         a,b = _dbl(),_dbl()
@@ -476,6 +539,22 @@ def _load(nclib_filename):
         return (a.value,b.value)
     functions['ncrystal_domain'] = ncrystal_domain
 
+    _raw_info_memfp = _wrap('ncrystal_info_memory_footprint',None,(ncrystal_info_t,_dblp,_dblp),hide=True)
+    def ncrystal_info_memory_footprint(info):
+        a,b = _dbl(),_dbl()
+        _raw_info_memfp(info,a,b)
+        return (int(a.value),int(b.value))
+    functions['ncrystal_info_memory_footprint'] = ncrystal_info_memory_footprint
+
+    _raw_proc_memfp = _wrap('ncrystal_process_memory_footprint',None,(ncrystal_process_t,_dblp,_dblp),hide=True)
+    def ncrystal_process_memory_footprint(proc):
+        a,b = _dbl(),_dbl()
+        _raw_proc_memfp(proc,a,b)
+        return (int(a.value),int(b.value))
+    functions['ncrystal_process_memory_footprint'] = ncrystal_process_memory_footprint
+    _wrap('ncrystal_dump_info_memory_footprint',None,(ncrystal_info_t,))
+    _wrap('ncrystal_dump_process_memory_footprint',None,(ncrystal_process_t,))
+
     _raw_samplesct_iso =_wrap('ncrystal_samplescatterisotropic',None,(ncrystal_scatter_t,_dbl,_dblp,_dblp),hide=True)
     _raw_samplesct_iso_many =_wrap('ncrystal_samplescatterisotropic_many',None,
                                    (ncrystal_scatter_t,_dblp,_ulong,_ulong,_dblp,_dblp),hide=True)
@@ -496,6 +575,18 @@ def _load(nclib_filename):
             return ekin_final,mu
     functions['ncrystal_samplesct_iso'] = ncrystal_samplesct_iso
 
+    _raw_samplesct_iso_hist = _wrap('ncrystal_samplescatterisotropic_hist',None,
+                                    (ncrystal_scatter_t,_dbl,_ulong,_int,_uint,_dbl,_dbl,
+                                     _int,_uint,_dbl,_dbl,_dbl,_uint,_dblp),hide=True)
+    def ncrystal_samplesct_iso_hist(scat,ekin,nsamples,xvar,nbinsx,xmin,xmax,yvar,nbinsy,ymin,ymax,
+                                    temperature,nthreads):
+        nbins = nbinsx * ( nbinsy if yvar else 1 )
+        h, h_ct = _create_numpy_double_array(nbins)
+        _raw_samplesct_iso_hist(scat,ekin,nsamples,xvar,nbinsx,xmin,xmax,yvar,nbinsy,ymin,ymax,
+                                temperature,nthreads,h_ct)
+        return h.reshape(nbinsx,nbinsy) if yvar else h
+    functions['ncrystal_samplesct_iso_hist'] = ncrystal_samplesct_iso_hist
+
     def ncrystal_samplesct(scat, ekin, direction, repeat):
         cdir = (_dbl * 3)(*direction)
         if not repeat:
@@ -598,6 +689,23 @@ def _load(nclib_filename):
         _raw_setrand(keepalive[1])
     functions['ncrystal_setrandgen'] = ncrystal_setrandgen
 
+    _RANDGENBULKFCTTYPE = ctypes.CFUNCTYPE( None, _dblp, _uint )
+    _raw_setrandbulk    = _wrap('ncrystal_setrandgen_bulk',None,(_RANDGENBULKFCTTYPE,),hide=True)
+    def ncrystal_setrandgen_bulk(randfct):
+        #Same as ncrystal_setrandgen, but wrapping a function producing one
+        #number at a time in a callback filling arrays (thus only crossing the
+        #language barrier once per batch of numbers).
+        if not randfct:
+            keepalive=(None,ctypes.cast(None, _RANDGENBULKFCTTYPE))
+        else:
+            def _fill(ptr,n):
+                for i in range(n):
+                    ptr[i] = randfct()
+            keepalive=(randfct,_RANDGENBULKFCTTYPE(_fill))#keep refs!
+        _keepalive.append(keepalive)
+        _raw_setrandbulk(keepalive[1])
+    functions['ncrystal_setrandgen_bulk'] = ncrystal_setrandgen_bulk
+
     _wrap('ncrystal_clone_absorption',ncrystal_absorption_t,(ncrystal_absorption_t,))
     _wrap('ncrystal_clone_scatter',ncrystal_scatter_t,(ncrystal_scatter_t,))
     _wrap('ncrystal_clone_scatter_rngbyidx',ncrystal_scatter_t,(ncrystal_scatter_t,_ulong))
@@ -606,8 +714,10 @@ def _load(nclib_filename):
     _wrap('ncrystal_decodecfg_vdoslux',_uint,(_cstr,))
     _wrap('ncrystal_disable_caching',None,tuple())
     _wrap('ncrystal_enable_caching',None,tuple())
+    _wrap('ncrystal_enable_textdata_dedup',None,(_int,))
     _wrap('ncrystal_has_factory',_int,(_cstr,))
     _wrap('ncrystal_clear_caches',None,tuple())
+    _wrap('ncrystal_setnthreads',None,(_uint,))
 
 
     _wrap('ncrystal_rngsupportsstatemanip_ofscatter',_int,( ncrystal_scatter_t, ))
@@ -663,6 +773,62 @@ def _load(nclib_filename):
         return res
     functions['ncrystal_get_pluginlist'] = ncrystal_get_pluginlist
 
+    _raw_savesnapshot = _wrap('ncrystal_save_snapshot',None,(_cstr,_uint,_cstrp),hide=True)
+    def ncrystal_save_snapshot(path,cfgstrs):
+        arr = (_cstr * len(cfgstrs))(*[_str2cstr(e) for e in cfgstrs])
+        _raw_savesnapshot(_str2cstr(path),len(cfgstrs),ctypes.cast(arr,_cstrp))
+    functions['ncrystal_save_snapshot'] = ncrystal_save_snapshot
+    _raw_savesnapshot_mt = _wrap('ncrystal_save_snapshot_mt',None,(_cstr,_uint,_cstrp,_uint),hide=True)
+    def ncrystal_save_snapshot_mt(path,cfgstrs,nthreads):
+        arr = (_cstr * len(cfgstrs))(*[_str2cstr(e) for e in cfgstrs])
+        _raw_savesnapshot_mt(_str2cstr(path),len(cfgstrs),ctypes.cast(arr,_cstrp),nthreads)
+    functions['ncrystal_save_snapshot_mt'] = ncrystal_save_snapshot_mt
+    _wrap('ncrystal_load_snapshot',None,(_cstr,))
+    _raw_savesnapshot_mem = _wrap('ncrystal_save_snapshot_to_memory',_charptr,(_uint,_cstrp,_uint,ctypes.POINTER(_ulong)),hide=True)
+    def ncrystal_save_snapshot_to_memory(cfgstrs,nthreads):
+        arr = (_cstr * len(cfgstrs))(*[_str2cstr(e) for e in cfgstrs])
+        size = _ulong()
+        ptr = _raw_savesnapshot_mem(len(cfgstrs),ctypes.cast(arr,_cstrp),nthreads,size)
+        data = ctypes.string_at(ptr,size.value)
+        _raw_deallocstr(ptr)
+        return data
+    functions['ncrystal_save_snapshot_to_memory'] = ncrystal_save_snapshot_to_memory
+    _raw_loadsnapshot_mem = _wrap('ncrystal_load_snapshot_from_memory',None,(_cstr,_ulong),hide=True)
+    functions['ncrystal_load_snapshot_from_memory'] = lambda data : _raw_loadsnapshot_mem(data,len(data))
+    _wrap('ncrystal_ncmat2binary',None,(_cstr,_cstr))
+
+    _raw_getcachestats = _wrap('ncrystal_get_cache_stats',None,(_uintp,_cstrpp),hide=True)
+    def ncrystal_get_cachestats():
+        n,l = _uint(),_cstrp()
+        _raw_getcachestats(n,ctypes.byref(l))
+        assert n.value%8==0
+        res=[]
+        for i in range(n.value//8):
+            e = [ l[i*8+j].decode() for j in range(8) ]
+            res += [ dict( name = e[0],
+                           nstrongrefs = int(e[1]),
+                           nentries = int(e[2]),
+                           nbytes = int(e[3]),
+                           ninflight = int(e[4]),
+                           nhits = int(e[5]),
+                           nmisses = int(e[6]),
+                           constructiontime = float(e[7]) ) ]
+        _raw_deallocstrlist(n,l)
+        return res
+    functions['ncrystal_get_cachestats'] = ncrystal_get_cachestats
+
+    _wrap('ncrystal_counters_enabled',_int,tuple())
+    _wrap('ncrystal_reset_counters',None,tuple())
+    _raw_getcounters = _wrap('ncrystal_get_counters',None,(_uintp,_cstrpp),hide=True)
+    def ncrystal_get_counters():
+        n,l = _uint(),_cstrp()
+        _raw_getcounters(n,ctypes.byref(l))
+        assert n.value%2==0
+        res = [ ( l[i*2].decode(), int(l[i*2+1].decode()) ) for i in range(n.value//2) ]
+        _raw_deallocstrlist(n,l)
+        return res
+    functions['ncrystal_get_counters'] = ncrystal_get_counters
+
     _wrap('ncrystal_add_custom_search_dir',None,(_cstr,))
     _wrap('ncrystal_remove_custom_search_dirs',None,tuple())
     _wrap('ncrystal_enable_abspaths',None,(_int,))
@@ -695,6 +861,33 @@ def createVDOSDebye(debye_temperature):
     #Actual returned egrid should contain only first and last value:
     return (_np.asarray([vdos_egrid[0],vdos_egrid[-1]]) ,vdos_density)
 
+#Pickling of Info, Scatter and Absorption objects created from cfg-strings
+#transfers the cfg-string along with a snapshot of the derived data needed by
+#it, so the objects can be recreated without redoing expensive initialisation
+#(in particular in worker processes used with the multiprocessing module). The
+#snapshot is only produced once per cfg-string in the pickling process (which
+#clears caches, as for saveSnapshot), and only loaded once in the unpickling
+#process:
+_pickle_snapshots = {}
+_unpickle_loaded_snapshots = set()
+
+def _reduceMaterial(obj):
+    if obj._cfgstr is None:
+        raise NCBadInput('Only %s objects created directly from cfg-strings can be pickled'%obj.__class__.__name__)
+    data = _pickle_snapshots.get(obj._cfgstr)
+    if data is None:
+        data = _rawfct['ncrystal_save_snapshot_to_memory']([obj._cfgstr],1)
+        _pickle_snapshots[obj._cfgstr] = data
+    return (_unpickleMaterial,(obj.__class__,obj._cfgstr,data))
+
+def _unpickleMaterial(cls,cfgstr,data):
+    import hashlib
+    key = hashlib.sha256(data).digest()
+    if key not in _unpickle_loaded_snapshots:
+        _rawfct['ncrystal_load_snapshot_from_memory'](data)
+        _unpickle_loaded_snapshots.add(key)
+    return cls(cfgstr)
+
 class RCBase:
     """Base class for all NCrystal objects"""
     def __init__(self, rawobj):
@@ -880,9 +1073,9 @@ class Info(RCBase):
         """create Info object based on cfg-string (same as using createInfo(cfgstr))"""
         if isinstance(cfgstr,tuple) and len(cfgstr)==2 and cfgstr[0]=='_rawobj_':
             #Already got an ncrystal_info_t object:
-            rawobj = cfgstr[1]
+            rawobj, self._cfgstr = cfgstr[1], None
         else:
-            rawobj = _rawfct['ncrystal_create_info'](_str2cstr(cfgstr))
+            rawobj, self._cfgstr = _rawfct['ncrystal_create_info'](_str2cstr(cfgstr)), cfgstr
         super(Info, self).__init__(rawobj)
         self.__dyninfo=None
         self.__atominfo=None
@@ -890,6 +1083,13 @@ class Info(RCBase):
         self.__atomdatas=[]
         self.__comp=None
 
+    def __reduce__(self):
+        """Support for pickling, which is possible for objects created directly
+        from cfg-strings. The cfg-string is pickled along with a snapshot of
+        the expensive derived data (cf. saveSnapshot), so the object can be
+        recreated in another process without redoing its initialisation."""
+        return _reduceMaterial(self)
+
     def _initComp(self):
         assert self.__comp is None
         nc = _rawfct['ncrystal_info_ncomponents'](self._rawobj)
@@ -916,6 +1116,22 @@ class Info(RCBase):
         sys.stderr.flush()
         _rawfct['ncrystal_dump'](self._rawobj)
 
+    def memoryFootprint(self,dump=False):
+        """Approximate memory usage in bytes, returned as a dictionary with keys
+        exclusive (memory owned by this object alone), shared (memory of
+        sub-objects also used elsewhere, e.g. by factory caches) and total.
+
+        If the dump flag is set to True, the values will not be returned. Instead
+        they will be printed to stdout.
+        """
+        if dump:
+            sys.stdout.flush()
+            sys.stderr.flush()
+            _rawfct['ncrystal_dump_info_memory_footprint'](self._rawobj)
+            return
+        e,s = _rawfct['ncrystal_info_memory_footprint'](self._rawobj)
+        return dict(exclusive=e,shared=s,total=e+s)
+
     def hasTemperature(self):
         """Whether or not material has a temperature available"""
         return _rawfct['ncrystal_info_gettemperature'](self._rawobj)>-1
@@ -1154,14 +1370,14 @@ class Info(RCBase):
         hasmsd = bool(_rawfct['ncrystal_info_hasatommsd'](self._rawobj))
         hasperelemdt=False
         l=[]
-        for iatom in range(natoms):
-            atomidx,n,dt,msd = _rawfct['ncrystal_info_getatominfo'](self._rawobj,iatom)
+        atomidxs,ns,dts,msds,allpos = _rawfct['ncrystal_info_getatominfo_all'](self._rawobj)
+        ipos = 0
+        for atomidx,n,dt,msd in zip(atomidxs,ns,dts,msds):
+            pos = [ tuple(allpos[i:i+3]) for i in range(ipos,ipos+3*n,3) ]
+            ipos += 3*n
             if dt:
                 hasperelemdt=True
             assert hasmsd == (msd>0.0)
-            pos=[]
-            for ipos in range(n):
-                pos.append( _rawfct['ncrystal_info_getatompos'](self._rawobj,iatom,ipos) )
             l.append( Info.AtomInfo(self,atomidx, n,
                                     ( dt if ( dt and  dt>0.0) else None),
                                     (msd if (msd and msd>0.0) else None),
@@ -1184,10 +1400,24 @@ class Info(RCBase):
         """Iterator over HKL info, yielding tuples in the format
         (h,k,l,multiplicity,dspacing,fsquared)"""
         nc_assert(self.hasHKLInfo())
-        h,k,l,mult,dsp,fsq = _rawfct['ncrystal_info_gethkl_setuppars']()
-        for idx in range(self.nHKL()):
-            _rawfct['ncrystal_info_gethkl'](self._rawobj,idx,h,k,l,mult,dsp,fsq)
-            yield h.value,k.value,l.value,mult.value,dsp.value,fsq.value
+        arrs = _rawfct['ncrystal_info_gethkl_all'](self._rawobj)
+        for e in zip(*(a.tolist() if _np is not None else a[:] for a in arrs)):
+            yield e
+    def hklArrays(self):
+        """All HKL info as a tuple of numpy arrays (h,k,l,multiplicity,dspacing,fsquared),
+        each of length nHKL(). Requires numpy."""
+        _ensure_numpy()
+        nc_assert(self.hasHKLInfo())
+        return _rawfct['ncrystal_info_gethkl_all'](self._rawobj)
+    def hklDemiNormals(self):
+        """Demi-normals of all HKL families as a numpy array of shape (N,3), with
+        the multiplicity/2 normals of each family following each other in the
+        order of hklList(). Returns None if demi-normals are unavailable. Requires
+        numpy."""
+        _ensure_numpy()
+        nc_assert(self.hasHKLInfo())
+        normals = _rawfct['ncrystal_info_getdeminormals_all'](self._rawobj)
+        return normals.reshape((-1,3)) if normals is not None else None
     def dspacingFromHKL(self, h, k, l):
         """Convenience method, calculating the d-spacing of a given Miller
         index. Calling this incurs the overhead of creating a reciprocal lattice
@@ -1496,6 +1726,22 @@ class Process(CalcBase):
 
         """
         return _rawfct['ncrystal_domain'](self._rawobj)
+    def memoryFootprint(self,dump=False):
+        """Approximate memory usage in bytes of the process and its components,
+        returned as a dictionary with keys exclusive (memory owned by this
+        process alone), shared (memory of sub-objects also used elsewhere,
+        e.g. by factory caches or other processes) and total.
+
+        If the dump flag is set to True, the values will not be returned.
+        Instead they will be printed to stdout, with a breakdown per component.
+        """
+        if dump:
+            sys.stdout.flush()
+            sys.stderr.flush()
+            _rawfct['ncrystal_dump_process_memory_footprint'](self._rawobj)
+            return
+        e,s = _rawfct['ncrystal_process_memory_footprint'](self._rawobj)
+        return dict(exclusive=e,shared=s,total=e+s)
     def isNonOriented(self):
         """opposite of isOriented()"""
         return bool(_rawfct['ncrystal_isnonoriented'](self._rawobj))
@@ -1505,7 +1751,7 @@ class Process(CalcBase):
     def crossSection( self, ekin, direction ):
         """Access cross sections."""
         return _rawfct['ncrystal_crosssection'](self._rawobj,ekin, direction)
-    def crossSectionNonOriented( self, ekin, repeat = None ):
+    def crossSectionNonOriented( self, ekin, repeat = None, nthreads = None ):
         """Access cross sections (should not be called for oriented processes).
 
         For efficiency it is possible to provide the ekin parameter as a numpy
@@ -1514,8 +1760,68 @@ class Process(CalcBase):
         causing the ekin value(s) to be reused that many times and a numpy array
         with results returned.
 
+        Large arrays can be evaluated in parallel by setting nthreads to the
+        desired number of threads (0 means one per CPU). The work is then split
+        into chunks, each evaluated by a dedicated clone of the object (see
+        _parallelMany for details).
+
         """
-        return _rawfct['ncrystal_crosssection_nonoriented'](self._rawobj,ekin,repeat)
+        if not _wantParallel(ekin,repeat,nthreads):
+            return _rawfct['ncrystal_crosssection_nonoriented'](self._rawobj,ekin,repeat)
+        return _parallelMany( self, ekin, repeat, nthreads,
+                              lambda o,e : _rawfct['ncrystal_crosssection_nonoriented'](o._rawobj,e) )
+
+    def crossSectionGrid( self, ekin, directions, nthreads = 0 ):
+        """Access cross sections for all combinations of the provided energies
+        and directions (the latter given as an array of shape (M,3) or a list of
+        M direction tuples). Returns a numpy array of shape (N,M) where N is the
+        number of energies, with entry [i,j] holding the cross section at
+        ekin[i] and directions[j].
+
+        The evaluation happens in a single call to the compiled NCrystal library,
+        with the energies split over nthreads threads (0 means all available
+        hardware threads), each using its own cache.
+        """
+        if not isinstance(nthreads, numbers.Integral) or nthreads < 0:
+            raise NCBadInput('nthreads parameter must be a non-negative integer')
+        return _rawfct['ncrystal_crosssection_grid'](self._rawobj,ekin,directions,int(nthreads))
+
+    def groupAveragedXS( self, group_bounds, flux_ekin = None, flux_values = None,
+                         precision = 1e-6, nthreads = 0 ):
+        """Flux-weighted averages of the cross section over energy groups (should
+        not be called for oriented processes). The groups are given by the
+        increasing energies in group_bounds [eV], and the flux spectrum by a
+        table of (flux_ekin,flux_values) points which is linearly interpolated
+        and must cover all groups. If no flux table is given, a 1/E spectrum is
+        assumed. Returns the len(group_bounds)-1 averaged cross sections.
+
+        The integrals are carried out in a single call to the compiled NCrystal
+        library, adaptively and to the requested relative precision, between
+        the energies at which the cross section has kinks or discontinuities
+        (such as Bragg edges and the grid points of S(alpha,beta) cross section
+        tables). The work is split over nthreads threads (0 means all available
+        hardware threads), without affecting the results.
+        """
+        if not isinstance(nthreads, numbers.Integral) or nthreads < 0:
+            raise NCBadInput('nthreads parameter must be a non-negative integer')
+        if (flux_ekin is None) != (flux_values is None):
+            raise NCBadInput('flux_ekin and flux_values must be provided together')
+        return _rawfct['ncrystal_groupaveraged_xs'](self._rawobj,group_bounds,
+                                                    flux_ekin if flux_ekin is not None else [],
+                                                    flux_values if flux_values is not None else [],
+                                                    float(precision),int(nthreads))
+
+    def _parallelClone( self, i ):
+        raise NCLogicError('Parallel evaluation not supported for %s objects'%self.__class__.__name__)
+
+    def _getParallelClones( self, n ):
+        #Clones are created on demand and kept for later calls, so the i'th
+        #chunk is always evaluated by the same clone:
+        if not hasattr(self,'_parclones'):
+            self._parclones = []
+        while len(self._parclones) < n:
+            self._parclones.append( self._parallelClone( len(self._parclones) ) )
+        return self._parclones[0:n]
 
     def xsect(self,ekin=None,direction=None,wl=None,repeat=None):
         """Convenience function which redirects calls to either crossSectionNonOriented
@@ -1551,9 +1857,9 @@ class Absorption(Process):
         """create Absorption object based on cfg-string (same as using createAbsorption(cfgstr))"""
         if isinstance(cfgstr,tuple) and len(cfgstr)==2 and cfgstr[0]=='_rawobj_':
             #Cloning:
-            rawobj_abs = cfgstr[1]
+            rawobj_abs, self._cfgstr = cfgstr[1], None
         else:
-            rawobj_abs = _rawfct['ncrystal_create_absorption'](_str2cstr(cfgstr))
+            rawobj_abs, self._cfgstr = _rawfct['ncrystal_create_absorption'](_str2cstr(cfgstr)), cfgstr
         self._rawobj_abs = rawobj_abs
         rawobj_proc = _rawfct['ncrystal_cast_abs2proc'](rawobj_abs)
         super(Absorption, self).__init__(rawobj_proc)
@@ -1568,6 +1874,16 @@ class Absorption(Process):
         newrawobj = _rawfct['ncrystal_clone_absorption'](self._rawobj_abs)
         return Absorption( ('_rawobj_',newrawobj) )
 
+    def _parallelClone( self, i ):
+        return self.clone()
+
+    def __reduce__(self):
+        """Support for pickling, which is possible for objects created directly
+        from cfg-strings. The cfg-string is pickled along with a snapshot of
+        the expensive derived data (cf. saveSnapshot), so the object can be
+        recreated in another process without redoing its initialisation."""
+        return _reduceMaterial(self)
+
 class Scatter(Process):
 
     """Base class for calculations of scattering in materials.
@@ -1581,12 +1897,20 @@ class Scatter(Process):
         """create Scatter object based on cfg-string (same as using createScatter(cfgstr))"""
         if isinstance(cfgstr,tuple) and len(cfgstr)==2 and cfgstr[0]=='_rawobj_':
             #Already got an ncrystal_scatter_t object:
-            self._rawobj_scat = cfgstr[1]
+            self._rawobj_scat, self._cfgstr = cfgstr[1], None
         else:
-            self._rawobj_scat = _rawfct['ncrystal_create_scatter'](_str2cstr(cfgstr))
+            self._rawobj_scat, self._cfgstr = _rawfct['ncrystal_create_scatter'](_str2cstr(cfgstr)), cfgstr
         rawobj_proc = _rawfct['ncrystal_cast_scat2proc'](self._rawobj_scat)
         super(Scatter, self).__init__(rawobj_proc)
 
+    def __reduce__(self):
+        """Support for pickling, which is possible for objects created directly
+        from cfg-strings. The cfg-string is pickled along with a snapshot of
+        the expensive derived data (cf. saveSnapshot), so the object can be
+        recreated in another process without redoing its initialisation. The state of the random
+        number stream is not transferred."""
+        return _reduceMaterial(self)
+
 
     def clone(self,rng_stream_index=None,for_current_thread=False):
         """Clone object. The clone will be using the same physics models and sharing any
@@ -1624,6 +1948,9 @@ class Scatter(Process):
             newrawobj = _rawfct['ncrystal_clone_scatter'](self._rawobj_scat)
         return Scatter( ('_rawobj_',newrawobj) )
 
+    def _parallelClone( self, i ):
+        return self.clone(rng_stream_index=i)
+
     def sampleScatter( self, ekin, direction, repeat = None ):
         """Randomly generate scatterings.
 
@@ -1638,7 +1965,7 @@ class Scatter(Process):
         return _rawfct['ncrystal_samplesct'](self._rawobj_scat,ekin,direction,repeat)
 
 
-    def sampleScatterIsotropic( self, ekin, repeat = None ):
+    def sampleScatterIsotropic( self, ekin, repeat = None, nthreads = None ):
         """Randomly generate scatterings (should not be called for oriented processes).
 
         Assuming a scattering took place, generate final state of
@@ -1649,8 +1976,47 @@ class Scatter(Process):
         set to a positive number, causing the ekin value(s) to be reused that
         many times and numpy arrays with results returned.
 
+        Large arrays can be sampled in parallel by setting nthreads to the
+        desired number of threads (0 means one per CPU). Note that the
+        parallel chunks are sampled by clones with their own RNG streams (see
+        _parallelMany for details), so results will differ from those of a
+        sequential call.
+
+        """
+        if not _wantParallel(ekin,repeat,nthreads):
+            return _rawfct['ncrystal_samplesct_iso'](self._rawobj_scat,ekin,repeat)
+        return _parallelMany( self, ekin, repeat, nthreads,
+                              lambda o,e : _rawfct['ncrystal_samplesct_iso'](o._rawobj_scat,e) )
+
+    _histvars = {'dekin':1,'mu':2,'q':3,'alpha':4,'beta':5}
+
+    def sampleScatterIsotropicHist( self, ekin, nsamples, x, y = None, temperature = None, nthreads = 0 ):
+        """Sample nsamples scatterings at the given kinetic energy (should not be
+        called for oriented processes), and return a histogram of their
+        distribution as a numpy array, without transferring the individual
+        samples from the compiled NCrystal library.
+
+        The histogram variables are specified as x=(varname,nbins,vmin,vmax)
+        and optionally y=(varname,nbins,vmin,vmax) for a 2D histogram (the
+        returned array then has shape (nbinsx,nbinsy)). Supported variable names
+        are 'dekin' (ekin_final-ekin in eV), 'mu' (cosine of scattering angle),
+        'Q' (momentum transfer in 1/Aa), and 'alpha' and 'beta' (dimensionless
+        S(alpha,beta) variables, requiring the temperature parameter to be set
+        in kelvin). Sampled values outside the histogram ranges are not
+        counted. The sampling is distributed over nthreads threads (0 means all
+        available hardware threads), but results do not depend on nthreads.
         """
-        return _rawfct['ncrystal_samplesct_iso'](self._rawobj_scat,ekin,repeat)
+        def parsevar(v):
+            if not isinstance(v,(tuple,list)) or len(v)!=4 or str(v[0]).lower() not in Scatter._histvars:
+                raise NCBadInput('Histogram variables must be specified as (varname,nbins,vmin,vmax)'
+                                 ' with varname one of: %s'%', '.join(('dekin','mu','Q','alpha','beta')))
+            return Scatter._histvars[str(v[0]).lower()],int(v[1]),float(v[2]),float(v[3])
+        xv = parsevar(x)
+        yv = parsevar(y) if y is not None else (0,0,0.0,0.0)
+        if not isinstance(nthreads, numbers.Integral) or nthreads < 0:
+            raise NCBadInput('nthreads parameter must be a non-negative integer')
+        return _rawfct['ncrystal_samplesct_iso_hist'](self._rawobj_scat,float(ekin),int(nsamples),*xv,*yv,
+                                                      float(temperature or 0.0),int(nthreads))
 
     def generateScattering( self, ekin, direction, repeat = None ):
         """WARNING: Deprecated method. Please use the sampleScatter method instead.
@@ -1731,6 +2097,47 @@ class Scatter(Process):
                                                    _str2cstr(state) )
 
 
+_parallel_min_chunk = 1000
+
+def _wantParallel( ekin, repeat, nthreads ):
+    if nthreads is None or nthreads == 1:
+        return False
+    if not isinstance(nthreads, numbers.Integral) or nthreads < 0:
+        raise NCBadInput('nthreads parameter must be a non-negative integer')
+    return repeat is not None or hasattr(ekin,'__len__')
+
+def _parallelMany( obj, ekin, repeat, nthreads, evalfct ):
+    """Evaluate evalfct(clone,ekin_chunk) for consecutive chunks of the ekin
+    array (expanded by repeat) in a thread pool, with results concatenated.
+
+    Each chunk is evaluated by a dedicated clone of obj, created on first usage
+    and then kept around for subsequent calls. Scatter clones get the RNG
+    stream indices 0,1,...,nthreads-1 (see Scatter.clone), so results are
+    reproducible for a given value of nthreads, but will share RNG streams with
+    any other objects cloned with the same indices. The calls into the compiled
+    NCrystal library do not hold the Python GIL, so the threads do run
+    concurrently. Chunks have at least %i entries, so small arrays will use
+    fewer threads than requested.
+    """
+    _ensure_numpy()
+    if nthreads == 0:
+        nthreads = os.cpu_count() or 1
+    e = _np.ascontiguousarray(ekin,dtype=float).ravel() if hasattr(ekin,'__len__') else _np.full(1,float(ekin))
+    if repeat is not None:
+        e = _np.tile(e,repeat)
+    nthreads = max( 1, min( nthreads, len(e) // _parallel_min_chunk ) )
+    clones = obj._getParallelClones( nthreads )
+    if nthreads == 1:
+        return evalfct( clones[0], e )
+    chunks = _np.array_split( e, nthreads )
+    import concurrent.futures
+    with concurrent.futures.ThreadPoolExecutor( max_workers = nthreads ) as executor:
+        results = list( executor.map( evalfct, clones, chunks ) )
+    if isinstance(results[0],tuple):
+        return tuple( _np.concatenate(r) for r in zip(*results) )
+    return _np.concatenate( results )
+_parallelMany.__doc__ = _parallelMany.__doc__%_parallel_min_chunk
+
 def createInfo(cfgstr):
     """Construct Info object based on provided configuration (using available factories)"""
     return Info(cfgstr)
@@ -1829,6 +2236,84 @@ def ekin2wl(ekin):
 def clearCaches():
     """Clear various caches"""
     _rawfct['ncrystal_clear_caches']()
+def setNThreads(n):
+    """Set number of threads used for expensive initialisation work, overriding
+    the NCRYSTAL_NTHREADS environment variable (0 means all available hardware
+    threads). Should be called before creating any objects."""
+    _rawfct['ncrystal_setnthreads'](int(n))
+def saveSnapshot(path,cfgstrs,nthreads=None):
+    """Save snapshot of the expensive derived data (expanded VDOS kernels,
+    scattering tables and samplers, HKL lists, ...) needed for the listed cfg-strings into
+    a single binary file, which can be loaded in later processes with
+    loadSnapshot to avoid recomputing the data. Note that this clears all
+    caches. The cfg-strings are processed in parallel by nthreads threads (0
+    means all available hardware threads, and None means to use the
+    NCRYSTAL_NTHREADS environment variable)."""
+    if nthreads is None:
+        _rawfct['ncrystal_save_snapshot'](str(path),list(cfgstrs))
+    else:
+        _rawfct['ncrystal_save_snapshot_mt'](str(path),list(cfgstrs),int(nthreads))
+
+def loadSnapshot(path):
+    """Load snapshot created by saveSnapshot. This must be done before creating
+    the objects which should benefit from it."""
+    _rawfct['ncrystal_load_snapshot'](_str2cstr(str(path)))
+
+def convertToNCMATBinary(datasrc,outfile):
+    """Parse NCMAT data (usually a file name, but any name which can be passed
+    to createTextData is accepted), and write it to outfile in the binary NCMAT
+    format (data type "ncmatbin"), which is much faster to load. Such files can
+    be used anywhere .ncmat files are accepted, but note that the format is
+    versioned and files must be regenerated when NCrystal no longer supports
+    the version."""
+    _rawfct['ncrystal_ncmat2binary'](_str2cstr(str(datasrc)),_str2cstr(str(outfile)))
+
+def getCacheStats(dump=False):
+    """Return list of statistics for all caches used so far, with each entry a
+    dictionary with keys: name, nstrongrefs, nentries, nbytes (approximate size
+    of objects still alive, 0 if unknown), ninflight (objects currently under
+    construction), nhits, nmisses, and constructiontime (total wall time in
+    seconds spent constructing objects).
+
+    If the dump flag is set to True, the list will not be returned. Instead it
+    will be printed to stdout.
+    """
+    l=_rawfct['ncrystal_get_cachestats']()
+    if not dump:
+        return l
+    print('NCrystal has %i caches in use.'%len(l))
+    for e in l:
+        print('==> %s: %i hits, %i misses (%g s construction time), %i entries (%i kept alive, %g MB)%s'%(
+            e['name'],e['nhits'],e['nmisses'],e['constructiontime'],e['nentries'],
+            e['nstrongrefs'],e['nbytes']*1e-6,
+            ', %i in-flight'%e['ninflight'] if e['ninflight'] else ''))
+
+def getCounters(dump=False):
+    """Return dictionary with the values of the hot-path instrumentation counters
+    (see NCCounters.hh for their meaning), which can help selecting which
+    configuration parameters (e.g. dirtol, mosprec or vdoslux) to tune for
+    speed. The counters are only incremented if NCrystal was built with
+    ENABLE_COUNTERS=ON (see countersEnabled()), and otherwise always zero.
+
+    If the dump flag is set to True, the values will not be returned. Instead
+    they will be printed to stdout.
+    """
+    d = dict( _rawfct['ncrystal_get_counters']() )
+    if not dump:
+        return d
+    if not countersEnabled():
+        print('NCrystal counters are not enabled (requires build with ENABLE_COUNTERS=ON).')
+    for k,v in d.items():
+        print('==> %s: %i'%(k,v))
+
+def countersEnabled():
+    """Whether NCrystal was built with hot-path instrumentation counters enabled."""
+    return bool(_rawfct['ncrystal_counters_enabled']())
+
+def resetCounters():
+    """Reset all hot-path instrumentation counters to zero (cf. getCounters())."""
+    _rawfct['ncrystal_reset_counters']()
+
 def clearInfoCaches():
     """Deprecated. Does the same as clearCaches()"""
     clearCaches()
@@ -1838,6 +2323,12 @@ def disableCaching():
 def enableCaching():
     """Enable caching of Info objects in factory infrastructure"""
     _rawfct['ncrystal_enable_caching']()
+def enableTextDataDeduplication(flag=True):
+    """Let input data with byte-wise identical content (e.g. in-memory files
+    registered under different names) share cached Info and process objects.
+    Can also be enabled by setting the environment variable
+    NCRYSTAL_TEXTDATA_DEDUP."""
+    _rawfct['ncrystal_enable_textdata_dedup'](1 if flag else 0)
 
 def hasFactory(name):
     """Check if a factory of a given name exists"""
@@ -1881,7 +2372,7 @@ def formatVectorForNCMAT(name,values):
     return res
 
 #Accept custom random generator:
-def setDefaultRandomGenerator(rg, keepalive=True):
+def setDefaultRandomGenerator(rg, keepalive=True, bulk=False):
     """Set the default random generator for CalcBase classes.
 
     Note that this can only changes the random generator for those CalcBase
@@ -1895,8 +2386,13 @@ def setDefaultRandomGenerator(rg, keepalive=True):
     for keeping a reference to the object for as long as NCrystal might use it
     to generate random numbers.
 
+    If bulk=True, NCrystal will request random numbers from rg in batches
+    (keeping them in a buffer until needed), which is much faster since it
+    avoids a callback from C++ for each number consumed. Note that rg will
+    then be called ahead of time.
+
     """
-    _rawfct['ncrystal_setrandgen'](rg)
+    _rawfct['ncrystal_setrandgen_bulk' if bulk else 'ncrystal_setrandgen'](rg)
 
 __atomdb={}
 def atomDB(Z,A=None,throwOnErrors=True):